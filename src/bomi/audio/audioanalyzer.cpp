@@ -1,4 +1,5 @@
 #include "audioanalyzer.hpp"
+#include "loudnessmeter.hpp"
 #include "misc/log.hpp"
 #include "tmp/algorithm.hpp"
 
@@ -59,11 +60,112 @@ public:
         }
         return sqrt(sum2 / (m_frames * m_format.channels().num));
     }
+    auto feed(LoudnessMeter &meter) const -> void
+    {
+        for (auto &buffer : d)
+            meter.feed(buffer->constView<float>().plane(), buffer->frames());
+    }
+    auto peak() const -> double { return m_peak; }
+    auto setPeak(double peak) -> void { m_peak = peak; }
 private:
     AudioBufferFormat m_format;
     std::deque<AudioBufferPtr> d;
     const AudioFilter *m_filter = nullptr;
     int m_frames = 0, m_targetFrames = 0;
+    double m_peak = 0.0;
+};
+
+// minimum of last size values, O(1) amortized per push
+// ring holds increasing candidates which can still become minimum
+class SlidingMin {
+public:
+    SlidingMin() { setSize(1); }
+    auto setSize(int size) -> void { m_size = size; m_ring.resize(size); clear(); }
+    auto clear() -> void { m_pushed = m_head = m_count = 0; }
+    auto isFull() const -> bool { return m_pushed >= m_size; }
+    auto min() const -> double { return m_ring[m_head].value; }
+    auto push(double value) -> void
+    {
+        if (m_count && m_ring[m_head].index <= m_pushed - m_size) {
+            m_head = (m_head + 1) % m_size;
+            --m_count;
+        }
+        while (m_count && at(m_count - 1).value >= value)
+            --m_count;
+        at(m_count++) = { m_pushed++, value };
+    }
+private:
+    struct Entry { qint64 index; double value; };
+    auto at(int i) -> Entry& { return m_ring[(m_head + i) % m_size]; }
+    std::vector<Entry> m_ring;
+    qint64 m_pushed = 0;
+    int m_size = 1, m_head = 0, m_count = 0;
+};
+
+// gaussian of radius r over last 2r + 1 values, output is centered at r
+// short windows take exact weights, longer ones three box passes
+// whose supports add up to same window so that cost stays constant
+class GaussianWindow {
+public:
+    static constexpr int ExactRadius = 8;
+    GaussianWindow() { setRadius(1); }
+    auto setRadius(int radius) -> void
+    {
+        if (radius <= ExactRadius) {
+            m_weights = Gaussian::create(radius);
+            m_boxes[0].setWidth(m_weights.size());
+        } else {
+            m_weights.clear();
+            for (int i = 0; i < 3; ++i)
+                m_boxes[i].setWidth(2 * ((radius + i) / 3) + 1);
+        }
+    }
+    auto clear() -> void { for (auto &box : m_boxes) box.clear(); }
+    // false until window is filled
+    auto push(double value, double *out) -> bool
+    {
+        if (!m_weights.empty()) {
+            auto &ring = m_boxes[0];
+            ring.push(value);
+            if (!ring.isFull())
+                return false;
+            *out = 0.0;
+            for (int i = 0; i < (int)m_weights.size(); ++i)
+                *out += m_weights[i] * ring.at(i);
+            return true;
+        }
+        for (auto &box : m_boxes) {
+            box.push(value);
+            if (!box.isFull())
+                return false;
+            value = box.mean();
+        }
+        *out = value;
+        return true;
+    }
+private:
+    struct Box {
+        auto setWidth(int width) -> void { ring.resize(width); clear(); }
+        auto clear() -> void { head = filled = 0; sum = 0.0; }
+        auto isFull() const -> bool { return filled == (int)ring.size(); }
+        auto mean() const -> double { return sum / ring.size(); }
+        // i-th oldest value
+        auto at(int i) const -> double { return ring[(head + i) % ring.size()]; }
+        auto push(double value) -> void
+        {
+            if (isFull())
+                sum -= ring[head];
+            else
+                ++filled;
+            sum += (ring[head] = value);
+            head = (head + 1) % ring.size();
+        }
+        std::vector<double> ring;
+        int head = 0, filled = 0;
+        double sum = 0.0;
+    };
+    std::vector<double> m_weights;
+    std::array<Box, 3> m_boxes;
 };
 
 struct AudioAnalyzer::Data {
@@ -71,32 +173,77 @@ struct AudioAnalyzer::Data {
     AudioBufferFormat format;
     AudioNormalizerOption option;
     int frames = 0;
-    double scale = 1.0;
+    double scale = 1.0, fileLoudness = LoudnessMeter::Silence;
     bool normalizer = false;
     struct {
-        std::deque<double> orig, min, smooth;
+        // minimum over window of gains, then smoothed
+        SlidingMin min;
+        GaussianWindow gaussian;
+        std::deque<double> smooth;
         double prev = 1.0, current = 1.0;
-        auto clear() { prev = current = 1.0; orig.clear(); min.clear(); smooth.clear(); }
+        bool primed = false;
+        auto clear()
+        {
+            prev = current = 1.0; primed = false;
+            min.clear(); gaussian.clear(); smooth.clear();
+        }
     } history;
     std::deque<AudioFrameChunk> inputs, outputs;
     AudioFrameChunk filling;
-    Gaussian gaussian;
+    int radius = 1;
+    LoudnessMeter meter;
+    struct {
+        double next = 1.0;
+        bool ready = false;
+        int chunks = 0;
+    } lookahead;
 
     auto chunk() const -> AudioFrameChunk { return { format, p, frames }; }
+    auto setRadius(int r) -> void
+    {
+        radius = r;
+        history.min.setSize(2 * r + 1);
+        history.gaussian.setRadius(r);
+        history.clear();
+    }
 
     auto update(float gain) -> void
     {
-        if((int)history.orig.size() < gaussian.radius()) {
-            history.current = history.prev = gain;
-            history.orig.insert(history.orig.end(), gaussian.radius(), history.prev);
-            history.min.insert(history.min.end(), gaussian.radius(), history.prev);
+        auto &h = history;
+        // first gain fills past half of both windows
+        if (!h.primed) {
+            h.primed = true;
+            h.current = h.prev = gain;
+            double out;
+            for (int i = 0; i < radius; ++i) {
+                h.min.push(gain);
+                h.gaussian.push(gain, &out);
+            }
         }
-        history.orig.push_back(gain);
-#define PUSH_POP(from, to, filter) while((int)from.size() >= gaussian.size()) \
-            { to.push_back(filter(from)); from.pop_front(); }
-        PUSH_POP(history.orig, history.min, tmp::min);
-        PUSH_POP(history.min, history.smooth, gaussian.apply);
-#undef PUSH_POP
+        h.min.push(gain);
+        double smooth;
+        if (h.min.isFull() && h.gaussian.push(h.min.min(), &smooth))
+            h.smooth.push_back(smooth);
+    }
+
+    // gain of the front output chunk from loudness measured up to lookahead
+    auto loudnessGain() const -> double
+    {
+        auto lufs = fileLoudness;
+        if (lufs == LoudnessMeter::Silence)
+            lufs = meter.integrated();
+        if (lufs == LoudnessMeter::Silence)
+            lufs = meter.shortTerm();
+        if (lufs == LoudnessMeter::Silence)
+            return history.prev;
+        double peak = 0.0;
+        const int count = std::min<int>(outputs.size(), lookahead.chunks + 1);
+        for (int i = 0; i < count; ++i)
+            peak = std::max(peak, outputs[i].peak());
+        auto gain = std::pow(10.0, (option.target_lufs - lufs) / 20.0);
+        if (peak > 0.0)
+            gain = std::min(gain, 0.95 / peak);
+        return gain;
     }
 };
 
@@ -114,6 +261,7 @@ AudioAnalyzer::~AudioAnalyzer()
 auto AudioAnalyzer::setFormat(const AudioBufferFormat &format) -> void
 {
     d->history.clear();
+    d->meter.setFormat(format.fps(), LoudnessMeter::weights(format.channels()));
     if (!_Change(d->format, format))
         return;
     d->format = format;
@@ -125,6 +273,7 @@ auto AudioAnalyzer::reset() -> void
     d->inputs.clear();
     d->outputs.clear();
     d->history.smooth.clear();
+    d->lookahead.ready = false;
     d->frames = d->format.secToFrames(d->option.chunk_sec);
     d->filling = d->chunk();
 }
@@ -145,6 +294,26 @@ auto AudioAnalyzer::gain() const -> float
     return d->history.current;
 }
 
+auto AudioAnalyzer::meter() const -> const LoudnessMeter&
+{
+    return d->meter;
+}
+
+auto AudioAnalyzer::setFileLoudness(double lufs) -> void
+{
+    d->fileLoudness = std::isfinite(lufs) ? lufs : LoudnessMeter::Silence;
+}
+
+auto AudioAnalyzer::isLoudnessActive() const -> bool
+{
+    return d->normalizer && d->option.use_loudness;
+}
+
+auto AudioAnalyzer::isEmpty() const -> bool
+{
+    return !d->filling.frames() && d->inputs.empty() && d->outputs.empty();
+}
+
 auto AudioAnalyzer::setScale(double scale) -> void
 {
     d->scale = scale;
@@ -167,9 +336,12 @@ auto AudioAnalyzer::setNormalizerOption(const AudioNormalizerOption &opt) -> voi
     d->option.chunk_sec = qBound(0.1, opt.chunk_sec, 1.0);
     d->option.max       = std::min(10.0, opt.max);
     d->option.target    = std::min(0.95, opt.target);
+    d->option.use_loudness  = opt.use_loudness;
+    d->option.target_lufs   = qBound(-70.0, opt.target_lufs, 0.0);
+    d->option.lookahead_sec = qBound(0.0, opt.lookahead_sec, 10.0);
+    d->lookahead.chunks = std::ceil(d->option.lookahead_sec / d->option.chunk_sec);
 
-    d->gaussian.setRadius(d->option.smoothing);
-    d->history.clear();
+    d->setRadius(d->option.smoothing);
     reset();
 }
 
@@ -201,6 +373,8 @@ auto AudioAnalyzer::pull(bool eof) -> AudioBufferPtr
 {
     if (!d->normalizer)
         return flush();
+    if (d->option.use_loudness)
+        return pullLoudness(eof);
     while (!d->inputs.empty()) {
         auto chunk = tmp::take_front(d->inputs);
         double gain = d->history.prev;
@@ -231,6 +405,33 @@ auto AudioAnalyzer::pull(bool eof) -> AudioBufferPtr
     return buffer;
 }
 
+auto AudioAnalyzer::pullLoudness(bool eof) -> AudioBufferPtr
+{
+    while (!d->inputs.empty()) {
+        auto chunk = tmp::take_front(d->inputs);
+        bool silence = false;
+        chunk.setPeak(chunk.max(&silence));
+        chunk.feed(d->meter);
+        d->outputs.push_back(std::move(chunk));
+    }
+    if (!d->lookahead.ready) {
+        if ((int)d->outputs.size() <= d->lookahead.chunks)
+            return eof ? flush() : AudioBufferPtr();
+        d->lookahead.next = cutoff(d->loudnessGain(), d->option.max);
+        d->lookahead.ready = true;
+    }
+    auto &chunk = d->outputs.front();
+    const auto r = qBound(0.0, chunk.frames() / double(chunk.targetFrames()), 1.0);
+    d->history.current = d->history.prev * r + (1.0 - r) * d->lookahead.next;
+    auto buffer = chunk.pop();
+    if (!buffer) {
+        d->outputs.pop_front();
+        d->history.prev = d->lookahead.next;
+        d->lookahead.ready = false;
+    }
+    return buffer;
+}
+
 auto AudioAnalyzer::flush() -> AudioBufferPtr
 {
     auto pop_deque = [&] (auto &d) {
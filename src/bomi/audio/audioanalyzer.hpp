@@ -4,6 +4,8 @@
 #include "audionormalizeroption.hpp"
 #include "audiofilter.hpp"
 
+class LoudnessMeter;
+
 class AudioAnalyzer : public AudioFilter {
 public:
     AudioAnalyzer();
@@ -20,9 +22,17 @@ public:
     auto push(AudioBufferPtr &src) -> void;
     auto pull(bool eof = false) -> AudioBufferPtr;
     auto gain() const -> float;
+    // meter is fed only while loudness normalization is active
+    auto isLoudnessActive() const -> bool;
+    auto meter() const -> const LoudnessMeter&;
+    // loudness of whole file known in advance, -inf if unknown
+    auto setFileLoudness(double lufs) -> void;
+    // true if no buffer is queued
+    auto isEmpty() const -> bool;
     auto passthrough(const AudioBufferPtr &in) const -> bool override;
 private:
     auto flush() -> AudioBufferPtr;
+    auto pullLoudness(bool eof) -> AudioBufferPtr;
     struct Data;
     Data *d;
 };
@@ -0,0 +1,243 @@
+#include "audiobenchmark.hpp"
+#include "audiomixer.hpp"
+#include "audioscaler.hpp"
+#include "audioanalyzer.hpp"
+#include "audioconverter.hpp"
+#include "audioresampler.hpp"
+#include "audioequalizerfilter.hpp"
+#include "audiokernel.hpp"
+#include "enum/channellayout.hpp"
+#include "misc/benchmarktable.hpp"
+#include <QElapsedTimer>
+
+struct AudioBenchmark::Data {
+    double duration = 10.0;
+    int bufferFrames = 1024;
+    mp_audio_pool *pool = nullptr;
+
+    auto fill(mp_audio *mp, int offset) const -> void
+    {
+        const int nch = mp->channels.num, frames = mp->samples;
+        auto sample = [&] (int f, int c) -> float
+            { return 0.5f * std::sin((offset + f) * (0.05f + 0.01f * c)); };
+        switch (mp->format) {
+        case AF_FORMAT_S16: {
+            auto p = (qint16*)mp->planes[0];
+            for (int f = 0; f < frames; ++f)
+                for (int c = 0; c < nch; ++c)
+                    *p++ = sample(f, c) * 32767;
+            break;
+        } case AF_FORMAT_FLOAT: {
+            auto p = (float*)mp->planes[0];
+            for (int f = 0; f < frames; ++f)
+                for (int c = 0; c < nch; ++c)
+                    *p++ = sample(f, c);
+            break;
+        } case AF_FORMAT_FLOATP:
+            for (int c = 0; c < nch; ++c) {
+                auto p = (float*)mp->planes[c];
+                for (int f = 0; f < frames; ++f)
+                    *p++ = sample(f, c);
+            }
+            break;
+        default:
+            mp_audio_fill_silence(mp, 0, frames);
+        }
+    }
+};
+
+AudioBenchmark::AudioBenchmark()
+    : d(new Data)
+{
+    d->pool = mp_audio_pool_create(nullptr);
+}
+
+AudioBenchmark::~AudioBenchmark()
+{
+    talloc_free(d->pool);
+    delete d;
+}
+
+auto AudioBenchmark::setDuration(double sec) -> void
+{
+    d->duration = sec;
+}
+
+auto AudioBenchmark::setBufferFrames(int frames) -> void
+{
+    d->bufferFrames = frames;
+}
+
+auto AudioBenchmark::run(const Case &c) -> Result
+{
+    mp_chmap chmap, outChmap;
+    _ChmapFromLayout(&chmap, c.layout);
+    _ChmapFromLayout(&outChmap, c.outLayout);
+    const AudioBufferFormat from((af_format)c.format, chmap, c.fps);
+    const AudioBufferFormat mixerIn(AF_FORMAT_FLOAT, chmap, c.outFps);
+    const AudioBufferFormat mixerOut(AF_FORMAT_FLOAT, outChmap, c.outFps);
+    const AudioBufferFormat to((af_format)c.outFormat, outChmap, c.outFps);
+
+    AudioResampler resampler; AudioAnalyzer analyzer; AudioScaler scaler;
+    AudioMixer mixer; AudioEqualizerFilter equalizer; AudioConverter converter;
+    AudioScratch scratch;
+    scratch.floats(c.outFps / 10 * MP_NUM_CHANNELS);
+    const std::array<AudioFilter*, 4> chain = {{ &scaler, &mixer, &equalizer, &converter }};
+    const std::array<AudioFilter*, 6> filters
+            = {{ &resampler, &analyzer, &scaler, &mixer, &equalizer, &converter }};
+
+    resampler.setFormat(from, mixerIn);
+    analyzer.setFormat(mixerIn);
+    scaler.setFormat(mixerIn);
+    mixer.setFormat(mixerIn, mixerOut);
+    mixer.setChannelLayoutMap(ChannelLayoutMap::default_());
+    equalizer.setFormat(mixerOut);
+    converter.setFormat(to);
+    analyzer.setNormalizerOption(AudioNormalizerOption::default_());
+    analyzer.setNormalizerActive(c.normalizer);
+    scaler.setActive(c.scale != 1.0);
+    for (auto filter : filters) {
+        filter->setPool(d->pool);
+        filter->setScratch(&scratch);
+        filter->reset();
+        // speed of benchmark cases is left to tempo scaler
+        filter->setScale(filter == &resampler ? 1.0 : c.scale);
+    }
+
+    Result result;
+    const int total = c.fps * d->duration;
+    QElapsedTimer timer;
+    auto output = [&] (bool eof) {
+        auto buffer = analyzer.pull(eof);
+        if (!buffer || buffer->isEmpty())
+            return false;
+        mixer.setAmplifier(analyzer.gain());
+        for (auto filter : chain) {
+            if (filter->passthrough(buffer))
+                continue;
+            if (filter->canRunInPlace(buffer))
+                filter->runInPlace(*buffer);
+            else
+                buffer = filter->run(buffer);
+        }
+        talloc_free(buffer->take());
+        return true;
+    };
+    for (int offset = 0; offset < total; offset += d->bufferFrames) {
+        const int frames = std::min(d->bufferFrames, total - offset);
+        auto mp = mp_audio_pool_get(d->pool, &from.mpAudio(), frames);
+        mp->samples = frames;
+        d->fill(mp, offset);
+        const auto allocs = AudioBuffer::allocations();
+        timer.start();
+        auto input = AudioBuffer::fromMpAudio(mp);
+        auto buffer = resampler.run(input);
+        input.reset();
+        analyzer.push(buffer);
+        output(false);
+        result.nsecs += timer.nsecsElapsed();
+        result.allocations += AudioBuffer::allocations() - allocs;
+        result.frames += frames;
+        ++result.buffers;
+    }
+    timer.start();
+    while (output(true)) ;
+    result.nsecs += timer.nsecsElapsed();
+    return result;
+}
+
+auto AudioBenchmark::parity() -> Parity
+{
+    mp_chmap chmap, outChmap;
+    _ChmapFromLayout(&chmap, ChannelLayout::_5_1);
+    _ChmapFromLayout(&outChmap, ChannelLayout::_2_0);
+    const AudioBufferFormat in(AF_FORMAT_FLOAT, chmap, 48000);
+    const AudioBufferFormat out(AF_FORMAT_FLOAT, outChmap, 48000);
+    AudioMixer reference, kernel;
+    reference.setKernel(AudioKernel::Isa::Scalar);
+    for (auto mixer : {&reference, &kernel}) {
+        mixer->setPool(d->pool);
+        mixer->setFormat(in, out);
+        mixer->setChannelLayoutMap(ChannelLayoutMap::default_());
+        // drive compressor far from its linear range
+        mixer->setAmplifier(4.0);
+    }
+
+    Parity parity;
+    const int total = in.fps() * d->duration;
+    QElapsedTimer timer;
+    for (int offset = 0; offset < total; offset += d->bufferFrames) {
+        const int frames = std::min(d->bufferFrames, total - offset);
+        auto mp = mp_audio_pool_get(d->pool, &in.mpAudio(), frames);
+        mp->samples = frames;
+        d->fill(mp, offset);
+        auto src = AudioBuffer::fromMpAudio(mp);
+        timer.start();
+        auto r = reference.run(src);
+        parity.referenceNsecs += timer.nsecsElapsed();
+        timer.start();
+        auto k = kernel.run(src);
+        parity.kernelNsecs += timer.nsecsElapsed();
+        const auto rv = r->constView<float>(), kv = k->constView<float>();
+        for (auto rit = rv.begin(), kit = kv.begin(); rit != rv.end(); ++rit, ++kit)
+            parity.maxError = std::max<double>(parity.maxError, std::abs(*rit - *kit));
+        parity.samples += frames * out.channels().num;
+        talloc_free(r->take());
+        talloc_free(k->take());
+        talloc_free(src->take());
+    }
+    return parity;
+}
+
+auto AudioBenchmark::cases() -> QList<Case>
+{
+    using L = ChannelLayout;
+    QList<Case> cases;
+    auto add = [&] (const char *name, int fmt, int fps, L layout,
+                    int outFmt, int outFps, L outLayout,
+                    double scale = 1.0, bool normalizer = false) {
+        Case c;
+        c.name = _L(name);
+        c.format = fmt; c.fps = fps; c.layout = layout;
+        c.outFormat = outFmt; c.outFps = outFps; c.outLayout = outLayout;
+        c.scale = scale; c.normalizer = normalizer;
+        cases.push_back(c);
+    };
+    add("s16 2.0 48k > s16 2.0 48k", AF_FORMAT_S16, 48000, L::_2_0,
+        AF_FORMAT_S16, 48000, L::_2_0);
+    add("float 2.0 48k > float 2.0 48k", AF_FORMAT_FLOAT, 48000, L::_2_0,
+        AF_FORMAT_FLOAT, 48000, L::_2_0);
+    add("s16 2.0 44.1k > s16 2.0 48k", AF_FORMAT_S16, 44100, L::_2_0,
+        AF_FORMAT_S16, 48000, L::_2_0);
+    add("floatp 5.1 48k > s16 2.0 48k", AF_FORMAT_FLOATP, 48000, L::_5_1,
+        AF_FORMAT_S16, 48000, L::_2_0);
+    add("floatp 5.1 48k > float 5.1 48k", AF_FORMAT_FLOATP, 48000, L::_5_1,
+        AF_FORMAT_FLOAT, 48000, L::_5_1);
+    add("s16 2.0 48k > s16 2.0 48k x1.5", AF_FORMAT_S16, 48000, L::_2_0,
+        AF_FORMAT_S16, 48000, L::_2_0, 1.5);
+    add("s16 2.0 48k > s16 2.0 48k x0.8", AF_FORMAT_S16, 48000, L::_2_0,
+        AF_FORMAT_S16, 48000, L::_2_0, 0.8);
+    add("s16 2.0 48k > s16 2.0 48k norm", AF_FORMAT_S16, 48000, L::_2_0,
+        AF_FORMAT_S16, 48000, L::_2_0, 1.0, true);
+    return cases;
+}
+
+auto AudioBenchmark::dumpInfo() -> void
+{
+    AudioBenchmark bench;
+    const auto cases = AudioBenchmark::cases();
+    BenchmarkTable table;
+    table.fit(cases);
+    table.header(u"case"_q, "  ns/frame  allocs/buffer  realtime");
+    for (auto &c : cases) {
+        const auto r = bench.run(c);
+        table.row(c.name, _N(r.nsPerFrame(), 2, 10) % _N(r.allocationsPerBuffer(), 2, 15)
+                  % _N(r.realtime(c.fps), 1, 9) % 'x'_q);
+    }
+    const auto p = bench.parity();
+    const auto ns = [&] (quint64 nsecs) { return p.samples ? nsecs / double(p.samples) : 0.0; };
+    qDebug().nospace() << "downmix 5.1 > 2.0 compressed: max error "
+                       << p.maxError << ", ns/sample "
+                       << _N(ns(p.referenceNsecs), 2).toLatin1().constData() << " reference / "
+                       << _N(ns(p.kernelNsecs), 2).toLatin1().constData() << " kernel";
+}
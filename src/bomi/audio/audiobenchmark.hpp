@@ -0,0 +1,46 @@
+#ifndef AUDIOBENCHMARK_HPP
+#define AUDIOBENCHMARK_HPP
+
+enum class ChannelLayout;
+
+// runs the filter stages of AudioController against synthetic input
+// without an audio output, to measure the cost of the audio path
+
+class AudioBenchmark {
+public:
+    struct Case {
+        QString name;
+        int format, fps; ChannelLayout layout;
+        int outFormat, outFps; ChannelLayout outLayout;
+        double scale = 1.0; bool normalizer = false;
+    };
+    struct Result {
+        quint64 buffers = 0, frames = 0, allocations = 0, nsecs = 0;
+        auto nsPerFrame() const -> double { return frames ? nsecs / double(frames) : 0.0; }
+        auto allocationsPerBuffer() const -> double
+            { return buffers ? allocations / double(buffers) : 0.0; }
+        // processed seconds of audio per second
+        auto realtime(int fps) const -> double
+            { return nsecs ? frames / double(fps) / (nsecs * 1e-9) : 0.0; }
+    };
+    // 5.1 to 2.0 downmix through compressor, kernels against reference path
+    struct Parity {
+        double maxError = 0.0;
+        quint64 samples = 0, referenceNsecs = 0, kernelNsecs = 0;
+    };
+    AudioBenchmark();
+    ~AudioBenchmark();
+    // length of synthetic input for each case in seconds
+    auto setDuration(double sec) -> void;
+    auto setBufferFrames(int frames) -> void;
+    auto run(const Case &c) -> Result;
+    auto parity() -> Parity;
+    static auto cases() -> QList<Case>;
+    // run all cases() and print a table to stdout
+    static auto dumpInfo() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // AUDIOBENCHMARK_HPP
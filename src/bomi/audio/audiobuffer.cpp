@@ -1,12 +1,38 @@
 #include "audiobuffer.hpp"
 
+static QAtomicInteger<quint64> s_allocations{0};
+
 auto AudioBuffer::expand(int frames) -> void
 {
     if (this->frames() == frames)
         return;
     detach();
-    if (frames > m_audio->samples)
+    if (frames > m_audio->samples) {
+        if (frames > mp_audio_get_allocated_size(m_audio))
+            s_allocations.ref();
         mp_audio_realloc_min(m_audio, frames);
+    }
+    m_audio->samples = frames;
+    makeEnds();
+}
+
+auto AudioBuffer::detach() -> void
+{
+    if (m_writable)
+        return;
+    mp_audio_make_writeable(m_audio);
+    s_allocations.ref();
+    m_writable = true;
+    makeEnds();
+}
+
+auto AudioBuffer::reinterpret(const AudioBufferFormat &format) -> void
+{
+    const auto &mp = format.mpAudio();
+    Q_ASSERT(mp.num_planes == planes() && mp.sstride <= fstride());
+    detach();
+    const int frames = this->frames();
+    mp_audio_copy_config(m_audio, &mp);
     m_audio->samples = frames;
     makeEnds();
 }
@@ -21,9 +47,24 @@ auto AudioBuffer::makeEnds() -> void
 
 auto AudioBuffer::fromMpAudio(mp_audio *mp) -> AudioBufferPtr
 {
+    s_allocations.ref();
     auto buffer = new AudioBuffer;
     buffer->m_audio = mp;
     buffer->m_writable = mp_audio_is_writeable(mp);
     buffer->makeEnds();
     return AudioBufferPtr(buffer);
 }
+
+auto AudioBuffer::copy(mp_audio_pool *pool) const -> AudioBufferPtr
+{
+    auto mp = mp_audio_pool_new_copy(pool, m_audio);
+    if (!mp)
+        return AudioBufferPtr();
+    s_allocations.ref();
+    return fromMpAudio(mp);
+}
+
+auto AudioBuffer::allocations() -> quint64
+{
+    return s_allocations.load();
+}
@@ -53,7 +53,9 @@ public:
     auto expand(int frames) -> void;
     auto isWritable() const -> bool { return m_writable; }
     auto take() -> mp_audio* { auto p = m_audio; m_audio = nullptr; return p; }
-    auto detach() -> void { if (!m_writable) mp_audio_make_writeable(m_audio); }
+    auto detach() -> void;
+    // reuse the memory for format which takes no more bytes per frame
+    auto reinterpret(const AudioBufferFormat &format) -> void;
     auto type() const -> af_format { return (af_format)m_audio->format; }
     auto samples() const -> int { return frames() * channels(); }
     auto frames() const -> int { return m_audio->samples; }
@@ -76,6 +78,10 @@ public:
     template<class T>
     auto constView() const -> AudioBufferConstView<T>;
     static auto fromMpAudio(mp_audio *mp) -> AudioBufferPtr;
+    // writable copy from pool, e.g. for another branch of filters
+    auto copy(mp_audio_pool *pool) const -> AudioBufferPtr;
+    // number of buffer objects created and sample memories copied or grown
+    static auto allocations() -> quint64;
 private:
     auto makeEnds() -> void;
     AudioBuffer() { }
@@ -4,13 +4,19 @@
 #include "audiomixer.hpp"
 #include "audioscaler.hpp"
 #include "audioanalyzer.hpp"
+#include "loudnessmeter.hpp"
 #include "audioconverter.hpp"
 #include "audioresampler.hpp"
 #include "audioequalizer.hpp"
+#include "audioequalizerfilter.hpp"
+#include "audiozone.hpp"
+#include "audioprofile.hpp"
 #include "player/mpv_helper.hpp"
 #include "enum/channellayout.hpp"
 #include "misc/log.hpp"
 #include "misc/speedmeasure.hpp"
+#include "misc/tracer.hpp"
+#include "os/os.hpp"
 extern "C" {
 #include <audio/filter/af.h>
 }
@@ -50,17 +56,25 @@ enum FilterDirty : quint32 {
     Scale = 32,
     Resample = 64,
     Clip = 128,
-    Equalizer = 256
+    Equalizer = 256,
+    Zones = 512
 };
 
 struct AudioController::Data {
+    // filter runs in playloop thread of mpv
+    OS::ThreadClassKeeper scheduling{OS::ThreadClass::Playback};
     quint32 dirty = 0;
     int fmt_conv = AF_FORMAT_UNKNOWN, outrate = 0;
     SpeedMeasure<quint64> measure{10, 30};
     int srate = 0;
     quint64 samples = 0;
     bool normalizerActivated = false, tempoScalerActivated = false, eof = false;
+    bool sameFormat = false;
+    QAtomicInteger<quint64> buffers{0}, passthroughs{0};
     double scale = 1.0, amp = 1.0, gain = 1.0;
+    std::atomic<double> syncScale{1.0}, delay{0.0};
+    bool lowLatency = false;
+    double fileLoudness = -qInf();
     mp_chmap chmap;
     af_instance *af = nullptr;
     AudioNormalizerOption normalizerOption;
@@ -68,8 +82,12 @@ struct AudioController::Data {
     ChannelLayoutMap map = ChannelLayoutMap::default_();
     ChannelLayout layout = ChannelLayoutInfo::default_();
     AudioEqualizer eq;
+    QList<AudioZoneOption> zoneOptions;
+    QList<AudioZone*> zones;
     AudioFormat from, to;
     AudioVisualizer vis;
+    // formats configured for the stages last time
+    AudioBufferFormat bufFrom, bufMixerIn, bufMixerOut;
 
     static constexpr af_format fmt_interm = AF_FORMAT_FLOAT;
     af_format fmt_to = AF_FORMAT_UNKNOWN;
@@ -78,13 +96,41 @@ struct AudioController::Data {
     AudioAnalyzer analyzer;
     AudioScaler scaler;
     AudioMixer mixer;
+    AudioEqualizerFilter equalizer;
     AudioConverter converter;
     AudioBufferPtr input;
+    AudioScratch scratch;
     QVector<AudioBufferPtr> forFft;
     QVector<AudioFilter*> filters;
     QVector<AudioFilter*> chain;
+    QVector<AudioProfile::Stage> stages;
+    AudioProfile profile;
 
     QMutex mutex;
+
+    auto updateZones(const QList<AudioZoneOption> &options) -> void
+    {
+        QList<AudioZone*> zones;
+        for (auto &option : options) {
+            auto it = std::find_if(this->zones.begin(), this->zones.end(),
+                                   [&] (AudioZone *zone)
+                { return zone->option().device == option.device; });
+            AudioZone *zone = nullptr;
+            if (it != this->zones.end()) {
+                zone = *it;
+                this->zones.erase(it);
+                zone->setOption(option);
+            } else
+                zone = new AudioZone(af->global, option);
+            zone->setChannelLayoutMap(map);
+            zone->setFormat(bufMixerIn, bufMixerOut.channels());
+            zones.push_back(zone);
+        }
+        qDeleteAll(this->zones);
+        this->zones = zones;
+    }
+    auto outputDelay() const -> double
+        { return af && af->output_delay ? *af->output_delay : 0.0; }
 };
 
 AudioController::AudioController(QObject *parent)
@@ -96,14 +142,21 @@ AudioController::AudioController(QObject *parent)
             emit samplerateChanged(d->srate);
         if (_Change<double>(d->gain, d->normalizerActivated ? d->analyzer.gain() : -1))
             emit gainChanged(d->gain);
+        if (d->analyzer.isLoudnessActive()) {
+            const auto &meter = d->analyzer.meter();
+            emit loudnessChanged(meter.momentary(), meter.shortTerm(), meter.integrated());
+        }
     }, 100000);
 
-    d->chain << &d->scaler << &d->mixer << &d->converter;
+    d->chain << &d->scaler << &d->mixer << &d->equalizer << &d->converter;
+    d->stages << AudioProfile::Scaler << AudioProfile::Mixer
+              << AudioProfile::Equalizer << AudioProfile::Converter;
     d->filters << &d->resampler << &d->analyzer << d->chain;
 }
 
 AudioController::~AudioController()
 {
+    qDeleteAll(d->zones);
     delete d;
 }
 
@@ -141,6 +194,12 @@ auto AudioController::open(af_instance *af) -> int
 
 auto AudioController::uninit() -> void
 {
+    _Debug("%% of %% buffer(s) passed through filters.",
+           d->passthroughs.load(), d->buffers.load());
+    // zones belong to the player instance of filter chain
+    qDeleteAll(d->zones);
+    d->zones.clear();
+    d->dirty |= Zones;
     d->af = nullptr;
     d->layout = ChannelLayoutInfo::default_();
     d->input = AudioBufferPtr();
@@ -198,23 +257,51 @@ auto AudioController::reinitialize(mp_audio *from) -> int
     const AudioBufferFormat buf_mixer_out(d->fmt_interm, to->channels, to->rate);
     const AudioBufferFormat buf_to(to);
 
-    d->resampler.setFormat(buf_from, buf_mixer_in);
-    d->analyzer.setFormat(buf_mixer_in);
-    d->scaler.setFormat(buf_mixer_in);
-    d->mixer.setFormat(buf_mixer_in, buf_mixer_out);
-    d->mixer.setChannelLayoutMap(d->map);
-    d->mixer.setSoftClip(d->softClip);
+    // stages keep their state while formats stay, e.g. when only output
+    // device has been switched, and then output stage is rebuilt only
+    const bool input = _Change(d->bufFrom, buf_from) | _Change(d->bufMixerIn, buf_mixer_in);
+    const bool mixer = _Change(d->bufMixerOut, buf_mixer_out) || input;
+    QVector<AudioFilter*> rebuilt;
+    if (input) {
+        d->resampler.setFormat(buf_from, buf_mixer_in);
+        d->analyzer.setFormat(buf_mixer_in);
+        d->scaler.setFormat(buf_mixer_in);
+        rebuilt << &d->resampler << &d->analyzer << &d->scaler;
+    }
+    if (mixer) {
+        d->mixer.setFormat(buf_mixer_in, buf_mixer_out);
+        d->mixer.setChannelLayoutMap(d->map);
+        d->equalizer.setFormat(buf_mixer_out);
+        rebuilt << &d->mixer << &d->equalizer;
+        for (auto zone : d->zones)
+            zone->setFormat(buf_mixer_in, buf_mixer_out.channels());
+    }
+    d->converter.setSoftClip(d->softClip);
     d->converter.setFormat(buf_to);
+    rebuilt << &d->converter;
 
     d->fmt_to = (af_format)to->format;
-    d->dirty = 0xffffffff;
+    d->sameFormat = mp_audio_config_equals(from, to)
+            && _IsOneOf(from->format, AF_FORMAT_S16, AF_FORMAT_S16P,
+                        AF_FORMAT_S32, AF_FORMAT_S32P,
+                        AF_FORMAT_FLOAT, AF_FORMAT_FLOATP);
+    // options of kept stages would reset their state again
+    if (input)
+        d->dirty = 0xffffffff;
+    else
+        d->dirty |= (mixer ? ChMap | Equalizer : 0) | Clip;
     d->eof = false;
 
+    // enough for 100ms of 8 channels to avoid growing in steady state
+    d->scratch.floats(to->rate / 10 * MP_NUM_CHANNELS);
     for (auto filter : d->filters) {
         filter->setPool(d->af->out_pool);
-        filter->reset();
+        filter->setScratch(&d->scratch);
     }
-    d->vis.reset();
+    for (auto filter : rebuilt)
+        filter->reset();
+    if (input)
+        d->vis.reset();
     emit gainChanged(d->gain = d->normalizerActivated ? d->analyzer.gain() : -1);
     return true;
 }
@@ -233,7 +320,8 @@ auto AudioController::control(int cmd, void *arg) -> int
     case AF_CONTROL_SET_PLAYBACK_SPEED:
         d->scale = *(double*)arg;
         d->dirty |= Scale;
-        return d->tempoScalerActivated;
+        // resampler follows speed in place, so upstream never reinitializes
+        return true;
     case AF_CONTROL_SET_FORMAT:
         d->fmt_conv = *(int*)arg;
         if (!isSupported(d->fmt_conv))
@@ -249,6 +337,8 @@ auto AudioController::control(int cmd, void *arg) -> int
     case AF_CONTROL_RESET:
         for (auto filter : d->filters)
             filter->reset();
+        for (auto zone : d->zones)
+            zone->reset();
         return AF_OK;
     default:
         return AF_UNKNOWN;
@@ -257,25 +347,53 @@ auto AudioController::control(int cmd, void *arg) -> int
 
 auto AudioController::filter(mp_audio *data) -> int
 {
+    TRACE_SCOPE("AudioController::filter");
+    d->scheduling.keep();
     if (d->dirty) {
+        bool zones = false;
+        QList<AudioZoneOption> zoneOptions;
         d->mutex.lock();
         if (d->dirty & Normalizer) {
             d->analyzer.setNormalizerActive(d->normalizerActivated);
-            d->analyzer.setNormalizerOption(d->normalizerOption);
+            auto option = d->normalizerOption;
+            d->analyzer.setFileLoudness(d->fileLoudness);
+            if (std::isfinite(d->fileLoudness))
+                option.lookahead_sec = 0.0;
+            if (d->lowLatency) {
+                // gain swings faster but nothing waits for future chunks
+                option.smoothing = std::min(option.smoothing, 2);
+                option.chunk_sec = 0.1;
+                option.lookahead_sec = 0.0;
+            }
+            d->analyzer.setNormalizerOption(option);
         }
         if (d->dirty & Scale) {
+            // pitch shift of display sync is inaudible, stretching is not
+            double resampling = d->scale;
+            if (d->tempoScalerActivated)
+                resampling = d->scale != 1.0 ? d->syncScale.load() : 1.0;
             d->scaler.setActive(d->tempoScalerActivated);
-            for (auto filter : d->filters)
-                filter->setScale(d->scale);
+            d->scaler.setLowLatency(d->lowLatency);
+            d->scaler.setScale(d->scale / resampling);
+            d->resampler.setScale(resampling);
+            d->analyzer.setScale(d->scale);
         }
-        if (d->dirty & ChMap)
+        if (d->dirty & ChMap) {
             d->mixer.setChannelLayoutMap(d->map);
+            for (auto zone : d->zones)
+                zone->setChannelLayoutMap(d->map);
+        }
+        if ((zones = d->dirty & Zones))
+            zoneOptions = d->zoneOptions;
         if (d->dirty & Clip)
-            d->mixer.setSoftClip(d->softClip);
+            d->converter.setSoftClip(d->softClip);
         if (d->dirty & Equalizer)
-            d->mixer.setEqualizer(d->eq);
+            d->equalizer.setEqualizer(d->eq);
         d->dirty = 0;
         d->mutex.unlock();
+        // opening devices may take a while, so out of the lock
+        if (zones)
+            d->updateZones(zoneOptions);
     }
 
     d->eof = !data;
@@ -286,32 +404,93 @@ auto AudioController::filter(mp_audio *data) -> int
     return 0;
 }
 
+auto AudioController::isPassthrough() const -> bool
+{
+    if (!d->sameFormat || d->vis.isActive() || d->analyzer.isNormalizerActive()
+            || !d->analyzer.isEmpty() || !d->zones.isEmpty())
+        return false;
+    for (auto filter : d->filters) {
+        if (filter != &d->analyzer && filter != &d->converter
+                && !filter->passthrough(d->input))
+            return false;
+    }
+    return true;
+}
+
 auto AudioController::output() -> int
 {
+    if (d->input)
+        d->mixer.setAmplifier(d->amp * d->analyzer.gain());
+    if (d->input && isPassthrough()) {
+        // whole chain is no-op: only clip float samples in place
+        if (_IsOneOf(d->input->type(), AF_FORMAT_FLOAT, AF_FORMAT_FLOATP))
+            d->converter.clip(d->input);
+        af_add_output_frame(d->af, d->input->take());
+        d->input = AudioBufferPtr();
+        d->buffers.ref();
+        d->passthroughs.ref();
+        for (int i = 0; i < AudioProfile::StageCount; ++i)
+            d->profile.skip((AudioProfile::Stage)i);
+        d->profile.finish();
+        d->af->delay = d->delay = 0;
+        return 0;
+    }
     if (d->input) {
+        const int frames = d->input->frames();
+        const bool skip = d->resampler.passthrough(d->input);
+        if (skip)
+            d->profile.skip(AudioProfile::Resampler);
+        else
+            d->profile.begin(AudioProfile::Resampler);
         auto buffer = d->resampler.run(d->input);
+        if (!skip)
+            d->profile.end(AudioProfile::Resampler, frames);
         d->input = AudioBufferPtr();
+        d->profile.begin(AudioProfile::Analyzer);
         d->analyzer.push(buffer);
+        d->profile.end(AudioProfile::Analyzer, buffer->frames());
     }
     do {
+        d->profile.begin(AudioProfile::Analyzer);
         auto buffer = d->analyzer.pull(d->eof);
+        d->profile.end(AudioProfile::Analyzer, 0);
         if (!buffer || buffer->isEmpty())
             break;
         if (d->vis.isActive())
             d->vis.analyze(buffer);
         d->mixer.setAmplifier(d->amp * d->analyzer.gain());
-        for (auto filter : d->chain) {
-            if (!filter->passthrough(buffer))
+        for (int i = 0; i < d->chain.size(); ++i) {
+            const auto filter = d->chain[i];
+            const auto stage = d->stages[i];
+            // zones share everything up to tempo scaler
+            if (filter == &d->mixer && !d->zones.isEmpty()) {
+                const auto delay = d->outputDelay();
+                for (auto zone : d->zones)
+                    zone->feed(*buffer, d->analyzer.gain(), delay);
+            }
+            if (filter->passthrough(buffer)) {
+                d->profile.skip(stage);
+                continue;
+            }
+            const int frames = buffer->frames();
+            d->profile.begin(stage);
+            if (filter->canRunInPlace(buffer))
+                filter->runInPlace(*buffer);
+            else
                 buffer = filter->run(buffer);
+            d->profile.end(stage, frames);
         }
         auto audio = buffer->take();
         Q_ASSERT(mp_audio_config_equals(&d->af->fmt_out, audio));
         af_add_output_frame(d->af, audio);
+        d->buffers.ref();
+        d->profile.finish();
     } while (false);
 
     d->af->delay = 0;
     for (auto filter : d->filters)
         d->af->delay += filter->delay();
+    d->delay = d->af->delay;
     return 0;
 }
 
@@ -352,6 +531,43 @@ auto AudioController::setNormalizerOption(const AudioNormalizerOption &option)
     d->dirty |= Normalizer;
 }
 
+auto AudioController::setTempoScalerActivated(bool on) -> void
+{
+    d->mutex.lock();
+    if (_Change(d->tempoScalerActivated, on))
+        d->dirty |= Scale;
+    d->mutex.unlock();
+}
+
+auto AudioController::setNormalizerActivated(bool on) -> void
+{
+    d->mutex.lock();
+    if (_Change(d->normalizerActivated, on))
+        d->dirty |= Normalizer;
+    d->mutex.unlock();
+}
+
+auto AudioController::setFileLoudness(double lufs) -> void
+{
+    d->mutex.lock();
+    if (_Change(d->fileLoudness, lufs))
+        d->dirty |= Normalizer;
+    d->mutex.unlock();
+}
+
+auto AudioController::setLowLatency(bool on) -> void
+{
+    d->mutex.lock();
+    d->lowLatency = on;
+    d->dirty |= Normalizer | Scale;
+    d->mutex.unlock();
+}
+
+auto AudioController::delay() const -> double
+{
+    return d->delay;
+}
+
 auto AudioController::isNormalizerActivated() const -> bool
 {
     return d->normalizerActivated;
@@ -398,7 +614,35 @@ auto AudioController::setEqualizer(const AudioEqualizer &eq) -> void
     d->mutex.unlock();
 }
 
+auto AudioController::setZones(const QList<AudioZoneOption> &zones) -> void
+{
+    d->mutex.lock();
+    if (_Change(d->zoneOptions, zones))
+        d->dirty |= Zones;
+    d->mutex.unlock();
+}
+
+auto AudioController::setSyncScale(double scale) -> void
+{
+    d->syncScale = scale;
+}
+
 auto AudioController::visualizer() const -> AudioVisualizer*
 {
     return &d->vis;
 }
+
+auto AudioController::profile() const -> AudioProfile*
+{
+    return &d->profile;
+}
+
+auto AudioController::bufferCount() const -> quint64
+{
+    return d->buffers.load();
+}
+
+auto AudioController::passthroughCount() const -> quint64
+{
+    return d->passthroughs.load();
+}
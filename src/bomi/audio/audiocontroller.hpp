@@ -6,7 +6,8 @@ struct af_cfg;                          struct af_info;
 struct mp_chmap;                        struct AudioNormalizerOption;
 class ChannelLayoutMap;                 class AudioFormat;
 class AudioEqualizer;                   class AudioVisualizer;
-enum class ChannelLayout;
+struct AudioZoneOption;                 enum class ChannelLayout;
+class AudioProfile;
 
 class AudioController : public QObject {
     Q_OBJECT
@@ -17,21 +18,44 @@ public:
     auto isTempoScalerActivated() const -> bool;
     auto isNormalizerActivated() const -> bool;
     auto setNormalizerOption(const AudioNormalizerOption &option) -> void;
+    // applied to running filter in place
+    auto setTempoScalerActivated(bool on) -> void;
+    auto setNormalizerActivated(bool on) -> void;
     auto setSoftClip(bool soft) -> void;
     auto setChannelLayoutMap(const ChannelLayoutMap &map) -> void;
     auto setOutputChannelLayout(ChannelLayout layout) -> void;
     auto setEqualizer(const AudioEqualizer &eq) -> void;
+    // extra output devices fed from the chain after tempo scaler
+    auto setZones(const QList<AudioZoneOption> &zones) -> void;
+    // shorten look-ahead of normalizer and tempo scaler
+    auto setLowLatency(bool on) -> void;
+    // integrated loudness of playing file from overview, -inf if unknown
+    // normalizer needs no look-ahead while it is known
+    auto setFileLoudness(double lufs) -> void;
+    // seconds of audio held by filters, updated for every output buffer
+    auto delay() const -> double;
+    // part of playback speed which only keeps video in step with display
+    // it is left to resampler even if tempo scaler is activated, the rest is
+    // resampled too if tempo scaler is not activated
+    auto setSyncScale(double scale) -> void;
     auto chmap() const -> mp_chmap*;
     auto inputFormat() const -> AudioFormat;
     auto outputFormat() const -> AudioFormat;
     auto samplerate() const -> int;
     auto setAnalyzeSpectrum(bool on) -> void;
     auto visualizer() const -> AudioVisualizer*;
+    // timing of each filter stage
+    auto profile() const -> AudioProfile*;
+    // number of buffers handed to output and how many of them skipped all filters
+    auto bufferCount() const -> quint64;
+    auto passthroughCount() const -> quint64;
 signals:
     void inputFormatChanged();
     void outputFormatChanged();
     void samplerateChanged(int sr);
     void gainChanged(double gain);
+    // in LUFS, emitted only while loudness normalization is active
+    void loudnessChanged(double momentary, double shortTerm, double integrated);
     void spectrumObtained(const QList<qreal> &data);
 private:
     static auto open(af_instance *af) -> int;
@@ -39,6 +63,7 @@ private:
     auto reinitialize(mp_audio *data) -> int;
     auto filter(mp_audio *data) -> int;
     auto output() -> int;
+    auto isPassthrough() const -> bool;
     auto uninit() -> void;
     auto control(int cmd, void *arg) -> int;
     struct Data;
@@ -1,41 +1,28 @@
 #include "audioconverter.hpp"
-
-#include "misc/tmp.hpp"
-#include "tmp/type_traits.hpp"
 extern "C" {
 #include <audio/format.h>
 #include <audio/audio.h>
 }
 
-template<class T>
-static auto convert(uchar *dst, float src) -> void
-{
-    auto value = (T*)dst;
-    if (tmp::is_floating_point<T>())
-        *value = src;
-    else
-        *value = src * _Max<T>() + 0.5;
-}
-
-
 auto AudioConverter::setFormat(const AudioBufferFormat &format) -> void
 {
     if (!_Change(m_format, format))
         return;
-    m_convert = [=] () -> Convert {
+    auto &kernel = AudioKernel::table();
+    m_convert = [&] () -> AudioKernel::Convert {
         switch (format.type()) {
         case AF_FORMAT_S16:
         case AF_FORMAT_S16P:
-            return convert<qint16>;
+            return kernel.toS16;
         case AF_FORMAT_S32:
         case AF_FORMAT_S32P:
-            return convert<qint32>;
+            return kernel.toS32;
         case AF_FORMAT_FLOAT:
         case AF_FORMAT_FLOATP:
-            return convert<float>;
+            return kernel.toFloat;
         case AF_FORMAT_DOUBLE:
         case AF_FORMAT_DOUBLEP:
-            return convert<double>;
+            return kernel.toDouble;
         default:
             return nullptr;
         }
@@ -45,31 +32,63 @@ auto AudioConverter::setFormat(const AudioBufferFormat &format) -> void
 
 auto AudioConverter::passthrough(const AudioBufferPtr &/*in*/) const -> bool
 {
-    return m_format.type() == AF_FORMAT_FLOAT;
+    return false;
+}
+
+auto AudioConverter::clip(AudioBufferPtr &in) const -> void
+{
+    Q_ASSERT(in->type() == AF_FORMAT_FLOAT || in->type() == AF_FORMAT_FLOATP);
+    auto &kernel = AudioKernel::table();
+    auto view = in->view<float>();
+    const int samples = in->samples() / in->planes();
+    for (int i = 0; i < in->planes(); ++i) {
+        if (m_softClip)
+            kernel.softclip(view.plane(i), samples);
+        else
+            kernel.hardclip(view.plane(i), samples);
+    }
+}
+
+auto AudioConverter::canRunInPlace(const AudioBufferPtr &in) const -> bool
+{
+    // interleaved output which is not wider than float
+    return in->planes() == 1 && m_format.planes() == 1
+            && m_format.mpAudio().bps <= (int)sizeof(float);
+}
+
+auto AudioConverter::runInPlace(AudioBuffer &buffer) -> void
+{
+    auto view = buffer.view<float>();
+    const int samples = buffer.samples();
+    auto &kernel = AudioKernel::table();
+    if (m_softClip)
+        kernel.softclip(view.begin(), samples);
+    else
+        kernel.hardclip(view.begin(), samples);
+    if (m_format.type() == AF_FORMAT_FLOAT)
+        return;
+    // each sample is written at or before its own position
+    m_convert(view.begin(), view.begin(), samples, 1);
+    buffer.reinterpret(m_format);
 }
 
 auto AudioConverter::run(AudioBufferPtr &in) -> AudioBufferPtr
 {
+    if (canRunInPlace(in)) {
+        runInPlace(*in);
+        return in;
+    }
+    // clip here to be the last stage after mixing and equalizing
+    clip(in);
     if (m_format.type() == AF_FORMAT_FLOAT)
         return in;
     auto dest = newBuffer(m_format, in->frames());
     auto sview = in->constView<float>();
     if (dest->isPlanar()) {
-        for (int ch = 0; ch < dest->channels(); ++ch) {
-            const float *src = sview.plane() + ch;
-            uchar *dst = dest->data()[ch];
-            for (int i = 0; i < in->frames(); ++i) {
-                m_convert(dst, *src);
-                src += dest->channels();
-                dst += dest->bps();
-            }
-        }
-    } else {
-        uchar *dst = dest->data()[0];
-        for (auto it = sview.begin(); it != sview.end(); ++it) {
-            m_convert(dst, *it);
-            dst += dest->bps();
-        }
-    }
+        for (int ch = 0; ch < dest->channels(); ++ch)
+            m_convert(dest->data()[ch], sview.plane() + ch,
+                      in->frames(), dest->channels());
+    } else
+        m_convert(dest->data()[0], sview.plane(), in->samples(), 1);
     return dest;
 }
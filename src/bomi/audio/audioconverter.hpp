@@ -2,17 +2,23 @@
 #define AUDIOCONVERTER_HPP
 
 #include "audiofilter.hpp"
+#include "audiokernel.hpp"
 
 class AudioConverter : public AudioFilter {
 public:
     auto setFormat(const AudioBufferFormat &format) -> void;
+    auto setSoftClip(bool soft) -> void { m_softClip = soft; }
+    // clip float samples in place
+    auto clip(AudioBufferPtr &in) const -> void;
     auto run(AudioBufferPtr &in) -> AudioBufferPtr override;
     auto format() const -> const AudioBufferFormat& { return m_format; }
     auto passthrough(const AudioBufferPtr &in) const -> bool override;
+    auto canRunInPlace(const AudioBufferPtr &in) const -> bool override;
+    auto runInPlace(AudioBuffer &buffer) -> void override;
 private:
     AudioBufferFormat m_format;
-    using Convert = auto (*)(uchar *dst, float src) -> void;
-    Convert m_convert = nullptr;
+    AudioKernel::Convert m_convert = nullptr;
+    bool m_softClip = false;
 };
 
 #endif // AUDIOCONVERTER_HPP
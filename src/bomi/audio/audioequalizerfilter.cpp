@@ -0,0 +1,136 @@
+#include "audioequalizerfilter.hpp"
+#include "audioequalizer.hpp"
+#include "audiokernel.hpp"
+
+static constexpr int Bands = AudioEqualizer::bands();
+using Bank = AudioKernel::BiquadBank;
+
+struct AudioEqualizerFilter::Data {
+    AudioBufferFormat format;
+    AudioEqualizer eq;
+    const AudioKernel::Table *kernel = &AudioKernel::table();
+    struct { float a = 0, b = 0, c = 0; } coefs[Bands];
+    // only bands with non-zero gain are kept in bank
+    Bank bank;
+    int active = 0;
+    std::array<int, Bands> bandOf;
+    std::array<Bank::State, MP_NUM_CHANNELS> states;
+};
+
+AudioEqualizerFilter::AudioEqualizerFilter()
+    : d(new Data)
+{
+    reset();
+}
+
+AudioEqualizerFilter::~AudioEqualizerFilter()
+{
+    delete d;
+}
+
+auto AudioEqualizerFilter::delay() const -> double
+{
+    // follow the estimation in af_equalizer.c of mpv
+    return d->active ? 2.0 / d->format.fps() : 0.0;
+}
+
+auto AudioEqualizerFilter::reset() -> void
+{
+    for (auto &s : d->states)
+        s.clear();
+}
+
+auto AudioEqualizerFilter::setFormat(const AudioBufferFormat &format) -> void
+{
+    if (!_Change(d->format, format))
+        return;
+    const float fps = format.fps();
+    const float f_max = 0.5f * fps;
+    const float w_band = 1; // bandwidth in octave
+    for (int i = 0; i < Bands; ++i) {
+        const float f_center = AudioEqualizer::freqeuncy(i);
+        auto &c = d->coefs[i];
+        if (f_center < f_max) {
+            const float theta = 2.0f * M_PI * f_center / fps;
+            const float alpha = sin(theta) * sinh(log(2.0)*0.5 * w_band * theta/sin(theta));
+            c.a = alpha / (alpha + 1.f);
+            c.b = 2.0 * cos(theta) / (alpha + 1.f);
+            c.c = (alpha - 1.f) / (alpha + 1.f);
+        } else
+            c.a = c.b = c.c = 0.f;
+    }
+    d->active = 0;
+    reset();
+    rebuild();
+}
+
+auto AudioEqualizerFilter::setEqualizer(const AudioEqualizer &eq) -> void
+{
+    if (_Change(d->eq, eq))
+        rebuild();
+}
+
+auto AudioEqualizerFilter::rebuild() -> void
+{
+    // keep history of bands which stay active to avoid clicks
+    const auto old = d->states;
+    const auto oldBandOf = d->bandOf;
+    const int oldActive = d->active;
+    reset();
+
+    int n = 0;
+    for (int i = 0; i < Bands; ++i) {
+        const auto db = qBound(AudioEqualizer::min(), d->eq[i], AudioEqualizer::max());
+        const float amp = std::pow(10., db / 20.) - 1.;
+        const auto &c = d->coefs[i];
+        if (amp == 0.f || (c.a == 0.f && c.b == 0.f && c.c == 0.f))
+            continue;
+        d->bank.a[n] = c.a;
+        d->bank.b[n] = c.b;
+        d->bank.c[n] = c.c;
+        d->bank.amp[n] = amp;
+        for (int j = 0; j < oldActive; ++j) {
+            if (oldBandOf[j] != i)
+                continue;
+            for (int ch = 0; ch < MP_NUM_CHANNELS; ++ch) {
+                d->states[ch].y1[n] = old[ch].y1[j];
+                d->states[ch].y2[n] = old[ch].y2[j];
+            }
+        }
+        d->bandOf[n++] = i;
+    }
+    for (int ch = 0; ch < MP_NUM_CHANNELS; ++ch) {
+        d->states[ch].x1 = old[ch].x1;
+        d->states[ch].x2 = old[ch].x2;
+    }
+    d->active = n;
+    d->bank.setBands(n);
+}
+
+auto AudioEqualizerFilter::passthrough(const AudioBufferPtr &/*in*/) const -> bool
+{
+    return !d->active;
+}
+
+auto AudioEqualizerFilter::run(AudioBufferPtr &in) -> AudioBufferPtr
+{
+    runInPlace(*in);
+    return in;
+}
+
+auto AudioEqualizerFilter::runInPlace(AudioBuffer &buffer) -> void
+{
+    if (buffer.isEmpty() || !d->active)
+        return;
+    auto view = buffer.view<float>();
+    const int nch = buffer.channels();
+    if (buffer.isPlanar()) {
+        for (int ch = 0; ch < nch; ++ch)
+            d->kernel->equalize(view.plane(ch), buffer.frames(), 1,
+                                d->bank, d->states[ch]);
+    } else {
+        for (int ch = 0; ch < nch; ++ch)
+            d->kernel->equalize(view.plane() + ch, buffer.frames(), nch,
+                                d->bank, d->states[ch]);
+    }
+}
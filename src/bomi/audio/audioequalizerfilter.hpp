@@ -0,0 +1,27 @@
+#ifndef AUDIOEQUALIZERFILTER_HPP
+#define AUDIOEQUALIZERFILTER_HPP
+
+#include "audiofilter.hpp"
+
+class AudioEqualizer;
+
+class AudioEqualizerFilter : public AudioFilter {
+public:
+    AudioEqualizerFilter();
+    ~AudioEqualizerFilter();
+    auto setFormat(const AudioBufferFormat &format) -> void;
+    auto setEqualizer(const AudioEqualizer &eq) -> void;
+    auto reset() -> void override;
+    auto delay() const -> double override;
+    auto run(AudioBufferPtr &in) -> AudioBufferPtr override;
+    auto passthrough(const AudioBufferPtr &in) const -> bool override;
+    auto canRunInPlace(const AudioBufferPtr &) const -> bool override
+        { return true; }
+    auto runInPlace(AudioBuffer &buffer) -> void override;
+private:
+    auto rebuild() -> void;
+    struct Data;
+    Data *d;
+};
+
+#endif // AUDIOEQUALIZERFILTER_HPP
@@ -3,11 +3,26 @@
 
 #include "audiobuffer.hpp"
 
+// memory reused by filters in audio thread, only grows
+class AudioScratch {
+public:
+    auto floats(int count) -> float*
+    {
+        if ((int)m_data.size() < count)
+            m_data.resize(count);
+        return m_data.data();
+    }
+private:
+    std::vector<float> m_data;
+};
+
 class AudioFilter {
 public:
     AudioFilter() { }
     virtual ~AudioFilter() { }
     auto setPool(mp_audio_pool *pool) -> void { m_pool = pool; }
+    auto setScratch(AudioScratch *scratch) -> void { m_scratch = scratch; }
+    auto scratch() const -> AudioScratch* { return m_scratch; }
     auto newBuffer(const AudioBufferFormat &format, int frames) const -> AudioBufferPtr
     { return AudioBuffer::fromMpAudio(mp_audio_pool_get(m_pool, &format.mpAudio(), frames)); }
     virtual auto setScale(double scale) -> void;
@@ -15,8 +30,14 @@ public:
     virtual auto delay() const -> double;
     virtual auto passthrough(const AudioBufferPtr &in) const -> bool = 0;
     virtual auto run(AudioBufferPtr &in) -> AudioBufferPtr = 0;
+    // opt-in path which overwrites the memory of buffer instead of allocation
+    // buffer may be reinterpreted to a format not larger than before
+    virtual auto canRunInPlace(const AudioBufferPtr &/*in*/) const -> bool
+        { return false; }
+    virtual auto runInPlace(AudioBuffer &/*buffer*/) -> void { }
 private:
     mp_audio_pool *m_pool = nullptr;
+    AudioScratch *m_scratch = nullptr;
 };
 
 #endif // AUDIOFILTER_HPP
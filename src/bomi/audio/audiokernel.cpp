@@ -0,0 +1,754 @@
+#include "audiokernel.hpp"
+#include "tmp/type_traits.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AUDIO_KERNEL_X86 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AUDIO_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace AudioKernel {
+
+static constexpr float HalfPi = M_PI * 0.5;
+// odd Taylor terms of sin(x) up to x^9, error < 4e-6 in [-pi/2, pi/2]
+static constexpr float S3 = -1.0/6, S5 = 1.0/120, S7 = -1.0/5040, S9 = 1.0/362880;
+// log(m) = 2*atanh(s) with s = (m - 1)/(m + 1), odd terms up to s^7
+// m is reduced into [sqrt(1/2), sqrt(2)) so |s| < 0.1716 and error < 3e-8
+static constexpr float L1 = 2.0, L3 = 2.0/3, L5 = 2.0/5, L7 = 2.0/7;
+static constexpr float Ln2 = M_LN2;
+static constexpr int SqrtHalfBits = 0x3f3504f3;
+// lcm(channels, lanes) for any channels up to 8 and 4 lanes
+static constexpr int CompressPeriod = 32;
+
+/******************************************************************************/
+
+static auto mixScalar(float *dst, const float *src, int frames,
+                      const MixMatrix &m) -> void
+{
+    const int nin = m.inputs(), nout = m.outputs();
+    for (int f = 0; f < frames; ++f, src += nin) {
+        for (int o = 0; o < nout; ++o) {
+            float v = 0.f;
+            for (int i = 0; i < nin; ++i)
+                v += src[i] * m.coef(i, o);
+            *dst++ = v;
+        }
+    }
+}
+
+static auto amplifyScalar(float *data, int samples, float amp) -> void
+{
+    for (int i = 0; i < samples; ++i)
+        data[i] *= amp;
+}
+
+static auto hardclipScalar(float *data, int samples) -> void
+{
+    for (int i = 0; i < samples; ++i)
+        data[i] = qBound(-1.f, data[i], 1.f);
+}
+
+static auto softclipScalar(float *data, int samples) -> void
+{
+    for (int i = 0; i < samples; ++i) {
+        const float p = data[i];
+        data[i] = p >= HalfPi ? 1.f : p <= -HalfPi ? -1.f : std::sin(p);
+    }
+}
+
+static auto equalizeScalar(float *data, int frames, int stride,
+                           const BiquadBank &bank, BiquadBank::State &s) -> void
+{
+    const int bands = bank.bands();
+    for (int f = 0; f < frames; ++f, data += stride) {
+        const float x = *data, dx = x - s.x2;
+        float v = x;
+        for (int i = 0; i < bands; ++i) {
+            const float y = bank.a[i] * dx + bank.b[i] * s.y1[i] + bank.c[i] * s.y2[i];
+            s.y2[i] = s.y1[i];
+            s.y1[i] = y;
+            v += y * bank.amp[i];
+        }
+        s.x2 = s.x1;
+        s.x1 = x;
+        *data = v;
+    }
+}
+
+static auto dotScalar(const float *a, const float *b, int count) -> float
+{
+    float sum = 0.f;
+    for (int i = 0; i < count; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+SIA compressOne(float v, float c1, float c2) -> float
+    { return c1 > 0.f ? std::copysign(std::log(1.f + c1 * std::abs(v)) * c2, v) : v; }
+
+// samples from begin to end of interleaved data
+static auto compressSamples(float *data, int begin, int end, int nch,
+                            const float *c1, const float *c2) -> void
+{
+    for (int i = begin, ch = begin % nch; i < end; ++i) {
+        data[i] = compressOne(data[i], c1[ch], c2[ch]);
+        if (++ch == nch)
+            ch = 0;
+    }
+}
+
+static auto compressScalar(float *data, int frames, int nch,
+                           const float *c1, const float *c2) -> void
+{
+    compressSamples(data, 0, frames * nch, nch, c1, c2);
+}
+
+// repeat per channel coefficients for lanes which cross frames
+static auto repeat(float *k1, float *k2, const float *c1, const float *c2,
+                   int nch, int lanes) -> int
+{
+    int period = nch;
+    while (period % lanes)
+        period += nch;
+    Q_ASSERT(period <= CompressPeriod);
+    for (int i = 0; i < period; ++i) {
+        k1[i] = c1[i % nch];
+        k2[i] = c2[i % nch];
+    }
+    return period;
+}
+
+template<class T>
+SIA scale() -> float { return _Max<T>(); }
+
+// float cannot represent INT32_MAX, clamp to the largest float below 2^31
+template<class T>
+SIA limit() -> float { return tmp::is_same<T, qint32>() ? 2147483520.f : _Max<T>(); }
+
+template<class T>
+SIA lowest() -> float { return tmp::is_same<T, qint32>() ? -limit<T>() : _Min<T>(); }
+
+template<class T>
+SIA convertOne(float v) -> T
+{
+    if (tmp::is_floating_point<T>())
+        return v;
+    return std::lrint(qBound<float>(lowest<T>(), v * scale<T>(), limit<T>()));
+}
+
+template<class T>
+static auto convertScalar(void *dst, const float *src, int count, int stride) -> void
+{
+    auto out = static_cast<T*>(dst);
+    if (tmp::is_same<T, float>() && stride == 1) {
+        if (dst != src)
+            memmove(dst, src, count * sizeof(float));
+        return;
+    }
+    for (int i = 0; i < count; ++i, src += stride)
+        out[i] = convertOne<T>(*src);
+}
+
+/******************************************************************************/
+
+#ifdef AUDIO_KERNEL_X86
+
+TARGET("sse2")
+static auto mixSse2(float *dst, const float *src, int frames,
+                    const MixMatrix &m) -> void
+{
+    const int nin = m.inputs(), nout = m.outputs();
+    const int width = nout > 4 ? 8 : 4;
+    // a full-width store spills into the following frames,
+    // which is harmless except for the last few frames of the block
+    const int safe = frames - (width + nout - 1) / nout;
+    __m128 c[MixMatrix::MaxChannels][2];
+    for (int i = 0; i < nin; ++i) {
+        c[i][0] = _mm_loadu_ps(m.column(i));
+        c[i][1] = _mm_loadu_ps(m.column(i) + 4);
+    }
+    alignas(16) float tmp[8];
+    for (int f = 0; f < frames; ++f, src += nin, dst += nout) {
+        __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+        for (int i = 0; i < nin; ++i) {
+            const __m128 s = _mm_set1_ps(src[i]);
+            lo = _mm_add_ps(lo, _mm_mul_ps(s, c[i][0]));
+            hi = _mm_add_ps(hi, _mm_mul_ps(s, c[i][1]));
+        }
+        if (f < safe) {
+            _mm_storeu_ps(dst, lo);
+            if (width > 4)
+                _mm_storeu_ps(dst + 4, hi);
+        } else {
+            _mm_store_ps(tmp, lo);
+            _mm_store_ps(tmp + 4, hi);
+            memcpy(dst, tmp, sizeof(float) * nout);
+        }
+    }
+}
+
+TARGET("sse2")
+static auto amplifySse2(float *data, int samples, float amp) -> void
+{
+    const __m128 a = _mm_set1_ps(amp);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), a));
+    amplifyScalar(data + i, samples - i, amp);
+}
+
+TARGET("sse2")
+static auto hardclipSse2(float *data, int samples) -> void
+{
+    const __m128 max = _mm_set1_ps(1.f), min = _mm_set1_ps(-1.f);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 v = _mm_loadu_ps(data + i);
+        _mm_storeu_ps(data + i, _mm_min_ps(_mm_max_ps(v, min), max));
+    }
+    hardclipScalar(data + i, samples - i);
+}
+
+TARGET("sse2")
+static auto softclipSse2(float *data, int samples) -> void
+{
+    const __m128 max = _mm_set1_ps(HalfPi), min = _mm_set1_ps(-HalfPi);
+    const __m128 s3 = _mm_set1_ps(S3), s5 = _mm_set1_ps(S5);
+    const __m128 s7 = _mm_set1_ps(S7), s9 = _mm_set1_ps(S9);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i), min), max);
+        const __m128 x2 = _mm_mul_ps(x, x);
+        __m128 p = _mm_add_ps(s7, _mm_mul_ps(x2, s9));
+        p = _mm_add_ps(s5, _mm_mul_ps(x2, p));
+        p = _mm_add_ps(s3, _mm_mul_ps(x2, p));
+        p = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x2, x), p));
+        _mm_storeu_ps(data + i, p);
+    }
+    softclipScalar(data + i, samples - i);
+}
+
+TARGET("sse2")
+static auto equalizeSse2(float *data, int frames, int stride,
+                         const BiquadBank &bank, BiquadBank::State &s) -> void
+{
+    const int bands = bank.bands();
+    for (int f = 0; f < frames; ++f, data += stride) {
+        const float x = *data;
+        const __m128 dx = _mm_set1_ps(x - s.x2);
+        __m128 acc = _mm_setzero_ps();
+        for (int i = 0; i < bands; i += 4) {
+            const __m128 y1 = _mm_load_ps(s.y1 + i);
+            __m128 y = _mm_mul_ps(_mm_load_ps(bank.a + i), dx);
+            y = _mm_add_ps(y, _mm_mul_ps(_mm_load_ps(bank.b + i), y1));
+            y = _mm_add_ps(y, _mm_mul_ps(_mm_load_ps(bank.c + i), _mm_load_ps(s.y2 + i)));
+            _mm_store_ps(s.y2 + i, y1);
+            _mm_store_ps(s.y1 + i, y);
+            acc = _mm_add_ps(acc, _mm_mul_ps(y, _mm_load_ps(bank.amp + i)));
+        }
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        s.x2 = s.x1;
+        s.x1 = x;
+        *data = x + _mm_cvtss_f32(acc);
+    }
+}
+
+TARGET("avx")
+static auto mixAvx(float *dst, const float *src, int frames,
+                   const MixMatrix &m) -> void
+{
+    const int nin = m.inputs(), nout = m.outputs();
+    const int safe = frames - (8 + nout - 1) / nout;
+    __m256 c[MixMatrix::MaxChannels];
+    for (int i = 0; i < nin; ++i)
+        c[i] = _mm256_loadu_ps(m.column(i));
+    alignas(32) float tmp[8];
+    for (int f = 0; f < frames; ++f, src += nin, dst += nout) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int i = 0; i < nin; ++i)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(src[i]), c[i]));
+        if (f < safe)
+            _mm256_storeu_ps(dst, acc);
+        else {
+            _mm256_store_ps(tmp, acc);
+            memcpy(dst, tmp, sizeof(float) * nout);
+        }
+    }
+}
+
+TARGET("avx")
+static auto amplifyAvx(float *data, int samples, float amp) -> void
+{
+    const __m256 a = _mm256_set1_ps(amp);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), a));
+    amplifyScalar(data + i, samples - i, amp);
+}
+
+TARGET("avx")
+static auto hardclipAvx(float *data, int samples) -> void
+{
+    const __m256 max = _mm256_set1_ps(1.f), min = _mm256_set1_ps(-1.f);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256 v = _mm256_loadu_ps(data + i);
+        _mm256_storeu_ps(data + i, _mm256_min_ps(_mm256_max_ps(v, min), max));
+    }
+    hardclipScalar(data + i, samples - i);
+}
+
+TARGET("avx")
+static auto softclipAvx(float *data, int samples) -> void
+{
+    const __m256 max = _mm256_set1_ps(HalfPi), min = _mm256_set1_ps(-HalfPi);
+    const __m256 s3 = _mm256_set1_ps(S3), s5 = _mm256_set1_ps(S5);
+    const __m256 s7 = _mm256_set1_ps(S7), s9 = _mm256_set1_ps(S9);
+    int i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(data + i), min), max);
+        const __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_add_ps(s7, _mm256_mul_ps(x2, s9));
+        p = _mm256_add_ps(s5, _mm256_mul_ps(x2, p));
+        p = _mm256_add_ps(s3, _mm256_mul_ps(x2, p));
+        p = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x2, x), p));
+        _mm256_storeu_ps(data + i, p);
+    }
+    softclipScalar(data + i, samples - i);
+}
+
+TARGET("avx")
+static auto equalizeAvx(float *data, int frames, int stride,
+                        const BiquadBank &bank, BiquadBank::State &s) -> void
+{
+    const int bands = bank.bands();
+    for (int f = 0; f < frames; ++f, data += stride) {
+        const float x = *data;
+        const __m256 dx = _mm256_set1_ps(x - s.x2);
+        __m256 acc = _mm256_setzero_ps();
+        for (int i = 0; i < bands; i += 8) {
+            const __m256 y1 = _mm256_load_ps(s.y1 + i);
+            __m256 y = _mm256_mul_ps(_mm256_load_ps(bank.a + i), dx);
+            y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_load_ps(bank.b + i), y1));
+            y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_load_ps(bank.c + i),
+                                               _mm256_load_ps(s.y2 + i)));
+            _mm256_store_ps(s.y2 + i, y1);
+            _mm256_store_ps(s.y1 + i, y);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(y, _mm256_load_ps(bank.amp + i)));
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc),
+                                _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        s.x2 = s.x1;
+        s.x1 = x;
+        *data = x + _mm_cvtss_f32(sum);
+    }
+}
+
+TARGET("sse2")
+static auto dotSse2(const float *a, const float *b, int count) -> float
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc) + dotScalar(a + i, b + i, count - i);
+}
+
+TARGET("avx")
+static auto dotAvx(const float *a, const float *b, int count) -> float
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i),
+                                                 _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8),
+                                                 _mm256_loadu_ps(b + i + 8)));
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + dotScalar(a + i, b + i, count - i);
+}
+
+TARGET("sse2")
+static inline auto compress4(__m128 v, __m128 c1, __m128 c2) -> __m128
+{
+    const __m128 sign = _mm_set1_ps(-0.f), one = _mm_set1_ps(1.f);
+    const __m128 y = _mm_add_ps(one, _mm_mul_ps(c1, _mm_andnot_ps(sign, v)));
+    // y = m*2^e
+    const __m128i bits = _mm_castps_si128(y);
+    const __m128i e = _mm_srai_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(SqrtHalfBits)), 23);
+    const __m128 m = _mm_castsi128_ps(_mm_sub_epi32(bits, _mm_slli_epi32(e, 23)));
+    const __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    const __m128 s2 = _mm_mul_ps(s, s);
+    __m128 p = _mm_add_ps(_mm_set1_ps(L5), _mm_mul_ps(s2, _mm_set1_ps(L7)));
+    p = _mm_add_ps(_mm_set1_ps(L3), _mm_mul_ps(s2, p));
+    p = _mm_add_ps(_mm_set1_ps(L1), _mm_mul_ps(s2, p));
+    const __m128 ln = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(e), _mm_set1_ps(Ln2)),
+                                 _mm_mul_ps(s, p));
+    const __m128 r = _mm_or_ps(_mm_mul_ps(ln, c2), _mm_and_ps(v, sign));
+    const __m128 mask = _mm_cmpgt_ps(c1, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(mask, r), _mm_andnot_ps(mask, v));
+}
+
+// avx has no 256-bit integer ops for exponent, so this serves avx too
+TARGET("sse2")
+static auto compressSse2(float *data, int frames, int nch,
+                         const float *c1, const float *c2) -> void
+{
+    alignas(16) float k1[CompressPeriod], k2[CompressPeriod];
+    const int period = repeat(k1, k2, c1, c2, nch, 4);
+    const int samples = frames * nch;
+    int i = 0;
+    for (int k = 0; i + 4 <= samples; i += 4) {
+        const __m128 v = _mm_loadu_ps(data + i);
+        _mm_storeu_ps(data + i, compress4(v, _mm_load_ps(k1 + k), _mm_load_ps(k2 + k)));
+        if ((k += 4) == period)
+            k = 0;
+    }
+    compressSamples(data, i, samples, nch, c1, c2);
+}
+
+// all loads of a step precede its stores so that dst may alias src
+TARGET("sse2")
+static auto toS16Sse2(void *dst, const float *src, int count, int stride) -> void
+{
+    if (stride != 1)
+        return convertScalar<qint16>(dst, src, count, stride);
+    auto out = static_cast<qint16*>(dst);
+    const __m128 s = _mm_set1_ps(scale<qint16>());
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // cvtps rounds to nearest and packs saturates
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), s));
+        const __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), s));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+    }
+    convertScalar<qint16>(out + i, src + i, count - i, 1);
+}
+
+TARGET("sse2")
+static auto toS32Sse2(void *dst, const float *src, int count, int stride) -> void
+{
+    if (stride != 1)
+        return convertScalar<qint32>(dst, src, count, stride);
+    auto out = static_cast<qint32*>(dst);
+    const __m128 s = _mm_set1_ps(scale<qint32>());
+    const __m128 max = _mm_set1_ps(limit<qint32>()), min = _mm_set1_ps(-limit<qint32>());
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), s);
+        const __m128i r = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, min), max));
+        _mm_storeu_si128((__m128i*)(out + i), r);
+    }
+    convertScalar<qint32>(out + i, src + i, count - i, 1);
+}
+
+TARGET("sse2")
+static auto toDoubleSse2(void *dst, const float *src, int count, int stride) -> void
+{
+    if (stride != 1)
+        return convertScalar<double>(dst, src, count, stride);
+    auto out = static_cast<double*>(dst);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(out + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    convertScalar<double>(out + i, src + i, count - i, 1);
+}
+
+#endif // AUDIO_KERNEL_X86
+
+/******************************************************************************/
+
+#ifdef AUDIO_KERNEL_NEON
+
+static auto mixNeon(float *dst, const float *src, int frames,
+                    const MixMatrix &m) -> void
+{
+    const int nin = m.inputs(), nout = m.outputs();
+    const int width = nout > 4 ? 8 : 4;
+    const int safe = frames - (width + nout - 1) / nout;
+    float32x4_t c[MixMatrix::MaxChannels][2];
+    for (int i = 0; i < nin; ++i) {
+        c[i][0] = vld1q_f32(m.column(i));
+        c[i][1] = vld1q_f32(m.column(i) + 4);
+    }
+    float tmp[8];
+    for (int f = 0; f < frames; ++f, src += nin, dst += nout) {
+        float32x4_t lo = vdupq_n_f32(0.f), hi = vdupq_n_f32(0.f);
+        for (int i = 0; i < nin; ++i) {
+            lo = vmlaq_n_f32(lo, c[i][0], src[i]);
+            hi = vmlaq_n_f32(hi, c[i][1], src[i]);
+        }
+        if (f < safe) {
+            vst1q_f32(dst, lo);
+            if (width > 4)
+                vst1q_f32(dst + 4, hi);
+        } else {
+            vst1q_f32(tmp, lo);
+            vst1q_f32(tmp + 4, hi);
+            memcpy(dst, tmp, sizeof(float) * nout);
+        }
+    }
+}
+
+static auto amplifyNeon(float *data, int samples, float amp) -> void
+{
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), amp));
+    amplifyScalar(data + i, samples - i, amp);
+}
+
+static auto hardclipNeon(float *data, int samples) -> void
+{
+    const float32x4_t max = vdupq_n_f32(1.f), min = vdupq_n_f32(-1.f);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4)
+        vst1q_f32(data + i, vminq_f32(vmaxq_f32(vld1q_f32(data + i), min), max));
+    hardclipScalar(data + i, samples - i);
+}
+
+static auto softclipNeon(float *data, int samples) -> void
+{
+    const float32x4_t max = vdupq_n_f32(HalfPi), min = vdupq_n_f32(-HalfPi);
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const float32x4_t x = vminq_f32(vmaxq_f32(vld1q_f32(data + i), min), max);
+        const float32x4_t x2 = vmulq_f32(x, x);
+        float32x4_t p = vmlaq_n_f32(vdupq_n_f32(S7), x2, S9);
+        p = vmlaq_f32(vdupq_n_f32(S5), x2, p);
+        p = vmlaq_f32(vdupq_n_f32(S3), x2, p);
+        p = vmlaq_f32(x, vmulq_f32(x2, x), p);
+        vst1q_f32(data + i, p);
+    }
+    softclipScalar(data + i, samples - i);
+}
+
+static auto equalizeNeon(float *data, int frames, int stride,
+                         const BiquadBank &bank, BiquadBank::State &s) -> void
+{
+    const int bands = bank.bands();
+    for (int f = 0; f < frames; ++f, data += stride) {
+        const float x = *data, dx = x - s.x2;
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (int i = 0; i < bands; i += 4) {
+            const float32x4_t y1 = vld1q_f32(s.y1 + i);
+            float32x4_t y = vmulq_n_f32(vld1q_f32(bank.a + i), dx);
+            y = vmlaq_f32(y, vld1q_f32(bank.b + i), y1);
+            y = vmlaq_f32(y, vld1q_f32(bank.c + i), vld1q_f32(s.y2 + i));
+            vst1q_f32(s.y2 + i, y1);
+            vst1q_f32(s.y1 + i, y);
+            acc = vmlaq_f32(acc, y, vld1q_f32(bank.amp + i));
+        }
+        const float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        s.x2 = s.x1;
+        s.x1 = x;
+        *data = x + vget_lane_f32(vpadd_f32(sum, sum), 0);
+    }
+}
+
+static auto dotNeon(const float *a, const float *b, int count) -> float
+{
+    float32x4_t acc0 = vdupq_n_f32(0.f), acc1 = vdupq_n_f32(0.f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+    const float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0) + dotScalar(a + i, b + i, count - i);
+}
+
+static inline auto compress4Neon(float32x4_t v, float32x4_t c1,
+                                 float32x4_t c2) -> float32x4_t
+{
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t y = vmlaq_f32(one, c1, vabsq_f32(v));
+    // y = m*2^e
+    const int32x4_t bits = vreinterpretq_s32_f32(y);
+    const int32x4_t e = vshrq_n_s32(vsubq_s32(bits, vdupq_n_s32(SqrtHalfBits)), 23);
+    const float32x4_t m = vreinterpretq_f32_s32(vsubq_s32(bits, vshlq_n_s32(e, 23)));
+    // two newton steps on the estimate reach float precision
+    const float32x4_t den = vaddq_f32(m, one);
+    float32x4_t inv = vrecpeq_f32(den);
+    inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+    const float32x4_t s = vmulq_f32(vsubq_f32(m, one), inv), s2 = vmulq_f32(s, s);
+    float32x4_t p = vmlaq_n_f32(vdupq_n_f32(L5), s2, L7);
+    p = vmlaq_f32(vdupq_n_f32(L3), s2, p);
+    p = vmlaq_f32(vdupq_n_f32(L1), s2, p);
+    const float32x4_t ln = vmlaq_n_f32(vmulq_f32(s, p), vcvtq_f32_s32(e), Ln2);
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000));
+    const float32x4_t r = vreinterpretq_f32_u32(
+                vorrq_u32(vreinterpretq_u32_f32(vmulq_f32(ln, c2)), sign));
+    return vbslq_f32(vcgtq_f32(c1, vdupq_n_f32(0.f)), r, v);
+}
+
+static auto compressNeon(float *data, int frames, int nch,
+                         const float *c1, const float *c2) -> void
+{
+    float k1[CompressPeriod], k2[CompressPeriod];
+    const int period = repeat(k1, k2, c1, c2, nch, 4);
+    const int samples = frames * nch;
+    int i = 0;
+    for (int k = 0; i + 4 <= samples; i += 4) {
+        const float32x4_t v = vld1q_f32(data + i);
+        vst1q_f32(data + i, compress4Neon(v, vld1q_f32(k1 + k), vld1q_f32(k2 + k)));
+        if ((k += 4) == period)
+            k = 0;
+    }
+    compressSamples(data, i, samples, nch, c1, c2);
+}
+
+// round to nearest even like lrint() and cvtps, saturated to qint16 later
+static inline auto roundS16Neon(float32x4_t v) -> int32x4_t
+{
+#ifdef __aarch64__
+    return vcvtnq_s32_f32(v);
+#else
+    // no fraction bits are left after adding 1.5 * 2^23, so addition rounds
+    // to even; exact for anything clamped into qint16 range
+    const float32x4_t magic = vdupq_n_f32(12582912.f);
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(-32768.f)), vdupq_n_f32(32767.f));
+    return vcvtq_s32_f32(vsubq_f32(vaddq_f32(v, magic), magic));
+#endif
+}
+
+static auto toS16Neon(void *dst, const float *src, int count, int stride) -> void
+{
+    if (stride != 1)
+        return convertScalar<qint16>(dst, src, count, stride);
+    auto out = static_cast<qint16*>(dst);
+    const float32x4_t s = vdupq_n_f32(scale<qint16>());
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int32x4_t lo = roundS16Neon(vmulq_f32(vld1q_f32(src + i), s));
+        const int32x4_t hi = roundS16Neon(vmulq_f32(vld1q_f32(src + i + 4), s));
+        const int16x8_t r = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+        vst1q_s16(out + i, r);
+    }
+    convertScalar<qint16>(out + i, src + i, count - i, 1);
+}
+
+#endif // AUDIO_KERNEL_NEON
+
+/******************************************************************************/
+
+auto isaName(Isa isa) -> const char*
+{
+    switch (isa) {
+    case Isa::Sse2: return "SSE2";
+    case Isa::Avx:  return "AVX";
+    case Isa::Neon: return "NEON";
+    default:        return "Scalar";
+    }
+}
+
+static auto make(Isa isa) -> Table
+{
+    Table t;
+    t.isa = Isa::Scalar;
+    t.mix = mixScalar;
+    t.amplify = amplifyScalar;
+    t.hardclip = hardclipScalar;
+    t.softclip = softclipScalar;
+    t.equalize = equalizeScalar;
+    t.dot = dotScalar;
+    t.compress = compressScalar;
+    t.toS16 = convertScalar<qint16>;
+    t.toS32 = convertScalar<qint32>;
+    t.toFloat = convertScalar<float>;
+    t.toDouble = convertScalar<double>;
+    switch (isa) {
+#ifdef AUDIO_KERNEL_X86
+    case Isa::Avx:
+        if (__builtin_cpu_supports("avx")) {
+            t.isa = Isa::Avx;
+            t.mix = mixAvx;
+            t.amplify = amplifyAvx;
+            t.hardclip = hardclipAvx;
+            t.softclip = softclipAvx;
+            t.equalize = equalizeAvx;
+            t.dot = dotAvx;
+            t.compress = compressSse2;
+            t.toS16 = toS16Sse2;
+            t.toS32 = toS32Sse2;
+            t.toDouble = toDoubleSse2;
+            break;
+        } // fall through
+    case Isa::Sse2:
+        if (__builtin_cpu_supports("sse2")) {
+            t.isa = Isa::Sse2;
+            t.mix = mixSse2;
+            t.amplify = amplifySse2;
+            t.hardclip = hardclipSse2;
+            t.softclip = softclipSse2;
+            t.equalize = equalizeSse2;
+            t.dot = dotSse2;
+            t.compress = compressSse2;
+            t.toS16 = toS16Sse2;
+            t.toS32 = toS32Sse2;
+            t.toDouble = toDoubleSse2;
+        }
+        break;
+#endif
+#ifdef AUDIO_KERNEL_NEON
+    case Isa::Neon:
+        t.isa = Isa::Neon;
+        t.mix = mixNeon;
+        t.amplify = amplifyNeon;
+        t.hardclip = hardclipNeon;
+        t.softclip = softclipNeon;
+        t.equalize = equalizeNeon;
+        t.dot = dotNeon;
+        t.compress = compressNeon;
+        t.toS16 = toS16Neon;
+        break;
+#endif
+    default:
+        break;
+    }
+    return t;
+}
+
+auto table(Isa isa) -> const Table&
+{
+    static const std::array<Table, 4> tables = {
+        make(Isa::Scalar), make(Isa::Sse2), make(Isa::Avx), make(Isa::Neon)
+    };
+    return tables[(int)isa];
+}
+
+auto table() -> const Table&
+{
+    static const Table &best = [] () -> const Table& {
+#ifdef AUDIO_KERNEL_X86
+        return table(Isa::Avx);
+#elif defined(AUDIO_KERNEL_NEON)
+        return table(Isa::Neon);
+#else
+        return table(Isa::Scalar);
+#endif
+    }();
+    return best;
+}
+
+}
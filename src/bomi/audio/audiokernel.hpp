@@ -0,0 +1,85 @@
+#ifndef AUDIOKERNEL_HPP
+#define AUDIOKERNEL_HPP
+
+// block kernels for float audio processing in the audio thread
+// every kernel has a scalar reference and is dispatched at runtime
+
+namespace AudioKernel {
+
+enum class Isa { Scalar, Sse2, Avx, Neon };
+
+// column-major dense mixing matrix, each column padded to MaxChannels
+// coef(i, o) is the gain of input channel i to output channel o
+struct MixMatrix {
+    static constexpr int MaxChannels = 8;
+    auto resize(int in, int out) -> void
+    {
+        m_in = in; m_out = out;
+        m_coefs.assign(in * MaxChannels, 0.f);
+    }
+    auto coef(int in, int out) -> float& { return m_coefs[in * MaxChannels + out]; }
+    auto coef(int in, int out) const -> float
+        { return m_coefs[in * MaxChannels + out]; }
+    auto column(int in) const -> const float* { return &m_coefs[in * MaxChannels]; }
+    auto inputs() const -> int { return m_in; }
+    auto outputs() const -> int { return m_out; }
+    auto scale(float s) -> void { for (auto &c : m_coefs) c *= s; }
+private:
+    int m_in = 0, m_out = 0;
+    std::vector<float> m_coefs;
+};
+
+// band-major coefficients of parallel peaking biquads
+// y[n] = a*(x[n] - x[n-2]) + b*y[n-1] + c*y[n-2], out = x + sum amp*y
+// bands() is padded with silent bands to a multiple of Pad
+struct BiquadBank {
+    static constexpr int MaxBands = 16, Pad = 8;
+    struct State {
+        auto clear() -> void { memset(this, 0, sizeof(*this)); }
+        alignas(32) float y1[MaxBands], y2[MaxBands];
+        float x1, x2;
+    };
+    auto bands() const -> int { return m_bands; }
+    auto setBands(int bands) -> void
+    {
+        m_bands = (bands + Pad - 1) / Pad * Pad;
+        for (int i = bands; i < MaxBands; ++i)
+            a[i] = b[i] = c[i] = amp[i] = 0.f;
+    }
+    alignas(32) float a[MaxBands], b[MaxBands], c[MaxBands], amp[MaxBands];
+private:
+    int m_bands = 0;
+};
+
+// convert count floats which are stride floats apart into packed samples
+// integers are rounded to nearest and saturated
+using Convert = auto (*)(void *dst, const float *src, int count, int stride) -> void;
+
+struct Table {
+    Isa isa = Isa::Scalar;
+    Convert toS16 = nullptr, toS32 = nullptr, toFloat = nullptr, toDouble = nullptr;
+    // dst[f * outputs + o] = sum_i m(i, o) * src[f * inputs + i]
+    auto (*mix)(float *dst, const float *src, int frames,
+                const MixMatrix &m) -> void = nullptr;
+    auto (*amplify)(float *data, int samples, float amp) -> void = nullptr;
+    auto (*hardclip)(float *data, int samples) -> void = nullptr;
+    auto (*softclip)(float *data, int samples) -> void = nullptr;
+    auto (*dot)(const float *a, const float *b, int count) -> float = nullptr;
+    // downmix compressor on interleaved frames, per channel:
+    // v = sign(v)*log(1 + c1*|v|)*c2 if c1 > 0, otherwise v is kept
+    // evaluated in float, relative error is a few float epsilons
+    auto (*compress)(float *data, int frames, int channels,
+                     const float *c1, const float *c2) -> void = nullptr;
+    // filter one channel in place, samples are stride floats apart
+    auto (*equalize)(float *data, int frames, int stride,
+                     const BiquadBank &bank, BiquadBank::State &s) -> void = nullptr;
+};
+
+auto isaName(Isa isa) -> const char*;
+// best table for running cpu
+auto table() -> const Table&;
+auto table(Isa isa) -> const Table&;
+
+}
+
+#endif // AUDIOKERNEL_HPP
@@ -1,4 +1,5 @@
 #include "audiomixer.hpp"
+#include "audiokernel.hpp"
 
 static auto LambertW1(const double z) -> double {
     const double eps=4.0e-16, em1=0.3678794411714423215955237701614608;
@@ -51,41 +52,37 @@ struct CompressInfo {
     }
 };
 
-static auto softclip(float p) -> float
-{
-    return (p >= M_PI*0.5) ? 1.0 : ((p <= -M_PI*0.5) ? -1.0 : std::sin(p));
-}
-
-static auto hardclip(float p) -> float
-{
-    return p < -1.0 ? -1.0 : p > 1.0 ? 1.0 : p;
-}
-
-static constexpr int Bands = AudioEqualizer::bands();
-
 struct AudioMixer::Data {
     AudioBufferFormat in, out;
     float amp = 1.0;
-    bool softClip = false;
     bool mix = true;
     std::array<int, MP_SPEAKER_ID_COUNT> ch_index_src, ch_index_dst;
     ChannelManipulation ch_man;
     ChannelLayoutMap map;
-    AudioEqualizer eq;
-    bool eq_zero = true;
 
     const std::vector<CompressInfo> compressInfo = CompressInfo::create();
-
-    struct { float a = 0, b = 0, c = 0, amp = 0; } coefs[Bands];
-    struct { float x[2], y[Bands][2]; } xys[MP_NUM_CHANNELS];
+    const AudioKernel::Table *kernel = &AudioKernel::table();
+    // flat form of ch_man compiled by setChannelLayoutMap()
+    // input indices for output dch: src[first[dch]] until src[first[dch + 1]]
+    // compressor coefficients per output, c1 is zero for a single source
+    struct {
+        std::array<int, MP_NUM_CHANNELS + 1> first;
+        std::array<int, MP_NUM_CHANNELS * MP_NUM_CHANNELS> src;
+        std::array<double, MP_NUM_CHANNELS> c1, c2;
+        // same coefficients for kernel, compressed if any c1 is nonzero
+        std::array<float, MP_NUM_CHANNELS> k1, k2;
+        bool compressed = false;
+    } plan;
+    // dense form of plan: unit gains and scaled by amp
+    AudioKernel::MixMatrix matrix, scaled;
+    float scaledAmp = -1.f;
+
+    // ref: http://www.voegler.eu/pub/audio/
+    //      digital-audio-mixing-and-normalization.html
+    auto compress(double v, int dch) const -> double
+        { return std::copysign(log(1.0 + plan.c1[dch]*std::abs(v))*plan.c2[dch], v); }
 };
 
-auto AudioMixer::delay() const -> double
-{
-    // follow the estimation in af_equalizer.c of mpv
-    return d->eq_zero ? 0.0 : 2.0 / d->out.fps();
-}
-
 AudioMixer::AudioMixer()
     : d(new Data)
 {
@@ -106,21 +103,36 @@ auto AudioMixer::setChannelLayoutMap(const ChannelLayoutMap &map) -> void
     d->map = map;
     d->ch_man = map(d->in.channels(), d->out.channels());
     d->mix = d->in != d->out || !d->map.isIdentity(d->in.channels(), d->out.channels());
-}
 
-auto AudioMixer::setEqualizer(const AudioEqualizer &eq) -> void
-{
-    d->eq = eq;
-    d->eq_zero = eq.isZero();
-    if (d->eq_zero) {
-        for (auto &c : d->coefs)
-            c.amp = 0.0;
-    } else {
-        for (int i = 0; i < eq.size(); ++i) {
-            const auto db = qBound(eq.min(), eq[i], eq.max());
-            d->coefs[i].amp = std::pow(10., db / 20.) - 1.;
+    const auto &chin = d->in.channels(), &chout = d->out.channels();
+    auto &p = d->plan;
+    d->matrix.resize(chin.num, chout.num);
+    int count = 0;
+    p.compressed = false;
+    for (int dch = 0; dch < chout.num; ++dch) {
+        p.first[dch] = count;
+        auto &sources = d->ch_man.sources(chout.speaker[dch]);
+        for (auto spk : sources) {
+            if (count >= (int)p.src.size())
+                break;
+            p.src[count++] = d->ch_index_src[spk];
+            d->matrix.coef(d->ch_index_src[spk], dch) += 1.f;
         }
+        const int n = count - p.first[dch];
+        const auto &info = d->compressInfo[std::min<int>(n, d->compressInfo.size() - 1)];
+        p.c1[dch] = n > 1 ? info.c1 : 0.0;
+        p.c2[dch] = n > 1 ? info.c2 : 1.0;
+        p.k1[dch] = p.c1[dch];
+        p.k2[dch] = p.c2[dch];
+        p.compressed |= n > 1;
     }
+    p.first[chout.num] = count;
+    d->scaledAmp = -1.f;
+}
+
+auto AudioMixer::setKernel(AudioKernel::Isa isa) -> void
+{
+    d->kernel = &AudioKernel::table(isa);
 }
 
 auto AudioMixer::setFormat(const AudioBufferFormat &in, const AudioBufferFormat &out) -> void
@@ -133,29 +145,35 @@ auto AudioMixer::setFormat(const AudioBufferFormat &in, const AudioBufferFormat
     for (int i=0; i<in.channels().num; ++i)
         d->ch_index_src[in.channels().speaker[i]] = i;
     setChannelLayoutMap(d->map);
-
-    const float fps = out.fps();
-    const float f_max = 0.5f * fps;
-    const float w_band = 1; // bandwidth in octave
-    for (int i = 0; i < Bands; ++i) {
-        const float f_center = AudioEqualizer::freqeuncy(i);
-        auto &c = d->coefs[i];
-        if (f_center < f_max) {
-            const float theta = 2.0f * M_PI * f_center / fps;
-            const float alpha = sin(theta) * sinh(log(2.0)*0.5 * w_band * theta/sin(theta));
-            c.a = alpha / (alpha + 1.f);
-            c.b = 2.0 * cos(theta) / (alpha + 1.f);
-            c.c = (alpha - 1.f) / (alpha + 1.f);
-        } else
-            c.a = c.b = c.c = 0.f;
-    }
-    memset(d->xys, 0, sizeof(d->xys));
-    setEqualizer(d->eq);
 }
 
 auto AudioMixer::passthrough(const AudioBufferPtr &/*in*/) const -> bool
 {
-    return false;
+    return !d->mix && d->amp == 1.f;
+}
+
+auto AudioMixer::canRunInPlace(const AudioBufferPtr &in) const -> bool
+{
+    if (!d->mix)
+        return true;
+    return scratch() && in->planes() == 1
+            && d->out.channels().num <= d->in.channels().num;
+}
+
+auto AudioMixer::runInPlace(AudioBuffer &buffer) -> void
+{
+    const int frames = buffer.frames();
+    auto view = buffer.view<float>();
+    if (!d->mix) {
+        process(view.begin(), view.begin(), frames);
+        return;
+    }
+    // downmix into scratch and shrink the buffer
+    const int samples = frames * d->out.channels().num;
+    float *tmp = scratch()->floats(samples);
+    process(tmp, view.begin(), frames);
+    buffer.reinterpret(d->out);
+    memcpy(buffer.data()[0], tmp, samples * sizeof(float));
 }
 
 auto AudioMixer::run(AudioBufferPtr &src) -> AudioBufferPtr
@@ -163,66 +181,67 @@ auto AudioMixer::run(AudioBufferPtr &src) -> AudioBufferPtr
     const int frames = src->frames();
     if (src->isEmpty())
         return newBuffer(d->out, frames);
-    AudioBufferPtr dest;
-    if (d->mix)
-        dest = newBuffer(d->out, frames);
+    if (canRunInPlace(src)) {
+        runInPlace(*src);
+        return src;
+    }
+    auto dest = newBuffer(d->out, frames);
+    process(dest->view<float>().begin(), src->constView<float>().begin(), frames);
+    return dest;
+}
+
+auto AudioMixer::process(float *dst, const float *src, int frames) -> void
+{
+    if (d->kernel->isa == AudioKernel::Isa::Scalar)
+        runScalar(dst, src, frames);
     else
-        dest = src;
-    auto dview = dest->view<float>();
-    auto sview = src->constView<float>();
-    auto clip = d->softClip ? softclip : hardclip;
-    auto equalize = [=] (float v, int ch) {
-        if (!d->eq_zero) {
-            const float x = v;
-            auto &h = d->xys[ch];
-            for(int b = 0; b < Bands; ++b) {
-                const auto &c = d->coefs[b];
-                const float y = c.a * (x - h.x[1])
-                        + c.b * h.y[b][0] + c.c * h.y[b][1];
-                h.y[b][1] = h.y[b][0];
-                h.y[b][0] = y;
-                v += y * c.amp;
-            }
-            h.x[1] = h.x[0];
-            h.x[0] = x;
+        runBlock(dst, src, frames);
+}
+
+auto AudioMixer::runBlock(float *dst, const float *src, int frames) -> void
+{
+    const auto &k = *d->kernel;
+    const int nch = d->out.channels().num;
+    const int samples = frames * nch;
+    if (d->amp < 1e-8) {
+        std::fill(dst, dst + samples, 0);
+        return;
+    }
+    if (!d->mix) {
+        if (dst != src)
+            std::copy(src, src + samples, dst);
+        k.amplify(dst, samples, d->amp);
+    } else {
+        if (_Change(d->scaledAmp, d->amp)) {
+            d->scaled = d->matrix;
+            d->scaled.scale(d->amp);
         }
-        return v;
-    };
+        k.mix(dst, src, frames, d->scaled);
+        if (d->plan.compressed)
+            k.compress(dst, frames, nch, d->plan.k1.data(), d->plan.k2.data());
+    }
+}
 
+auto AudioMixer::runScalar(float *dst, const float *src, int frames) -> void
+{
+    const int nin = d->in.channels().num, nout = d->out.channels().num;
+    const float *end = src + frames * nin;
     if (d->amp < 1e-8)
-        std::fill(dview.begin(), dview.end(), 0);
+        std::fill(dst, dst + frames * nout, 0);
     else if (!d->mix) {
-        auto it = dview.begin();
-        while (it != dview.end()) {
-            for (int ch = 0; ch < src->channels(); ++ch, ++it)
-                *it = clip(equalize(*it * d->amp, ch));
-        }
+        for (; src != end; ++src)
+            *dst++ = *src * d->amp;
     } else {
-        auto dit = dview.begin();
-        for (auto sit = sview.begin(); sit != sview.end(); sit += src->channels()) {
-            for (int dch = 0; dch < dest->channels(); ++dch) {
-                const auto spk = d->out.channels().speaker[dch];
-                auto &map = d->ch_man.sources(spk);
+        const auto &p = d->plan;
+        for (auto sit = src; sit != end; sit += nin) {
+            for (int dch = 0; dch < nout; ++dch) {
                 double v = 0;
-                for (int i=0; i<map.size(); ++i)
-                    v += sit[d->ch_index_src[map[i]]]*d->amp;
-                if (map.size() > 1) {
-                    // ref: http://www.voegler.eu/pub/audio/
-                    //      digital-audio-mixing-and-normalization.html
-                    const auto &info = d->compressInfo[map.size()];
-                    if (v < 0)
-                        v = -log(1.0 - info.c1*v)*info.c2;
-                    else
-                        v = +log(1.0 + info.c1*v)*info.c2;
-                }
-                *dit++ = clip(equalize(v, dch));
+                for (int i = p.first[dch]; i < p.first[dch + 1]; ++i)
+                    v += sit[p.src[i]]*d->amp;
+                if (p.c1[dch] > 0.0)
+                    v = d->compress(v, dch);
+                *dst++ = v;
             }
         }
     }
-    return dest;
-}
-
-auto AudioMixer::setSoftClip(bool soft) -> void
-{
-    d->softClip = soft;
 }
@@ -5,7 +5,8 @@
 #include "channelmanipulation.hpp"
 #include "channellayoutmap.hpp"
 #include "audionormalizeroption.hpp"
-#include "audioequalizer.hpp"
+
+namespace AudioKernel { enum class Isa; }
 
 class AudioMixer : public AudioFilter {
 public:
@@ -13,13 +14,20 @@ public:
     ~AudioMixer();
     auto setFormat(const AudioBufferFormat &in, const AudioBufferFormat &out) -> void;
     auto setAmplifier(float level) -> void;
-    auto setEqualizer(const AudioEqualizer &eq) -> void;
     auto setChannelLayoutMap(const ChannelLayoutMap &map) -> void;
-    auto setSoftClip(bool soft) -> void;
-    auto delay() const -> double override;
+    // Isa::Scalar selects per-sample reference path in double
+    auto setKernel(AudioKernel::Isa isa) -> void;
     auto run(AudioBufferPtr &in) -> AudioBufferPtr override;
     auto passthrough(const AudioBufferPtr &in) const -> bool override;
+    auto canRunInPlace(const AudioBufferPtr &in) const -> bool override;
+    auto runInPlace(AudioBuffer &buffer) -> void override;
 private:
+    // dst may be src if no remix is required
+    auto process(float *dst, const float *src, int frames) -> void;
+    // block path with dispatched kernels
+    auto runBlock(float *dst, const float *src, int frames) -> void;
+    // per-sample reference path
+    auto runScalar(float *dst, const float *src, int frames) -> void;
     struct Data;
     Data *d;
 };
@@ -8,7 +8,10 @@ static const auto jio = JIO(
     JE(smoothing),
     JE(max),
     JE(target),
-    JE(chunk_sec)
+    JE(chunk_sec),
+    JE(use_loudness),
+    JE(target_lufs),
+    JE(lookahead_sec)
 );
 
 JSON_DECLARE_FROM_TO_FUNCTIONS
@@ -29,6 +32,8 @@ AudioNormalizerOptionWidget::AudioNormalizerOptionWidget(QWidget *parent)
     PLUG_CHANGED(d->ui.chunk_sec);
     PLUG_CHANGED(d->ui.max);
     PLUG_CHANGED(d->ui.smoothing);
+    PLUG_CHANGED(d->ui.target_lufs);
+    PLUG_CHANGED(d->ui.lookahead_sec);
 }
 
 AudioNormalizerOptionWidget::~AudioNormalizerOptionWidget()
@@ -40,20 +45,25 @@ auto AudioNormalizerOptionWidget::option() const -> AudioNormalizerOption
 {
     AudioNormalizerOption option;
     option.target = d->ui.target->value();
-    option.use_rms = d->ui.use_rms->currentIndex();
+    option.use_rms = d->ui.use_rms->currentIndex() == 1;
+    option.use_loudness = d->ui.use_rms->currentIndex() == 2;
     option.chunk_sec = d->ui.chunk_sec->value();
     option.max = d->ui.max->value()/100.0;
     option.smoothing = d->ui.smoothing->value();
+    option.target_lufs = d->ui.target_lufs->value();
+    option.lookahead_sec = d->ui.lookahead_sec->value();
     return option;
 }
 
 auto AudioNormalizerOptionWidget::setOption(const AudioNormalizerOption &option) -> void
 {
     d->ui.target->setValue(option.target);
-    d->ui.use_rms->setCurrentIndex(option.use_rms);
+    d->ui.use_rms->setCurrentIndex(option.use_loudness ? 2 : option.use_rms);
     d->ui.chunk_sec->setValue(option.chunk_sec);
     d->ui.max->setValue(option.max * 100.0);
     d->ui.smoothing->setValue(option.smoothing);
+    d->ui.target_lufs->setValue(option.target_lufs);
+    d->ui.lookahead_sec->setValue(option.lookahead_sec);
 }
 
 auto AudioNormalizerOption::default_() -> AudioNormalizerOption
@@ -64,5 +74,8 @@ auto AudioNormalizerOption::default_() -> AudioNormalizerOption
     opt.smoothing = 15;
     opt.max = 10;
     opt.target = 0.95;
+    opt.use_loudness = false;
+    opt.target_lufs = -23.0;
+    opt.lookahead_sec = 3.0;
     return opt;
 }
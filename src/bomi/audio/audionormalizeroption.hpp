@@ -7,12 +7,16 @@ struct AudioDevice {
 };
 
 struct AudioNormalizerOption {
-    DECL_EQ(AudioNormalizerOption, &T::use_rms, &T::smoothing, &T::max, &T::target, &T::chunk_sec)
+    DECL_EQ(AudioNormalizerOption, &T::use_rms, &T::smoothing, &T::max, &T::target,
+            &T::chunk_sec, &T::use_loudness, &T::target_lufs, &T::lookahead_sec)
     auto toJson() const -> QJsonObject;
     auto setFromJson(const QJsonObject &json) -> bool;
     static auto default_() -> AudioNormalizerOption;
     bool use_rms = false; int smoothing = 15;
     double max = 10.0, target = 0.95, chunk_sec = 0.5;
+    // EBU R128 gated loudness instead of peak/rms level
+    bool use_loudness = false;
+    double target_lufs = -23.0, lookahead_sec = 3.0;
 };
 
 class AudioNormalizerOptionWidget : public QWidget {
@@ -0,0 +1,163 @@
+#include "audioprofile.hpp"
+#include "audiobuffer.hpp"
+#include <QElapsedTimer>
+
+// ns between publications of stats
+static constexpr qint64 PublishInterval = 250000000;
+
+struct StageRecord {
+    std::array<qint64, AudioProfile::History> times;
+    int size = 0, pos = 0;
+    quint64 runs = 0, passthroughs = 0, frames = 0, allocations = 0;
+    // for current output buffer
+    qint64 start = 0, ns = 0;
+    quint64 allocStart = 0, allocs = 0;
+    int inFrames = 0;
+    bool ran = false, skipped = false;
+
+    auto push(qint64 ns) -> void
+    {
+        times[pos] = ns;
+        pos = (pos + 1) % AudioProfile::History;
+        size = qMin(size + 1, AudioProfile::History);
+    }
+    auto commit() -> void
+    {
+        if (ran) {
+            push(ns);
+            ++runs;
+            frames += inFrames;
+            allocations += allocs;
+        } else if (skipped)
+            ++passthroughs;
+        ns = 0; allocs = 0; inFrames = 0;
+        ran = skipped = false;
+    }
+    auto clear() -> void
+    {
+        size = pos = 0;
+        runs = passthroughs = frames = allocations = 0;
+    }
+    auto stats() const -> AudioProfile::StageStats
+    {
+        AudioProfile::StageStats s;
+        s.runs = runs;
+        s.passthroughs = passthroughs;
+        if (runs) {
+            s.frames = frames / double(runs);
+            s.allocations = allocations / double(runs);
+        }
+        if (size <= 0)
+            return s;
+        auto sorted = times;
+        std::sort(sorted.begin(), sorted.begin() + size);
+        auto at = [&] (double p) { return sorted[qRound(p * (size - 1))] * 1e-3; };
+        qint64 sum = 0;
+        for (int i = 0; i < size; ++i)
+            sum += sorted[i];
+        s.average = sum * 1e-3 / size;
+        s.p50 = at(0.5);
+        s.p95 = at(0.95);
+        s.p99 = at(0.99);
+        s.max = sorted[size - 1] * 1e-3;
+        return s;
+    }
+};
+
+struct AudioProfile::Data {
+    QElapsedTimer timer;
+    qint64 published = 0;
+    std::array<StageRecord, StageCount> stages;
+    StageRecord total;
+    std::atomic<bool> reset{false};
+    mutable QMutex mutex;
+    Stats stats;
+};
+
+AudioProfile::AudioProfile()
+    : d(new Data)
+{
+    d->timer.start();
+}
+
+AudioProfile::~AudioProfile()
+{
+    delete d;
+}
+
+auto AudioProfile::name(Stage stage) -> QString
+{
+    switch (stage) {
+    case Resampler: return u"resampler"_q;
+    case Analyzer:  return u"analyzer"_q;
+    case Scaler:    return u"scaler"_q;
+    case Mixer:     return u"mixer"_q;
+    case Equalizer: return u"equalizer"_q;
+    case Converter: return u"converter"_q;
+    default:        return QString();
+    }
+}
+
+auto AudioProfile::begin(Stage stage) -> void
+{
+    auto &s = d->stages[stage];
+    s.allocStart = AudioBuffer::allocations();
+    s.start = d->timer.nsecsElapsed();
+}
+
+auto AudioProfile::end(Stage stage, int frames) -> void
+{
+    auto &s = d->stages[stage];
+    s.ns += d->timer.nsecsElapsed() - s.start;
+    s.allocs += AudioBuffer::allocations() - s.allocStart;
+    s.inFrames += frames;
+    s.ran = true;
+}
+
+auto AudioProfile::skip(Stage stage) -> void
+{
+    d->stages[stage].skipped = true;
+}
+
+auto AudioProfile::finish() -> void
+{
+    if (d->reset.exchange(false)) {
+        for (auto &s : d->stages)
+            s.clear();
+        d->total.clear();
+    }
+    for (auto &s : d->stages) {
+        if (s.ran) {
+            d->total.ns += s.ns;
+            d->total.allocs += s.allocs;
+            d->total.inFrames = qMax(d->total.inFrames, s.inFrames);
+            d->total.ran = true;
+        } else if (s.skipped)
+            d->total.skipped = true;
+        s.commit();
+    }
+    d->total.commit();
+    const auto now = d->timer.nsecsElapsed();
+    if (now - d->published < PublishInterval)
+        return;
+    d->published = now;
+    Stats stats;
+    for (int i = 0; i < StageCount; ++i)
+        stats.stages[i] = d->stages[i].stats();
+    stats.total = d->total.stats();
+    QMutexLocker locker(&d->mutex);
+    d->stats = stats;
+}
+
+auto AudioProfile::stats() const -> Stats
+{
+    QMutexLocker locker(&d->mutex);
+    return d->stats;
+}
+
+auto AudioProfile::reset() -> void
+{
+    d->reset = true;
+    QMutexLocker locker(&d->mutex);
+    d->stats = Stats();
+}
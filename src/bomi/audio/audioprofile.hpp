@@ -0,0 +1,48 @@
+#ifndef AUDIOPROFILE_HPP
+#define AUDIOPROFILE_HPP
+
+#include <array>
+
+// cost of each stage of audio filters
+// recorded by audio thread only, which publishes stats a few times per second
+// so that stats() from any thread never contends with every buffer
+class AudioProfile {
+public:
+    static constexpr int History = 256;
+    enum Stage {
+        Resampler, Analyzer, Scaler, Mixer, Equalizer, Converter, StageCount
+    };
+    // times in us per buffer which has been processed by the stage
+    struct StageStats {
+        double average = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+        // frames and allocations per processed buffer
+        double frames = 0, allocations = 0;
+        quint64 runs = 0, passthroughs = 0;
+        auto passthroughRatio() const -> double
+            { const auto n = runs + passthroughs; return n ? passthroughs / double(n) : 0.0; }
+    };
+    struct Stats {
+        std::array<StageStats, StageCount> stages;
+        // all stages of one output buffer
+        StageStats total;
+    };
+    AudioProfile();
+    AudioProfile(const AudioProfile &) = delete;
+    AudioProfile &operator = (const AudioProfile &) = delete;
+    ~AudioProfile();
+    // audio thread: wrap each call into a stage, then finish() for output buffer
+    // a stage may be entered more than once for one output buffer
+    auto begin(Stage stage) -> void;
+    auto end(Stage stage, int frames) -> void;
+    auto skip(Stage stage) -> void;
+    auto finish() -> void;
+    // any thread
+    auto stats() const -> Stats;
+    auto reset() -> void;
+    static auto name(Stage stage) -> QString;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // AUDIOPROFILE_HPP
@@ -8,10 +8,9 @@ extern "C" {
 struct AudioResampler::Data {
     SwrContext *swr = nullptr;
     AudioBufferFormat in, out;
-    int fps = 1;
-    bool resample = false;
+    // dynamic: resampling kernel is running and rate follows scale in place
+    bool resample = false, dynamic = false;
     double delay = 0.0, scale = 1.0;
-    auto updateFps() -> void { fps = lrint(in.fps() * scale); }
 };
 
 AudioResampler::AudioResampler()
@@ -32,14 +31,16 @@ auto AudioResampler::canAccept(int format) -> bool
     return af_to_avformat(format) != AV_SAMPLE_FMT_NONE;
 }
 
+// context is kept and only initialized again with new options
 auto AudioResampler::reconfigure() -> void
 {
-    d->updateFps();
-    if (d->swr)
-        swr_free(&d->swr);
+    d->resample = d->in != d->out || d->scale != 1.0;
     if (!d->resample)
         return;
-    d->swr = swr_alloc();
+    if (!d->swr)
+        d->swr = swr_alloc();
+    // compensation needs the kernel even for same rates, so keep it once used
+    d->dynamic = d->dynamic || d->scale != 1.0;
     const auto nch = d->in.channels().num;
     av_opt_set_int(d->swr,  "in_channel_count", nch, 0);
     av_opt_set_int(d->swr, "out_channel_count", nch, 0);
@@ -47,7 +48,9 @@ auto AudioResampler::reconfigure() -> void
     av_opt_set_int(d->swr, "out_sample_rate", d->out.fps(), 0);
     av_opt_set_sample_fmt(d->swr,  "in_sample_fmt", af_to_avformat(d->in.type()), 0);
     av_opt_set_sample_fmt(d->swr, "out_sample_fmt", af_to_avformat(d->out.type()), 0);
-    reset();
+    av_opt_set_int(d->swr, "flags", d->dynamic ? SWR_FLAG_RESAMPLE : 0, 0);
+    if (swr_init(d->swr) < 0)
+        d->resample = d->dynamic = false;
 }
 
 auto AudioResampler::setFormat(const AudioBufferFormat &in, const AudioBufferFormat &out) -> void
@@ -56,8 +59,7 @@ auto AudioResampler::setFormat(const AudioBufferFormat &in, const AudioBufferFor
     if (!(_Change(d->in, in) | _Change(d->out, out)))
         return;
     Q_ASSERT(d->in.channels().num == d->out.channels().num);
-    d->resample = d->in != d->out;
-
+    d->dynamic = false;
     reconfigure();
 }
 
@@ -79,6 +81,14 @@ auto AudioResampler::run(AudioBufferPtr &in) -> AudioBufferPtr
     const int frames_delay = swr_get_delay(d->swr, d->in.fps());
     int frames = av_rescale_rnd(frames_delay + in->frames(),
                                 d->out.fps(), d->in.fps(), AV_ROUND_UP);
+    if (d->dynamic) {
+        // spread over one second for precision of tiny nudges
+        // distance counts down while converting, so renew it every time
+        const int distance = d->out.fps();
+        const int delta = lrint(distance * (1.0 / d->scale - 1.0));
+        swr_set_compensation(d->swr, delta, delta ? distance : 0);
+        frames = std::ceil(frames / d->scale);
+    }
     auto dst = newBuffer(d->out, frames);
     d->delay = (double)frames/d->in.fps();
     if (frames > 0) {
@@ -91,13 +101,21 @@ auto AudioResampler::run(AudioBufferPtr &in) -> AudioBufferPtr
 
 auto AudioResampler::setScale(double scale) -> void
 {
-    d->scale = scale;
+    if (!_Change(d->scale, scale) || d->dynamic)
+        return;
+    if (d->scale != 1.0)
+        reconfigure();
 }
 
 auto AudioResampler::reset() -> void
 {
-    if (!d->swr)
+    if (!d->resample)
         return;
+    // buffered samples are gone anyway: drop the kernel if not required
+    if (d->dynamic && d->scale == 1.0 && d->in == d->out) {
+        d->resample = d->dynamic = false;
+        return;
+    }
     swr_close(d->swr);
     swr_init(d->swr);
 }
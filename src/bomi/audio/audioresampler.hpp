@@ -9,6 +9,7 @@ public:
     ~AudioResampler();
     auto setFormat(const AudioBufferFormat &in, const AudioBufferFormat &out) -> void;
     auto run(AudioBufferPtr &in) -> AudioBufferPtr override;
+    // applied by compensation without flushing once resampling has started
     auto setScale(double scale) -> void final;
     auto delay() const -> double override;
     auto reset() -> void override;
@@ -1,8 +1,13 @@
 #include "audioscaler.hpp"
+#include "audiokernel.hpp"
 
 static constexpr const double m_ms_stride = 60.0;
 static constexpr const double m_percent_overlap = 0.20;
 static constexpr const double m_ms_search = 14.0;
+static constexpr const double m_ms_stride_low = 20.0;
+static constexpr const double m_ms_search_low = 5.0;
+// step of coarse search in frames, ~0.17ms in 48kHz
+static constexpr const int m_coarse_step = 8;
 
 auto AudioScaler::expand(Vector &vec, int frames) -> void
 {
@@ -26,11 +31,12 @@ auto AudioScaler::setFormat(const AudioBufferFormat &format) -> void
     m_delay = 0.0;
     m_format = format;
     const double frames_per_ms = m_format.fps() / 1000.0;
-    m_frames_stride = frames_per_ms * m_ms_stride;
+    m_frames_stride = frames_per_ms * (m_lowLatency ? m_ms_stride_low : m_ms_stride);
+    m_frames_stride_scaled = m_scale * m_frames_stride;
     expand(m_overlap, qMax<int>(0, m_frames_stride * m_percent_overlap));
     m_frames_search = 0;
     if (m_overlap.frames > 1)
-        m_frames_search = frames_per_ms * m_ms_search;
+        m_frames_search = frames_per_ms * (m_lowLatency ? m_ms_search_low : m_ms_search);
     m_frames_standing = m_frames_stride - m_overlap.frames;
     if (m_overlap.isEmpty())
         return;
@@ -152,8 +158,17 @@ auto AudioScaler::setActive(bool active) -> void
         reset();
 }
 
+auto AudioScaler::setLowLatency(bool on) -> void
+{
+    if (!_Change(m_lowLatency, on) || m_format.fps() <= 0)
+        return;
+    setFormat(m_format);
+}
+
 auto AudioScaler::setScale(double scale) -> void
 {
+    if (m_scale == scale)
+        return;
     m_scale = scale;
     m_frames_stride_scaled = m_scale * m_frames_stride;
     reset();
@@ -170,22 +185,39 @@ auto AudioScaler::best_overlap_frames_offset() -> int
             *cit++ = *wit++ * *oit++;
     }
 
+    const bool coarse = m_searchMode == CoarseToFine
+            || (m_searchMode == Auto && m_scale >= FastSearchScale);
+    const int step = coarse ? m_coarse_step : 1;
     int best_off = 0;
     float best_corr = _Min<qint64>(), corr;
-    for (int off = 0; off < m_frames_search; ++off) {
-        corr = 0;
-        auto cit = _C(m_buf_pre_corr).data();
-        auto qit = _C(m_queue).data() + f2s(1 + off);
-        for (int i = 0; i < samples; ++i)
-            corr += *cit++ * *qit++;
-        if (corr > best_corr) {
+    for (int off = 0; off < m_frames_search; off += step) {
+        if ((corr = correlate(off)) > best_corr) {
             best_corr = corr;
             best_off  = off;
         }
     }
+    if (step > 1) {
+        // refine around coarse peak
+        const int from = qMax(0, best_off - step + 1);
+        const int to = qMin(m_frames_search, best_off + step);
+        const int coarse_off = best_off;
+        for (int off = from; off < to; ++off) {
+            if (off != coarse_off && (corr = correlate(off)) > best_corr) {
+                best_corr = corr;
+                best_off  = off;
+            }
+        }
+    }
     return best_off;
 }
 
+auto AudioScaler::correlate(int off) const -> float
+{
+    return AudioKernel::table().dot(m_buf_pre_corr.data(),
+                                    m_queue.data() + f2s(1 + off),
+                                    f2s(m_overlap.frames - 1));
+}
+
 auto AudioScaler::reset() -> void
 {
     m_frames_stride_error = 0;
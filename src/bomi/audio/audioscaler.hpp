@@ -5,7 +5,14 @@
 
 class AudioScaler : public AudioFilter {
 public:
+    // Auto uses CoarseToFine from FastSearchScale
+    enum SearchMode { Exhaustive, CoarseToFine, Auto };
+    static constexpr double FastSearchScale = 1.5;
+    auto setSearchMode(SearchMode mode) -> void { m_searchMode = mode; }
+    auto searchMode() const -> SearchMode { return m_searchMode; }
     auto setActive(bool active) -> void;
+    // shorter stride and search window for less buffering
+    auto setLowLatency(bool on) -> void;
     auto isActive() const -> bool { return m_enabled && m_scale != 1.0; }
     auto setFormat(const AudioBufferFormat &format) -> void;
     auto delay() const -> double override { return m_delay; }
@@ -24,17 +31,19 @@ private:
     auto f2s(int frames) const -> int { return frames * m_format.channels().num; }
     auto f2b(int frames) const -> int { return f2s(frames) * sizeof(float); }
     auto best_overlap_frames_offset() -> int;
+    auto correlate(int off) const -> float;
     auto copy(float *dst, int to, const float *src, int from, int frames) const -> void;
     auto move(float *dst, int to, int from, int frames) const -> void;
     auto expand(Vector &vec, int frames) -> void;
     AudioBufferFormat m_format;
-    bool m_enabled = false;
+    bool m_enabled = false, m_lowLatency = false;
     double m_frames_stride_scaled = 0.0, m_frames_stride_error = 0.0;
     int m_frames_stride = 0, m_frames_queued = 0;
     int m_frames_search = 0, m_frames_standing = 0, m_frames_to_slide = 0;
     Vector m_table_blend, m_table_window;
     Vector m_buf_pre_corr, m_queue, m_overlap;
     double m_delay = 0.0, m_scale = 1.0;
+    SearchMode m_searchMode = Auto;
 };
 
 #endif // AUDIOSCALER_HPP
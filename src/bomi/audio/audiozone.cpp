@@ -0,0 +1,234 @@
+#include "audiozone.hpp"
+#include "audiomixer.hpp"
+#include "audioconverter.hpp"
+#include "audioresampler.hpp"
+#include "audioequalizerfilter.hpp"
+#include "misc/json.hpp"
+#include "misc/log.hpp"
+extern "C" {
+#include <audio/out/ao.h>
+#include <audio/format.h>
+#include <talloc.h>
+}
+
+DECLARE_LOG_CONTEXT(Audio)
+
+#define JSON_CLASS AudioZoneOption
+static const auto jio = JIO(
+    JE(device),
+    JE(volume),
+    JE(delay),
+    JE(equalizer)
+);
+
+JSON_DECLARE_FROM_TO_FUNCTIONS
+
+/******************************************************************************/
+
+// error of queued time which is resynced at once instead of resampling
+static constexpr double ResyncThreshold = 0.1;
+// drift correction: speed offset per second of error and its bound
+static constexpr double DriftGain = 0.05, MaxDrift = 0.005;
+
+struct AudioZone::Data {
+    mpv_global *global = nullptr;
+    AudioZoneOption option;
+    ChannelLayoutMap map = ChannelLayoutMap::default_();
+    ao *output = nullptr;
+    bool reopen = true;
+    // requested and actual format of output
+    AudioBufferFormat in, out;
+    mp_chmap channels;
+    mp_audio_pool *pool = nullptr;
+    AudioScratch scratch;
+    AudioMixer mixer;
+    AudioEqualizerFilter equalizer;
+    AudioResampler resampler;
+    AudioConverter converter;
+    QVector<AudioFilter*> chain;
+    // converted audio which did not fit in output yet, also delay line
+    std::vector<std::vector<uchar>> pending;
+    int pendingFrames = 0, fstride = 0;
+    // smoothed queued seconds, ao delay is jittery for every call
+    double queued = 0.0;
+    bool primed = false;
+
+    auto close() -> void
+    {
+        if (output)
+            ao_uninit(output);
+        output = nullptr;
+        pending.clear();
+        pendingFrames = 0;
+        primed = false;
+    }
+    auto open() -> void
+    {
+        close();
+        reopen = false;
+        if (option.device.isEmpty() || !in.fps())
+            return;
+        output = ao_init_device(global, option.device.toLocal8Bit().constData(),
+                                in.fps(), AF_FORMAT_FLOAT, channels);
+        if (!output) {
+            _Error("Cannot open audio zone '%%'.", option.device);
+            return;
+        }
+        mp_audio format;
+        ao_get_format(output, &format);
+        out = AudioBufferFormat(&format);
+        const AudioBufferFormat mixed(AF_FORMAT_FLOAT, out.channels(), in.fps());
+        const AudioBufferFormat resampled(AF_FORMAT_FLOAT, out.channels(), out.fps());
+        mixer.setFormat(in, mixed);
+        mixer.setChannelLayoutMap(map);
+        equalizer.setFormat(mixed);
+        equalizer.setEqualizer(option.equalizer);
+        resampler.setFormat(mixed, resampled);
+        converter.setFormat(out);
+        for (auto filter : chain) {
+            filter->reset();
+            filter->setPool(pool);
+            filter->setScratch(&scratch);
+        }
+        fstride = out.mpAudio().sstride;
+        pending.resize(out.planes());
+        _Info("Audio zone '%%' opened: %%Hz, %% channels, %%", option.device,
+              out.fps(), out.channels().num, af_fmt_to_str(out.type()));
+    }
+    auto append(const uchar **data, int frames) -> void
+    {
+        const int bytes = frames * fstride;
+        for (int i = 0; i < (int)pending.size(); ++i) {
+            auto &plane = pending[i];
+            const auto size = plane.size();
+            plane.resize(size + bytes);
+            if (data)
+                memcpy(plane.data() + size, data[i], bytes);
+            else
+                af_fill_silence(plane.data() + size, bytes, out.type());
+        }
+        pendingFrames += frames;
+    }
+    auto drop(int frames) -> void
+    {
+        frames = std::min(frames, pendingFrames);
+        for (auto &plane : pending)
+            plane.erase(plane.begin(), plane.begin() + frames * fstride);
+        pendingFrames -= frames;
+    }
+    auto play() -> void
+    {
+        const int frames = std::min(ao_get_space(output), pendingFrames);
+        if (frames <= 0)
+            return;
+        void *planes[MP_NUM_CHANNELS];
+        for (int i = 0; i < (int)pending.size(); ++i)
+            planes[i] = pending[i].data();
+        drop(ao_play(output, planes, frames, 0));
+    }
+    // returns scale for resampler to keep queued time at target
+    auto control(double target) -> double
+    {
+        const double queued = ao_get_delay(output) + out.toSeconds(pendingFrames);
+        if (!primed) {
+            this->queued = queued;
+            primed = true;
+        } else
+            this->queued += 0.05 * (queued - this->queued);
+        const double error = this->queued - target;
+        if (std::abs(error) < ResyncThreshold) {
+            const auto scale = 1.0 + qBound(-MaxDrift, error * DriftGain, MaxDrift);
+            return qRound(scale * 1e5) * 1e-5;
+        }
+        if (error < 0)
+            append(nullptr, out.secToFrames(-error));
+        else
+            drop(out.secToFrames(error));
+        this->queued = target;
+        return 1.0;
+    }
+};
+
+AudioZone::AudioZone(mpv_global *global, const AudioZoneOption &option)
+    : d(new Data)
+{
+    d->global = global;
+    d->option = option;
+    d->pool = mp_audio_pool_create(nullptr);
+    mp_chmap_from_channels(&d->channels, 2);
+    d->chain << &d->mixer << &d->equalizer << &d->resampler << &d->converter;
+}
+
+AudioZone::~AudioZone()
+{
+    d->close();
+    talloc_free(d->pool);
+    delete d;
+}
+
+auto AudioZone::option() const -> const AudioZoneOption&
+{
+    return d->option;
+}
+
+auto AudioZone::setOption(const AudioZoneOption &option) -> void
+{
+    if (option.device != d->option.device)
+        d->reopen = true;
+    d->option = option;
+    d->equalizer.setEqualizer(option.equalizer);
+}
+
+auto AudioZone::setChannelLayoutMap(const ChannelLayoutMap &map) -> void
+{
+    d->map = map;
+    d->mixer.setChannelLayoutMap(map);
+}
+
+auto AudioZone::setFormat(const AudioBufferFormat &format, const mp_chmap &channels) -> void
+{
+    if (!d->reopen && d->in == format && mp_chmap_equals(&d->channels, &channels))
+        return;
+    d->in = format;
+    d->channels = channels;
+    d->open();
+}
+
+auto AudioZone::isOpen() const -> bool
+{
+    return d->output;
+}
+
+auto AudioZone::feed(const AudioBuffer &buffer, double gain, double mainDelay) -> void
+{
+    if (!d->output || buffer.isEmpty())
+        return;
+    const double target = mainDelay + qBound(0, d->option.delay, 2000) * 1e-3;
+    d->resampler.setScale(d->control(target));
+    d->mixer.setAmplifier(d->option.volume * gain);
+    auto copy = buffer.copy(d->pool);
+    if (!copy)
+        return;
+    for (auto filter : d->chain) {
+        if (filter->passthrough(copy))
+            continue;
+        if (filter->canRunInPlace(copy))
+            filter->runInPlace(*copy);
+        else
+            copy = filter->run(copy);
+    }
+    if (!copy->isEmpty())
+        d->append(copy->constData(), copy->frames());
+    d->play();
+}
+
+auto AudioZone::reset() -> void
+{
+    if (!d->output)
+        return;
+    ao_reset(d->output);
+    d->drop(d->pendingFrames);
+    d->primed = false;
+    for (auto filter : d->chain)
+        filter->reset();
+}
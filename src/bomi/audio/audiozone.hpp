@@ -0,0 +1,51 @@
+#ifndef AUDIOZONE_HPP
+#define AUDIOZONE_HPP
+
+#include "audioequalizer.hpp"
+
+struct mpv_global;                      struct mp_chmap;
+class AudioBuffer;                      class AudioBufferFormat;
+class ChannelLayoutMap;
+
+// extra output device which plays the same audio as main output
+struct AudioZoneOption {
+    DECL_EQ(AudioZoneOption, &T::device, &T::volume, &T::delay, &T::equalizer)
+    auto toJson() const -> QJsonObject;
+    auto setFromJson(const QJsonObject &json) -> bool;
+    // "driver/device" as listed in audio device option
+    QString device;
+    double volume = 1.0;
+    // in ms, added to output latency of main device
+    int delay = 0;
+    AudioEqualizer equalizer;
+};
+
+Q_DECLARE_METATYPE(AudioZoneOption)
+
+// branch of audio filters after tempo scaler with own output
+// everything runs in audio thread and output stays in step with main device:
+// slow drift of device clocks is resampled away, large gaps are resynced
+class AudioZone {
+public:
+    AudioZone(mpv_global *global, const AudioZoneOption &option);
+    AudioZone(const AudioZone &) = delete;
+    AudioZone &operator = (const AudioZone &) = delete;
+    ~AudioZone();
+    auto option() const -> const AudioZoneOption&;
+    // device change takes effect at next setFormat()
+    auto setOption(const AudioZoneOption &option) -> void;
+    auto setChannelLayoutMap(const ChannelLayoutMap &map) -> void;
+    // format of buffers to feed and channels requested from device
+    // device is opened again only if requested format has been changed
+    auto setFormat(const AudioBufferFormat &format, const mp_chmap &channels) -> void;
+    auto isOpen() const -> bool;
+    // output is attenuated additionally with gain, e.g. from normalizer
+    // mainDelay is seconds queued in main output before this buffer
+    auto feed(const AudioBuffer &buffer, double gain, double mainDelay) -> void;
+    auto reset() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // AUDIOZONE_HPP
@@ -0,0 +1,326 @@
+#include "barvisualizeritem.hpp"
+#include "visualizer.hpp"
+#include <QVariantAnimation>
+#include <QVector4D>
+#include <QElapsedTimer>
+#include <QPointer>
+
+// seconds for bar to rise, to fall from top and for peak to fall
+static constexpr float Rise = 0.1f, Fall = 1.0f, Hold = 3.0f;
+// times in vertices are relative to origin, which moves to keep float precision
+static constexpr double Rebase = 600.0;
+
+struct Bar {
+    float from = 0, to = 0, peak = 0;
+    double rise = -1e3, fall = -1e3;
+    // same as vertex shader
+    auto level(double t) const -> float
+    {
+        const float dt = t - rise;
+        if (dt < Rise) {
+            const float r = dt / Rise;
+            return from + (to - from) * r * (2.f - r);
+        }
+        return to * std::max(0.f, 1.f - (dt - Rise) / Fall);
+    }
+    auto peakLevel(double t) const -> float
+    {
+        const float r = std::max(0.f, float(t - fall)) / Hold;
+        return peak * std::max(0.f, 1.f - r * r);
+    }
+};
+
+struct BarData : BarVisualizerItem::ShaderData {
+    float time = 0, height = 1, cap = 1;
+    QVector4D low, mid, high, peak;
+};
+
+struct BarVisualizerItem::SIface : ShaderIface {
+    SIface() {
+        vertexShader = "const float Rise = " + QByteArray::number(Rise, 'f', 3)
+                + "; const float Fall = " + QByteArray::number(Fall, 'f', 3)
+                + "; const float Hold = " + QByteArray::number(Hold, 'f', 3) + ";";
+        vertexShader += R"(
+            uniform mat4 qt_Matrix;
+            uniform float time, height, cap;
+            attribute vec4 aPosition;
+            attribute vec2 aRange, aTimes, aPeak;
+            varying float level, isPeak;
+            void main() {
+                float dt = time - aTimes.x;
+                float bar;
+                if (dt < Rise) {
+                    float r = dt / Rise;
+                    bar = mix(aRange.x, aRange.y, r * (2.0 - r));
+                } else
+                    bar = aRange.y * max(0.0, 1.0 - (dt - Rise) / Fall);
+                float r = max(0.0, time - aTimes.y) / Hold;
+                float peak = max(bar, aPeak.x * max(0.0, 1.0 - r * r));
+                vec4 vtx = aPosition;
+                if (aPeak.y < 0.5)
+                    vtx.y = height * (1.0 - bar * aPosition.y);
+                else
+                    vtx.y = height * (1.0 - peak) - cap * aPosition.y;
+                level = 1.0 - vtx.y / height;
+                isPeak = aPeak.y;
+                gl_Position = qt_Matrix * vtx;
+            }
+        )";
+        fragmentShader = R"(
+            uniform float qt_Opacity;
+            uniform vec4 low, mid, high, peak;
+            varying float level, isPeak;
+            void main() {
+                vec4 bar = level < 0.5 ? mix(low, mid, level * 2.0)
+                                       : mix(mid, high, level * 2.0 - 1.0);
+                gl_FragColor = mix(bar, peak, isPeak) * qt_Opacity;
+            }
+        )";
+        attributes << "aPosition" << "aRange" << "aTimes" << "aPeak";
+    }
+private:
+    auto resolve(QOpenGLShaderProgram *prog) -> void final
+    {
+        loc_time = prog->uniformLocation("time");
+        loc_height = prog->uniformLocation("height");
+        loc_cap = prog->uniformLocation("cap");
+        loc_low = prog->uniformLocation("low");
+        loc_mid = prog->uniformLocation("mid");
+        loc_high = prog->uniformLocation("high");
+        loc_peak = prog->uniformLocation("peak");
+    }
+    auto update(QOpenGLShaderProgram *prog, ShaderData *data) -> void final
+    {
+        auto d = static_cast<const BarData*>(data);
+        prog->setUniformValue(loc_time, d->time);
+        prog->setUniformValue(loc_height, d->height);
+        prog->setUniformValue(loc_cap, d->cap);
+        prog->setUniformValue(loc_low, d->low);
+        prog->setUniformValue(loc_mid, d->mid);
+        prog->setUniformValue(loc_high, d->high);
+        prog->setUniformValue(loc_peak, d->peak);
+    }
+    int loc_time = -1, loc_height = -1, loc_cap = -1;
+    int loc_low = -1, loc_mid = -1, loc_high = -1, loc_peak = -1;
+};
+
+struct BarVisualizerItem::Data {
+    BarVisualizerItem *p = nullptr;
+    QPointer<AudioVisualizer> vis;
+    QVector<Bar> bars;
+    qreal gap = 1;
+    bool running = true;
+    QColor low = Qt::green, mid = Qt::yellow, high = Qt::red, peak = Qt::white;
+    // seconds of animation clock which stops while not running
+    QElapsedTimer clock;
+    double base = 0, origin = 0, until = 0;
+    QVariantAnimation ticker;
+
+    auto now() const -> double
+        { return running ? base + clock.nsecsElapsed() * 1e-9 : base; }
+    auto barWidth() const -> qreal
+    {
+        const int n = bars.size();
+        return n ? std::max(0.0, (p->width() - (n - 1) * gap) / n) : 0.0;
+    }
+    auto resize(int count) -> void
+    {
+        if (bars.size() == count)
+            return;
+        bars.resize(count);
+        p->reserve(UpdateGeometry);
+    }
+    auto animate() -> void
+    {
+        if (running && p->isVisible() && now() < until) {
+            if (ticker.state() != QAbstractAnimation::Running)
+                ticker.start();
+        } else
+            ticker.stop();
+    }
+    static auto premultiplied(const QColor &c) -> QVector4D
+    {
+        const float a = c.alphaF();
+        return { float(c.redF() * a), float(c.greenF() * a), float(c.blueF() * a), a };
+    }
+};
+
+BarVisualizerItem::BarVisualizerItem(QQuickItem *parent)
+    : Super(parent), d(new Data)
+{
+    d->p = this;
+    setFlag(ItemHasContents, true);
+    d->clock.start();
+    d->ticker.setDuration(1000);
+    d->ticker.setLoopCount(-1);
+    d->ticker.setStartValue(0.0);
+    d->ticker.setEndValue(1.0);
+    connect(&d->ticker, &QVariantAnimation::valueChanged, this, [=] () {
+        reserve(UpdateMaterial);
+        if (d->now() >= d->until)
+            d->ticker.stop();
+    });
+}
+
+BarVisualizerItem::~BarVisualizerItem()
+{
+    delete d;
+}
+
+auto BarVisualizerItem::visualizer() const -> AudioVisualizer*
+{
+    return d->vis;
+}
+
+auto BarVisualizerItem::setVisualizer(AudioVisualizer *visualizer) -> void
+{
+    if (d->vis == visualizer)
+        return;
+    if (d->vis)
+        disconnect(d->vis, nullptr, this, nullptr);
+    d->vis = visualizer;
+    if (d->vis) {
+        connect(d->vis, &AudioVisualizer::dataChanged,
+                this, &BarVisualizerItem::updateLevels);
+        connect(d->vis, &AudioVisualizer::countChanged,
+                this, [=] () { d->resize(d->vis->count()); });
+        d->resize(d->vis->count());
+    }
+    emit visualizerChanged();
+}
+
+auto BarVisualizerItem::updateLevels() -> void
+{
+    const auto &levels = d->vis->levels();
+    d->resize(levels.size());
+    const double now = d->now();
+    if (now - d->origin > Rebase)
+        d->origin = now;
+    for (int i = 0; i < levels.size(); ++i) {
+        auto &b = d->bars[i];
+        const float v = levels[i];
+        const float level = b.level(now);
+        if (level < v) {
+            b.from = level;
+            b.to = v;
+            b.rise = now;
+            d->until = std::max(d->until, now + Rise + Fall);
+        }
+        if (b.peakLevel(now) < v) {
+            b.peak = v;
+            b.fall = now + Rise;
+            d->until = std::max(d->until, b.fall + Hold);
+        }
+    }
+    reserve(UpdateAll);
+    d->animate();
+}
+
+auto BarVisualizerItem::gap() const -> qreal
+{
+    return d->gap;
+}
+
+auto BarVisualizerItem::setGap(qreal gap) -> void
+{
+    if (_Change(d->gap, gap)) {
+        reserve(UpdateAll);
+        emit gapChanged();
+    }
+}
+
+auto BarVisualizerItem::isRunning() const -> bool
+{
+    return d->running;
+}
+
+auto BarVisualizerItem::setRunning(bool running) -> void
+{
+    if (d->running == running)
+        return;
+    if (running)
+        d->clock.restart();
+    else
+        d->base = d->now();
+    d->running = running;
+    d->animate();
+    emit runningChanged();
+}
+
+#define DEF_COLOR(get, set, var) \
+auto BarVisualizerItem::get() const -> QColor { return d->var; } \
+auto BarVisualizerItem::set(const QColor &color) -> void \
+{ \
+    if (_Change(d->var, color)) { \
+        reserve(UpdateMaterial); \
+        emit get##Changed(); \
+    } \
+}
+
+DEF_COLOR(lowColor, setLowColor, low)
+DEF_COLOR(midColor, setMidColor, mid)
+DEF_COLOR(highColor, setHighColor, high)
+DEF_COLOR(peakColor, setPeakColor, peak)
+
+#undef DEF_COLOR
+
+auto BarVisualizerItem::itemChange(ItemChange change, const ItemChangeData &data) -> void
+{
+    Super::itemChange(change, data);
+    if (change == ItemVisibleHasChanged)
+        d->animate();
+}
+
+auto BarVisualizerItem::geometryChanged(const QRectF &new_, const QRectF &old) -> void
+{
+    Super::geometryChanged(new_, old);
+    if (new_.size() != old.size())
+        reserve(UpdateAll);
+}
+
+auto BarVisualizerItem::vertexCount() const -> int
+{
+    // two quads of triangles for bar and peak cap
+    return d->bars.size() * 12;
+}
+
+auto BarVisualizerItem::updateVertex(Vertex *vertex) -> void
+{
+    const qreal w = d->barWidth();
+    auto it = vertex;
+    for (int i = 0; i < d->bars.size(); ++i) {
+        const auto &b = d->bars[i];
+        const qreal x = i * (w + d->gap);
+        for (int q = 0; q < 2; ++q) {
+            auto end = OGL::CoordAttr::fillTriangles(it, &Vertex::position,
+                                                     {x, 1.0}, {x + w, 0.0});
+            for (; it != end; ++it) {
+                it->range.set(b.from, b.to);
+                it->times.set(b.rise - d->origin, b.fall - d->origin);
+                it->peak.set(b.peak, q);
+            }
+        }
+    }
+}
+
+auto BarVisualizerItem::createShader() const -> ShaderIface*
+{
+    return new SIface;
+}
+
+auto BarVisualizerItem::createData() const -> ShaderData*
+{
+    return new BarData;
+}
+
+auto BarVisualizerItem::updateData(ShaderData *data) -> void
+{
+    auto bd = static_cast<BarData*>(data);
+    bd->time = d->now() - d->origin;
+    bd->height = std::max(1.0, height());
+    bd->cap = std::floor(qBound(1.0, d->barWidth() * 0.5, 5.0));
+    bd->low = Data::premultiplied(d->low);
+    bd->mid = Data::premultiplied(d->mid);
+    bd->high = Data::premultiplied(d->high);
+    bd->peak = Data::premultiplied(d->peak);
+}
@@ -0,0 +1,84 @@
+#ifndef BARVISUALIZERITEM_HPP
+#define BARVISUALIZERITEM_HPP
+
+#include "quick/opengldrawitem.hpp"
+#include "opengl/openglvertex.hpp"
+
+class AudioVisualizer;
+
+struct BarVertex {
+    // x in px, y is 0 for bottom edge and 1 for top edge
+    OGL::CoordAttr position;
+    // bar rises from x to y, starting at x of times
+    OGL::CoordAttr range;
+    // x: start of rise, y: start of falling peak, in seconds
+    OGL::CoordAttr times;
+    // x: level of peak, y: 0 for bar and 1 for peak cap
+    OGL::CoordAttr peak;
+    static const OGL::AttrInfo &info() {
+        static const OGL::AttrData data[] = {
+            OGL::CoordAttr::data(0, true),
+            OGL::CoordAttr::data(1, false),
+            OGL::CoordAttr::data(2, false),
+            OGL::CoordAttr::data(3, false)
+        };
+        static const OGL::AttrInfo info = { 4, sizeof(BarVertex), data };
+        return info;
+    }
+};
+
+// bars of AudioVisualizer::levels() in one geometry node
+// geometry is rebuilt only when levels arrive,
+// rising and falling of bars and peaks are evaluated in shader with time
+class BarVisualizerItem : public ShaderRenderItem<BarVertex> {
+    Q_OBJECT
+    Q_PROPERTY(AudioVisualizer *visualizer READ visualizer WRITE setVisualizer NOTIFY visualizerChanged)
+    Q_PROPERTY(qreal gap READ gap WRITE setGap NOTIFY gapChanged)
+    Q_PROPERTY(bool running READ isRunning WRITE setRunning NOTIFY runningChanged)
+    Q_PROPERTY(QColor lowColor READ lowColor WRITE setLowColor NOTIFY lowColorChanged)
+    Q_PROPERTY(QColor midColor READ midColor WRITE setMidColor NOTIFY midColorChanged)
+    Q_PROPERTY(QColor highColor READ highColor WRITE setHighColor NOTIFY highColorChanged)
+    Q_PROPERTY(QColor peakColor READ peakColor WRITE setPeakColor NOTIFY peakColorChanged)
+public:
+    BarVisualizerItem(QQuickItem *parent = nullptr);
+    ~BarVisualizerItem();
+    auto visualizer() const -> AudioVisualizer*;
+    auto setVisualizer(AudioVisualizer *visualizer) -> void;
+    auto gap() const -> qreal;
+    auto setGap(qreal gap) -> void;
+    // animation is frozen while not running
+    auto isRunning() const -> bool;
+    auto setRunning(bool running) -> void;
+    auto lowColor() const -> QColor;
+    auto setLowColor(const QColor &color) -> void;
+    auto midColor() const -> QColor;
+    auto setMidColor(const QColor &color) -> void;
+    auto highColor() const -> QColor;
+    auto setHighColor(const QColor &color) -> void;
+    auto peakColor() const -> QColor;
+    auto setPeakColor(const QColor &color) -> void;
+signals:
+    void visualizerChanged();
+    void gapChanged();
+    void runningChanged();
+    void lowColorChanged();
+    void midColorChanged();
+    void highColorChanged();
+    void peakColorChanged();
+private:
+    auto drawingMode() const -> GLenum final { return GL_TRIANGLES; }
+    auto geometryChanged(const QRectF &new_, const QRectF &old) -> void final;
+    auto itemChange(ItemChange change, const ItemChangeData &data) -> void final;
+    auto updateVertex(Vertex *vertex) -> void final;
+    auto vertexCount() const -> int final;
+    auto type() const -> Type* final { static Type t; return &t; }
+    auto createShader() const -> ShaderIface* final;
+    auto createData() const -> ShaderData* final;
+    auto updateData(ShaderData *data) -> void final;
+    auto updateLevels() -> void;
+    struct SIface;
+    struct Data;
+    Data *d;
+};
+
+#endif // BARVISUALIZERITEM_HPP
@@ -0,0 +1,197 @@
+#include "loudnessmeter.hpp"
+#include "audiobuffer.hpp"
+
+// K-weighting filter and gating follow ITU-R BS.1770-4
+// energies are accumulated in 100ms steps; a gating block is 4 steps
+
+static constexpr int StepsPerBlock = 4, StepsPerShortTerm = 30;
+// histogram of block loudness in 0.1 LU bins from the absolute gate to +30 LUFS
+static constexpr int HistogramBins = 1000;
+static constexpr double BinWidth = 0.1;
+
+static auto toLoudness(double energy) -> double
+{
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : LoudnessMeter::Silence;
+}
+
+struct Biquad {
+    double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+};
+
+struct LoudnessMeter::Data {
+    Biquad shelf, highpass;
+    struct Channel { double weight = 1.0, s[4] = {0, 0, 0, 0}; };
+    std::vector<Channel> channels;
+    int stepFrames = 0, frames = 0;
+    double energy = 0.0;
+    // ring of mean energies of the last steps
+    std::array<double, StepsPerShortTerm> steps;
+    int head = 0, filled = 0;
+    std::array<double, HistogramBins> binEnergy;
+    std::array<quint64, HistogramBins> binCount;
+
+    auto clear() -> void
+    {
+        for (auto &c : channels)
+            std::fill_n(c.s, 4, 0.0);
+        frames = 0; energy = 0.0;
+        head = filled = 0;
+        steps.fill(0.0);
+        binEnergy.fill(0.0);
+        binCount.fill(0);
+    }
+    auto window(int count) const -> double
+    {
+        count = std::min(count, filled);
+        if (count <= 0)
+            return 0.0;
+        double sum = 0.0;
+        for (int i = 1; i <= count; ++i)
+            sum += steps[(head - i + StepsPerShortTerm) % StepsPerShortTerm];
+        return sum / count;
+    }
+    auto step() -> void
+    {
+        steps[head] = energy / frames;
+        head = (head + 1) % StepsPerShortTerm;
+        filled = std::min(filled + 1, StepsPerShortTerm);
+        energy = 0.0; frames = 0;
+        if (filled < StepsPerBlock)
+            return;
+        const auto block = window(StepsPerBlock);
+        const auto lufs = toLoudness(block);
+        if (lufs < AbsoluteGate)
+            return;
+        const int bin = std::min<int>((lufs - AbsoluteGate) / BinWidth, HistogramBins - 1);
+        binEnergy[bin] += block;
+        ++binCount[bin];
+    }
+    auto gated(int from) const -> double
+    {
+        double sum = 0.0; quint64 count = 0;
+        for (int i = from; i < HistogramBins; ++i) {
+            sum += binEnergy[i];
+            count += binCount[i];
+        }
+        return count ? sum / count : 0.0;
+    }
+};
+
+LoudnessMeter::LoudnessMeter()
+    : d(new Data)
+{
+    d->clear();
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+    delete d;
+}
+
+auto LoudnessMeter::weights(const mp_chmap &chmap) -> std::vector<double>
+{
+    std::vector<double> weights(chmap.num, 1.0);
+    for (int i = 0; i < chmap.num; ++i) {
+        switch (chmap.speaker[i]) {
+        case MP_SPEAKER_ID_LFE:
+            weights[i] = 0.0;
+            break;
+        case MP_SPEAKER_ID_BL: case MP_SPEAKER_ID_BR:
+        case MP_SPEAKER_ID_SL: case MP_SPEAKER_ID_SR:
+            weights[i] = 1.41;
+            break;
+        default:
+            break;
+        }
+    }
+    return weights;
+}
+
+auto LoudnessMeter::setFormat(int fps, const std::vector<double> &weights) -> void
+{
+    // K-weighting coefficients derived for arbitrary sample rates
+    double f0 = 1681.974450955533, g = 3.999843853973347, q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / fps);
+    const double vh = std::pow(10.0, g / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    d->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    d->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    d->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    d->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    d->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444; q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / fps);
+    a0 = 1.0 + k / q + k * k;
+    d->highpass.b0 = 1.0; d->highpass.b1 = -2.0; d->highpass.b2 = 1.0;
+    d->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    d->highpass.a2 = (1.0 - k / q + k * k) / a0;
+
+    d->channels.resize(weights.size());
+    for (int i = 0; i < (int)weights.size(); ++i)
+        d->channels[i].weight = weights[i];
+    d->stepFrames = std::max(1, fps / 10);
+    d->clear();
+}
+
+auto LoudnessMeter::reset() -> void
+{
+    d->clear();
+}
+
+auto LoudnessMeter::feed(const float *data, int frames) -> void
+{
+    const int nch = d->channels.size();
+    if (!nch || d->stepFrames <= 0)
+        return;
+    const auto &f1 = d->shelf, &f2 = d->highpass;
+    while (frames > 0) {
+        const int count = std::min(frames, d->stepFrames - d->frames);
+        for (int c = 0; c < nch; ++c) {
+            auto &ch = d->channels[c];
+            if (ch.weight == 0.0)
+                continue;
+            // two cascaded biquads in transposed direct form II
+            double s0 = ch.s[0], s1 = ch.s[1], s2 = ch.s[2], s3 = ch.s[3], sum = 0.0;
+            const float *p = data + c;
+            for (int i = 0; i < count; ++i, p += nch) {
+                const double x = *p;
+                const double y = f1.b0 * x + s0;
+                s0 = f1.b1 * x - f1.a1 * y + s1;
+                s1 = f1.b2 * x - f1.a2 * y;
+                const double z = f2.b0 * y + s2;
+                s2 = f2.b1 * y - f2.a1 * z + s3;
+                s3 = f2.b2 * y - f2.a2 * z;
+                sum += z * z;
+            }
+            ch.s[0] = s0; ch.s[1] = s1; ch.s[2] = s2; ch.s[3] = s3;
+            d->energy += ch.weight * sum;
+        }
+        data += count * nch;
+        frames -= count;
+        if ((d->frames += count) >= d->stepFrames)
+            d->step();
+    }
+}
+
+auto LoudnessMeter::momentary() const -> double
+{
+    return toLoudness(d->window(StepsPerBlock));
+}
+
+auto LoudnessMeter::shortTerm() const -> double
+{
+    return toLoudness(d->window(StepsPerShortTerm));
+}
+
+auto LoudnessMeter::integrated() const -> double
+{
+    const auto absolute = d->gated(0);
+    if (absolute <= 0.0)
+        return Silence;
+    const auto threshold = toLoudness(absolute) + RelativeGate;
+    const int from = qBound<int>(0, std::ceil((threshold - AbsoluteGate) / BinWidth),
+                                 HistogramBins - 1);
+    return toLoudness(d->gated(from));
+}
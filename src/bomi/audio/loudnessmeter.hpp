@@ -0,0 +1,33 @@
+#ifndef LOUDNESSMETER_HPP
+#define LOUDNESSMETER_HPP
+
+// ITU-R BS.1770 / EBU R128 loudness meter
+// all history is kept in fixed-size storage so that feeding never allocates
+
+struct mp_chmap;
+
+class LoudnessMeter {
+public:
+    // loudness of silence or of nothing measured yet
+    static constexpr double Silence = -std::numeric_limits<double>::infinity();
+    static constexpr double AbsoluteGate = -70.0, RelativeGate = -10.0;
+    LoudnessMeter();
+    ~LoudnessMeter();
+    // weights are BS.1770 channel weights, 0 for LFE
+    auto setFormat(int fps, const std::vector<double> &weights) -> void;
+    auto reset() -> void;
+    // interleaved float samples
+    auto feed(const float *data, int frames) -> void;
+    // 400ms sliding window in LUFS
+    auto momentary() const -> double;
+    // 3s sliding window in LUFS
+    auto shortTerm() const -> double;
+    // gated loudness of everything since reset() in LUFS
+    auto integrated() const -> double;
+    static auto weights(const mp_chmap &chmap) -> std::vector<double>;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // LOUDNESSMETER_HPP
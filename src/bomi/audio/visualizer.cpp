@@ -1,48 +1,97 @@
 #include "visualizer.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "audiobuffer.hpp"
+#include "os/os.hpp"
+#include "tmp/ring.hpp"
 #include "kiss_fft/tools/kiss_fftr.h"
-#include <complex>
+#include <array>
+#include <atomic>
+#include <map>
 
 static const QEvent::Type UpdateData = QEvent::Type(QEvent::User + 1);
 
+// frames of mix and channels from af thread to worker thread
+using SampleRing = tmp::SpscRing<float>;
+
+// signals in each frame of ring: mix and then every channel
+static constexpr int MaxChannels = 8;
+static constexpr int Signals = 1 + MaxChannels;
+
+// real transforms of many signals with one plan
+// kiss_fft_scalar packs Lanes floats with USE_SIMD, so that each pass
+// transforms that many signals for about cost of one
 class FFT {
 public:
+    static constexpr int Lanes = sizeof(kiss_fft_scalar) / sizeof(float);
+    static constexpr int Passes = (Signals + Lanes - 1) / Lanes;
+    // frames taken from ring at once
+    static constexpr int Chunk = 256;
     FFT() { setInputSize(10); }
     ~FFT() { kiss_fftr_free(m_kiss); }
-    auto push(const AudioBufferPtr &input) -> bool
+    // average every m_decimation frames as a cheap low-pass
+    auto push(SampleRing &ring) -> bool
     {
-        if (m_pos < m_size_in) {
-            if (!input || input->isEmpty())
-                return false;
-            m_nq = input->fps() / 2;
-            auto view = input->constView<float>();
-            const float *p = view.plane();
-            const int frames = input->frames();
-            const int nch = input->channels();
-            auto dst = m_input.data() + m_pos;
-            for (int i = 0; i < frames && m_pos < m_size_in; ++i, ++m_pos) {
-                float mix = 0;
-                for (int c = 0; c < nch; ++c) {
-                    mix += *p++;
+        while (m_pos < m_size_in) {
+            const int frames = qMin(m_size_in - m_pos, int(Chunk)) * m_decimation;
+            const int got = ring.pop(m_block.data() + m_filled * Signals,
+                                     (frames - m_filled) * Signals) / Signals;
+            m_filled += got;
+            const int groups = m_filled / m_decimation;
+            for (int g = 0; g < groups; ++g, ++m_pos) {
+                const float *frame = m_block.data() + g * m_decimation * Signals;
+                for (int s = 0; s < Signals; ++s) {
+                    float sum = 0.f;
+                    for (int i = 0; i < m_decimation; ++i)
+                        sum += frame[i * Signals + s];
+                    input(s)[m_pos * Lanes] = sum / m_decimation;
                 }
-                mix /= nch;
-                *dst++ = mix;
             }
+            const int rest = m_filled - groups * m_decimation;
+            std::copy_n(m_block.data() + groups * m_decimation * Signals,
+                        rest * Signals, m_block.data());
+            m_filled = rest;
+            if (!got)
+                break;
         }
         return m_pos >= m_size_in;
     }
-    auto run() -> void { kiss_fftr(m_kiss, m_input.data(), (kiss_fft_cpx*)m_output.data()); clear(); }
-    auto output() -> const std::vector<std::complex<float>>& { return m_output; }
+    auto decimation() const -> int { return m_decimation; }
+    auto setDecimation(int factor) -> void
+    {
+        m_decimation = qMax(1, factor);
+        m_block.resize(Chunk * m_decimation * Signals);
+        m_filled = 0;
+    }
+    // only passes which hold first signals
+    auto run(int signals) -> void
+    {
+        for (int i = 0; i < (signals + Lanes - 1) / Lanes; ++i)
+            kiss_fftr(m_kiss, m_input[i].data(), m_output[i].data());
+        clear();
+    }
+    auto bins() const -> int { return m_size_in / 2 + 1; }
+    auto magnitude(int signal, int bin) const -> float
+    {
+        const auto &c = m_output[signal / Lanes][bin];
+        const float r = reinterpret_cast<const float*>(&c.r)[signal % Lanes];
+        const float i = reinterpret_cast<const float*>(&c.i)[signal % Lanes];
+        return std::sqrt(r * r + i * i);
+    }
+    // samples of last transform with stride of Lanes
+    auto samples(int signal) const -> const float*
+    {
+        return reinterpret_cast<const float*>(m_input[signal / Lanes].data()) + signal % Lanes;
+    }
     auto inputSize() const -> int { return m_size_in; }
     auto setInputSize(int size) -> void
     {
-        static_assert(sizeof(std::complex<float>) == sizeof(kiss_fft_cpx), "!!!");
         size = kiss_fftr_next_fast_size_real(size);
-        if (size != (int)m_input.size()) {
-            m_input.resize(size);
+        if (size != m_size_in) {
             m_size_in = size;
-            m_output.resize(m_size_in / 2 + 1);
+            for (int i = 0; i < Passes; ++i) {
+                m_input[i].assign(size, kiss_fft_scalar());
+                m_output[i].resize(bins());
+            }
             kiss_fftr_free(m_kiss);
             m_kiss = kiss_fftr_alloc(m_size_in, false, nullptr, nullptr);
         }
@@ -50,112 +99,264 @@ public:
     }
     auto clear() -> void { m_pos = 0; }
 private:
+    auto input(int signal) -> float*
+        { return reinterpret_cast<float*>(m_input[signal / Lanes].data()) + signal % Lanes; }
     kiss_fftr_cfg m_kiss = nullptr;
-    int m_size_in = 0, m_pos = 0;
-    double m_nq = 20000;
-    std::vector<float> m_input;
-    std::vector<std::complex<float>> m_output;
+    int m_size_in = 0, m_pos = 0, m_decimation = 1, m_filled = 0;
+    std::vector<float> m_block;
+    std::array<std::vector<kiss_fft_scalar>, Passes> m_input;
+    std::array<std::vector<kiss_fft_cpx>, Passes> m_output;
 };
 
 /******************************************************************************/
 
+// sparse weights of fft magnitudes for each bar
+struct BarMap {
+    struct Tap { int bin; float weight; };
+    DECL_EQ(BarMap, &T::count, &T::min, &T::max, &T::xs, &T::bins, &T::nq)
+    int count = 0, bins = 0;
+    qreal min = 0, max = 0, nq = 0;
+    AudioVisualizer::Scale xs = AudioVisualizer::Log;
+    std::vector<Tap> taps;
+    std::vector<int> offsets;
+    auto build() -> void;
+};
+
+// merge gaussian gather of linear interpolation into one tap list per bar
+auto BarMap::build() -> void
+{
+    constexpr int radius = 3;
+    static const auto gw = Gaussian::create(radius);
+    taps.clear();
+    offsets.assign(1, 0);
+    std::map<int, float> weights;
+    for (int i = 0; i < count; ++i) {
+        const auto r = count > 1 ? double(i) / (count - 1) : 0.0;
+        const auto f = xs != AudioVisualizer::Log ? min + (max - min) * r
+            : std::exp(std::log(min) + (std::log(max) - std::log(min)) * r);
+        const double idx = f * (bins - 1) / nq;
+        weights.clear();
+        for (int j = -radius, g = 0; j <= radius; ++j, ++g) {
+            const double x = idx + j;
+            const int left = x, right = left + 1;
+            if (left < 0 || right >= bins)
+                continue;
+            const float a = x - (double)left;
+            weights[left] += gw[g] * (1.0f - a);
+            weights[right] += gw[g] * a;
+        }
+        for (auto &w : weights)
+            taps.push_back({ w.first, w.second });
+        offsets.push_back(taps.size());
+    }
+}
+
+class VisualizerThread : public QThread {
+public:
+    VisualizerThread(AudioVisualizer *vis): m_vis(vis) { }
+    auto setInterval(int ms) -> void { m_interval = ms; }
+    auto finish() -> void { m_quit = true; wait(); m_quit = false; }
+private:
+    auto run() -> void final;
+    AudioVisualizer *m_vis = nullptr;
+    std::atomic<bool> m_quit{false};
+    std::atomic<int> m_interval{16};
+};
+
 struct AudioVisualizer::Data {
-    QList<qreal> data, interm, back;
+    QVector<float> data, interm, back;
+    QVector<float> chData, chInterm, chBack;
+    float corr = 0.f, corrInterm = 0.f, corrBack = 0.f;
+    bool perChannel = false;
     qreal min = 20, max = 20000;
     bool active = false, enabled = false;
     int fps = 0, count = 0;
     double minLv = _Max<double>(), maxLv = 0;
     Type type = None;
+    // guards data between worker and gui thread
+    // also count, min, max and scales which gui writes and worker copies
     QMutex mutex;
     FFT fft;
     AudioVisualizer::Scale xs = AudioVisualizer::Log;
     AudioVisualizer::Scale ys = AudioVisualizer::Log, tys = ys;
+    // written by af thread
+    SampleRing ring{19};
+    BarMap map;
+    std::vector<float> mags;
+    std::atomic<int> srcFps{0}, srcChannels{0};
+    std::atomic<bool> perChannelAf{false};
+    std::atomic<bool> enabledAf{false}, resetLv{true}, pending{false};
+    VisualizerThread *thread = nullptr;
+    template<class T>
+    auto set(T &member, const T &value) -> bool
+        { QMutexLocker locker(&mutex); return _Change(member, value); }
 };
 
+auto VisualizerThread::run() -> void
+{
+    while (!m_quit) {
+        msleep(m_interval);
+        m_vis->process();
+    }
+}
+
 AudioVisualizer::AudioVisualizer(QObject *item)
     : QObject(item), d(new Data)
 {
+    d->thread = new VisualizerThread(this);
     setCount(5);
 }
 
 AudioVisualizer::~AudioVisualizer()
 {
+    d->thread->finish();
+    delete d->thread;
     delete d;
 }
 
 auto AudioVisualizer::reset() -> void
 {
-    d->maxLv = 0.0;
-    d->minLv = _Max<double>();
+    d->resetLv = true;
 }
 
-//        function i2f(i, fps, n) { return i * fps * 0.5 / (n - 1); }
+// in af thread: only copy into ring so that it never blocks
 auto AudioVisualizer::analyze(const QSharedPointer<AudioBuffer> &data) -> void
 {
-    if (!d->enabled)
+    if (!d->enabledAf.load(std::memory_order_relaxed))
         return;
     Q_ASSERT(data);
-    if (_Change(d->fps, data->fps()))
-        d->fft.setInputSize(d->fps * 0.1);
-    if (!d->fft.push(data))
+    if (data->isEmpty())
+        return;
+    d->srcFps.store(data->fps(), std::memory_order_relaxed);
+    const int nch = data->channels();
+    d->srcChannels.store(nch, std::memory_order_relaxed);
+    auto view = data->constView<float>();
+    const float *p = view.plane(), *frame = p;
+    const int used = d->perChannelAf.load(std::memory_order_relaxed)
+                     ? qMin(nch, MaxChannels) : 0;
+    const float div = 1.f / nch;
+    // whole frames only, so that each pop of worker ends at frame
+    d->ring.push(data->frames() * Signals, [&] (int i) {
+        const int s = i % Signals;
+        if (s)
+            return s <= used ? frame[s - 1] : 0.f;
+        frame = p;
+        float mix = 0;
+        for (int c = 0; c < nch; ++c)
+            mix += *p++;
+        return mix * div;
+    });
+}
+
+//        function i2f(i, fps, n) { return i * fps * 0.5 / (n - 1); }
+auto AudioVisualizer::process() -> void
+{
+    const int fps = d->srcFps.load(std::memory_order_relaxed);
+    if (fps <= 0)
+        return;
+    if (_Change(d->fps, fps)) {
+        // no need for fft over 48kHz: nyquist frequency is beyond hearing
+        int decimation = 1;
+        while (fps / (decimation + 1) >= 48000)
+            ++decimation;
+        d->fft.setDecimation(decimation);
+        d->fft.setInputSize(d->fps * 0.1 / decimation);
+    }
+    if (d->resetLv.exchange(false)) {
+        d->maxLv = 0.0;
+        d->minLv = _Max<double>();
+    }
+    if (!d->fft.push(d->ring))
         return;
-    d->fft.run();
-    auto &cpx = d->fft.output();
+    const int channels = d->perChannelAf.load(std::memory_order_relaxed)
+            ? qMin(d->srcChannels.load(std::memory_order_relaxed), MaxChannels) : 0;
+    d->fft.run(1 + channels);
+    const int bins = d->fft.bins();
 
+    d->mutex.lock();
     const int c = d->count;
-    if (d->back.size() != c) {
-        d->back.clear(); d->back.reserve(c);
-        for (int i = 0; i < c; ++i)
-            d->back.push_back(0.0);
+    const qreal lo = d->min, hi = d->max;
+    const auto xs = d->xs, ys = d->ys;
+    d->mutex.unlock();
+
+    BarMap key;
+    key.count = c; key.min = lo; key.max = hi; key.xs = xs;
+    key.bins = bins; key.nq = d->fps * 0.5 / d->fft.decimation();
+    if (d->map != key) {
+        d->map.count = key.count; d->map.min = key.min; d->map.max = key.max;
+        d->map.xs = key.xs; d->map.bins = key.bins; d->map.nq = key.nq;
+        d->map.build();
     }
-    const auto nq = d->fps * 0.5;
-    auto get = [&] (double i) -> double {
-        const int left = i;
-        const int right = left + 1;
-        if (left < 0 || right >= (int)cpx.size())
-            return 0.0;
-        const float a = i - (double)left;
-        return std::abs(cpx.at(left)) * (1.0f - a) + a * std::abs(cpx.at(right));
-    };
 
-    constexpr int radius = 3;
-    static const auto gw = Gaussian::create(radius);
+    if (d->back.size() != c)
+        d->back.fill(0.f, c);
+    if (d->chBack.size() != c * channels)
+        d->chBack.fill(0.f, c * channels);
+    d->mags.resize(bins);
 
-    if (_Change(d->tys, d->ys))
-        reset();
+    if (_Change(d->tys, ys)) {
+        d->maxLv = 0.0;
+        d->minLv = _Max<double>();
+    }
 
     double &min = d->minLv, &max = d->maxLv;
-    for (int i = 0; i < c; ++i) {
-        const auto f = d->xs != Log ? d->min + (d->max - d->min) * i / (c - 1)
-            : std::exp(std::log(d->min) + (std::log(d->max) - std::log(d->min)) * i / (c - 1));
-        const double idx = f * (cpx.size() - 1) / nq;
-        double lv = 0.0;
-        int g = 0;
-        for (int j = -radius; j <= radius; ++j, ++g)
-            lv += get(idx + j) * gw[g];
-        if (lv < 1e-4)
-            lv = 0.0;
-        else {
-            if (d->tys == Log)
-                lv = std::log(lv);
-            min = std::min(lv, min);
-            max = std::max(lv, max);
+    // levels of all signals share one range to be compared
+    auto bars = [&] (int signal, float *out) {
+        for (int i = 0; i < bins; ++i)
+            d->mags[i] = d->fft.magnitude(signal, i);
+        for (int i = 0; i < c; ++i) {
+            double lv = 0.0;
+            for (int t = d->map.offsets[i]; t < d->map.offsets[i + 1]; ++t)
+                lv += d->mags[d->map.taps[t].bin] * d->map.taps[t].weight;
+            if (lv < 1e-4)
+                lv = 0.0;
+            else {
+                if (d->tys == Log)
+                    lv = std::log(lv);
+                min = std::min(lv, min);
+                max = std::max(lv, max);
+            }
+            out[i] = lv;
         }
-        d->back[i] = lv;
-    }
+    };
+    bars(0, d->back.data());
+    for (int ch = 0; ch < channels; ++ch)
+        bars(1 + ch, d->chBack.data() + ch * c);
     if (d->tys != Log)
         min = 0;
     if (min != max) {
-        for (auto &v : d->back) {
-            if (v != 0.0)
-                v = (v - min) / (max - min);
-        }
+        auto normalize = [&] (QVector<float> &levels) {
+            for (auto &v : levels) {
+                if (v != 0.0)
+                    v = qBound(0.0, (v - min) / (max - min), 1.0);
+            }
+        };
+        normalize(d->back);
+        normalize(d->chBack);
     }
 
+    d->corrBack = 0.f;
+    if (channels >= 2) {
+        const float *l = d->fft.samples(1), *r = d->fft.samples(2);
+        double lr = 0, ll = 0, rr = 0;
+        for (int i = 0; i < d->fft.inputSize(); ++i, l += FFT::Lanes, r += FFT::Lanes) {
+            lr += *l * *r;
+            ll += *l * *l;
+            rr += *r * *r;
+        }
+        if (ll > 1e-12 && rr > 1e-12)
+            d->corrBack = lr / std::sqrt(ll * rr);
+    } else if (channels == 1)
+        d->corrBack = 1.f;
+
     d->mutex.lock();
     d->back.swap(d->interm);
+    d->chBack.swap(d->chInterm);
+    std::swap(d->corrBack, d->corrInterm);
     d->mutex.unlock();
-    qApp->postEvent(this, new QEvent(UpdateData));
+    // at most one update waits in gui event loop
+    if (!d->pending.exchange(true))
+        qApp->postEvent(this, new QEvent(UpdateData));
 }
 
 auto AudioVisualizer::min() const -> qreal
@@ -170,13 +371,13 @@ auto AudioVisualizer::max() const -> qreal
 
 auto AudioVisualizer::setMin(qreal min) -> void
 {
-    if (_Change(d->min, min))
+    if (d->set(d->min, min))
         emit minChanged();
 }
 
 auto AudioVisualizer::setMax(qreal max) -> void
 {
-    if (_Change(d->max, max))
+    if (d->set(d->max, max))
         emit maxChanged();
 }
 
@@ -187,14 +388,28 @@ auto AudioVisualizer::count() const -> int
 
 auto AudioVisualizer::setCount(int count) -> void
 {
-    if (_Change(d->count, count))
+    if (d->set(d->count, count))
         emit countChanged();
 }
 
 auto AudioVisualizer::setEnabled(bool enabled) -> void
 {
-    if (_Change(d->enabled, enabled))
-        emit enabledChanged();
+    if (!_Change(d->enabled, enabled))
+        return;
+    d->enabledAf = enabled;
+    if (enabled) {
+        // update in display refresh rate
+        setRefreshRate(OS::refreshRate());
+        d->ring.clear();
+        d->thread->start();
+    } else
+        d->thread->finish();
+    emit enabledChanged();
+}
+
+auto AudioVisualizer::setRefreshRate(qreal hz) -> void
+{
+    d->thread->setInterval(hz > 1.0 ? qMax(1, qRound(1000.0 / hz)) : 16);
 }
 
 auto AudioVisualizer::isEnabled() const -> bool
@@ -203,10 +418,56 @@ auto AudioVisualizer::isEnabled() const -> bool
 }
 
 auto AudioVisualizer::data() const -> QList<qreal>
+{
+    QList<qreal> data;
+    data.reserve(d->data.size());
+    for (auto v : d->data)
+        data.push_back(v);
+    return data;
+}
+
+auto AudioVisualizer::levels() const -> const QVector<float>&
 {
     return d->data;
 }
 
+auto AudioVisualizer::isPerChannel() const -> bool
+{
+    return d->perChannel;
+}
+
+auto AudioVisualizer::setPerChannel(bool on) -> void
+{
+    if (!_Change(d->perChannel, on))
+        return;
+    d->perChannelAf = on;
+    emit perChannelChanged();
+}
+
+auto AudioVisualizer::channels() const -> QVariantList
+{
+    QVariantList channels;
+    const int c = d->count;
+    for (int i = 0; c > 0 && i + c <= d->chData.size(); i += c) {
+        QVariantList levels;
+        levels.reserve(c);
+        for (int j = 0; j < c; ++j)
+            levels.push_back(d->chData[i + j]);
+        channels.push_back(levels);
+    }
+    return channels;
+}
+
+auto AudioVisualizer::channelLevels() const -> const QVector<float>&
+{
+    return d->chData;
+}
+
+auto AudioVisualizer::correlation() const -> qreal
+{
+    return d->corr;
+}
+
 auto AudioVisualizer::isActive() const -> bool
 {
     return d->active;
@@ -223,8 +484,11 @@ auto AudioVisualizer::setActive(bool active) -> void
 auto AudioVisualizer::customEvent(QEvent *e) -> void
 {
     if (e->type() == UpdateData) {
+        d->pending = false;
         d->mutex.lock();
         d->data.swap(d->interm);
+        d->chData.swap(d->chInterm);
+        std::swap(d->corr, d->corrInterm);
         d->mutex.unlock();
         emit dataChanged();
     }
@@ -232,7 +496,7 @@ auto AudioVisualizer::customEvent(QEvent *e) -> void
 
 auto AudioVisualizer::setXScale(Scale scale) -> void
 {
-    if (_Change(d->xs, scale))
+    if (d->set(d->xs, scale))
         emit xScaleChanged();
 }
 
@@ -243,7 +507,7 @@ auto AudioVisualizer::xScale() const -> Scale
 
 auto AudioVisualizer::setYScale(Scale scale) -> void
 {
-    if (_Change(d->ys, scale))
+    if (d->set(d->ys, scale))
         emit yScaleChanged();
 }
 
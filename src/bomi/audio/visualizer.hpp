@@ -4,7 +4,7 @@
 #include "quick/simpletextureitem.hpp"
 #include "enum/visualization.hpp"
 
-class AudioBuffer;
+class AudioBuffer;                      class VisualizerThread;
 
 class AudioVisualizer : public QObject {
     Q_OBJECT
@@ -17,6 +17,9 @@ class AudioVisualizer : public QObject {
     Q_PROPERTY(Scale xScale READ xScale WRITE setXScale NOTIFY xScaleChanged)
     Q_PROPERTY(Scale yScale READ yScale WRITE setYScale NOTIFY yScaleChanged)
     Q_PROPERTY(Type type READ type NOTIFY typeChanged)
+    Q_PROPERTY(bool perChannel READ isPerChannel WRITE setPerChannel NOTIFY perChannelChanged)
+    Q_PROPERTY(QVariantList channels READ channels NOTIFY dataChanged)
+    Q_PROPERTY(qreal correlation READ correlation NOTIFY dataChanged)
     Q_ENUMS(Scale)
     Q_ENUMS(Type)
 public:
@@ -28,6 +31,18 @@ public:
     AudioVisualizer(QObject *parent = nullptr);
     ~AudioVisualizer();
     auto data() const -> QList<qreal>;
+    // levels of bars in [0, 1] for gui thread, valid until next dataChanged()
+    auto levels() const -> const QVector<float>&;
+    // spectrum of each channel too, in the same scale as mix
+    auto isPerChannel() const -> bool;
+    auto setPerChannel(bool on) -> void;
+    // list of levels for each channel in order of source
+    auto channels() const -> QVariantList;
+    // count levels of each channel in a row, empty unless per channel
+    auto channelLevels() const -> const QVector<float>&;
+    // of first two channels in [-1, 1]: 1 for mono, 0 for unrelated,
+    // -1 for opposite phase
+    auto correlation() const -> qreal;
     auto count() const -> int;
     auto setCount(int count) -> void;
     auto min() const -> qreal;
@@ -43,7 +58,9 @@ public:
     auto setYScale(Scale scale) -> void;
     auto setType(Visualization type) -> void;
     auto type() const -> Type;
-    // in af thread
+    // updates follow display refresh
+    auto setRefreshRate(qreal hz) -> void;
+    // in af thread, never blocks
     auto analyze(const QSharedPointer<AudioBuffer> &data) -> void;
     auto reset() -> void;
 signals:
@@ -57,11 +74,15 @@ signals:
     void xScaleChanged();
     void yScaleChanged();
     void typeChanged();
+    void perChannelChanged();
 private:
+    // in worker thread
+    auto process() -> void;
     auto setEnabled(bool enabled) -> void;
     auto customEvent(QEvent *e) -> void final;
     struct Data;
     Data *d;
+    friend class VisualizerThread;
 };
 
 Q_DECLARE_METATYPE(AudioVisualizer::Scale)
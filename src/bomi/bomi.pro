@@ -15,6 +15,7 @@ include(configure.pro)
 !isEmpty(BOMI_RELEASE) {
 	CONFIG -= debug
     CONFIG += release
+    DEFINES += BOMI_NO_TRACE_LOG
     macx:CONFIG += app_bundle
 }
 
@@ -165,6 +166,7 @@ HEADERS += \
 	enum/visualization.hpp \
 	misc/charsetdetector.hpp \
 	misc/downloader.hpp \
+	misc/downloadserver.hpp \
 	misc/actiongroup.hpp \
 	misc/dataevent.hpp \
 	misc/xmlrpcclient.hpp \
@@ -188,11 +190,13 @@ HEADERS += \
 	player/mediamisc.hpp \
 	player/playengine.hpp \
 	player/mainwindow.hpp \
+	player/headlesswindow.hpp \
 	player/translator.hpp \
 	player/recentinfo.hpp \
 	player/mpv_helper.hpp \
 	player/playengine_p.hpp \
 	player/historymodel.hpp \
+	player/medialibrary.hpp \
 	player/playlistmodel.hpp \
     audio/channellayoutmap.hpp \
     player/openmediainfo.hpp \
@@ -211,6 +215,7 @@ HEADERS += \
     player/abrepeatchecker.hpp \
     widget/openmediabehaviorgroupbox.hpp \
     tmp/static_op.hpp \
+    tmp/ring.hpp \
 	pref/prefdialog_p.hpp \
     opengl/openglbenchmarker.hpp \
     enum/colorspace.hpp \
@@ -244,6 +249,7 @@ HEADERS += \
     audio/audioequalizer.hpp \
 	dialog/audioequalizerdialog.hpp \
     quick/circularimageitem.hpp \
+    quick/svgimageprovider.hpp \
     quick/maskareaitem.hpp \
 	quick/windowobject.hpp \
     misc/autoloader.hpp \
@@ -293,15 +299,54 @@ HEADERS += \
     misc/windowsize.hpp \
     enum/framebufferobjectformat.hpp \
     video/videopreview.hpp \
+    video/streamitem.hpp \
     dialog/fileassocdialog.hpp \
     quick/triangleitem.hpp \
+    quick/infosubscriber.hpp \
+    quick/bluritem.hpp \
     audio/visualizer.hpp \
+    audio/barvisualizeritem.hpp \
     kiss_fft/tools/kiss_fftr.h \
     kiss_fft/kiss_fft.h \
     dialog/encoderdialog.hpp \
     misc/filenamegenerator.hpp \
     enum/rotation.hpp \
-    player/videosettings.hpp
+    player/videosettings.hpp \
+    audio/audiokernel.hpp \
+    audio/audioequalizerfilter.hpp \
+    audio/loudnessmeter.hpp \
+    audio/audiobenchmark.hpp \
+    video/lumascan.hpp \
+    video/cropdetector.hpp \
+    video/combdetector.hpp \
+    video/motionestimator.hpp \
+    opengl/openglpixelbufferring.hpp \
+    video/rendertiming.hpp \
+    video/playbackstats.hpp \
+    video/slidedecoder.hpp \
+    video/sliderenderer.hpp \
+    subtitle/subtitlebenchmark.hpp \
+    video/videobenchmark.hpp \
+    video/renderbenchmark.hpp \
+    misc/benchmarktable.hpp \
+    video/previewsprite.hpp \
+    video/keyframedecoder.hpp \
+    video/contactsheet.hpp \
+    player/mediaprobe.hpp \
+    misc/directorycache.hpp \
+    player/keyframeindex.hpp \
+    player/audiooverview.hpp \
+    audio/audiozone.hpp \
+    audio/audioprofile.hpp \
+    misc/startuptrace.hpp \
+    misc/tracer.hpp \
+    opengl/openglreadback.hpp \
+    video/framecapture.hpp \
+    opengl/openglshadercache.hpp \
+    opengl/openglworker.hpp \
+    misc/matchindex.hpp \
+    misc/folderscanner.hpp \
+    os/resourcemonitor.hpp
 
 SOURCES += \
 	stdafx.cpp \
@@ -397,6 +442,7 @@ SOURCES += \
 	misc/enumaction.cpp \
 	misc/charsetdetector.cpp \
 	misc/downloader.cpp \
+	misc/downloadserver.cpp \
 	misc/actiongroup.cpp \
 	misc/xmlrpcclient.cpp \
 	misc/log.cpp \
@@ -408,6 +454,7 @@ SOURCES += \
 	misc/trayicon.cpp \
 	player/main.cpp \
 	player/mainwindow.cpp \
+	player/headlesswindow.cpp \
 	player/mrl.cpp \
 	player/translator.cpp \
 	pref/pref.cpp \
@@ -422,6 +469,7 @@ SOURCES += \
 	player/mediamisc.cpp \
 	player/mrlstate.cpp \
 	player/historymodel.cpp \
+	player/medialibrary.cpp \
 	player/mpv_helper.cpp \
     audio/channellayoutmap.cpp \
     player/openmediainfo.cpp \
@@ -467,6 +515,7 @@ SOURCES += \
 	audio/audioequalizer.cpp \
 	dialog/audioequalizerdialog.cpp \
     quick/circularimageitem.cpp \
+    quick/svgimageprovider.cpp \
     quick/maskareaitem.cpp \
 	quick/windowobject.cpp \
     misc/autoloader.cpp \
@@ -511,15 +560,53 @@ SOURCES += \
     misc/windowsize.cpp \
     enum/framebufferobjectformat.cpp \
     video/videopreview.cpp \
+    video/streamitem.cpp \
     dialog/fileassocdialog.cpp \
     quick/triangleitem.cpp \
+    quick/infosubscriber.cpp \
+    quick/bluritem.cpp \
     audio/visualizer.cpp \
+    audio/barvisualizeritem.cpp \
     kiss_fft/tools/kiss_fftr.c \
     kiss_fft/kiss_fft.c \
     dialog/encoderdialog.cpp \
     misc/filenamegenerator.cpp \
     enum/rotation.cpp \
-    player/videosettings.cpp
+    player/videosettings.cpp \
+    audio/audiokernel.cpp \
+    audio/audioequalizerfilter.cpp \
+    audio/loudnessmeter.cpp \
+    audio/audiobenchmark.cpp \
+    video/lumascan.cpp \
+    video/cropdetector.cpp \
+    video/combdetector.cpp \
+    video/motionestimator.cpp \
+    opengl/openglpixelbufferring.cpp \
+    video/rendertiming.cpp \
+    video/playbackstats.cpp \
+    video/slidedecoder.cpp \
+    video/sliderenderer.cpp \
+    subtitle/subtitlebenchmark.cpp \
+    video/videobenchmark.cpp \
+    video/renderbenchmark.cpp \
+    video/previewsprite.cpp \
+    video/keyframedecoder.cpp \
+    video/contactsheet.cpp \
+    player/mediaprobe.cpp \
+    misc/directorycache.cpp \
+    player/keyframeindex.cpp \
+    player/audiooverview.cpp \
+    audio/audiozone.cpp \
+    audio/audioprofile.cpp \
+    misc/startuptrace.cpp \
+    misc/tracer.cpp \
+    opengl/openglreadback.cpp \
+    video/framecapture.cpp \
+    opengl/openglshadercache.cpp \
+    opengl/openglworker.cpp \
+    misc/matchindex.cpp \
+    misc/folderscanner.cpp \
+    os/resourcemonitor.cpp
 
 TRANSLATIONS += translations/bomi_en.ts \
 	translations/bomi_ko.ts \
@@ -7,16 +7,51 @@
 #include "misc/dataevent.hpp"
 #include "misc/osdstyle.hpp"
 #include "player/streamtrack.hpp"
+#include "os/os.hpp"
 #include <QCloseEvent>
+#include <QStandardItemModel>
+#include <QThreadPool>
+#include <QTreeWidget>
+#include <QHeaderView>
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
 }
 
 static constexpr int TickEvent = QEvent::User + 1;
+static constexpr int ProbeEvent = QEvent::User + 2;
+// consumer gpus open only a few encoding sessions at once
+static constexpr int MaxHwJobs = 2;
 
 enum FrameRate { CFRAuto, CFRManual, VFR };
 
-struct CodecListPair { QStringList ac, vc; };
+// vc contains hw too
+struct CodecListPair { QStringList ac, vc, hw; };
+
+static auto isHardware(const AVCodec *c) -> bool
+{
+    static const char *const apis[] = {
+        "nvenc", "_qsv", "_vaapi", "_amf", "_omx", "_videotoolbox", "_mf", "_v4l2m2m"
+    };
+    for (auto api : apis) {
+        if (strstr(c->name, api))
+            return true;
+    }
+    return false;
+}
+
+// mpv feeds encoders from system memory, so hw frame formats are useless
+static auto uploadFormat(const AVCodec *c) -> AVPixelFormat
+{
+    if (!c->pix_fmts)
+        return AV_PIX_FMT_YUV420P;
+    for (auto p = c->pix_fmts; *p != AV_PIX_FMT_NONE; ++p) {
+        auto desc = av_pix_fmt_desc_get(*p);
+        if (desc && !(desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            return *p;
+    }
+    return AV_PIX_FMT_NONE;
+}
 
 static auto allCodecs() -> const CodecListPair&
 {
@@ -26,9 +61,13 @@ static auto allCodecs() -> const CodecListPair&
         while ((c = av_codec_next(c))) {
             if (!av_codec_is_encoder(c))
                 continue;
-            if (c->type == AVMEDIA_TYPE_VIDEO)
+            if (c->type == AVMEDIA_TYPE_VIDEO) {
+                if (uploadFormat(c) == AV_PIX_FMT_NONE)
+                    continue;
                 list.vc.push_back(_L(c->name));
-            else if (c->type == AVMEDIA_TYPE_AUDIO)
+                if (isHardware(c))
+                    list.hw.push_back(_L(c->name));
+            } else if (c->type == AVMEDIA_TYPE_AUDIO)
                 list.ac.push_back(_L(c->name));
         }
         av_free(c);
@@ -39,6 +78,128 @@ static auto allCodecs() -> const CodecListPair&
     return list;
 }
 
+// copy back mode of hwdec since encoding has no gl context
+static auto copyHwdec() -> QByteArray
+{
+    switch (OS::hwAcc()->api()) {
+    case OS::HwAcc::VaApiGLX:
+        return "vaapi-copy"_b;
+    case OS::HwAcc::Dxva2Copy:
+        return "dxva2-copy"_b;
+    default:
+        return QByteArray();
+    }
+}
+
+// hardware encoders are listed whenever compiled, but only opening one
+// tells whether a device for it exists
+class EncoderProbeJob : public QRunnable {
+public:
+    EncoderProbeJob(QObject *receiver, const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_receiver(receiver), m_cancel(cancel) { }
+    static auto mutex() -> QMutex& { static QMutex mutex; return mutex; }
+    // empty until probed
+    static auto usable() -> QStringList& { static QStringList list; return list; }
+    static auto isProbed() -> bool& { static bool probed = false; return probed; }
+private:
+    auto run() -> void final
+    {
+        mutex().lock();
+        bool probed = isProbed();
+        mutex().unlock();
+        if (!probed) {
+            QStringList list;
+            for (auto &name : allCodecs().hw) {
+                auto c = avcodec_find_encoder_by_name(name.toLatin1().constData());
+                auto ctx = c ? avcodec_alloc_context3(c) : nullptr;
+                if (!ctx)
+                    continue;
+                ctx->width = ctx->height = 256;
+                ctx->time_base = { 1, 25 };
+                ctx->pix_fmt = uploadFormat(c);
+                if (avcodec_open2(ctx, c, nullptr) >= 0)
+                    list.push_back(name);
+                avcodec_close(ctx);
+                av_free(ctx);
+            }
+            mutex().lock();
+            usable() = list;
+            isProbed() = true;
+            mutex().unlock();
+        }
+        QMutexLocker locker(&mutex());
+        if (!*m_cancel)
+            _PostEvent(m_receiver, ProbeEvent, usable());
+    }
+    QObject *m_receiver = nullptr;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
+// each encoder spreads over cores by itself, so a few instances saturate cpu
+static auto maxJobs() -> int
+{
+    return qBound(1, QThread::idealThreadCount() / 4, 4);
+}
+
+// everything needed to encode one clip, kept in queue across sessions
+struct EncodeJob {
+    QByteArray source, vcopts;
+    QString file;
+    QList<QPair<QByteArray, QByteArray>> options;
+    int start = 0, end = 0, threads = 0;
+    // hw: takes gpu session, threaded: vcopts accept threads
+    bool hw = false, threaded = false;
+    auto toVariant() const -> QVariant
+    {
+        QVariantList opts;
+        for (auto &opt : options)
+            opts.push_back(QVariantList() << opt.first << opt.second);
+        QVariantMap map;
+        map[u"source"_q] = source;
+        map[u"vcopts"_q] = vcopts;
+        map[u"file"_q] = file;
+        map[u"options"_q] = opts;
+        map[u"start"_q] = start;
+        map[u"end"_q] = end;
+        map[u"threads"_q] = threads;
+        map[u"hw"_q] = hw;
+        map[u"threaded"_q] = threaded;
+        return map;
+    }
+    static auto fromVariant(const QVariant &var) -> EncodeJob
+    {
+        const auto map = var.toMap();
+        EncodeJob job;
+        job.source = map[u"source"_q].toByteArray();
+        job.vcopts = map[u"vcopts"_q].toByteArray();
+        job.file = map[u"file"_q].toString();
+        for (auto &opt : map[u"options"_q].toList()) {
+            const auto pair = opt.toList();
+            if (pair.size() == 2)
+                job.options.push_back({ pair[0].toByteArray(), pair[1].toByteArray() });
+        }
+        job.start = map[u"start"_q].toInt();
+        job.end = map[u"end"_q].toInt();
+        job.threads = map[u"threads"_q].toInt();
+        job.hw = map[u"hw"_q].toBool();
+        job.threaded = map[u"threaded"_q].toBool();
+        return job;
+    }
+    auto duration() const -> int { return end - start; }
+};
+
+struct EncodeTask {
+    enum State { Pending, Running, Done, Failed };
+    int id = 0, error = MPV_ERROR_SUCCESS;
+    // tick: touched in mpv thread, progress: done msecs
+    int tick = -1, progress = 0;
+    State state = Pending;
+    EncodeJob job;
+    QSharedPointer<Mpv> mpv;
+    QTreeWidgetItem *item = nullptr;
+    QElapsedTimer elapsed;
+};
+
 struct CodecPair { QString ac, vc; };
 auto operator << (QDebug dbg, const CodecPair &cp) -> QDebug
 {
@@ -48,22 +209,235 @@ auto operator << (QDebug dbg, const CodecPair &cp) -> QDebug
 struct EncoderDialog::Data {
     EncoderDialog *p = nullptr;
     Ui::EncoderDialog ui;
-    QSharedPointer<Mpv> mpv;
     QByteArray source;
     StreamTrack audio, sub;
     OsdStyle style;
     QSize size;
-    QPushButton *start = nullptr;
+    QPushButton *start = nullptr, *add = nullptr, *run = nullptr, *remove = nullptr;
     FileNameGenerator g;
     ObjectStorage storage;
     QMap<QString, QVariant> copts;
     QMap<QString, CodecPair> fmts;
     QString ext, ac, vc;
     QRect crop;
-    int tick = -1, error = MPV_ERROR_SUCCESS;
-    bool resizing = false;
+    bool resizing = false, active = false;
+    QList<EncodeTask*> tasks;
+    int nextId = 0, failed = 0;
+    // progress of tasks done before current run, excluded from eta
+    double base = 0;
+    QElapsedTimer elapsed;
+    QSharedPointer<std::atomic<bool>> cancelProbe;
     auto aspect() const -> double
         { return size.isEmpty() ? 1.0 : size.width() / (double)size.height(); }
+    auto setUsable(const QStringList &usable) -> void
+    {
+        auto model = qobject_cast<QStandardItemModel*>(ui.vc->model());
+        for (auto &name : allCodecs().hw) {
+            const int idx = ui.vc->findText(name);
+            if (idx < 0)
+                continue;
+            const bool ok = usable.contains(name);
+            if (model)
+                model->item(idx)->setEnabled(ok);
+            ui.vc->setItemData(idx, ok ? tr("Hardware encoder")
+                                       : tr("No device for this hardware encoder"),
+                               Qt::ToolTipRole);
+        }
+    }
+    auto find(int id) const -> EncodeTask*
+    {
+        for (auto task : tasks) {
+            if (task->id == id)
+                return task;
+        }
+        return nullptr;
+    }
+    auto count(EncodeTask::State state) const -> int
+    {
+        int count = 0;
+        for (auto task : tasks)
+            count += task->state == state;
+        return count;
+    }
+    auto push(const EncodeJob &job) -> void
+    {
+        auto task = new EncodeTask;
+        task->id = ++nextId;
+        task->job = job;
+        task->item = new QTreeWidgetItem(ui.queue);
+        task->item->setText(0, QFileInfo(job.file).fileName());
+        task->item->setToolTip(0, job.file);
+        tasks.push_back(task);
+        updateItem(task);
+        updateButtons();
+    }
+    auto updateItem(EncodeTask *task) -> void
+    {
+        QString text;
+        switch (task->state) {
+        case EncodeTask::Pending:
+            text = tr("Queued");
+            break;
+        case EncodeTask::Running: {
+            const double done = task->progress, total = task->job.duration();
+            text = _N(qRound(100.0 * done / total)) % '%'_q;
+            if (done > 0 && total > done) {
+                const auto left = task->elapsed.elapsed() * (total - done) / done;
+                text += tr(" (%1 left)").arg(_MSecToString(left));
+            }
+            break;
+        } case EncodeTask::Done:
+            text = tr("Done");
+            break;
+        case EncodeTask::Failed:
+            text = QString::fromUtf8(mpv_error_string(task->error));
+            break;
+        }
+        task->item->setText(1, text);
+    }
+    auto updateProgress() -> void
+    {
+        double total = 0, done = 0;
+        for (auto task : tasks) {
+            const int duration = task->job.duration();
+            total += duration;
+            if (task->state == EncodeTask::Done || task->state == EncodeTask::Failed)
+                done += duration;
+            else if (task->state == EncodeTask::Running)
+                done += qBound(0, task->progress, duration);
+        }
+        auto prog = ui.prog;
+        prog->setRange(0, 1000);
+        prog->setValue(total > 0 ? 1000 * done / total : 0);
+        prog->setFormat(u"%p%"_q);
+        if (active && done > base && total > done) {
+            const auto left = elapsed.elapsed() * (total - done) / (done - base);
+            prog->setFormat(tr("%p% (%1 left)").arg(_MSecToString(left)));
+        }
+    }
+    auto updateButtons() -> void
+    {
+        run->setEnabled(!active && count(EncodeTask::Pending) > 0);
+        remove->setEnabled(!ui.queue->selectedItems().isEmpty());
+    }
+    auto stop(EncodeTask *task) -> void
+    {
+        if (!task->mpv)
+            return;
+        if (task->mpv->isRunning()) {
+            task->mpv->tellAsync("quit");
+            task->mpv->wait(30000);
+        }
+        task->mpv->destroy();
+        task->mpv.clear();
+    }
+    auto launch(EncodeTask *task) -> void
+    {
+        const auto &job = task->job;
+        const int id = task->id;
+        task->mpv.reset(new Mpv);
+        auto mpv = task->mpv.data();
+        QObject::connect(mpv, &QThread::finished, p, [=] () { finish(id); });
+        mpv->setLogContext("mpv/encoder"_b);
+        mpv->create();
+        mpv->setObserver(p);
+        mpv->request(MPV_EVENT_TICK, [=] (mpv_event*) {
+            if (_Change<int>(task->tick, mpv->get<double>("time-pos") * 10))
+                _PostEvent(p, TickEvent, id, task->tick);
+        });
+        mpv->request(MPV_EVENT_END_FILE, [=] (mpv_event *e) {
+            const auto ev = static_cast<mpv_event_end_file*>(e->data);
+            if (ev->reason == MPV_END_FILE_REASON_ERROR)
+                task->error = ev->error;
+            mpv->tellAsync("quit");
+        });
+        for (auto &opt : job.options)
+            mpv->setOption(opt.first.constData(), opt.second.constData());
+        // split cores among concurrent encoders unless user chose the count
+        int threads = job.threads;
+        if (!threads && maxJobs() > 1 && tasks.size() > 1)
+            threads = qMax(1, QThread::idealThreadCount() / maxJobs());
+        const auto n = QByteArray::number(threads);
+        mpv->setOption("vd-lavc-threads", n.constData());
+        // libavcodec encoders run in one thread unless told
+        auto vcopts = job.vcopts;
+        if (job.threaded && !vcopts.contains("threads=")) {
+            const auto t = "threads="_b + (threads ? n : "auto"_b);
+            vcopts = vcopts.isEmpty() ? t : t + ',' + vcopts;
+        }
+        if (!vcopts.isEmpty())
+            mpv->setOption("ovcopts", vcopts.constData());
+        task->tick = -1;
+        task->progress = 0;
+        task->error = MPV_ERROR_SUCCESS;
+        task->state = EncodeTask::Running;
+        task->elapsed.start();
+        updateItem(task);
+        mpv->initialize(Log::Debug, false);
+        mpv->start();
+        mpv->tell("loadfile", job.source);
+    }
+    auto finish(int id) -> void
+    {
+        auto task = find(id);
+        if (!task || !task->mpv)
+            return;
+        task->mpv->destroy();
+        task->mpv.clear();
+        if (task->error != MPV_ERROR_SUCCESS) {
+            task->state = EncodeTask::Failed;
+            ++failed;
+        } else
+            task->state = EncodeTask::Done;
+        updateItem(task);
+        schedule();
+    }
+    auto activate() -> void
+    {
+        if (active)
+            return;
+        active = true;
+        failed = 0;
+        base = 0;
+        for (auto task : tasks) {
+            if (task->state == EncodeTask::Done || task->state == EncodeTask::Failed)
+                base += task->job.duration();
+        }
+        elapsed.start();
+        schedule();
+    }
+    auto schedule() -> void
+    {
+        if (!active)
+            return;
+        int running = 0, hw = 0;
+        for (auto task : tasks) {
+            if (task->state == EncodeTask::Running) {
+                ++running;
+                hw += task->job.hw;
+            }
+        }
+        for (auto task : tasks) {
+            if (running >= maxJobs())
+                break;
+            if (task->state != EncodeTask::Pending || (task->job.hw && hw >= MaxHwJobs))
+                continue;
+            launch(task);
+            ++running;
+            hw += task->job.hw;
+        }
+        if (!running)
+            active = false;
+        updateProgress();
+        updateButtons();
+        if (active)
+            return;
+        if (failed > 0)
+            MBox::error(p, tr("Encoder"), tr("Failed to encode %1 clip(s).").arg(failed),
+                        { BBox::Ok }, BBox::Ok);
+        else
+            p->hide();
+    }
 };
 
 EncoderDialog::EncoderDialog(QWidget *parent)
@@ -104,8 +478,55 @@ EncoderDialog::EncoderDialog(QWidget *parent)
     });
     d->storage.add(d->ui.file);
     d->storage.add(d->ui.folder);
+    d->storage.add(d->ui.threads);
+    d->storage.add(d->ui.hwdec);
+    // running clips are stopped on exit and stored as queued
+    d->storage.add("queue", [=] () -> QVariant {
+        QVariantList list;
+        for (auto task : d->tasks) {
+            if (task->state == EncodeTask::Pending || task->state == EncodeTask::Running)
+                list.push_back(task->job.toVariant());
+        }
+        return list;
+    }, [=] (const QVariant &var) {
+        for (auto &item : var.toList()) {
+            const auto job = EncodeJob::fromVariant(item);
+            if (!job.source.isEmpty() && job.duration() > 0)
+                d->push(job);
+        }
+    });
 
+    d->add = d->ui.bbox->addButton(tr("Add to Queue"), BBox::ActionRole, this, [=] () {
+        const auto error = enqueue();
+        if (!error.isEmpty())
+            MBox::error(this, tr("Encoder"), error, { BBox::Ok }, BBox::Ok);
+    });
     d->start = d->ui.bbox->addButton(tr("Start"), BBox::ActionRole, this, [=] () { start(); });
+    d->run = d->ui.bbox->addButton(tr("Run Queue"), BBox::ActionRole, this, [=] () { d->activate(); });
+    d->remove = d->ui.bbox->addButton(tr("Remove"), BBox::ActionRole, this, [=] () {
+        for (auto item : d->ui.queue->selectedItems()) {
+            for (int i = 0; i < d->tasks.size(); ++i) {
+                auto task = d->tasks[i];
+                if (task->item != item)
+                    continue;
+                d->stop(task);
+                d->tasks.removeAt(i);
+                delete task->item;
+                delete task;
+                break;
+            }
+        }
+        d->schedule();
+        d->updateProgress();
+        d->updateButtons();
+    });
+    d->remove->setEnabled(false);
+    d->run->setEnabled(false);
+    d->ui.queue->header()->setStretchLastSection(false);
+    d->ui.queue->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    d->ui.queue->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    connect(d->ui.queue, &QTreeWidget::itemSelectionChanged,
+            this, [=] () { d->updateButtons(); });
     connect(d->ui.bbox->button(BBox::Close), &QAbstractButton::clicked,
             this, &EncoderDialog::close);
     connect(SIGNAL_VT(d->ui.fps, currentIndexChanged, int), this,
@@ -125,6 +546,17 @@ EncoderDialog::EncoderDialog(QWidget *parent)
     d->ui.ext->addItems(d->fmts.keys());
     d->ui.ac->addItems(allCodecs().ac);
     d->ui.vc->addItems(allCodecs().vc);
+    d->ui.hwdec->setEnabled(!copyHwdec().isEmpty());
+    d->cancelProbe.reset(new std::atomic<bool>(false));
+    {
+        QMutexLocker locker(&EncoderProbeJob::mutex());
+        if (EncoderProbeJob::isProbed())
+            d->setUsable(EncoderProbeJob::usable());
+        else if (!allCodecs().hw.isEmpty()) {
+            d->setUsable(QStringList());
+            QThreadPool::globalInstance()->start(new EncoderProbeJob(this, d->cancelProbe));
+        }
+    }
     d->ui.folder->setText(_WritablePath(Location::Movies));
     d->ui.fps->setCurrentIndex(::CFRAuto);
     d->ui.fps_value->setValue(30.0);
@@ -175,6 +607,7 @@ EncoderDialog::EncoderDialog(QWidget *parent)
 
 EncoderDialog::~EncoderDialog()
 {
+    *d->cancelProbe = true;
     cancel();
     d->ac = d->ui.ac->currentText();
     d->vc = d->ui.vc->currentText();
@@ -182,6 +615,7 @@ EncoderDialog::~EncoderDialog()
     d->copts[d->ac] = d->ui.acopts->text();
     d->copts[d->vc] = d->ui.vcopts->text();
     d->storage.save();
+    qDeleteAll(d->tasks);
     delete d;
 }
 
@@ -198,19 +632,21 @@ auto EncoderDialog::updateCropArea() -> void
 
 auto EncoderDialog::cancel() -> void
 {
-    if (d->mpv) {
-        if (d->mpv->isRunning()) {
-            d->mpv->tellAsync("quit");
-            d->mpv->wait(30000);
-        }
-        d->mpv->destroy();
-        d->mpv.clear();
+    d->active = false;
+    for (auto task : d->tasks) {
+        if (task->state != EncodeTask::Running)
+            continue;
+        d->stop(task);
+        task->state = EncodeTask::Pending;
+        d->updateItem(task);
     }
+    d->updateProgress();
+    d->updateButtons();
 }
 
 auto EncoderDialog::isBusy() const -> bool
 {
-    return d->mpv;
+    return d->count(EncodeTask::Running) > 0;
 }
 
 auto EncoderDialog::setSource(const QByteArray &mrl, const QSize &size,
@@ -244,14 +680,16 @@ auto EncoderDialog::setAudio(const StreamTrack &audio) -> void
 
 auto EncoderDialog::start() -> bool
 {
-    const auto error = run();
-    if (error.isEmpty())
+    const auto error = enqueue();
+    if (error.isEmpty()) {
+        d->activate();
         return true;
+    }
     MBox::error(this, tr("Encoder"), error, { BBox::Ok }, BBox::Ok);
     return false;
 }
 
-auto EncoderDialog::run() -> QString
+auto EncoderDialog::enqueue() -> QString
 {
     if (d->size.isEmpty())
         return tr("No video stream exists.");
@@ -271,41 +709,28 @@ auto EncoderDialog::run() -> QString
     const auto file = d->g.get(folder, d->ui.file->text(), d->ui.ext->currentText());
     if (file.isEmpty())
         return tr("Failed to create file.");
-    Q_ASSERT(!d->mpv);
-    d->mpv.reset(new Mpv);
-    connect(d->mpv.data(), &QThread::finished, this, [=] () {
-        d->mpv->destroy();
-        d->mpv.clear();
-        d->start->setEnabled(true);
-        if (d->error != MPV_ERROR_SUCCESS)
-            MBox::error(this, tr("Encoder"), QString::fromUtf8(mpv_error_string(d->error)),
-                        { BBox::Ok }, BBox::Ok);
-        hide();
-    });
-    d->mpv->setLogContext("mpv/encoder"_b);
-    d->mpv->create();
-    d->mpv->setObserver(this);
-    d->mpv->observe("time-pos", [=] (double s) { qDebug() << s; });
-    d->mpv->request(MPV_EVENT_TICK, [=] (mpv_event*) {
-        if (_Change<int>(d->tick, d->mpv->get<double>("time-pos") * 10))
-            _PostEvent(this, TickEvent, d->tick);
-    });
-    d->mpv->request(MPV_EVENT_END_FILE, [=] (mpv_event *e) {
-        const auto ev = static_cast<mpv_event_end_file*>(e->data);
-        if (ev->reason == MPV_END_FILE_REASON_ERROR)
-            d->error = ev->error;
-        d->mpv->tellAsync("quit");
-    });
-
+    EncodeJob job;
+    job.source = d->source;
+    job.file = file;
+    job.start = a;
+    job.end = b;
+    job.threads = d->ui.threads->value();
+    auto set = [&] (const char *name, const QByteArray &value)
+        { job.options.push_back({ QByteArray(name), value }); };
     auto _n = [] (auto n) { return QByteArray::number(n); };
 
-    d->mpv->setOption("o", MpvFile(file).toMpv());
+    set("o", MpvFile(file).toMpv());
+    const auto hwdec = copyHwdec();
+    if (d->ui.hwdec->isChecked() && !hwdec.isEmpty()) {
+        set("hwdec", hwdec);
+        set("hwdec-codecs", "all"_b);
+    }
     switch (d->ui.fps->currentIndex()) {
     case CFRManual:
-        d->mpv->setOption("ofps", _n(d->ui.fps_value->value()));
+        set("ofps", _n(d->ui.fps_value->value()));
         break;
     case CFRAuto:
-        d->mpv->setOption("oautofps", "yes");
+        set("oautofps", "yes");
         break;
     }
 
@@ -326,35 +751,36 @@ auto EncoderDialog::run() -> QString
         vf += "scale=" + _n(size.width()) + ':' + _n(size.height());
     }
     if (!vf.isEmpty())
-        d->mpv->setOption("vf", vf);
+        set("vf", vf);
 
     if (d->ui.ext->currentText() == u"gif"_q) {
-        d->mpv->setOption("ovc", "gif"_b);
-        if (!d->ui.vcopts->text().isEmpty())
-            d->mpv->setOption("ovcopts", d->ui.vcopts->text().toUtf8());
-        d->mpv->setOption("aid", "no"_b);
+        set("ovc", "gif"_b);
+        job.vcopts = d->ui.vcopts->text().toUtf8();
+        set("aid", "no"_b);
     } else {
-        d->mpv->setOption("ovc", d->ui.vc->currentText().toLatin1());
-        d->mpv->setOption("oac", d->ui.ac->currentText().toLatin1());
-        if (!d->ui.vcopts->text().isEmpty())
-            d->mpv->setOption("ovcopts", d->ui.vcopts->text().toUtf8());
+        const auto vc = d->ui.vc->currentText();
+        set("ovc", vc.toLatin1());
+        set("oac", d->ui.ac->currentText().toLatin1());
+        job.vcopts = d->ui.vcopts->text().toUtf8();
+        job.hw = allCodecs().hw.contains(vc);
+        job.threaded = !job.hw;
         if (!d->ui.acopts->text().isEmpty())
-            d->mpv->setOption("oacopts", d->ui.acopts->text().toUtf8());
+            set("oacopts", d->ui.acopts->text().toUtf8());
         if (d->audio.isValid()) {
             if (d->audio.isExternal())
-                d->mpv->setOption("audio-file", MpvFile(d->audio.file()).toMpv());
+                set("audio-file", MpvFile(d->audio.file()).toMpv());
             else
-                d->mpv->setOption("aid", _n(d->audio.id()));
+                set("aid", _n(d->audio.id()));
         }
     }
 
     if (!d->ui.subtitle->isChecked())
-        d->mpv->setOption("sid", "no");
+        set("sid", "no");
     else {
         const auto color = [] (const QColor &color) { return color.name(QColor::HexArgb).toLatin1(); };
         const auto &style = d->style;
         const auto &font = style.font;
-        d->mpv->setOption("sub-text-color", color(font.color));
+        set("sub-text-color", color(font.color));
         QStringList fontStyles;
         if (font.bold())
             fontStyles.append(u"Bold"_q);
@@ -364,29 +790,29 @@ auto EncoderDialog::run() -> QString
         if (!fontStyles.isEmpty())
             family += ":style="_a % fontStyles.join(' '_q);
         const double factor = font.size * 720.0;
-        d->mpv->setOption("sub-text-font", family.toUtf8());
-        d->mpv->setOption("sub-text-font-size", _n(factor));
+        set("sub-text-font", family.toUtf8());
+        set("sub-text-font-size", _n(factor));
         const auto &outline = style.outline;
         const auto scaled = [factor] (double v)
             { return qBound(0., v*factor, 10.); };
         if (outline.enabled) {
-            d->mpv->setOption("sub-text-border-size", _n(scaled(outline.width)));
-            d->mpv->setOption("sub-text-border-color", color(outline.color));
+            set("sub-text-border-size", _n(scaled(outline.width)));
+            set("sub-text-border-color", color(outline.color));
         } else
-            d->mpv->setOption("sub-text-border-size", "0.0");
+            set("sub-text-border-size", "0.0");
         const auto &bbox = style.bbox;
         if (bbox.enabled)
-            d->mpv->setOption("sub-text-back-color", color(bbox.color));
+            set("sub-text-back-color", color(bbox.color));
         else
-            d->mpv->setOption("sub-text-back-color", color(Qt::transparent));
+            set("sub-text-back-color", color(Qt::transparent));
         auto norm = [] (const QPointF &p) { return sqrt(p.x()*p.x() + p.y()*p.y()); };
         const auto &shadow = style.shadow;
         if (shadow.enabled) {
-            d->mpv->setOption("sub-text-shadow-color", color(shadow.color));
-            d->mpv->setOption("sub-text-shadow-offset", _n(scaled(norm(shadow.offset))));
+            set("sub-text-shadow-color", color(shadow.color));
+            set("sub-text-shadow-offset", _n(scaled(norm(shadow.offset))));
         } else {
-            d->mpv->setOption("sub-text-shadow-color", color(Qt::transparent));
-            d->mpv->setOption("sub-text-shadow-offset", "0.0");
+            set("sub-text-shadow-color", color(Qt::transparent));
+            set("sub-text-shadow-offset", "0.0");
         }
         // these should be applied?
         //    d->mpv.setAsync("ass-force-margins", d->vr->overlayOnLetterbox() && override); };
@@ -395,24 +821,17 @@ auto EncoderDialog::run() -> QString
         //    d->d->mpv->setAsync("ass-style-override", o ? "force"_b : "yes"_b);
         if (d->sub.isValid()) {
             if (d->sub.isExternal()) {
-                d->mpv->setOption("sub-file", MpvFile(d->sub.file()).toMpv());
+                set("sub-file", MpvFile(d->sub.file()).toMpv());
                 auto cp = d->sub.encoding().name().replace("Windows-"_a, "cp"_a, Qt::CaseInsensitive);
-                d->mpv->setOption("subcp", cp.toLatin1());
+                set("subcp", cp.toLatin1());
             } else
-                d->mpv->setOption("sid", _n(d->sub.id()));
+                set("sid", _n(d->sub.id()));
         }
     }
 
-    d->mpv->setOption("start", _n(a * 1e-3));
-    d->mpv->setOption("end", _n(b * 1e-3));
-
-    d->tick = -1;
-    d->error = MPV_ERROR_SUCCESS;
-    d->start->setEnabled(false);
-    d->ui.prog->setRange(a/100, b/100);
-    d->mpv->initialize(Log::Debug, false);
-    d->mpv->start();
-    d->mpv->tell("loadfile", d->source);
+    set("start", _n(a * 1e-3));
+    set("end", _n(b * 1e-3));
+    d->push(job);
     return QString();
 }
 
@@ -430,8 +849,23 @@ auto EncoderDialog::closeEvent(QCloseEvent *event) -> void
 
 auto EncoderDialog::customEvent(QEvent *event) -> void
 {
-    if (event->type() == TickEvent)
-        d->ui.prog->setValue(_GetData<int>(event));
+    switch ((int)event->type()) {
+    case TickEvent: {
+        int id = 0, tick = 0;
+        _TakeData(event, id, tick);
+        auto task = d->find(id);
+        if (!task || task->state != EncodeTask::Running)
+            break;
+        task->progress = tick * 100 - task->job.start;
+        d->updateItem(task);
+        d->updateProgress();
+        break;
+    } case ProbeEvent:
+        d->setUsable(_GetData<QStringList>(event));
+        break;
+    default:
+        break;
+    }
 }
 
 auto EncoderDialog::setSubtitle(const StreamTrack &sub, const OsdStyle &style) -> void
@@ -26,7 +26,7 @@ private:
     auto hideEvent(QHideEvent *event) -> void final;
     auto closeEvent(QCloseEvent *event) -> void final;
     auto customEvent(QEvent *event) -> void final;
-    auto run() -> QString;
+    auto enqueue() -> QString;
     struct Data;
     Data *d;
 };
@@ -2,9 +2,8 @@
 #include "ui_openmediafolderdialog.h"
 #include "player/playlist.hpp"
 #include "misc/objectstorage.hpp"
+#include "misc/folderscanner.hpp"
 #include <QFileIconProvider>
-#include <QCollator>
-#include "tmp/algorithm.hpp"
 
 enum ListRole {
     Type = Qt::UserRole + 1, Path
@@ -16,6 +15,9 @@ struct OpenMediaFolderDialog::Data {
     bool generating = false;
     QFileIconProvider icons;
     ObjectStorage storage;
+    // files are streamed into list while folders are being read
+    FolderScanner scanner;
+    QString root;
 
     auto updateOpenButton() -> void
     {
@@ -40,20 +42,10 @@ struct OpenMediaFolderDialog::Data {
     }
 
 
-    static auto sort(QFileInfoList &list) -> QFileInfoList&
+    auto add(const QFileInfoList &files, const QString &root) -> void
     {
-        QCollator c;
-        c.setNumericMode(true);
-        tmp::sort(list, [&](auto &lhs, auto &rhs)
-            { return c.compare(lhs.fileName(), rhs.fileName()) < 0; });
-        return list;
-    }
-
-    auto open(const QDir &dir, const QString &root, bool recursive) -> void
-    {
-        static const auto filters = _ToNameFilter(MediaExt);
-        auto files = dir.entryInfoList(filters, QDir::Files);
-        sort(files);
+        bool checked = false;
+        generating = true;
         for (int i=0; i<files.size(); ++i) {
             const auto path = files[i].absoluteFilePath();
             auto item = new QListWidgetItem(path.mid(root.size() + 1), ui.list);
@@ -71,24 +63,25 @@ struct OpenMediaFolderDialog::Data {
             item->setData(Type, QVariant::fromValue(box));
             item->setData(Path, path);
             item->setCheckState(box->isChecked() ? Qt::Checked : Qt::Unchecked);
+            checked |= box->isChecked();
         }
-        if (recursive) {
-            auto subs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
-            sort(subs);
-            for (auto &sub : subs)
-                open(QDir(sub.absoluteFilePath()), root, recursive);
-        }
+        generating = false;
+        if (checked)
+            ui.dbb->button(QDialogButtonBox::Open)->setEnabled(true);
     }
 
     auto updateList() -> void
     {
         ui.list->clear();
+        ui.dbb->button(QDialogButtonBox::Open)->setEnabled(false);
+        root.clear();
         const auto folder = ui.folder->text();
-        if (!folder.isEmpty()) {
-            const QDir dir(folder);
-            open(dir, dir.absolutePath(), ui.recursive->isChecked());
+        if (folder.isEmpty()) {
+            scanner.stop();
+            return;
         }
-        updateOpenButton();
+        root = QDir(folder).absolutePath();
+        scanner.start(root, MediaExt, ui.recursive->isChecked());
     }
 };
 
@@ -110,6 +103,8 @@ OpenMediaFolderDialog::OpenMediaFolderDialog(QWidget *parent, const QString &key
     connect(d->ui.list, &QListWidget::itemChanged,
             this, [=] () { d->updateOpenButton(); });
     connect(d->ui.recursive, &QCheckBox::toggled, this, [=] () { d->updateList(); });
+    connect(&d->scanner, &FolderScanner::found,
+            this, [=] (const QFileInfoList &files) { d->add(files, d->root); });
 
     d->ui.dbb->button(QDialogButtonBox::Open)->setEnabled(false);
     adjustSize();
@@ -13,8 +13,33 @@ SnapshotSaver::SnapshotSaver(const QImage &image, const QString &fileName, int q
     m_writable = file.open(QFile::Truncate | QFile::WriteOnly) && file.isWritable();
 }
 
+SnapshotSaver::SnapshotSaver(const QImage &frame, const QImage &osd,
+                             const QImage &sub, const QRectF &subRect,
+                             const QString &fileName, int quality)
+    : SnapshotSaver(frame, fileName, quality)
+{
+    m_osd = osd;
+    m_sub = sub;
+    m_subRect = subRect;
+}
+
+auto SnapshotSaver::compose(const QImage &frame, const QImage &osd,
+                            const QImage &sub, const QRectF &subRect) -> QImage
+{
+    if (osd.isNull() && sub.isNull())
+        return frame;
+    QImage image = frame;
+    QPainter painter(&image);
+    if (!osd.isNull())
+        painter.drawImage(osd.rect(), osd);
+    if (!sub.isNull())
+        painter.drawImage(subRect, sub);
+    return image;
+}
+
 auto SnapshotSaver::run() -> void
 {
+    m_image = compose(m_image, m_osd, m_sub, m_subRect);
     if (!m_writable)
         _Error("'%%' is not wriable.", m_fileName);
     else if (!m_image.save(m_fileName, nullptr, m_quality))
@@ -8,9 +8,15 @@ class VideoRenderer;        class SubtitleRenderer;
 class SnapshotSaver : public QRunnable {
 public:
     SnapshotSaver(const QImage &image, const QString &fileName, int quality);
+    // draw osd and subtitle over frame before saving
+    SnapshotSaver(const QImage &frame, const QImage &osd, const QImage &sub,
+                  const QRectF &subRect, const QString &fileName, int quality);
     auto isWritable() const -> bool { return m_writable; }
+    static auto compose(const QImage &frame, const QImage &osd,
+                        const QImage &sub, const QRectF &subRect) -> QImage;
 private:
-    const QImage m_image;
+    QImage m_image, m_osd, m_sub;
+    QRectF m_subRect;
     const QString m_fileName;
     const int m_quality;
     bool m_writable = false;
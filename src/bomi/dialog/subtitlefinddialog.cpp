@@ -15,7 +15,8 @@
 enum CustomRole {
     UrlRole = Qt::UserRole + 1,
     FileNameRole,
-    LangCodeRole
+    LangCodeRole,
+    MediaRole
 };
 
 class SubtitleLinkModel
@@ -36,6 +37,7 @@ public:
         if (role == UrlRole)      return at(row).url;
         if (role == FileNameRole) return at(row).fileName;
         if (role == LangCodeRole) return at(row).langCode;
+        if (role == MediaRole)    return at(row).media;
         return QVariant();
     }
     auto displayData(int row, int column) const -> QVariant {
@@ -74,7 +76,7 @@ struct SubtitleFindDialog::Data {
     Ui::SubtitleFindDialog ui;
     Downloader downloader;
     OpenSubtitlesFinder *finder = nullptr;
-    Mrl pending;
+    QList<Mrl> pending;
     SubtitleLinkModel model;
     LanguageFilterModel proxy;
     QString fileName;
@@ -125,9 +127,9 @@ struct SubtitleFindDialog::Data {
         if (ok) {
             ui.prog->setRange(0, 1);
             if (!pending.isEmpty()) {
-                auto mrl = pending;
-                pending = Mrl();
-                p->find(mrl);
+                const auto mrls = pending;
+                pending.clear();
+                p->find(mrls);
             }
         } else
             ui.prog->setRange(0, 0);
@@ -151,10 +153,11 @@ struct SubtitleFindDialog::Data {
         };
         ui.state->setText(text());
     }
-    auto getNameToPreserve(const QString &subName) -> QString
+    auto getNameToPreserve(const QString &subName, const QString &media) -> QString
     {
         Q_ASSERT(options.preserve);
 
+        const auto mediaFile = media.isEmpty() ? this->mediaFile : QFileInfo(media);
         auto dir = mediaFile.dir();
         QTemporaryFile temp(dir.absoluteFilePath(u"XXXXXX"_q));
         if (!temp.open())
@@ -233,7 +236,7 @@ SubtitleFindDialog::SubtitleFindDialog(QWidget *parent)
     d->ui.view->header()->resizeSection(1, 450);
     d->ui.view->header()->resizeSection(2, 150);
     d->finder = new OpenSubtitlesFinder;
-    d->ui.open->set(PathButton::SingleFile, PathButton::Open);
+    d->ui.open->set(PathButton::MultiFile, PathButton::Open);
     connect(&d->downloader, &Downloader::started, [this] () { d->updateState(); });
     connect(&d->downloader, &Downloader::progressed, [this] (qint64 written, qint64 total) {
         d->ui.prog->setRange(0, total);
@@ -246,8 +249,13 @@ SubtitleFindDialog::SubtitleFindDialog(QWidget *parent)
         d->downloads.erase(it);
         d->updateState();
     });
-    connect(d->ui.open, &PathButton::fileSelected,
-            [this] (const QString &file) { if (!file.isEmpty()) find(file); });
+    connect(d->ui.open, &PathButton::filesSelected, [this] (const QStringList &files) {
+        QList<Mrl> mrls;
+        for (auto &file : files)
+            mrls.push_back(Mrl(file));
+        if (!mrls.isEmpty())
+            find(mrls);
+    });
     connect(d->ui.find_file, &QPushButton::clicked, this, [=] () {
         if (d->mediaFile.exists())
             find(d->mediaFile.absoluteFilePath());
@@ -274,7 +282,8 @@ SubtitleFindDialog::SubtitleFindDialog(QWidget *parent)
         info.temp = !d->options.preserve;
         info.fileName = index.data(FileNameRole).toString();
         if (d->options.preserve) {
-            info.fileName = d->getNameToPreserve(info.fileName);
+            info.fileName = d->getNameToPreserve(info.fileName,
+                                                 index.data(MediaRole).toString());
             if (info.fileName.isEmpty())
                 return;
         }
@@ -323,12 +332,23 @@ auto SubtitleFindDialog::setOptions(bool preserve, const QString &format,
 
 auto SubtitleFindDialog::find(const Mrl &mrl) -> void
 {
-    d->mediaFile = QFileInfo(mrl.toLocalFile());
-    d->ui.fileName->setText(d->mediaFile.fileName());
+    find(QList<Mrl>() << mrl);
+}
+
+auto SubtitleFindDialog::find(const QList<Mrl> &mrls) -> void
+{
+    if (mrls.isEmpty())
+        return;
+    d->mediaFile = QFileInfo(mrls.first().toLocalFile());
+    if (mrls.size() > 1)
+        d->ui.fileName->setText(tr("%1 files").arg(mrls.size()));
+    else
+        d->ui.fileName->setText(d->mediaFile.fileName());
     if (!d->finder->isAvailable()) {
-        d->pending = mrl;
-    } else if (!d->finder->find(mrl)) {
-        const auto name = mrl.displayName();
+        d->pending = mrls;
+    } else if (!d->finder->find(mrls)) {
+        const auto name = mrls.size() > 1 ? d->ui.fileName->text()
+                                          : mrls.first().displayName();
         MBox::warn(this, tr("Find Subtitle"),
                    tr("Cannot find subtitles for %1.").arg(name),
                    { BBox::Ok });
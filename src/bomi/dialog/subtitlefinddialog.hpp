@@ -11,6 +11,7 @@ public:
     ~SubtitleFindDialog();
     auto setOptions(bool preserve, const QString &format, const QString &fb) -> void;
     auto find(const Mrl &mrl) -> void;
+    auto find(const QList<Mrl> &mrls) -> void;
     auto setLoadFunc(Load &&load) -> void;
     static auto defaultFileNameFormat() -> QString;
 private:
@@ -78,27 +78,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { return 0 <= id && id < size() ? info[id].value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const int &data,
@@ -112,6 +100,24 @@ public:
     static constexpr auto default_() -> Enum
     { return ChangeValue::Reset; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 5:
+            if (name == QLatin1String("Reset"))
+                return &info[0];
+            break;
+        case 8:
+            if (name == QLatin1String("Increase"))
+                return &info[1];
+            if (name == QLatin1String("Decrease"))
+                return &info[2];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
@@ -82,11 +82,36 @@ public:
     { return qApp->translate("EnumInfo", "Channel Layout"); }
     static auto item(Enum e) -> const Item*
     { 
-    auto it = std::find_if(info.cbegin(), info.cend(),
-                            [e] (const Item &info)
-                            { return info.value == e; });
-    return it != info.cend() ? &(*it) : nullptr;
- }
+        switch (e) {
+        case Enum::Mono: return &info[0];
+        case Enum::_2_0: return &info[1];
+        case Enum::_2_1: return &info[2];
+        case Enum::_3_0: return &info[3];
+        case Enum::_3_0_Back: return &info[4];
+        case Enum::_3_1: return &info[5];
+        case Enum::_4_0: return &info[6];
+        case Enum::_4_0_Side: return &info[7];
+        case Enum::_4_0_Diamond: return &info[8];
+        case Enum::_4_1: return &info[9];
+        case Enum::_4_1_Diamond: return &info[10];
+        case Enum::_5_0: return &info[11];
+        case Enum::_5_0_Side: return &info[12];
+        case Enum::_5_1: return &info[13];
+        case Enum::_5_1_Side: return &info[14];
+        case Enum::_6_0: return &info[15];
+        case Enum::_6_0_Front: return &info[16];
+        case Enum::_6_0_Hex: return &info[17];
+        case Enum::_6_1: return &info[18];
+        case Enum::_6_1_Hex: return &info[19];
+        case Enum::_6_1_Front: return &info[20];
+        case Enum::_7_0: return &info[21];
+        case Enum::_7_0_Front: return &info[22];
+        case Enum::_7_1: return &info[23];
+        case Enum::_7_1_Wide: return &info[24];
+        case Enum::_7_1_Side: return &info[25];
+        default: return nullptr;
+        }
+    }
     static auto name(Enum e) -> QString
     { auto i = item(e); return i ? i->name : QString(); }
     static auto key(Enum e) -> QString
@@ -130,27 +155,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = item((Enum)id); return i ? i->value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const QByteArray &data,
@@ -164,6 +177,76 @@ public:
     static constexpr auto default_() -> Enum
     { return ChannelLayout::_2_0; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 4:
+            if (name == QLatin1String("Mono"))
+                return &info[0];
+            if (name == QLatin1String("_2_0"))
+                return &info[1];
+            if (name == QLatin1String("_2_1"))
+                return &info[2];
+            if (name == QLatin1String("_3_0"))
+                return &info[3];
+            if (name == QLatin1String("_3_1"))
+                return &info[5];
+            if (name == QLatin1String("_4_0"))
+                return &info[6];
+            if (name == QLatin1String("_4_1"))
+                return &info[9];
+            if (name == QLatin1String("_5_0"))
+                return &info[11];
+            if (name == QLatin1String("_5_1"))
+                return &info[13];
+            if (name == QLatin1String("_6_0"))
+                return &info[15];
+            if (name == QLatin1String("_6_1"))
+                return &info[18];
+            if (name == QLatin1String("_7_0"))
+                return &info[21];
+            if (name == QLatin1String("_7_1"))
+                return &info[23];
+            break;
+        case 8:
+            if (name == QLatin1String("_6_0_Hex"))
+                return &info[17];
+            if (name == QLatin1String("_6_1_Hex"))
+                return &info[19];
+            break;
+        case 9:
+            if (name == QLatin1String("_3_0_Back"))
+                return &info[4];
+            if (name == QLatin1String("_4_0_Side"))
+                return &info[7];
+            if (name == QLatin1String("_5_0_Side"))
+                return &info[12];
+            if (name == QLatin1String("_5_1_Side"))
+                return &info[14];
+            if (name == QLatin1String("_7_1_Wide"))
+                return &info[24];
+            if (name == QLatin1String("_7_1_Side"))
+                return &info[25];
+            break;
+        case 10:
+            if (name == QLatin1String("_6_0_Front"))
+                return &info[16];
+            if (name == QLatin1String("_6_1_Front"))
+                return &info[20];
+            if (name == QLatin1String("_7_0_Front"))
+                return &info[22];
+            break;
+        case 12:
+            if (name == QLatin1String("_4_0_Diamond"))
+                return &info[8];
+            if (name == QLatin1String("_4_1_Diamond"))
+                return &info[10];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
@@ -88,27 +88,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { return 0 <= id && id < size() ? info[id].value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const QString &data,
@@ -122,6 +110,38 @@ public:
     static constexpr auto default_() -> Enum
     { return CodecId::Invalid; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 3:
+            if (name == QLatin1String("Vc1"))
+                return &info[5];
+            break;
+        case 4:
+            if (name == QLatin1String("H264"))
+                return &info[4];
+            if (name == QLatin1String("Wmv3"))
+                return &info[6];
+            if (name == QLatin1String("Hevc"))
+                return &info[7];
+            break;
+        case 5:
+            if (name == QLatin1String("Mpeg1"))
+                return &info[1];
+            if (name == QLatin1String("Mpeg2"))
+                return &info[2];
+            if (name == QLatin1String("Mpeg4"))
+                return &info[3];
+            break;
+        case 7:
+            if (name == QLatin1String("Invalid"))
+                return &info[0];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
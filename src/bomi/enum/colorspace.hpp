@@ -91,27 +91,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { return 0 <= id && id < size() ? info[id].value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const ColorEnumData &data,
@@ -125,6 +113,42 @@ public:
     static constexpr auto default_() -> Enum
     { return ColorSpace::Auto; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 3:
+            if (name == QLatin1String("RGB"))
+                return &info[6];
+            if (name == QLatin1String("XYZ"))
+                return &info[7];
+            break;
+        case 4:
+            if (name == QLatin1String("Auto"))
+                return &info[0];
+            break;
+        case 5:
+            if (name == QLatin1String("BT601"))
+                return &info[2];
+            if (name == QLatin1String("BT709"))
+                return &info[3];
+            if (name == QLatin1String("YCgCo"))
+                return &info[8];
+            break;
+        case 8:
+            if (name == QLatin1String("BT2020CL"))
+                return &info[5];
+            break;
+        case 9:
+            if (name == QLatin1String("SMPTE240M"))
+                return &info[1];
+            if (name == QLatin1String("BT2020NCL"))
+                return &info[4];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
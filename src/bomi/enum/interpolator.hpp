@@ -84,27 +84,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { return 0 <= id && id < size() ? info[id].value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const QByteArray &data,
@@ -118,6 +106,34 @@ public:
     static constexpr auto default_() -> Enum
     { return Interpolator::Bilinear; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 6:
+            if (name == QLatin1String("Spline"))
+                return &info[2];
+            break;
+        case 7:
+            if (name == QLatin1String("Bicubic"))
+                return &info[1];
+            if (name == QLatin1String("Lanczos"))
+                return &info[3];
+            if (name == QLatin1String("Sharpen"))
+                return &info[5];
+            break;
+        case 8:
+            if (name == QLatin1String("Bilinear"))
+                return &info[0];
+            break;
+        case 10:
+            if (name == QLatin1String("EwaLanczos"))
+                return &info[4];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
@@ -104,27 +104,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { return 0 <= id && id < size() ? info[id].value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const int &data,
@@ -138,6 +126,54 @@ public:
     static constexpr auto default_() -> Enum
     { return MouseBehavior::NoBehavior; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 8:
+            if (name == QLatin1String("ScrollUp"))
+                return &info[5];
+            break;
+        case 9:
+            if (name == QLatin1String("LeftClick"))
+                return &info[1];
+            break;
+        case 10:
+            if (name == QLatin1String("NoBehavior"))
+                return &info[0];
+            if (name == QLatin1String("RightClick"))
+                return &info[2];
+            if (name == QLatin1String("ScrollDown"))
+                return &info[6];
+            break;
+        case 11:
+            if (name == QLatin1String("MiddleClick"))
+                return &info[3];
+            if (name == QLatin1String("DoubleClick"))
+                return &info[4];
+            if (name == QLatin1String("Extra1Click"))
+                return &info[7];
+            if (name == QLatin1String("Extra2Click"))
+                return &info[8];
+            if (name == QLatin1String("Extra3Click"))
+                return &info[9];
+            if (name == QLatin1String("Extra4Click"))
+                return &info[10];
+            if (name == QLatin1String("Extra5Click"))
+                return &info[11];
+            if (name == QLatin1String("Extra6Click"))
+                return &info[12];
+            if (name == QLatin1String("Extra7Click"))
+                return &info[13];
+            if (name == QLatin1String("Extra8Click"))
+                return &info[14];
+            if (name == QLatin1String("Extra9Click"))
+                return &info[15];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
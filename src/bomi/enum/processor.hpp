@@ -58,11 +58,13 @@ public:
     { return qApp->translate("EnumInfo", ""); }
     static auto item(Enum e) -> const Item*
     { 
-    auto it = std::find_if(info.cbegin(), info.cend(),
-                            [e] (const Item &info)
-                            { return info.value == e; });
-    return it != info.cend() ? &(*it) : nullptr;
- }
+        switch (e) {
+        case Enum::None: return &info[0];
+        case Enum::CPU: return &info[1];
+        case Enum::GPU: return &info[2];
+        default: return nullptr;
+        }
+    }
     static auto name(Enum e) -> QString
     { auto i = item(e); return i ? i->name : QString(); }
     static auto key(Enum e) -> QString
@@ -83,27 +85,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = item((Enum)id); return i ? i->value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const QVariant &data,
@@ -117,6 +107,24 @@ public:
     static constexpr auto default_() -> Enum
     { return Processor::None; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 3:
+            if (name == QLatin1String("CPU"))
+                return &info[1];
+            if (name == QLatin1String("GPU"))
+                return &info[2];
+            break;
+        case 4:
+            if (name == QLatin1String("None"))
+                return &info[0];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
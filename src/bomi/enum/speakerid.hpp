@@ -72,11 +72,21 @@ public:
     { return qApp->translate("EnumInfo", ""); }
     static auto item(Enum e) -> const Item*
     { 
-    auto it = std::find_if(info.cbegin(), info.cend(),
-                            [e] (const Item &info)
-                            { return info.value == e; });
-    return it != info.cend() ? &(*it) : nullptr;
- }
+        switch (e) {
+        case Enum::FrontLeft: return &info[0];
+        case Enum::FrontRight: return &info[1];
+        case Enum::FrontCenter: return &info[2];
+        case Enum::LowFrequency: return &info[3];
+        case Enum::BackLeft: return &info[4];
+        case Enum::BackRight: return &info[5];
+        case Enum::FrontLeftCenter: return &info[6];
+        case Enum::FrontRightCenter: return &info[7];
+        case Enum::BackCenter: return &info[8];
+        case Enum::SideLeft: return &info[9];
+        case Enum::SideRight: return &info[10];
+        default: return nullptr;
+        }
+    }
     static auto name(Enum e) -> QString
     { auto i = item(e); return i ? i->name : QString(); }
     static auto key(Enum e) -> QString
@@ -105,27 +115,15 @@ public:
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = item((Enum)id); return i ? i->value : def; }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const mp_speaker_id &data,
@@ -139,6 +137,50 @@ public:
     static constexpr auto default_() -> Enum
     { return SpeakerId::FrontLeft; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+        case 8:
+            if (name == QLatin1String("BackLeft"))
+                return &info[4];
+            if (name == QLatin1String("SideLeft"))
+                return &info[9];
+            break;
+        case 9:
+            if (name == QLatin1String("FrontLeft"))
+                return &info[0];
+            if (name == QLatin1String("BackRight"))
+                return &info[5];
+            if (name == QLatin1String("SideRight"))
+                return &info[10];
+            break;
+        case 10:
+            if (name == QLatin1String("FrontRight"))
+                return &info[1];
+            if (name == QLatin1String("BackCenter"))
+                return &info[8];
+            break;
+        case 11:
+            if (name == QLatin1String("FrontCenter"))
+                return &info[2];
+            break;
+        case 12:
+            if (name == QLatin1String("LowFrequency"))
+                return &info[3];
+            break;
+        case 15:
+            if (name == QLatin1String("FrontLeftCenter"))
+                return &info[6];
+            break;
+        case 16:
+            if (name == QLatin1String("FrontRightCenter"))
+                return &info[7];
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
@@ -358,4 +358,29 @@ auto _UrlFromLocalFile(const QString &file) -> QUrl
     return url;
 }
 
+auto _NaturalSortKey(const QString &str) -> QString
+{
+    // digit run becomes '0', its length without leading zeros and the rest
+    // '0' never appears otherwise, so lengths are compared with lengths only
+    const auto folded = str.toCaseFolded();
+    QString key;
+    key.reserve(folded.size() + 8);
+    auto isDigit = [] (QChar c) { return '0'_q <= c && c <= '9'_q; };
+    for (int i = 0; i < folded.size();) {
+        if (!isDigit(folded[i])) {
+            key += folded[i++];
+            continue;
+        }
+        while (i < folded.size() && folded[i] == '0'_q)
+            ++i;
+        const int from = i;
+        while (i < folded.size() && isDigit(folded[i]))
+            ++i;
+        key += '0'_q;
+        key += QChar(0xe000 + qMin(i - from, 0x17ff));
+        key += folded.midRef(from, i - from);
+    }
+    return key;
+}
+
 }
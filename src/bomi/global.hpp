@@ -237,6 +237,10 @@ auto _LastOpenPath(const QString &key = QString()) -> QString;
 
 auto _UrlFromLocalFile(const QString &file) -> QUrl;
 
+// case-folded string with digit runs ordered by value, as QCollator does
+// in numeric mode, which can be compared as plain string
+auto _NaturalSortKey(const QString &str) -> QString;
+
 }
 
 using namespace Global;
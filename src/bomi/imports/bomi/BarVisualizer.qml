@@ -14,77 +14,17 @@ Item {
 
     Component.onCompleted: { vis.count = 100 }
 
-    Item {
+    VisualizerBars {
         id: frame
+        visualizer: vis
+        gap: d.gap
+        running: App.engine.playing
         width: (d.barWidth + d.gap) * vis.count - d.gap
         anchors.bottom: parent.bottom
         anchors.bottomMargin: parent.height * 0.07
         anchors.top: parent.top
         anchors.topMargin: parent.height * 0.1
         x: (parent.width - width) * 0.5 | 0
-
-        Repeater {
-            model: vis.count
-            Rectangle {
-                id: rect; parent: frame
-                width: d.barWidth; anchors.bottom: parent ? parent.bottom : undefined
-                x: index * (d.barWidth + d.gap)
-                gradient: Gradient {
-                    id: grad
-                    readonly property real min: -rect.y / rect.height
-                    GradientStop { position: grad.min; color: "red" }
-                    GradientStop { position: grad.min * 0.5 + 0.5; color: "yellow" }
-                    GradientStop { position: 1.0; color: "green" }
-                }
-
-                readonly property real value: vis.data[index] * frame.height
-
-                onValueChanged: {
-                    if (height < value) {
-                        sani.stop()
-                        sani.value = value
-                        sani.start()
-                    }
-                }
-                onHeightChanged: {
-                    if (height > top.anchors.bottomMargin)
-                        top.anchors.bottomMargin = height
-                }
-
-                SequentialAnimation {
-                    id: sani
-                    property real value: 0
-                    running: App.engine.playing
-                    NumberAnimation {
-                        target: rect
-                        property: "height"
-                        easing.type: Easing.OutQuad
-                        duration: 100
-                        to: sani.value
-                    }
-                    NumberAnimation {
-                        target: rect
-                        property: "height"
-                        easing.type: Easing.Linear
-                        duration: 1000
-                        to: 0
-                    }
-                }
-                Rectangle {
-                    id: top; parent: frame
-                    width: d.barWidth; height: Math.max(1, Math.min(5, width * 0.5)) | 0
-                    x: rect.x; anchors.bottom: parent.bottom
-
-                    NumberAnimation {
-                        id: anTop
-                        target: top; property: "anchors.bottomMargin"; to: 0
-                        easing.type: Easing.InQuad; duration: 3000
-                        running: top.anchors.bottomMargin > rect.height
-                    }
-
-                }
-            }
-        }
     }
 
     ShaderEffectSource {
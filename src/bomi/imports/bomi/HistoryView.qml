@@ -6,10 +6,13 @@ import bomi 1.0 as B
 Item {
     id: dock
     width: 300; height: parent.height
-    readonly property alias blockHiding: view.blockHiding
-    readonly property int widthHint: view.contentWidth+view.margins*2
-    property alias selectedIndex: view.selectedIndex
+    readonly property QtObject view: viewLoader.item
+    readonly property bool blockHiding: view ? view.blockHiding : false
+    readonly property int widthHint: view ? view.contentWidth+view.margins*2 : 300
+    readonly property int selectedIndex: view ? view.selectedIndex : -1
     readonly property QtObject history: B.App.history
+    readonly property QtObject library: B.App.library
+    readonly property bool searching: library.enabled && search.text.length > 0
     property int status: __ToolHidden
     anchors.right: parent.left
     visible: anchors.rightMargin < 0
@@ -40,7 +43,7 @@ Item {
         id: starComponent
         Image {
             width: 16; height: 16
-            source: starArea.containsMouse || history.isStarred(row)
+            source: starArea.containsMouse || starred
                     ? "qrc:/img/fav-on.png" : "qrc:/img/fav-off.png"
             MouseArea {
                 id: starArea
@@ -48,43 +51,89 @@ Item {
                 hoverEnabled: true
                 acceptedButtons: Qt.LeftButton
                 onClicked: {
-                    history.setStarred(row, !history.isStarred(row))
+                    history.setStarred(row, !starred)
                 }
             }
         }
     }
 
-    B.ModelView {
-        id: view
-        model: B.App.history
-        titlePadding: title.height
-        anchors.rightMargin: 1
-        rowHeight: 26
-        columns: [
-            ItemColumn { width: 200; title: qsTr("Name"); role: "name"; index: 1 },
-            ItemColumn { width: 150; title: qsTr("Latest Playback"); role: "latestplay" },
-            ItemColumn { width: 400; title: qsTr("Location"); role: "location" }
-        ]
-        itemDelegate: Item {
-            Loader {
-                readonly property int row: index
-                sourceComponent: column.index > 0 ? starComponent : undefined
-                anchors.verticalCenter: parent.verticalCenter
+    // list is incubated after first frame, so it doesn't delay skin loading
+    Loader {
+        id: viewLoader
+        anchors.fill: parent
+        visible: !dock.searching
+        asynchronous: true
+        sourceComponent: Component {
+            B.ModelView {
+                id: view
+                model: B.App.history
+                recordRole: "record"
+                titlePadding: search.y + search.height
+                anchors.rightMargin: 1
+                rowHeight: 26
+                columns: [
+                    ItemColumn { width: 200; title: qsTr("Name"); role: "name"; index: 1 },
+                    ItemColumn { width: 150; title: qsTr("Latest Playback"); role: "latestplay" },
+                    ItemColumn { width: 400; title: qsTr("Location"); role: "location" }
+                ]
+                itemDelegate: Item {
+                    Loader {
+                        readonly property int row: index
+                        readonly property bool starred: record.star
+                        sourceComponent: column.index > 0 ? starComponent : undefined
+                        anchors.verticalCenter: parent.verticalCenter
+                    }
+
+                    Text {
+                        anchors { fill: parent; leftMargin: column.index > 0 ? 18 : 0 }
+                        text: value; color: "white"; elide: Text.ElideRight
+                        verticalAlignment: Text.AlignVCenter
+                    }
+                }
+                onActivated: B.App.history.play(index)
             }
+        }
+    }
+
+    TextField {
+        id: search
+        visible: library.enabled
+        height: visible ? 24 : 0
+        y: title.height
+        anchors { left: parent.left; right: parent.right; margins: 6 }
+        placeholderText: qsTr("Search library")
+        onTextChanged: results.model = dock.searching ? library.search(text) : []
+    }
 
-            Text {
-                anchors { fill: parent; leftMargin: column.index > 0 ? 18 : 0 }
-                text: value; color: "white"; elide: Text.ElideRight
-                verticalAlignment: Text.AlignVCenter
+    ListView {
+        id: results
+        visible: dock.searching
+        clip: true
+        anchors { fill: parent; topMargin: search.y + search.height + 6 }
+        delegate: Item {
+            width: results.width; height: 36
+            Column {
+                anchors { fill: parent; leftMargin: 8; rightMargin: 8 }
+                Text {
+                    width: parent.width; color: "white"; elide: Text.ElideRight
+                    text: modelData.title ? modelData.title : modelData.name
+                }
+                Text {
+                    width: parent.width; color: "gray"; elide: Text.ElideMiddle
+                    font.pixelSize: 10; text: modelData.folder
+                }
+            }
+            MouseArea {
+                anchors.fill: parent
+                onDoubleClicked: B.App.open(modelData.location)
             }
         }
-        onActivated: B.App.history.play(index)
     }
 
     Rectangle {
         width: 1
         height: parent.height
-        anchors.left: view.right
+        anchors.right: parent.right
     }
 
     MouseArea {
@@ -95,7 +144,9 @@ Item {
 
     Text {
         id: title
-        text: width < 200 ? qsTr("History"): qsTr("Playback History")
+        text: history.importing
+              ? qsTr("Importing... %1%").arg(Math.round(history.importProgress * 100))
+              : width < 200 ? qsTr("History"): qsTr("Playback History")
         height: 30
         width: parent.width - 2 * 20
         color: "white"
@@ -10,7 +10,9 @@ Rectangle {
     Image {
         visible: logo.show
         anchors.fill: parent
-        source: "qrc:/img/logo-background.svg"
+        source: "image://svg/img/logo-background.svg"
+        sourceSize { width: logo.width; height: logo.height }
+        asynchronous: true
         smooth: true
         Image {
             id: logoImage
@@ -14,6 +14,8 @@ Item {
     readonly property alias blockHiding: d.blockHiding
     readonly property alias titleSeparator: __titleSeparator
     property alias model: list.model
+    // role of pre-formatted row which holds values of every column
+    property string recordRole: ""
     readonly property real contentWidth: {
         var width = 0
         for (var i=0; i<columns.length; ++i)
@@ -193,6 +195,7 @@ Item {
         delegate: Item {
             readonly property int row: index
             readonly property var itemModel: model
+            readonly property var itemRecord: recordRole ? model[recordRole] : null
             width: 2000; height: rowLoader.implicitHeight
 
             Loader {
@@ -215,7 +218,8 @@ Item {
                 model: view.columns
                 Loader {
                     readonly property ItemColumn column: modelData
-                    readonly property var value: itemModel[column.role]
+                    readonly property var record: itemRecord
+                    readonly property var value: record ? record[column.role] : itemModel[column.role]
                     readonly property int index: row
                     readonly property bool current: currentIndex == index
                     readonly property bool selected: selectedIndex == index
@@ -17,6 +17,9 @@ Item {
 
     Component.onCompleted: { bringIn.start() }
 
+    // statistics are computed only while this is shown
+    InfoSubscriber { active: wrapper.visible; interval: 200 }
+
     ColumnLayout {
         id: box; spacing: 0
         PlayInfoText { content: engine.media.name }
@@ -51,6 +54,45 @@ Item {
             readonly property string suffix: "%/" + (App.memory.total/1024.0).toFixed(2) + "GiB"
             content: formatBracket(name, usage.toFixed(1) + "MiB", (usage/App.memory.total*100.0).toFixed(1) + suffix)
         }
+        PlayInfoText {
+            readonly property var threads: App.cpu.threads
+            readonly property string name: qsTr("Threads")
+            function list() {
+                var text = ""
+                for (var i = 0; i < threads.length && i < 6; ++i) {
+                    var t = threads[i]
+                    if (i > 0)
+                        text += ", "
+                    text += t.name + (t.count > 1 ? "×" + t.count : "") + " " + t.usage.toFixed(1) + "%"
+                }
+                return text
+            }
+            visible: threads.length > 0
+            content: name + ": " + list()
+        }
+        PlayInfoText {
+            readonly property real heap: App.memory.heap
+            readonly property real rate: App.memory.heapRate
+            readonly property string name: qsTr("Heap")
+            readonly property string sign: rate < 0 ? "" : "+"
+            visible: heap >= 0
+            content: formatBracket(name, heap.toFixed(1) + "MiB", sign + rate.toFixed(2) + "MiB/s")
+        }
+        PlayInfoText {
+            readonly property real free: App.memory.gpuFree
+            readonly property real total: App.memory.gpuTotal
+            readonly property string name: qsTr("Video Memory")
+            visible: free >= 0
+            content: total > 0 ? formatBracket(name, (total - free).toFixed(1) + "MiB",
+                                               Alg.trunc((total - free)/total*100.0, 1).toFixed(1)
+                                               + "%/" + (total/1024.0).toFixed(2) + "GiB")
+                               : name + ": " + free.toFixed(1) + "MiB " + qsTr("free")
+        }
+        PlayInfoText {
+            readonly property real saved: App.memory.saved
+            visible: saved > 0
+            content: qsTr("Saved by Low Memory Mode") + ": " + saved.toFixed(1) + "MiB"
+        }
         PlayInfoText {
             readonly property int used: engine.cache.used
             readonly property int size: engine.cache.size
@@ -60,6 +102,19 @@ Item {
             content: formatBracket(name, !size ? qsTr("Unavailable") : (used + "KiB"),
                                    Format.fixedNA(percent, 1) + suffix);
         }
+        PlayInfoText {
+            readonly property var cache: engine.cache
+            readonly property string name: qsTr("Cache Fill")
+            readonly property string stalls: qsTr("%1 stalls, last %2ms")
+                                             .arg(cache.underruns).arg(cache.latency)
+            visible: cache.size > 0
+            content: formatBracket(name, cache.fillRate.toFixed(1) + "KiB/s, in "
+                                   + cache.throughput.toFixed(1) + "KiB/s", stalls)
+        }
+        PlayInfoText {
+            readonly property string name: qsTr("Custom Item Draw Calls")
+            content: name + ": " + App.topLevelItem.drawCalls
+        }
 
         PlayInfoText { }
 
@@ -81,6 +136,15 @@ Item {
             readonly property string name: qsTr("Delayed Frames")
             content: formatBracket(name, video.delayedFrames, video.delayedTime.toFixed(3) + "ms")
         }
+        PlayInfoText {
+            readonly property string name: qsTr("Decoding")
+            readonly property string threads: qsTr("%1 threads").arg(video.decoderThreads)
+            content: formatBracket(name, video.decodeTime.toFixed(3) + "ms/frame", threads)
+        }
+        PlayInfoText {
+            readonly property string name: qsTr("Decoder Queue/Late Frames")
+            content: name + ": " + video.decoderQueue + '/' + video.decoderDroppedFrames
+        }
 
         Component {
             id: toolText
@@ -115,6 +179,29 @@ Item {
             readonly property string name: qsTr("Driver")
             content: formatBracket(name, Format.textNA(audio.driver), audio.device)
         }
+        PlayInfoText {
+            readonly property string name: qsTr("Latency")
+            content: name + ": " + Format.fixedNA(audio.latency, 1, "ms")
+        }
+        PlayInfoText {
+            readonly property var profile: audio.profile
+            readonly property var total: profile.total
+            readonly property string name: qsTr("Filter Time")
+            function list() {
+                var text = ""
+                for (var i = 0; i < profile.stages.length; ++i) {
+                    var s = profile.stages[i]
+                    if (s.passthrough >= 1 || s.p99 <= 0)
+                        continue
+                    if (text.length > 0)
+                        text += ", "
+                    text += s.name + " " + s.p99.toFixed(1)
+                }
+                return text
+            }
+            content: formatBracket(name, total.p50.toFixed(1) + '/' + total.p99.toFixed(1)
+                                   + "us/buffer", list())
+        }
 
         PlayInfoText { }
 
@@ -5,19 +5,20 @@ import QtQuick.Controls.Styles 1.0
 
 Item {
     id: dock
-    readonly property alias blockHiding: view.blockHiding
+    readonly property QtObject view: viewLoader.item
+    readonly property bool blockHiding: view ? view.blockHiding : false
     readonly property real widthHint: {
         var w = 30
-        if (_location.show)
+        if (B.App.theme.controls.showLocationsInPlaylist)
             w += Math.min(widthHintForName, widthHintForLocation)
         else
             w += widthHintForName
         return Math.max(200, w);
     }
-    readonly property alias widthHintForName: view.nameWidth
-    readonly property alias widthHintForLocation: view.locationWidth
+    readonly property real widthHintForName: view ? view.nameWidth : 0
+    readonly property real widthHintForLocation: view ? view.locationWidth : 0
     readonly property QtObject playlist: B.App.playlist
-    property alias selectedIndex: view.selectedIndex
+    readonly property int selectedIndex: view ? view.selectedIndex : -1
     property int status: __ToolHidden
 
     width: widthHint; height: parent.height - 2*y; anchors.left: parent.right
@@ -50,91 +51,104 @@ Item {
         anchors.left: parent.left
     }
 
-    B.ModelView {
-        id: view
-        model: B.App.playlist
-        titlePadding: title.height
-        anchors {
-            leftMargin: 1
-            bottomMargin: parent.height - bottomSeparator.y
-        }
-        Text {
-            id: _name
-            font { pixelSize: 15 }
-            visible: false
-            text: "DUMMY TEXT FOR HEIGHT"
-            readonly property real h: contentHeight
-            function getWidth(text) {
-                return B.App.textWidth(text, font.pixelSize, font.family)
-            }
-        }
-        Text {
-            id: _location
-            readonly property bool show: B.App.theme.controls.showLocationsInPlaylist
-            readonly property real h: contentHeight
-            font { pixelSize: 10; family: B.App.theme.monospace }
-            visible: false
-            text: "DUMMY TEXT FOR HEIGHT"
-            function getWidth(text) {
-                return B.App.textWidth(text, font.pixelSize, font.family)
-            }
-        }
-
-        headerVisible: false
-        rowHeight: _name.contentHeight + (_location.show ? _location.contentHeight : 0) + 14;
+    // list is incubated after first frame, so it doesn't delay skin loading
+    Loader {
+        id: viewLoader
+        anchors.fill: parent
+        asynchronous: true
+        sourceComponent: Component {
+            B.ModelView {
+                id: view
+                model: B.App.playlist
+                titlePadding: title.height
+                anchors {
+                    leftMargin: 1
+                    bottomMargin: parent.height - bottomSeparator.y
+                }
+                Text {
+                    id: _name
+                    font { pixelSize: 15 }
+                    visible: false
+                    text: "DUMMY TEXT FOR HEIGHT"
+                    readonly property real h: contentHeight
+                    function getWidth(text) {
+                        return B.App.textWidth(text, font.pixelSize, font.family)
+                    }
+                }
+                Text {
+                    id: _location
+                    readonly property bool show: B.App.theme.controls.showLocationsInPlaylist
+                    readonly property real h: contentHeight
+                    font { pixelSize: 10; family: B.App.theme.monospace }
+                    visible: false
+                    text: "DUMMY TEXT FOR HEIGHT"
+                    function getWidth(text) {
+                        return B.App.textWidth(text, font.pixelSize, font.family)
+                    }
+                }
 
-        property real nameWidth: 0
-        property real locationWidth: 0
-        currentIndex: model.loaded
-        function updateWidthHints() {
-            var nameMax = 0, locMax = 0;
-            for (var i=0; i<view.count; ++i) {
-                var number = _name.getWidth(model.number(i))
-                var name = _name.getWidth(model.name(i))
-                nameMax = Math.max(nameMax, number + name)
-                if (_location.show)
-                    locMax = Math.max(locMax, _location.getWidth(model.location(i)))
-            }
-            nameWidth = nameMax
-            locationWidth = locMax
-        }
+                headerVisible: false
+                rowHeight: _name.contentHeight + (_location.show ? _location.contentHeight : 0) + 14;
 
-        Connections {
-            target: view.model;
-            onSelectedChanged: view.selectedIndex = target.selected
-        }
+                property real nameWidth: 0
+                property real locationWidth: 0
+                currentIndex: model.loaded
+                // model may be filled before incubation completes
+                Component.onCompleted: {
+                    selectedIndex = model.selected
+                    countChanged()
+                }
+                function updateWidthHints() {
+                    var nameMax = 0, locMax = 0;
+                    for (var i=0; i<view.count; ++i) {
+                        var number = _name.getWidth(model.number(i))
+                        var name = _name.getWidth(model.name(i))
+                        nameMax = Math.max(nameMax, number + name)
+                        if (_location.show)
+                            locMax = Math.max(locMax, _location.getWidth(model.location(i)))
+                    }
+                    nameWidth = nameMax
+                    locationWidth = locMax
+                }
 
-        columns: B.ItemColumn { title: "Name"; role: "name"; width: 200; id: column}
+                Connections {
+                    target: view.model;
+                    onSelectedChanged: view.selectedIndex = target.selected
+                }
 
-        onSelectedIndexChanged: model.selected = view.selectedIndex
-        onCountChanged: {
-            updateWidthHints()
-            column.width = Math.max(nameWidth, locationWidth)
-        }
-        onActivated: model.play(index)
+                recordRole: "record"
+                columns: B.ItemColumn { title: "Name"; role: "name"; width: 200; id: column}
 
-        itemDelegate: Item {
-            Column {
-                width: parent.width
-                anchors.verticalCenter: parent.verticalCenter
-                Text {
-                    anchors { margins: 5; left: parent.left; right: parent.right }
-                    font: _name.font
-                    verticalAlignment: Text.AlignVCenter; height: _name.h
-                    color: "white"; text: value; elide: Text.ElideRight
+                onSelectedIndexChanged: model.selected = view.selectedIndex
+                onCountChanged: {
+                    updateWidthHints()
+                    column.width = Math.max(nameWidth, locationWidth)
                 }
-                Text {
-                    visible: _location.show
-                    anchors { margins: 5; left: parent.left; right: parent.right }
-                    font: _location.font
-                    width: parent.width; height: _location.h; verticalAlignment: Text.AlignTop
-                    color: "white"; text: view.model.location(index); elide: Text.ElideRight
+                onActivated: model.play(index)
+
+                itemDelegate: Item {
+                    Column {
+                        width: parent.width
+                        anchors.verticalCenter: parent.verticalCenter
+                        Text {
+                            anchors { margins: 5; left: parent.left; right: parent.right }
+                            font: _name.font
+                            verticalAlignment: Text.AlignVCenter; height: _name.h
+                            color: "white"; text: value; elide: Text.ElideRight
+                        }
+                        Text {
+                            visible: _location.show
+                            anchors { margins: 5; left: parent.left; right: parent.right }
+                            font: _location.font
+                            width: parent.width; height: _location.h; verticalAlignment: Text.AlignTop
+                            color: "white"; text: record.location; elide: Text.ElideRight
+                        }
+                    }
                 }
             }
         }
     }
 
-
     MouseArea {
         anchors.fill: parent
         acceptedButtons: Qt.RightButton
@@ -9,6 +9,9 @@ Slider {
     property bool toolTip: !bind
     property VideoPreviewStyle preview: VideoPreviewStyle { }
     property int target: -1
+    // skins can draw peaks of whole audio over the groove
+    property bool waveform: false
+    property color waveformColor: Qt.rgba(1, 1, 1, 0.3)
     enabled: d.e.seekable
     acceptsWheel: true
     z: 1
@@ -79,6 +82,28 @@ Slider {
             bind.time = Qt.binding(function ( ) { return mouseArea.time; })
     }
 
+    Canvas {
+        id: wave
+        anchors.fill: parent
+        visible: seeker.waveform && d.e.audio.hasOverview
+        onVisibleChanged: requestPaint()
+        onWidthChanged: requestPaint()
+        onHeightChanged: requestPaint()
+        onPaint: {
+            var ctx = getContext("2d")
+            ctx.reset()
+            if (!visible)
+                return
+            var peaks = d.e.audio.waveform(width / 2 | 0)
+            ctx.fillStyle = seeker.waveformColor
+            for (var i = 0; i < peaks.length; ++i) {
+                var h = Math.max(1, peaks[i] * height)
+                ctx.fillRect(i * 2, (height - h) * 0.5, 1, h)
+            }
+        }
+        Connections { target: d.e.audio; onOverviewChanged: wave.requestPaint() }
+    }
+
     Repeater {
         model: d.e.chapters
         Loader {
@@ -3,21 +3,40 @@
 #include "http-parser/http_parser.h"
 #include "misc/log.hpp"
 #include <QNetworkRequest>
+#include <QQueue>
 
 DECLARE_LOG_CONTEXT(JSON-RPC)
 
+static constexpr int MaxInFlight = 16;
+static constexpr qint64 MaxUnsentBytes = 4 << 20;
+static constexpr qint64 MaxBodyBytes = 1 << 20;
+// clients are created in network thread only
+static quint64 s_serial = 0;
+
 struct JrClient::Data {
+    quint64 id = 0;
     QIODevice *device;
     JrServer *server;
     QString peer;
+    QJsonObject pending;
+    QTimer notifier;
+    int inFlight = 0;
 };
 
 JrClient::JrClient(QIODevice *device, const QString &peer, JrServer *server)
-    : QObject(server), d(new Data)
+    : d(new Data)
 {
+    d->id = ++s_serial;
     d->device = device;
     d->server = server;
     d->peer = peer;
+    d->notifier.setSingleShot(true);
+    d->notifier.setInterval(100);
+    connect(&d->notifier, &QTimer::timeout, this, &JrClient::flush);
+    connect(device, &QIODevice::bytesWritten, this, [=] () {
+        if (!isCongested())
+            resume();
+    });
 }
 
 JrClient::~JrClient()
@@ -25,6 +44,11 @@ JrClient::~JrClient()
     delete d;
 }
 
+auto JrClient::id() const -> quint64
+{
+    return d->id;
+}
+
 auto JrClient::peer() const -> QString
 {
     return d->peer;
@@ -50,12 +74,56 @@ auto JrClient::write(const QList<JrResponse> &responses,
     beginReply(responses, data.size() + 1);
     *d->device << data << '\n';
     endReply();
+    if (d->inFlight > 0)
+        --d->inFlight;
     if (autoClose())
         d->device->close();
+    else if (!isCongested())
+        resume();
+}
+
+auto JrClient::isCongested() const -> bool
+{
+    return d->inFlight >= MaxInFlight || d->device->bytesToWrite() > MaxUnsentBytes;
+}
+
+auto JrClient::setNotifyInterval(int ms) -> void
+{
+    d->notifier.setInterval(qBound(20, ms, 60000));
+}
+
+auto JrClient::post(const QString &name, const QJsonValue &value) -> void
+{
+    d->pending.insert(name, value);
+    if (!d->notifier.isActive())
+        d->notifier.start();
+}
+
+auto JrClient::unpost(const QString &name) -> void
+{
+    d->pending.remove(name);
+}
+
+auto JrClient::flush() -> void
+{
+    if (d->pending.isEmpty() || !d->device->isOpen())
+        return;
+    if (d->device->bytesToWrite() > MaxUnsentBytes) {
+        d->notifier.start(); // keep merging until client catches up
+        return;
+    }
+    QJsonObject json;
+    json[u"jsonrpc"_q] = u"2.0"_q;
+    json[u"method"_q] = u"rpc.notify"_q;
+    json[u"params"_q] = d->pending;
+    d->pending = QJsonObject();
+    *d->device << QJsonDocument(json).toJson(QJsonDocument::Compact) << '\n';
 }
 
+// every parse() ends with one reply(), maybe after gui thread answers
 auto JrClient::parse(const QByteArray &data) -> void
 {
+    ++d->inFlight;
     d->server->parse(this, data);
 }
 
@@ -78,8 +146,11 @@ struct JrHttp::Data {
     http_parser *parser = nullptr;
     http_parser_settings settings;
     Request request;
-    QByteArray field, value, body;
+    QByteArray field, value, body, buffer;
     QString url;
+    // keep-alive of requests waiting for reply, in order of arrival
+    QQueue<bool> keepAlive;
+    bool closing = false, last = false;
     auto fillHeader() -> void
     {
         if (field.isEmpty() || value.isEmpty())
@@ -95,13 +166,17 @@ struct JrHttp::Data {
         case BadRequest: return "Bad Request"_b;
         case NotFound: return "Not Found"_b;
         case MethodNotAllowed: return "Method Not Allowed"_b;
+        case PayloadTooLarge: return "Payload Too Large"_b;
         case InternalServerError: return "Internal Server Error"_b;
         }
         return QByteArray();
     }
     auto close(JrHttp::Status status) -> void
     {
-        writeStatus(status) << "\r\n";
+        writeStatus(status) << "Connection: close\r\n"
+                            << "Content-Length: 0\r\n\r\n";
+        buffer.clear();
+        closing = true;
         p->device()->close();
     }
     auto writeStatus(JrHttp::Status status) -> QIODevice&
@@ -152,23 +227,40 @@ JrHttp::JrHttp(QIODevice *device, const QString &peer, JrServer *server)
         }
 
         const auto type = d->request.header(Request::ContentTypeHeader).toByteArray();
-        const auto len = d->request.header(Request::ContentLengthHeader).toInt();
+        const auto len = d->request.header(Request::ContentLengthHeader).toLongLong();
         const auto accept = d->request.rawHeader("Accept");
+        const bool chunked = parser->flags & F_CHUNKED;
 
         static const QList<QByteArray> types= {
             "application/json-rpc",
             "application/json",
             "application/jsonrequest"
         };
-        if (len <= 0 || !types.contains(type) || !types.contains(accept)) {
+        if ((len <= 0 && !chunked) || !types.contains(type) || !types.contains(accept)) {
             d->close(BadRequest);
             _Error("Bad Request: content-type: %%, content-length: %%, accept: %%", type, len, accept);
             return -1;
         }
+        if (len > MaxBodyBytes) {
+            d->close(PayloadTooLarge);
+            _Error("Request body of %% bytes is too large.", len);
+            return -1;
+        }
+        if (len > 0)
+            d->body.reserve(len);
+        return 0;
+    };
+    d->settings.on_body = [] (http_parser *parser, const char *at, size_t len) -> int {
+        auto d = GET_DATA();
+        // chunked body has no length in advance
+        if (d->body.size() + (qint64)len > MaxBodyBytes) {
+            d->close(PayloadTooLarge);
+            _Error("Request body exceeds %% bytes.", MaxBodyBytes);
+            return -1;
+        }
+        d->body.append(at, len);
         return 0;
     };
-    d->settings.on_body = [] (http_parser *parser, const char *at, size_t len) -> int
-        { GET_DATA()->body.append(at, len); return 0; };
     d->settings.on_message_complete = [] (http_parser *parser) -> int {
         auto d = GET_DATA();
         if (parser->method == HTTP_GET) {
@@ -200,14 +292,18 @@ JrHttp::JrHttp(QIODevice *device, const QString &peer, JrServer *server)
             }
             d->body += '}';
         }
+        const bool keepAlive = http_should_keep_alive(parser);
+        d->keepAlive.enqueue(keepAlive);
+        d->last = !keepAlive;
         d->p->parse(d->body);
+        d->body.clear();
+        // hold pipelined requests after last one or while congested
+        if (!keepAlive || d->p->isCongested())
+            http_parser_pause(parser, 1);
         return 0;
     };
 #undef GET_DATA
-    connect(device, &QIODevice::readyRead, this, [=] () {
-        const auto data = this->device()->readAll();
-        http_parser_execute(d->parser, &d->settings, data.data(), data.size());
-    });
+    connect(device, &QIODevice::readyRead, this, &JrHttp::read);
 }
 
 JrHttp::~JrHttp()
@@ -216,6 +312,41 @@ JrHttp::~JrHttp()
     delete d;
 }
 
+auto JrHttp::autoClose() const -> bool
+{
+    return d->closing;
+}
+
+auto JrHttp::read() -> void
+{
+    if (d->closing || d->last || !device()->isOpen())
+        return;
+    // leave data in socket while congested, so sender is held back
+    if (isCongested())
+        return;
+    d->buffer.append(device()->readAll());
+    while (!d->buffer.isEmpty() && !d->closing && !isCongested()) {
+        const auto parsed = http_parser_execute(d->parser, &d->settings,
+                                                d->buffer.constData(),
+                                                d->buffer.size());
+        const auto error = HTTP_PARSER_ERRNO(d->parser);
+        if (error == HPE_PAUSED) {
+            d->buffer.remove(0, parsed);
+            if (d->last)
+                d->buffer.clear(); // nothing follows 'Connection: close'
+            else
+                http_parser_pause(d->parser, 0);
+            continue;
+        }
+        d->buffer.clear();
+        if (error != HPE_OK && !d->closing) {
+            _Error("Invalid HTTP request from %%: %%", peer(),
+                   http_errno_description(error));
+            d->close(BadRequest);
+        }
+    }
+}
+
 auto JrHttp::beginReply(const QList<JrResponse> &responses, int length) -> void
 {
     Status status = Ok;
@@ -236,7 +367,11 @@ auto JrHttp::beginReply(const QList<JrResponse> &responses, int length) -> void
         if (status != Ok)
             break;
     }
+    const bool keepAlive = d->keepAlive.isEmpty() ? false : d->keepAlive.dequeue();
+    d->closing = !keepAlive;
+    // responses are serialized at once, so length is always known
     d->writeStatus(status) << "Content-Type: application/json-rpc\r\n"
+                           << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n"
                            << "Content-Length: " << length << "\r\n\r\n";
 }
 
@@ -323,8 +458,11 @@ JrRaw::~JrRaw()
 auto JrRaw::read() -> void
 {
     Q_ASSERT(device());
+    // leave data in socket while congested, so sender is held back
+    if (isCongested())
+        return;
     d->data.append(device()->readAll());
-    while (!d->data.isEmpty()) {
+    while (!d->data.isEmpty() && !isCongested()) {
         auto data = d->extract();
         if (data.isEmpty())
             return; // fetch more
@@ -5,23 +5,38 @@
 
 class JrServer;
 
+// lives in network thread of server
 class JrClient : public QObject {
 public:
     JrClient(QIODevice *device, const QString &peer, JrServer *server);
     ~JrClient();
+    // unique in process, never reused
+    auto id() const -> quint64;
     auto peer() const -> QString;
     auto device() const -> QIODevice*;
     auto server() const -> JrServer*;
     auto parse(const QByteArray &data) -> void;
+    // close after current reply
     virtual auto autoClose() const -> bool { return false; }
     auto reply(const JrResponse &response) -> void;
     auto reply(const QList<JrResponse> &response) -> void;
+    // subscriptions need connection which stays open
+    virtual auto canNotify() const -> bool { return true; }
+    // changes are merged by name and sent in one batch at most once per interval
+    auto setNotifyInterval(int ms) -> void;
+    auto post(const QString &name, const QJsonValue &value) -> void;
+    auto unpost(const QString &name) -> void;
+    // too many requests in flight or too much data not sent yet
+    auto isCongested() const -> bool;
 protected:
     virtual auto beginReply(const QList<JrResponse> &/*responses*/, int /*length*/) -> void { }
     virtual auto endReply() -> void { }
+    // called when congestion may have been resolved
+    virtual auto resume() -> void { }
 private:
     auto write(const QList<JrResponse> &responses,
                const QJsonDocument &doc) -> void;
+    auto flush() -> void;
     struct Data;
     Data *d;
 };
@@ -33,13 +48,18 @@ public:
         BadRequest = 400,
         NotFound = 404,
         MethodNotAllowed = 405,
+        PayloadTooLarge = 413,
         InternalServerError = 500
     };
     JrHttp(QIODevice *device, const QString &peer, JrServer *server);
     ~JrHttp();
     auto beginReply(const QList<JrResponse> &responses, int length) -> void final;
-    auto autoClose() const -> bool final { return true; }
+    auto autoClose() const -> bool final;
+    // server cannot send anything which is not a response
+    auto canNotify() const -> bool final { return false; }
 private:
+    auto resume() -> void final { read(); }
+    auto read() -> void;
     struct Data;
     Data *d;
 };
@@ -49,6 +69,7 @@ public:
     JrRaw(QIODevice *device, const QString &peer, JrServer *server);
     ~JrRaw();
 private:
+    auto resume() -> void final { read(); }
     auto read() -> void;
     struct Data;
     Data *d;
@@ -1 +1,7 @@
 #include "jriface.hpp"
+
+auto JrWatcher::triggerSlot() -> QMetaMethod
+{
+    const auto &mo = staticMetaObject;
+    return mo.method(mo.indexOfSlot("trigger()"));
+}
@@ -5,9 +5,27 @@ class JrRequest;                        class JrResponse;
 
 class JrIface : public QObject {
 public:
+    using Notify = std::function<void(const QJsonValue&)>;
     JrIface(QObject *parent = nullptr): QObject(parent) { }
     ~JrIface() = default;
     virtual auto request(const JrRequest &request) -> JrResponse = 0;
+    // call notify with new value whenever property or signal at path changes
+    // returned object owns the connection, nullptr if path cannot be watched
+    virtual auto watch(const QString &/*path*/, Notify &&/*notify*/,
+                       QObject */*parent*/) -> QObject* { return nullptr; }
+};
+
+// invokes function whenever connected signal is emitted
+class JrWatcher : public QObject {
+    Q_OBJECT
+public:
+    JrWatcher(std::function<void()> &&func, QObject *parent = nullptr)
+        : QObject(parent), m_func(std::move(func)) { }
+    static auto triggerSlot() -> QMetaMethod;
+public slots:
+    void trigger() { m_func(); }
+private:
+    std::function<void()> m_func;
 };
 
 #endif // JRIFACE_HPP
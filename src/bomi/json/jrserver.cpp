@@ -2,6 +2,7 @@
 #include "jrclient.hpp"
 #include "jriface.hpp"
 #include "misc/log.hpp"
+#include "misc/dataevent.hpp"
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QSslSocket>
@@ -11,6 +12,18 @@
 DECLARE_LOG_CONTEXT(JSON-RPC)
 
 using ServerError = QAbstractSocket::SocketError;
+using Task = std::function<void()>;
+
+enum EventType { RunTask = QEvent::User + 1 };
+
+// runs tasks posted from gui thread in network thread
+class JrRouter : public QObject {
+    auto customEvent(QEvent *event) -> void final
+    {
+        if (event->type() == RunTask)
+            _GetData<Task>(event)();
+    }
+};
 
 class JrTransport {
 public:
@@ -25,6 +38,7 @@ public:
         { m_server->sendError(error, str); }
     virtual auto listen(const QString &address, int port) -> bool = 0;
     virtual auto serverName() const -> QString = 0;
+    virtual auto object() -> QObject* = 0;
 private:
     JrServer *m_server;
 };
@@ -67,6 +81,7 @@ struct JrTcp : public QTcpServer, public JrTransport {
     }
     auto serverName() const -> QString final
         { return serverAddress().toString() % ':'_q % _N(serverPort()); }
+    auto object() -> QObject* final { return this; }
 };
 
 struct JrLocal : public QLocalServer, public JrTransport {
@@ -94,24 +109,45 @@ struct JrLocal : public QLocalServer, public JrTransport {
         return false;
     }
     auto serverName() const -> QString final { return fullServerName(); }
+    auto object() -> QObject* final { return this; }
 };
 
 /******************************************************************************/
 
 struct JrServer::Data {
+    JrServer *p = nullptr;
     JrConnection connection = JrConnection::Tcp;
     JrProtocol protocol = JrProtocol::Http;
     JrTransport *transport = nullptr;
+    QThread thread;
+    JrRouter router;
+    QString serverName;
+
+    // gui thread only
     JrIface *iface = nullptr;
     ServerError error = QAbstractSocket::UnknownSocketError;
-    QMap<QIODevice*, JrClient*> clients;
     Error handleError;
     QString errorString = u"No Error"_q;
+    QHash<quint64, QMap<QString, QObject*>> watchers;
+
+    // network thread only
+    QMap<quint64, JrClient*> clients;
+
+    auto gui(Task &&task) -> void { _PostEvent(p, RunTask, task); }
+    auto net(Task &&task) -> void { _PostEvent(&router, RunTask, task); }
+    auto client(quint64 id) const -> JrClient* { return clients.value(id); }
+
+    auto request(quint64 id, bool notifiable,
+                 const QList<JrRequest> &requests) -> QList<JrResponse>;
+    auto subscribe(quint64 id, bool notifiable,
+                   const JrRequest &request, bool on) -> JrResponse;
+    auto unwatch(quint64 id) -> void { qDeleteAll(watchers.take(id)); }
 };
 
 JrServer::JrServer(JrConnection connection, JrProtocol protocol, QObject *parent)
     : QObject(parent), d(new Data)
 {
+    d->p = this;
     d->connection = connection;
     d->protocol = protocol;
     switch (d->connection) {
@@ -123,17 +159,25 @@ JrServer::JrServer(JrConnection connection, JrProtocol protocol, QObject *parent
         d->transport = new JrLocal(this);
         break;
     }
+    d->router.moveToThread(&d->thread);
+    d->thread.setObjectName(u"JSON-RPC"_q);
+    d->thread.start();
 }
 
 JrServer::~JrServer()
 {
     _Info("Closing server.");
     setInterface(nullptr);
-    auto devices = d->clients.keys();
-    for (auto dev : devices) {
-        dev->close();
-        removeClient(dev);
+    d->thread.quit();
+    d->thread.wait();
+    // network thread is gone, so its objects can be touched here
+    auto clients = d->clients;
+    for (auto client : clients) {
+        client->device()->close();
+        removeClient(client->device());
     }
+    for (auto it = d->watchers.begin(); it != d->watchers.end(); ++it)
+        qDeleteAll(*it);
     delete d->transport;
     delete d;
 }
@@ -152,14 +196,25 @@ auto JrServer::listen(const QString &address, int port) -> bool
 {
     d->error = QAbstractSocket::UnknownSocketError;
     d->errorString = u"No Error"_q;
-    if (d->transport && d->transport->listen(address, port)) {
-        _Info("Listening %%.", d->transport->serverName());
+    if (!d->transport || d->transport->object()->thread() != thread())
+        return false; // already listening in network thread
+    if (d->transport->listen(address, port)) {
+        d->serverName = d->transport->serverName();
+        _Info("Listening %%.", d->serverName);
+        d->transport->object()->moveToThread(&d->thread);
         return true;
     }
     _Error("Failed to listen '%%:%%': %%", address, port, errorString());
     return false;
 }
 
+auto JrServer::customEvent(QEvent *event) -> void
+{
+    if (event->type() == RunTask)
+        _GetData<Task>(event)();
+}
+
+// network thread
 auto JrServer::parse(JrClient *client, const QByteArray &data) -> void
 {
     QJsonParseError error = { 0, QJsonParseError::NoError };
@@ -177,33 +232,115 @@ auto JrServer::parse(JrClient *client, const QByteArray &data) -> void
     else if (doc.isArray())
         array = doc.array();
 
+    QList<JrRequest> requests;
+    requests.reserve(array.size());
+    for (int i = 0; i < array.size(); ++i)
+        requests.push_back(JrRequest::fromJson(array.at(i).toObject()));
+
+    // whole batch is handled in one hop
+    const auto id = client->id();
+    const auto notifiable = client->canNotify();
+    d->gui([=] () {
+        const auto replies = d->request(id, notifiable, requests);
+        d->net([=] () {
+            auto client = d->client(id);
+            if (!client)
+                return;
+            if (replies.size() == 1)
+                client->reply(replies.front());
+            else
+                client->reply(replies);
+        });
+    });
+}
+
+// gui thread
+auto JrServer::Data::request(quint64 id, bool notifiable,
+                             const QList<JrRequest> &requests) -> QList<JrResponse>
+{
     QList<JrResponse> replies;
-    replies.reserve(array.size());
-    for (int i = 0; i < array.size(); ++i) {
-        const auto request = JrRequest::fromJson(array.at(i).toObject());
+    replies.reserve(requests.size());
+    for (auto &request : requests) {
         if (!request.isValid()) {
             _Error("Invalid request object exits.");
             replies.push_back(_JrErrorResponse(QJsonValue::Null, JrError::InvalidRequest));
         } else {
             JrResponse res;
-            if (d->iface)
-                res = d->iface->request(request);
+            if (request.method() == "rpc.subscribe"_a)
+                res = subscribe(id, notifiable, request, true);
+            else if (request.method() == "rpc.unsubscribe"_a)
+                res = subscribe(id, notifiable, request, false);
+            else if (iface)
+                res = iface->request(request);
             else
                 res = _JrErrorResponse(request.id(), JrError::MethodNotFound);
             if (!request.isNotification())
                 replies.push_back(res);
         }
     }
-    if (replies.size() == 1)
-        client->reply(replies.front());
-    else
-        client->reply(replies);
+    return replies;
 }
 
+// params: ["name", ...] or { "names": ["name", ...], "interval": msec }
+// result: names which are (un)subscribed successfully
+auto JrServer::Data::subscribe(quint64 id, bool notifiable,
+                               const JrRequest &request, bool on) -> JrResponse
+{
+    if (!notifiable)
+        return _JrErrorResponse(request.id(), JrError::InvalidRequest,
+                                u"Subscription needs persistent connection"_q);
+    QJsonArray names;
+    const auto params = request.params();
+    if (params.isArray())
+        names = params.toArray();
+    else if (params.isObject()) {
+        const auto json = params.toObject();
+        names = json[u"names"_q].toArray();
+        const auto interval = json[u"interval"_q];
+        if (interval.isDouble()) {
+            const int ms = interval.toInt();
+            net([=] () { if (auto c = client(id)) c->setNotifyInterval(ms); });
+        }
+    }
+    auto &watching = watchers[id];
+    QJsonArray done;
+    for (auto value : names) {
+        const auto name = value.toString();
+        if (name.isEmpty())
+            continue;
+        if (!on) {
+            if (auto watcher = watching.take(name)) {
+                delete watcher;
+                net([=] () { if (auto c = client(id)) c->unpost(name); });
+                done.push_back(name);
+            }
+            continue;
+        }
+        if (watching.contains(name)) {
+            done.push_back(name);
+            continue;
+        }
+        if (!iface)
+            break;
+        auto notify = [=] (const QJsonValue &value) {
+            net([=] () { if (auto c = client(id)) c->post(name, value); });
+        };
+        if (auto watcher = iface->watch(name, std::move(notify), nullptr)) {
+            watching.insert(name, watcher);
+            done.push_back(name);
+        }
+    }
+    if (watching.isEmpty())
+        watchers.remove(id);
+    if (on && done.isEmpty())
+        return _JrErrorResponse(request.id(), JrError::InvalidParams);
+    return { request, done };
+}
+
+// network thread
 auto JrServer::addClient(QIODevice *dev, const QString &peer) -> bool
 {
     JrClient *client = nullptr;
-    Q_ASSERT(!client);
     switch (d->protocol) {
     case JrProtocol::Http:
         client = new JrHttp(dev, peer, this);
@@ -215,16 +352,23 @@ auto JrServer::addClient(QIODevice *dev, const QString &peer) -> bool
         return false;
     }
     _Info("Client connected: %%", peer);
-    d->clients[dev] = client;
+    d->clients[client->id()] = client;
     return true;
 }
 
+// network thread
 auto JrServer::removeClient(QIODevice *dev) -> void
 {
-    auto client = d->clients.take(dev);
-    if (client) {
+    for (auto it = d->clients.begin(); it != d->clients.end(); ++it) {
+        if ((*it)->device() != dev)
+            continue;
+        auto client = *it;
+        const auto id = client->id();
+        d->clients.erase(it);
         _Info("Client disconnected: %%", client->peer());
         delete client;
+        d->gui([=] () { d->unwatch(id); });
+        return;
     }
 }
 
@@ -232,6 +376,10 @@ auto JrServer::setInterface(JrIface *iface) -> void
 {
     if (d->iface)
         disconnect(d->iface, nullptr, this, nullptr);
+    // watchers belong to old interface
+    for (auto it = d->watchers.begin(); it != d->watchers.end(); ++it)
+        qDeleteAll(*it);
+    d->watchers.clear();
     d->iface = iface;
     if (d->iface)
         connect(d->iface, &JrIface::destroyed, this,
@@ -255,15 +403,19 @@ auto JrServer::errorString() const -> QString
 
 auto JrServer::sendError(ServerError error, const QString &errorString) -> void
 {
-    if (error != QAbstractSocket::RemoteHostClosedError) {
-        d->error = error;
-        d->errorString = errorString;
-        if (d->handleError)
-            d->handleError(error);
+    if (error == QAbstractSocket::RemoteHostClosedError)
+        return;
+    if (QThread::currentThread() != thread()) {
+        d->gui([=] () { sendError(error, errorString); });
+        return;
     }
+    d->error = error;
+    d->errorString = errorString;
+    if (d->handleError)
+        d->handleError(error);
 }
 
 auto JrServer::serverName() const -> QString
 {
-    return d->transport ? d->transport->serverName() : QString();
+    return d->serverName;
 }
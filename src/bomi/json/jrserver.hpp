@@ -8,6 +8,8 @@
 class JrIface;                          class JrClient;
 class JrRequest;                        class JrResponse;
 
+// sockets, framing and json parsing run in network thread
+// only requests are handed to interface in gui thread
 class JrServer : public QObject {
     Q_OBJECT
     using Error = std::function<void(QAbstractSocket::SocketError)>;
@@ -23,6 +25,7 @@ public:
     auto errorString() const -> QString;
     auto setErrorHandler(Error &&func) -> void;
 private:
+    auto customEvent(QEvent *event) -> void final;
     auto sendError(QAbstractSocket::SocketError error,
                    const QString &errorString) -> void;
     auto parse(JrClient *client, const QByteArray &data) -> void;
@@ -23,6 +23,11 @@ extern "C" {
   in the tools/ directory.
 */
 
+/* bomi: 4 transforms in each call where sse and aligned stack are given */
+#if !defined(USE_SIMD) && !defined(FIXED_POINT) && (defined(__x86_64__) || defined(_M_X64))
+# define USE_SIMD 1
+#endif
+
 #ifdef USE_SIMD
 # include <xmmintrin.h>
 # define kiss_fft_scalar __m128
@@ -99,7 +104,7 @@ void kiss_fft_stride(kiss_fft_cfg cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout
 
 /* If kiss_fft_alloc allocated a buffer, it is one contiguous 
    buffer and can be simply free()d when no longer needed*/
-#define kiss_fft_free free
+#define kiss_fft_free KISS_FFT_FREE
 
 /*
  Cleans up some memory that gets managed internally. Not necessary to call, but it might clean up 
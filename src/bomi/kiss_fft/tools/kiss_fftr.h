@@ -38,7 +38,7 @@ void kiss_fftri(kiss_fftr_cfg cfg,const kiss_fft_cpx *freqdata,kiss_fft_scalar *
  output timedata has nfft scalar points
 */
 
-#define kiss_fftr_free free
+#define kiss_fftr_free KISS_FFT_FREE
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,7 @@
 #include "json.hpp"
 #include "ui_autoloaderwidget.h"
 #include "simplelistmodel.hpp"
+#include "directorycache.hpp"
 #include <QStyledItemDelegate>
 
 #define JSON_CLASS Autoloader
@@ -13,42 +14,33 @@ auto Autoloader::autoload(const Mrl &mrl, ExtType type) const -> QStringList
     if (!mrl.isLocalFile() || !enabled)
         return QStringList();
     const QFileInfo fileInfo(mrl.toLocalFile());
-    auto root = fileInfo.dir();
-    auto loaded = tryDir(fileInfo, type, root);
-    auto list = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    const auto root = DirectoryCache::get(fileInfo.absolutePath());
+    auto loaded = tryDir(fileInfo, type, *root);
     for (auto &path : search_paths) {
-        for (auto &one : list) {
-            if (path.match(one)) {
-                auto dir = root;
-                if (dir.cd(one))
-                    loaded += tryDir(fileInfo, type, dir);
-            }
+        for (auto &one : root->dirs()) {
+            if (path.match(one))
+                loaded += tryDir(fileInfo, type, *DirectoryCache::get(root->filePath(one)));
         }
     }
     return loaded;
 }
 
 auto Autoloader::tryDir(const QFileInfo &fileInfo, ExtType type,
-                        const QDir &dir) const -> QStringList
+                        const DirectoryListing &dir) const -> QStringList
 {
     Q_ASSERT(enabled);
     if (!dir.exists())
         return QStringList();
     QStringList files;
-    const auto filter = _ToNameFilter(type);
-    const auto all = dir.entryInfoList(filter, QDir::Files, QDir::Name);
     const auto base = fileInfo.completeBaseName();
-    for (int i = 0; i < all.size(); ++i) {
-        if (all[i].fileName() == fileInfo.fileName())
+    const auto all = mode == AutoloadMode::Matched ? dir.matched(base, type)
+                                                   : dir.files(type);
+    for (auto &name : all) {
+        if (name == fileInfo.fileName())
             continue;
-        if (mode != AutoloadMode::Folder) {
-            if (mode == AutoloadMode::Matched) {
-                if (base != all[i].completeBaseName())
-                    continue;
-            } else if (!all[i].fileName().contains(base))
-                continue;
-        }
-        files.push_back(all[i].absoluteFilePath());
+        if (mode == AutoloadMode::Contain && !name.contains(base))
+            continue;
+        files.push_back(dir.filePath(name));
     }
     return files;
 }
@@ -5,6 +5,8 @@
 #include "enum/autoloadmode.hpp"
 #include "player/mrl.hpp"
 
+class DirectoryListing;
+
 struct Autoloader {
     DECL_EQ(Autoloader, &T::search_paths, &T::enabled, &T::mode)
     auto toJson() const -> QJsonObject;
@@ -15,7 +17,8 @@ struct Autoloader {
     bool enabled = false;
     AutoloadMode mode = AutoloadMode::Matched;
 private:
-    auto tryDir(const QFileInfo &fileInfo, ExtType type, const QDir &dir) const -> QStringList;
+    auto tryDir(const QFileInfo &fileInfo, ExtType type,
+                const DirectoryListing &dir) const -> QStringList;
 };
 
 Q_DECLARE_METATYPE(Autoloader)
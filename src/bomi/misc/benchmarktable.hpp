@@ -0,0 +1,25 @@
+#ifndef BENCHMARKTABLE_HPP
+#define BENCHMARKTABLE_HPP
+
+// report of benchmark cases on stdout, one row for each case
+// first column is padded to longest name given to fit()
+class BenchmarkTable {
+public:
+    auto fit(const QString &name) -> void { m_width = qMax(m_width, name.size()); }
+    // anything whose items have name such as list of cases
+    template<class List>
+    auto fit(const List &list) -> void { for (auto &item : list) fit(item.name); }
+    auto row(const QString &name, const QString &columns) const -> void
+    {
+        qDebug().nospace() << name.toLatin1().constData()
+                           << QByteArray(qMax(0, m_width - name.size()), ' ').constData()
+                           << columns.toLatin1().constData();
+    }
+    // titles of columns after first one are laid out by caller
+    auto header(const QString &first, const char *titles) const -> void
+        { row(first, _L(titles)); }
+private:
+    int m_width = 0;
+};
+
+#endif // BENCHMARKTABLE_HPP
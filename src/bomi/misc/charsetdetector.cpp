@@ -2,6 +2,7 @@
 #include "misc/log.hpp"
 #define HAVE_DLL_EXPORT
 #include <chardet.h>
+#include <QDateTime>
 
 DECLARE_LOG_CONTEXT(Charset)
 
@@ -64,6 +65,17 @@ auto CharsetDetector::detect(const QByteArray &data, double confidence) -> Encod
     return EncodingInfo();
 }
 
+// detection by file identity, shared by every caller such as subtitle autoload
+struct Detected {
+    qint64 size = 0; QDateTime modified; int limit = 0;
+    QString encoding; double confidence = 0.0;
+    bool full = false; // whole limit has been scanned
+};
+
+static QMutex s_mutex;
+static QHash<QString, Detected> s_cache;
+static constexpr int CacheMax = 256, FirstChunk = 64*1024;
+
 auto CharsetDetector::detect(const QString &fileName, double confidence, int size) -> EncodingInfo
 {
     QFile file(fileName);
@@ -71,9 +83,70 @@ auto CharsetDetector::detect(const QString &fileName, double confidence, int siz
         _Error("Cannot open file: %%", fileName);
         return EncodingInfo();
     }
+    const QFileInfo info(fileName);
+    const auto limit = size < 0 || size > file.size() ? (int)file.size() : size;
+    auto accept = [&] (const Detected &det) {
+        if (det.encoding.isEmpty()) {
+            _Info("Failed to detect encoding.");
+            return EncodingInfo();
+        }
+        _Info("Encoding detected: %% (confidence: %%)", det.encoding, det.confidence);
+        if (det.confidence >= confidence)
+            return EncodingInfo::fromName(det.encoding);
+        _Info("Through away detected encoding for low confidence < %%.", confidence);
+        return EncodingInfo();
+    };
+    const auto key = info.absoluteFilePath();
+    s_mutex.lock();
+    auto it = s_cache.constFind(key);
+    if (it != s_cache.cend() && it->size == info.size()
+            && it->modified == info.lastModified() && it->limit == limit
+            && (it->full || it->confidence >= confidence)) {
+        const auto det = *it;
+        s_mutex.unlock();
+        return accept(det);
+    }
+    s_mutex.unlock();
+
     _Info("Trying encoding autodetection: %%", fileName);
-    size = -1;
-    if (size < 0)
-        size = file.size();
-    return detect(file.read(size), confidence);
+    Detected det;
+    det.size = info.size();
+    det.modified = info.lastModified();
+    det.limit = limit;
+    // libchardet cannot be fed incrementally, so growing prefixes are scanned
+    // until confidence is enough, which costs at most twice the last one
+    auto mapped = limit > 0 ? file.map(0, limit) : nullptr;
+    QByteArray buffer;
+    for (int len = qMin(FirstChunk, limit); len > 0; len = qMin(len * 2, limit)) {
+        QByteArray chunk;
+        if (mapped)
+            chunk = QByteArray(reinterpret_cast<const char*>(mapped), len);
+        else {
+            buffer += file.read(len - buffer.size());
+            chunk = buffer;
+        }
+        det.full = len >= limit;
+        // avoid a character cut at the end
+        if (!det.full) {
+            const int eol = chunk.lastIndexOf('\n');
+            if (eol > 0)
+                chunk.truncate(eol + 1);
+        }
+        CharsetDetector chardet(chunk);
+        if (chardet.isDetected()) {
+            det.encoding = chardet.encoding();
+            det.confidence = chardet.confidence();
+        }
+        if (det.full || det.confidence >= confidence)
+            break;
+    }
+    if (mapped)
+        file.unmap(mapped);
+
+    s_mutex.lock();
+    if (s_cache.size() >= CacheMax)
+        s_cache.clear();
+    s_cache.insert(key, det);
+    s_mutex.unlock();
+    return accept(det);
 }
@@ -10,6 +10,8 @@ public:
     auto isDetected() const -> bool;
     auto encoding() const -> QString;
     auto confidence() const -> double;
+    // reads at most size bytes (whole file if negative) and stops early once
+    // confidence is reached, results are cached by file identity
     static auto detect(const QString &fileName, double confidence = 0.6,
                        int size = 1024*500) -> EncodingInfo;
     static auto detect(const QByteArray &data, double confidence = 0.6) -> EncodingInfo;
@@ -0,0 +1,142 @@
+#include "directorycache.hpp"
+#include "misc/dataevent.hpp"
+#include <QFileSystemWatcher>
+
+enum EventType { Watch = QEvent::User + 1 };
+
+DirectoryListing::DirectoryListing(const QString &path)
+    : m_path(QDir(path).absolutePath())
+{
+    const QDir dir(m_path);
+    if (!(m_exists = dir.exists()))
+        return;
+    m_modified = QFileInfo(m_path).lastModified();
+    m_dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    const auto files = dir.entryList(QDir::Files, QDir::Name);
+    m_files.reserve(files.size());
+    for (auto &name : files) {
+        const int dot = name.lastIndexOf('.'_q);
+        m_bases[dot < 0 ? name : name.left(dot)].push_back(m_files.size());
+        m_files.push_back({name, dot});
+    }
+}
+
+auto DirectoryListing::files(ExtTypes exts) const -> QStringList
+{
+    QStringList names;
+    for (auto &e : m_files) {
+        if (_IsSuffixOf(exts, suffix(e)))
+            names.push_back(e.name);
+    }
+    return names;
+}
+
+auto DirectoryListing::matched(const QString &base, ExtTypes exts) const -> QStringList
+{
+    QStringList names;
+    const auto it = m_bases.find(base);
+    if (it == m_bases.end())
+        return names;
+    for (const int idx : *it) {
+        if (_IsSuffixOf(exts, suffix(m_files[idx])))
+            names.push_back(m_files[idx].name);
+    }
+    return names;
+}
+
+/******************************************************************************/
+
+struct DirectoryCache::Data {
+    QFileSystemWatcher watcher;
+    QMutex mutex;
+    QHash<QString, QSharedPointer<const DirectoryListing>> listings;
+    QStringList order; // recently used at back
+    auto drop(const QString &path) -> void
+    {
+        QMutexLocker locker(&mutex);
+        listings.remove(path);
+        order.removeOne(path);
+    }
+};
+
+static DirectoryCache *s_cache = nullptr;
+
+DirectoryCache::DirectoryCache()
+    : d(new Data)
+{
+    auto drop = [=] (const QString &path) {
+        d->drop(path);
+        d->watcher.removePath(path);
+    };
+    connect(&d->watcher, &QFileSystemWatcher::directoryChanged, this, drop);
+}
+
+DirectoryCache::~DirectoryCache()
+{
+    s_cache = nullptr;
+    delete d;
+}
+
+auto DirectoryCache::initialize() -> void
+{
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    if (!s_cache)
+        s_cache = new DirectoryCache;
+    s_cache->setParent(qApp);
+}
+
+auto DirectoryCache::get(const QString &path) -> QSharedPointer<const DirectoryListing>
+{
+    using Ptr = QSharedPointer<const DirectoryListing>;
+    if (!s_cache)
+        return Ptr(new DirectoryListing(path));
+    auto d = s_cache->d;
+    const auto key = QDir(path).absolutePath();
+    d->mutex.lock();
+    auto it = d->listings.constFind(key);
+    if (it != d->listings.cend()) {
+        auto listing = *it;
+        d->order.removeOne(key);
+        d->order.push_back(key);
+        d->mutex.unlock();
+        return listing;
+    }
+    d->mutex.unlock();
+
+    Ptr listing(new DirectoryListing(key));
+    if (!listing->exists())
+        return listing;
+    QStringList evicts;
+    d->mutex.lock();
+    d->listings[key] = listing;
+    d->order.removeOne(key);
+    d->order.push_back(key);
+    while (d->order.size() > MaxDirectories) {
+        evicts.push_back(d->order.takeFirst());
+        d->listings.remove(evicts.back());
+    }
+    d->mutex.unlock();
+    // watcher lives in main thread
+    _PostEvent(s_cache, Watch, key, evicts);
+    return listing;
+}
+
+auto DirectoryCache::customEvent(QEvent *event) -> void
+{
+    if (event->type() != static_cast<QEvent::Type>(Watch))
+        return;
+    QString path; QStringList evicts;
+    _TakeData(event, path, evicts);
+    if (!evicts.isEmpty())
+        d->watcher.removePaths(evicts);
+    if (!d->watcher.directories().contains(path))
+        d->watcher.addPath(path);
+    // changed before watching started
+    QMutexLocker locker(&d->mutex);
+    auto it = d->listings.constFind(path);
+    if (it != d->listings.cend()
+            && (*it)->lastModified() != QFileInfo(path).lastModified()) {
+        locker.unlock();
+        d->drop(path);
+    }
+}
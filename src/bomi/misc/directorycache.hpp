@@ -0,0 +1,48 @@
+#ifndef DIRECTORYCACHE_HPP
+#define DIRECTORYCACHE_HPP
+
+// names in one directory with index of complete base names
+class DirectoryListing {
+public:
+    DirectoryListing(const QString &path);
+    auto path() const -> const QString& { return m_path; }
+    auto exists() const -> bool { return m_exists; }
+    auto lastModified() const -> const QDateTime& { return m_modified; }
+    // sub directory names sorted by name
+    auto dirs() const -> const QStringList& { return m_dirs; }
+    // file names with suffix of exts sorted by name
+    auto files(ExtTypes exts) const -> QStringList;
+    // same as above but complete base name should be base
+    auto matched(const QString &base, ExtTypes exts) const -> QStringList;
+    auto filePath(const QString &name) const -> QString
+        { return m_path % '/'_q % name; }
+private:
+    struct Entry { QString name; int dot; };
+    auto suffix(const Entry &e) const -> QString
+        { return e.dot < 0 ? QString() : e.name.mid(e.dot + 1); }
+    QString m_path;
+    QStringList m_dirs;
+    QVector<Entry> m_files;
+    QHash<QString, QVector<int>> m_bases;
+    QDateTime m_modified;
+    bool m_exists = false;
+};
+
+// listings shared by autoloader and playlist generation
+// entries are dropped when QFileSystemWatcher reports changes
+class DirectoryCache : public QObject {
+public:
+    static constexpr int MaxDirectories = 64;
+    ~DirectoryCache();
+    // create shared instance, should be called in main thread
+    static auto initialize() -> void;
+    // thread-safe, scans without caching if not initialized
+    static auto get(const QString &path) -> QSharedPointer<const DirectoryListing>;
+private:
+    DirectoryCache();
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // DIRECTORYCACHE_HPP
@@ -5,6 +5,13 @@
 
 DECLARE_LOG_CONTEXT(Downloader)
 
+static constexpr qint64 MinSegmentBytes = 1 << 20;
+static constexpr qint64 ReadChunk = 64 << 10;
+static constexpr int TickInterval = 100;
+static constexpr int SaveInterval = 1000;
+// request which reaches prioritized position within this keeps going
+static constexpr qint64 NearBytes = 2 << 20;
+
 static auto sufficesForMimeType(const QString &type) -> QStringList
 {
     if (type.isEmpty())
@@ -22,6 +29,14 @@ static auto sufficesForMimeType(const QString &type) -> QStringList
     return mime.suffixes();
 }
 
+// [begin, end) of file, end < 0 if length is unknown
+struct Segment {
+    qint64 begin = 0, end = -1, pos = 0;
+    QNetworkReply *reply = nullptr;
+    bool partial = false; // requested with range
+    auto isDone() const -> bool { return end >= 0 && pos >= end; }
+};
+
 struct Downloader::Data {
     Downloader *p = nullptr;
     QUrl url;
@@ -30,8 +45,297 @@ struct Downloader::Data {
     QByteArray data;
     qint64 written = -1, total = -1;
     qreal rate = -1.0;
-    QNetworkReply *reply = nullptr;
     QStringList suffices;
+
+    QVector<Segment> segments;
+    QString file, contentType;
+    QFile out;
+    // ETag or Last-Modified for If-Range, empty if ranges cannot be used
+    QByteArray validator;
+    bool ranged = false, sized = false, restarted = false;
+    int connections = 4;
+    qint64 limit = 0, budget = 0, priority = 0;
+    QTimer ticker, saver;
+
+    auto stateFile() const -> QString { return file % ".state"_a; }
+    auto release(Segment &seg) -> void
+    {
+        if (!seg.reply)
+            return;
+        seg.reply->disconnect(p);
+        if (seg.reply->isRunning())
+            seg.reply->abort();
+        seg.reply->deleteLater();
+        seg.reply = nullptr;
+    }
+    auto releaseAll() -> void
+    {
+        for (auto &seg : segments)
+            release(seg);
+        ticker.stop();
+        saver.stop();
+    }
+    auto request(int i) -> void
+    {
+        auto &seg = segments[i];
+        QNetworkRequest req(url);
+        seg.partial = seg.end >= 0 && (seg.pos > 0 || seg.end < total);
+        if (seg.partial) {
+            req.setRawHeader("Range", "bytes=" + QByteArray::number(seg.pos)
+                             + '-' + QByteArray::number(seg.end - 1));
+            if (!validator.isEmpty())
+                req.setRawHeader("If-Range", validator);
+        }
+        seg.reply = nam->get(req);
+        // keep data in socket for throttling
+        if (limit > 0)
+            seg.reply->setReadBufferSize(ReadChunk);
+        auto reply = seg.reply;
+        connect(reply, &QNetworkReply::metaDataChanged,
+                p, [=] () { if (segments[i].reply == reply) checkHeader(i); });
+        connect(reply, &QNetworkReply::readyRead, p, [=] () { pump(); });
+        connect(reply, &QNetworkReply::finished, p, [=] () { pump(); });
+    }
+    // distance from priority, parts behind it come last
+    auto distance(const Segment &seg) const -> qint64
+        { return seg.pos >= priority ? seg.pos - priority : total + seg.pos; }
+    // keep requests up to connections for parts nearest to priority
+    auto schedule() -> void
+    {
+        for (;;) {
+            int active = 0, next = -1;
+            for (int i = 0; i < segments.size(); ++i) {
+                if (segments[i].reply)
+                    ++active;
+                else if (!segments[i].isDone()
+                         && (next < 0 || distance(segments[i]) < distance(segments[next])))
+                    next = i;
+            }
+            if (next < 0)
+                return;
+            if (active >= connections) {
+                // pause farthest one unless it is nearer than waiting one
+                int far = -1;
+                for (int i = 0; i < segments.size(); ++i) {
+                    if (segments[i].reply && (far < 0 || distance(segments[i]) > distance(segments[far])))
+                        far = i;
+                }
+                if (distance(segments[far]) <= distance(segments[next]))
+                    return;
+                release(segments[far]);
+            }
+            request(next);
+        }
+    }
+    auto checkHeader(int i) -> void
+    {
+        auto reply = segments[i].reply;
+        const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (segments[i].partial) {
+            // content changed or range ignored, so all parts are invalid
+            if (status != 206)
+                restart();
+            return;
+        }
+        contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
+        const auto length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        if (status != 200 || length <= 0 || segments.size() > 1)
+            return;
+        total = length;
+        segments[0].end = length;
+        ranged = reply->rawHeader("Accept-Ranges") == "bytes";
+        validator = reply->rawHeader("ETag");
+        if (validator.isEmpty())
+            validator = reply->rawHeader("Last-Modified");
+        if (!ranged)
+            validator.clear();
+        if (out.isOpen())
+            out.resize(length);
+        const int count = qMin<qint64>(connections, length / MinSegmentBytes);
+        if (!ranged || count < 2)
+            return;
+        // first reply keeps going for the first part and others are split
+        if (!out.isOpen()) {
+            data.resize(length);
+            sized = true;
+        }
+        const qint64 size = length / count;
+        segments[0].end = size;
+        for (int j = 1; j < count; ++j) {
+            Segment seg;
+            seg.begin = seg.pos = j * size;
+            seg.end = j == count - 1 ? length : (j + 1) * size;
+            segments.push_back(seg);
+            request(j);
+        }
+        _Debug("Download %% in %% parts.", url, count);
+    }
+    auto write(Segment &seg, const QByteArray &bytes) -> void
+    {
+        if (out.isOpen()) {
+            out.seek(seg.pos);
+            out.write(bytes);
+        } else if (sized)
+            memcpy(data.data() + seg.pos, bytes.constData(), bytes.size());
+        else
+            data.append(bytes);
+        seg.pos += bytes.size();
+        written += bytes.size();
+    }
+    auto pump() -> void
+    {
+        if (!running)
+            return;
+        for (auto &seg : segments) {
+            if (!seg.reply)
+                continue;
+            while (seg.reply->bytesAvailable() > 0 && !seg.isDone()) {
+                qint64 n = qMin(seg.reply->bytesAvailable(), ReadChunk);
+                if (seg.end >= 0)
+                    n = qMin(n, seg.end - seg.pos);
+                if (limit > 0) {
+                    if (budget <= 0)
+                        break;
+                    n = qMin(n, budget);
+                    budget -= n;
+                }
+                write(seg, seg.reply->read(n));
+            }
+            if (seg.isDone())
+                release(seg);
+            else if (seg.reply->isFinished() && !seg.reply->bytesAvailable()) {
+                const auto error = seg.reply->error();
+                release(seg);
+                if (error != QNetworkReply::NoError || seg.end >= 0) {
+                    _Error("Failed to download %%: %%", url, error);
+                    return fail();
+                }
+                seg.end = total = seg.pos; // length was unknown
+            }
+        }
+        // readers of file see only flushed data
+        if (out.isOpen())
+            out.flush();
+        p->progress(written, total);
+        if (std::all_of(segments.begin(), segments.end(),
+                        [] (const Segment &seg) { return seg.isDone(); }))
+            finish();
+        else if (ranged)
+            schedule();
+    }
+    auto restart() -> void
+    {
+        releaseAll();
+        if (restarted)
+            return fail();
+        _Info("Restart download of %% from beginning.", url);
+        restarted = true;
+        reset();
+        start();
+    }
+    auto reset() -> void
+    {
+        segments = { Segment() };
+        data.clear();
+        validator.clear();
+        ranged = sized = false;
+        written = 0;
+        total = -1;
+        if (out.isOpen())
+            out.resize(0);
+    }
+    auto start() -> void
+    {
+        priority = 0;
+        if (ranged)
+            schedule();
+        else {
+            for (int i = 0; i < segments.size(); ++i) {
+                if (!segments[i].isDone())
+                    request(i);
+            }
+        }
+        if (limit > 0) {
+            budget = limit * TickInterval / 1000;
+            ticker.start();
+        }
+        if (out.isOpen())
+            saver.start();
+    }
+    auto saveState() -> void
+    {
+        if (!out.isOpen() || !ranged || total <= 0)
+            return;
+        QJsonArray parts;
+        for (auto &seg : segments) {
+            QJsonArray part;
+            part.push_back(seg.begin);
+            part.push_back(seg.end);
+            part.push_back(seg.pos);
+            parts.push_back(part);
+        }
+        QJsonObject json;
+        json[u"url"_q] = url.toString();
+        json[u"total"_q] = total;
+        json[u"validator"_q] = QString::fromLatin1(validator);
+        json[u"content-type"_q] = contentType;
+        json[u"segments"_q] = parts;
+        out.flush();
+        QFile state(stateFile());
+        if (state.open(QFile::WriteOnly | QFile::Truncate))
+            state.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    }
+    auto loadState() -> bool
+    {
+        QFile state(stateFile());
+        if (!state.open(QFile::ReadOnly))
+            return false;
+        const auto json = QJsonDocument::fromJson(state.readAll()).object();
+        total = json[u"total"_q].toDouble(-1);
+        if (json[u"url"_q].toString() != url.toString() || total <= 0
+                || out.size() != total)
+            return false;
+        segments.clear();
+        written = 0;
+        for (auto v : json[u"segments"_q].toArray()) {
+            const auto part = v.toArray();
+            Segment seg;
+            seg.begin = part.at(0).toDouble();
+            seg.end = part.at(1).toDouble();
+            seg.pos = part.at(2).toDouble();
+            if (seg.begin < 0 || seg.end > total || seg.pos < seg.begin || seg.pos > seg.end)
+                return false;
+            written += seg.pos - seg.begin;
+            segments.push_back(seg);
+        }
+        validator = json[u"validator"_q].toString().toLatin1();
+        contentType = json[u"content-type"_q].toString();
+        ranged = true;
+        return !segments.isEmpty();
+    }
+    auto finish() -> void
+    {
+        releaseAll();
+        if (out.isOpen()) {
+            out.close();
+            QFile::remove(stateFile());
+        }
+        if (suffices.isEmpty())
+            suffices = sufficesForMimeType(contentType);
+        running = false;
+        emit p->finished();
+        emit p->runningChanged();
+    }
+    auto fail() -> void
+    {
+        saveState();
+        releaseAll();
+        out.close();
+        data.clear();
+        running = false;
+        emit p->finished();
+        emit p->runningChanged();
+    }
 };
 
 Downloader::Downloader(QObject *parent)
@@ -40,11 +344,18 @@ Downloader::Downloader(QObject *parent)
 {
     d->p = this;
     d->nam = new QNetworkAccessManager;
+    d->ticker.setInterval(TickInterval);
+    connect(&d->ticker, &QTimer::timeout, this, [=] () {
+        d->budget = d->limit * TickInterval / 1000;
+        d->pump();
+    });
+    d->saver.setInterval(SaveInterval);
+    connect(&d->saver, &QTimer::timeout, this, [=] () { d->saveState(); });
 }
 
 Downloader::~Downloader()
 {
-    if (d->reply)
+    if (d->running)
         cancel();
     delete d->nam;
     delete d;
@@ -65,13 +376,80 @@ auto Downloader::isCanceled() const -> bool
     return d->canceled;
 }
 
+auto Downloader::setFile(const QString &file) -> void
+{
+    if (!d->running)
+        d->file = file;
+}
+
+auto Downloader::file() const -> QString
+{
+    return d->file;
+}
+
+auto Downloader::setConnections(int count) -> void
+{
+    d->connections = qBound(1, count, 16);
+}
+
+auto Downloader::setBandwidthLimit(qint64 bytes) -> void
+{
+    d->limit = qMax<qint64>(0, bytes);
+    if (!d->running)
+        return;
+    for (auto &seg : d->segments) {
+        if (seg.reply)
+            seg.reply->setReadBufferSize(d->limit > 0 ? ReadChunk : 0);
+    }
+    if (d->limit > 0)
+        d->ticker.start();
+    else {
+        d->ticker.stop();
+        d->pump();
+    }
+}
+
+auto Downloader::available(qint64 pos) const -> qint64
+{
+    for (auto &seg : d->segments) {
+        if (seg.begin <= pos && pos < seg.pos)
+            return seg.pos - pos;
+    }
+    return 0;
+}
+
+auto Downloader::prioritize(qint64 pos) -> void
+{
+    if (!d->running || !d->ranged || d->total <= 0 || !d->out.isOpen())
+        return;
+    d->priority = qBound<qint64>(0, pos, d->total);
+    for (int i = 0; i < d->segments.size(); ++i) {
+        auto &seg = d->segments[i];
+        if (pos < seg.begin || pos >= seg.end)
+            continue;
+        if (pos < seg.pos || (seg.reply && pos - seg.pos < NearBytes))
+            break;
+        // rest of this part becomes new part which starts at pos
+        Segment tail;
+        tail.begin = tail.pos = pos;
+        tail.end = seg.end;
+        seg.end = pos;
+        if (seg.isDone())
+            d->release(seg);
+        d->segments.push_back(tail);
+        _Debug("Download %% from %% bytes first.", d->url, pos);
+        break;
+    }
+    d->schedule();
+}
+
 auto Downloader::cancel() -> void
 {
-    if (d->reply) {
+    if (d->running) {
         d->canceled = true;
-        d->reply->abort();
-        if (d->reply)
-            _Delete(d->reply);
+        d->saveState();
+        d->releaseAll();
+        d->out.close();
         if (_Change(d->running, false))
             emit runningChanged();
         emit canceledChanged();
@@ -123,24 +501,26 @@ auto Downloader::start(const QUrl &url, const QStringList &extFilter) -> bool
             return false;
     }
 
+    d->restarted = false;
+    d->contentType.clear();
+    if (!d->file.isEmpty()) {
+        d->out.setFileName(d->file);
+        if (!d->out.open(QFile::ReadWrite)) {
+            _Error("Cannot open %% to download %%", d->file, url);
+            return false;
+        }
+    }
     d->running = true;
     emit started();
     emit runningChanged();
     progress(-1, -1);
 
-    d->reply = d->nam->get(QNetworkRequest(url));
-    connect(d->reply, &QNetworkReply::downloadProgress,
-            this, &Downloader::progress);
-    connect(d->reply, &QNetworkReply::finished, [this] () {
-        d->data = d->reply->readAll();
-        if (d->suffices.isEmpty())
-            d->suffices = sufficesForMimeType(d->reply->header(QNetworkRequest::ContentTypeHeader).toString());
-        d->running = false;
-        emit finished();
-        emit runningChanged();
-        d->reply->deleteLater();
-        d->reply = nullptr;
-    });
+    d->data.clear();
+    if (d->out.isOpen() && d->loadState())
+        _Info("Resume download of %% from %% bytes.", url, d->written);
+    else
+        d->reset();
+    d->start();
     return true;
 }
 
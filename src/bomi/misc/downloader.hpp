@@ -23,6 +23,18 @@ public:
     auto writtenSize() const -> qint64;
     auto rate() const -> qreal;
     auto isCanceled() const -> bool;
+    // write to file instead of memory and resume from its state file if any
+    auto setFile(const QString &file) -> void;
+    auto file() const -> QString;
+    // parallel range requests for large file when server accepts them
+    auto setConnections(int count) -> void;
+    // bytes per second, 0 for unlimited
+    auto setBandwidthLimit(qint64 bytes) -> void;
+    // bytes written in a row from pos, flushed to file already
+    auto available(qint64 pos) const -> qint64;
+    // fetch from pos first, parts start in order from there
+    // it has effect only on file whose server accepts ranges
+    auto prioritize(qint64 pos) -> void;
     Q_INVOKABLE void cancel();
 signals:
     void writtenSizeChanged(qint64 writtenSize);
@@ -0,0 +1,276 @@
+#include "downloadserver.hpp"
+#include "downloader.hpp"
+#include "misc/log.hpp"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QCryptographicHash>
+
+DECLARE_LOG_CONTEXT(Downloader)
+
+static constexpr qint64 SendChunk = 256 << 10;
+// kept in socket at most, the rest waits in file
+static constexpr qint64 SendBuffer = 1 << 20;
+static constexpr int HeaderMax = 16 << 10;
+// downloaded files kept in cache, oldest ones go first
+static constexpr int DiskMax = 4;
+
+struct Client {
+    QTcpSocket *socket = nullptr;
+    QByteArray request, id;
+    qint64 pos = 0;
+    bool ranged = false, responded = false;
+    QFile in;
+};
+
+struct DownloadServer::Data {
+    DownloadServer *p = nullptr;
+    QTcpServer server;
+    QString folder;
+    // written in any thread by url()
+    mutable QMutex mutex;
+    QHash<QByteArray, QString> remotes;
+    int port = 0;
+    // gui thread only
+    QByteArray id;
+    Downloader *downloader = nullptr;
+    QList<Client*> clients;
+
+    auto file(const QByteArray &id) const -> QString { return folder % '/'_q % _L(id); }
+    auto prune() -> void
+    {
+        QDir dir(folder);
+        const auto files = dir.entryInfoList({ u"*"_q }, QDir::Files, QDir::Time);
+        int kept = 0;
+        for (auto &info : files) {
+            if (info.suffix() == "state"_a)
+                continue;
+            if (++kept > DiskMax) {
+                dir.remove(info.fileName());
+                dir.remove(info.fileName() % ".state"_a);
+            }
+        }
+    }
+    auto drop(Client *c) -> void
+    {
+        clients.removeOne(c);
+        c->socket->disconnect(p);
+        c->socket->deleteLater();
+        delete c;
+    }
+    auto reply(Client *c, const QByteArray &status) -> void
+    {
+        c->responded = true;
+        c->socket->write("HTTP/1.1 " + status + "\r\nConnection: close\r\n\r\n");
+        c->socket->disconnectFromHost();
+    }
+    auto cancel() -> void
+    {
+        // clients are dropped while walking, so copy is walked
+        const auto list = clients;
+        for (auto c : list)
+            drop(c);
+        if (downloader) {
+            // state file lets same file resume next time
+            downloader->cancel();
+            downloader->deleteLater();
+            downloader = nullptr;
+        }
+        id.clear();
+    }
+    auto open(const QByteArray &id) -> bool
+    {
+        if (downloader && this->id == id)
+            return true;
+        mutex.lock();
+        const auto remote = remotes.value(id);
+        mutex.unlock();
+        if (remote.isEmpty())
+            return false;
+        // one download at a time, clients of others go with it
+        const auto list = clients;
+        for (auto c : list) {
+            if (c->id != id)
+                drop(c);
+        }
+        if (downloader) {
+            downloader->cancel();
+            downloader->deleteLater();
+        }
+        this->id = id;
+        downloader = new Downloader(p);
+        downloader->setFile(file(id));
+        connect(downloader, &Downloader::progressed, p, [=] () { update(); });
+        connect(downloader, &Downloader::finished, p, [=] () { update(); });
+        if (!downloader->start(QUrl(remote))) {
+            _Error("Cannot start download of %% for playback.", remote);
+            downloader->deleteLater();
+            downloader = nullptr;
+            this->id.clear();
+            return false;
+        }
+        prune();
+        _Info("Play %% while downloading into %%.", remote, file(id));
+        return true;
+    }
+    auto parse(Client *c) -> void
+    {
+        c->request += c->socket->readAll();
+        const int end = c->request.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (c->request.size() > HeaderMax)
+                reply(c, "431 Request Header Fields Too Large"_b);
+            return;
+        }
+        const auto lines = c->request.left(end).split('\n');
+        const auto request = lines.first().trimmed().split(' ');
+        if (request.size() < 2 || request[0] != "GET") {
+            reply(c, "405 Method Not Allowed"_b);
+            return;
+        }
+        c->id = request[1].mid(1);
+        for (int i = 1; i < lines.size(); ++i) {
+            const auto line = lines[i].trimmed();
+            const int colon = line.indexOf(':');
+            if (colon < 0 || line.left(colon).trimmed().toLower() != "range")
+                continue;
+            const auto value = line.mid(colon + 1).trimmed();
+            if (value.startsWith("bytes=")) {
+                c->pos = value.mid(6).split('-').value(0).toLongLong();
+                c->ranged = true;
+            }
+        }
+        c->request.clear();
+        if (!open(c->id)) {
+            reply(c, "404 Not Found"_b);
+            return;
+        }
+        downloader->prioritize(c->pos);
+        respond(c);
+    }
+    // header waits for length or first data of unknown length
+    auto respond(Client *c) -> void
+    {
+        const qint64 total = downloader->totalSize();
+        if (total < 0 && downloader->isRunning() && !downloader->available(0))
+            return;
+        if (total < 0 && (!downloader->isRunning() || c->pos > 0)) {
+            // failed, or cannot seek in stream of unknown length
+            reply(c, "404 Not Found"_b);
+            return;
+        }
+        if (total >= 0 && c->pos >= total && c->pos > 0) {
+            reply(c, "416 Range Not Satisfiable\r\nContent-Range: bytes */"_b + QByteArray::number(total));
+            return;
+        }
+        c->in.setFileName(file(c->id));
+        if (!c->in.open(QFile::ReadOnly)) {
+            reply(c, "500 Internal Server Error"_b);
+            return;
+        }
+        QByteArray header = c->ranged && total >= 0 ? "HTTP/1.1 206 Partial Content\r\n"_b
+                                                     : "HTTP/1.1 200 OK\r\n"_b;
+        header += "Content-Type: application/octet-stream\r\nConnection: close\r\n";
+        if (total >= 0) {
+            header += "Accept-Ranges: bytes\r\nContent-Length: " + QByteArray::number(total - c->pos) + "\r\n";
+            if (c->ranged)
+                header += "Content-Range: bytes " + QByteArray::number(c->pos) + '-'
+                        + QByteArray::number(total - 1) + '/' + QByteArray::number(total) + "\r\n";
+        }
+        c->socket->write(header + "\r\n");
+        c->responded = true;
+        send(c);
+    }
+    auto send(Client *c) -> void
+    {
+        while (c->socket->bytesToWrite() < SendBuffer) {
+            const qint64 n = qMin(downloader->available(c->pos), SendChunk);
+            if (n <= 0)
+                break;
+            c->in.seek(c->pos);
+            const auto bytes = c->in.read(n);
+            if (bytes.isEmpty())
+                break;
+            c->socket->write(bytes);
+            c->pos += bytes.size();
+        }
+        const qint64 total = downloader->totalSize();
+        if ((total >= 0 && c->pos >= total) || !downloader->isRunning()) {
+            if (!downloader->available(c->pos))
+                c->socket->disconnectFromHost();
+        }
+    }
+    auto update() -> void
+    {
+        const auto list = clients;
+        for (auto c : list) {
+            if (c->id != id || c->socket->state() != QTcpSocket::ConnectedState)
+                continue;
+            if (!c->responded)
+                respond(c);
+            else
+                send(c);
+        }
+    }
+};
+
+DownloadServer::DownloadServer(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    d->p = this;
+    d->folder = _WritablePath(Location::Cache) % "/download"_a;
+    connect(&d->server, &QTcpServer::newConnection, this, [=] () {
+        while (auto socket = d->server.nextPendingConnection()) {
+            auto c = new Client;
+            c->socket = socket;
+            d->clients.push_back(c);
+            connect(socket, &QTcpSocket::readyRead, this, [=] () {
+                if (!c->responded && c->request.size() <= HeaderMax)
+                    d->parse(c);
+            });
+            connect(socket, &QTcpSocket::bytesWritten, this, [=] () {
+                if (c->responded && c->in.isOpen() && c->id == d->id)
+                    d->send(c);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [=] () { d->drop(c); });
+        }
+    });
+}
+
+DownloadServer::~DownloadServer()
+{
+    setEnabled(false);
+    delete d;
+}
+
+auto DownloadServer::isEnabled() const -> bool
+{
+    return d->server.isListening();
+}
+
+auto DownloadServer::setEnabled(bool enabled) -> void
+{
+    if (enabled == d->server.isListening())
+        return;
+    if (enabled) {
+        QDir().mkpath(d->folder);
+        if (!d->server.listen(QHostAddress::LocalHost))
+            _Error("Cannot listen for playback while downloading: %%", d->server.errorString());
+    } else {
+        d->cancel();
+        d->server.close();
+    }
+    QMutexLocker locker(&d->mutex);
+    d->port = d->server.isListening() ? d->server.serverPort() : 0;
+    if (!d->port)
+        d->remotes.clear();
+}
+
+auto DownloadServer::url(const QString &remote) -> QString
+{
+    QMutexLocker locker(&d->mutex);
+    if (!d->port)
+        return QString();
+    const auto id = QCryptographicHash::hash(remote.toUtf8(), QCryptographicHash::Sha1).toHex();
+    d->remotes[id] = remote;
+    return "http://127.0.0.1:"_a % _N(d->port) % '/'_q % _L(id);
+}
@@ -0,0 +1,21 @@
+#ifndef DOWNLOADSERVER_HPP
+#define DOWNLOADSERVER_HPP
+
+// serves remote files to mpv over local http while Downloader writes them
+// to cache, so that playback starts long before download is done
+// reads of parts not downloaded yet wait, and seeks move download there
+class DownloadServer : public QObject {
+    Q_OBJECT
+public:
+    DownloadServer(QObject *parent = nullptr);
+    ~DownloadServer();
+    auto setEnabled(bool enabled) -> void;
+    auto isEnabled() const -> bool;
+    // local url for remote one, empty if disabled, callable from any thread
+    auto url(const QString &remote) -> QString;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // DOWNLOADSERVER_HPP
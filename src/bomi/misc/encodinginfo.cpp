@@ -3,6 +3,14 @@
 #include "misc/log.hpp"
 #include "misc/charsetdetector.hpp"
 
+#if defined(__SSE2__)
+#define UTF8_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define UTF8_NEON 1
+#include <arm_neon.h>
+#endif
+
 auto operator << (QDataStream &out, const EncodingInfo &e) -> QDataStream&
 {
     out << e.mib(); return out;
@@ -35,6 +43,118 @@ EncodingInfo::~EncodingInfo()
 
 }
 
+static constexpr int Utf8Mib = 106;
+
+// skips ascii bytes, 16 at once where no byte has its high bit
+static auto skipAscii(const uchar *p, const uchar *end) -> const uchar*
+{
+#if UTF8_SSE2
+    for (; end - p >= 16; p += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)))
+            break;
+    }
+#elif UTF8_NEON
+    for (; end - p >= 16; p += 16) {
+        const uint8x16_t v = vld1q_u8(p);
+        const uint8x8_t high = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+        if (vget_lane_u64(vreinterpret_u64_u8(high), 0) & 0x8080808080808080ull)
+            break;
+    }
+#else
+    for (; end - p >= 8; p += 8) {
+        quint64 word; memcpy(&word, p, 8);
+        if (word & 0x8080808080808080ull)
+            break;
+    }
+#endif
+    while (p < end && *p < 0x80)
+        ++p;
+    return p;
+}
+
+// rejects overlong forms, surrogates and code points beyond U+10FFFF
+static auto isUtf8(const uchar *p, const uchar *end, bool partial) -> bool
+{
+    while ((p = skipAscii(p, end)) < end) {
+        const uchar c = *p++;
+        int trails = 0; uchar lo = 0x80, hi = 0xbf;
+        if (0xc2 <= c && c <= 0xdf)
+            trails = 1;
+        else if (0xe0 <= c && c <= 0xef) {
+            trails = 2;
+            if (c == 0xe0)
+                lo = 0xa0;
+            else if (c == 0xed)
+                hi = 0x9f;
+        } else if (0xf0 <= c && c <= 0xf4) {
+            trails = 3;
+            if (c == 0xf0)
+                lo = 0x90;
+            else if (c == 0xf4)
+                hi = 0x8f;
+        } else
+            return false;
+        for (; trails > 0; --trails, ++p) {
+            if (p >= end)
+                return partial;
+            if (*p < lo || *p > hi)
+                return false;
+            lo = 0x80; hi = 0xbf;
+        }
+    }
+    return true;
+}
+
+auto EncodingInfo::fromBom(const char *data, qint64 size, int *bom) -> EncodingInfo
+{
+    const auto p = reinterpret_cast<const uchar*>(data);
+    auto is = [&] (std::initializer_list<uchar> mark) {
+        if (size < (qint64)mark.size() || !std::equal(mark.begin(), mark.end(), p))
+            return false;
+        if (bom)
+            *bom = mark.size();
+        return true;
+    };
+    if (bom)
+        *bom = 0;
+    if (is({ 0xef, 0xbb, 0xbf }))
+        return fromMib(Utf8Mib);
+    // utf-32le first, its mark starts with that of utf-16le
+    if (is({ 0xff, 0xfe, 0x00, 0x00 }))
+        return fromMib(1019);
+    if (is({ 0x00, 0x00, 0xfe, 0xff }))
+        return fromMib(1018);
+    if (is({ 0xff, 0xfe }))
+        return fromMib(1014);
+    if (is({ 0xfe, 0xff }))
+        return fromMib(1013);
+    return EncodingInfo();
+}
+
+auto EncodingInfo::sniff(const char *data, qint64 size, bool partial) -> EncodingInfo
+{
+    int bom = 0;
+    const auto enc = fromBom(data, size, &bom);
+    if (enc.isValid() && enc.mib() != Utf8Mib)
+        return enc;
+    const auto p = reinterpret_cast<const uchar*>(data);
+    return isUtf8(p + bom, p + size, partial) ? fromMib(Utf8Mib) : EncodingInfo();
+}
+
+auto EncodingInfo::decode(const char *data, int size) const -> QString
+{
+    int bom = 0;
+    auto enc = fromBom(data, size, &bom);
+    if (!enc.isValid())
+        enc = *this;
+    if (enc.mib() == Utf8Mib)
+        return QString::fromUtf8(data + bom, size - bom);
+    auto codec = enc.codec();
+    if (!codec)
+        codec = QTextCodec::codecForLocale();
+    return codec->toUnicode(data, size);
+}
+
 auto EncodingInfo::detect(Category c, const QByteArray &data) -> EncodingInfo
 {
     return detect(c, default_(c), data);
@@ -50,6 +170,9 @@ auto EncodingInfo::detect(Category c, const EncodingInfo &fb, const QByteArray &
     const auto conf = _confidence(c);
     if (conf < 0 && fb.isValid())
         return fb;
+    const auto sniffed = sniff(data.constData(), data.size());
+    if (sniffed.isValid())
+        return sniffed;
     const auto ret = CharsetDetector::detect(data, conf);
     return (!fb.isValid() || ret.isValid()) ? ret : fb;
 }
@@ -59,6 +182,23 @@ auto EncodingInfo::detect(Category c, const EncodingInfo &fb, const QString &fil
     const auto conf = _confidence(c);
     if (conf < 0 && fb.isValid())
         return fb;
+    // most files are utf-8 or ascii, which needs no statistics
+    QFile file(fileName);
+    if (file.open(QFile::ReadOnly)) {
+        const auto size = length < 0 ? file.size() : qMin<qint64>(length, file.size());
+        EncodingInfo sniffed;
+        if (auto mapped = size > 0 ? file.map(0, size) : nullptr) {
+            sniffed = sniff(reinterpret_cast<const char*>(mapped), size, size < file.size());
+            file.unmap(mapped);
+        } else {
+            const auto data = file.read(size);
+            sniffed = sniff(data.constData(), data.size(), data.size() < file.size());
+        }
+        if (sniffed.isValid()) {
+            _Debug("Encoding sniffed: %% for %%", sniffed.name(), fileName);
+            return sniffed;
+        }
+    }
     const auto ret = CharsetDetector::detect(fileName, conf, length);
     return (!fb.isValid() || ret.isValid()) ? ret : fb;
 }
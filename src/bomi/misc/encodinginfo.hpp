@@ -26,6 +26,14 @@ public:
     static auto detect(Category c, const QString &file, int length =  1024*500) -> EncodingInfo;
     static auto detect(Category c, const EncodingInfo &fb, const QByteArray &data) -> EncodingInfo;
     static auto detect(Category c, const EncodingInfo &fb, const QString &file, int length =  1024*500) -> EncodingInfo;
+    // unicode encoding by byte order mark, length of the mark is stored in bom
+    static auto fromBom(const char *data, qint64 size, int *bom = nullptr) -> EncodingInfo;
+    // encoding by byte order mark or utf-8 if data is valid utf-8, which
+    // covers plain ascii, invalid otherwise
+    // partial accepts a sequence cut at end of data read from longer file
+    static auto sniff(const char *data, qint64 size, bool partial = false) -> EncodingInfo;
+    // byte order mark wins like QTextStream, locale is used when invalid
+    auto decode(const char *data, int size) const -> QString;
     static auto utf8() -> EncodingInfo { return EncodingInfo::fromMib(106); }
     static auto fromMib(int mib) -> EncodingInfo;
     static auto fromName(const QString &name) -> EncodingInfo;
@@ -0,0 +1,155 @@
+#include "folderscanner.hpp"
+#include "misc/dataevent.hpp"
+#include "tmp/algorithm.hpp"
+#include <QThreadPool>
+
+enum EventType { Listed = QEvent::User + 1 };
+
+class FolderListJob : public QRunnable {
+public:
+    FolderListJob(QObject *scanner, int serial, int node, const QString &path,
+                  const QStringList &filters, bool recursive,
+                  const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_scanner(scanner), m_serial(serial), m_node(node), m_path(path)
+        , m_filters(filters), m_recursive(recursive), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        if (*m_cancel)
+            return;
+        const QDir dir(m_path);
+        auto files = dir.entryInfoList(m_filters, QDir::Files);
+        FolderScanner::sort(files);
+        QFileInfoList dirs;
+        if (m_recursive && !*m_cancel) {
+            dirs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+            FolderScanner::sort(dirs);
+        }
+        if (!*m_cancel)
+            _PostEvent(m_scanner, Listed, m_serial, m_node, files, dirs);
+    }
+private:
+    QObject *m_scanner = nullptr;
+    int m_serial = 0, m_node = 0;
+    QString m_path;
+    QStringList m_filters;
+    bool m_recursive = false;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
+struct FolderNode {
+    FolderNode(const QString &path = QString()): path(path) { }
+    QString path;
+    QFileInfoList files;
+    QVector<int> children;
+    bool listed = false;
+};
+
+struct FolderScanner::Data {
+    FolderScanner *p = nullptr;
+    QStringList filters;
+    bool recursive = false;
+    int serial = 0;
+    QSharedPointer<std::atomic<bool>> cancel;
+    std::vector<FolderNode> nodes;
+    // nodes which are not reported yet, next one at back
+    QVector<int> pending;
+    QThreadPool pool;
+    auto list(int node) -> void
+    {
+        pool.start(new FolderListJob(p, serial, node, nodes[node].path,
+                                     filters, recursive, cancel));
+    }
+    // report nodes in depth-first order as far as they are listed
+    auto flush() -> void
+    {
+        QFileInfoList files;
+        while (!pending.isEmpty() && nodes[pending.back()].listed) {
+            auto &node = nodes[pending.back()];
+            pending.pop_back();
+            files += node.files;
+            node.files.clear();
+            for (int i = node.children.size() - 1; i >= 0; --i)
+                pending.push_back(node.children[i]);
+        }
+        if (!files.isEmpty())
+            emit p->found(files);
+        if (pending.isEmpty() && cancel) {
+            cancel.reset();
+            emit p->finished();
+        }
+    }
+};
+
+FolderScanner::FolderScanner(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    d->p = this;
+    d->pool.setMaxThreadCount(4);
+}
+
+FolderScanner::~FolderScanner()
+{
+    stop();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto FolderScanner::setThreadCount(int count) -> void
+{
+    d->pool.setMaxThreadCount(qMax(1, count));
+}
+
+auto FolderScanner::isRunning() const -> bool
+{
+    return !d->cancel.isNull();
+}
+
+auto FolderScanner::start(const QString &folder, ExtTypes exts, bool recursive) -> void
+{
+    stop();
+    d->filters = _ToNameFilter(exts);
+    d->recursive = recursive;
+    d->cancel.reset(new std::atomic<bool>(false));
+    d->nodes.emplace_back(QDir(folder).absolutePath());
+    d->pending.push_back(0);
+    d->list(0);
+}
+
+auto FolderScanner::stop() -> void
+{
+    if (d->cancel)
+        *d->cancel = true;
+    d->cancel.reset();
+    d->pool.clear();
+    ++d->serial;
+    d->nodes.clear();
+    d->pending.clear();
+}
+
+auto FolderScanner::sort(QFileInfoList &list) -> void
+{
+    tmp::sort_by(list, [] (const QFileInfo &info)
+        { return _NaturalSortKey(info.fileName()); });
+}
+
+auto FolderScanner::customEvent(QEvent *event) -> void
+{
+    if (event->type() != static_cast<QEvent::Type>(Listed))
+        return;
+    int serial = 0, node = 0; QFileInfoList files, dirs;
+    _TakeData(event, serial, node, files, dirs);
+    if (serial != d->serial)
+        return;
+    QVector<int> children;
+    children.reserve(dirs.size());
+    for (auto &dir : dirs) {
+        children.push_back(d->nodes.size());
+        d->nodes.emplace_back(dir.absoluteFilePath());
+        d->list(children.back());
+    }
+    auto &n = d->nodes[node];
+    n.files = files;
+    n.children = children;
+    n.listed = true;
+    d->flush();
+}
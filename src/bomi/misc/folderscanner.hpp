@@ -0,0 +1,27 @@
+#ifndef FOLDERSCANNER_HPP
+#define FOLDERSCANNER_HPP
+
+// lists media files of folder in background and reports them in batches
+// files are in natural order of names and sub folders come after files
+// recursive scan lists sub folders in parallel but still reports in order
+class FolderScanner : public QObject {
+    Q_OBJECT
+public:
+    FolderScanner(QObject *parent = nullptr);
+    ~FolderScanner();
+    auto start(const QString &folder, ExtTypes exts, bool recursive = false) -> void;
+    auto stop() -> void;
+    auto isRunning() const -> bool;
+    // number of folders listed at once, which helps on network storage
+    auto setThreadCount(int count) -> void;
+    static auto sort(QFileInfoList &list) -> void;
+signals:
+    void found(const QFileInfoList &files);
+    void finished();
+private:
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // FOLDERSCANNER_HPP
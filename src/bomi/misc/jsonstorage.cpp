@@ -4,6 +4,8 @@
 #include "pref/pref.hpp"
 #include "player/mrlstate.hpp"
 #include "video/interpolatorparams.hpp"
+#include <QSaveFile>
+#include <QCryptographicHash>
 
 DECLARE_LOG_CONTEXT(JSON)
 
@@ -19,6 +21,21 @@ struct JsonIO<Mrl> : JsonQStringType {
     }
 };
 
+// digest of content last read or written for each file
+// unchanged object is not written again
+struct JsonDigests {
+    static auto hash(const QByteArray &data) -> QByteArray
+        { return QCryptographicHash::hash(data, QCryptographicHash::Sha1); }
+    auto get(const QString &file) -> QByteArray
+        { QMutexLocker locker(&mutex); return map.value(file); }
+    auto set(const QString &file, const QByteArray &data) -> void
+        { const auto digest = hash(data); QMutexLocker locker(&mutex); map[file] = digest; }
+    QMutex mutex;
+    QHash<QString, QByteArray> map;
+};
+
+static JsonDigests s_digests;
+
 JsonStorage::JsonStorage(const QString &fileName) noexcept
     : m_fileName(fileName)
 {
@@ -28,13 +45,21 @@ JsonStorage::JsonStorage(const QString &fileName) noexcept
 auto JsonStorage::write(const QJsonObject &json) noexcept -> bool
 {
     setError(NoError);
-    QFile file(m_fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    const auto data = QJsonDocument(json).toJson();
+    if (s_digests.get(m_fileName) == JsonDigests::hash(data)
+            && QFile::exists(m_fileName))
+        return true;
+    // written to temporary file and renamed, so crash never leaves half file
+    QSaveFile file(m_fileName);
+    if (!file.open(QFile::WriteOnly)) {
         setError(OpenError);
         return false;
     }
-    QJsonDocument doc(json);
-    file.write(doc.toJson());
+    if (file.write(data) != data.size() || !file.commit()) {
+        _Error("Error: Cannot write '%%' file: %%", m_fileName, file.errorString());
+        return false;
+    }
+    s_digests.set(m_fileName, data);
     return true;
 }
 
@@ -69,9 +94,12 @@ auto JsonStorage::read() noexcept -> QJsonObject
         setError(OpenError);
         return QJsonObject();
     }
-    const auto json = QJsonDocument::fromJson(file.readAll(), &m_parseError);
+    const auto data = file.readAll();
+    const auto json = QJsonDocument::fromJson(data, &m_parseError);
     if (m_parseError.error)
         setError(ParseError);
+    else
+        s_digests.set(m_fileName, data);
     return json.object();
 }
 
@@ -173,6 +201,8 @@ static auto convs() -> const QHash<int, JVConvert>&
         INSERT(IntrplParamSetMap);
         INSERT(WindowSize);
         INSERT(QList<WindowSize>);
+        INSERT(AudioZoneOption);
+        INSERT(QList<AudioZoneOption>);
 
         for (auto type : _EnumMetaTypeIds()) {
             auto &ec = c[type];
@@ -244,21 +274,66 @@ auto _JsonToQVariant(const QJsonValue &json, const QVariant &def) -> QVariant
     return v.isValid() ? v : def;
 }
 
+auto _JsonToQVariantConverter(int metaType) -> JsonToQVariant
+{
+    const auto it = convs().find(metaType);
+    if (it == convs().end()) {
+        return [metaType] (const QJsonValue &) {
+            _Error("Unknown type for conversion: %%", QMetaType::typeName(metaType));
+            return QVariant();
+        };
+    }
+    const JVConvert *conv = &it.value();
+    return [conv] (const QJsonValue &json) {
+        QVariant var;
+        return conv->j2v(conv, json, var) ? var : QVariant();
+    };
+}
+
+// property names and converters resolved once for each class
+struct JsonProperty {
+    QMetaProperty property;
+    QString name;
+    const JVConvert *conv;
+};
+
+static auto jsonProperties(const QMetaObject *mo) -> const QVector<JsonProperty>&
+{
+    static QHash<const QMetaObject*, QVector<JsonProperty>> cache;
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    auto it = cache.find(mo);
+    if (it != cache.end())
+        return *it;
+    QVector<JsonProperty> properties;
+    properties.reserve(mo->propertyCount() - 1);
+    for (int i = 1; i < mo->propertyCount(); ++i) {
+        const auto p = mo->property(i);
+        const auto conv = convs().find(p.userType());
+        properties.push_back({ p, QString::fromLatin1(p.name()),
+                               conv != convs().end() ? &conv.value() : nullptr });
+    }
+    return *cache.insert(mo, properties);
+}
+
 auto _JsonToQObject(const QJsonObject &json, QObject *obj) -> bool
 {
     bool res = true;
     auto mo = obj->metaObject();
-    for (int i = 1; i < mo->propertyCount(); ++i) {
-        auto p = mo->property(i);
-        auto it = json.find(QString::fromLatin1(p.name()));
+    for (auto &jp : jsonProperties(mo)) {
+        auto it = json.find(jp.name);
         if (it == json.end()) {
-            _Warn("Cannot find property '%%' in '%%'", p.name(), mo->className());
+            _Warn("Cannot find property '%%' in '%%'", jp.name, mo->className());
             res = false;
             continue;
         }
-        const auto var = _JsonToQVariant(*it, p.read(obj));
-        Q_ASSERT(var.userType() == p.userType());
-        p.write(obj, var);
+        auto var = jp.property.read(obj);
+        if (!jp.conv)
+            var = _JsonToQVariant(*it, var);
+        else if (!jp.conv->j2v(jp.conv, *it, var))
+            continue;
+        Q_ASSERT(var.userType() == jp.property.userType());
+        jp.property.write(obj, var);
     }
     return res;
 }
@@ -266,11 +341,10 @@ auto _JsonToQObject(const QJsonObject &json, QObject *obj) -> bool
 auto _JsonFromQObject(const QObject *obj) -> QJsonObject
 {
     QJsonObject json;
-    auto mo = obj->metaObject();
-    for (int i = 1; i < mo->propertyCount(); ++i) {
-        auto p = mo->property(i);
-        const auto value = _JsonFromQVariant(p.read(obj));
-        json.insert(QString::fromLatin1(p.name()), value);
+    for (auto &jp : jsonProperties(obj->metaObject())) {
+        const auto var = jp.property.read(obj);
+        json.insert(jp.name, jp.conv ? jp.conv->v2j(jp.conv, var)
+                                     : _JsonFromQVariant(var));
     }
     return json;
 }
@@ -30,6 +30,9 @@ auto _JsonFromQVariant(const QVariant &var) -> QJsonValue;
 auto _JsonToQVariant(const QJsonValue &json, const QVariant &def) -> QVariant;
 auto _JsonToQVariant(const QJsonValue &json, int metaType) -> QVariant;
 auto _JsonToQVariant(const QJsonValue &json, int metaType, const QVariant &def) -> QVariant;
+// converter looked up once, returns invalid QVariant on failure
+using JsonToQVariant = std::function<QVariant(const QJsonValue&)>;
+auto _JsonToQVariantConverter(int metaType) -> JsonToQVariant;
 
 auto _JsonType(int metaType) -> QJsonValue::Type;
 auto _QVariantFromType(int metaType) -> QVariant;
@@ -2,6 +2,7 @@
 #include <QLocalServer>
 #include <QLockFile>
 #include <QLocalSocket>
+#include <QtEndian>
 
 #if defined(Q_OS_WIN)
 #include <QtCore/QLibrary>
@@ -30,18 +31,70 @@ static int getUid() {
 #endif
 }
 
+constexpr static const char* ack = "ack";
+static constexpr quint32 MaxMessageBytes = 16 << 20;
+
+static auto socketName(const QString &id) -> QString
+{
+    return id % '-'_q % QString::number(getUid(), 16);
+}
+
+static auto writeMessage(QLocalSocket *socket, const QByteArray &msg, int timeout) -> bool
+{
+    QByteArray frame(sizeof(quint32), 0);
+    qToBigEndian<quint32>(msg.size(), reinterpret_cast<uchar*>(frame.data()));
+    socket->write(frame + msg);
+    if (!socket->waitForBytesWritten(timeout))
+        return false;
+    const int len = qstrlen(ack);
+    while (socket->bytesAvailable() < len) {
+        if (!socket->waitForReadyRead(timeout))
+            return false;
+    }
+    return socket->read(len) == ack;
+}
+
 struct LocalConnection::Data {
+    LocalConnection *p = nullptr;
     QString id, socket;
     QLocalServer server;
     QLockFile *lock = nullptr;
+    // unparsed bytes of each connected client
+    QHash<QLocalSocket*, QByteArray> buffers;
+    // connection to other instance, reused for every message
+    QLocalSocket *client = nullptr;
+    auto read(QLocalSocket *socket) -> void
+    {
+        auto it = buffers.find(socket);
+        if (it == buffers.end())
+            return;
+        it->append(socket->readAll());
+        QList<QByteArray> messages;
+        while (it->size() >= (int)sizeof(quint32)) {
+            const auto at = reinterpret_cast<const uchar*>(it->constData());
+            const auto length = qFromBigEndian<quint32>(at);
+            if (length > MaxMessageBytes) {
+                buffers.erase(it);
+                socket->abort();
+                return;
+            }
+            const int size = sizeof(quint32) + length;
+            if (it->size() < size)
+                break;
+            messages.push_back(it->mid(sizeof(quint32), length));
+            it->remove(0, size);
+            socket->write(ack, qstrlen(ack));
+        }
+        for (auto &msg : messages)
+            emit p->messageReceived(msg);
+    }
 };
 
-constexpr static const char* ack = "ack";
-
 LocalConnection::LocalConnection(const QString &id, QObject* parent)
 : QObject(parent), d(new Data) {
+    d->p = this;
     d->id = id;
-    d->socket = id % '-'_q % QString::number(getUid(), 16);
+    d->socket = socketName(id);
     d->lock = new QLockFile(QDir::temp().path() % '/'_q % d->socket % u"-lock"_q);
     d->lock->setStaleLockTime(0);
 }
@@ -62,28 +115,17 @@ auto LocalConnection::runServer() -> bool
         if (!d->server.listen(d->socket))
             return false;
     }
-    connect(&d->server, &QLocalServer::newConnection, [this]() {
-        QScopedPointer<QLocalSocket> socket(d->server.nextPendingConnection());
-        if (socket) {
-            while (socket->bytesAvailable() < (int)sizeof(quint32))
-                socket->waitForReadyRead();
-            QDataStream in(socket.data());
-            QByteArray msg;
-            quint32 left;
-            in >> left;
-            msg.resize(left);
-            char *buffer = msg.data();
-            do {
-                const int read = in.readRawData(buffer, left);
-                if (read < 0)
-                    return;
-                left -= read;
-                buffer += read;
-            } while (left > 0 && socket->waitForReadyRead(5000));
-            socket->write(ack, qstrlen(ack));
-            socket->waitForBytesWritten(1000);
-            socket->close();
-            emit messageReceived(msg); //### (might take a long time to return)
+    connect(&d->server, &QLocalServer::newConnection, this, [this]() {
+        while (auto socket = d->server.nextPendingConnection()) {
+            d->buffers.insert(socket, QByteArray());
+            connect(socket, &QLocalSocket::readyRead,
+                    this, [=] () { d->read(socket); });
+            connect(socket, &QLocalSocket::disconnected, this, [=] () {
+                d->buffers.remove(socket);
+                socket->deleteLater();
+            });
+            if (socket->bytesAvailable() > 0)
+                d->read(socket);
         }
     });
     return true;
@@ -93,14 +135,31 @@ auto LocalConnection::sendMessage(const QByteArray &msg, int timeout) -> bool
 {
     if (runServer())
         return false;
+    if (!d->client)
+        d->client = new QLocalSocket(this);
+    auto socket = d->client;
+    if (socket->state() != QLocalSocket::ConnectedState) {
+        socket->abort();
+        socket->connectToServer(d->socket);
+        if (!socket->waitForConnected(timeout))
+            return false;
+    }
+    return writeMessage(socket, msg, timeout);
+}
+
+auto LocalConnection::stopServer() -> void
+{
+    if (!d->lock->isLocked())
+        return;
+    d->server.close();
+    disconnect(&d->server, &QLocalServer::newConnection, this, nullptr);
+    d->lock->unlock();
+}
+
+auto LocalConnection::forward(const QString &id, const QByteArray &msg, int timeout) -> bool
+{
+    // stale socket file of crashed instance refuses connection at once
     QLocalSocket socket;
-    socket.connectToServer(d->socket);
-    if (!socket.waitForConnected(timeout))
-        return false;
-    QDataStream out(&socket);
-    out.writeBytes(msg.constData(), msg.size());
-    bool res = socket.waitForBytesWritten(timeout);
-    res &= socket.waitForReadyRead(timeout);   // wait for ack
-    res &= (socket.read(qstrlen(ack)) == ack);
-    return res;
+    socket.connectToServer(socketName(id));
+    return socket.waitForConnected(timeout) && writeMessage(&socket, msg, timeout);
 }
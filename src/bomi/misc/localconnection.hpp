@@ -1,13 +1,18 @@
 #ifndef LOCALCONNECTION_HPP
 #define LOCALCONNECTION_HPP
 
+// messages are framed by 32-bit big-endian length and acknowledged one by one
+// connections stay open, so a client can send many messages on one socket
 class LocalConnection : public QObject {
     Q_OBJECT
 public:
     LocalConnection(const QString &id, QObject *parent = 0);
     ~LocalConnection();
     auto runServer() -> bool;
+    auto stopServer() -> void;
     auto sendMessage(const QByteArray &message, int timeout) -> bool;
+    // sends to running server without becoming one, false if there is none
+    static auto forward(const QString &id, const QByteArray &message, int timeout) -> bool;
 signals:
     void messageReceived(const QByteArray &message);
 private:
@@ -19,239 +19,83 @@ auto operator >> (QDataStream &in, Locale &l) -> QDataStream&
 
 DECLARE_LOG_CONTEXT(Locale)
 
-struct Data {
-    Data()
-    {
-        // ISO639-3 B to T
-        aliases[u"cze"_q] = u"ces"_q;
-        aliases[u"baq"_q] = u"eus"_q;
-        aliases[u"fre"_q] = u"fra"_q;
-        aliases[u"ger"_q] = u"deu"_q;
-        aliases[u"gre"_q] = u"ell"_q;
-        aliases[u"arm"_q] = u"hye"_q;
-        aliases[u"ice"_q] = u"isl"_q;
-        aliases[u"geo"_q] = u"kat"_q;
-        aliases[u"mac"_q] = u"mkd"_q;
-        aliases[u"mao"_q] = u"mri"_q;
-        aliases[u"may"_q] = u"msa"_q;
-        aliases[u"bur"_q] = u"mya"_q;
-        aliases[u"dut"_q] = u"nld"_q;
-        aliases[u"per"_q] = u"fas"_q;
-        aliases[u"rum"_q] = u"ron"_q;
-        aliases[u"slo"_q] = u"slk"_q;
-        aliases[u"alb"_q] = u"sqi"_q;
-        aliases[u"tib"_q] = u"bod"_q;
-        aliases[u"wel"_q] = u"cym"_q;
-        aliases[u"chi"_q] = u"zho"_q;
-
-        // custom code for opensubtitles
-        aliases[u"scc"_q] = u"srp"_q;
-        aliases[u"pob"_q] = u"por"_q;
-        aliases[u"pb"_q]  = u"por"_q;
+// ISO639-1 to ISO639-3, ISO639-2 B to T, custom codes of opensubtitles
+// (scc, pob, pb) and duplicated languages (tgl, twi), sorted by code
+struct IsoAlias { char code[4], iso[4]; };
+static constexpr IsoAlias s_aliases[] = {
+    {"aa", "aar"}, {"ab", "abk"}, {"ae", "ave"}, {"af", "afr"}, {"ak", "aka"},
+    {"alb", "sqi"}, {"am", "amh"}, {"an", "arg"}, {"ar", "ara"}, {"arm", "hye"},
+    {"as", "asm"}, {"av", "ava"}, {"ay", "aym"}, {"az", "aze"}, {"ba", "bak"},
+    {"baq", "eus"}, {"be", "bel"}, {"bg", "bul"}, {"bh", "bih"}, {"bi", "bis"},
+    {"bm", "bam"}, {"bn", "ben"}, {"bo", "bod"}, {"br", "bre"}, {"bs", "bos"},
+    {"bur", "mya"}, {"ca", "cat"}, {"ce", "che"}, {"ch", "cha"}, {"chi", "zho"},
+    {"co", "cos"}, {"cr", "cre"}, {"cs", "ces"}, {"cu", "chu"}, {"cv", "chv"},
+    {"cy", "cym"}, {"cze", "ces"}, {"da", "dan"}, {"de", "deu"}, {"dut", "nld"},
+    {"dv", "div"}, {"dz", "dzo"}, {"ee", "ewe"}, {"el", "ell"}, {"en", "eng"},
+    {"eo", "epo"}, {"es", "spa"}, {"et", "est"}, {"eu", "eus"}, {"fa", "fas"},
+    {"ff", "ful"}, {"fi", "fin"}, {"fj", "fij"}, {"fo", "fao"}, {"fr", "fra"},
+    {"fre", "fra"}, {"fy", "fry"}, {"ga", "gle"}, {"gd", "gla"}, {"geo", "kat"},
+    {"ger", "deu"}, {"gl", "glg"}, {"gn", "grn"}, {"gre", "ell"}, {"gu", "guj"},
+    {"gv", "glv"}, {"ha", "hau"}, {"he", "heb"}, {"hi", "hin"}, {"ho", "hmo"},
+    {"hr", "hrv"}, {"ht", "hat"}, {"hu", "hun"}, {"hy", "hye"}, {"hz", "her"},
+    {"ia", "ina"}, {"ice", "isl"}, {"id", "ind"}, {"ie", "ile"}, {"ig", "ibo"},
+    {"ii", "iii"}, {"ik", "ipk"}, {"io", "ido"}, {"is", "isl"}, {"it", "ita"},
+    {"iu", "iku"}, {"ja", "jpn"}, {"jv", "jav"}, {"ka", "kat"}, {"kg", "kon"},
+    {"ki", "kik"}, {"kj", "kua"}, {"kk", "kaz"}, {"kl", "kal"}, {"km", "khm"},
+    {"kn", "kan"}, {"ko", "kor"}, {"kr", "kau"}, {"ks", "kas"}, {"ku", "kur"},
+    {"kv", "kom"}, {"kw", "cor"}, {"ky", "kir"}, {"la", "lat"}, {"lb", "ltz"},
+    {"lg", "lug"}, {"li", "lim"}, {"ln", "lin"}, {"lo", "lao"}, {"lt", "lit"},
+    {"lu", "lub"}, {"lv", "lav"}, {"mac", "mkd"}, {"mao", "mri"},
+    {"may", "msa"}, {"mg", "mlg"}, {"mh", "mah"}, {"mi", "mri"}, {"mk", "mkd"},
+    {"ml", "mal"}, {"mn", "mon"}, {"mr", "mar"}, {"ms", "msa"}, {"mt", "mlt"},
+    {"my", "mya"}, {"na", "nau"}, {"nb", "nob"}, {"nd", "nde"}, {"ne", "nep"},
+    {"ng", "ndo"}, {"nl", "nld"}, {"nn", "nno"}, {"no", "nor"}, {"nr", "nbl"},
+    {"nv", "nav"}, {"ny", "nya"}, {"oc", "oci"}, {"oj", "oji"}, {"om", "orm"},
+    {"or", "ori"}, {"os", "oss"}, {"pa", "pan"}, {"pb", "por"}, {"per", "fas"},
+    {"pi", "pli"}, {"pl", "pol"}, {"pob", "por"}, {"ps", "pus"}, {"pt", "por"},
+    {"qu", "que"}, {"rm", "roh"}, {"rn", "run"}, {"ro", "ron"}, {"ru", "rus"},
+    {"rum", "ron"}, {"rw", "kin"}, {"sa", "san"}, {"sc", "srd"}, {"scc", "srp"},
+    {"sd", "snd"}, {"se", "sme"}, {"sg", "sag"}, {"si", "sin"}, {"sk", "slk"},
+    {"sl", "slv"}, {"slo", "slk"}, {"sm", "smo"}, {"sn", "sna"}, {"so", "som"},
+    {"sq", "sqi"}, {"sr", "srp"}, {"ss", "ssw"}, {"st", "sot"}, {"su", "sun"},
+    {"sv", "swe"}, {"sw", "swa"}, {"ta", "tam"}, {"te", "tel"}, {"tg", "tgk"},
+    {"tgl", "fil"}, {"th", "tha"}, {"ti", "tir"}, {"tib", "bod"}, {"tk", "tuk"},
+    {"tl", "tgl"}, {"tn", "tsn"}, {"to", "ton"}, {"tr", "tur"}, {"ts", "tso"},
+    {"tt", "tat"}, {"tw", "twi"}, {"twi", "aka"}, {"ty", "tah"}, {"ug", "uig"},
+    {"uk", "ukr"}, {"ur", "urd"}, {"uz", "uzb"}, {"ve", "ven"}, {"vi", "vie"},
+    {"vo", "vol"}, {"wa", "wln"}, {"wel", "cym"}, {"wo", "wol"}, {"xh", "xho"},
+    {"yi", "yid"}, {"yo", "yor"}, {"za", "zha"}, {"zh", "zho"}, {"zu", "zul"},
+};
 
-        // duplicated languages
-        aliases[u"tgl"_q] = u"fil"_q;
-        aliases[u"twi"_q] = u"aka"_q;
+SIA isoAlias(const QString &code) -> QString
+{
+    const auto latin1 = code.toLatin1();
+    auto it = std::lower_bound(std::begin(s_aliases), std::end(s_aliases), latin1,
+        [] (const IsoAlias &a, const QByteArray &c) { return qstrcmp(a.code, c) < 0; });
+    if (it != std::end(s_aliases) && latin1 == it->code)
+        return _L(it->iso);
+    return code;
+}
 
-        // ISO639-1 to ISO639-3
-        aliases[u"aa"_q] = u"aar"_q;
-        aliases[u"ab"_q] = u"abk"_q;
-        aliases[u"af"_q] = u"afr"_q;
-        aliases[u"ak"_q] = u"aka"_q;
-        aliases[u"sq"_q] = u"sqi"_q;
-        aliases[u"am"_q] = u"amh"_q;
-        aliases[u"ar"_q] = u"ara"_q;
-        aliases[u"an"_q] = u"arg"_q;
-        aliases[u"hy"_q] = u"hye"_q;
-        aliases[u"as"_q] = u"asm"_q;
-        aliases[u"av"_q] = u"ava"_q;
-        aliases[u"ae"_q] = u"ave"_q;
-        aliases[u"ay"_q] = u"aym"_q;
-        aliases[u"az"_q] = u"aze"_q;
-        aliases[u"ba"_q] = u"bak"_q;
-        aliases[u"bm"_q] = u"bam"_q;
-        aliases[u"eu"_q] = u"eus"_q;
-        aliases[u"be"_q] = u"bel"_q;
-        aliases[u"bn"_q] = u"ben"_q;
-        aliases[u"bh"_q] = u"bih"_q;
-        aliases[u"bi"_q] = u"bis"_q;
-        aliases[u"bs"_q] = u"bos"_q;
-        aliases[u"br"_q] = u"bre"_q;
-        aliases[u"bg"_q] = u"bul"_q;
-        aliases[u"my"_q] = u"mya"_q;
-        aliases[u"ca"_q] = u"cat"_q;
-        aliases[u"ch"_q] = u"cha"_q;
-        aliases[u"ce"_q] = u"che"_q;
-        aliases[u"zh"_q] = u"zho"_q;
-        aliases[u"cu"_q] = u"chu"_q;
-        aliases[u"cv"_q] = u"chv"_q;
-        aliases[u"kw"_q] = u"cor"_q;
-        aliases[u"co"_q] = u"cos"_q;
-        aliases[u"cr"_q] = u"cre"_q;
-        aliases[u"cs"_q] = u"ces"_q;
-        aliases[u"da"_q] = u"dan"_q;
-        aliases[u"dv"_q] = u"div"_q;
-        aliases[u"nl"_q] = u"nld"_q;
-        aliases[u"dz"_q] = u"dzo"_q;
-        aliases[u"en"_q] = u"eng"_q;
-        aliases[u"eo"_q] = u"epo"_q;
-        aliases[u"et"_q] = u"est"_q;
-        aliases[u"ee"_q] = u"ewe"_q;
-        aliases[u"fo"_q] = u"fao"_q;
-        aliases[u"fj"_q] = u"fij"_q;
-        aliases[u"fi"_q] = u"fin"_q;
-        aliases[u"fr"_q] = u"fra"_q;
-        aliases[u"fy"_q] = u"fry"_q;
-        aliases[u"ff"_q] = u"ful"_q;
-        aliases[u"ka"_q] = u"kat"_q;
-        aliases[u"de"_q] = u"deu"_q;
-        aliases[u"gd"_q] = u"gla"_q;
-        aliases[u"ga"_q] = u"gle"_q;
-        aliases[u"gl"_q] = u"glg"_q;
-        aliases[u"gv"_q] = u"glv"_q;
-        aliases[u"el"_q] = u"ell"_q;
-        aliases[u"gn"_q] = u"grn"_q;
-        aliases[u"gu"_q] = u"guj"_q;
-        aliases[u"ht"_q] = u"hat"_q;
-        aliases[u"ha"_q] = u"hau"_q;
-        aliases[u"he"_q] = u"heb"_q;
-        aliases[u"hz"_q] = u"her"_q;
-        aliases[u"hi"_q] = u"hin"_q;
-        aliases[u"ho"_q] = u"hmo"_q;
-        aliases[u"hr"_q] = u"hrv"_q;
-        aliases[u"hu"_q] = u"hun"_q;
-        aliases[u"ig"_q] = u"ibo"_q;
-        aliases[u"is"_q] = u"isl"_q;
-        aliases[u"io"_q] = u"ido"_q;
-        aliases[u"ii"_q] = u"iii"_q;
-        aliases[u"iu"_q] = u"iku"_q;
-        aliases[u"ie"_q] = u"ile"_q;
-        aliases[u"ia"_q] = u"ina"_q;
-        aliases[u"id"_q] = u"ind"_q;
-        aliases[u"ik"_q] = u"ipk"_q;
-        aliases[u"it"_q] = u"ita"_q;
-        aliases[u"jv"_q] = u"jav"_q;
-        aliases[u"ja"_q] = u"jpn"_q;
-        aliases[u"kl"_q] = u"kal"_q;
-        aliases[u"kn"_q] = u"kan"_q;
-        aliases[u"ks"_q] = u"kas"_q;
-        aliases[u"kr"_q] = u"kau"_q;
-        aliases[u"kk"_q] = u"kaz"_q;
-        aliases[u"km"_q] = u"khm"_q;
-        aliases[u"ki"_q] = u"kik"_q;
-        aliases[u"rw"_q] = u"kin"_q;
-        aliases[u"ky"_q] = u"kir"_q;
-        aliases[u"kv"_q] = u"kom"_q;
-        aliases[u"kg"_q] = u"kon"_q;
-        aliases[u"ko"_q] = u"kor"_q;
-        aliases[u"kj"_q] = u"kua"_q;
-        aliases[u"ku"_q] = u"kur"_q;
-        aliases[u"lo"_q] = u"lao"_q;
-        aliases[u"la"_q] = u"lat"_q;
-        aliases[u"lv"_q] = u"lav"_q;
-        aliases[u"li"_q] = u"lim"_q;
-        aliases[u"ln"_q] = u"lin"_q;
-        aliases[u"lt"_q] = u"lit"_q;
-        aliases[u"lb"_q] = u"ltz"_q;
-        aliases[u"lu"_q] = u"lub"_q;
-        aliases[u"lg"_q] = u"lug"_q;
-        aliases[u"mk"_q] = u"mkd"_q;
-        aliases[u"mh"_q] = u"mah"_q;
-        aliases[u"ml"_q] = u"mal"_q;
-        aliases[u"mi"_q] = u"mri"_q;
-        aliases[u"mr"_q] = u"mar"_q;
-        aliases[u"ms"_q] = u"msa"_q;
-        aliases[u"mg"_q] = u"mlg"_q;
-        aliases[u"mt"_q] = u"mlt"_q;
-        aliases[u"mn"_q] = u"mon"_q;
-        aliases[u"na"_q] = u"nau"_q;
-        aliases[u"nv"_q] = u"nav"_q;
-        aliases[u"nr"_q] = u"nbl"_q;
-        aliases[u"nd"_q] = u"nde"_q;
-        aliases[u"ng"_q] = u"ndo"_q;
-        aliases[u"ne"_q] = u"nep"_q;
-        aliases[u"nn"_q] = u"nno"_q;
-        aliases[u"nb"_q] = u"nob"_q;
-        aliases[u"no"_q] = u"nor"_q;
-        aliases[u"ny"_q] = u"nya"_q;
-        aliases[u"oc"_q] = u"oci"_q;
-        aliases[u"oj"_q] = u"oji"_q;
-        aliases[u"or"_q] = u"ori"_q;
-        aliases[u"om"_q] = u"orm"_q;
-        aliases[u"os"_q] = u"oss"_q;
-        aliases[u"pa"_q] = u"pan"_q;
-        aliases[u"fa"_q] = u"fas"_q;
-        aliases[u"pi"_q] = u"pli"_q;
-        aliases[u"pl"_q] = u"pol"_q;
-        aliases[u"pt"_q] = u"por"_q;
-        aliases[u"ps"_q] = u"pus"_q;
-        aliases[u"qu"_q] = u"que"_q;
-        aliases[u"rm"_q] = u"roh"_q;
-        aliases[u"ro"_q] = u"ron"_q;
-        aliases[u"rn"_q] = u"run"_q;
-        aliases[u"ru"_q] = u"rus"_q;
-        aliases[u"sg"_q] = u"sag"_q;
-        aliases[u"sa"_q] = u"san"_q;
-        aliases[u"si"_q] = u"sin"_q;
-        aliases[u"sk"_q] = u"slk"_q;
-        aliases[u"sl"_q] = u"slv"_q;
-        aliases[u"se"_q] = u"sme"_q;
-        aliases[u"sm"_q] = u"smo"_q;
-        aliases[u"sn"_q] = u"sna"_q;
-        aliases[u"sd"_q] = u"snd"_q;
-        aliases[u"so"_q] = u"som"_q;
-        aliases[u"st"_q] = u"sot"_q;
-        aliases[u"es"_q] = u"spa"_q;
-        aliases[u"sc"_q] = u"srd"_q;
-        aliases[u"sr"_q] = u"srp"_q;
-        aliases[u"ss"_q] = u"ssw"_q;
-        aliases[u"su"_q] = u"sun"_q;
-        aliases[u"sw"_q] = u"swa"_q;
-        aliases[u"sv"_q] = u"swe"_q;
-        aliases[u"ty"_q] = u"tah"_q;
-        aliases[u"ta"_q] = u"tam"_q;
-        aliases[u"tt"_q] = u"tat"_q;
-        aliases[u"te"_q] = u"tel"_q;
-        aliases[u"tg"_q] = u"tgk"_q;
-        aliases[u"tl"_q] = u"tgl"_q;
-        aliases[u"th"_q] = u"tha"_q;
-        aliases[u"bo"_q] = u"bod"_q;
-        aliases[u"ti"_q] = u"tir"_q;
-        aliases[u"to"_q] = u"ton"_q;
-        aliases[u"tn"_q] = u"tsn"_q;
-        aliases[u"ts"_q] = u"tso"_q;
-        aliases[u"tk"_q] = u"tuk"_q;
-        aliases[u"tr"_q] = u"tur"_q;
-        aliases[u"tw"_q] = u"twi"_q;
-        aliases[u"ug"_q] = u"uig"_q;
-        aliases[u"uk"_q] = u"ukr"_q;
-        aliases[u"ur"_q] = u"urd"_q;
-        aliases[u"uz"_q] = u"uzb"_q;
-        aliases[u"ve"_q] = u"ven"_q;
-        aliases[u"vi"_q] = u"vie"_q;
-        aliases[u"vo"_q] = u"vol"_q;
-        aliases[u"cy"_q] = u"cym"_q;
-        aliases[u"wa"_q] = u"wln"_q;
-        aliases[u"wo"_q] = u"wol"_q;
-        aliases[u"xh"_q] = u"xho"_q;
-        aliases[u"yi"_q] = u"yid"_q;
-        aliases[u"yo"_q] = u"yor"_q;
-        aliases[u"za"_q] = u"zha"_q;
-        aliases[u"zu"_q] = u"zul"_q;
-    }
+struct Data {
     Locale native = Locale::system();
-    QHash<QString, QString> aliases;
-    QMap<QString, QString> isoName;
-    auto iso(QLocale::Language lang) const -> QJsonObject
+    // names in native language, parsed from map only when first requested
+    QHash<QString, QString> isoName;
+    bool parsed = false;
+    auto parse() -> void
     {
+        parsed = true;
         QFile file(u":/locale-map.json"_q);
         if (!file.open(QFile::ReadOnly))
-            return QJsonObject();
+            return;
         QJsonParseError e;
-        auto doc = QJsonDocument::fromJson(file.readAll(), &e);
+        const auto doc = QJsonDocument::fromJson(file.readAll(), &e);
         if (e.error)
-            return QJsonObject();
-        return doc.array().at(lang).toObject();
+            return;
+        const auto map = doc.array().at(native.language()).toObject();
+        isoName.reserve(map.size());
+        for (auto it = map.begin(); it != map.end(); ++it)
+            isoName.insert(it.key(), it.value().toString());
     }
 };
 
@@ -736,28 +580,28 @@ auto Locale::native() -> Locale
 
 auto Locale::setNative(const Locale &l) -> void
 {
-    data().native = l;
+    auto &d = data();
+    if (d.native == l)
+        return;
+    d.native = l;
+    d.isoName.clear();
+    d.parsed = false;
 }
 
 auto Locale::isoToNativeName(const QString &_iso) -> QString
 {
     if (_iso.size() > 3)
         return QString();
-    QString iso = _iso.toLower();
-    auto it = data().aliases.constFind(iso);
-    if (it != data().aliases.cend())
-        iso = *it;
-    auto &name = data().isoName[iso];
-    if (name.isEmpty()) {
-        const auto map = data().iso(data().native.language());
-        const auto lang = map[iso].toString();
-        if (lang.isEmpty()) {
-            _Error("Cannot find locale for %%", iso);
-            name = iso;
-        } else
-            name = lang;
+    const auto iso = isoAlias(_iso.toLower());
+    auto &d = data();
+    if (!d.parsed)
+        d.parse();
+    auto it = d.isoName.constFind(iso);
+    if (it == d.isoName.cend()) {
+        _Error("Cannot find locale for %%", iso);
+        it = d.isoName.insert(iso, iso);
     }
-    return name;
+    return *it;
 }
 
 auto Locale::nativeName() const -> QString
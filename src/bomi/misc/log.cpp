@@ -3,8 +3,12 @@
 #include "logoption.hpp"
 #include "configure.hpp"
 #include "tmp/algorithm.hpp"
+#include "tmp/ring.hpp"
 #include <QTextCodec>
 #include <QBuffer>
+#include <QElapsedTimer>
+#include <condition_variable>
+#include <mutex>
 #include <cstdlib>
 
 #if HAVE_SYSTEMD
@@ -27,12 +31,15 @@ static Log::Level lvStdErr  = Log::Off;
 static Log::Level lvJournal = Log::Off;
 static Log::Level lvFile    = Log::Off;
 static Log::Level lvViewer  = Log::Off;
-static Log::Level lvMax     = Log::Trace;
 
 static QReadWriteLock s_rwLock;
 static QHash<QObject*, int> s_subscribers;
+// lines before first subscriber, since log viewer is created on demand
+static QList<QPair<Log::Level, QString>> s_backlog;
+static constexpr int BacklogMax = 5000;
 
 static QSharedPointer<FILE> s_file;
+static LogOption s_option;
 static bool s_local8BitIsUtf8 = false;
 
 SIA encodeForTerminal(const QByteArray &log) -> QByteArray
@@ -44,40 +51,244 @@ SIA encodeForTerminal(const QByteArray &log) -> QByteArray
     return QString::fromUtf8(log).toLocal8Bit();
 }
 
+Log::Level Log::m_maxLevel = Log::Trace;
+
 const QStringList Log::m_options = QStringList()
         << u"off"_q   << u"fatal"_q << u"error"_q << u"warn"_q
         << u"info"_q  << u"debug"_q << u"trace"_q;
 
+using LogLine = QPair<Log::Level, QString>;
+
+// bounded mpsc ring of lines, drained in batches by one writer thread
+// so that logging threads never wait for i/o
+struct LogSlot {
+    Log::Level level = Log::Off;
+    QByteArray text;
+};
+
+static constexpr int RingOrder = 12;
+static constexpr int FlushInterval = 100; // ms
+
+class LogWriter : public QThread {
+public:
+    LogWriter()
+    {
+        setObjectName(u"LogWriter"_q);
+    }
+    ~LogWriter() { deactivate(); }
+    auto isActive() const -> bool { return m_active.load(std::memory_order_acquire); }
+    auto activate() -> void
+    {
+        m_quit.store(false);
+        m_active.store(true, std::memory_order_release);
+        start(QThread::LowPriority);
+    }
+    auto deactivate() -> void
+    {
+        if (!isActive())
+            return;
+        m_active.store(false, std::memory_order_release);
+        m_quit.store(true);
+        wake();
+        wait();
+    }
+    // returns position of the line
+    auto push(Log::Level lv, const QByteArray &text) -> quint64
+    {
+        qint64 pos = -1;
+        forever {
+            pos = m_ring.tryPush([&] (LogSlot &slot)
+                                 { slot.level = lv; slot.text = text; });
+            if (pos >= 0)
+                break;
+            // full, which is exceptional, so just give writer a chance
+            wake();
+            QThread::yieldCurrentThread();
+        }
+        if (m_sleeping.load())
+            wake();
+        return pos;
+    }
+    // wait until lines up to pos have been written and flushed
+    auto flush(quint64 pos) -> void
+    {
+        if (QThread::currentThread() == this)
+            return;
+        m_flush.store(true, std::memory_order_release);
+        while (isActive() && m_flushed.load(std::memory_order_acquire) <= pos) {
+            wake();
+            QThread::msleep(1);
+        }
+    }
+    auto flush() -> void
+    {
+        const auto head = m_ring.head();
+        if (head > 0)
+            flush(head - 1);
+    }
+private:
+    auto wake() -> void { m_cond.notify_one(); }
+    auto pop(Log::Level &lv, QByteArray &text) -> bool
+    {
+        return m_ring.pop([&] (LogSlot &slot) {
+            lv = slot.level;
+            text.swap(slot.text);
+            slot.text.clear();
+        });
+    }
+    auto run() -> void final;
+    tmp::MpscRing<LogSlot, RingOrder> m_ring;
+    std::atomic<quint64> m_flushed{0};
+    std::atomic<bool> m_sleeping{false}, m_active{false}, m_flush{false};
+    std::atomic<bool> m_quit{false};
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+static LogWriter s_writer;
+
 SIA print(FILE *file, const QByteArray &log) -> void
 {
     fwrite(log.constData(), 1, log.size(), file);
-    fflush(file);
 }
 
-auto Log::print(Level lv, const QByteArray &log) -> void
+SIA printToViewer(QList<LogLine> &&lines) -> void
+{
+    if (lines.isEmpty())
+        return;
+    s_rwLock.lockForRead();
+    if (s_subscribers.isEmpty()) {
+        s_rwLock.unlock();
+        s_rwLock.lockForWrite();
+    }
+    if (!s_subscribers.isEmpty()) {
+        auto &s = _C(s_subscribers);
+        for (auto it = s.begin(); it != s.end(); ++it)
+            _PostEvent(it.key(), it.value(), lines);
+    } else {
+        const int max = s_option.lines() ? s_option.lines() : BacklogMax;
+        s_backlog += lines;
+        while (s_backlog.size() > max)
+            s_backlog.pop_front();
+    }
+    s_rwLock.unlock();
+}
+
+SIA flushAll() -> void
+{
+    if (lvStdOut)
+        fflush(stdout);
+    if (lvStdErr)
+        fflush(stderr);
+    if (lvFile && s_file)
+        fflush(s_file.data());
+}
+
+// append line to the batch of every output which takes its level
+SIA printAll(Log::Level lv, const QByteArray &log, QByteArray &out,
+             QByteArray &err, QByteArray &file, QList<LogLine> &viewer) -> void
 {
 #if HAVE_SYSTEMD
     if (lv <= lvJournal)
-        sd_journal_print(jp[lv], log.constData());
+        sd_journal_print(jp[lv], "%s", log.constData());
 #endif
     if (lv <= lvStdOut)
-        ::print(stdout, encodeForTerminal(log));
+        out += encodeForTerminal(log);
     if (lv <= lvStdErr)
-        ::print(stderr, encodeForTerminal(log));
+        err += encodeForTerminal(log);
     if (lv <= lvFile && s_file)
-        ::print(s_file.data(), log);
-    if (lv <= lvViewer && !s_subscribers.isEmpty()) {
-        s_rwLock.lockForRead();
-        auto &s = _C(s_subscribers);
+        file += log;
+    if (lv <= lvViewer) {
         auto str = QString::fromUtf8(log); str.chop(1);
-        for (auto it = s.begin(); it != s.end(); ++it)
-            _PostEvent(it.key(), it.value(), lv, str);
-        s_rwLock.unlock();
+        viewer.push_back(qMakePair(lv, str));
+    }
+}
+
+SIA writeAll(QByteArray &out, QByteArray &err, QByteArray &file,
+             QList<LogLine> &viewer) -> void
+{
+    if (!out.isEmpty())
+        ::print(stdout, out);
+    if (!err.isEmpty())
+        ::print(stderr, err);
+    if (!file.isEmpty())
+        ::print(s_file.data(), file);
+    printToViewer(std::move(viewer));
+    out.clear(); err.clear(); file.clear(); viewer.clear();
+}
+
+auto LogWriter::run() -> void
+{
+    static constexpr int BatchMax = 256;
+    QByteArray out, err, file, text;
+    QList<LogLine> viewer;
+    QElapsedTimer timer;
+    timer.start();
+    bool dirty = false;
+    forever {
+        int count = 0;
+        Log::Level lv;
+        while (count < BatchMax && pop(lv, text)) {
+            printAll(lv, text, out, err, file, viewer);
+            ++count;
+        }
+        if (count) {
+            writeAll(out, err, file, viewer);
+            dirty = true;
+        }
+        if (dirty && (timer.elapsed() >= FlushInterval
+                      || m_flush.exchange(false, std::memory_order_acq_rel))) {
+            flushAll();
+            dirty = false;
+            timer.restart();
+        }
+        if (!dirty)
+            m_flushed.store(m_ring.tail(), std::memory_order_release);
+        if (count == BatchMax)
+            continue;
+        if (m_quit.load() && !count)
+            break;
+        std::unique_lock<std::mutex> locker(m_mutex);
+        m_sleeping.store(true);
+        // a line pushed just before the flag is set waits for timeout at worst
+        if (!m_quit.load() && m_ring.isEmpty())
+            m_cond.wait_for(locker, std::chrono::milliseconds(FlushInterval));
+        m_sleeping.store(false);
+    }
+    flushAll();
+    m_flushed.store(m_ring.tail(), std::memory_order_release);
+}
+
+auto Log::print(Level lv, const QByteArray &log) -> void
+{
+    if (s_writer.isActive()) {
+        const auto pos = s_writer.push(lv, log);
+        if (lv == Fatal) {
+            s_writer.flush(pos);
+            abort();
+        }
+        return;
     }
+    QByteArray out, err, file;
+    QList<LogLine> viewer;
+    printAll(lv, log, out, err, file, viewer);
+    writeAll(out, err, file, viewer);
+    flushAll();
     if (lv == Fatal)
         abort();
 }
 
+auto Log::flush() -> void
+{
+    if (s_writer.isActive())
+        s_writer.flush();
+}
+
+auto Log::finalize() -> void
+{
+    s_writer.deactivate();
+}
+
 static const std::array<Log::Level, 4> lvQt = []() {
     std::array<Log::Level, 4> ret;
     ret[QtDebugMsg] = Log::Debug;
@@ -89,11 +300,11 @@ static const std::array<Log::Level, 4> lvQt = []() {
 
 auto Log::qt(QtMsgType type, const QMessageLogContext &, const QString &msg) -> void
 {
-    write("Qt", lvQt[type], msg.toUtf8());
+    const auto lv = lvQt[type];
+    if (lv <= m_maxLevel)
+        write("Qt", lv, msg.toUtf8());
 }
 
-static LogOption s_option;
-
 auto Log::setOption(const LogOption &option) -> void
 {
     s_option = option;
@@ -103,22 +314,23 @@ auto Log::setOption(const LogOption &option) -> void
     lvJournal = option.level(LogOutput::Journal);
     lvFile    = option.level(LogOutput::File);
     lvViewer  = option.level(LogOutput::Viewer);
-    lvMax = tmp::max(lvStdOut, lvStdErr, lvFile, lvViewer);
+    m_maxLevel = tmp::max(lvStdOut, lvStdErr, lvFile, lvViewer);
 #if HAVE_SYSTEMD
-    lvMax = tmp::max(lvMax, lvJournal);
+    m_maxLevel = tmp::max(m_maxLevel, lvJournal);
 #endif
 
     s_local8BitIsUtf8 = QTextCodec::codecForLocale()->mibEnum() == 106;
 
-    if (!lvFile)
-        return;
-    auto path = option.file().toLocal8Bit();
-    auto pf = fopen(path.constData(), "a");
-    if (!pf) {
-        qDebug("Cannot open file: %s\n", path.constData());
-        return;
+    if (lvFile) {
+        auto path = option.file().toLocal8Bit();
+        auto pf = fopen(path.constData(), "a");
+        if (pf)
+            s_file = QSharedPointer<FILE>(pf, fclose);
+        else
+            qDebug("Cannot open file: %s\n", path.constData());
     }
-    s_file = QSharedPointer<FILE>(pf, fclose);
+    if (!s_writer.isActive())
+        s_writer.activate();
 }
 
 auto Log::option() -> const LogOption&
@@ -126,15 +338,13 @@ auto Log::option() -> const LogOption&
     return s_option;
 }
 
-auto Log::maximumLevel() -> Level
-{
-    return lvMax;
-}
-
 auto Log::subscribe(QObject *o, int event) -> int
 {
     QWriteLocker l(&s_rwLock);
     s_subscribers.insert(o, event);
+    if (!s_backlog.isEmpty())
+        _PostEvent(o, event, s_backlog);
+    s_backlog.clear();
     return s_option.lines() ? s_option.lines() : _Max<int>();
 }
 
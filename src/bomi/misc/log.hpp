@@ -58,6 +58,12 @@ class Log {
     constexpr static const char *l2t = " FEWIDT";
 public:
     enum Level { Off, Fatal, Error, Warn, Info, Debug, Trace };
+    // lines above this level are compiled out, including their arguments
+#ifdef BOMI_NO_TRACE_LOG
+    static constexpr Level CompiledLevel = Debug;
+#else
+    static constexpr Level CompiledLevel = Trace;
+#endif
     template<class F>
     static auto write(Level level, F &&getLogText) -> void
     {
@@ -84,8 +90,13 @@ public:
         const int index = m_options.indexOf(name);
         return index < 0 ? Off : (Level)index;
     }
+    // lines are queued and written in another thread after setOption()
     static auto print(Level lv, const QByteArray &log) -> void;
-    static auto maximumLevel() -> Level;
+    // block until every queued line is written out
+    static auto flush() -> void;
+    // stop writer thread, following lines are written synchronously
+    static auto finalize() -> void;
+    static auto maximumLevel() -> Level { return m_maxLevel; }
     static auto setOption(const LogOption &option) -> void;
     static auto option() -> const LogOption&;
     static auto qt(QtMsgType type, const QMessageLogContext &context, const QString &msg) -> void;
@@ -151,8 +162,10 @@ private:
 #define DECLARE_LOG_CONTEXT(ctx) \
     static inline const char *getLogContext() { return (#ctx); }
 
-#define _WriteLog(lv, fmt, ...) Log::write(lv, [&] () \
-    { return std::move(Log::parse(lv, getLogContext(), fmt, ##__VA_ARGS__)); })
+// arguments are converted only if some output takes the level
+#define _WriteLog(lv, fmt, ...) (Log::CompiledLevel < lv ? (void)0 \
+    : Log::write(lv, [&] () \
+    { return std::move(Log::parse(lv, getLogContext(), fmt, ##__VA_ARGS__)); }))
 #define _Fatal(fmt, ...) _WriteLog(Log::Fatal, fmt, ##__VA_ARGS__)
 #define _Error(fmt, ...) _WriteLog(Log::Error, fmt, ##__VA_ARGS__)
 #define _Warn(fmt, ...)  _WriteLog(Log::Warn,  fmt, ##__VA_ARGS__)
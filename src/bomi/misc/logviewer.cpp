@@ -215,24 +215,36 @@ auto LogViewer::customEvent(QEvent *ev) -> void
         return;
     if (d->stop)
         return;
-    LogEntry entry;
-    _TakeData(ev, entry.level, entry.message);
-    Q_ASSERT(entry.message.at(3) == '['_q);
-    const int idx = entry.message.indexOf(']'_q, 4);
-    if (idx < 0) {
-        qDebug("Unknown logging context. Skip it.");
-        return;
+    // lines come in batches from log writer
+    QList<QPair<Log::Level, QString>> lines;
+    _TakeData(ev, lines);
+    QList<LogEntry> entries;
+    entries.reserve(lines.size());
+    bool added = false;
+    for (auto &line : lines) {
+        LogEntry entry;
+        entry.level = line.first;
+        entry.message = line.second;
+        Q_ASSERT(entry.message.at(3) == '['_q);
+        const int idx = entry.message.indexOf(']'_q, 4);
+        if (idx < 0) {
+            qDebug("Unknown logging context. Skip it.");
+            continue;
+        }
+        entry.context = entry.message.mid(4, idx -4 );
+        added |= d->newContext(entry.context, true);
+        entries.push_back(entry);
     }
-    entry.context = entry.message.mid(4, idx -4 );
-    d->model.append(entry);
+    d->model.append(entries);
 
-    if (d->newContext(entry.context, true)) {
+    if (added) {
         d->ui.context->sortItems();
         d->syncContext();
     }
 
-    if (d->model.rows() > d->lines)
-        d->model.remove(0);
+    const int over = d->model.rows() - d->lines;
+    if (over > 0)
+        d->model.removeRows(0, over, QModelIndex());
     if (d->ui.autoscroll->isChecked())
         d->ui.view->scrollToBottom();
 }
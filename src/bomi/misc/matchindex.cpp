@@ -0,0 +1,95 @@
+#include "matchindex.hpp"
+#include "matchstring.hpp"
+#include <numeric>
+
+MatchIndex::MatchIndex(const QStringList &texts)
+    : m_texts(texts)
+{
+    m_folded.reserve(m_texts.size());
+    for (int i = 0; i < m_texts.size(); ++i) {
+        m_folded.push_back(m_texts[i].toCaseFolded());
+        const auto &folded = m_folded.back();
+        const auto c = folded.unicode();
+        for (int j = 0; j + Gram <= folded.size(); ++j) {
+            auto &list = m_grams[gram(c + j)];
+            // postings are sorted and unique since texts are visited in order
+            if (list.isEmpty() || list.back() != i)
+                list.push_back(i);
+        }
+    }
+    for (auto &list : m_grams)
+        list.squeeze();
+}
+
+auto MatchIndex::postings(const QString &folded) const -> QVector<int>
+{
+    QVector<const QVector<int>*> lists;
+    const auto c = folded.unicode();
+    for (int j = 0; j + Gram <= folded.size(); ++j) {
+        const auto it = m_grams.constFind(gram(c + j));
+        if (it == m_grams.cend())
+            return QVector<int>();
+        lists.push_back(&*it);
+    }
+    std::sort(lists.begin(), lists.end(), [] (auto lhs, auto rhs)
+        { return lhs->size() < rhs->size(); });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+    QVector<int> result = *lists.front(), tmp;
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        tmp.clear();
+        std::set_intersection(result.begin(), result.end(),
+                              lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(tmp));
+        result.swap(tmp);
+    }
+    return result;
+}
+
+auto MatchIndex::find(const MatchString &query, const QVector<int> *candidates,
+                      const std::atomic<bool> *cancel) const -> QVector<int>
+{
+    QVector<int> all, narrowed, result;
+    if (!candidates) {
+        all.resize(m_texts.size());
+        std::iota(all.begin(), all.end(), 0);
+        candidates = &all;
+    }
+    if (query.string().isEmpty() || !query.isValid())
+        return *candidates;
+    const auto folded = query.isRegEx() ? QString() : query.string().toCaseFolded();
+    if (folded.size() >= Gram) {
+        const auto posted = postings(folded);
+        std::set_intersection(candidates->begin(), candidates->end(),
+                              posted.begin(), posted.end(),
+                              std::back_inserter(narrowed));
+        candidates = &narrowed;
+    }
+    result.reserve(candidates->size());
+    for (int i = 0; i < candidates->size(); ++i) {
+        if (cancel && !(i & 1023) && *cancel)
+            return QVector<int>();
+        const int idx = candidates->at(i);
+        bool matched = false;
+        if (query.isRegEx())
+            matched = query.contains(m_texts[idx]);
+        else if (query.isCaseSensitive())
+            matched = m_texts[idx].contains(query.string(), Qt::CaseSensitive);
+        else
+            matched = m_folded[idx].contains(folded, Qt::CaseSensitive);
+        if (matched)
+            result.push_back(idx);
+    }
+    return result;
+}
+
+auto MatchIndex::narrows(const MatchString &prev, const MatchString &next) -> bool
+{
+    if (prev.string().isEmpty() || !prev.isValid())
+        return true;
+    if (prev.isRegEx() || next.isRegEx())
+        return prev == next;
+    // case-insensitive matches include case-sensitive ones
+    if (prev.isCaseSensitive() && next.isCaseInsensitive())
+        return false;
+    return next.string().contains(prev.string(), prev.caseSensitivity());
+}
@@ -0,0 +1,30 @@
+#ifndef MATCHINDEX_HPP
+#define MATCHINDEX_HPP
+
+class MatchString;
+
+// substring search over fixed list of texts for MatchString filters
+// trigram postings narrow plain queries down before texts are compared
+// immutable after construction, so it can be shared between threads
+class MatchIndex {
+public:
+    MatchIndex() = default;
+    MatchIndex(const QStringList &texts);
+    auto size() const -> int { return m_texts.size(); }
+    auto text(int i) const -> const QString& { return m_texts[i]; }
+    // sorted positions of texts which contain query
+    // only positions in candidates are tested unless it is null
+    auto find(const MatchString &query, const QVector<int> *candidates = nullptr,
+              const std::atomic<bool> *cancel = nullptr) const -> QVector<int>;
+    // whether matches of next are subset of matches of prev
+    static auto narrows(const MatchString &prev, const MatchString &next) -> bool;
+private:
+    static constexpr int Gram = 3;
+    static auto gram(const QChar *c) -> quint64
+        { return (quint64)c[0].unicode() << 32 | (quint64)c[1].unicode() << 16 | c[2].unicode(); }
+    auto postings(const QString &folded) const -> QVector<int>;
+    QStringList m_texts, m_folded;
+    QHash<quint64, QVector<int>> m_grams;
+};
+
+#endif // MATCHINDEX_HPP
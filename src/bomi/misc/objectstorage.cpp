@@ -2,6 +2,7 @@
 #include "misc/log.hpp"
 #include <QMetaProperty>
 #include <QSettings>
+#include <QTimer>
 
 DECLARE_LOG_CONTEXT(ObjectStorage)
 
@@ -24,17 +25,45 @@ struct ObjectStorage::Data {
     QList<QByteArray> properties;
     QList<Alias> aliases;
     QList<RawData> data;
+    // values last read or written, only changed ones are written again
+    QHash<QString, QVariant> stored;
+    QTimer timer;
     bool autosave = false;
+    auto collect() const -> QList<QPair<QString, QVariant>>
+    {
+        QList<QPair<QString, QVariant>> values;
+        if (object->isWidgetType()) {
+            auto w = static_cast<const QWidget*>(object);
+            if (!w->parentWidget())
+                values.push_back({u"_b_geometry"_q, w->saveGeometry()});
+        }
+        for (auto &name : properties)
+            values.push_back({_L(name), object->property(name)});
+        for (auto &alias : aliases)
+            values.push_back({_L(alias.name), alias.property.read(alias.object)});
+        for (auto &raw : data)
+            values.push_back({_L(raw.name), raw.get()});
+        return values;
+    }
+    auto value(const QString &key, const QVariant &def) -> QVariant
+    {
+        if (!s->contains(key))
+            return def;
+        return stored[key] = s->value(key);
+    }
 };
 
 ObjectStorage::ObjectStorage(QObject *parent)
     : QObject(parent), d(new Data)
 {
+    d->timer.setSingleShot(true);
+    d->timer.setInterval(500);
+    connect(&d->timer, &QTimer::timeout, this, &ObjectStorage::save);
 }
 
 ObjectStorage::~ObjectStorage()
 {
-    if (d->autosave)
+    if (d->autosave || d->timer.isActive())
         save();
     else
         close();
@@ -83,8 +112,10 @@ auto ObjectStorage::close() -> void
 auto ObjectStorage::write(const char *name, const QVariant &var) -> void
 {
     Q_ASSERT(d->s);
-    if (d->s)
+    if (d->s) {
         d->s->setValue(_L(name), var);
+        d->stored[_L(name)] = var;
+    }
 }
 
 auto ObjectStorage::read(const char *name, const QVariant &def) const -> QVariant
@@ -97,28 +128,36 @@ auto ObjectStorage::read(const char *name, const QVariant &def) const -> QVarian
 
 auto ObjectStorage::save() -> void
 {
+    d->timer.stop();
     if (!d->object)
         return;
+    auto values = d->collect();
+    for (int i = 0; i < values.size(); ) {
+        auto it = d->stored.constFind(values[i].first);
+        if (it != d->stored.cend() && *it == values[i].second)
+            values.removeAt(i);
+        else
+            ++i;
+    }
+    // nothing changed, so don't touch the file
+    if (values.isEmpty())
+        return;
     const bool was = d->s;
     if (!was)
         open();
-
-    if (d->object->isWidgetType()) {
-        auto w = static_cast<const QWidget*>(d->object);
-        if (!w->parentWidget())
-            d->s->setValue(u"_b_geometry"_q, w->saveGeometry());
+    for (auto &v : values) {
+        d->s->setValue(v.first, v.second);
+        d->stored[v.first] = v.second;
     }
-    for (auto &name : d->properties)
-        d->s->setValue(_L(name), d->object->property(name));
-    for (auto &alias : d->aliases)
-        d->s->setValue(_L(alias.name), alias.property.read(alias.object));
-    for (auto &data : d->data)
-        d->s->setValue(_L(data.name), data.get());
-
     if (!was)
         close();
 }
 
+auto ObjectStorage::saveLater() -> void
+{
+    d->timer.start();
+}
+
 auto ObjectStorage::add(const char *property) -> void
 {
     d->properties.push_back(property);
@@ -135,17 +174,17 @@ auto ObjectStorage::restore() -> void
     if (d->object->isWidgetType()) {
         auto w = static_cast<QWidget*>(d->object);
         if (!w->parentWidget()) {
-            auto g = d->s->value(u"_b_geometry"_q).toByteArray();
+            auto g = d->value(u"_b_geometry"_q, QVariant()).toByteArray();
             if (!g.isEmpty())
                 w->restoreGeometry(g);
         }
     }
     for (auto &name : d->properties)
-        d->object->setProperty(name, d->s->value(_L(name), d->object->property(name)));
+        d->object->setProperty(name, d->value(_L(name), d->object->property(name)));
     for (auto &alias : d->aliases)
-        alias.property.write(alias.object, d->s->value(_L(alias.name), alias.property.read(alias.object)));
+        alias.property.write(alias.object, d->value(_L(alias.name), alias.property.read(alias.object)));
     for (auto &data : d->data)
-        data.set(d->s->value(_L(data.name), data.get()));
+        data.set(d->value(_L(data.name), data.get()));
 
     if (!was)
         close();
@@ -12,6 +12,8 @@ public:
     auto object() const -> QObject*;
     auto setObject(QObject *object, const QString &name) -> bool;
     auto save() -> void;
+    // coalesce frequent changes into one save
+    auto saveLater() -> void;
     auto restore() -> void;
     auto open() -> void;
     auto close() -> void;
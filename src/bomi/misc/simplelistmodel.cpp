@@ -223,6 +223,30 @@ auto SimpleListModelBase::reset(int rows) -> void
     setSpecialRow(-1);
 }
 
+auto SimpleListModelBase::insertStates(int row, int count) -> void
+{
+    if (count <= 0)
+        return;
+    for (auto &v : d->checked)
+        v.insert(row, count, false);
+    emit rowsChanged(d->rows += count);
+    if (d->special >= row)
+        setSpecialRow(d->special + count);
+}
+
+auto SimpleListModelBase::removeStates(int row, int count) -> void
+{
+    if (count <= 0)
+        return;
+    for (auto &v : d->checked)
+        v.remove(row, count);
+    emit rowsChanged(d->rows -= count);
+    if (d->special >= row + count)
+        setSpecialRow(d->special - count);
+    else if (d->special >= row)
+        setSpecialRow(-1);
+}
+
 auto SimpleListModelBase::setSpecialRow(int row) -> void
 {
     if (d->special == row)
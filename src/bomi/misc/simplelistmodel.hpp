@@ -1,6 +1,8 @@
 #ifndef SIMPLELISTMODEL_HPP
 #define SIMPLELISTMODEL_HPP
 
+#include "tmp/type_traits.hpp"
+
 template<class T, class List> class SimpleListModel;
 
 class SimpleListModelBase : public QAbstractListModel {
@@ -36,6 +38,9 @@ signals:
 protected:
     auto resize(int rows) -> void;
     auto reset(int rows) -> void;
+    // keep row states in sync after rows have been inserted or removed
+    auto insertStates(int row, int count) -> void;
+    auto removeStates(int row, int count) -> void;
     auto setSpecialFont(const QFont &font) -> void;
     auto setSpecialRow(int row) -> void;
     virtual auto flags(int row, int column) const -> Qt::ItemFlags;
@@ -95,16 +100,49 @@ private:
     auto removeAt(int row) -> bool final
         { return _InRange0(row, m_list.size()) && (m_list.removeAt(row), true); }
     auto removeAll() -> void final { m_list.clear(); }
+    // rows without operator == are never shared, so setList() resets
+    template<class U = T>
+    static auto same(const U &lhs, const U &rhs)
+        -> tmp::enable_if_t<tmp::has_equal<U>(), bool> { return lhs == rhs; }
+    template<class U = T>
+    static auto same(const U &, const U &)
+        -> tmp::enable_unless_t<tmp::has_equal<U>(), bool> { return false; }
     Container m_list;
 };
 
+// only the range between common head and tail is removed and inserted,
+// so views keep delegates of unchanged rows
 template<class T, class List>
 auto SimpleListModel<T, List>::setList(const List &list) -> void
 {
-    beginResetModel();
-    m_list = list;
-    reset(m_list.size());
-    endResetModel();
+    const int n = m_list.size(), m = list.size();
+    int head = 0, tail = 0;
+    while (head < n && head < m && same(m_list.at(head), list.at(head)))
+        ++head;
+    while (tail < n - head && tail < m - head
+           && same(m_list.at(n - 1 - tail), list.at(m - 1 - tail)))
+        ++tail;
+    if (!head && !tail) {
+        beginResetModel();
+        m_list = list;
+        reset(m_list.size());
+        endResetModel();
+        return;
+    }
+    const int removed = n - head - tail, inserted = m - head - tail;
+    if (removed > 0) {
+        beginRemoveRows(QModelIndex(), head, head + removed - 1);
+        m_list.erase(m_list.begin() + head, m_list.begin() + head + removed);
+        removeStates(head, removed);
+        endRemoveRows();
+    }
+    if (inserted > 0) {
+        beginInsertRows(QModelIndex(), head, head + inserted - 1);
+        m_list = list;
+        insertStates(head, inserted);
+        endInsertRows();
+    } else
+        m_list = list;
 }
 
 template<class T, class List>
@@ -3,13 +3,16 @@
 
 #include <QElapsedTimer>
 #include <functional>
-#include <deque>
+#include <algorithm>
+#include <vector>
+#include <cmath>
 
+// rate of a growing value over last max pushes, also usable as interval meter
+// records live in a ring allocated only by setDequeSize(), so push() and
+// rate or jitter queries are O(1)
 template<class T>
 class SpeedMeasure {
     struct Record {
-        Record(quint64 time, const T &value)
-            : value(value), usec(time) { }
         T value = 0;
         quint64 usec = 0;
     };
@@ -19,15 +22,24 @@ public:
         setDequeSize(min, max);
         m_watch.start();
     }
-    auto reset() -> void { m_records.clear(); m_last = 0; }
+    auto reset() -> void { m_size = 0; m_squares = 0; m_last = 0; }
     auto get() const -> double
-        { return ((int)m_records.size() < m_min) ? 0.0 : dvalue()/dsec(); }
+        { return (m_size < m_min) ? 0.0 : dvalue()/dsec(); }
     auto push(const T &t) -> void
     {
         const quint64 usec = m_watch.nsecsElapsed() * 1e-3;
-        m_records.emplace_back(usec, t);
-        while ((int)m_records.size() > m_max)
-            m_records.pop_front();
+        const int capacity = m_records.size();
+        if (m_size == capacity) {
+            // oldest interval leaves with oldest record
+            m_squares -= square(at(1).usec - at(0).usec);
+            --m_size;
+        }
+        if (m_size > 0)
+            m_squares += square(usec - back().usec);
+        m_head = (m_head + 1) % capacity;
+        m_records[m_head].value = t;
+        m_records[m_head].usec = usec;
+        ++m_size;
         if (m_interval > 0 && m_timer) {
             if (!m_last || m_last > usec ) {
                 m_last = usec;
@@ -37,27 +49,71 @@ public:
             }
         }
     }
-    auto count() const -> int { return m_records.size(); }
+    auto count() const -> int { return m_size; }
     auto setDequeSize(int min, int max) -> void
     {
         Q_ASSERT(min > 1 && min <= max);
         m_min = min;
         m_max = max;
-        while ((int)m_records.size() > m_max)
-            m_records.pop_front();
+        // keep newest ones in order from start of new ring
+        std::vector<Record> records(max);
+        const int size = qMin(m_size, max);
+        for (int i = 0; i < size; ++i)
+            records[i] = at(m_size - size + i);
+        m_records.swap(records);
+        m_scratch.reserve(max);
+        m_size = size;
+        m_head = size > 0 ? size - 1 : max - 1;
+        m_squares = 0;
+        for (int i = 1; i < m_size; ++i)
+            m_squares += square(at(i).usec - at(i - 1).usec);
     }
     auto dusec() const -> quint64
-        { return m_records.back().usec - m_records.front().usec; }
+        { return back().usec - front().usec; }
     auto dsec() const -> double { return dusec() * 1e-6; }
     auto dvalue() const -> T
-        { return m_records.back().value - m_records.front().value; }
+        { return back().value - front().value; }
+    // mean and standard deviation of intervals between pushes in us
+    auto interval() const -> double
+        { return m_size < 2 ? 0.0 : dusec() / double(m_size - 1); }
+    auto jitter() const -> double
+    {
+        if (m_size < 2)
+            return 0.0;
+        const double mean = interval();
+        const double var = m_squares / double(m_size - 1) - mean * mean;
+        return var > 0.0 ? std::sqrt(var) : 0.0;
+    }
+    // p in [0, 1] of intervals in us, O(count) without allocation
+    auto percentile(double p) const -> double
+    {
+        if (m_size < 2)
+            return 0.0;
+        m_scratch.clear();
+        for (int i = 1; i < m_size; ++i)
+            m_scratch.push_back(at(i).usec - at(i - 1).usec);
+        const auto nth = m_scratch.begin()
+                + qBound<int>(0, p * m_scratch.size(), m_scratch.size() - 1);
+        std::nth_element(m_scratch.begin(), nth, m_scratch.end());
+        return *nth;
+    }
     auto setTimer(std::function<void(void)> &&timer,
                   quint64 usec = 5000000) -> void
         { m_timer = std::move(timer); m_interval = usec; }
 private:
-    std::deque<Record> m_records;
-    int m_min = 2, m_max = 20;
-    quint64 m_last = 0, m_interval = 0;
+    static auto square(quint64 v) -> quint64 { return v * v; }
+    // i-th oldest record
+    auto at(int i) const -> const Record&
+    {
+        const int capacity = m_records.size();
+        return m_records[(m_head - m_size + 1 + i + capacity) % capacity];
+    }
+    auto front() const -> const Record& { return at(0); }
+    auto back() const -> const Record& { return m_records[m_head]; }
+    std::vector<Record> m_records;
+    mutable std::vector<quint64> m_scratch;
+    int m_min = 2, m_max = 20, m_size = 0, m_head = 0;
+    quint64 m_squares = 0, m_last = 0, m_interval = 0;
     std::function<void(void)> m_timer;
     QElapsedTimer m_watch;
 };
@@ -0,0 +1,49 @@
+#include "startuptrace.hpp"
+#include "log.hpp"
+#include <QElapsedTimer>
+
+DECLARE_LOG_CONTEXT(Startup)
+
+struct Phase { const char *name; qint64 msecs; };
+
+static QElapsedTimer s_timer;
+static QVector<Phase> s_phases;
+static bool s_enabled = false, s_finished = false;
+
+auto StartupTrace::start() -> void
+{
+    s_timer.start();
+}
+
+auto StartupTrace::setEnabled(bool enabled) -> void
+{
+    s_enabled = enabled;
+    if (!s_enabled)
+        s_phases.clear();
+}
+
+auto StartupTrace::isEnabled() -> bool
+{
+    return s_enabled && !s_finished;
+}
+
+auto StartupTrace::mark(const char *phase) -> void
+{
+    if (isEnabled() && s_timer.isValid())
+        s_phases.push_back({ phase, s_timer.elapsed() });
+}
+
+auto StartupTrace::finish(const char *phase) -> void
+{
+    if (!isEnabled())
+        return;
+    mark(phase);
+    s_finished = true;
+    qint64 last = 0;
+    for (auto &p : s_phases) {
+        _Info("%%: %%ms (+%%ms)", p.name, p.msecs, p.msecs - last);
+        last = p.msecs;
+    }
+    s_phases.clear();
+    s_phases.squeeze();
+}
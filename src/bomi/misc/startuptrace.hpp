@@ -0,0 +1,18 @@
+#ifndef STARTUPTRACE_HPP
+#define STARTUPTRACE_HPP
+
+// elapsed time of each startup phase, written to log once startup finishes
+// all functions should be called in gui thread only
+class StartupTrace {
+public:
+    // call as early as possible, before QApplication
+    static auto start() -> void;
+    static auto setEnabled(bool enabled) -> void;
+    static auto isEnabled() -> bool;
+    // phase is a string literal which ends now
+    static auto mark(const char *phase) -> void;
+    // mark last phase and print all of them, later calls are ignored
+    static auto finish(const char *phase) -> void;
+};
+
+#endif // STARTUPTRACE_HPP
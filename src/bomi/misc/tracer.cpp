@@ -0,0 +1,137 @@
+#include "tracer.hpp"
+#include "log.hpp"
+#include <QThread>
+#include <QFile>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+DECLARE_LOG_CONTEXT(Trace)
+
+static constexpr int SpanMax = 1 << 15; // per thread
+
+struct TraceSpan { const char *name; qint64 begin, end; };
+
+// written by its thread, read by exporter, so lock is hardly ever contended
+struct TraceBuffer {
+    int tid = 0;
+    QByteArray name;
+    std::mutex mutex;
+    std::vector<TraceSpan> spans;
+    int next = 0;
+    bool wrapped = false;
+};
+
+static std::atomic<bool> s_recording{false};
+static std::mutex s_mutex;
+// buffers outlive their threads so that spans of finished threads remain
+static std::vector<std::unique_ptr<TraceBuffer>> s_buffers;
+static thread_local TraceBuffer *t_buffer = nullptr;
+
+static auto buffer() -> TraceBuffer*
+{
+    if (t_buffer)
+        return t_buffer;
+    std::unique_ptr<TraceBuffer> buffer(new TraceBuffer);
+    buffer->spans.resize(SpanMax);
+    std::lock_guard<std::mutex> locker(s_mutex);
+    buffer->tid = s_buffers.size() + 1;
+    if (auto thread = QThread::currentThread())
+        buffer->name = thread->objectName().toUtf8();
+    if (buffer->name.isEmpty())
+        buffer->name = "Thread " + QByteArray::number(buffer->tid);
+    t_buffer = buffer.get();
+    s_buffers.push_back(std::move(buffer));
+    return t_buffer;
+}
+
+auto Tracer::isRecording() -> bool
+{
+    return s_recording.load(std::memory_order_relaxed);
+}
+
+auto Tracer::start() -> void
+{
+    std::lock_guard<std::mutex> locker(s_mutex);
+    for (auto &b : s_buffers) {
+        std::lock_guard<std::mutex> locker(b->mutex);
+        b->next = 0;
+        b->wrapped = false;
+    }
+    s_recording.store(true, std::memory_order_relaxed);
+    _Info("Start recording trace.");
+}
+
+auto Tracer::stop() -> void
+{
+    if (s_recording.exchange(false))
+        _Info("Stop recording trace.");
+}
+
+auto Tracer::now() -> qint64
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+auto Tracer::record(const char *name, qint64 begin, qint64 end) -> void
+{
+    if (!isRecording())
+        return;
+    auto b = buffer();
+    std::lock_guard<std::mutex> locker(b->mutex);
+    b->spans[b->next] = { name, begin, end };
+    if (++b->next >= SpanMax) {
+        b->next = 0;
+        b->wrapped = true;
+    }
+}
+
+auto Tracer::toJson() -> QByteArray
+{
+    // written by hand, QJsonDocument would take long for many spans
+    QByteArray json;
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto append = [&] (const QByteArray &event) {
+        if (!first)
+            json += ",\n";
+        json += event;
+        first = false;
+    };
+    auto escaped = [] (QByteArray text) {
+        text.replace('\\', "\\\\").replace('"', "\\\"");
+        return text;
+    };
+    auto us = [] (qint64 ns) { return QByteArray::number(ns * 1e-3, 'f', 3); };
+    std::lock_guard<std::mutex> locker(s_mutex);
+    for (auto &b : s_buffers) {
+        const auto tid = QByteArray::number(b->tid);
+        append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+               + ",\"args\":{\"name\":\"" + escaped(b->name) + "\"}}");
+        std::lock_guard<std::mutex> locker(b->mutex);
+        const int count = b->wrapped ? SpanMax : b->next;
+        const int from = b->wrapped ? b->next : 0;
+        json.reserve(json.size() + count * 80);
+        for (int i = 0; i < count; ++i) {
+            const auto &s = b->spans[(from + i) % SpanMax];
+            append("{\"name\":\"" + escaped(s.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   + tid + ",\"ts\":" + us(s.begin) + ",\"dur\":" + us(s.end - s.begin) + "}");
+        }
+    }
+    json += "]}\n";
+    return json;
+}
+
+auto Tracer::save(const QString &fileName) -> bool
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        _Error("Cannot open %% to save trace.", fileName);
+        return false;
+    }
+    file.write(toJson());
+    _Info("Trace has been saved in %%.", fileName);
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+// spans of work in every thread on one monotonic clock,
+// exported as trace event json for chrome://tracing or perfetto
+// each thread writes into its own buffer, which keeps last spans only
+// while not recording, a marker costs one relaxed load
+class Tracer {
+public:
+    static auto isRecording() -> bool;
+    // clears old spans
+    static auto start() -> void;
+    static auto stop() -> void;
+    // ns on monotonic clock
+    static auto now() -> qint64;
+    // name should be a string literal or live as long as the application
+    static auto record(const char *name, qint64 begin, qint64 end) -> void;
+    static auto toJson() -> QByteArray;
+    static auto save(const QString &fileName) -> bool;
+    class Scope {
+    public:
+        Scope(const char *name)
+            : m_name(name), m_begin(isRecording() ? now() : -1) { }
+        ~Scope() { if (m_begin >= 0) record(m_name, m_begin, now()); }
+    private:
+        const char *m_name;
+        qint64 m_begin;
+    };
+};
+
+#define TRACE_SCOPE_CAT(a, b) a##b
+#define TRACE_SCOPE_VAR(line) TRACE_SCOPE_CAT(__trace_scope_, line)
+#define TRACE_SCOPE(name) Tracer::Scope TRACE_SCOPE_VAR(__LINE__)(name)
+
+#endif // TRACER_HPP
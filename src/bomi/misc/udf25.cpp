@@ -25,6 +25,8 @@
  */
 #include "udf25.hpp"
 #include "misc/log.hpp"
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
@@ -589,13 +591,80 @@ auto udf25::GetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int
   return 0;
 }
 
+auto udf25::setReadAhead(int blocks) -> void
+{
+  blocks = qMax(1, blocks);
+  if (blocks != m_readAhead) {
+    m_readAhead = blocks;
+    m_chunks.clear();
+  }
+}
+
+auto udf25::setCacheSize(int chunks) -> void
+{
+  m_cacheSize = qMax(1, chunks);
+  m_chunks.clear();
+}
+
+// chunks are aligned runs of read-ahead blocks, so sequential reads
+// hit the disk once per chunk instead of once per block
+auto udf25::chunk(qint64 index) -> const QByteArray*
+{
+  auto it = m_chunks.find(index);
+  if (it != m_chunks.end()) {
+    it->used = ++m_clock;
+    return &it->data;
+  }
+  if (m_chunks.size() >= m_cacheSize) {
+    auto lru = m_chunks.begin();
+    for (auto it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+      if (it->used < lru->used)
+        lru = it;
+    }
+    m_chunks.erase(lru);
+  }
+  const qint64 len = m_readAhead * (qint64)DVD_VIDEO_LB_LEN;
+  Chunk chunk;
+  chunk.data.resize(len);
+  m_fp->clear();
+  if (!m_fp->seekg(index * len))
+    return nullptr;
+  m_fp->read(chunk.data.data(), len);
+  chunk.data.resize(m_fp->gcount());
+  chunk.used = ++m_clock;
+  return &m_chunks.insert(index, chunk)->data;
+}
+
 auto udf25::ReadAt( int64_t pos, size_t len, unsigned char *data ) -> int
 {
-  if (!m_fp->seekg(pos))
-    return -1;
-  if (!m_fp->read((char*)data, len))
+  if (m_map) {
+    const qint64 size = m_image.size();
+    if (pos < 0 || pos > size)
+      return -1;
+    if (pos + (qint64)len > size) {
+      _Error("ReadFile - less data than requested available!");
+      len = size - pos;
+    }
+    memcpy(data, m_map + pos, len);
+    return len;
+  }
+  const qint64 chunkLen = m_readAhead * (qint64)DVD_VIDEO_LB_LEN;
+  size_t done = 0;
+  while (done < len) {
+    const qint64 at = pos + done;
+    auto cached = chunk(at / chunkLen);
+    if (!cached)
+      return done ? (int)done : -1;
+    const qint64 offset = at % chunkLen;
+    const qint64 n = qMin<qint64>(cached->size() - offset, len - done);
+    if (n <= 0)
+      break;
+    memcpy(data + done, cached->constData() + offset, n);
+    done += n;
+  }
+  if (done < len)
     _Error("ReadFile - less data than requested available!");
-  return m_fp->gcount();
+  return done;
 }
 
 auto udf25::DVDReadLBUDF( quint32 lb_number, size_t block_count, unsigned char *data, int /*encrypted*/ ) -> int
@@ -963,6 +1032,7 @@ udf25::udf25( )
 
 udf25::~udf25( )
 {
+  saveIndex();
   delete m_fp;
   free(m_udfcache);
 }
@@ -1054,8 +1124,17 @@ auto udf25::UDFFindFile( const char* filename, quint64 *filesize ) -> FileAD*
   return result;
 }
 
-auto udf25::Open(const char *isofile) -> bool
+auto udf25::Open(const char *isofile, bool mapped) -> bool
 {
+  if (mapped) {
+    m_image.setFileName(QString::fromLocal8Bit(isofile));
+    if (m_image.open(QFile::ReadOnly))
+      m_map = m_image.map(0, m_image.size());
+    if (!m_map) {
+      _Warn("Cannot map image. Fall back to cached reading.");
+      m_image.close();
+    }
+  }
   m_fp = new std::fstream(isofile, std::ios::binary | std::ios::in);
 
   if(!m_fp->is_open())
@@ -1065,9 +1144,125 @@ auto udf25::Open(const char *isofile) -> bool
     m_fp = NULL;
     return false;
   }
+  loadIndex(QString::fromLocal8Bit(isofile));
   return true;
 }
 
+static constexpr quint32 IndexMagic = 0x75646678; // 'udfx'
+static constexpr qint32 IndexVersion = 1;
+
+// keyed by path, size and modification time of image
+static auto indexPath(const QString &isofile) -> QString
+{
+  const QFileInfo info(isofile);
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(info.absoluteFilePath().toUtf8());
+  hash.addData(QByteArray::number(info.size()));
+  hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+  return _WritablePath(Location::Cache) % "/udf/"_a
+          % _L(hash.result().toHex()) % ".idx"_a;
+}
+
+auto udf25::loadIndex(const QString &isofile) -> void
+{
+  m_index = Index();
+  m_index.path = indexPath(isofile);
+  QFile file(m_index.path);
+  if (!file.open(QFile::ReadOnly))
+    return;
+  QDataStream in(&file);
+  quint32 magic = 0; qint32 version = 0;
+  in >> magic >> version;
+  if (magic != IndexMagic || version != IndexVersion)
+    return;
+  qint32 files = 0;
+  in >> files;
+  for (int i = 0; i < files && in.status() == QDataStream::Ok; ++i) {
+    QString path; IndexedFile f; qint32 ads = 0;
+    in >> path >> f.Length >> f.Partition >> f.Partition_Start
+       >> f.Partition_Start_Correction >> f.Type >> f.Flags >> ads;
+    if (ads < 0 || ads > UDF_MAX_AD_CHAINS)
+      break;
+    f.ADs.resize(ads);
+    for (auto &ad : f.ADs)
+      in >> ad.Location >> ad.Length >> ad.Flags >> ad.Partition;
+    m_index.files.insert(path, f);
+  }
+  in >> m_index.dirs;
+  if (in.status() != QDataStream::Ok) {
+    _Warn("Directory index is broken: %%", m_index.path);
+    const auto path = m_index.path;
+    m_index = Index();
+    m_index.path = path;
+    return;
+  }
+  _Debug("Directory index loaded: %% files, %% directories",
+         m_index.files.size(), m_index.dirs.size());
+}
+
+auto udf25::saveIndex() -> void
+{
+  if (!m_index.dirty || m_index.path.isEmpty())
+    return;
+  QDir().mkpath(QFileInfo(m_index.path).absolutePath());
+  QFile file(m_index.path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    _Warn("Cannot write directory index: %%", m_index.path);
+    return;
+  }
+  QDataStream out(&file);
+  out << IndexMagic << IndexVersion << (qint32)m_index.files.size();
+  for (auto it = m_index.files.cbegin(); it != m_index.files.cend(); ++it) {
+    const auto &f = *it;
+    out << it.key() << f.Length << f.Partition << f.Partition_Start
+        << f.Partition_Start_Correction << f.Type << f.Flags << (qint32)f.ADs.size();
+    for (auto &ad : f.ADs)
+      out << ad.Location << ad.Length << ad.Flags << ad.Partition;
+  }
+  out << m_index.dirs;
+  m_index.dirty = false;
+}
+
+// UDFFindFile() through index, which remembers misses too
+auto udf25::findFile(const QString &path, quint64 *filesize) -> FileAD*
+{
+  *filesize = 0;
+  auto it = m_index.files.constFind(path);
+  if (it != m_index.files.cend()) {
+    if (it->ADs.isEmpty())
+      return nullptr;
+    auto result = (struct FileAD *) malloc(sizeof(FileAD));
+    if (!result)
+      return nullptr;
+    memset(result, 0, sizeof(*result));
+    result->Length = it->Length;
+    result->num_AD = it->ADs.size();
+    result->Partition = it->Partition;
+    result->Partition_Start = it->Partition_Start;
+    result->Partition_Start_Correction = it->Partition_Start_Correction;
+    result->Type = it->Type;
+    result->Flags = it->Flags;
+    memcpy(result->AD_chain, it->ADs.constData(), it->ADs.size() * sizeof(AD));
+    *filesize = result->Length;
+    return result;
+  }
+  auto result = UDFFindFile(path.toLocal8Bit(), filesize);
+  IndexedFile f;
+  if (result) {
+    f.Length = result->Length;
+    f.Partition = result->Partition;
+    f.Partition_Start = result->Partition_Start;
+    f.Partition_Start_Correction = result->Partition_Start_Correction;
+    f.Type = result->Type;
+    f.Flags = result->Flags;
+    f.ADs.resize(result->num_AD);
+    memcpy(f.ADs.data(), result->AD_chain, result->num_AD * sizeof(AD));
+  }
+  m_index.files.insert(path, f);
+  m_index.dirty = true;
+  return result;
+}
+
 
 
 //int64_t udf25::GetFileSize(HANDLE hFile)
@@ -1095,7 +1290,7 @@ auto udf25::Open(const char *isofile) -> bool
 
 File::File(udf25 *udf, const QString &fileName): m_udf(udf) {
     if (udf->m_fp)
-        m_file = udf->UDFFindFile(fileName.toLocal8Bit(), &m_size);
+        m_file = udf->findFile(fileName, &m_size);
 }
 
 File::~File() {
@@ -1119,7 +1314,7 @@ auto File::read(char *buffer, qint64 size) -> qint64
     quint64 pos;
     int      ret;
     while(size > 0) {
-        auto len = UDFFilePos(m_file, m_seek_pos, &pos);
+        auto len = locate(m_seek_pos, &pos);
         if(!len)
             break;
         // correct for partition indirection if applicable
@@ -1151,6 +1346,32 @@ auto File::close() -> void
     m_file = nullptr;
     m_size = 0;
     m_seek_pos = 0;
+    m_ad = 0;
+    m_adStart = 0;
+}
+
+// same as UDFFilePos() but resumes from last descriptor for sequential reads
+auto File::locate(quint64 pos, quint64 *res) -> quint32
+{
+    if (pos < m_adStart) {
+        m_ad = 0;
+        m_adStart = 0;
+    }
+    for (; m_ad < m_file->num_AD; ++m_ad) {
+        const auto &ad = m_file->AD_chain[m_ad];
+        if (pos - m_adStart < ad.Length)
+            break;
+        m_adStart += ad.Length;
+    }
+    if (m_ad >= m_file->num_AD) {
+        m_ad = 0;
+        m_adStart = 0;
+        return 0;
+    }
+    const auto &ad = m_file->AD_chain[m_ad];
+    const auto offset = pos - m_adStart;
+    *res = (quint64)(m_file->Partition_Start + ad.Location) * DVD_VIDEO_LB_LEN + offset;
+    return ad.Length - (quint32)offset;
 }
 
 auto File::seek(int64_t offset, int whence) -> int64_t
@@ -1179,6 +1400,12 @@ auto File::seek(int64_t offset, int whence) -> int64_t
 }
 
 Dir::Dir(udf25 *udf, const QString &path): m_udf(udf), m_path(path) {
+    auto indexed = udf->m_index.dirs.constFind(path);
+    if (indexed != udf->m_index.dirs.cend()) {
+        m_files = *indexed;
+        m_open = true;
+        return;
+    }
     File file(udf, path);
     if (!file.isOpen())
       return;
@@ -1204,6 +1431,8 @@ Dir::Dir(udf25 *udf, const QString &path): m_udf(udf), m_path(path) {
             continue;
         m_files.append(file);
     }
+    udf->m_index.dirs.insert(path, m_files);
+    udf->m_index.dirty = true;
 }
 
 auto Dir::files(bool withPath) const -> QStringList
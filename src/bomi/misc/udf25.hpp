@@ -27,6 +27,7 @@
  */
 
 #include <fstream>
+#include <QFile>
 
 namespace udf {
 
@@ -179,8 +180,32 @@ class udf25
 public:
   udf25( );
   ~udf25( );
-  auto Open(const char *isofile) -> bool;
+  // mapped mode reads a local image through memory map instead of cache
+  auto Open(const char *isofile, bool mapped = false) -> bool;
+  // blocks read at once on cache miss and number of such chunks kept in lru
+  auto setReadAhead(int blocks) -> void;
+  auto setCacheSize(int chunks) -> void;
 private:
+  struct Chunk { QByteArray data; quint64 used = 0; };
+  auto chunk(qint64 index) -> const QByteArray*;
+  /* Directory index, stored per image in cache directory */
+  struct IndexedFile {
+    quint64 Length = 0;
+    quint16 Partition = 0;
+    quint32 Partition_Start = 0, Partition_Start_Correction = 0;
+    quint8  Type = 0;
+    quint16 Flags = 0;
+    QVector<AD> ADs; // empty if not found
+  };
+  struct Index {
+    QHash<QString, IndexedFile> files;
+    QHash<QString, QStringList> dirs;
+    QString path;
+    bool dirty = false;
+  };
+  auto findFile(const QString &path, quint64 *filesize) -> FileAD*;
+  auto loadIndex(const QString &isofile) -> void;
+  auto saveIndex() -> void;
   FileAD *UDFFindFile( const char* filename, quint64 *filesize );
   auto UDFScanDirX( udf_dir_t *dirp ) -> int;
   auto DVDUDFCacheLevel(int level) -> int;
@@ -201,6 +226,13 @@ protected:
   int m_udfcache_level; /* 0 - turned off, 1 - on */
   void *m_udfcache;
   std::fstream *m_fp;
+  /* Block cache */
+  QHash<qint64, Chunk> m_chunks;
+  quint64 m_clock = 0;
+  int m_readAhead = 32, m_cacheSize = 64;
+  QFile m_image;
+  const uchar *m_map = nullptr;
+  Index m_index;
 };
 
 
@@ -218,11 +250,15 @@ public:
     auto fileName() const -> QString { return m_fileName; }
 private:
     auto close() -> void;
+    auto locate(quint64 pos, quint64 *res) -> quint32;
     File(const File&) = delete;
     File &operator=(const File&) = delete;
     FileAD *m_file = nullptr;
     quint64 m_seek_pos = 0;  // in bytes
     quint64 m_size = 0;  // in bytes
+    // allocation descriptor which covers last read and its file offset
+    quint32 m_ad = 0;
+    quint64 m_adStart = 0;
     QString m_fileName;
     udf25 *m_udf = nullptr;
 };
@@ -5,9 +5,41 @@
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QProcess>
+#include <QCryptographicHash>
+#include <QSet>
 
 DECLARE_LOG_CONTEXT(YouTubeDL)
 
+static constexpr int MaxPrefetch = 3, MaxCacheSize = 256;
+// in seconds, for results without expire parameter in urls
+static constexpr int DefaultLifetime = 10 * 60, ExpireMargin = 60;
+
+struct YouTubeCache {
+    QJsonObject json;
+    QDateTime expires;
+};
+
+// signed urls of youtube contain expire=<time_t> in query or path
+static auto expiry(const QJsonObject &json) -> QDateTime
+{
+    static const QRegEx rx(uR"([?&/]expire[=/](\d+))"_q);
+    qint64 expire = 0;
+    auto check = [&] (const QString &url) {
+        const auto m = rx.match(url);
+        if (!m.hasMatch())
+            return;
+        const auto t = m.capturedRef(1).toLongLong();
+        if (t > 0 && (!expire || t < expire))
+            expire = t;
+    };
+    check(json[u"url"_q].toString());
+    for (auto fmt : json[u"formats"_q].toArray())
+        check(fmt.toObject()[u"url"_q].toString());
+    if (!expire)
+        return QDateTime::currentDateTimeUtc().addSecs(DefaultLifetime);
+    return QDateTime::fromMSecsSinceEpoch((expire - ExpireMargin) * 1000);
+}
+
 static auto operator > (const YouTubeFormat &lhs, const YouTubeFormat &rhs) -> bool
 {
     if (lhs.isAudio() != rhs.isAudio())
@@ -118,6 +150,90 @@ struct YouTubeDL::Data {
     bool ask = false;
     int height = 720, fps = 0;
     QString container = u"webm"_q;
+    // guarded by mutex
+    QHash<QString, YouTubeCache> cache;
+    // gui thread only
+    QStringList queue;
+    QSet<QString> fetching;
+
+    auto cookies(const QString &url) const -> QString
+    {
+        const auto hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5);
+        return cookieDir.path() % "/cookies-"_a % _L(hash.toHex());
+    }
+    auto arguments(const QString &url) const -> QStringList
+    {
+        QStringList args;
+        if (!userAgent.isEmpty())
+            args << u"--user-agent"_q << userAgent;
+        args << u"--cookies"_q << cookies(url);
+        args << u"--flat-playlist"_q << u"--no-playlist"_q << u"--all-subs"_q;
+        args << u"--sub-format"_q
+             << (url.contains("crunchyroll.com"_a, Qt::CaseInsensitive) ? u"ass"_q : u"srt"_q);
+        args << u"-J"_q << url;
+        return args;
+    }
+    auto lookup(const QString &url, QJsonObject *json) -> bool
+    {
+        QMutexLocker locker(&mutex);
+        auto it = cache.find(url);
+        if (it == cache.end())
+            return false;
+        if (it->expires <= QDateTime::currentDateTimeUtc()) {
+            cache.erase(it);
+            return false;
+        }
+        if (json)
+            *json = it->json;
+        return true;
+    }
+    auto store(const QString &url, const QJsonObject &json) -> void
+    {
+        QMutexLocker locker(&mutex);
+        const auto now = QDateTime::currentDateTimeUtc();
+        if (cache.size() >= MaxCacheSize) {
+            for (auto it = cache.begin(); it != cache.end(); ) {
+                if (it->expires <= now)
+                    it = cache.erase(it);
+                else
+                    ++it;
+            }
+            if (cache.size() >= MaxCacheSize)
+                cache.erase(cache.begin());
+        }
+        cache[url] = { json, expiry(json) };
+    }
+    auto startPrefetch() -> void
+    {
+        while (fetching.size() < MaxPrefetch && !queue.isEmpty()) {
+            const auto url = queue.takeFirst();
+            if (lookup(url, nullptr))
+                continue;
+            fetching.insert(url);
+            auto proc = new QProcess(p);
+            auto done = [=] () {
+                fetching.remove(url);
+                proc->deleteLater();
+                startPrefetch();
+            };
+            connect(SIGNAL_VT(proc, finished, int, QProcess::ExitStatus), p,
+                    [=] (int code, QProcess::ExitStatus status) {
+                if (status == QProcess::NormalExit && !code) {
+                    const auto out = proc->readAllStandardOutput().trimmed();
+                    store(url, _JsonFromString(_L(out)));
+                    _Debug("Prefetched %%", url);
+                }
+                done();
+            });
+            connect(SIGNAL_VT(proc, error, QProcess::ProcessError), p,
+                    [=] (QProcess::ProcessError error) {
+                if (error == QProcess::FailedToStart)
+                    done();
+            });
+            QFile(cookies(url)).remove();
+            proc->start(program, arguments(url), QProcess::ReadOnly);
+        }
+    }
 };
 
 YouTubeDL::YouTubeDL(QObject *parent)
@@ -256,7 +372,7 @@ auto YouTubeDL::result() const -> Result
 
 auto YouTubeDL::cookies() const -> QString
 {
-    return d->cookieDir.path() % "/cookies"_a;
+    return d->cookies(d->input);
 }
 
 auto YouTubeDL::userAgent() const -> QString
@@ -285,15 +401,20 @@ auto YouTubeDL::run(const QString &url) -> bool
     d->input = url;
     d->json = QJsonObject();
     d->error = NoError;
+    QJsonObject json;
+    auto accept = [&] () {
+        // ported from mpv/player/lua/ytdl_hook.lua
+        if (json[u"direct"_q].toBool())
+            return false;
+        d->json = json;
+        return true;
+    };
+    if (d->lookup(url, &json)) {
+        _Debug("Use cached result for %%", url);
+        return accept();
+    }
     QFile(cookies()).remove();
-    QStringList args;
-    if (!d->userAgent.isEmpty())
-        args << u"--user-agent"_q << d->userAgent;
-    args << u"--cookies"_q << cookies();
-    args << u"--flat-playlist"_q << u"--no-playlist"_q << u"--all-subs"_q;
-    args << u"--sub-format"_q
-         << (url.contains("crunchyroll.com"_a, Qt::CaseInsensitive) ? u"ass"_q : u"srt"_q);
-    args << u"-J"_q << d->input;
+    const auto args = d->arguments(url);
 
     d->mutex.lock();
     d->proc = &proc;
@@ -333,13 +454,21 @@ auto YouTubeDL::run(const QString &url) -> bool
         return false;
     }
     auto out = proc.readAllStandardOutput().trimmed();
-    const auto json =_JsonFromString(_L(std::move(out)));
+    json = _JsonFromString(_L(std::move(out)));
+    d->store(url, json);
+    return accept();
+}
 
-    // ported from mpv/player/lua/ytdl_hook.lua
-    if (json[u"direct"_q].toBool())
-        return false;
-    d->json = json;
-    return true;
+auto YouTubeDL::prefetch(const QStringList &urls) -> void
+{
+    for (auto url : urls) {
+        if (!url.startsWith("http://"_a) && !url.startsWith("https://"_a))
+            continue;
+        url = QUrl(url).toString(QUrl::FullyEncoded); // same key as engine
+        if (!d->fetching.contains(url) && !d->queue.contains(url))
+            d->queue.push_back(url);
+    }
+    d->startPrefetch();
 }
 
 auto YouTubeDL::program() const -> QString
@@ -356,6 +485,13 @@ auto YouTubeDL::supports(const QString &url) -> bool
 {
     if (!url.startsWith("http://"_a) && !url.startsWith("https://"_a))
         return false;
+    static QMutex mutex;
+    static QHash<QString, bool> supported;
+    QMutexLocker locker(&mutex);
+    auto it = supported.constFind(url);
+    if (it != supported.cend())
+        return *it;
+    locker.unlock();
 
     QProcess proc;
     QStringList args;
@@ -369,9 +505,14 @@ auto YouTubeDL::supports(const QString &url) -> bool
         return false;
     if (proc.exitStatus() != QProcess::NormalExit)
         return false;
-    if (proc.exitCode())
-        return false;
-    const auto out = proc.readAllStandardOutput().trimmed();
-    const auto err = proc.readAllStandardError().trimmed();
-    return !out.isEmpty() && err.isEmpty();
+    bool res = false;
+    if (!proc.exitCode()) {
+        const auto out = proc.readAllStandardOutput().trimmed();
+        const auto err = proc.readAllStandardError().trimmed();
+        res = !out.isEmpty() && err.isEmpty();
+    }
+    // only definite answers are remembered
+    locker.relock();
+    supported.insert(url, res);
+    return res;
 }
@@ -57,7 +57,10 @@ public:
     auto setTimeout(int timeout) -> void;
     auto timeout() const -> int;
     auto cookies() const -> QString;
+    // result of url is reused until its signed urls expire
     auto run(const QString &url) -> bool;
+    // resolve urls in background processes into the cache used by run()
+    auto prefetch(const QStringList &urls) -> void;
     auto error() const -> Error;
     auto result() const -> Result;
     auto cancel() -> void;
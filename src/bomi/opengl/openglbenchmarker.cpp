@@ -1,18 +1,48 @@
 #include "openglbenchmarker.hpp"
-#include "misc/log.hpp"
 
-DECLARE_LOG_CONTEXT(OpenGL)
+auto OpenGLBenchmarker::create() -> bool
+{
+    m_valid = true;
+    for (auto &timer : m_timers)
+        m_valid &= timer.create();
+    if (!m_valid)
+        destroy();
+    m_head = m_pending = 0;
+    m_running = false;
+    return m_valid;
+}
+
+auto OpenGLBenchmarker::destroy() -> void
+{
+    for (auto &timer : m_timers)
+        timer.destroy();
+    m_valid = m_running = false;
+    m_head = m_pending = 0;
+}
+
+auto OpenGLBenchmarker::begin() -> void
+{
+    if (!m_valid || m_running || m_pending >= Queries)
+        return;
+    m_timers[(m_head + m_pending) % Queries].begin();
+    m_running = true;
+}
+
+auto OpenGLBenchmarker::end() -> void
+{
+    if (!m_running)
+        return;
+    m_timers[(m_head + m_pending) % Queries].end();
+    m_running = false;
+    ++m_pending;
+}
 
-void OpenGLBenchmarker::end()
+auto OpenGLBenchmarker::take() -> qint64
 {
-    m_timer.end();
-    m_ns += m_timer.waitForResult();
-    ++m_counter;
-    if (m_counter >= m_max) {
-        _Info("%%op/s (%%ms for %% operations)",
-              m_counter/(m_ns*1e-9),
-              m_ns/1000000.0, m_counter);
-        m_counter = 0;
-        m_ns = 0;
-    }
+    if (!m_pending || !m_timers[m_head].isResultAvailable())
+        return -1;
+    const qint64 ns = m_timers[m_head].waitForResult();
+    m_head = (m_head + 1) % Queries;
+    --m_pending;
+    return ns;
 }
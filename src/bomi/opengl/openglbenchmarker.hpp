@@ -2,24 +2,27 @@
 #define OPENGLBENCHMARKER_HPP
 
 #include <QOpenGLTimerQuery>
+#include <array>
 
+// gpu timer which never waits for results
+// results are taken a few frames later from a ring of queries
 class OpenGLBenchmarker {
 public:
+    static constexpr int Queries = 4;
     OpenGLBenchmarker() = default;
     OpenGLBenchmarker(bool init) { if (init) create(); }
-    void create() {
-        m_timer.create();
-        m_ns = 0;
-        m_counter = 0;
-    }
-    void destroy() { m_timer.destroy(); }
-    void begin() { m_timer.begin(); }
-    void end();
-    void setMaxCount(int n) { m_max = n; }
+    auto create() -> bool;
+    auto destroy() -> void;
+    auto isValid() const -> bool { return m_valid; }
+    // skipped if every query is still in flight
+    auto begin() -> void;
+    auto end() -> void;
+    // elapsed ns of oldest finished query, or -1 if none is available
+    auto take() -> qint64;
 private:
-    QOpenGLTimerQuery m_timer;
-    quint64 m_ns = 0;
-    int m_counter = 0, m_max = 100;
+    std::array<QOpenGLTimerQuery, Queries> m_timers;
+    int m_head = 0, m_pending = 0;
+    bool m_valid = false, m_running = false;
 };
 
 #endif // OPENGLBENCHMARKER_HPP
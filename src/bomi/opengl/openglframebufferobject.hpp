@@ -13,13 +13,24 @@ public:
     auto getCoords(double &x1, double &y1, double &x2, double &y2) const -> void
     {
         if (m_texture.target() == OGL::TargetRectangle) {
-            x1 = y1 = 0; x2 = m_texture.width(); y2 = m_texture.height();
-        } else { x1 = y1 = 0; x2 = y2 = 1; }
+            x1 = y1 = 0; x2 = m_size.width(); y2 = m_size.height();
+        } else {
+            x1 = y1 = 0;
+            x2 = m_size.width() / (double)m_texture.width();
+            y2 = m_size.height() / (double)m_texture.height();
+        }
     }
     auto format() const { return m_texture.format(); }
     auto bind(GLenum target = GL_FRAMEBUFFER) const -> void;
     auto release() const -> void;
+    // size in use from origin, which can be smaller than texture
     auto size() const -> QSize { return m_size; }
+    auto capacity() const -> QSize { return m_texture.size(); }
+    auto setSize(const QSize &size) -> void
+    {
+        Q_ASSERT(size.width() <= m_texture.width() && size.height() <= m_texture.height());
+        m_size = size;
+    }
     auto width() const -> int { return m_size.width(); }
     auto height() const -> int { return m_size.height(); }
     auto isValid() const -> bool { return m_complete; }
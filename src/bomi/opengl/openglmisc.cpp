@@ -44,6 +44,29 @@ auto hasExtension(Extension ext) -> bool
     return d.extensions & ext;
 }
 
+auto gpuMemory(double *free, double *total) -> bool
+{
+    static constexpr GLenum NvxTotal = 0x9048, NvxAvailable = 0x9049;
+    static constexpr GLenum AtiTextureFree = 0x87fc;
+    if (hasExtension(NvxGpuMemoryInfo)) {
+        GLint t = 0, a = 0;
+        glGetIntegerv(NvxTotal, &t);
+        glGetIntegerv(NvxAvailable, &a);
+        *free = a / 1024.0;
+        *total = t / 1024.0;
+        return true;
+    }
+    if (hasExtension(AtiMemInfo)) {
+        // free in pool, largest block, auxiliary free, auxiliary largest
+        GLint info[4] = {0, 0, 0, 0};
+        glGetIntegerv(AtiTextureFree, info);
+        *free = info[0] / 1024.0;
+        *total = -1.0;
+        return true;
+    }
+    return false;
+}
+
 auto check() -> QString
 {
     QOpenGLContext gl;
@@ -87,6 +110,12 @@ auto check() -> QString
     checkExtension("GLX_EXT_swap_control"_b, ExtSwapControl);
     checkExtension("GLX_SGI_swap_control"_b, SgiSwapControl);
     checkExtension("GLX_MESA_swap_control"_b, MesaSwapControl);
+    checkExtension("GL_ARB_sync"_b, Sync, 3, 2);
+    checkExtension("GL_ARB_map_buffer_range"_b, MapBufferRange, 3);
+    checkExtension("GL_ARB_buffer_storage"_b, BufferStorage, 4, 4);
+    checkExtension("GL_NVX_gpu_memory_info"_b, NvxGpuMemoryInfo);
+    checkExtension("GL_ATI_meminfo"_b, AtiMemInfo);
+    checkExtension("GL_ARB_instanced_arrays"_b, InstancedArrays, 3, 3);
 
     if (QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()) {
         extensions.push_back(u"GL_ARB_framebuffer_object"_q);
@@ -110,6 +139,7 @@ auto check() -> QString
         return ok;
     };
     testFbo(OGL::RGBA16_UNorm);
+    testFbo(OGL::RGB10A2_UNorm);
     testFbo(OGL::RGBA8_UNorm);
     if (d.fboFormats.isEmpty())
         return qApp->translate("OpenGL", "No available FBO texture format.\n"
@@ -85,6 +85,7 @@ enum TextureFormat { // internal format
     RG8_UNorm              = GL_RG8,
     RGB8_UNorm             = GL_RGB8,
     RGBA8_UNorm            = GL_RGBA8,
+    RGB10A2_UNorm          = GL_RGB10_A2,
     R16_UNorm              = GL_R16,
     RG16_UNorm             = GL_RG16,
     RGB16_UNorm            = GL_RGB16,
@@ -160,7 +161,13 @@ enum Extension {
     MesaYCbCrTexture  = 1 << 6,
     ExtSwapControl    = 1 << 7,
     SgiSwapControl    = 1 << 8,
-    MesaSwapControl   = 1 << 9
+    MesaSwapControl   = 1 << 9,
+    Sync              = 1 << 10,
+    MapBufferRange    = 1 << 11,
+    BufferStorage     = 1 << 12,
+    NvxGpuMemoryInfo  = 1 << 13,
+    AtiMemInfo        = 1 << 14,
+    InstancedArrays   = 1 << 15
 };
 
 auto initialize(QOpenGLContext *ctx, bool debug) -> void;
@@ -175,6 +182,10 @@ auto hasExtension(Extension ext) -> bool;
 
 auto maximumTextureSize() -> int;
 
+// MiB of video memory for current context, false if driver does not tell
+// total is negative when only free memory is known
+auto gpuMemory(double *free, double *total) -> bool;
+
 SIA rg(const char *rg) -> QByteArray
 {
     if (hasExtension(TextureRG))
@@ -219,6 +230,7 @@ SIA _ToLog(OGL::TextureFormat format) -> QByteArray {
     ENUM_CASE(OGL::RG8_UNorm);
     ENUM_CASE(OGL::RGB8_UNorm);
     ENUM_CASE(OGL::RGBA8_UNorm);
+    ENUM_CASE(OGL::RGB10A2_UNorm);
     ENUM_CASE(OGL::R16_UNorm);
     ENUM_CASE(OGL::RG16_UNorm);
     ENUM_CASE(OGL::RGB16_UNorm);
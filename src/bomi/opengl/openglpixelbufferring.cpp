@@ -0,0 +1,216 @@
+#include "openglpixelbufferring.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+
+static constexpr GLuint64 FenceTimeout = 1000000000; // 1s in ns
+
+struct PixelBuffer {
+    GLuint id = GL_NONE;
+    GLsync fence = nullptr;
+    int capacity = 0;
+    uchar *persistent = nullptr;
+};
+
+struct OpenGLPixelBufferRing::Data {
+    QOpenGLFunctions *func = nullptr;
+    // entry points not in QOpenGLFunctions
+    auto (QOPENGLF_APIENTRYP mapBuffer)(GLenum, GLenum) -> void* = nullptr;
+    auto (QOPENGLF_APIENTRYP unmapBuffer)(GLenum) -> GLboolean = nullptr;
+    auto (QOPENGLF_APIENTRYP mapBufferRange)(GLenum, GLintptr, GLsizeiptr,
+                                             GLbitfield) -> void* = nullptr;
+    auto (QOPENGLF_APIENTRYP bufferStorage)(GLenum, GLsizeiptr, const void*,
+                                            GLbitfield) -> void = nullptr;
+    auto (QOPENGLF_APIENTRYP fenceSync)(GLenum, GLbitfield) -> GLsync = nullptr;
+    auto (QOPENGLF_APIENTRYP clientWaitSync)(GLsync, GLbitfield,
+                                             GLuint64) -> GLenum = nullptr;
+    auto (QOPENGLF_APIENTRYP deleteSync)(GLsync) -> void = nullptr;
+
+    GLenum target = GL_PIXEL_UNPACK_BUFFER;
+    int count = 3, index = 0, offset = 0;
+    std::vector<PixelBuffer> buffers;
+    uchar *ptr = nullptr;
+    bool bound = false;
+
+    auto current() -> PixelBuffer& { return buffers[index]; }
+    auto wait(PixelBuffer &buffer) -> void
+    {
+        if (!buffer.fence)
+            return;
+        const auto res = clientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                        FenceTimeout);
+        if (res == GL_TIMEOUT_EXPIRED || res == GL_WAIT_FAILED)
+            _Warn("Pixel buffer %% is still in use after timeout.", buffer.id);
+        deleteSync(buffer.fence);
+        buffer.fence = nullptr;
+    }
+    // buffers from glBufferStorage are immutable, so reallocation needs new one
+    auto allocatePersistent(PixelBuffer &buffer, int size) -> bool
+    {
+        static constexpr GLbitfield flags = GL_MAP_WRITE_BIT
+                | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        if (buffer.persistent) {
+            func->glBindBuffer(target, buffer.id);
+            unmapBuffer(target);
+            buffer.persistent = nullptr;
+        }
+        func->glDeleteBuffers(1, &buffer.id);
+        func->glGenBuffers(1, &buffer.id);
+        func->glBindBuffer(target, buffer.id);
+        bufferStorage(target, size, nullptr, flags);
+        auto ptr = mapBufferRange(target, 0, size, flags);
+        buffer.persistent = static_cast<uchar*>(ptr);
+        buffer.capacity = buffer.persistent ? size : 0;
+        return buffer.persistent;
+    }
+};
+
+OpenGLPixelBufferRing::OpenGLPixelBufferRing(int count, GLenum target)
+    : d(new Data)
+{
+    d->count = qMax(1, count);
+    d->target = target;
+}
+
+OpenGLPixelBufferRing::~OpenGLPixelBufferRing()
+{
+    Q_ASSERT(d->buffers.empty());
+    delete d;
+}
+
+auto OpenGLPixelBufferRing::create() -> bool
+{
+    Q_ASSERT(d->buffers.empty());
+    auto ctx = QOpenGLContext::currentContext();
+    if (!ctx)
+        return false;
+    d->func = ctx->functions();
+#define RESOLVE(var, name) \
+    (d->var = reinterpret_cast<decltype(d->var)>(ctx->getProcAddress(name)))
+    if (!RESOLVE(mapBuffer, "glMapBuffer") || !RESOLVE(unmapBuffer, "glUnmapBuffer"))
+        return false;
+    if (OGL::hasExtension(OGL::MapBufferRange))
+        RESOLVE(mapBufferRange, "glMapBufferRange");
+    if (OGL::hasExtension(OGL::Sync)) {
+        if (!RESOLVE(fenceSync, "glFenceSync")
+                || !RESOLVE(clientWaitSync, "glClientWaitSync")
+                || !RESOLVE(deleteSync, "glDeleteSync"))
+            d->fenceSync = nullptr;
+    }
+    // persistent mapping relies on fences to avoid overwriting
+    if (d->fenceSync && d->mapBufferRange && OGL::hasExtension(OGL::BufferStorage))
+        RESOLVE(bufferStorage, "glBufferStorage");
+#undef RESOLVE
+    d->buffers.resize(d->count);
+    for (auto &buffer : d->buffers)
+        d->func->glGenBuffers(1, &buffer.id);
+    d->index = 0;
+    _Debug("Create %% pixel buffers. Persistent mapping: %%",
+           d->count, isPersistent());
+    return true;
+}
+
+auto OpenGLPixelBufferRing::destroy() -> void
+{
+    if (d->buffers.empty())
+        return;
+    if (d->bound) {
+        unmap();
+        release();
+    }
+    for (auto &buffer : d->buffers) {
+        if (buffer.fence)
+            d->deleteSync(buffer.fence);
+        if (buffer.persistent) {
+            d->func->glBindBuffer(d->target, buffer.id);
+            d->unmapBuffer(d->target);
+        }
+        d->func->glDeleteBuffers(1, &buffer.id);
+    }
+    d->func->glBindBuffer(d->target, 0);
+    d->buffers.clear();
+}
+
+auto OpenGLPixelBufferRing::isValid() const -> bool
+{
+    return !d->buffers.empty();
+}
+
+auto OpenGLPixelBufferRing::isPersistent() const -> bool
+{
+    return d->bufferStorage;
+}
+
+auto OpenGLPixelBufferRing::map(int size) -> bool
+{
+    Q_ASSERT(!d->bound);
+    if (d->buffers.empty() || size <= 0)
+        return false;
+    auto &buffer = d->current();
+    d->wait(buffer);
+    d->offset = 0;
+    if (d->bufferStorage) {
+        if (buffer.capacity < size && !d->allocatePersistent(buffer, size * 1.5))
+            return false;
+        d->func->glBindBuffer(d->target, buffer.id);
+        d->ptr = buffer.persistent;
+    } else {
+        d->func->glBindBuffer(d->target, buffer.id);
+        // orphan old storage so that driver never stalls on it
+        if (buffer.capacity < size)
+            buffer.capacity = size * 1.5;
+        d->func->glBufferData(d->target, buffer.capacity,
+                              nullptr, GL_STREAM_DRAW);
+        void *ptr = nullptr;
+        if (d->mapBufferRange)
+            ptr = d->mapBufferRange(d->target, 0, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        else
+            ptr = d->mapBuffer(d->target, GL_WRITE_ONLY);
+        d->ptr = static_cast<uchar*>(ptr);
+    }
+    if (!d->ptr) {
+        d->func->glBindBuffer(d->target, 0);
+        return false;
+    }
+    d->bound = true;
+    return true;
+}
+
+auto OpenGLPixelBufferRing::write(const void *data, int bytes) -> const void*
+{
+    if (!d->bound)
+        return data;
+    Q_ASSERT(d->ptr && d->offset + bytes <= d->current().capacity);
+    memcpy(d->ptr + d->offset, data, bytes);
+    const auto offset = d->offset;
+    d->offset += bytes;
+    return reinterpret_cast<const void*>(static_cast<quintptr>(offset));
+}
+
+auto OpenGLPixelBufferRing::unmap() -> void
+{
+    if (!d->bound || !d->ptr)
+        return;
+    if (!d->bufferStorage)
+        d->unmapBuffer(d->target);
+    d->ptr = nullptr;
+}
+
+auto OpenGLPixelBufferRing::release() -> void
+{
+    if (!d->bound)
+        return;
+    Q_ASSERT(!d->ptr);
+    auto &buffer = d->current();
+    if (d->fenceSync)
+        buffer.fence = d->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    d->func->glBindBuffer(d->target, 0);
+    d->bound = false;
+    d->index = (d->index + 1) % d->buffers.size();
+}
@@ -0,0 +1,35 @@
+#ifndef OPENGLPIXELBUFFERRING_HPP
+#define OPENGLPIXELBUFFERRING_HPP
+
+#include "openglmisc.hpp"
+
+// ring of pixel unpack buffers for asynchronous texture uploads
+// usage: map(), write() every source, unmap(), upload with write() results
+// as data pointers, then release()
+// without pbo support, write() returns its source and uploads stay synchronous
+// other targets like GL_ARRAY_BUFFER work in the same way as vertex streams
+class OpenGLPixelBufferRing {
+public:
+    OpenGLPixelBufferRing(int count = 3, GLenum target = GL_PIXEL_UNPACK_BUFFER);
+    OpenGLPixelBufferRing(const OpenGLPixelBufferRing &) = delete;
+    OpenGLPixelBufferRing &operator = (const OpenGLPixelBufferRing &) = delete;
+    ~OpenGLPixelBufferRing();
+    // current context is required for all functions below
+    auto create() -> bool;
+    auto destroy() -> void;
+    auto isValid() const -> bool;
+    auto isPersistent() const -> bool;
+    // take next buffer which is not read by gpu and make room for size bytes
+    auto map(int size) -> bool;
+    // copy bytes and return the pointer which should be passed to upload
+    auto write(const void *data, int bytes) -> const void*;
+    // finish writing, the buffer stays bound for uploads
+    auto unmap() -> void;
+    // fence the uploads from current buffer and unbind it
+    auto release() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // OPENGLPIXELBUFFERRING_HPP
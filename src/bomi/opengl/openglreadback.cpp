@@ -0,0 +1,185 @@
+#include "openglreadback.hpp"
+#include "openglframebufferobject.hpp"
+#include "misc/log.hpp"
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+static constexpr GLuint64 FenceTimeout = 1000000000; // 1s in ns
+
+struct PackBuffer {
+    GLuint id = GL_NONE;
+    GLsync fence = nullptr;
+    int capacity = 0;
+    QSize size;
+    QImage::Format format = QImage::Format_Invalid;
+    QImage image; // for synchronous reads
+};
+
+struct OpenGLReadback::Data {
+    QOpenGLFunctions *func = nullptr;
+    // entry points not in QOpenGLFunctions
+    auto (QOPENGLF_APIENTRYP mapBuffer)(GLenum, GLenum) -> void* = nullptr;
+    auto (QOPENGLF_APIENTRYP unmapBuffer)(GLenum) -> GLboolean = nullptr;
+    auto (QOPENGLF_APIENTRYP mapBufferRange)(GLenum, GLintptr, GLsizeiptr,
+                                             GLbitfield) -> void* = nullptr;
+    auto (QOPENGLF_APIENTRYP fenceSync)(GLenum, GLbitfield) -> GLsync = nullptr;
+    auto (QOPENGLF_APIENTRYP clientWaitSync)(GLsync, GLbitfield,
+                                             GLuint64) -> GLenum = nullptr;
+    auto (QOPENGLF_APIENTRYP deleteSync)(GLsync) -> void = nullptr;
+
+    int count = 4, head = 0, queued = 0;
+    std::vector<PackBuffer> buffers;
+
+    auto at(int i) -> PackBuffer& { return buffers[(head + i) % buffers.size()]; }
+    auto download(PackBuffer &buffer) -> QImage
+    {
+        QImage image(buffer.size, buffer.format);
+        const int bytes = image.byteCount();
+        func->glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+        void *ptr = nullptr;
+        if (mapBufferRange)
+            ptr = mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        else
+            ptr = mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (ptr) {
+            memcpy(image.bits(), ptr, bytes);
+            unmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            _Error("Cannot map pixel pack buffer %%.", buffer.id);
+            image = QImage();
+        }
+        func->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return image;
+    }
+};
+
+OpenGLReadback::OpenGLReadback(int count)
+    : d(new Data)
+{
+    d->count = qMax(1, count);
+}
+
+OpenGLReadback::~OpenGLReadback()
+{
+    Q_ASSERT(d->buffers.empty());
+    delete d;
+}
+
+auto OpenGLReadback::create() -> bool
+{
+    Q_ASSERT(d->buffers.empty());
+    auto ctx = QOpenGLContext::currentContext();
+    if (!ctx)
+        return false;
+    d->func = ctx->functions();
+#define RESOLVE(var, name) \
+    (d->var = reinterpret_cast<decltype(d->var)>(ctx->getProcAddress(name)))
+    if (RESOLVE(mapBuffer, "glMapBuffer") && RESOLVE(unmapBuffer, "glUnmapBuffer")
+            && OGL::hasExtension(OGL::Sync)) {
+        if (!RESOLVE(fenceSync, "glFenceSync")
+                || !RESOLVE(clientWaitSync, "glClientWaitSync")
+                || !RESOLVE(deleteSync, "glDeleteSync"))
+            d->fenceSync = nullptr;
+        if (OGL::hasExtension(OGL::MapBufferRange))
+            RESOLVE(mapBufferRange, "glMapBufferRange");
+    }
+#undef RESOLVE
+    d->buffers.resize(d->count);
+    if (d->fenceSync) {
+        for (auto &buffer : d->buffers)
+            d->func->glGenBuffers(1, &buffer.id);
+    }
+    d->head = d->queued = 0;
+    _Debug("Create %% readback buffers. Asynchronous: %%", d->count, isAsync());
+    return true;
+}
+
+auto OpenGLReadback::destroy() -> void
+{
+    if (d->buffers.empty())
+        return;
+    for (auto &buffer : d->buffers) {
+        if (buffer.fence)
+            d->deleteSync(buffer.fence);
+        if (buffer.id != GL_NONE)
+            d->func->glDeleteBuffers(1, &buffer.id);
+    }
+    d->buffers.clear();
+    d->head = d->queued = 0;
+}
+
+auto OpenGLReadback::isValid() const -> bool
+{
+    return !d->buffers.empty();
+}
+
+auto OpenGLReadback::isAsync() const -> bool
+{
+    return d->fenceSync;
+}
+
+auto OpenGLReadback::available() const -> int
+{
+    return d->buffers.size() - d->queued;
+}
+
+auto OpenGLReadback::pending() const -> int
+{
+    return d->queued;
+}
+
+auto OpenGLReadback::read(const OpenGLFramebufferObject *fbo,
+                          QImage::Format format) -> bool
+{
+    if (d->buffers.empty() || d->queued >= (int)d->buffers.size())
+        return false;
+    auto &buffer = d->at(d->queued++);
+    buffer.format = format;
+    buffer.size = fbo ? fbo->size() : QSize();
+    if (buffer.size.isEmpty())
+        return true;
+    fbo->bind(GL_READ_FRAMEBUFFER);
+    const int w = buffer.size.width(), h = buffer.size.height();
+    if (!d->fenceSync) {
+        buffer.image = QImage(buffer.size, format);
+        d->func->glReadPixels(0, 0, w, h, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+                              buffer.image.bits());
+    } else {
+        const int bytes = w * h * 4;
+        d->func->glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+        // orphan old storage so that previous map never blocks this one
+        buffer.capacity = qMax(buffer.capacity, bytes);
+        d->func->glBufferData(GL_PIXEL_PACK_BUFFER, buffer.capacity,
+                              nullptr, GL_STREAM_READ);
+        d->func->glReadPixels(0, 0, w, h, GL_BGRA,
+                              GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+        d->func->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        buffer.fence = d->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    fbo->release();
+    return true;
+}
+
+auto OpenGLReadback::take(QImage &image, bool wait) -> bool
+{
+    if (!d->queued)
+        return false;
+    auto &buffer = d->at(0);
+    if (buffer.fence) {
+        const auto res = d->clientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                           wait ? FenceTimeout : 0);
+        if (res == GL_TIMEOUT_EXPIRED && !wait)
+            return false;
+        if (res == GL_TIMEOUT_EXPIRED || res == GL_WAIT_FAILED)
+            _Warn("Pixel pack buffer %% is still in use after timeout.", buffer.id);
+        d->deleteSync(buffer.fence);
+        buffer.fence = nullptr;
+        image = d->download(buffer);
+    } else {
+        image = QImage();
+        image.swap(buffer.image);
+    }
+    d->head = (d->head + 1) % d->buffers.size();
+    --d->queued;
+    return true;
+}
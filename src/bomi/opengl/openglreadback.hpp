@@ -0,0 +1,35 @@
+#ifndef OPENGLREADBACK_HPP
+#define OPENGLREADBACK_HPP
+
+#include "openglmisc.hpp"
+
+class OpenGLFramebufferObject;
+
+// queue of framebuffer reads through pixel pack buffers
+// read() only issues transfers and take() returns images in issued order
+// once gpu has finished them
+// without sync support, read() downloads immediately and take() never waits
+class OpenGLReadback {
+public:
+    OpenGLReadback(int count = 4);
+    OpenGLReadback(const OpenGLReadback &) = delete;
+    OpenGLReadback &operator = (const OpenGLReadback &) = delete;
+    ~OpenGLReadback();
+    // current context is required for all functions below
+    auto create() -> bool;
+    auto destroy() -> void;
+    auto isValid() const -> bool;
+    auto isAsync() const -> bool;
+    // number of reads which can be issued now
+    auto available() const -> int;
+    auto pending() const -> int;
+    // null fbo queues null image to keep order of paired reads
+    auto read(const OpenGLFramebufferObject *fbo, QImage::Format format) -> bool;
+    // false if oldest read is not finished yet and wait is false
+    auto take(QImage &image, bool wait = false) -> bool;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // OPENGLREADBACK_HPP
@@ -0,0 +1,191 @@
+#include "openglshadercache.hpp"
+#include "openglworker.hpp"
+#include "misc/log.hpp"
+#include <QOpenGLShaderProgram>
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+
+static constexpr quint32 Magic = 0x62736863; // 'bshc'
+
+auto OpenGLShaderCache::Source::key() const -> QByteArray
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertex);
+    hash.addData("\n--\n", 4);
+    hash.addData(fragment);
+    for (auto &attr : attributes)
+        hash.addData(attr + '\n');
+    return hash.result().toHex();
+}
+
+struct OpenGLShaderCache::Data {
+    using GetBinary = void (QOPENGLF_APIENTRYP)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    using SetBinary = void (QOPENGLF_APIENTRYP)(GLuint, GLenum, const void*, GLsizei);
+    using SetParam = void (QOPENGLF_APIENTRYP)(GLuint, GLenum, GLint);
+    // per context, resolved on first use
+    struct Api {
+        GetBinary getBinary = nullptr;
+        SetBinary setBinary = nullptr;
+        SetParam setParam = nullptr;
+        QString folder; // empty if binaries are not supported
+    };
+
+    static auto root() -> QString { return _WritablePath(Location::Cache) % "/shader"_a; }
+    static auto mutex() -> QMutex& { static QMutex mutex; return mutex; }
+    static auto api(QOpenGLContext *ctx) -> Api
+    {
+        static QHash<QOpenGLContext*, Api> apis;
+        QMutexLocker locker(&mutex());
+        auto it = apis.find(ctx);
+        if (it != apis.end())
+            return *it;
+        Api api;
+        auto f = ctx->functions();
+        const auto version = ctx->format().version();
+        if (!ctx->isOpenGLES() && (version >= qMakePair(4, 1)
+                || ctx->hasExtension("GL_ARB_get_program_binary"))) {
+            api.getBinary = (GetBinary)ctx->getProcAddress("glGetProgramBinary");
+            api.setBinary = (SetBinary)ctx->getProcAddress("glProgramBinary");
+            api.setParam = (SetParam)ctx->getProcAddress("glProgramParameteri");
+            GLint formats = 0;
+            f->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            if (api.getBinary && api.setBinary && api.setParam && formats > 0) {
+                // binaries are valid only for same driver
+                QCryptographicHash hash(QCryptographicHash::Sha1);
+                for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                    if (auto str = f->glGetString(name))
+                        hash.addData(reinterpret_cast<const char*>(str));
+                }
+                api.folder = root() % '/'_q % _L(hash.result().toHex().left(16));
+                if (!QDir().mkpath(api.folder))
+                    api.folder.clear();
+            }
+        }
+        QObject::connect(ctx, &QOpenGLContext::aboutToBeDestroyed, [ctx] () {
+            QMutexLocker locker(&mutex());
+            apis.remove(ctx);
+        });
+        return *apis.insert(ctx, api);
+    }
+    static auto remember(const QByteArray &key, const Source &source) -> void
+    {
+        static QSet<QByteArray> known;
+        QMutexLocker locker(&mutex());
+        if (known.contains(key))
+            return;
+        known.insert(key);
+        QFile file(root() % '/'_q % _L(key) % ".src"_a);
+        if (file.exists() || !file.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+        QDataStream out(&file);
+        out << Magic << source.vertex << source.fragment << source.attributes;
+    }
+    static auto load(const QString &path, Source *source) -> bool
+    {
+        QFile file(path);
+        if (!file.open(QFile::ReadOnly))
+            return false;
+        QDataStream in(&file);
+        quint32 magic = 0;
+        in >> magic >> source->vertex >> source->fragment >> source->attributes;
+        return magic == Magic && in.status() == QDataStream::Ok;
+    }
+    static auto binaryPath(const Api &api, const QByteArray &key) -> QString
+        { return api.folder % '/'_q % _L(key) % ".bin"_a; }
+    static auto loadBinary(const Api &api, QOpenGLShaderProgram *prog,
+                           const QByteArray &key) -> bool
+    {
+        QFile file(binaryPath(api, key));
+        if (!file.open(QFile::ReadOnly))
+            return false;
+        QDataStream in(&file);
+        quint32 magic = 0, format = 0;
+        QByteArray binary;
+        in >> magic >> format >> binary;
+        if (magic != Magic || in.status() != QDataStream::Ok || binary.isEmpty())
+            return false;
+        api.setBinary(prog->programId(), format, binary.constData(), binary.size());
+        // link() only checks status when no shader has been added
+        if (prog->link())
+            return true;
+        _Warn("Discard stale program binary %%.", key);
+        file.remove();
+        return false;
+    }
+    static auto saveBinary(const Api &api, QOpenGLShaderProgram *prog,
+                           const QByteArray &key) -> void
+    {
+        auto f = QOpenGLContext::currentContext()->functions();
+        GLint length = 0;
+        f->glGetProgramiv(prog->programId(), GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        QByteArray binary(length, Qt::Uninitialized);
+        GLenum format = 0;
+        api.getBinary(prog->programId(), length, &length, &format, binary.data());
+        binary.resize(length);
+        QFile file(binaryPath(api, key));
+        if (!file.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+        QDataStream out(&file);
+        out << Magic << (quint32)format << binary;
+    }
+};
+
+auto OpenGLShaderCache::link(QOpenGLShaderProgram *prog, const Source &source) -> bool
+{
+    auto ctx = QOpenGLContext::currentContext();
+    Q_ASSERT(ctx);
+    const auto key = source.key();
+    const auto api = Data::api(ctx);
+    if (!api.folder.isEmpty()) {
+        Data::remember(key, source);
+        if (Data::loadBinary(api, prog, key))
+            return true;
+    }
+    prog->removeAllShaders();
+    prog->addShaderFromSourceCode(QOpenGLShader::Vertex, source.vertex);
+    prog->addShaderFromSourceCode(QOpenGLShader::Fragment, source.fragment);
+    for (int i = 0; i < source.attributes.size(); ++i)
+        prog->bindAttributeLocation(source.attributes[i], i);
+    if (!api.folder.isEmpty())
+        api.setParam(prog->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (!prog->link()) {
+        _Error("Cannot link program: %%", prog->log());
+        return false;
+    }
+    if (!api.folder.isEmpty())
+        Data::saveBinary(api, prog, key);
+    return true;
+}
+
+auto OpenGLShaderCache::warmUp(OpenGLWorker *worker) -> void
+{
+    worker->post([] (QOpenGLContext *gl) {
+        const auto api = Data::api(gl);
+        if (api.folder.isEmpty())
+            return;
+        const QDir dir(Data::root());
+        const auto files = dir.entryList({u"*.src"_q}, QDir::Files);
+        int linked = 0;
+        for (auto &file : files) {
+            const auto key = file.left(file.size() - 4).toLatin1();
+            if (QFile::exists(Data::binaryPath(api, key)))
+                continue;
+            Source source;
+            if (!Data::load(dir.filePath(file), &source))
+                continue;
+            QOpenGLShaderProgram prog;
+            if (link(&prog, source))
+                ++linked;
+        }
+        if (linked)
+            _Info("%% programs are cached in background.", linked);
+    });
+}
@@ -0,0 +1,25 @@
+#ifndef OPENGLSHADERCACHE_HPP
+#define OPENGLSHADERCACHE_HPP
+
+class QOpenGLShaderProgram;             class OpenGLWorker;
+
+// disk cache of linked programs through glGetProgramBinary
+// binaries are keyed by sources and driver, so driver update starts over
+// sources of every program are remembered so that warmUp() can relink them
+// for a new driver in background and following links can load them
+class OpenGLShaderCache {
+public:
+    struct Source {
+        QByteArray vertex, fragment;
+        QVector<QByteArray> attributes; // bound in order from 0
+        auto key() const -> QByteArray;
+    };
+    // current context is required
+    static auto link(QOpenGLShaderProgram *program, const Source &source) -> bool;
+    // links as a job of worker, which does not need to share objects
+    static auto warmUp(OpenGLWorker *worker) -> void;
+private:
+    struct Data;
+};
+
+#endif // OPENGLSHADERCACHE_HPP
@@ -0,0 +1,244 @@
+#include "openglworker.hpp"
+#include "opengloffscreencontext.hpp"
+#include "openglmisc.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+static constexpr GLuint64 FenceTimeout = 1000000000; // 1s in ns
+
+struct Ticket {
+    quint64 id = 0;
+    QObject *receiver = nullptr;
+    int event = 0;
+};
+
+struct Queued : Ticket { OpenGLWorker::Job job; };
+
+struct InFlight : Ticket { GLsync fence = nullptr; };
+
+class OpenGLWorkerThread : public QThread {
+public:
+    OpenGLWorkerThread(OpenGLWorker::Data *d): d(d) { }
+private:
+    auto run() -> void final;
+    OpenGLWorker::Data *d;
+};
+
+struct OpenGLWorker::Data {
+    OpenGLOffscreenContext gl;
+    OpenGLWorkerThread *thread = nullptr;
+    QThread *owner = nullptr;
+    mutable QMutex mutex;
+    QWaitCondition queued, finished;
+    std::deque<Queued> jobs;
+    std::deque<InFlight> flying;
+    quint64 posted = 0, done = 0;
+    int busy = 0;
+    bool quit = false, running = false;
+
+    auto (QOPENGLF_APIENTRYP fenceSync)(GLenum, GLbitfield) -> GLsync = nullptr;
+    auto (QOPENGLF_APIENTRYP clientWaitSync)(GLsync, GLbitfield,
+                                             GLuint64) -> GLenum = nullptr;
+    auto (QOPENGLF_APIENTRYP deleteSync)(GLsync) -> void = nullptr;
+
+    auto resolve() -> void
+    {
+        if (!OGL::hasExtension(OGL::Sync))
+            return;
+        auto ctx = gl.context();
+#define RESOLVE(var, name) \
+    (var = reinterpret_cast<decltype(var)>(ctx->getProcAddress(name)))
+        if (!RESOLVE(fenceSync, "glFenceSync")
+                || !RESOLVE(clientWaitSync, "glClientWaitSync")
+                || !RESOLVE(deleteSync, "glDeleteSync"))
+            fenceSync = nullptr;
+#undef RESOLVE
+    }
+    // call without lock
+    auto complete(const Ticket &ticket) -> void
+    {
+        mutex.lock();
+        done = ticket.id;
+        --busy;
+        mutex.unlock();
+        finished.wakeAll();
+        if (ticket.receiver)
+            _PostEvent(ticket.receiver, ticket.event, ticket.id);
+    }
+    // gpu runs commands in order, so only the oldest fence is checked
+    auto retire(GLuint64 timeout) -> void
+    {
+        while (!flying.empty()) {
+            auto &front = flying.front();
+            const auto res = clientWaitSync(front.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                            timeout);
+            if (res == GL_TIMEOUT_EXPIRED && timeout == 0)
+                return;
+            if (res == GL_TIMEOUT_EXPIRED || res == GL_WAIT_FAILED)
+                _Warn("Job %% is not finished after timeout.", front.id);
+            deleteSync(front.fence);
+            const Ticket ticket = front;
+            flying.pop_front();
+            complete(ticket);
+        }
+    }
+    auto drop() -> void
+    {
+        for (auto &f : flying)
+            deleteSync(f.fence);
+        flying.clear();
+    }
+};
+
+auto OpenGLWorkerThread::run() -> void
+{
+    if (!d->gl.makeCurrent()) {
+        _Error("Cannot make context of %% current.", d->gl.contextName());
+        d->gl.context()->moveToThread(d->owner);
+        return;
+    }
+    d->resolve();
+    auto ctx = d->gl.context();
+    auto func = ctx->functions();
+    forever {
+        d->mutex.lock();
+        while (!d->quit && d->jobs.empty()) {
+            if (!d->flying.empty()) {
+                d->mutex.unlock();
+                d->retire(FenceTimeout);
+                d->mutex.lock();
+            } else
+                d->queued.wait(&d->mutex);
+        }
+        if (d->quit) {
+            d->mutex.unlock();
+            break;
+        }
+        auto job = std::move(d->jobs.front());
+        d->jobs.pop_front();
+        ++d->busy;
+        d->mutex.unlock();
+
+        job.job(ctx);
+        if (d->fenceSync) {
+            InFlight f;
+            static_cast<Ticket&>(f) = job;
+            f.fence = d->fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            func->glFlush();
+            d->flying.push_back(f);
+            d->retire(0);
+        } else {
+            func->glFinish();
+            d->complete(job);
+        }
+    }
+    if (d->fenceSync)
+        d->drop();
+    d->gl.doneCurrent();
+    d->gl.context()->moveToThread(d->owner);
+}
+
+OpenGLWorker::OpenGLWorker(const QString &name)
+    : d(new Data)
+{
+    d->gl.setContextName(name);
+}
+
+OpenGLWorker::~OpenGLWorker()
+{
+    stop();
+    delete d;
+}
+
+auto OpenGLWorker::start(const QSurfaceFormat &format, QOpenGLContext *share) -> bool
+{
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    if (d->thread)
+        return false;
+    d->gl.setFormat(format);
+    d->gl.setShareContext(share);
+    d->gl.createSurface();
+    if (!d->gl.createContext()) {
+        _Error("Cannot create context for %%.", d->gl.contextName());
+        return false;
+    }
+    d->owner = QThread::currentThread();
+    d->quit = false;
+    d->thread = new OpenGLWorkerThread(d);
+    d->thread->setObjectName(d->gl.contextName());
+    d->gl.setThread(d->thread);
+    d->running = true;
+    d->thread->start(QThread::LowPriority);
+    _Debug("%% started.", d->gl.contextName());
+    return true;
+}
+
+auto OpenGLWorker::stop() -> void
+{
+    if (!d->thread)
+        return;
+    d->mutex.lock();
+    d->quit = true;
+    const auto dropped = d->jobs.size();
+    d->jobs.clear();
+    d->mutex.unlock();
+    d->queued.wakeAll();
+    d->thread->wait();
+    _Delete(d->thread);
+    d->mutex.lock();
+    d->running = false;
+    d->busy = 0;
+    d->mutex.unlock();
+    d->finished.wakeAll();
+    _Debug("%% stopped. %% jobs are dropped.", d->gl.contextName(), dropped);
+}
+
+auto OpenGLWorker::isRunning() const -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    return d->running;
+}
+
+auto OpenGLWorker::post(Job &&job, QObject *receiver, int event) -> quint64
+{
+    Queued q;
+    q.job = std::move(job);
+    q.receiver = receiver;
+    q.event = event;
+    d->mutex.lock();
+    q.id = ++d->posted;
+    d->jobs.push_back(std::move(q));
+    const auto id = d->posted;
+    d->mutex.unlock();
+    d->queued.wakeOne();
+    return id;
+}
+
+auto OpenGLWorker::isDone(quint64 ticket) const -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    return d->done >= ticket;
+}
+
+auto OpenGLWorker::wait(quint64 ticket) -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    while (d->done < ticket) {
+        if (!d->running)
+            return false;
+        d->finished.wait(&d->mutex);
+    }
+    return true;
+}
+
+auto OpenGLWorker::pending() const -> int
+{
+    QMutexLocker locker(&d->mutex);
+    return d->jobs.size() + d->busy;
+}
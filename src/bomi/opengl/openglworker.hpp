@@ -0,0 +1,37 @@
+#ifndef OPENGLWORKER_HPP
+#define OPENGLWORKER_HPP
+
+#include <functional>
+
+class QOpenGLContext;                   class QSurfaceFormat;
+
+// thread with own offscreen context which runs heavy gpu jobs in posted order
+// so that render thread keeps its frame budget
+// every job is fenced and its ticket is done only after gpu has finished it,
+// so objects written by a job are complete for contexts which share them
+class OpenGLWorker {
+public:
+    using Job = std::function<void(QOpenGLContext*)>;
+    OpenGLWorker(const QString &name = u"OpenGLWorker"_q);
+    OpenGLWorker(const OpenGLWorker &) = delete;
+    OpenGLWorker &operator = (const OpenGLWorker &) = delete;
+    ~OpenGLWorker();
+    // call in gui thread, share can be current in another thread
+    auto start(const QSurfaceFormat &format, QOpenGLContext *share = nullptr) -> bool;
+    // drop jobs not started yet and wait for the running one
+    auto stop() -> void;
+    auto isRunning() const -> bool;
+    // can be called in any thread, jobs posted before start() wait for it
+    // receiver gets DataEvent<quint64> of event type with ticket when done
+    auto post(Job &&job, QObject *receiver = nullptr, int event = 0) -> quint64;
+    auto isDone(quint64 ticket) const -> bool;
+    // false if worker is not running or stops before the job is done
+    auto wait(quint64 ticket) -> bool;
+    auto pending() const -> int;
+private:
+    struct Data;
+    Data *d;
+    friend class OpenGLWorkerThread;
+};
+
+#endif // OPENGLWORKER_HPP
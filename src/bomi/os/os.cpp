@@ -3,6 +3,24 @@
 #include "enum/deintmethod.hpp"
 #include <QFontDatabase>
 #include <QScreen>
+#include <atomic>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+#include <QStorageInfo>
+#endif
+#ifdef Q_OS_MAC
+#include <pthread.h>
+#include <pthread/qos.h>
+#endif
+
+extern "C" {
+#include <video/img_format.h>
+#include <video/mp_image.h>
+#include <video/mp_image_pool.h>
+}
+
+#ifdef bool
+#undef bool
+#endif
 
 namespace OS {
 
@@ -27,6 +45,77 @@ auto screensaverMethods() -> QStringList { return { u"auto"_q }; }
 auto setScreensaverMethod(const QString &) -> void { }
 #endif
 
+#if !defined(Q_OS_LINUX) && !defined(Q_OS_WIN)
+auto heapMemory() -> double { return -1.0; }
+auto threadTimes() -> QVector<ThreadTime> { return QVector<ThreadTime>(); }
+#endif
+
+static std::atomic<bool> s_realtime{false}, s_efficiency{false};
+static std::atomic<int> s_policySerial{0};
+
+auto setThreadPolicy(const ThreadPolicy &policy) -> void
+{
+    s_realtime = policy.realtime;
+    s_efficiency = policy.efficiency;
+    ++s_policySerial;
+}
+
+auto threadPolicy() -> ThreadPolicy
+{
+    ThreadPolicy policy;
+    policy.realtime = s_realtime;
+    policy.efficiency = s_efficiency;
+    return policy;
+}
+
+auto threadPolicySerial() -> int
+{
+    return s_policySerial;
+}
+
+#if defined(Q_OS_MAC)
+auto setThreadClass(ThreadClass tc) -> bool
+{
+    // background qos runs on efficiency cores of apple silicon
+    auto qos = QOS_CLASS_DEFAULT;
+    switch (tc) {
+    case ThreadClass::Playback:
+        qos = s_realtime ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED;
+        break;
+    case ThreadClass::Render:
+        qos = s_realtime ? QOS_CLASS_USER_INITIATED : QOS_CLASS_DEFAULT;
+        break;
+    case ThreadClass::Background:
+        qos = s_efficiency ? QOS_CLASS_BACKGROUND : QOS_CLASS_UTILITY;
+        break;
+    }
+    return !pthread_set_qos_class_self_np(qos, 0);
+}
+#elif !defined(Q_OS_LINUX) && !defined(Q_OS_WIN)
+auto setThreadClass(ThreadClass) -> bool { return false; }
+#endif
+
+auto networkHost(const QString &path) -> QString
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+    static const QList<QByteArray> types = {
+        "cifs"_b, "smbfs"_b, "smb2"_b, "nfs"_b, "nfs4"_b,
+        "afpfs"_b, "webdav"_b, "fuse.sshfs"_b
+    };
+    const QStorageInfo storage(path);
+    if (!storage.isValid() || !types.contains(storage.fileSystemType()))
+        return QString();
+    // //host/share, host:/export or user@host:/path
+    auto device = QString::fromLocal8Bit(storage.device());
+    if (device.startsWith("//"_a))
+        return device.mid(2).section('/'_q, 0, 0);
+    return device.section(':'_q, 0, 0).section('@'_q, -1);
+#else
+    Q_UNUSED(path);
+    return QString();
+#endif
+}
+
 auto getHwAcc() -> HwAcc*;
 
 auto hwAcc() -> HwAcc*
@@ -89,6 +178,11 @@ auto HwAcc::supports(CodecId codec) -> bool
     return d->codecs.contains(codec);
 }
 
+auto HwAcc::supportedCodecs() const -> QList<CodecId>
+{
+    return d->codecs;
+}
+
 auto HwAcc::supports(DeintMethod method) -> bool
 {
     return d->deints.contains(method);
@@ -142,11 +236,59 @@ auto HwAcc::setSupportedDeints(const QList<DeintMethod> &deints) -> void
     d->deints = deints;
 }
 
-auto HwAcc::download(mp_hwdec_ctx *, const mp_image *, mp_image_pool *) -> mp_image*
+auto HwAcc::download(mp_hwdec_ctx *, const mp_image *, mp_image_pool *,
+                     const Download &) -> mp_image*
 {
     return nullptr;
 }
 
+auto HwAcc::extract(const mp_image *src, mp_image_pool *pool,
+                    const Download &part, const QPoint &offset) -> mp_image*
+{
+    const auto &fmt = src->fmt;
+    const int ax = (1 << fmt.chroma_xs) - 1, ay = (1 << fmt.chroma_ys) - 1;
+    QRect rect = part.region.isNull() ? QRect(offset, QSize(src->w, src->h))
+                                      : part.region;
+    rect.translate(-offset);
+    rect &= QRect(0, 0, src->w, src->h);
+    rect.setLeft(rect.left() & ~ax);
+    rect.setTop(rect.top() & ~ay);
+    const int scale = qMax(1, part.scale);
+    const int w = rect.width() / scale, h = rect.height() / scale;
+    if (w <= 0 || h <= 0 || !(fmt.flags & MP_IMGFLAG_BYTE_ALIGNED))
+        return nullptr;
+    // packed pixels cannot be split into luma or decimated per pixel
+    if (fmt.num_planes == 1 && fmt.align_x > 1 && (part.lumaOnly || scale > 1))
+        return nullptr;
+    if (part.lumaOnly && fmt.bytes[0] != 1)
+        return nullptr;
+    auto img = mp_image_pool_get(pool, part.lumaOnly ? IMGFMT_Y8 : src->imgfmt, w, h);
+    if (!img)
+        return nullptr;
+    mp_image_copy_attributes(img, (mp_image*)src);
+    for (int p = 0; p < img->num_planes; ++p) {
+        const int bytes = fmt.bytes[p], xs = fmt.xs[p], ys = fmt.ys[p];
+        const int pw = mp_image_plane_w(img, p), ph = mp_image_plane_h(img, p);
+        const int x0 = (rect.left() >> xs) * bytes, y0 = rect.top() >> ys;
+        for (int y = 0; y < ph; ++y) {
+            auto from = src->planes[p] + (y0 + y * scale) * src->stride[p] + x0;
+            auto to = img->planes[p] + y * img->stride[p];
+            if (scale == 1) {
+                memcpy(to, from, pw * bytes);
+                continue;
+            }
+            for (int x = 0; x < pw; ++x, to += bytes, from += bytes * scale)
+                memcpy(to, from, bytes);
+        }
+    }
+    return img;
+}
+
+auto HwAcc::scanLuma(mp_hwdec_ctx *, const mp_image *) -> double
+{
+    return -1.0;
+}
+
 #ifndef Q_OS_WIN
 auto setImeEnabled(QWindow *w, bool enabled) -> void
 {
@@ -154,6 +296,15 @@ auto setImeEnabled(QWindow *w, bool enabled) -> void
 }
 #endif
 
+static qreal s_refreshRate = -1;
+
+auto refreshRate() -> qreal
+{
+    if (s_refreshRate > 0)
+        return s_refreshRate;
+    return qApp->primaryScreen() ? qApp->primaryScreen()->refreshRate() : -1;
+}
+
 WindowAdapter::WindowAdapter(QWindow *parent)
     : QObject(parent)
 {
@@ -161,6 +312,31 @@ WindowAdapter::WindowAdapter(QWindow *parent)
 #ifndef Q_OS_WIN
     connect(m_window, &QWindow::windowStateChanged, this, &WindowAdapter::setState);
 #endif
+    // moves come in bursts, so check once they settle
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(200);
+    connect(&m_refreshTimer, &QTimer::timeout, this, [=] () {
+        const auto hz = queryRefreshRate();
+        if (hz > 0)
+            s_refreshRate = hz;
+        if (_Change(m_refreshRate, hz))
+            emit refreshRateChanged(m_refreshRate);
+    });
+    auto update = [=] () { updateRefreshRate(); };
+    connect(m_window, &QWindow::screenChanged, this, update);
+    connect(m_window, &QWindow::xChanged, this, update);
+    connect(m_window, &QWindow::yChanged, this, update);
+    connect(m_window, &QWindow::visibleChanged, this, update);
+    connect(qApp, &QGuiApplication::screenAdded, this, update);
+    m_refreshRate = queryRefreshRate();
+    if (m_refreshRate > 0)
+        s_refreshRate = m_refreshRate;
+}
+
+auto WindowAdapter::queryRefreshRate() const -> qreal
+{
+    auto s = screen();
+    return s ? s->refreshRate() : -1;
 }
 
 auto WindowAdapter::screen() const -> QScreen*
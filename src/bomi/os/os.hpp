@@ -27,11 +27,60 @@ auto processTime() -> quint64; // us
 auto systemTime()  -> quint64; // us
 auto totalMemory() -> double;
 auto usingMemory() -> double;
+// MiB in use by heap allocator, negative if unknown
+auto heapMemory() -> double;
+
+// cpu time of each thread in process
+struct ThreadTime {
+    quint64 id = 0, time = 0; // us
+    QString name;
+    bool main = false;
+};
+auto threadTimes() -> QVector<ThreadTime>;
+
+// scheduling of calling thread by what it does
+enum class ThreadClass {
+    Playback,   // mpv playloop and audio filters, realtime if allowed
+    Render,     // subtitle rendering, above normal if allowed
+    Background  // previews, thumbnails and other helpers which can wait
+};
+struct ThreadPolicy {
+    bool realtime = false;
+    // keep background threads on efficiency cores of hybrid cpu
+    bool efficiency = false;
+};
+auto setThreadPolicy(const ThreadPolicy &policy) -> void;
+auto threadPolicy() -> ThreadPolicy;
+// changed by every setThreadPolicy() so that threads can apply it again
+auto threadPolicySerial() -> int;
+// false if system denied it, the thread keeps running as before then
+auto setThreadClass(ThreadClass tc) -> bool;
+
+// applies class again only when thread or policy changed since last call
+// cheap enough for every buffer in code which runs in threads of others
+class ThreadClassKeeper {
+public:
+    ThreadClassKeeper(ThreadClass tc): m_class(tc) { }
+    auto keep() -> void
+    {
+        const auto serial = threadPolicySerial();
+        const auto thread = QThread::currentThreadId();
+        if (_Change(m_serial, serial) | _Change(m_thread, thread))
+            setThreadClass(m_class);
+    }
+private:
+    ThreadClass m_class;
+    int m_serial = -1;
+    Qt::HANDLE m_thread = nullptr;
+};
 
 auto defaultFont() -> QFont;
 auto defaultFixedFont() -> QFont;
 
 auto opticalDrives() -> QStringList;
+// server of network file system where path lives, empty for local disk
+auto networkHost(const QString &path) -> QString;
+// refresh rate of monitor under main window as tracked by its adapter
 auto refreshRate() -> qreal;
 
 class WindowAdapter : public QObject {
@@ -74,10 +123,17 @@ public:
     auto mousePosForMovingByDrag() const -> QPoint { return m_mouseStartPos; }
     auto winId() const -> WId { return m_window->winId(); }
     auto window() const -> QWindow* { return m_window; }
+    // Hz of monitor which shows the window in its current mode
+    auto refreshRate() const -> qreal { return m_refreshRate; }
 signals:
     void stateChanged(Qt::WindowState state, Qt::WindowState old);
+    void refreshRateChanged(qreal hz);
 protected:
     WindowAdapter(QWindow *parent);
+    // negative if unknown
+    virtual auto queryRefreshRate() const -> qreal;
+    // recheck soon when monitor or its mode may have changed
+    auto updateRefreshRate() -> void { m_refreshTimer.start(); }
     auto setMovingByDrag(bool moving) { m_moving = moving; }
     auto setState(Qt::WindowState ws) -> void;
     auto setFramelessHint(bool frameless) -> void;
@@ -87,6 +143,8 @@ private:
     bool m_started = false, m_moving = false;
     QPoint m_winStartPos, m_mouseStartPos;
     Qt::WindowState m_state = Qt::WindowNoState, m_oldState = Qt::WindowNoState;
+    qreal m_refreshRate = -1;
+    QTimer m_refreshTimer;
 };
 
 auto adapter(QWindow *w) -> WindowAdapter*;
@@ -94,15 +152,27 @@ auto adapter(QWindow *w) -> WindowAdapter*;
 class HwAcc {
 public:
     enum Api { VaApiGLX, VdpauX11, Dxva2Copy, NoApi };
+    // part of surface which consumer needs, whole frame by default
+    struct Download {
+        QRect region; // null for whole frame, aligned to chroma
+        bool lumaOnly = false; // IMGFMT_Y8 image of luma plane
+        int scale = 1; // keep every scale-th pixel in both directions
+        auto isWhole() const -> bool
+            { return region.isNull() && !lumaOnly && scale <= 1; }
+    };
     virtual ~HwAcc();
     auto isAvailable() const -> bool;
     auto supports(CodecId codec) -> bool;
+    auto supportedCodecs() const -> QList<CodecId>;
     auto supports(DeintMethod method) -> bool;
     auto api() const -> Api;
     auto name() const -> QString;
     auto description() const -> QString;
-    virtual auto download(mp_hwdec_ctx *ctx, const mp_image *mpi,
-                          mp_image_pool *pool) -> mp_image*;
+    virtual auto download(mp_hwdec_ctx *ctx, const mp_image *mpi, mp_image_pool *pool,
+                          const Download &part = Download()) -> mp_image*;
+    // average luma like _LumaScan() read in place without download
+    // negative if surface cannot be accessed directly
+    virtual auto scanLuma(mp_hwdec_ctx *ctx, const mp_image *mpi) -> double;
     static auto fullCodecList() -> QList<CodecId>;
     static auto name(Api api) -> QString;
     static auto description(Api api) -> QString;
@@ -111,6 +181,10 @@ protected:
     HwAcc(Api api = NoApi);
     auto setSupportedCodecs(const QList<CodecId> &codecs) -> void;
     auto setSupportedDeints(const QList<DeintMethod> &deints) -> void;
+    // copy only requested part of src, which can wrap mapped surface memory
+    // offset is position of src in whole frame
+    static auto extract(const mp_image *src, mp_image_pool *pool,
+                        const Download &part, const QPoint &offset = QPoint()) -> mp_image*;
 private:
     struct Data;
     Data *d;
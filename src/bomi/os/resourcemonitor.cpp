@@ -0,0 +1,202 @@
+#include "resourcemonitor.hpp"
+#include "os.hpp"
+#include <QElapsedTimer>
+
+namespace OS {
+
+// KiB, negative if unknown
+static std::atomic<qint64> s_gpuFree{-1}, s_gpuTotal{-1};
+
+static auto savings() -> QMap<QByteArray, double>& { static QMap<QByteArray, double> map; return map; }
+static auto savingsMutex() -> QMutex& { static QMutex mutex; return mutex; }
+
+class MonitorThread : public QThread {
+public:
+    MonitorThread(ResourceMonitor *monitor)
+        : m_monitor(monitor) { setObjectName(u"ResourceMonitor"_q); }
+    auto stop() -> void
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_wait.wakeAll();
+        m_mutex.unlock();
+        wait();
+        m_quit = false;
+    }
+    auto usage() const -> ResourceUsage
+        { QMutexLocker locker(&m_mutex); return m_usage; }
+    auto setInterval(int ms) -> void { m_interval = ms; }
+private:
+    auto run() -> void final;
+    auto sample() -> void;
+    ResourceMonitor *m_monitor = nullptr;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wait;
+    bool m_quit = false;
+    std::atomic<int> m_interval{ResourceMonitor::Interval};
+    ResourceUsage m_usage;
+    // previous values
+    QElapsedTimer m_timer;
+    quint64 m_pt = 0, m_st = 0;
+    double m_heap = -1.0;
+    QHash<quint64, quint64> m_times;
+};
+
+auto MonitorThread::run() -> void
+{
+    m_timer.invalidate();
+    m_times.clear();
+    m_pt = m_st = 0;
+    m_heap = -1.0;
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        locker.unlock();
+        sample();
+        emit m_monitor->sampled();
+        locker.relock();
+        if (!m_quit)
+            m_wait.wait(&m_mutex, m_interval);
+    }
+}
+
+auto MonitorThread::sample() -> void
+{
+    const bool first = !m_timer.isValid();
+    const double elapsed = first ? 0.0 : m_timer.nsecsElapsed() * 1e-9;
+    m_timer.start();
+
+    ResourceUsage usage;
+    const auto pt = processTime(), st = systemTime();
+    if (!first && st > m_st)
+        usage.cpu = (pt - m_pt) / (double)(st - m_st) * 100.0;
+    m_pt = pt; m_st = st;
+    usage.memory = usingMemory();
+    usage.heap = heapMemory();
+    if (!first && elapsed > 0 && usage.heap >= 0 && m_heap >= 0)
+        usage.heapRate = (usage.heap - m_heap) / elapsed;
+    m_heap = usage.heap;
+    const auto free = s_gpuFree.load(), total = s_gpuTotal.load();
+    usage.gpuFree = free < 0 ? -1.0 : free / 1024.0;
+    usage.gpuTotal = total < 0 ? -1.0 : total / 1024.0;
+    savingsMutex().lock();
+    for (auto mib : savings())
+        usage.saved += mib;
+    savingsMutex().unlock();
+
+    QHash<QString, int> index;
+    QHash<quint64, quint64> times;
+    for (auto &t : threadTimes()) {
+        times[t.id] = t.time;
+        const auto name = ResourceMonitor::subsystem(t.name, t.main);
+        auto it = index.find(name);
+        if (it == index.end()) {
+            it = index.insert(name, usage.threads.size());
+            usage.threads.push_back(ThreadUsage());
+            usage.threads.back().name = name;
+        }
+        auto &thread = usage.threads[*it];
+        ++thread.count;
+        const auto prev = m_times.find(t.id);
+        if (elapsed > 0 && prev != m_times.end() && t.time > *prev)
+            thread.cpu += (t.time - *prev) * 1e-6 / elapsed * 100.0;
+    }
+    m_times.swap(times);
+    std::stable_sort(usage.threads.begin(), usage.threads.end(),
+                     [] (const ThreadUsage &lhs, const ThreadUsage &rhs)
+        { return lhs.cpu > rhs.cpu; });
+
+    QMutexLocker locker(&m_mutex);
+    m_usage = usage;
+}
+
+/******************************************************************************/
+
+struct ResourceMonitor::Data {
+    MonitorThread *thread = nullptr;
+    int refs = 0;
+};
+
+static ResourceMonitor *s_monitor = nullptr;
+
+ResourceMonitor::ResourceMonitor()
+    : d(new Data)
+{
+    d->thread = new MonitorThread(this);
+}
+
+ResourceMonitor::~ResourceMonitor()
+{
+    d->thread->stop();
+    delete d->thread;
+    delete d;
+}
+
+auto ResourceMonitor::get() -> ResourceMonitor*
+{
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    if (!s_monitor)
+        s_monitor = new ResourceMonitor;
+    return s_monitor;
+}
+
+auto ResourceMonitor::finalize() -> void
+{
+    _Delete(s_monitor);
+}
+
+auto ResourceMonitor::acquire() -> void
+{
+    if (!d->refs++)
+        d->thread->start(QThread::LowPriority);
+}
+
+auto ResourceMonitor::release() -> void
+{
+    Q_ASSERT(d->refs > 0);
+    if (!--d->refs)
+        d->thread->stop();
+}
+
+auto ResourceMonitor::setInterval(int ms) -> void
+{
+    d->thread->setInterval(ms);
+}
+
+auto ResourceMonitor::usage() const -> ResourceUsage
+{
+    return d->thread->usage();
+}
+
+auto ResourceMonitor::setGpuMemory(double free, double total) -> void
+{
+    s_gpuFree = free < 0 ? -1 : free * 1024;
+    s_gpuTotal = total < 0 ? -1 : total * 1024;
+}
+
+auto ResourceMonitor::setSaving(const char *key, double mib) -> void
+{
+    QMutexLocker locker(&savingsMutex());
+    if (mib > 0)
+        savings()[key] = mib;
+    else
+        savings().remove(key);
+}
+
+auto ResourceMonitor::subsystem(const QString &thread, bool main) -> QString
+{
+    if (main)
+        return u"GUI"_q;
+    if (thread == "playback core"_a)
+        return u"Playloop"_q;
+    if (thread == "ao"_a)
+        return u"Audio"_q;
+    if (thread == "vo"_a || thread.startsWith("QSGRenderThread"_a))
+        return u"Render"_q;
+    if (thread == "demux"_a || thread == "cache"_a || thread == "opener"_a)
+        return u"Demuxer"_q;
+    if (thread.startsWith("mpv"_a))
+        return u"Events"_q;
+    return thread;
+}
+
+}
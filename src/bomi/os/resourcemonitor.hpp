@@ -0,0 +1,54 @@
+#ifndef RESOURCEMONITOR_HPP
+#define RESOURCEMONITOR_HPP
+
+namespace OS {
+
+struct ThreadUsage {
+    QString name;
+    double cpu = 0.0; // % of one core, summed for threads of same name
+    int count = 0;
+};
+
+struct ResourceUsage {
+    double cpu = 0.0;       // % like processTime() over systemTime()
+    double memory = 0.0;    // MiB resident
+    double heap = -1.0;     // MiB in use by allocator, negative if unknown
+    double heapRate = 0.0;  // MiB/s of heap growth
+    double gpuFree = -1.0, gpuTotal = -1.0; // MiB, negative if unknown
+    double saved = 0.0;     // MiB released or capped by low memory mode
+    QVector<ThreadUsage> threads; // busiest first
+};
+
+// samples usage of process and its threads in own thread
+// sampling runs only while it is acquired by someone
+class ResourceMonitor : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int Interval = 500;
+    // should be called in main thread
+    static auto get() -> ResourceMonitor*;
+    static auto finalize() -> void;
+    auto acquire() -> void;
+    auto release() -> void;
+    // ms between samples, Interval by default
+    auto setInterval(int ms) -> void;
+    // latest sample, thread-safe
+    auto usage() const -> ResourceUsage;
+    // video memory can be read only where gl context is current, thread-safe
+    static auto setGpuMemory(double free, double total) -> void;
+    // MiB which subsystem of key saves in low memory mode, thread-safe
+    static auto setSaving(const char *key, double mib) -> void;
+    // readable name of subsystem which runs thread
+    static auto subsystem(const QString &thread, bool main) -> QString;
+signals:
+    void sampled();
+private:
+    ResourceMonitor();
+    ~ResourceMonitor();
+    struct Data;
+    Data *d;
+};
+
+}
+
+#endif // RESOURCEMONITOR_HPP
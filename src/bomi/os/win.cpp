@@ -11,6 +11,7 @@
 #include <QQuickItem>
 #include <QDesktopWidget>
 #include <psapi.h>
+#include <tlhelp32.h>
 #include <QWindow>
 #include <QSettings>
 #include <QFontDatabase>
@@ -174,12 +175,13 @@ auto defaultFixedFont() -> QFont
 }
 
 struct Win : public QObject {
-    Win() { proc = GetCurrentProcess(); }
+    Win() { proc = GetCurrentProcess(); mainThread = GetCurrentThreadId(); }
     EXECUTION_STATE executionState = 0;
     bool originalScreensaver = false;
     QHash<QWindow*, HIMC> imes;
     HANDLE shutdownToken = nullptr;
     HANDLE proc = nullptr;
+    DWORD mainThread = 0;
     Dxva2Info dxva2;
 };
 
@@ -347,6 +349,23 @@ auto WinWindowAdapter::eventFilter(QObject *obj, QEvent *ev) -> bool
 SIA toPoint(LPARAM lParam) -> QPoint
 { return { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) }; }
 
+auto WinWindowAdapter::queryRefreshRate() const -> qreal
+{
+    if (!m_hwnd)
+        return WindowAdapter::queryRefreshRate();
+    MONITORINFOEXW info;
+    info.cbSize = sizeof(info);
+    DEVMODEW mode;
+    mode.dmSize = sizeof(mode);
+    mode.dmDriverExtra = 0;
+    auto monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTONEAREST);
+    if (!GetMonitorInfoW(monitor, reinterpret_cast<MONITORINFO*>(&info))
+            || !EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode)
+            || mode.dmDisplayFrequency <= 1) // 0 and 1 are hardware default
+        return WindowAdapter::queryRefreshRate();
+    return mode.dmDisplayFrequency;
+}
+
 auto WinWindowAdapter::nativeEventFilter(const QByteArray &, void *message, long *res) -> bool
 {
     auto msg = static_cast<MSG*>(message);
@@ -354,6 +373,9 @@ auto WinWindowAdapter::nativeEventFilter(const QByteArray &, void *message, long
         return false;
     auto w = window();
     switch (msg->message) {
+    case WM_DISPLAYCHANGE:
+        updateRefreshRate();
+        return false;
     case WM_ENTERSIZEMOVE:
         m_startMousePos = QPoint(-1, -1);
         m_moving = false;
@@ -522,6 +544,101 @@ auto usingMemory() -> double
     return counters.WorkingSetSize/double(1024*1024);
 }
 
+auto heapMemory() -> double
+{
+    return -1.0;
+}
+
+auto threadTimes() -> QVector<ThreadTime>
+{
+    QVector<ThreadTime> times;
+    const auto pid = GetCurrentProcessId();
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE)
+        return times;
+    // available since windows 10 1607
+    using GetDescription = HRESULT (WINAPI *)(HANDLE, PWSTR*);
+    static const auto getDescription = (GetDescription)GetProcAddress(
+        GetModuleHandleW(L"kernel32.dll"), "GetThreadDescription");
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    for (bool ok = Thread32First(snapshot, &entry); ok; ok = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID != pid)
+            continue;
+        auto thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+        if (!thread)
+            continue;
+        ULARGE_INTEGER creation, exit, kernel, user;
+        if (GetThreadTimes(thread, (LPFILETIME)&creation.u, (LPFILETIME)&exit.u,
+                           (LPFILETIME)&kernel.u, (LPFILETIME)&user.u)) {
+            ThreadTime t;
+            t.id = entry.th32ThreadID;
+            t.time = (kernel.QuadPart + user.QuadPart)/10;
+            t.main = entry.th32ThreadID == d->mainThread;
+            PWSTR desc = nullptr;
+            if (getDescription && SUCCEEDED(getDescription(thread, &desc)) && desc) {
+                t.name = QString::fromWCharArray(desc);
+                LocalFree(desc);
+            }
+            if (t.name.isEmpty())
+                t.name = "Thread "_a % _N((quint64)t.id);
+            times.push_back(t);
+        }
+        CloseHandle(thread);
+    }
+    CloseHandle(snapshot);
+    return times;
+}
+
+auto setThreadClass(ThreadClass tc) -> bool
+{
+    // both are looked up, older sdk and windows lack them
+    using AvSet = HANDLE (WINAPI *)(LPCWSTR, LPDWORD);
+    using AvRevert = BOOL (WINAPI *)(HANDLE);
+    static const auto avrt = LoadLibraryW(L"avrt.dll");
+    static const auto avSet = avrt ? (AvSet)GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW") : nullptr;
+    static const auto avRevert = avrt ? (AvRevert)GetProcAddress(avrt, "AvRevertMmThreadCharacteristics") : nullptr;
+    // available since windows 10 1709, execution speed throttling means ecoqos
+    struct PowerThrottling { ULONG version, control, state; };
+    using SetInformation = BOOL (WINAPI *)(HANDLE, int, LPVOID, DWORD);
+    static const auto setInformation = (SetInformation)GetProcAddress(
+        GetModuleHandleW(L"kernel32.dll"), "SetThreadInformation");
+    static thread_local HANDLE mmcss = nullptr;
+
+    const auto policy = threadPolicy();
+    const auto thread = GetCurrentThread();
+    if (setInformation) {
+        const bool eco = tc == ThreadClass::Background && policy.efficiency;
+        PowerThrottling throttling = { 1, 1, eco ? 1ul : 0ul };
+        setInformation(thread, 3 /* ThreadPowerThrottling */, &throttling, sizeof(throttling));
+    }
+    if (tc == ThreadClass::Playback && policy.realtime) {
+        if (!mmcss && avSet) {
+            DWORD index = 0;
+            mmcss = avSet(L"Playback", &index);
+        }
+        if (mmcss)
+            return true;
+    } else if (mmcss) {
+        if (avRevert)
+            avRevert(mmcss);
+        mmcss = nullptr;
+    }
+    int priority = THREAD_PRIORITY_NORMAL;
+    switch (tc) {
+    case ThreadClass::Playback:
+        priority = policy.realtime ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_NORMAL;
+        break;
+    case ThreadClass::Render:
+        priority = policy.realtime ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_NORMAL;
+        break;
+    case ThreadClass::Background:
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+        break;
+    }
+    return SetThreadPriority(thread, priority);
+}
+
 auto canShutdown() -> bool
 {
     if (d->shutdownToken)
@@ -560,11 +677,6 @@ auto opticalDrives() -> QStringList
     return QStringList();
 }
 
-auto refreshRate() -> qreal
-{
-    return qApp->primaryScreen()->refreshRate();
-}
-
 Dxva2Info::Dxva2Info()
     : HwAcc(Dxva2Copy)
 {
@@ -31,6 +31,7 @@ public:
     auto showNormal() -> void final;
     auto screen() const -> QScreen* final;
 private:
+    auto queryRefreshRate() const -> qreal final;
     auto nativeEventFilter(const QByteArray &, void *message, long *result) -> bool final;
     auto eventFilter(QObject *obj, QEvent *ev) -> bool final;
     auto layer() const -> HWND
@@ -4,12 +4,18 @@
 
 #include "tmp/algorithm.hpp"
 #include "enum/codecid.hpp"
+#include "video/lumascan.hpp"
+#include "misc/json.hpp"
+#include "misc/jsonstorage.hpp"
+#include "misc/dataevent.hpp"
 #include <QDesktopWidget>
 #include <QMouseEvent>
+#include <QCryptographicHash>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusMessage>
 #include <QtDBus/QDBusInterface>
 #include <QtDBus/QDBusReply>
+#include <QtDBus/QDBusUnixFileDescriptor>
 #include <QtX11Extras/QX11Info>
 #include <unistd.h>
 #include <fcntl.h>
@@ -17,6 +23,12 @@
 #include <sys/time.h>
 #include <sys/sysctl.h>
 #include <sys/types.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <xcb/xcb.h>
 #include <xcb/randr.h>
 #include <xcb/xproto.h>
@@ -59,33 +71,79 @@ enum XcbAtom {
     _NET_WM_STATE_DEMANDS_ATTENTION,
     _NET_WM_STATE_STAYS_ON_TOP,
     _NET_WM_MOVERESIZE,
+    _NET_SUPPORTED,
     XcbAtomEnd,
     XcbAtomBegin = _NET_WM_STATE
 };
 
-static auto getAtom(xcb_connection_t *conn, const char *name) -> xcb_atom_t
-{
-    auto cookie = xcb_intern_atom(conn, 0, strlen(name), name);
-    auto reply = xcb_intern_atom_reply(conn, cookie, nullptr);
-    if (!reply)
-        return 0;
-    auto ret = reply->atom;
-    free(reply);
-    return ret;
-}
+static const char *atomNames[] = {
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_MODAL",
+    "_NET_WM_STATE_STICKY",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_SHADED",
+    "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_STATE_SKIP_PAGER",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_WM_STATE_BELOW",
+    "_NET_WM_STATE_DEMANDS_ATTENTION",
+    "_NET_WM_STATE_STAYS_ON_TOP",
+    "_NET_WM_MOVERESIZE",
+    "_NET_SUPPORTED"
+};
+
+static_assert(sizeof(atomNames)/sizeof(atomNames[0]) == XcbAtomEnd,
+              "wrong number of atom names");
 
 enum class ScreensaverMethod {
-    Auto, Gnome, Freedesktop, Xss
+    Auto, Gnome, Freedesktop, Logind, Xss
+};
+
+// result of probing drivers, which takes long on some of them
+struct HwAccProbe {
+    HwAcc::Api api = HwAcc::NoApi;
+    QList<CodecId> codecs;
+    auto operator == (const HwAccProbe &rhs) const -> bool
+        { return api == rhs.api && codecs == rhs.codecs; }
+    auto operator != (const HwAccProbe &rhs) const -> bool
+        { return !operator == (rhs); }
+};
+
+// thread-safe, opens own connection to display
+static auto probeHwAcc(const QByteArray &display) -> HwAccProbe;
+static auto createHwAcc(const HwAccProbe &probe) -> HwAccX11*;
+// identity of gpus and their drivers
+static auto hwAccKey() -> QString;
+static auto readHwAccCache(const QString &key, HwAccProbe &probe) -> bool;
+static auto writeHwAccCache(const QString &key, const HwAccProbe &probe) -> void;
+
+class HwAccProber : public QThread {
+public:
+    enum EventType { Probed = QEvent::User + 1 };
+    HwAccProber(const QByteArray &display, QObject *receiver)
+        : m_display(display), m_receiver(receiver)
+        { setObjectName(u"HwAccProber"_q); }
+private:
+    auto run() -> void final
+        { _PostEvent(m_receiver, Probed, probeHwAcc(m_display)); }
+    QByteArray m_display;
+    QObject *m_receiver = nullptr;
 };
 
 struct X11 : public QObject {
     X11();
     ~X11();
+    auto customEvent(QEvent *event) -> void final;
 
+    // inhibited by one call and released by one call, nothing runs between
     struct {
-        QTimer reset;
         QDBusInterface *iface = nullptr;
         QDBusReply<uint> reply;
+        // logind releases idle lock when this is closed
+        QDBusUnixFileDescriptor lock;
         bool inhibit = false;
         ScreensaverMethod method = ScreensaverMethod::Auto;
     } ss;
@@ -94,7 +152,14 @@ struct X11 : public QObject {
     xcb_window_t root = 0;
     Display *display = nullptr;
     xcb_atom_t atoms[XcbAtomEnd];
+    uint8_t randr = 0; // first event of extension, 0 if unavailable
+    bool moveResize = false; // wm moves window by _NET_WM_MOVERESIZE
     HwAccX11 *api = nullptr;
+    struct {
+        QString key;
+        HwAccProbe cached;
+        HwAccProber *prober = nullptr;
+    } hw;
 
     int statm = 0;
 
@@ -147,84 +212,126 @@ X11::X11()
 
     Q_ASSERT(connection);
 
-#define GET_ATOM(id) {atoms[id] = getAtom(connection, #id);}
-    GET_ATOM(_NET_WM_STATE);
-    GET_ATOM(_NET_WM_STATE_MODAL);
-    GET_ATOM(_NET_WM_STATE_STICKY);
-    GET_ATOM(_NET_WM_STATE_MAXIMIZED_VERT);
-    GET_ATOM(_NET_WM_STATE_MAXIMIZED_HORZ);
-    GET_ATOM(_NET_WM_STATE_SHADED);
-    GET_ATOM(_NET_WM_STATE_SKIP_TASKBAR);
-    GET_ATOM(_NET_WM_STATE_SKIP_PAGER);
-    GET_ATOM(_NET_WM_STATE_HIDDEN);
-    GET_ATOM(_NET_WM_STATE_FULLSCREEN);
-    GET_ATOM(_NET_WM_STATE_ABOVE);
-    GET_ATOM(_NET_WM_STATE_BELOW);
-    GET_ATOM(_NET_WM_STATE_DEMANDS_ATTENTION);
-    GET_ATOM(_NET_WM_STATE_STAYS_ON_TOP);
-    GET_ATOM(_NET_WM_MOVERESIZE);
-#undef GET_ATOM
-
-    ss.reset.setInterval(20000);
-    connect(&ss.reset, &QTimer::timeout, this, [=] () {
-        Q_ASSERT(ss.method == ScreensaverMethod::Xss);
-        _Debug("Force XCB_SCREEN_SAVER_RESET.");
-        xcb_force_screen_saver(connection, XCB_SCREEN_SAVER_RESET);
+    auto ext = xcb_get_extension_data(connection, &xcb_randr_id);
+    if (ext && ext->present) {
+        randr = ext->first_event;
+        // same mask as qt selects, since selection replaces the old one
+        xcb_randr_select_input(connection, root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE
+                               | XCB_RANDR_NOTIFY_MASK_OUTPUT_CHANGE
+                               | XCB_RANDR_NOTIFY_MASK_CRTC_CHANGE
+                               | XCB_RANDR_NOTIFY_MASK_OUTPUT_PROPERTY);
         xcb_flush(connection);
-    });
+    }
 
-#if HAVE_VAAPI && HAVE_VDPAU
-    api = new VaApiInfo;
-    if (!api->isNative()) {
-        delete api;
-        api = new VdpauInfo;
-        if (!api->isNative())
-            _Delete(api);
+    // all requests first, then replies, for one round trip
+    xcb_intern_atom_cookie_t cookies[XcbAtomEnd];
+    for (int i = XcbAtomBegin; i < XcbAtomEnd; ++i)
+        cookies[i] = xcb_intern_atom(connection, 0, strlen(atomNames[i]), atomNames[i]);
+    for (int i = XcbAtomBegin; i < XcbAtomEnd; ++i) {
+        auto reply = xcb_intern_atom_reply(connection, cookies[i], nullptr);
+        atoms[i] = reply ? reply->atom : 0;
+        free(reply);
     }
-#elif HAVE_VAAPI
-    api = new VaApiInfo;
-#elif HAVE_VDPAU
-    api = new VdpauInfo;
-#endif
-    if (api && !api->isOk()) {
-        _Info("Failed to initialize hardware acceration API.");
-        _Delete(api);
+
+    const auto cookie = xcb_get_property_unchecked(connection, 0, root,
+        atoms[_NET_SUPPORTED], XCB_ATOM_ATOM, 0, 4096);
+    if (auto reply = xcb_get_property_reply(connection, cookie, nullptr)) {
+        if (reply->format == 32 && reply->type == XCB_ATOM_ATOM) {
+            auto begin = static_cast<const xcb_atom_t*>(xcb_get_property_value(reply));
+            auto end = begin + xcb_get_property_value_length(reply) / 4;
+            moveResize = std::find(begin, end, atoms[_NET_WM_MOVERESIZE]) != end;
+        }
+        free(reply);
     }
+    if (!moveResize)
+        _Info("Window manager does not support _NET_WM_MOVERESIZE.");
+
+    // probe results are cached since enumerating devices is slow on some
+    // drivers, and probed again in background to catch what key misses
+    hw.key = hwAccKey();
+    const QByteArray name = DisplayString(display);
+    const bool cached = readHwAccCache(hw.key, hw.cached);
+    if (!cached) {
+        hw.cached = probeHwAcc(name);
+        writeHwAccCache(hw.key, hw.cached);
+    }
+    api = createHwAcc(hw.cached);
     if (api)
         _Info("Initialized hardware acceleration API: %%.", api->name());
     else
         _Info("No available hardware acceleration API.");
+    if (cached) {
+        hw.prober = new HwAccProber(name, this);
+        hw.prober->start(QThread::LowPriority);
+    }
 
     statm = ::open("/proc/self/statm", O_RDONLY);
 }
 
 X11::~X11()
 {
+    if (hw.prober)
+        hw.prober->wait();
+    delete hw.prober;
     delete api;
     delete ss.iface;
     ::close(statm);
 }
 
+auto X11::customEvent(QEvent *event) -> void
+{
+    if (event->type() != HwAccProber::Probed)
+        return;
+    HwAccProbe probe;
+    _TakeData(event, probe);
+    if (probe == hw.cached)
+        return;
+    writeHwAccCache(hw.key, probe);
+    // api object is shared by running engine, so only codecs are reconciled
+    if (api && probe.api == api->api()) {
+        api->restore(probe.codecs);
+        _Info("Hardware acceleration codecs have changed.");
+    } else
+        _Info("Hardware acceleration API has changed to %%, which will be "
+              "used after restart.", probe.api == HwAcc::NoApi
+              ? u"none"_q : HwAcc::name(probe.api));
+    hw.cached = probe;
+}
+
 auto getHwAcc() -> HwAcc* { return d->api; }
 
 template<class T>
 static inline QSharedPointer<T> _Reply(T *t) { return QSharedPointer<T>(t, free); }
 
-auto refreshRate() -> qreal
+// crtc which shows most of rect, in native pixels
+static auto crtcRefreshRate(const QRect &rect) -> qreal
 {
     auto sr = _Reply(xcb_randr_get_screen_resources_current_reply(
         d->connection,
         xcb_randr_get_screen_resources_current_unchecked(d->connection, d->root),
         nullptr));
+    if (!sr)
+        return -1;
     const auto len = xcb_randr_get_screen_resources_current_crtcs_length(sr.data());
-    const int n = qApp->desktop()->screenNumber(qApp->topLevelWidgets().value(0));
-    if (len < 1 || n >= len)
+    const auto crtcs = xcb_randr_get_screen_resources_current_crtcs(sr.data());
+    QVector<xcb_randr_get_crtc_info_cookie_t> cookies(len);
+    for (int i = 0; i < len; ++i)
+        cookies[i] = xcb_randr_get_crtc_info_unchecked(d->connection, crtcs[i],
+                                                       sr->config_timestamp);
+    xcb_randr_mode_t mode = 0;
+    int area = 0;
+    for (int i = 0; i < len; ++i) {
+        auto ci = _Reply(xcb_randr_get_crtc_info_reply(d->connection, cookies[i], nullptr));
+        if (!ci || !ci->mode)
+            continue;
+        const auto r = QRect(ci->x, ci->y, ci->width, ci->height) & rect;
+        if (r.width() * r.height() > area) {
+            area = r.width() * r.height();
+            mode = ci->mode;
+        }
+    }
+    if (!mode)
         return -1;
-    auto crtc = xcb_randr_get_screen_resources_current_crtcs(sr.data())[n];
-    auto ci = _Reply(xcb_randr_get_crtc_info_reply(
-        d->connection,
-        xcb_randr_get_crtc_info_unchecked(d->connection, crtc, XCB_CURRENT_TIME),
-        nullptr));
 
     auto mode_refresh = [] (xcb_randr_mode_info_t *mode_info) -> double
     {
@@ -240,7 +347,7 @@ auto refreshRate() -> qreal
 
     auto it = xcb_randr_get_screen_resources_current_modes_iterator(sr.data());
     while (it.rem) {
-        if (it.data->id == ci->mode)
+        if (it.data->id == mode)
             return mode_refresh(it.data);
         xcb_randr_mode_info_next(&it);
     }
@@ -254,6 +361,8 @@ static auto methodName(ScreensaverMethod method) -> QString
         return u"org.gnome.SessionManager.Inhibit"_q;
     case ScreensaverMethod::Freedesktop:
         return u"org.freedesktop.ScreenSaver.Inhibit"_q;
+    case ScreensaverMethod::Logind:
+        return u"org.freedesktop.login1.Inhibit"_q;
     case ScreensaverMethod::Xss:
         return u"XScreenSaver"_q;
     default:
@@ -267,6 +376,8 @@ static auto methodFromName(const QString &name) -> ScreensaverMethod
         return ScreensaverMethod::Gnome;
     else if (name == "org.freedesktop.ScreenSaver.Inhibit"_a)
         return ScreensaverMethod::Freedesktop;
+    else if (name == "org.freedesktop.login1.Inhibit"_a)
+        return ScreensaverMethod::Logind;
     else if (name == "XScreenSaver"_a)
         return ScreensaverMethod::Xss;
     return ScreensaverMethod::Auto;
@@ -277,10 +388,8 @@ auto setScreensaverMethod(const QString &name) -> void
     bool was = d->ss.inhibit;
     if (was)
         setScreensaverEnabled(true);
-    if (_Change(d->ss.method, methodFromName(name))) {
+    if (_Change(d->ss.method, methodFromName(name)))
         _Delete(d->ss.iface);
-        d->ss.reset.stop();
-    }
     if (was)
         setScreensaverEnabled(false);
 }
@@ -291,6 +400,7 @@ auto screensaverMethods() -> QStringList
         u"auto"_q,
         u"org.gnome.SessionManager.Inhibit"_q,
         u"org.freedesktop.ScreenSaver.Inhibit"_q,
+        u"org.freedesktop.login1.Inhibit"_q,
         u"XScreenSaver"_q
     };
 }
@@ -302,8 +412,6 @@ auto setScreensaverEnabled(bool enabled) -> void
     if (s.inhibit == disabled)
         return;
 
-    s.reset.stop();
-
     if (!s.iface && s.method != ScreensaverMethod::Xss) {
         auto getGnome = [&] () {
             _Renew(s.iface, u"org.gnome.SessionManager"_q,
@@ -315,11 +423,19 @@ auto setScreensaverEnabled(bool enabled) -> void
                    u"/ScreenSaver"_q, u"org.freedesktop.ScreenSaver"_q);
             return s.iface;
         };
+        auto getLogind = [&] () {
+            _Renew(s.iface, u"org.freedesktop.login1"_q,
+                   u"/org/freedesktop/login1"_q, u"org.freedesktop.login1.Manager"_q,
+                   QDBusConnection::systemBus());
+            return s.iface;
+        };
         const auto dbus = [&] () {
             if (s.method == ScreensaverMethod::Gnome)
                 return getGnome()->isValid();
             if (s.method == ScreensaverMethod::Freedesktop)
                 return getFreedesktop()->isValid();
+            if (s.method == ScreensaverMethod::Logind)
+                return getLogind()->isValid();
             if (s.method == ScreensaverMethod::Xss)
                 return false;
             if (getGnome()->isValid()) {
@@ -330,6 +446,10 @@ auto setScreensaverEnabled(bool enabled) -> void
                 s.method = ScreensaverMethod::Freedesktop;
                 return true;
             }
+            if (getLogind()->isValid()) {
+                s.method = ScreensaverMethod::Logind;
+                return true;
+            }
             return false;
         }();
         if (!dbus) {
@@ -342,28 +462,44 @@ auto setScreensaverEnabled(bool enabled) -> void
 
     if (disabled) {
         if (s.iface) {
-            if (s.method == ScreensaverMethod::Gnome)
-                s.reply = s.iface->call(u"Inhibit"_q, u"bomi"_q, 0u,
-                                        u"Running player"_q, 4u | 8u);
-            else
-                s.reply = s.iface->call(u"Inhibit"_q, u"bomi"_q,
-                                        u"Running player"_q);
-            if (!s.reply.isValid()) {
-                _Error("DBus '%%' error: %%", s.iface->interface(),
-                       s.reply.error().message());
-                _Error("Fallback to XCB_SCREEN_SAVER_RESET.");
+            QDBusError error;
+            if (s.method == ScreensaverMethod::Logind) {
+                QDBusReply<QDBusUnixFileDescriptor> lock
+                    = s.iface->call(u"Inhibit"_q, u"idle"_q, u"bomi"_q,
+                                    u"Running player"_q, u"block"_q);
+                if (lock.isValid())
+                    s.lock = lock.value();
+                else
+                    error = lock.error();
+            } else {
+                if (s.method == ScreensaverMethod::Gnome)
+                    s.reply = s.iface->call(u"Inhibit"_q, u"bomi"_q, 0u,
+                                            u"Running player"_q, 4u | 8u);
+                else
+                    s.reply = s.iface->call(u"Inhibit"_q, u"bomi"_q,
+                                            u"Running player"_q);
+                if (!s.reply.isValid())
+                    error = s.reply.error();
+            }
+            if (error.isValid()) {
+                _Error("DBus '%%' error: %%", s.iface->interface(), error.message());
+                _Error("Fallback to XScreenSaver.");
                 _Delete(s.iface);
                 s.method = ScreensaverMethod::Xss;
             } else
                 _Debug("Disable screensaver with '%%'.", s.iface->interface());
         }
         if (s.method == ScreensaverMethod::Xss) {
+            // suspends dpms as well until it is resumed
             xcb_screensaver_suspend(d->connection, 1);
+            xcb_flush(d->connection);
             _Debug("Disable screensaver with XScreenSaver.");
-            s.reset.start();
         }
     } else {
-        if (s.iface) {
+        if (s.method == ScreensaverMethod::Logind) {
+            s.lock = QDBusUnixFileDescriptor();
+            _Debug("Enable screensaver with '%%'.", s.iface->interface());
+        } else if (s.iface) {
             const auto func = s.method == ScreensaverMethod::Gnome ? u"Uninhibit"_q : u"UnInhibit"_q;
             auto res = s.iface->call(func, s.reply.value());
             if (res.type() == QDBusMessage::ErrorMessage)
@@ -374,6 +510,7 @@ auto setScreensaverEnabled(bool enabled) -> void
         }
         if (s.method == ScreensaverMethod::Xss) {
             xcb_screensaver_suspend(d->connection, 0);
+            xcb_flush(d->connection);
             _Debug("Enable screensaver with XScreenSaver.");
         }
     }
@@ -383,15 +520,48 @@ auto setScreensaverEnabled(bool enabled) -> void
 X11WindowAdapter::X11WindowAdapter(QWindow* w)
     : WindowAdapter(w)
 {
-    connect(&m_timer, &QTimer::timeout, this, [=] () {
-        auto cookie = xcb_query_pointer_unchecked(d->connection, winId());
-        auto ptr = xcb_query_pointer_reply(d->connection, cookie, nullptr);
-        const auto pressed = ptr->mask & XCB_BUTTON_MASK_1;
-        free(ptr);
-        if (!pressed)
-            stopDrag();
-    });
+    // mode switches and monitor changes come as randr events
+    qApp->installNativeEventFilter(this);
+    connect(&m_timer, &QTimer::timeout, this, &X11WindowAdapter::checkPointer);
     m_timer.setInterval(10);
+    m_mover.setSingleShot(true);
+    connect(&m_mover, &QTimer::timeout, this,
+            [=] () { WindowAdapter::moveByDrag(m_target); });
+}
+
+X11WindowAdapter::~X11WindowAdapter()
+{
+    qApp->removeNativeEventFilter(this);
+}
+
+auto X11WindowAdapter::queryRefreshRate() const -> qreal
+{
+    const auto dpr = window()->devicePixelRatio();
+    const auto g = window()->frameGeometry();
+    const QRect rect(g.topLeft() * dpr, g.size() * dpr);
+    const auto hz = crtcRefreshRate(rect);
+    return hz > 0 ? hz : WindowAdapter::queryRefreshRate();
+}
+
+auto X11WindowAdapter::nativeEventFilter(const QByteArray &type, void *message,
+                                         long */*result*/) -> bool
+{
+    if (type != "xcb_generic_event_t")
+        return false;
+    auto event = static_cast<xcb_generic_event_t*>(message);
+    const int response = event->response_type & ~0x80;
+    if (response == XCB_PROPERTY_NOTIFY) {
+        auto e = reinterpret_cast<xcb_property_notify_event_t*>(event);
+        if (e->atom == d->atoms[_NET_WM_STATE] && e->window == winId())
+            m_stateKnown = false;
+        return false;
+    }
+    if (!d->randr)
+        return false;
+    const int code = response - d->randr;
+    if (code == XCB_RANDR_SCREEN_CHANGE_NOTIFY || code == XCB_RANDR_NOTIFY)
+        updateRefreshRate();
+    return false;
 }
 
 auto X11WindowAdapter::setFullScreen(bool fs) -> void
@@ -400,10 +570,35 @@ auto X11WindowAdapter::setFullScreen(bool fs) -> void
         d->sendState(winId(), fs, _NET_WM_STATE_FULLSCREEN);
 }
 
+auto X11WindowAdapter::checkPointer() -> void
+{
+    if (m_pointer) {
+        void *reply = nullptr;
+        if (!xcb_poll_for_reply(d->connection, m_pointer, &reply, nullptr))
+            return;
+        m_pointer = 0;
+        if (!reply)
+            return;
+        auto ptr = static_cast<xcb_query_pointer_reply_t*>(reply);
+        const auto pressed = ptr->mask & XCB_BUTTON_MASK_1;
+        free(ptr);
+        if (!pressed) {
+            stopDrag();
+            return;
+        }
+    }
+    m_pointer = xcb_query_pointer_unchecked(d->connection, winId()).sequence;
+    xcb_flush(d->connection);
+}
+
 auto X11WindowAdapter::stopDrag() -> void
 {
     m_timer.stop();
-    if (!isMovingByDrag())
+    if (m_pointer) {
+        xcb_discard_reply(d->connection, m_pointer);
+        m_pointer = 0;
+    }
+    if (!isMovingByDrag() || !d->moveResize)
         return;
 
     // hack to get back focus
@@ -431,6 +626,14 @@ auto X11WindowAdapter::startMoveByDrag(const QPointF &m) -> void
 
 auto X11WindowAdapter::moveByDrag(const QPointF &m) -> void
 {
+    if (!d->moveResize) {
+        m_target = m;
+        if (!m_mover.isActive()) {
+            const auto hz = refreshRate();
+            m_mover.start(hz > 0 ? qMax(1, qRound(1000 / hz)) : 16);
+        }
+        return;
+    }
     if (isMovingByDrag())
         return;
     xcb_ungrab_pointer(d->connection, XCB_TIME_CURRENT_TIME);
@@ -445,12 +648,20 @@ auto X11WindowAdapter::moveByDrag(const QPointF &m) -> void
 
 auto X11WindowAdapter::endMoveByDrag() -> void
 {
+    if (m_mover.isActive()) {
+        m_mover.stop();
+        WindowAdapter::moveByDrag(m_target);
+    }
     stopDrag();
     WindowAdapter::endMoveByDrag();
 }
 
 auto X11WindowAdapter::isAlwaysOnTop() const -> bool
 {
+    if (m_stateKnown)
+        return m_onTop;
+    m_stateKnown = true;
+    m_onTop = false;
     const auto cookie = xcb_get_property_unchecked
         (d->connection, 0, winId(), d->atoms[_NET_WM_STATE], XCB_ATOM_ATOM, 0, 1024);
     auto reply = _Reply(xcb_get_property_reply(d->connection, cookie, nullptr));
@@ -459,9 +670,9 @@ auto X11WindowAdapter::isAlwaysOnTop() const -> bool
     auto begin = static_cast<const xcb_atom_t *>(xcb_get_property_value(reply.data()));
     auto end = begin + reply->length;
     if (std::find(begin, end, d->atoms[_NET_WM_STATE_STAYS_ON_TOP]) != end)
-        return true;
+        return m_onTop = true;
     if (std::find(begin, end, d->atoms[_NET_WM_STATE_ABOVE]) != end)
-        return true;
+        return m_onTop = true;
     return false;
 }
 
@@ -559,22 +770,187 @@ auto totalMemory() -> double
     return (sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE)) / double(1024 * 1024);
 }
 
+// read whole small file in /proc, which is always read from offset 0
+static auto readProc(int fd, char *buffer, int size) -> int
+{
+    const int len = ::pread(fd, buffer, size - 1, 0);
+    if (len <= 0)
+        return 0;
+    buffer[len] = '\0';
+    return len;
+}
+
+// pread() keeps this thread-safe
 auto usingMemory() -> double
 {
-    if (!d->statm)
+    if (!d || !d->statm)
         return 0;
-    // this is not thread safe!!
-    Q_ASSERT(QThread::currentThread() == qApp->thread());
-    static char buffer[BUFSIZ];
-    ::lseek(d->statm, 0, SEEK_SET);
-    int len = ::read(d->statm, buffer, BUFSIZ);
-    if (len <= 0)
+    char buffer[128];
+    if (!readProc(d->statm, buffer, sizeof(buffer)))
         return 0;
-    int size = 0, resident = 0;
-    sscanf(buffer, "%d %d", &size, &resident);
+    long size = 0, resident = 0;
+    sscanf(buffer, "%ld %ld", &size, &resident);
     return resident * sysconf(_SC_PAGESIZE) / double(1024*1024);
 }
 
+auto heapMemory() -> double
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    const auto info = mallinfo2();
+    return (info.uordblks + info.hblkhd) / double(1024*1024);
+#elif defined(__GLIBC__)
+    const auto info = mallinfo();
+    return ((quint64)(uint)info.uordblks + (uint)info.hblkhd) / double(1024*1024);
+#else
+    return -1.0;
+#endif
+}
+
+auto threadTimes() -> QVector<ThreadTime>
+{
+    QVector<ThreadTime> times;
+    auto dir = ::opendir("/proc/self/task");
+    if (!dir)
+        return times;
+    static const double tick = 1e6 / sysconf(_SC_CLK_TCK);
+    const auto pid = ::getpid();
+    char path[64], buffer[512];
+    while (auto entry = ::readdir(dir)) {
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        const int len = readProc(fd, buffer, sizeof(buffer));
+        ::close(fd);
+        // tid (comm) state ppid ... utime stime, comm can have parentheses
+        const auto open = (const char*)memchr(buffer, '(', len);
+        const auto close = (const char*)memrchr(buffer, ')', len);
+        if (!open || !close || close < open)
+            continue;
+        unsigned long long utime = 0, stime = 0;
+        if (sscanf(close + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                   &utime, &stime) != 2)
+            continue;
+        ThreadTime t;
+        t.id = strtoull(entry->d_name, nullptr, 10);
+        t.time = (utime + stime) * tick;
+        t.name = QString::fromLocal8Bit(open + 1, close - open - 1);
+        t.main = (pid_t)t.id == pid;
+        times.push_back(t);
+    }
+    ::closedir(dir);
+    return times;
+}
+
+// cpus clearly slower than fastest one, empty unless cpu is hybrid
+static auto efficiencyCpus() -> QVector<int>
+{
+    const int count = sysconf(_SC_NPROCESSORS_CONF);
+    char path[96], buffer[32];
+    auto read = [&] (const char *name) {
+        QVector<qint64> values;
+        for (int i = 0; i < count; ++i) {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", i, name);
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                return QVector<qint64>();
+            const auto len = readProc(fd, buffer, sizeof(buffer));
+            ::close(fd);
+            const auto value = len ? strtoll(buffer, nullptr, 10) : 0;
+            if (value <= 0)
+                return QVector<qint64>();
+            values.push_back(value);
+        }
+        return values;
+    };
+    // capacity of big.LITTLE, otherwise maximum frequency of intel hybrid
+    auto values = read("cpu_capacity");
+    if (values.isEmpty())
+        values = read("cpufreq/cpuinfo_max_freq");
+    QVector<int> cpus;
+    if (values.isEmpty())
+        return cpus;
+    // favored cores of same kind differ by few percent
+    const auto max = *std::max_element(values.begin(), values.end());
+    for (int i = 0; i < values.size(); ++i) {
+        if (values[i] < max * 0.8)
+            cpus.push_back(i);
+    }
+    return cpus;
+}
+
+static auto rtkit(const QString &method, pid_t tid, const QVariant &priority) -> bool
+{
+    auto msg = QDBusMessage::createMethodCall(u"org.freedesktop.RealtimeKit1"_q,
+                                              u"/org/freedesktop/RealtimeKit1"_q,
+                                              u"org.freedesktop.RealtimeKit1"_q, method);
+    msg << QVariant::fromValue<quint64>(tid) << priority;
+    const auto reply = QDBusConnection::systemBus().call(msg, QDBus::Block, 1000);
+    if (reply.type() != QDBusMessage::ErrorMessage)
+        return true;
+    _Debug("rtkit denied %%: %%", method, reply.errorMessage());
+    return false;
+}
+
+auto setThreadClass(ThreadClass tc) -> bool
+{
+    static const QVector<int> efficiency = efficiencyCpus();
+    static const auto allowed = [] () {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(::getpid(), sizeof(set), &set);
+        return set;
+    }();
+    const auto policy = threadPolicy();
+    const auto tid = (pid_t)::syscall(SYS_gettid);
+
+    auto affinity = allowed;
+    if (tc == ThreadClass::Background && policy.efficiency && !efficiency.isEmpty()) {
+        CPU_ZERO(&affinity);
+        for (auto cpu : efficiency)
+            CPU_SET(cpu, &affinity);
+    }
+    sched_setaffinity(tid, sizeof(affinity), &affinity);
+
+    sched_param param;
+    param.sched_priority = 0;
+    if (tc == ThreadClass::Playback && policy.realtime) {
+        // low priority is enough to win over every normal thread
+        param.sched_priority = 5;
+        if (!pthread_setschedparam(pthread_self(), SCHED_RR | SCHED_RESET_ON_FORK, &param))
+            return true;
+        // rtkit hands out realtime only to threads whose cpu time is bounded
+        rlimit limit;
+        if (!getrlimit(RLIMIT_RTTIME, &limit) && (limit.rlim_max == RLIM_INFINITY
+                                                  || limit.rlim_max > 200000)) {
+            limit.rlim_cur = limit.rlim_max = 200000;
+            setrlimit(RLIMIT_RTTIME, &limit);
+        }
+        if (rtkit(u"MakeThreadRealtime"_q, tid, QVariant::fromValue<quint32>(5)))
+            return true;
+    } else
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    int nice = 0;
+    switch (tc) {
+    case ThreadClass::Playback:
+        nice = policy.realtime ? -10 : 0;
+        break;
+    case ThreadClass::Render:
+        nice = policy.realtime ? -5 : 0;
+        break;
+    case ThreadClass::Background:
+        nice = 10;
+        break;
+    }
+    if (!setpriority(PRIO_PROCESS, tid, nice))
+        return true;
+    // raising priority needs privilege which rtkit has
+    return nice < 0 && rtkit(u"MakeThreadHighPriority"_q, tid, QVariant::fromValue<qint32>(nice));
+}
+
 /******************************************************************************/
 
 struct HwAccCodec {
@@ -627,12 +1003,13 @@ static const HwAccCodec s_vdpCodecs[] = {
 
 #if HAVE_VAAPI
 
-VaApiInfo::VaApiInfo(): HwAccX11(VaApiGLX)
+VaApiInfo::VaApiInfo(Display *xdpy): HwAccX11(VaApiGLX)
 {
     setLogContext("VAAPI");
     setOkStatus(VA_STATUS_SUCCESS);
     setGetErrorStringFunction([] (qint64 s) { return vaErrorStr(s); });
-    const auto xdpy = QX11Info::display();
+    if (!xdpy)
+        return;
     auto display = vaGetDisplayGLX(xdpy);
     if (!check(display ? VA_STATUS_SUCCESS : VA_STATUS_ERROR_UNIMPLEMENTED,
                "Cannot create VADisplay."))
@@ -682,24 +1059,123 @@ VaApiInfo::VaApiInfo(): HwAccX11(VaApiGLX)
 }
 
 auto VaApiInfo::download(mp_hwdec_ctx *ctx, const mp_image *mpi,
-                         mp_image_pool *pool) -> mp_image*
+                         mp_image_pool *pool, const Download &part) -> mp_image*
 {
-    if (!ctx->vaapi_ctx)
+    auto va = ctx->vaapi_ctx;
+    if (!va)
         return nullptr;
-    auto img = va_surface_download((mp_image*)mpi, pool);
-    if (!img)
+    if (part.isWhole()) {
+        auto img = va_surface_download((mp_image*)mpi, pool);
+        if (!img)
+            return nullptr;
+        mp_image_copy_attributes(img, (mp_image*)mpi);
+        return img;
+    }
+    const auto surface = va_surface_id((mp_image*)mpi);
+    if (surface == VA_INVALID_ID)
         return nullptr;
-    mp_image_copy_attributes(img, (mp_image*)mpi);
+    // every va format here has 2x2 chroma
+    Download even = part;
+    even.region = part.region.isNull() ? QRect(0, 0, mpi->w, mpi->h)
+                                       : part.region & QRect(0, 0, mpi->w, mpi->h);
+    even.region.setLeft(even.region.left() & ~1);
+    even.region.setTop(even.region.top() & ~1);
+    even.region.setWidth(even.region.width() & ~1);
+    even.region.setHeight(even.region.height() & ~1);
+    if (even.region.isEmpty())
+        return nullptr;
+
+    mp_image *img = nullptr;
+    mp_image src;
+    VAImage image;
+    // derived image maps surface memory itself on most drivers,
+    // so only the rows and pixels requested are read
+    va_lock(va);
+    bool ok = vaSyncSurface(va->display, surface) == VA_STATUS_SUCCESS
+            && vaDeriveImage(va->display, surface, &image) == VA_STATUS_SUCCESS;
+    va_unlock(va);
+    if (ok) {
+        if (va_image_map(va, &image, &src)) {
+            mp_image_set_size(&src, mpi->w, mpi->h);
+            img = extract(&src, pool, even);
+            va_image_unmap(va, &image);
+        }
+        va_lock(va);
+        vaDestroyImage(va->display, image.image_id);
+        va_unlock(va);
+    }
+    // otherwise driver copies the region only
+    auto format = img ? nullptr : va_image_format_from_imgfmt(va, IMGFMT_NV12);
+    if (format) {
+        const auto &r = even.region;
+        va_lock(va);
+        ok = vaCreateImage(va->display, format, r.width(), r.height(),
+                           &image) == VA_STATUS_SUCCESS;
+        if (ok && vaGetImage(va->display, surface, r.x(), r.y(), r.width(),
+                             r.height(), image.image_id) != VA_STATUS_SUCCESS) {
+            vaDestroyImage(va->display, image.image_id);
+            ok = false;
+        }
+        va_unlock(va);
+        if (ok) {
+            if (va_image_map(va, &image, &src)) {
+                mp_image_set_size(&src, r.width(), r.height());
+                img = extract(&src, pool, even, r.topLeft());
+                va_image_unmap(va, &image);
+            }
+            va_lock(va);
+            vaDestroyImage(va->display, image.image_id);
+            va_unlock(va);
+        }
+    }
+    if (img)
+        mp_image_copy_attributes(img, (mp_image*)mpi);
     return img;
 }
 
+auto VaApiInfo::scanLuma(mp_hwdec_ctx *ctx, const mp_image *mpi) -> double
+{
+    auto va = ctx->vaapi_ctx;
+    if (!va)
+        return -1.0;
+    const auto surface = va_surface_id((mp_image*)mpi);
+    if (surface == VA_INVALID_ID)
+        return -1.0;
+    // derived image maps surface memory itself on most drivers, so only
+    // sampled luma rows are read instead of copying whole frame
+    double avg = -1.0;
+    VAImage image;
+    va_lock(va);
+    if (vaSyncSurface(va->display, surface) == VA_STATUS_SUCCESS
+            && vaDeriveImage(va->display, surface, &image) == VA_STATUS_SUCCESS) {
+        const auto fourcc = image.format.fourcc;
+        void *data = nullptr;
+        if ((fourcc == VA_FOURCC_NV12 || fourcc == VA_FOURCC_YV12
+             || fourcc == VA_FOURCC('I', '4', '2', '0'))
+                && vaMapBuffer(va->display, image.buf, &data) == VA_STATUS_SUCCESS) {
+            mp_image y;
+            memset(&y, 0, sizeof(y));
+            mp_image_setfmt(&y, IMGFMT_Y8);
+            mp_image_set_size(&y, mpi->w, mpi->h);
+            y.params.colorlevels = mpi->params.colorlevels;
+            y.planes[0] = static_cast<uchar*>(data) + image.offsets[0];
+            y.stride[0] = image.pitches[0];
+            avg = _LumaScan(&y);
+            vaUnmapBuffer(va->display, image.buf);
+        }
+        vaDestroyImage(va->display, image.image_id);
+    }
+    va_unlock(va);
+    return avg;
+}
+
 #endif
 
 /******************************************************************************/
 
 #if HAVE_VDPAU
 
-VdpauInfo::VdpauInfo()
+VdpauInfo::VdpauInfo(Display *xdpy)
     : HwAccX11(VdpauX11)
 {
     setLogContext("VDPAU");
@@ -709,7 +1185,9 @@ VdpauInfo::VdpauInfo()
             return "Unknown error code";
         return m_errors[s].constData();
     });
-    if (!check(vdp_device_create_x11(QX11Info::display(), QX11Info::appScreen(),
+    if (!xdpy)
+        return;
+    if (!check(vdp_device_create_x11(xdpy, DefaultScreen(xdpy),
                                      &m_device, &m_proc), "Cannot intialize VDPAU device"))
         return;
     VdpGetErrorString *getErrorString = nullptr;
@@ -764,23 +1242,141 @@ VdpauInfo::VdpauInfo()
 }
 
 auto VdpauInfo::download(mp_hwdec_ctx *ctx, const mp_image *mpi,
-                         mp_image_pool *pool) -> mp_image*
+                         mp_image_pool *pool, const Download &part) -> mp_image*
 {
     if (!ctx->vdpau_ctx)
         return nullptr;
     auto img = mp_image_pool_get(pool, IMGFMT_420P, mpi->w, mpi->h);
+    if (!img)
+        return nullptr;
     mp_image_copy_attributes(img, (mp_image*)mpi);
     const VdpVideoSurface surface = (intptr_t)mpi->planes[3];
     if (ctx->vdpau_ctx->vdp.video_surface_get_bits_y_cb_cr(
                 surface, VDP_YCBCR_FORMAT_YV12, (void* const*)img->planes,
-                (uint32_t*)img->stride) == VDP_STATUS_OK)
+                (uint32_t*)img->stride) != VDP_STATUS_OK) {
+        talloc_free(img);
+        return nullptr;
+    }
+    if (part.isWhole())
         return img;
+    // vdpau has no partial readback, so reduce after the full copy
+    auto reduced = extract(img, pool, part);
     talloc_free(img);
-    return nullptr;
+    if (reduced)
+        mp_image_copy_attributes(reduced, (mp_image*)mpi);
+    return reduced;
 }
 
 #endif
 
+/******************************************************************************/
+
+static auto probeHwAcc(const QByteArray &display) -> HwAccProbe
+{
+    HwAccProbe probe;
+    auto xdpy = XOpenDisplay(display.constData());
+    if (!xdpy)
+        return probe;
+    HwAccX11 *api = nullptr;
+#if HAVE_VAAPI && HAVE_VDPAU
+    api = new VaApiInfo(xdpy);
+    if (!api->isNative()) {
+        delete api;
+        api = new VdpauInfo(xdpy);
+        if (!api->isNative())
+            _Delete(api);
+    }
+#elif HAVE_VAAPI
+    api = new VaApiInfo(xdpy);
+#elif HAVE_VDPAU
+    api = new VdpauInfo(xdpy);
+#endif
+    if (api && !api->isOk())
+        _Info("Failed to initialize hardware acceration API.");
+    else if (api) {
+        probe.api = api->api();
+        probe.codecs = api->supportedCodecs();
+    }
+    delete api;
+    XCloseDisplay(xdpy);
+    return probe;
+}
+
+static auto createHwAcc(const HwAccProbe &probe) -> HwAccX11*
+{
+    HwAccX11 *api = nullptr;
+    switch (probe.api) {
+#if HAVE_VAAPI
+    case HwAcc::VaApiGLX:
+        api = new VaApiInfo(nullptr);
+        break;
+#endif
+#if HAVE_VDPAU
+    case HwAcc::VdpauX11:
+        api = new VdpauInfo(nullptr);
+        break;
+#endif
+    default:
+        return nullptr;
+    }
+    api->restore(probe.codecs);
+    return api;
+}
+
+static auto hwAccKey() -> QString
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto add = [&] (const QString &path) {
+        QFile file(path);
+        if (file.open(QFile::ReadOnly))
+            hash.addData(file.read(1024));
+        hash.addData("\n", 1);
+    };
+    const QDir drm(u"/sys/class/drm"_q);
+    for (auto &card : drm.entryList({ u"card*"_q }, QDir::AllEntries, QDir::Name)) {
+        if (card.contains('-'_q)) // connectors
+            continue;
+        const auto dev = drm.absoluteFilePath(card) % "/device"_a;
+        add(dev % "/vendor"_a);
+        add(dev % "/device"_a);
+        const auto driver = QFileInfo(dev % "/driver"_a).symLinkTarget().section('/'_q, -1);
+        hash.addData(driver.toLatin1());
+        add("/sys/module/"_a % driver % "/version"_a);
+    }
+    add(u"/proc/driver/nvidia/version"_q);
+    hash.addData(qgetenv("LIBVA_DRIVER_NAME") + '\n' + qgetenv("VDPAU_DRIVER"));
+    hash.addData(QByteArray::number(HAVE_VAAPI) + QByteArray::number(HAVE_VDPAU));
+    return _L(hash.result().toHex());
+}
+
+static auto hwAccCacheFile() -> QString
+{
+    return _WritablePath(Location::Cache) % "/hwacc.json"_a;
+}
+
+static auto readHwAccCache(const QString &key, HwAccProbe &probe) -> bool
+{
+    JsonStorage storage(hwAccCacheFile());
+    const auto json = storage.read();
+    if (storage.hasError() || json[u"key"_q].toString() != key)
+        return false;
+    const auto name = json[u"api"_q].toString();
+    probe.api = name.isEmpty() ? HwAcc::NoApi : HwAcc::api(name);
+    if (!name.isEmpty() && probe.api == HwAcc::NoApi)
+        return false;
+    probe.codecs.clear();
+    return json_io(&probe.codecs)->fromJson(probe.codecs, json[u"codecs"_q]);
+}
+
+static auto writeHwAccCache(const QString &key, const HwAccProbe &probe) -> void
+{
+    QJsonObject json;
+    json[u"key"_q] = key;
+    json[u"api"_q] = probe.api == HwAcc::NoApi ? QString() : HwAcc::name(probe.api);
+    json[u"codecs"_q] = json_io(&probe.codecs)->toJson(probe.codecs);
+    JsonStorage(hwAccCacheFile()).write(json);
+}
+
 } // namespace OS
 
 #endif
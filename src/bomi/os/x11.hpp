@@ -9,6 +9,7 @@
 #include "misc/log.hpp"
 #include "enum/deintmethod.hpp"
 #include <functional>
+#include <QAbstractNativeEventFilter>
 
 #if HAVE_VAAPI
 
@@ -48,9 +49,10 @@ auto createAdapter(QWidget *w) -> WindowAdapter*;
 
 struct X11;
 
-class X11WindowAdapter : public WindowAdapter {
+class X11WindowAdapter : public WindowAdapter, public QAbstractNativeEventFilter {
 public:
     X11WindowAdapter(QWindow* w);
+    ~X11WindowAdapter();
     auto setFullScreen(bool fs) -> void final;
     auto isAlwaysOnTop() const -> bool final;
     auto setAlwaysOnTop(bool onTop) -> void final;
@@ -60,8 +62,18 @@ public:
     auto setImeEnabled(bool /*enabled*/) -> void { }
     auto isImeEnabled() const -> bool { return false; }
 private:
+    auto queryRefreshRate() const -> qreal final;
+    auto nativeEventFilter(const QByteArray &type, void *message, long *result) -> bool final;
     auto stopDrag() -> void;
+    auto checkPointer() -> void;
+    // polls button state without waiting for reply while wm moves window
     QTimer m_timer;
+    unsigned int m_pointer = 0;
+    // without wm support, moves are merged to one per frame
+    QTimer m_mover;
+    QPointF m_target;
+    // _NET_WM_STATE is read again only after property notify
+    mutable bool m_onTop = false, m_stateKnown = false;
 };
 
 class HwAccX11 : public HwAcc {
@@ -82,6 +94,9 @@ public:
     auto isOk() const -> bool { return m_ok == m_status; }
     auto status() const -> qint64 { return m_status; }
     auto isNative() const { return m_native; }
+    // take result of earlier probe instead of probing devices
+    auto restore(const QList<CodecId> &codecs) -> void
+        { setNative(true); setSupportedCodecs(codecs); }
 protected:
     HwAccX11(Api api): HwAcc(api)
         { setSupportedDeints(QList<DeintMethod>() << DeintMethod::Bob);}
@@ -100,10 +115,12 @@ private:
 
 #if HAVE_VAAPI
 
+// constructors probe devices on xdpy unless it is null
 struct VaApiInfo : public HwAccX11 {
-    VaApiInfo();
-    auto download(mp_hwdec_ctx *ctx, const mp_image *mpi,
-                  mp_image_pool *pool) -> mp_image* final;
+    VaApiInfo(Display *xdpy);
+    auto download(mp_hwdec_ctx *ctx, const mp_image *mpi, mp_image_pool *pool,
+                  const Download &part = Download()) -> mp_image* final;
+    auto scanLuma(mp_hwdec_ctx *ctx, const mp_image *mpi) -> double final;
 };
 
 #endif
@@ -111,9 +128,9 @@ struct VaApiInfo : public HwAccX11 {
 #if HAVE_VDPAU
 
 struct VdpauInfo : public HwAccX11 {
-    VdpauInfo();
-    auto download(mp_hwdec_ctx *ctx, const mp_image *mpi,
-                  mp_image_pool *pool) -> mp_image* final;
+    VdpauInfo(Display *xdpy);
+    auto download(mp_hwdec_ctx *ctx, const mp_image *mpi, mp_image_pool *pool,
+                  const Download &part = Download()) -> mp_image* final;
 private:
     QVector<QByteArray> m_errors;
     VdpDevice m_device = 0;
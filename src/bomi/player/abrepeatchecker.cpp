@@ -2,12 +2,17 @@
 
 auto ABRepeatChecker::check(int time) -> bool
 {
-    if (!m_repeating || time <= m_b)
+    const int last = m_last;
+    m_last = time;
+    if (!m_repeating || m_times < 0 || last < 0)
         return false;
-    if (m_times < 0)
-        return true;
-    if (m_times <= ++m_nth)
-        stop();
+    // jump from latter half back to former one is a wrap at b
+    const int half = (m_a + m_b)/2;
+    if (!(time < half && half <= last))
+        return false;
+    if (m_times > ++m_nth)
+        return false;
+    stop();
     return true;
 }
 
@@ -17,6 +22,7 @@ auto ABRepeatChecker::start(int times) -> bool
         stop();
     m_times = times;
     m_nth = 0;
+    m_last = -1;
     m_repeating = (m_a >= 0 && m_b > m_a);
     return m_repeating;
 }
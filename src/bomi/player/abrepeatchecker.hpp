@@ -17,12 +17,14 @@ public:
     auto stop() -> void { m_repeating = false; }
     auto setA(int a) -> int { return m_a = a; }
     auto setB(int b) -> int { return m_b = b; }
+    // mpv does the looping, this only counts it
+    // returns true when repeated enough and the loop should be cleared
     auto check(int time) -> bool;
     auto start(int times = -1) -> bool;
 private:
     int m_a = -1, m_b = -1;
     bool m_repeating = false;
-    int m_times = 0, m_nth = 0;
+    int m_times = 0, m_nth = 0, m_last = -1;
 };
 
 #endif // ABREPEATCHECKER_HPP
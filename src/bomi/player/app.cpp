@@ -1,14 +1,22 @@
 #include "app.hpp"
 #include "mrl.hpp"
 #include "mainwindow.hpp"
+#include "headlesswindow.hpp"
 #include "misc/localconnection.hpp"
 #include "misc/logoption.hpp"
 #include "misc/json.hpp"
 #include "misc/locale.hpp"
 #include "misc/objectstorage.hpp"
+#include "misc/directorycache.hpp"
+#include "misc/startuptrace.hpp"
 #include "quick/appobject.hpp"
 #include "rootmenu.hpp"
 #include "os/os.hpp"
+#include "os/resourcemonitor.hpp"
+#include "audio/audiobenchmark.hpp"
+#include "subtitle/subtitlebenchmark.hpp"
+#include "video/videobenchmark.hpp"
+#include "video/renderbenchmark.hpp"
 #include <clocale>
 #include <QStyleFactory>
 #include <QMenuBar>
@@ -17,6 +25,7 @@
 #include <QCommandLineParser>
 #include <QFontDatabase>
 #include <QSettings>
+#include <QTextStream>
 
 #ifdef Q_OS_LINUX
 #include "player/mpris.hpp"
@@ -40,8 +49,10 @@ extern bool useLocalConfig;
 auto translator_load(const Locale &locale) -> bool;
 
 enum class LineCmd {
-    Wake, Open, Action, LogLevel, Debug,
-    DumpApiTree, DumpActionList, WinAssoc, WinUnassoc, WinAssocDefault,
+    Wake, Open, Action, LogLevel, Debug, TraceStartup, Stdin, Headless,
+    DumpApiTree, DumpActionList, BenchmarkAudio, BenchmarkSubtitle, BenchmarkVideo,
+    BenchmarkRender,
+    WinAssoc, WinUnassoc, WinAssocDefault,
     SetSubtitle, AddSubtitle,
 };
 
@@ -59,6 +70,11 @@ public:
     auto value(LineCmd cmd) const -> QString  { return m_parser.value(option(cmd)); }
     auto values(LineCmd cmd) const -> QStringList { return m_parser.values(option(cmd)); }
     auto parse(const QStringList &args) -> void { m_parser.process(args); }
+    // unlike parse(), never exits on error
+    auto tryParse(const QStringList &args) -> bool { return m_parser.parse(args); }
+    auto errorText() const -> QString { return m_parser.errorText(); }
+    // only opens files or runs actions, so running instance can take it as is
+    auto isForwardable() const -> bool;
     auto name(LineCmd cmd) const -> QString { return option(cmd).names().first(); }
     auto toJson() const -> QJsonArray
     {
@@ -73,8 +89,8 @@ public:
             args.push_back(QFileInfo(value(LineCmd::SetSubtitle)).absoluteFilePath());
         if (put(LineCmd::AddSubtitle))
             args.push_back(QFileInfo(value(LineCmd::AddSubtitle)).absoluteFilePath());
-        if (put(LineCmd::Action))
-            args.push_back(value(LineCmd::Action));
+        for (auto &action : values(LineCmd::Action))
+            args << "--"_a % name(LineCmd::Action) << action;
         const auto mrl = this->mrl();
         if (!mrl.isEmpty())
             args.push_back(mrl.toString());
@@ -89,6 +105,30 @@ public:
             lv = qMax(lv, Log::Debug);
         return lv;
     }
+    // split a line of stdin into arguments, double quotes group words
+    static auto split(const QString &line) -> QStringList
+    {
+        QStringList args;
+        QString arg;
+        bool quoted = false, empty = true;
+        for (auto c : line) {
+            if (c == '"'_q) {
+                quoted = !quoted;
+                empty = false;
+            } else if (!quoted && c.isSpace()) {
+                if (!empty)
+                    args.push_back(arg);
+                arg.clear();
+                empty = true;
+            } else {
+                arg += c;
+                empty = false;
+            }
+        }
+        if (!empty)
+            args.push_back(arg);
+        return args;
+    }
     auto mrl() const -> Mrl
     {
         if (isSet(LineCmd::Open)) return Mrl(value(LineCmd::Open));
@@ -109,6 +149,69 @@ CommandParser::CommandParser()
     m_parser.addVersionOption();
     const auto desc = u"The file path or URL to open."_q;
     m_parser.addPositionalArgument(u"mrl"_q, desc, u"mrl"_q);
+    addOption(LineCmd::Open, u"open"_q,
+              u"Open given %1 for file path or URL."_q, u"mrl"_q);
+    addOption(LineCmd::SetSubtitle, u"set-subtitle"_q,
+              u"Set subtitle file to display."_q, u"file"_q);
+//    addOption(LineCmd::AddSubtitle, u"add-subtitle"_q,
+//              u"Add subtitle file to display."_q, u"file"_q);
+    addOption(LineCmd::Wake, u"wake"_q,
+              u"Bring the application window in front."_q);
+    addOption(LineCmd::Action, u"action"_q,
+              u"Exectute %1 action or open %1 menu. "
+               "This can be given several times."_q, u"id"_q);
+    addOption(LineCmd::LogLevel, u"log-level"_q,
+              u"Maximum verbosity for log. %1 should be one of nexts:\n    "_q
+              % Log::levelNames().join(u", "_q), u"lv"_q);
+    addOption(LineCmd::Debug, u"debug"_q,
+              u"Turn on options for debugging."_q);
+    addOption(LineCmd::TraceStartup, u"trace-startup"_q,
+              u"Write elapsed time of each startup phase to log."_q);
+    addOption(LineCmd::Headless, u"headless"_q,
+              u"Bring up only fullscreen video output and JSON-RPC server "
+               "without menu, tray icon, MPRIS or skin."_q);
+    addOption(LineCmd::Stdin, u"stdin"_q,
+              u"Read command lines from stdin, one per line, and "
+               "send them to running instance until end of input."_q);
+    addOption(LineCmd::DumpApiTree, u"dump-api-tree"_q,
+              u"Dump API structure tree to stdout."_q);
+    addOption(LineCmd::DumpActionList, u"dump-action-list"_q,
+              u"Dump executable action list to stdout."_q);
+    addOption(LineCmd::BenchmarkAudio, u"benchmark-audio"_q,
+              u"Measure audio filters with synthetic input and print to stdout."_q);
+    addOption(LineCmd::BenchmarkSubtitle, u"benchmark-subtitle"_q,
+              u"Measure subtitle parsing and rendering and print to stdout."_q);
+    addOption(LineCmd::BenchmarkVideo, u"benchmark-video"_q,
+              u"Measure video filters with synthetic frames and print to stdout."_q);
+    addOption(LineCmd::BenchmarkRender, u"benchmark-render"_q,
+              u"Render generated frames offscreen for each scaler, dithering and "
+              "framebuffer format, compare them with golden images in %1 "
+              "and print to stdout."_q, u"dir"_q);
+#ifdef Q_OS_WIN
+    addOption(LineCmd::WinAssoc, u"win-assoc"_q,
+              u"Associate given comma-separated extension list."_q, u"ext"_q);
+    addOption(LineCmd::WinUnassoc, u"win-unassoc"_q,
+              u"Unassociate all extensions."_q);
+    addOption(LineCmd::WinAssocDefault, u"win-assoc-default"_q,
+              u"Associate default extensions."_q);
+#endif
+}
+
+auto CommandParser::isForwardable() const -> bool
+{
+    if (m_parser.isSet(u"help"_q) || m_parser.isSet(u"version"_q))
+        return false;
+    for (auto it = m_options.begin(); it != m_options.end(); ++it) {
+        switch (it.key()) {
+        case LineCmd::Wake: case LineCmd::Open: case LineCmd::Action:
+        case LineCmd::SetSubtitle: case LineCmd::AddSubtitle:
+            break;
+        default:
+            if (m_parser.isSet(*it))
+                return false;
+        }
+    }
+    return true;
 }
 
 auto CommandParser::addOption(LineCmd cmd, const QStringList &names, const QString &desc,
@@ -120,8 +223,18 @@ auto CommandParser::addOption(LineCmd cmd, const QStringList &names, const QStri
         m_parser.addOption(*m_options.insert(cmd, QCommandLineOption{ names, desc, valName, def }));
 }
 
+static const auto s_connectionId = u"net.xylosper.bomi"_q;
+
+static auto toMessage(App::MessageType type, const QJsonValue &json) -> QByteArray
+{
+    QJsonObject message;
+    message[u"type"_q] = (int)type;
+    message[u"contents"_q] = json;
+    return QJsonDocument(message).toBinaryData();
+}
+
 struct App::Data {
-    Data(App *p): p(p), connection(_L("net.xylosper.bomi"), nullptr) {}
+    Data(App *p): p(p), connection(s_connectionId, nullptr) {}
 
     App *p = nullptr;
     bool gldebug = false;
@@ -139,6 +252,7 @@ struct App::Data {
     QMenuBar *mb = nullptr;
 #endif
     MainWindow *main = nullptr;
+    HeadlessWindow *headless = nullptr;
     ObjectStorage storage;
 
     LogOption logOption = LogOption::default_();
@@ -149,7 +263,9 @@ struct App::Data {
 
     auto open(const Mrl &mrl, const QString &sub) -> void
     {
-        if (!main || !main->isSceneGraphInitialized())
+        if (headless)
+            headless->open(mrl, sub);
+        else if (!main || !main->isSceneGraphInitialized())
             pended = { mrl, sub };
         else if (!mrl.isEmpty())
             main->openFromFileManager(mrl, sub);
@@ -157,6 +273,29 @@ struct App::Data {
             main->setSubtitle(sub);
     }
 
+    // every line goes through the connection opened for command line
+    auto forwardStdin() -> void
+    {
+        QTextStream in(stdin);
+        for (;;) {
+            const auto line = in.readLine();
+            if (line.isNull())
+                break;
+            auto args = CommandParser::split(line);
+            if (args.isEmpty())
+                continue;
+            args.prepend(qApp->applicationFilePath());
+            if (!parser->tryParse(args)) {
+                _Error("Invalid command '%%': %%", line, parser->errorText());
+                continue;
+            }
+            if (!p->sendMessage(CommandLine, parser->toJson())) {
+                _Error("Running instance does not respond.");
+                break;
+            }
+        }
+    }
+
     auto import() -> void
     {
         auto copy = [] (const QString &from, const QString &to) -> bool
@@ -235,37 +374,12 @@ App::App(int &argc, char **argv)
 #endif
 
     OS::initialize();
+    DirectoryCache::initialize();
 
     _New(d->parser);
-    d->parser->addOption(LineCmd::Open, u"open"_q,
-                         u"Open given %1 for file path or URL."_q, u"mrl"_q);
-    d->parser->addOption(LineCmd::SetSubtitle, u"set-subtitle"_q,
-                         u"Set subtitle file to display."_q, u"file"_q);
-//    d->parser->addOption(LineCmd::AddSubtitle, u"add-subtitle"_q,
-//                         u"Add subtitle file to display."_q, u"file"_q);
-    d->parser->addOption(LineCmd::Wake, u"wake"_q,
-                         u"Bring the application window in front."_q);
-    d->parser->addOption(LineCmd::Action, u"action"_q,
-                         u"Exectute %1 action or open %1 menu."_q, u"id"_q);
-    d->parser->addOption(LineCmd::LogLevel, u"log-level"_q,
-                         u"Maximum verbosity for log. %1 should be one of nexts:\n    "_q
-                         % Log::levelNames().join(u", "_q), u"lv"_q);
-    d->parser->addOption(LineCmd::Debug, u"debug"_q,
-                         u"Turn on options for debugging."_q);
-    d->parser->addOption(LineCmd::DumpApiTree, u"dump-api-tree"_q,
-                         u"Dump API structure tree to stdout."_q);
-    d->parser->addOption(LineCmd::DumpActionList, u"dump-action-list"_q,
-                         u"Dump executable action list to stdout."_q);
-#ifdef Q_OS_WIN
-    d->parser->addOption(LineCmd::WinAssoc, u"win-assoc"_q,
-                         u"Associate given comma-separated extension list."_q, u"ext"_q);
-    d->parser->addOption(LineCmd::WinUnassoc, u"win-unassoc"_q,
-                         u"Unassociate all extensions."_q);
-    d->parser->addOption(LineCmd::WinAssocDefault, u"win-assoc-default"_q,
-                         u"Associate default extensions."_q);
-#endif
     d->parser->parse(arguments());
     d->gldebug = d->parser->isSet(LineCmd::Debug);
+    StartupTrace::setEnabled(d->parser->isSet(LineCmd::TraceStartup));
     const auto lvStdOut = d->parser->stdoutLogLevel();
 
     d->import();
@@ -323,9 +437,11 @@ App::~App() {
     delete d->main;
     delete d->mb;
     delete d;
+    OS::ResourceMonitor::finalize();
     OS::finalize();
     RootMenu::finalize();
     delete d->parser;
+    Log::finalize();
 }
 
 auto App::version() -> const char*
@@ -346,16 +462,29 @@ auto App::executeToQuit() -> bool
         AppObject::dumpInfo();
     if (isSet(LineCmd::DumpActionList))
         RootMenu::dumpInfo();
+    if (isSet(LineCmd::BenchmarkAudio))
+        AudioBenchmark::dumpInfo();
+    if (isSet(LineCmd::BenchmarkSubtitle))
+        SubtitleBenchmark::dumpInfo();
+    if (isSet(LineCmd::BenchmarkVideo))
+        VideoBenchmark::dumpInfo();
+    if (isSet(LineCmd::BenchmarkRender))
+        RenderBenchmark::dumpInfo(d->parser->value(LineCmd::BenchmarkRender));
     if (isSet(LineCmd::WinAssoc))
         OS::associateFileTypes(nullptr, true, d->parser->value(LineCmd::WinAssoc).split(','_q));
     if (isSet(LineCmd::WinAssocDefault))
         OS::associateFileTypes(nullptr, true, _CommonExtList(VideoExt | AudioExt));
     if (isSet(LineCmd::WinUnassoc))
         OS::unassociateFileTypes(nullptr, true);
-    if (isUnique() && sendMessage(CommandLine, d->parser->toJson())) {
+    // headless instance never hands its files to window of other one
+    if (!isHeadless() && isUnique() && sendMessage(CommandLine, d->parser->toJson())) {
         done = true;
-        _Info("Another instance of bomi is already running. Exit this...");
-    }
+        if (d->parser->isSet(LineCmd::Stdin))
+            d->forwardStdin();
+        else
+            _Info("Another instance of bomi is already running. Exit this...");
+    } else if (d->parser->isSet(LineCmd::Stdin))
+        _Warn("--stdin requires another running instance of bomi.");
     return done;
 }
 
@@ -371,9 +500,16 @@ auto App::load() -> void
 
 auto App::handleMessage(const QByteArray &message) -> void
 {
-    QJsonParseError error;
-    const auto msg = QJsonDocument::fromJson(message, &error).object();
-    Q_ASSERT(!error.error);
+    auto doc = QJsonDocument::fromBinaryData(message);
+    if (doc.isNull()) { // older instance sends text
+        QJsonParseError error;
+        doc = QJsonDocument::fromJson(message, &error);
+        if (error.error) {
+            _Error("Cannot parse message: %%", error.errorString());
+            return;
+        }
+    }
+    const auto msg = doc.object();
 
     const auto type = msg[u"type"_q].toInt();
     const auto contents = msg[u"contents"_q];
@@ -388,6 +524,16 @@ auto App::handleMessage(const QByteArray &message) -> void
     }
 }
 
+auto App::isHeadless() const -> bool
+{
+    return d->parser->isSet(LineCmd::Headless);
+}
+
+auto App::setHeadlessWindow(HeadlessWindow *window) -> void
+{
+    d->headless = window;
+}
+
 auto App::isOpenGLDebugLoggerRequested() const -> bool
 {
     return d->gldebug;
@@ -400,8 +546,11 @@ auto App::setMainWindow(MainWindow *mw) -> void
     d->main->setIcon(defaultIcon());
 #endif
     connect(d->main, &MainWindow::sceneGraphInitialized, this, [this] () {
+        StartupTrace::mark("scene graph");
         if (!d->pended.mrl.isEmpty())
             d->main->openFromFileManager(d->pended.mrl, d->pended.sub);
+        else // nothing to play, so startup ends here
+            StartupTrace::finish("idle");
         d->pended.clear();
     }, Qt::QueuedConnection);
 }
@@ -488,24 +637,31 @@ auto App::runCommands() -> void
 {
 //    if (isSet(LineCmd::OpenGLDebug))
 //        gldebug = true;
-    if (!d->main)
+    if (!d->main && !d->headless)
         return;
-    if (d->parser->isSet(LineCmd::Wake))
+    if (d->main && d->parser->isSet(LineCmd::Wake))
         d->main->wake();
     const auto mrl = d->parser->mrl();
     const auto sub = d->parser->value(LineCmd::SetSubtitle);
     d->open(mrl, sub);
-    const auto args = d->parser->values(LineCmd::Action);
-    if (!args.isEmpty())
-        RootMenu::instance().execute(args[0]);
+    for (auto &id : d->parser->values(LineCmd::Action))
+        RootMenu::instance().execute(id);
 }
 
 auto App::sendMessage(MessageType type, const QJsonValue &json, int timeout) -> bool
 {
-    QJsonObject message;
-    message[u"type"_q] = (int)type;
-    message[u"contents"_q] = json;
-    return d->connection.sendMessage(QJsonDocument(message).toJson(), timeout);
+    return d->connection.sendMessage(toMessage(type, json), timeout);
+}
+
+// no gui, plugin, translation or config is touched before this
+auto App::handOff(int &argc, char **argv) -> bool
+{
+    QCoreApplication core(argc, argv);
+    CommandParser parser;
+    if (!parser.tryParse(core.arguments()) || !parser.isForwardable())
+        return false;
+    return LocalConnection::forward(s_connectionId,
+                                    toMessage(CommandLine, parser.toJson()), 1000);
 }
 
 auto App::setLocale(const Locale &locale) -> void
@@ -554,7 +710,9 @@ auto App::setStyleName(const QString &name) -> void
 
 auto App::setUnique(bool unique) -> void
 {
-    d->unique = unique;
+    // running server means unique instance to handOff() of others
+    if (_Change(d->unique, unique) && !unique)
+        d->connection.stopServer();
 }
 
 auto App::styleName() const -> QString
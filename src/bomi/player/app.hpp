@@ -3,6 +3,7 @@
 
 class QUrl;                             class Mrl;
 class MainWindow;                       class QMenuBar;
+class HeadlessWindow;
 class Locale;                           struct LogOption;
 
 class App : public QApplication {
@@ -22,6 +23,8 @@ public:
     auto styleName() const -> QString;
     auto isUnique() const -> bool;
     auto executeToQuit() -> bool;
+    // sends command line to running instance before App is constructed
+    static auto handOff(int &argc, char **argv) -> bool;
     auto availableStyleNames() const -> QStringList;
     auto setUseLocalConfig(bool local) -> void;
     auto useLocalConfig() const -> bool;
@@ -37,6 +40,8 @@ public:
     auto setUnique(bool unique) -> void;
     auto runCommands() -> void;
     auto isOpenGLDebugLoggerRequested() const -> bool;
+    auto isHeadless() const -> bool;
+    auto setHeadlessWindow(HeadlessWindow *window) -> void;
     auto setMprisActivated(bool activated) -> void;
     auto sendMessage(MessageType type, const QJsonValue &t, int timeout = 5000) -> bool;
     auto sendMessage(MessageType type, const QStringList &t, int timeout = 5000) -> bool;
@@ -0,0 +1,186 @@
+#include "audiooverview.hpp"
+#include "mpv_property.hpp"
+#include "audio/loudnessmeter.hpp"
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+// content up to 8kHz dominates both envelope and loudness
+static constexpr int Rate = 16000, Channels = 2, Version = 1;
+static constexpr int BucketFrames = Rate / 1000 * AudioOverview::BucketMSecs;
+
+struct OverviewDecoder {
+    AVFormatContext *format = nullptr;
+    AVCodecContext *codec = nullptr;
+    AVFrame *frame = nullptr;
+    SwrContext *swr = nullptr;
+    int stream = -1, inFormat = -1, inRate = 0;
+    quint64 inLayout = 0;
+    std::vector<float> buffer;
+    ~OverviewDecoder()
+    {
+        swr_free(&swr);
+        av_frame_free(&frame);
+        if (codec)
+            avcodec_close(codec);
+        avformat_close_input(&format);
+    }
+    auto open(const QByteArray &path) -> bool
+    {
+        if (avformat_open_input(&format, path.constData(), nullptr, nullptr) < 0)
+            return false;
+        if (avformat_find_stream_info(format, nullptr) < 0)
+            return false;
+        AVCodec *dec = nullptr;
+        stream = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, &dec, 0);
+        if (stream < 0 || !dec)
+            return false;
+        for (uint i = 0; i < format->nb_streams; ++i) {
+            if ((int)i != stream)
+                format->streams[i]->discard = AVDISCARD_ALL;
+        }
+        auto ctx = format->streams[stream]->codec;
+        // playback has priority, so stay on one thread
+        ctx->thread_count = 1;
+        if (avcodec_open2(ctx, dec, nullptr) < 0)
+            return false;
+        codec = ctx;
+        frame = av_frame_alloc();
+        return frame;
+    }
+    // resampler follows format changes in the middle of stream
+    auto setup() -> bool
+    {
+        const quint64 layout = frame->channel_layout ? frame->channel_layout
+                : av_get_default_channel_layout(av_frame_get_channels(frame));
+        if (swr && inFormat == frame->format && inRate == frame->sample_rate
+                && inLayout == layout)
+            return true;
+        inFormat = frame->format; inRate = frame->sample_rate; inLayout = layout;
+        swr_free(&swr);
+        swr = swr_alloc_set_opts(nullptr, AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, Rate,
+                                 layout, (AVSampleFormat)inFormat, inRate, 0, nullptr);
+        if (swr && swr_init(swr) < 0)
+            swr_free(&swr);
+        return swr;
+    }
+    // returns number of converted frames in buffer
+    auto convert() -> int
+    {
+        if (frame->sample_rate <= 0 || !setup())
+            return 0;
+        const int frames = av_rescale_rnd(swr_get_delay(swr, inRate) + frame->nb_samples,
+                                          Rate, inRate, AV_ROUND_UP);
+        buffer.resize(frames * Channels);
+        auto out = (uint8_t*)buffer.data();
+        return std::max(0, swr_convert(swr, &out, frames,
+                                       (const uint8_t**)frame->extended_data,
+                                       frame->nb_samples));
+    }
+};
+
+struct OverviewEnvelope {
+    QByteArray peak, rms;
+    int frames = 0;
+    float max = 0.f;
+    double energy = 0.0;
+    auto quantize(double v) -> char { return qBound<int>(0, qRound(v * 255.0), 255); }
+    auto feed(const float *data, int count) -> void
+    {
+        for (int i = 0; i < count; ++i) {
+            for (int c = 0; c < Channels; ++c, ++data) {
+                max = std::max(max, std::abs(*data));
+                energy += *data * *data;
+            }
+            if (++frames == BucketFrames)
+                flush();
+        }
+    }
+    auto flush() -> void
+    {
+        if (!frames)
+            return;
+        peak.push_back(quantize(max));
+        rms.push_back(quantize(std::sqrt(energy / (frames * Channels))));
+        frames = 0; max = 0.f; energy = 0.0;
+    }
+};
+
+auto AudioOverview::peaks(int count) const -> QList<qreal>
+{
+    QList<qreal> list;
+    if (isEmpty() || count <= 0)
+        return list;
+    list.reserve(count);
+    const int size = this->size();
+    for (int i = 0; i < count; ++i) {
+        const int from = (qint64)i * size / count;
+        const int to = std::max<int>(from + 1, (qint64)(i + 1) * size / count);
+        uchar max = 0;
+        for (int j = from; j < to; ++j)
+            max = std::max<uchar>(max, m_peak[j]);
+        list.push_back(max / 255.0);
+    }
+    return list;
+}
+
+auto AudioOverview::toByteArray() const -> QByteArray
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << (qint32)Version << m_loudness << m_peak << m_rms;
+    return data;
+}
+
+auto AudioOverview::fromByteArray(const QByteArray &data) -> AudioOverview
+{
+    AudioOverview overview;
+    QDataStream in(data);
+    qint32 version = 0;
+    in >> version;
+    if (version != Version)
+        return overview;
+    in >> overview.m_loudness >> overview.m_peak >> overview.m_rms;
+    if (in.status() != QDataStream::Ok || overview.m_peak.size() != overview.m_rms.size())
+        return AudioOverview();
+    return overview;
+}
+
+auto AudioOverview::build(const QString &file,
+                          const std::atomic<bool> &cancel) -> AudioOverview
+{
+    AudioOverview overview;
+    OverviewDecoder decoder;
+    if (file.isEmpty() || !decoder.open(MpvFile(file).toMpv()))
+        return overview;
+    OverviewEnvelope envelope;
+    LoudnessMeter meter;
+    meter.setFormat(Rate, std::vector<double>(Channels, 1.0));
+    AVPacket packet;
+    while (!cancel && av_read_frame(decoder.format, &packet) >= 0) {
+        AVPacket left = packet;
+        while (packet.stream_index == decoder.stream && left.size > 0) {
+            int got = 0;
+            const int used = avcodec_decode_audio4(decoder.codec, decoder.frame, &got, &left);
+            if (used < 0)
+                break;
+            left.data += used;
+            left.size -= used;
+            const int frames = got ? decoder.convert() : 0;
+            if (frames > 0) {
+                envelope.feed(decoder.buffer.data(), frames);
+                meter.feed(decoder.buffer.data(), frames);
+            }
+        }
+        av_free_packet(&packet);
+    }
+    if (cancel)
+        return overview;
+    envelope.flush();
+    overview.m_peak = envelope.peak;
+    overview.m_rms = envelope.rms;
+    overview.m_loudness = meter.integrated();
+    return overview;
+}
@@ -0,0 +1,28 @@
+#ifndef AUDIOOVERVIEW_HPP
+#define AUDIOOVERVIEW_HPP
+
+// peak and rms envelope of whole audio in 1s buckets with gated loudness
+// levels are quantized to a byte, so an hour takes about 7KiB
+class AudioOverview {
+public:
+    static constexpr int BucketMSecs = 1000;
+    auto isEmpty() const -> bool { return m_peak.isEmpty(); }
+    auto size() const -> int { return m_peak.size(); }
+    // linear levels in [0, 1]
+    auto peak(int i) const -> double { return (uchar)m_peak[i] / 255.0; }
+    auto rms(int i) const -> double { return (uchar)m_rms[i] / 255.0; }
+    // integrated EBU R128 loudness in LUFS, -inf for silence
+    auto loudness() const -> double { return m_loudness; }
+    // highest peak of count equal spans for drawing
+    auto peaks(int count) const -> QList<qreal>;
+    auto toByteArray() const -> QByteArray;
+    static auto fromByteArray(const QByteArray &data) -> AudioOverview;
+    // decode best audio stream only, downmixed to stereo at reduced rate
+    static auto build(const QString &file,
+                      const std::atomic<bool> &cancel) -> AudioOverview;
+private:
+    QByteArray m_peak, m_rms;
+    double m_loudness = -qInf();
+};
+
+#endif // AUDIOOVERVIEW_HPP
@@ -2,6 +2,8 @@
 #include "streamtrack.hpp"
 #include "video/videoformat.hpp"
 #include "audio/audioformat.hpp"
+#include "video/rendertiming.hpp"
+#include "audio/audioprofile.hpp"
 #include <QQmlEngine>
 
 template<class L, class T = typename std::remove_pointer<typename L::value_type>::type>
@@ -96,6 +98,41 @@ auto AvCommonObject::setTracks(const StreamList &tracks) -> void
 
 /******************************************************************************/
 
+AudioProfileObject::AudioProfileObject()
+{
+    for (int i = 0; i < AudioProfile::StageCount; ++i)
+        m_stages.push_back(new AudioStageProfileObject(AudioProfile::name((AudioProfile::Stage)i)));
+}
+
+AudioProfileObject::~AudioProfileObject()
+{
+    qDeleteAll(m_stages);
+}
+
+auto AudioProfileObject::stages() const -> QQmlListProperty<AudioStageProfileObject>
+{
+    return _MakeQmlList(this, &m_stages);
+}
+
+auto AudioProfileObject::update() -> void
+{
+    if (!m_profile)
+        return;
+    const auto stats = m_profile->stats();
+    for (int i = 0; i < m_stages.size(); ++i)
+        m_stages[i]->set(stats.stages[i]);
+    m_total.set(stats.total);
+}
+
+void AudioProfileObject::reset()
+{
+    if (m_profile)
+        m_profile->reset();
+    update();
+}
+
+/******************************************************************************/
+
 AudioObject::AudioObject()
     : AvCommonObject(StreamAudio)
 {
@@ -172,6 +209,70 @@ auto VideoFormatObject::spaceText() const -> QString
     return QString();
 }
 
+auto RenderPassTimingObject::set(qreal gpu, qreal gpuMax,
+                                 qreal cpu, qreal cpuMax) -> void
+{
+    bool changed = _Change(m_gpu, gpu);
+    changed |= _Change(m_gpuMax, gpuMax);
+    changed |= _Change(m_cpu, cpu);
+    changed |= _Change(m_cpuMax, cpuMax);
+    if (changed)
+        emit this->changed();
+}
+
+auto RenderTimingObject::update(int dropped) -> void
+{
+    if (!m_timing)
+        return;
+    const auto stats = m_timing->stats();
+    auto set = [&] (RenderPassTimingObject &o, RenderTiming::Pass pass) {
+        const auto &s = stats.passes[pass];
+        o.set(s.gpu, s.gpuMax, s.cpu, s.cpuMax);
+    };
+    set(m_video, RenderTiming::Video);
+    set(m_osd, RenderTiming::Osd);
+    set(m_subtitle, RenderTiming::Subtitle);
+    if (dropped < m_droppedBase)
+        m_droppedBase = 0;
+    bool changed = _Change(m_interval, stats.interval);
+    changed |= _Change(m_intervalMax, stats.intervalMax);
+    changed |= _Change(m_misses, stats.vsyncMisses);
+    changed |= _Change(m_dropped, dropped);
+    changed |= _Change(m_samples, stats.samples);
+    if (changed)
+        emit this->changed();
+}
+
+void RenderTimingObject::reset()
+{
+    if (m_timing)
+        m_timing->reset();
+    m_droppedBase = m_dropped;
+    update(m_dropped);
+    emit changed();
+}
+
+auto PlaybackStatsObject::update() -> void
+{
+    if (!m_stats)
+        return;
+    m_summary = m_stats->summary();
+    m_map = m_summary.toMap();
+    emit changed();
+}
+
+QVariantMap PlaybackStatsObject::summary() const
+{
+    return m_stats ? m_stats->summary().toMap() : QVariantMap();
+}
+
+void PlaybackStatsObject::reset()
+{
+    if (m_stats)
+        m_stats->reset();
+    update();
+}
+
 VideoObject::VideoObject()
     : AvCommonObject(StreamVideo)
 {
@@ -192,6 +293,16 @@ void VideoObject::setDroppedFrames(int f)
         emit droppedFpsChanged();
 }
 
+auto VideoObject::setDecoderStats(double time, int queue, int dropped) -> void
+{
+    bool changed = false;
+    changed |= _Change(m_decodeTime, time);
+    changed |= _Change(m_decoderQueue, queue);
+    changed |= _Change(m_decoderDropped, dropped);
+    if (changed)
+        emit decoderStatsChanged();
+}
+
 auto VideoObject::delayedTime() const -> qreal
 {
     double fps = m_filter.fps();
@@ -3,10 +3,13 @@
 
 #include "enum/colorrange.hpp"
 #include "enum/colorspace.hpp"
+#include "audiooverview.hpp"
+#include "video/playbackstats.hpp"
 #include <QQmlListProperty>
 
 class AudioFormat;                      class StreamTrack;
 class StreamList;                       class VideoRenderer;
+class RenderTiming;                     class AudioProfile;
 
 class CodecObject : public QObject {
     Q_OBJECT
@@ -142,15 +145,95 @@ private:
     QString m_ch;
 };
 
+class AudioStageProfileObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString name READ name CONSTANT FINAL)
+    Q_PROPERTY(qreal time READ time NOTIFY changed)
+    Q_PROPERTY(qreal p50 READ p50 NOTIFY changed)
+    Q_PROPERTY(qreal p95 READ p95 NOTIFY changed)
+    Q_PROPERTY(qreal p99 READ p99 NOTIFY changed)
+    Q_PROPERTY(qreal max READ max NOTIFY changed)
+    Q_PROPERTY(qreal frames READ frames NOTIFY changed)
+    Q_PROPERTY(qreal allocations READ allocations NOTIFY changed)
+    Q_PROPERTY(qreal passthrough READ passthrough NOTIFY changed)
+public:
+    AudioStageProfileObject(const QString &name = QString()): m_name(name) { }
+    auto name() const -> QString { return m_name; }
+    // in us per processed buffer
+    auto time() const -> qreal { return m_time[0]; }
+    auto p50() const -> qreal { return m_time[1]; }
+    auto p95() const -> qreal { return m_time[2]; }
+    auto p99() const -> qreal { return m_time[3]; }
+    auto max() const -> qreal { return m_time[4]; }
+    auto frames() const -> qreal { return m_frames; }
+    auto allocations() const -> qreal { return m_allocs; }
+    // ratio of buffers which skipped the stage
+    auto passthrough() const -> qreal { return m_passthrough; }
+    template<class Stats>
+    auto set(const Stats &s) -> void
+    {
+        bool changed = _Change(m_time[0], s.average) | _Change(m_time[1], s.p50)
+                | _Change(m_time[2], s.p95) | _Change(m_time[3], s.p99)
+                | _Change(m_time[4], s.max);
+        changed |= _Change(m_frames, s.frames) | _Change(m_allocs, s.allocations)
+                | _Change(m_passthrough, s.passthroughRatio());
+        if (changed)
+            emit this->changed();
+    }
+signals:
+    void changed();
+private:
+    QString m_name;
+    std::array<qreal, 5> m_time{{0, 0, 0, 0, 0}};
+    qreal m_frames = 0, m_allocs = 0, m_passthrough = 0;
+};
+
+class AudioProfileObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(AudioStageProfileObject *resampler READ resampler CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *analyzer READ analyzer CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *scaler READ scaler CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *mixer READ mixer CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *equalizer READ equalizer CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *converter READ converter CONSTANT FINAL)
+    Q_PROPERTY(AudioStageProfileObject *total READ total CONSTANT FINAL)
+    Q_PROPERTY(QQmlListProperty<AudioStageProfileObject> stages READ stages CONSTANT FINAL)
+public:
+    AudioProfileObject();
+    ~AudioProfileObject();
+    auto resampler() -> AudioStageProfileObject* { return m_stages[0]; }
+    auto analyzer() -> AudioStageProfileObject* { return m_stages[1]; }
+    auto scaler() -> AudioStageProfileObject* { return m_stages[2]; }
+    auto mixer() -> AudioStageProfileObject* { return m_stages[3]; }
+    auto equalizer() -> AudioStageProfileObject* { return m_stages[4]; }
+    auto converter() -> AudioStageProfileObject* { return m_stages[5]; }
+    auto total() -> AudioStageProfileObject* { return &m_total; }
+    auto stages() const -> QQmlListProperty<AudioStageProfileObject>;
+    auto setProfile(AudioProfile *profile) -> void { m_profile = profile; }
+    auto update() -> void;
+    Q_INVOKABLE void reset();
+private:
+    AudioProfile *m_profile = nullptr;
+    QList<AudioStageProfileObject*> m_stages;
+    AudioStageProfileObject m_total{u"total"_q};
+};
+
 class AudioObject : public AvCommonObject {
     Q_OBJECT
     Q_PROPERTY(AudioFormatObject *decoder READ decoder CONSTANT FINAL)
     Q_PROPERTY(AudioFormatObject *filter READ filter CONSTANT FINAL)
     Q_PROPERTY(AudioFormatObject *output READ output CONSTANT FINAL)
     Q_PROPERTY(double normalizer READ normalizer NOTIFY normalizerChanged)
+    Q_PROPERTY(double momentaryLoudness READ momentaryLoudness NOTIFY loudnessChanged)
+    Q_PROPERTY(double shortTermLoudness READ shortTermLoudness NOTIFY loudnessChanged)
+    Q_PROPERTY(double integratedLoudness READ integratedLoudness NOTIFY loudnessChanged)
     Q_PROPERTY(QString driver READ driver NOTIFY driverChanged)
     Q_PROPERTY(QString device READ device NOTIFY deviceChanged)
+    Q_PROPERTY(double latency READ latency NOTIFY latencyChanged)
     Q_PROPERTY(QList<qreal> spectrum READ spectrum NOTIFY spectrumChanged)
+    Q_PROPERTY(bool hasOverview READ hasOverview NOTIFY overviewChanged)
+    Q_PROPERTY(double fileLoudness READ fileLoudness NOTIFY overviewChanged)
+    Q_PROPERTY(AudioProfileObject *profile READ profile CONSTANT FINAL)
 public:
     AudioObject();
     auto decoder() const -> const AudioFormatObject* { return &m_decoder; }
@@ -162,24 +245,54 @@ public:
     auto normalizer() const -> double { return m_gain; }
     auto setNormalizer(double gain) -> void
         { if (_Change(m_gain, gain)) emit normalizerChanged(); }
+    auto momentaryLoudness() const -> double { return m_loudness[0]; }
+    auto shortTermLoudness() const -> double { return m_loudness[1]; }
+    auto integratedLoudness() const -> double { return m_loudness[2]; }
+    auto setLoudness(double momentary, double shortTerm, double integrated) -> void
+    {
+        if (_Change(m_loudness[0], momentary) | _Change(m_loudness[1], shortTerm)
+                | _Change(m_loudness[2], integrated))
+            emit loudnessChanged();
+    }
     auto device() const -> QString;
     auto driver() const -> QString { return m_driver; }
+    // filters and output buffer in ms
+    auto latency() const -> double { return m_latency; }
+    auto setLatency(double ms) -> void
+        { if (_Change(m_latency, ms)) emit latencyChanged(); }
     auto spectrum() const -> QList<qreal> { return m_spectrum; }
     auto setSpectrum(const QList<qreal> &spectrum) -> void
         { emit spectrumChanged(m_spectrum = spectrum); }
+    // waveform of whole file, computed in background for local files
+    auto overview() const -> const AudioOverview& { return m_overview; }
+    auto setOverview(const AudioOverview &overview) -> void
+        { m_overview = overview; emit overviewChanged(); }
+    auto hasOverview() const -> bool { return !m_overview.isEmpty(); }
+    auto fileLoudness() const -> double { return m_overview.loudness(); }
+    // peaks in [0, 1] of count equal spans from begin to end
+    Q_INVOKABLE QList<qreal> waveform(int count) const
+        { return m_overview.peaks(count); }
+    auto profile() -> AudioProfileObject* { return &m_profile; }
 public slots:
     void setDriver(const QString &driver);
     void setDevice(const QString &device);
 signals:
     void normalizerChanged();
+    void loudnessChanged();
     void driverChanged();
     void deviceChanged();
+    void latencyChanged();
     void spectrumChanged(const QList<qreal> &spectrum);
+    void overviewChanged();
 private:
     AudioFormatObject m_decoder, m_filter, m_output;
-    double m_gain = -1.0;
+    double m_gain = -1.0, m_latency = 0.0;
+    // momentary, short-term and integrated in LUFS
+    std::array<double, 3> m_loudness{{-qInf(), -qInf(), -qInf()}};
     QString m_driver, m_device;
     QList<qreal> m_spectrum;
+    AudioOverview m_overview;
+    AudioProfileObject m_profile;
 };
 
 /******************************************************************************/
@@ -261,6 +374,84 @@ private:
     ColorRange m_range = ColorRange::Auto;
 };
 
+class RenderPassTimingObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(qreal gpuTime READ gpuTime NOTIFY changed)
+    Q_PROPERTY(qreal gpuMax READ gpuMax NOTIFY changed)
+    Q_PROPERTY(qreal cpuTime READ cpuTime NOTIFY changed)
+    Q_PROPERTY(qreal cpuMax READ cpuMax NOTIFY changed)
+public:
+    // in ms, negative gpu time if timer query is not supported
+    auto gpuTime() const -> qreal { return m_gpu; }
+    auto gpuMax() const -> qreal { return m_gpuMax; }
+    auto cpuTime() const -> qreal { return m_cpu; }
+    auto cpuMax() const -> qreal { return m_cpuMax; }
+    auto set(qreal gpu, qreal gpuMax, qreal cpu, qreal cpuMax) -> void;
+signals:
+    void changed();
+private:
+    qreal m_gpu = -1, m_gpuMax = -1, m_cpu = 0, m_cpuMax = 0;
+};
+
+class RenderTimingObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(RenderPassTimingObject *video READ video CONSTANT FINAL)
+    Q_PROPERTY(RenderPassTimingObject *osd READ osd CONSTANT FINAL)
+    Q_PROPERTY(RenderPassTimingObject *subtitle READ subtitle CONSTANT FINAL)
+    Q_PROPERTY(qreal frameInterval READ frameInterval NOTIFY changed)
+    Q_PROPERTY(qreal frameIntervalMax READ frameIntervalMax NOTIFY changed)
+    Q_PROPERTY(int vsyncMisses READ vsyncMisses NOTIFY changed)
+    Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY changed)
+    Q_PROPERTY(int samples READ samples NOTIFY changed)
+public:
+    auto video() -> RenderPassTimingObject* { return &m_video; }
+    auto osd() -> RenderPassTimingObject* { return &m_osd; }
+    auto subtitle() -> RenderPassTimingObject* { return &m_subtitle; }
+    auto frameInterval() const -> qreal { return m_interval; }
+    auto frameIntervalMax() const -> qreal { return m_intervalMax; }
+    auto vsyncMisses() const -> int { return m_misses; }
+    auto droppedFrames() const -> int { return m_dropped - m_droppedBase; }
+    auto samples() const -> int { return m_samples; }
+    auto setTiming(RenderTiming *timing) -> void { m_timing = timing; }
+    auto update(int dropped) -> void;
+    Q_INVOKABLE void reset();
+signals:
+    void changed();
+private:
+    RenderTiming *m_timing = nullptr;
+    RenderPassTimingObject m_video, m_osd, m_subtitle;
+    qreal m_interval = 0, m_intervalMax = 0;
+    int m_misses = 0, m_dropped = 0, m_droppedBase = 0, m_samples = 0;
+};
+
+class PlaybackStatsObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap avSync READ avSync NOTIFY changed)
+    Q_PROPERTY(QVariantMap frameInterval READ frameInterval NOTIFY changed)
+    Q_PROPERTY(qint64 frames READ frames NOTIFY changed)
+    Q_PROPERTY(qint64 lateFrames READ lateFrames NOTIFY changed)
+    Q_PROPERTY(qint64 decoderDrops READ decoderDrops NOTIFY changed)
+    Q_PROPERTY(qint64 outputDrops READ outputDrops NOTIFY changed)
+public:
+    auto avSync() const -> QVariantMap { return m_map[u"avSync"_q].toMap(); }
+    auto frameInterval() const -> QVariantMap { return m_map[u"frameInterval"_q].toMap(); }
+    auto frames() const -> qint64 { return m_summary.frames; }
+    auto lateFrames() const -> qint64 { return m_summary.lateFrames; }
+    auto decoderDrops() const -> qint64 { return m_summary.decoderDrops; }
+    auto outputDrops() const -> qint64 { return m_summary.outputDrops; }
+    auto setStats(PlaybackStats *stats) -> void { m_stats = stats; }
+    auto update() -> void;
+    // fresh one even if nobody subscribed to info
+    Q_INVOKABLE QVariantMap summary() const;
+    Q_INVOKABLE void reset();
+signals:
+    void changed();
+private:
+    PlaybackStats *m_stats = nullptr;
+    PlaybackStats::Summary m_summary;
+    QVariantMap m_map;
+};
+
 class VideoObject : public AvCommonObject {
     Q_OBJECT
     Q_PROPERTY(VideoFormatObject *decoder READ decoder CONSTANT FINAL)
@@ -269,12 +460,18 @@ class VideoObject : public AvCommonObject {
     Q_PROPERTY(VideoToolObject *hardwareAcceleration READ hwacc CONSTANT FINAL)
     Q_PROPERTY(VideoToolObject *deinterlacer READ deint CONSTANT FINAL)
     Q_PROPERTY(VideoRenderer *screen READ screen CONSTANT FINAL)
+    Q_PROPERTY(RenderTimingObject *timing READ timing CONSTANT FINAL)
+    Q_PROPERTY(PlaybackStatsObject *stats READ stats CONSTANT FINAL)
     Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY droppedFramesChanged)
     Q_PROPERTY(int delayedFrames READ delayedFrames NOTIFY delayedFramesChanged)
     Q_PROPERTY(qreal delayedTime READ delayedTime NOTIFY delayedTimeChanged)
     Q_PROPERTY(qreal droppedFps READ droppedFps NOTIFY droppedFpsChanged)
     Q_PROPERTY(qint64 frameNumber READ frameNumber NOTIFY frameNumberChanged)
     Q_PROPERTY(qint64 frameCount READ frameCount NOTIFY frameCountChanged)
+    Q_PROPERTY(qreal decodeTime READ decodeTime NOTIFY decoderStatsChanged)
+    Q_PROPERTY(int decoderQueue READ decoderQueue NOTIFY decoderStatsChanged)
+    Q_PROPERTY(int decoderDroppedFrames READ decoderDroppedFrames NOTIFY decoderStatsChanged)
+    Q_PROPERTY(int decoderThreads READ decoderThreads NOTIFY decoderStatsChanged)
 public:
     VideoObject();
     auto decoder() const -> const VideoFormatObject* { return &m_decoder; }
@@ -302,8 +499,18 @@ public:
         { if (_Change(m_frameNumber, n)) emit frameNumberChanged(); }
     auto frameNumber() const -> qint64 { return m_frameNumber; }
     auto frameCount() const -> qint64 { return m_frameCount; }
+    // average ms per decoded packet, packets held by decoder, late frames
+    auto setDecoderStats(double time, int queue, int dropped) -> void;
+    auto setDecoderThreads(int threads) -> void
+        { if (_Change(m_decoderThreads, threads)) emit decoderStatsChanged(); }
+    auto decodeTime() const -> qreal { return m_decodeTime; }
+    auto decoderQueue() const -> int { return m_decoderQueue; }
+    auto decoderDroppedFrames() const -> int { return m_decoderDropped; }
+    auto decoderThreads() const -> int { return m_decoderThreads; }
     auto screen() const -> VideoRenderer* { return m_screen; }
     auto setScreen(VideoRenderer *vr) { m_screen = vr; }
+    auto timing() -> RenderTimingObject* { return &m_timing; }
+    auto stats() -> PlaybackStatsObject* { return &m_stats; }
 signals:
     void frameCountChanged();
     void frameNumberChanged();
@@ -311,11 +518,15 @@ signals:
     void droppedFpsChanged();
     void delayedFramesChanged();
     void delayedTimeChanged();
+    void decoderStatsChanged();
 private:
     VideoFormatObject m_decoder, m_filter, m_output;
     VideoToolObject m_hwacc, m_deint;
+    RenderTimingObject m_timing;
+    PlaybackStatsObject m_stats;
     int m_dropped = 0, m_delayed = 0;
-    qreal m_droppedFps = 0.0, m_fpsMp = 1;
+    int m_decoderQueue = 0, m_decoderDropped = 0, m_decoderThreads = 0;
+    qreal m_droppedFps = 0.0, m_fpsMp = 1, m_decodeTime = 0.0;
     qint64 m_frameCount = 0, m_frameNumber = 0;
     QTime m_time;
     VideoRenderer *m_screen = nullptr;
@@ -0,0 +1,143 @@
+#include "headlesswindow.hpp"
+#include "app.hpp"
+#include "playengine.hpp"
+#include "historymodel.hpp"
+#include "mediaprobe.hpp"
+#include "pref/pref.hpp"
+#include "misc/youtubedl.hpp"
+#include "misc/yledl.hpp"
+#include "misc/startuptrace.hpp"
+#include "json/jrserver.hpp"
+#include "player/jrplayer.hpp"
+#include "quick/appobject.hpp"
+#include "video/videopreview.hpp"
+#include "os/os.hpp"
+#include <QQuickItem>
+
+DECLARE_LOG_CONTEXT(Headless)
+
+struct HeadlessWindow::Data {
+    HeadlessWindow *p = nullptr;
+    // deleted with scene graph which owns its gl resources
+    PlayEngine *e = new PlayEngine;
+    MediaProbeCache probes;
+    HistoryModel history;
+    YouTubeDL youtube;
+    YleDL yle;
+    Pref pref;
+    JrServer *jrServer = nullptr;
+    JrPlayer jrPlayer;
+    auto fit() -> void
+    {
+        if (auto screen = e->screen()) {
+            screen->setWidth(p->width());
+            screen->setHeight(p->height());
+        }
+    }
+};
+
+HeadlessWindow::HeadlessWindow()
+    : QQuickView(), d(new Data)
+{
+    d->p = this;
+    setColor(Qt::black);
+    setFlags(flags() | Qt::FramelessWindowHint);
+    setPersistentOpenGLContext(true);
+    setPersistentSceneGraph(true);
+
+    d->pref.initialize();
+    d->pref.load();
+    StartupTrace::mark("preferences");
+
+    AppObject::setQmlEngine(QQuickView::engine());
+    AppObject::setEngine(d->e);
+    AppObject::setHistory(&d->history);
+
+    d->history.setProbeCache(&d->probes);
+    d->history.setRetention(d->pref.history_max_days(), d->pref.history_max_count());
+    d->e->setHistory(&d->history);
+    d->e->setProbeCache(&d->probes);
+    d->e->setYouTube(&d->youtube);
+    d->e->setYle(&d->yle);
+    d->youtube.setProgram(d->pref.yt_program());
+    d->yle.setProgram(d->pref.yle_program());
+    d->e->run();
+    d->e->preview()->setActive(false);
+    d->e->setPreferences(d->pref);
+    StartupTrace::mark("engine");
+
+    d->e->screen()->setParentItem(contentItem());
+    d->fit();
+
+    connect(this, &QQuickView::sceneGraphInitialized, this, [this] () {
+        d->e->initializeGL(this, openglContext());
+        _Debug("Scene graph initialized.");
+    }, Qt::DirectConnection);
+    connect(this, &QQuickView::sceneGraphInvalidated, this, [this] () {
+        d->e->finalizeGL(QOpenGLContext::currentContext());
+        d->e->deleteLater();
+        _Debug("Scene graph invalidated.");
+    }, Qt::DirectConnection);
+    connect(&cApp, &App::commitDataRequest, this, [=] () { exit(); });
+
+    // controlled only through json-rpc, so server runs whatever preferences say
+    const auto &p = d->pref;
+    _New(d->jrServer, p.jr_connection(), p.jr_protocol());
+    d->jrServer->setInterface(&d->jrPlayer);
+    d->jrServer->setErrorHandler([=] (auto) {
+        _Error("JSON-RPC server error: %%", d->jrServer->errorString());
+    });
+    if (!d->jrServer->listen(p.jr_address(), p.jr_port()))
+        _Error("Cannot listen on %%:%% for JSON-RPC.", p.jr_address(), p.jr_port());
+
+    OS::setScreensaverMethod(p.screensaver_method());
+    OS::setScreensaverEnabled(false);
+}
+
+HeadlessWindow::~HeadlessWindow()
+{
+    d->jrServer->setInterface(nullptr);
+    delete d->jrServer;
+    exit();
+    setPersistentOpenGLContext(false);
+    setPersistentSceneGraph(false);
+    releaseResources();
+    _Debug("Delete headless window.");
+    delete d;
+}
+
+auto HeadlessWindow::open(const Mrl &mrl, const QString &sub) -> void
+{
+    if (!mrl.isEmpty())
+        d->e->load(mrl, true, sub);
+    else if (!sub.isEmpty())
+        d->e->addSubtitleFiles({ sub }, d->pref.sub_enc());
+}
+
+auto HeadlessWindow::exit() -> void
+{
+    static bool done = false;
+    if (done)
+        return;
+    done = true;
+    OS::setScreensaverEnabled(true);
+    d->e->shutdown();
+    d->e->waitUntilTerminated();
+    cApp.processEvents();
+    cApp.quit();
+}
+
+auto HeadlessWindow::event(QEvent *event) -> bool
+{
+    if (event->type() == QEvent::Close) {
+        exit();
+        return true;
+    }
+    return QQuickView::event(event);
+}
+
+auto HeadlessWindow::resizeEvent(QResizeEvent *event) -> void
+{
+    QQuickView::resizeEvent(event);
+    d->fit();
+}
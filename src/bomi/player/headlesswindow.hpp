@@ -0,0 +1,23 @@
+#ifndef HEADLESSWINDOW_HPP
+#define HEADLESSWINDOW_HPP
+
+#include <QQuickView>
+
+class Mrl;
+
+// fullscreen video output and json-rpc server only, no menu, tray or skin
+class HeadlessWindow : public QQuickView {
+    Q_OBJECT
+public:
+    HeadlessWindow();
+    ~HeadlessWindow();
+    auto open(const Mrl &mrl, const QString &sub = QString()) -> void;
+    auto exit() -> void;
+private:
+    auto event(QEvent *event) -> bool final;
+    auto resizeEvent(QResizeEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // HEADLESSWINDOW_HPP
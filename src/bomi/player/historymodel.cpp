@@ -1,11 +1,17 @@
 #include "historymodel.hpp"
 #include "mrlstatesqlfield.hpp"
+#include "mediaprobe.hpp"
 #include "misc/log.hpp"
+#include "misc/dataevent.hpp"
+#include "os/resourcemonitor.hpp"
+#include "os/os.hpp"
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QQuickItem>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QThreadPool>
 
 DECLARE_LOG_CONTEXT(History)
 
@@ -20,6 +26,8 @@ public:
             return true;
         return m_doing = check(m_db->transaction(), "transaction()"_b);
     }
+    // roll back when done
+    auto abort() -> void { m_commit = false; }
     auto done() -> void
     {
         if (!m_doing)
@@ -39,77 +47,595 @@ private:
     bool m_commit = true, m_doing = false;
 };
 
-struct RowCache { Mrl mrl; int row = -1; };
+static auto check(const QSqlQuery &query) -> bool
+{
+    if (!query.lastError().isValid())
+        return true;
+    _Error("Error on query: %% for %%"
+           , query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+enum EventType { Reload = QEvent::User + 1, Progress };
 
 static constexpr auto currentVersion = MrlState::Version;
 
+// merged writes for one mrl
+struct PendingWrite {
+    QSharedPointer<MrlState> state;
+    QStringList columns; // updated when upsert is false
+    bool upsert = false;
+};
+
+// writes history with own connection so that commits never block gui thread
+class HistoryWriter : public QThread {
+public:
+    // writes are delayed at most by this to be merged in one transaction
+    static constexpr int FlushInterval = 1000;
+    // pruning and vacuum run after being idle for this
+    static constexpr int MaintainInterval = 3600 * 1000;
+    ~HistoryWriter() { stop(); }
+    // migrate from old version first if it's not negative
+    auto open(QObject *model, const QString &path,
+              const MrlStateSqlFieldList &fields,
+              const MrlStateSqlFieldList &writes, int migrate = -1) -> void
+    {
+        m_model = model;
+        m_path = path;
+        m_fields = fields;
+        m_writes = writes;
+        m_migrate = migrate;
+        start();
+    }
+    // write out everything queued and finish, unfinished migration is dropped
+    auto stop() -> void
+    {
+        m_abort = true;
+        m_mutex.lock(); m_quit = true; m_wake.wakeAll(); m_mutex.unlock(); wait();
+    }
+    // remove unstarred rows older than days or beyond count, 0 for no limit
+    auto setRetention(int days, int count) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (_Change(m_days, days) | _Change(m_count, count)) {
+            m_maintain = true;
+            m_wake.wakeAll();
+        }
+    }
+    // empty column for whole state
+    auto push(const MrlState *state, const QString &column) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!isRunning())
+            return;
+        if (m_pending.isEmpty())
+            m_since.start();
+        auto &w = m_pending[state->mrl()];
+        if (!w.state) {
+            w.state.reset(new MrlState);
+            w.state->set_mrl(state->mrl());
+        }
+        if (column.isEmpty()) {
+            w.state->copyFrom(state);
+            w.upsert = true;
+            w.columns.clear();
+        } else {
+            const auto f = m_fields.field(column);
+            f.property().write(w.state.data(), f.property().read(state));
+            if (!w.upsert && !w.columns.contains(column))
+                w.columns.push_back(column);
+        }
+        m_wake.wakeAll();
+    }
+    // block until all queued writes are committed
+    auto flush() -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!isRunning())
+            return;
+        m_flushing = true;
+        m_wake.wakeAll();
+        while (!isIdle())
+            m_idle.wait(&m_mutex);
+        m_flushing = false;
+    }
+    // post Reload event to model when queued writes are committed
+    // returns false if nothing is queued
+    auto requestReload() -> bool
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_reload = !isIdle();
+    }
+    // apply queued values of fields for mrl to state
+    // returns true if whole state is queued
+    auto overlay(QObject *state, const Mrl &mrl,
+                 const MrlStateSqlFieldList &fields) const -> bool
+    {
+        QMutexLocker locker(&m_mutex);
+        bool upsert = false;
+        for (auto map : { &m_writing, &m_pending }) {
+            const auto it = map->find(mrl);
+            if (it == map->end())
+                continue;
+            upsert |= it->upsert;
+            for (auto &f : fields) {
+                if (it->upsert || it->columns.contains(_L(f.property().name())))
+                    f.property().write(state, f.property().read(it->state.data()));
+            }
+        }
+        return upsert;
+    }
+private:
+    auto isIdle() const -> bool { return m_pending.isEmpty() && m_writing.isEmpty(); }
+    auto run() -> void final;
+    auto migrate(QSqlDatabase &db, SqlQueryCache &queries) -> void;
+    // returns number of pruned rows
+    auto maintain(QSqlDatabase &db, int days, int count) -> int;
+    // returns true if new row is inserted
+    auto write(SqlQueryCache &queries, const PendingWrite &w) -> bool;
+    QObject *m_model = nullptr;
+    QString m_path;
+    const QString m_table = MrlState::table();
+    MrlStateSqlFieldList m_fields, m_writes;
+    QHash<Mrl, PendingWrite> m_pending, m_writing;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake, m_idle;
+    QElapsedTimer m_since;
+    int m_migrate = -1, m_days = 0, m_count = 0;
+    bool m_quit = false, m_flushing = false, m_reload = false, m_maintain = true;
+    std::atomic<bool> m_abort{false};
+};
+
+auto HistoryWriter::run() -> void
+{
+    const auto name = u"history-writer"_q;
+    {
+        auto db = QSqlDatabase::addDatabase(u"QSQLITE"_q, name);
+        db.setDatabaseName(m_path);
+        if (!db.open())
+            _Error("Error: %%. Couldn't open database for writing.",
+                   db.lastError().text());
+        // with wal, commits skip fsync and only checkpoints sync
+        QSqlQuery(db).exec(u"PRAGMA synchronous = NORMAL"_q);
+        SqlQueryCache queries(db);
+        if (m_migrate >= 0 && db.isOpen())
+            migrate(db, queries);
+        QMutexLocker locker(&m_mutex);
+        forever {
+            while (!m_quit && m_pending.isEmpty() && !m_maintain) {
+                if (!m_wake.wait(&m_mutex, MaintainInterval))
+                    m_maintain = true;
+            }
+            if (!m_quit && m_pending.isEmpty() && m_maintain) {
+                m_maintain = false;
+                const int days = m_days, count = m_count;
+                locker.unlock();
+                const int removed = db.isOpen() ? maintain(db, days, count) : 0;
+                locker.relock();
+                if (removed > 0)
+                    _PostEvent(m_model, Reload, -removed);
+                continue;
+            }
+            if (m_pending.isEmpty())
+                break;
+            if (!m_quit && !m_flushing) {
+                const auto remains = FlushInterval - m_since.elapsed();
+                if (remains > 0) {
+                    m_wake.wait(&m_mutex, remains);
+                    continue;
+                }
+            }
+            m_writing.swap(m_pending);
+            locker.unlock();
+            int inserted = 0;
+            if (db.isOpen()) {
+                Transactor t(&db);
+                for (auto &w : m_writing)
+                    inserted += write(queries, w);
+            }
+            locker.relock();
+            m_writing.clear();
+            m_idle.wakeAll();
+            // new rows change length of list, so report them anyway
+            const bool reload = m_reload && m_pending.isEmpty();
+            if (reload || inserted > 0) {
+                if (reload)
+                    m_reload = false;
+                _PostEvent(m_model, Reload, inserted);
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto HistoryWriter::migrate(QSqlDatabase &db, SqlQueryCache &queries) -> void
+{
+    QElapsedTimer timer;
+    timer.start();
+    // one transaction for all rows, new table is empty so insert is enough
+    Transactor t(&db);
+    const int count = _ImportMrlStates(m_migrate, db, [&] (const MrlState *state,
+                                                          int index, int total) {
+        if (m_abort)
+            return false;
+        check(m_fields.insert(queries, state));
+        if (timer.elapsed() > 100) {
+            timer.restart();
+            _PostEvent(m_model, Progress, index, total);
+        }
+        return true;
+    });
+    if (count < 0) {
+        t.abort();
+        return;
+    }
+    QSqlQuery(db).exec("PRAGMA user_version = "_a % _N(currentVersion));
+    t.done();
+    _PostEvent(m_model, Progress, count, count);
+    _PostEvent(m_model, Reload, count);
+}
+
+auto HistoryWriter::maintain(QSqlDatabase &db, int days, int count) -> int
+{
+    QSqlQuery query(db);
+    int removed = 0;
+    if (days > 0 || count > 0) {
+        Transactor t(&db);
+        if (days > 0) {
+            const auto since = QDateTime::currentDateTime().addDays(-days);
+            query.prepare("DELETE FROM "_a % m_table % " WHERE star = 0"
+                          " AND last_played_date_time < ?"_a);
+            query.addBindValue(since.toMSecsSinceEpoch());
+            if (query.exec())
+                removed += query.numRowsAffected();
+            check(query);
+        }
+        if (count > 0) {
+            // starred rows are kept and not counted
+            query.prepare("DELETE FROM "_a % m_table % " WHERE rowid IN"
+                          " (SELECT rowid FROM "_a % m_table % " WHERE star = 0"
+                          " ORDER BY last_played_date_time DESC LIMIT -1 OFFSET ?)"_a);
+            query.addBindValue(count);
+            if (query.exec())
+                removed += query.numRowsAffected();
+            check(query);
+        }
+    }
+    // auto_vacuum takes effect only after full vacuum, done once
+    if (query.exec(u"PRAGMA auto_vacuum"_q) && query.next()
+            && query.value(0).toInt() != 2) {
+        query.finish();
+        query.exec(u"PRAGMA auto_vacuum = INCREMENTAL"_q);
+        query.exec(u"VACUUM"_q);
+    } else {
+        query.finish();
+        query.exec(u"PRAGMA incremental_vacuum(1024)"_q);
+        while (query.next()) { }
+    }
+    check(query);
+    if (removed > 0)
+        _Info("%% old records removed.", removed);
+    return removed;
+}
+
+auto HistoryWriter::write(SqlQueryCache &queries, const PendingWrite &w) -> bool
+{
+    const auto state = w.state.data();
+    if (w.upsert) {
+        auto &update = m_writes.update(queries, state);
+        if (!check(update))
+            return false;
+        const bool insert = update.numRowsAffected() <= 0;
+        if (insert && !check(m_fields.insert(queries, state)))
+            return false;
+        // star is not written with state, so snapshot does not have it
+        auto &snapshot = queries.get("UPDATE "_a % m_table
+                                     % " SET snapshot=? WHERE mrl=?"_a);
+        snapshot.bindValue(0, m_writes.encode(state, currentVersion));
+        m_fields.field(u"mrl"_q).bind(snapshot, 1, state);
+        snapshot.exec();
+        check(snapshot);
+        return insert;
+    }
+    const auto m = m_fields.field(u"mrl"_q);
+    for (auto &column : w.columns) {
+        const auto f = m_fields.field(column);
+        // snapshot is stale now and columns will be read until next upsert
+        auto &query = queries.get("UPDATE "_a % m_table % " SET "_a % column
+                                  % "=?, snapshot=NULL WHERE mrl=?"_a);
+        f.bind(query, 0, state);
+        m.bind(query, 1, state);
+        query.exec();
+        check(query);
+    }
+    return false;
+}
+
+// one row of history list, read back by keyset pagination
+struct HistoryRow {
+    QString id, device, name;
+    qint64 last = 0, rowid = 0;
+    bool star = false;
+    // formatted on first display, pages are dropped on every change
+    mutable QVariantMap record;
+    auto mrl() const -> const Mrl&
+    {
+        if (m_mrl.isEmpty())
+            m_mrl = Mrl::fromUniqueId(id, device, name);
+        return m_mrl;
+    }
+private:
+    mutable Mrl m_mrl;
+};
+
+using HistoryPage = QVector<HistoryRow>;
+
+static constexpr int PageSize = 64, MaxPages = 16;
+
+// file of history entry and where it will resume, 0..1 of duration
+struct WarmTarget {
+    QString path;
+    double ratio = 0.0;
+};
+
+// reads header, tail and data around resume position of recent files so that
+// page cache of os or network file system has them when one gets opened
+class HistoryWarmJob : public QRunnable {
+public:
+    // bytes read from each part, window starts a quarter before resume
+    static constexpr qint64 Header = 2 << 20, Tail = 1 << 20, Window = 8 << 20;
+    HistoryWarmJob(const QVector<WarmTarget> &targets,
+                   const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_targets(targets), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        OS::setThreadClass(OS::ThreadClass::Background);
+        QByteArray buffer(256 << 10, Qt::Uninitialized);
+        for (auto &t : m_targets) {
+            QFile file(t.path);
+            if (*m_cancel || !file.open(QFile::ReadOnly))
+                continue;
+            const auto size = file.size();
+            const auto at = qBound<qint64>(0, size * t.ratio - Window / 4, size);
+            read(file, buffer, 0, Header);
+            read(file, buffer, at, Window);
+            read(file, buffer, size - Tail, Tail);
+            _Debug("Warmed %%.", t.path);
+        }
+    }
+private:
+    auto read(QFile &file, QByteArray &buffer, qint64 from, qint64 length) -> void
+    {
+        if (!file.seek(qMax<qint64>(0, from)))
+            return;
+        while (length > 0 && !*m_cancel) {
+            const auto read = file.read(buffer.data(), qMin<qint64>(buffer.size(), length));
+            if (read <= 0)
+                break;
+            length -= read;
+        }
+    }
+    QVector<WarmTarget> m_targets;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
 struct HistoryModel::Data {
     HistoryModel *p = nullptr;
     QSqlDatabase db;
-    RowCache rowCache;
+    QMap<int, HistoryPage> pages;
+    QSet<int> prefetches;
+    QTimer prefetcher;
+    // warming up entries on top while list is shown
+    QThreadPool warmer;
+    QSharedPointer<std::atomic<bool>> warming;
+    QSet<QString> warmed;
     QSqlQuery loader, finder;
+    SqlQueryCache queries;
     QSqlError error;
     MrlStateSqlFieldList fields, restores, writes;
+    // restores which snapshot does not have, selected with it
+    MrlStateSqlFieldList extras;
+    QString snapshotQuery;
     MrlState cached;
     const MrlState default_{};
     const QString table = MrlState::table();
     bool rememberImage = false, reload = true, visible = false;
-    bool mediaTitleLocal = false, mediaTitleUrl = false;
-    int idx_mrl, idx_name, idx_last, idx_device, idx_star, rows = 0;
+    bool mediaTitleLocal = false, mediaTitleUrl = false, importing = false;
+    double progress = 0.0;
+    const MediaProbeCache *probes = nullptr;
+    int rows = 0;
     QMutex mutex;
-    auto check(const QSqlQuery &query) -> bool
-    {
-        if (!query.lastError().isValid())
-            return true;
-        _Error("Error on query: %% for %%"
-               , query.lastError().text(), query.lastQuery());
-        return false;
-    }
-    auto upsert(const MrlState *state) -> bool
-    {
-        if (state->mrl() == cached.mrl())
-            cached.set_mrl(Mrl());
-        if (!writes.update(finder, state))
-            return check(finder);
-        if (finder.numRowsAffected() > 0)
-            return true;
-        fields.insert(finder, state);
-        return check(finder);
-    }
+    HistoryWriter writer;
+    // count rows only once, later changes are tracked by reset()
     auto load() -> bool
     {
-        const QString select = QString::fromLatin1(
-            "SELECT mrl, name, last_played_date_time, device, star"
-            ", (SELECT COUNT(*) FROM %1) as total FROM %2 ORDER BY "
-            "CASE WHEN star = 1 THEN 1 ELSE 0 END DESC"
-            ", last_played_date_time DESC"
-        );
-        if (!loader.exec(select.arg(table).arg(table))) {
+        if (!loader.exec("SELECT COUNT(*) FROM "_a % table) || !loader.next()) {
             _Error("%%", loader.lastError().text());
             _Error("Query: %%", loader.lastQuery());
             return false;
         }
-        Q_ASSERT(!loader.isForwardOnly());
+        reset(loader.value(0).toInt());
+        return true;
+    }
+    auto reset(int count) -> void
+    {
         p->beginResetModel();
-        rows = 0;
-        if (loader.next()) {
-            int c = 0;
-            idx_mrl = c++;
-            idx_name = c++;
-            idx_last = c++;
-            idx_device = c++;
-            idx_star = c++;
-            if (_Change(rows,loader.value(c).toInt()))
-                emit p->lengthChanged(rows);
-            loader.seek(-1);
-        }
+        pages.clear();
+        prefetches.clear();
+        if (_Change(rows, qMax(0, count)))
+            emit p->lengthChanged(rows);
         error = QSqlError();
         p->endResetModel();
         reload = false;
-        rowCache = RowCache();
-        return true;
     }
-    auto import(const QVector<MrlState*> &states) -> void
+    // rows are sorted by (star, last_played_date_time, rowid) descending
+    // and a page starts right after the last key of previous page
+    auto fetch(int page) -> const HistoryPage*
+    {
+        auto it = pages.find(page);
+        if (it != pages.end())
+            return &*it;
+        if (page < 0 || page * PageSize >= rows)
+            return nullptr;
+        const auto select = "SELECT mrl, name, last_played_date_time, device, "
+                            "star, rowid FROM "_a % table;
+        const auto order = " ORDER BY star DESC, last_played_date_time DESC, "
+                           "rowid DESC LIMIT "_a % _N(PageSize);
+        const auto prev = pages.find(page - 1);
+        QSqlQuery *query = nullptr;
+        if (prev != pages.end() && prev->size() == PageSize) {
+            query = &queries.get(select % " WHERE star < ?1 OR (star = ?1 AND "
+                "(last_played_date_time < ?2 OR (last_played_date_time = ?2 "
+                "AND rowid < ?3)))"_a % order);
+            query->bindValue(0, int(prev->last().star));
+            query->bindValue(1, prev->last().last);
+            query->bindValue(2, prev->last().rowid);
+        } else {
+            // jumped without previous page, the index still avoids sorting
+            query = &queries.get(select % order % " OFFSET ?"_a);
+            query->bindValue(0, page * PageSize);
+        }
+        if (!query->exec()) {
+            check(*query);
+            return nullptr;
+        }
+        HistoryPage items;
+        items.reserve(PageSize);
+        while (query->next()) {
+            HistoryRow row;
+            row.id = query->value(0).toString();
+            row.name = query->value(1).toString();
+            row.last = query->value(2).toLongLong();
+            row.device = query->value(3).toString();
+            row.star = query->value(4).toBool();
+            row.rowid = query->value(5).toLongLong();
+            items.push_back(row);
+        }
+        query->finish();
+        while (pages.size() >= MaxPages) {
+            // drop the farthest page
+            const bool front = page - pages.firstKey() > pages.lastKey() - page;
+            pages.erase(front ? pages.begin() : --pages.end());
+        }
+        return &*pages.insert(page, items);
+    }
+    auto row(int row) -> const HistoryRow*
+    {
+        if (!_InRange0(row, rows))
+            return nullptr;
+        const int page = row / PageSize;
+        auto items = fetch(page);
+        if (!items || row % PageSize >= items->size())
+            return nullptr;
+        // neighbours are loaded on idle while list is scrolled
+        for (auto next : { page + 1, page - 1 }) {
+            if (!pages.contains(next) && next >= 0 && next * PageSize < rows)
+                prefetches.insert(next);
+        }
+        if (!prefetches.isEmpty() && !prefetcher.isActive())
+            prefetcher.start();
+        return &(*items)[row % PageSize];
+    }
+    auto displayName(const HistoryRow *item) const -> QString
+    {
+        const auto &mrl = item->mrl();
+        if ((mrl.isLocalFile() && mediaTitleLocal)
+                || (mrl.isRemoteUrl() && mediaTitleUrl)) {
+            if (!item->name.isEmpty())
+                return item->name;
+            if (probes) {
+                const auto probe = probes->find(mrl);
+                if (!probe.title.isEmpty())
+                    return probe.title;
+            }
+        }
+        return mrl.displayName();
+    }
+    auto record(const HistoryRow *item) const -> const QVariantMap&
+    {
+        if (item->record.isEmpty()) {
+            item->record[u"name"_q] = displayName(item);
+            item->record[u"latestplay"_q]
+                    = QDateTime::fromMSecsSinceEpoch(item->last).toString(Qt::ISODate);
+            item->record[u"location"_q] = item->mrl().toString();
+            item->record[u"star"_q] = item->star;
+        }
+        return item->record;
+    }
+    // 1 if restored from snapshot, 0 if no snapshot, -1 if no row
+    auto restore(MrlState *state) -> int
+    {
+        auto &query = queries.get(snapshotQuery);
+        fields.field(u"mrl"_q).bind(query, 0, state);
+        if (!query.exec() || !query.next())
+            return check(query) ? -1 : 0;
+        const auto blob = query.value(0).toByteArray();
+        const bool ok = restores.decode(blob, state, currentVersion);
+        if (ok) {
+            int i = 0;
+            for (auto &f : extras)
+                f.exportTo(state, query.value(++i));
+        }
+        query.finish();
+        return ok;
+    }
+    auto prefetch() -> void
+    {
+        if (prefetches.isEmpty())
+            return;
+        const int page = *prefetches.begin();
+        prefetches.erase(prefetches.begin());
+        fetch(page);
+        if (!prefetches.isEmpty())
+            prefetcher.start();
+    }
+    // local files only, mounted network shares are where it helps
+    auto warm() -> void
+    {
+        static constexpr int Count = 4;
+        QVector<WarmTarget> targets;
+        auto &query = queries.get("SELECT resume_position FROM "_a % table % " WHERE mrl = ?"_a);
+        const auto m = fields.field(u"mrl"_q);
+        for (int i = 0; i < rows && targets.size() < Count; ++i) {
+            const auto item = row(i);
+            if (!item)
+                break;
+            const auto &mrl = item->mrl();
+            if (!mrl.isLocalFile() || mrl.isImage())
+                continue;
+            query.bindValue(0, m.sqlData(QVariant::fromValue(mrl)));
+            if (!query.exec() || !query.next()) {
+                check(query);
+                continue;
+            }
+            const int resume = query.value(0).toInt();
+            query.finish();
+            const auto probe = probes ? probes->find(mrl) : MediaProbe();
+            WarmTarget t;
+            t.path = mrl.toLocalFile();
+            if (resume > 0 && probe.duration > 0)
+                t.ratio = qBound(0.0, resume / (double)probe.duration, 1.0);
+            const auto key = t.path % '@'_q % _N(resume);
+            if (!warmed.contains(key)) {
+                warmed.insert(key);
+                targets.push_back(t);
+            }
+        }
+        if (targets.isEmpty())
+            return;
+        warming.reset(new std::atomic<bool>(false));
+        warmer.start(new HistoryWarmJob(targets, warming));
+    }
+    auto cool() -> void
+    {
+        if (!warming)
+            return;
+        *warming = true;
+        warming.reset();
+        warmer.clear();
+    }
+    // rows are migrated later by writer
+    auto createTable() -> void
     {
         Transactor t(&db);
         finder.exec(u"DROP TABLE IF EXISTS %1"_q.arg(table));
@@ -118,17 +644,6 @@ struct HistoryModel::Data {
         }).join(u", "_q);
 
         finder.exec(u"CREATE TABLE %1 (%2)"_q.arg(table).arg(columns));
-        for (auto state : states) {
-            upsert(state);
-            delete state;
-        }
-    }
-    auto getMrl() const -> Mrl
-    {
-        const auto id = loader.value(idx_mrl).toString();
-        const auto dev = loader.value(idx_device).toString();
-        const auto name = loader.value(idx_name).toString();
-        return Mrl::fromUniqueId(id, dev, name);
     }
 };
 
@@ -152,6 +667,10 @@ HistoryModel::HistoryModel(QObject *parent)
     d->fields.prepareSelect(d->table, d->fields.field(u"mrl"_q));
     d->writes.prepareUpdate(d->table, d->fields.field(u"mrl"_q));
     setPropertiesToRestore(QStringList());
+    d->prefetcher.setSingleShot(true);
+    d->prefetcher.setInterval(0);
+    connect(&d->prefetcher, &QTimer::timeout, this, [=] () { d->prefetch(); });
+    d->warmer.setMaxThreadCount(1);
 
     d->db = QSqlDatabase::addDatabase(u"QSQLITE"_q, u"history-model"_q);
     d->db.setDatabaseName(_WritablePath(Location::Config) % "/history.db"_a);
@@ -163,15 +682,19 @@ HistoryModel::HistoryModel(QObject *parent)
 
     d->loader = QSqlQuery(d->db);
     d->finder = QSqlQuery(d->db);
+    d->queries.setDatabase(d->db);
 
     d->finder.exec(u"PRAGMA journal_mode = WAL"_q);
     d->finder.exec(u"PRAGMA user_version"_q);
     int version = 0;
     if (d->finder.next())
         version = d->finder.value(0).toLongLong();
+    int migrate = -1;
     if (version < currentVersion) {
-        d->import(_ImportMrlStates(version, d->db));
-        d->finder.exec("PRAGMA user_version = "_a % _N(currentVersion));
+        // version is updated by writer when all rows are moved
+        d->createTable();
+        migrate = version;
+        d->importing = true;
     } else {
         auto record = d->db.record(d->table);
         QVector<MrlStateSqlField> lacks;
@@ -185,17 +708,52 @@ HistoryModel::HistoryModel(QObject *parent)
                 const auto query = u"ALTER TABLE %3 ADD COLUMN %1 %2"_q
                         .arg(_L(field.property().name())).arg(field.type());
                 d->finder.exec(query.arg(d->table));
-                d->check(d->finder);
+                check(d->finder);
             }
         }
     }
+    if (!d->db.record(d->table).contains(u"snapshot"_q)) {
+        d->finder.exec("ALTER TABLE "_a % d->table % " ADD COLUMN snapshot BLOB"_a);
+        check(d->finder);
+    }
+    // covers listing, star has to be non-null to sort on index
+    d->finder.exec("CREATE INDEX IF NOT EXISTS "_a % d->table % "_order ON "_a
+                   % d->table % " (star, last_played_date_time, mrl, name, device)"_a);
+    check(d->finder);
+    d->finder.exec("UPDATE "_a % d->table % " SET star = 0 WHERE star IS NULL"_a);
     d->load();
+    d->writer.open(this, d->db.databaseName(), d->fields, d->writes, migrate);
 }
 
 HistoryModel::~HistoryModel() {
+    d->cool();
+    d->warmer.waitForDone();
+    d->writer.stop();
     delete d;
 }
 
+auto HistoryModel::customEvent(QEvent *event) -> void
+{
+    switch ((int)event->type()) {
+    case Reload: {
+        int inserted = 0;
+        _TakeData(event, inserted);
+        d->reset(qMax(0, d->rows + inserted));
+        break;
+    } case Progress: {
+        int done = 0, total = 0;
+        _TakeData(event, done, total);
+        const double progress = total > 0 ? done / (double)total : 1.0;
+        if (_Change(d->progress, progress))
+            emit importProgressChanged();
+        if (done >= total && _Change(d->importing, false))
+            emit importingChanged();
+        break;
+    } default:
+        break;
+    }
+}
+
 auto HistoryModel::rowCount(const QModelIndex &index) const -> int
 {
     return index.isValid() ? 0 : d->rows;
@@ -214,8 +772,12 @@ auto HistoryModel::getState(MrlState *state) const -> bool
     if (d->restores.isEmpty())
         return true;
     Q_ASSERT(d->restores.isSelectPrepared());
-    if (d->cached.mrl() != state->mrl())
-        return d->restores.select(d->finder, state);
+    if (d->cached.mrl() != state->mrl()) {
+        const int restored = d->restore(state);
+        const bool stored = restored > 0
+                || (!restored && d->restores.select(d->queries, state));
+        return d->writer.overlay(state, state->mrl(), d->restores) || stored;
+    }
     for (auto &f : d->restores)
         f.property().write(state, f.property().read(&d->cached));
     return true;
@@ -229,7 +791,9 @@ auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
     if (d->cached.mrl() == mrl)
         return &d->cached;
     Q_ASSERT(d->fields.isSelectPrepared());
-    if (!d->fields.select(d->finder, &d->cached, mrl))
+    const bool stored = d->fields.select(d->queries, &d->cached,
+                                         QVariant::fromValue(mrl));
+    if (!d->writer.overlay(&d->cached, mrl, d->fields) && !stored)
         return nullptr;
     d->cached.set_mrl(mrl);
     return &d->cached;
@@ -238,14 +802,34 @@ auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
 auto HistoryModel::play(int row) -> void
 {
     QMutexLocker locker(&d->mutex);
-    if (_InRange0(row, d->rows) && d->loader.seek(row))
-        emit playRequested(d->getMrl());
+    if (auto item = d->row(row))
+        emit playRequested(item->mrl());
 }
 
 auto HistoryModel::setShowMediaTitleInName(bool local, bool url) -> void
 {
     if (_Change(d->mediaTitleLocal, local) | _Change(d->mediaTitleUrl, url))
-        d->load();
+        d->reset(d->rows);
+}
+
+auto HistoryModel::setProbeCache(const MediaProbeCache *probes) -> void
+{
+    d->probes = probes;
+}
+
+auto HistoryModel::setRetention(int days, int count) -> void
+{
+    d->writer.setRetention(days, count);
+}
+
+auto HistoryModel::isImporting() const -> bool
+{
+    return d->importing;
+}
+
+auto HistoryModel::importProgress() const -> double
+{
+    return d->progress;
 }
 
 auto HistoryModel::getData(const int row, int role) const -> QVariant
@@ -254,37 +838,26 @@ auto HistoryModel::getData(const int row, int role) const -> QVariant
         d->load();
         d->reload = false;
     }
-    if (!(0 <= row && row < d->rows))
+    const auto item = d->row(row);
+    if (!item)
         return QVariant();
-    if (!d->loader.seek(row))
-        return QVariant();
-    if (d->rowCache.row != row) {
-        d->rowCache.row = row;
-        d->rowCache.mrl = Mrl();
-    }
-    auto fillMrl = [this] () -> const Mrl& {
-        if (d->rowCache.mrl.isEmpty())
-            d->rowCache.mrl = d->getMrl();
-        return d->rowCache.mrl;
-    };
     switch (role) {
-    case NameRole: {
-        fillMrl();
-        if ((d->rowCache.mrl.isLocalFile() && d->mediaTitleLocal)
-                || (d->rowCache.mrl.isRemoteUrl() && d->mediaTitleUrl)) {
-            const auto name = d->loader.value(d->idx_name).toString();
-            if (!name.isEmpty())
-                return name;
-        }
-        return d->rowCache.mrl.displayName();
-    } case LatestPlayRole: {
-        const auto msecs = d->loader.value(d->idx_last).toLongLong();
-        return QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODate);
-    } case LocationRole:
-        return fillMrl().toString();
+    case NameRole:
+        return d->record(item)[u"name"_q];
+    case LatestPlayRole:
+        return d->record(item)[u"latestplay"_q];
+    case LocationRole:
+        return d->record(item)[u"location"_q];
     case StarRole:
-        return d->loader.value(d->idx_star);
-    default:
+        return item->star;
+    case RecordRole:
+        return d->record(item);
+    case DurationRole: {
+        if (!d->probes)
+            return QVariant();
+        const auto probe = d->probes->find(item->mrl());
+        return probe.isValid() ? QVariant(probe.duration) : QVariant();
+    } default:
         return QVariant();
     }
 }
@@ -301,6 +874,8 @@ auto HistoryModel::roleNames() const -> QHash<int, QByteArray>
     hash[LatestPlayRole] = "latestplay"_b;
     hash[LocationRole] = "location"_b;
     hash[StarRole] = "star"_b;
+    hash[DurationRole] = "duration"_b;
+    hash[RecordRole] = "record"_b;
     return hash;
 }
 
@@ -317,25 +892,29 @@ auto HistoryModel::isStarred(int row) const -> bool
 auto HistoryModel::setStarred(int row, bool star) -> void
 {
     QMutexLocker locker(&d->mutex);
-    if (!d->loader.seek(row)) {
+    const auto item = d->row(row);
+    if (!item) {
         _Error("Cannot seek to %% row.", row);
         return;
     }
-    const auto mrl = d->getMrl();
+    const auto mrl = item->mrl();
     const auto f = d->fields.field(u"star"_q), m = d->fields.field(u"mrl"_q);
+    d->writer.flush();
     Transactor t(&d->db);
-    d->finder.prepare("UPDATE "_a % d->table % " SET star=? WHERE mrl=?"_a);
-    d->finder.bindValue(0, f.sqlData(QVariant::fromValue(star)));
-    d->finder.bindValue(1, m.sqlData(QVariant::fromValue(mrl)));
-    if (!d->finder.exec())
-        qDebug() << d->finder.executedQuery();
+    auto &query = d->queries.get("UPDATE "_a % d->table % " SET star=? WHERE mrl=?"_a);
+    query.bindValue(0, f.sqlData(QVariant::fromValue(star)));
+    query.bindValue(1, m.sqlData(QVariant::fromValue(mrl)));
+    if (!query.exec())
+        qDebug() << query.executedQuery();
     t.done();
     update();
 }
 
 auto HistoryModel::update() -> void
 {
-    d->load();
+    // reload after queued writes get visible
+    if (!d->writer.requestReload())
+        d->reset(d->rows);
 }
 
 auto HistoryModel::update(const MrlState *state, const QString &column, bool reload) -> void
@@ -349,12 +928,9 @@ auto HistoryModel::update(const MrlState *state, const QString &column, bool rel
     const auto f = d->fields.field(column), m = d->fields.field(u"mrl"_q);
     if (!f.isValid() || !m.isValid())
         return;
-    Transactor t(&d->db);
-    d->finder.prepare("UPDATE "_a % d->table % " SET "_a % column % "=? WHERE mrl=?"_a);
-    d->finder.bindValue(0, f.sqlData(f.property().read(state)));
-    d->finder.bindValue(1, m.sqlData(m.property().read(state)));
-    d->finder.exec();
-    t.done();
+    if (state->mrl() == d->cached.mrl())
+        d->cached.set_mrl(Mrl());
+    d->writer.push(state, column);
     if (reload)
         update();
 }
@@ -367,9 +943,9 @@ auto HistoryModel::update(const MrlState *state, bool reload) -> void
         return;
     if (!state->mrl().isUnique())
         return;
-    Transactor t(&d->db);
-    d->upsert(state);
-    t.done();
+    if (state->mrl() == d->cached.mrl())
+        d->cached.set_mrl(Mrl());
+    d->writer.push(state, QString());
     if (reload)
         update();
 }
@@ -379,6 +955,19 @@ auto HistoryModel::setRememberImage(bool on) -> void
     d->rememberImage = on;
 }
 
+auto HistoryModel::setLowMemory(bool on) -> void
+{
+    // KiB, negative cache_size is read as KiB instead of pages
+    static constexpr int Default = 2000, Low = 256;
+    if (!d->db.isOpen())
+        return;
+    QSqlQuery query(d->db);
+    query.exec("PRAGMA cache_size = -"_a % _N(on ? Low : Default));
+    if (on)
+        query.exec(u"PRAGMA shrink_memory"_q);
+    OS::ResourceMonitor::setSaving("history", on ? (Default - Low) / 1024.0 : 0.0);
+}
+
 auto HistoryModel::isRestorable(const char *name) const -> bool
 {
     QMutexLocker locker(&d->mutex);
@@ -404,15 +993,27 @@ auto HistoryModel::setPropertiesToRestore(const QStringList &list) -> void
     }
     d->restores.prepareSelect(d->table, d->fields.field(u"mrl"_q));
     d->restores.prepareInsert(d->table);
+    d->extras.clear();
+    QStringList columns(u"snapshot"_q);
+    for (auto &f : d->restores) {
+        if (!d->writes.field(_L(f.property().name())).isValid()) {
+            d->extras.push_back(f);
+            columns.push_back(_L(f.property().name()));
+        }
+    }
+    d->snapshotQuery = "SELECT "_a % columns.join(','_q) % " FROM "_a
+            % d->table % " WHERE mrl = ?"_a;
 }
 
 auto HistoryModel::clear() -> void
 {
     QMutexLocker locker(&d->mutex);
+    d->writer.flush();
     Transactor t(&d->db);
     d->loader.exec("DELETE FROM "_a % d->table % " WHERE star != 1 OR star IS NULL"_a);
+    const int removed = d->loader.numRowsAffected();
     t.done();
-    d->load();
+    d->reset(d->rows - qMax(0, removed));
 }
 
 auto HistoryModel::isVisible() const -> bool
@@ -422,6 +1023,12 @@ auto HistoryModel::isVisible() const -> bool
 
 auto HistoryModel::setVisible(bool visible) -> void
 {
-    if (_Change(d->visible, visible))
-        emit visibleChanged(d->visible);
+    if (!_Change(d->visible, visible))
+        return;
+    if (visible) {
+        QMutexLocker locker(&d->mutex);
+        d->warm();
+    } else
+        d->cool();
+    emit visibleChanged(d->visible);
 }
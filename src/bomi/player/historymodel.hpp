@@ -3,14 +3,17 @@
 
 #include "mrlstate.hpp"
 
-class QSqlError;
+class QSqlError;                        class MediaProbeCache;
 
 class HistoryModel: public QAbstractTableModel {
     Q_OBJECT
     Q_PROPERTY(bool visible READ isVisible WRITE setVisible NOTIFY visibleChanged)
     Q_PROPERTY(int length READ rowCount NOTIFY lengthChanged)
+    Q_PROPERTY(bool importing READ isImporting NOTIFY importingChanged)
+    Q_PROPERTY(double importProgress READ importProgress NOTIFY importProgressChanged)
 public:
-    enum Role {NameRole = Qt::UserRole + 1, LatestPlayRole, LocationRole, StarRole};
+    enum Role {NameRole = Qt::UserRole + 1, LatestPlayRole, LocationRole, StarRole,
+               DurationRole, RecordRole};
     HistoryModel(QObject *parent = nullptr);
     ~HistoryModel();
     auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int;
@@ -23,11 +26,19 @@ public:
     auto update(const MrlState *state, const QString &column, bool reload) -> void;
     auto update(const MrlState *state, bool reload) -> void;
     auto setShowMediaTitleInName(bool local, bool url) -> void;
+    auto setProbeCache(const MediaProbeCache *probes) -> void;
+    // unstarred rows older than days or beyond count are pruned, 0 for no limit
+    auto setRetention(int days, int count) -> void;
+    auto isImporting() const -> bool;
+    auto importProgress() const -> double;
     auto setRememberImage(bool on) -> void;
+    // caps page cache of reading connection
+    auto setLowMemory(bool on) -> void;
     auto setPropertiesToRestore(const QStringList &properties) -> void;
     auto isRestorable(const char *name) const -> bool;
     auto clear() -> void;
     auto isVisible() const -> bool;
+    // showing list warms up files of top entries around their resume position
     auto setVisible(bool visible) -> void;
     auto update() -> void;
     auto toggle() -> void { setVisible(!isVisible()); }
@@ -39,7 +50,10 @@ signals:
     void changeVisibilityRequested(bool visible);
     void visibleChanged(bool visible);
     void lengthChanged(int length);
+    void importingChanged();
+    void importProgressChanged();
 private:
+    auto customEvent(QEvent *event) -> void final;
     auto getData(int row, int role) const -> QVariant;
     struct Data;
     Data *d;
@@ -3,70 +3,141 @@
 #include "json/jrcommon.hpp"
 #include "misc/jsonstorage.hpp"
 
+// invokable method with converters resolved in advance
+struct JrMethod {
+    QMetaMethod method;
+    QVector<JsonToQVariant> converters;
+    QVector<QString> names;
+};
+
+// what a name means for objects of one class
+struct JrMember {
+    int property = -1;
+    QVector<JrMethod> methods; // overloads, in declaration order
+};
+
+using JrDispatchTable = QHash<QByteArray, JrMember>;
+
 struct JrPlayer::Data {
     AppObject app;
-    QMetaObject *mo = nullptr;
-    PlayEngine *engine;
-    PlaylistModel *playlist;
-    HistoryModel *history;
-    WindowObject *window;
+    QHash<const QMetaObject*, JrDispatchTable> tables;
+
+    // built once for each class on first request
+    auto table(const QMetaObject *mo) -> const JrDispatchTable&
+    {
+        auto it = tables.find(mo);
+        if (it != tables.end())
+            return *it;
+        JrDispatchTable table;
+        // later index belongs to subclass, which overrides
+        for (int i = 0; i < mo->propertyCount(); ++i)
+            table[mo->property(i).name()].property = i;
+        for (int i = 0; i < mo->methodCount(); ++i) {
+            JrMethod m;
+            m.method = mo->method(i);
+            m.converters.reserve(m.method.parameterCount());
+            for (int j = 0; j < m.method.parameterCount(); ++j)
+                m.converters.push_back(_JsonToQVariantConverter(m.method.parameterType(j)));
+            for (auto &name : m.method.parameterNames())
+                m.names.push_back(_L(name));
+            table[m.method.name()].methods.push_back(m);
+        }
+        return *tables.insert(mo, table);
+    }
 
-    using ParamArray = std::array<QVariant, 10>;
+    // walk objects in path and return the one which has the last name
+    // list is set if path ends with length of list instead
+    auto resolve(const QString &path, QByteArray *last,
+                 QQmlListReference *length) -> QObject*
+    {
+        QObject *object = &app;
+        int pos = path.startsWith("App."_a) ? 4 : 0;
+        while (pos < path.size()) {
+            const int next = path.indexOf('.'_q, pos);
+            if (next > pos) {
+                const auto name = path.midRef(pos, next - pos).toUtf8();
+                pos = next + 1;
+                const int left = name.indexOf('[');
+                if (left > 0) {
+                    QQmlListReference list(object, name.left(left));
+                    const int right = name.indexOf(']', left);
+                    if (!list.isValid() || right < 0)
+                        return nullptr;
+                    bool ok = false;
+                    const int idx = name.mid(left + 1, right - (left + 1)).toInt(&ok);
+                    const auto obj = list.at(idx);
+                    if (!ok || !obj)
+                        return nullptr;
+                    object = obj;
+                    continue;
+                }
+                const auto p = object->property(name);
+                if (auto obj = p.value<QObject*>()) {
+                    object = obj;
+                    continue;
+                }
+                QQmlListReference list(object, name);
+                if (!list.isValid() || path.midRef(pos) != "length"_a)
+                    return nullptr;
+                *length = list;
+                return object;
+            }
+            *last = path.midRef(pos).toUtf8();
+            return last->isEmpty() ? nullptr : object;
+        }
+        return nullptr;
+    }
 
-    auto invoke(QObject *object, const QMetaMethod &method, const QList<QVariant> &params) -> QJsonValue
+    SIA toJson(const QVariant &var) -> QJsonValue
     {
-        if (method.parameterCount() > 10)
-            return QJsonValue::Undefined; // cannot call with over 10 params
-        Q_ASSERT(method.parameterCount() == params.size());
+        if (auto obj = var.value<QObject*>())
+            return _JsonFromQObject(obj);
+        return _JsonFromQVariant(var);
+    }
 
-        std::array<QGenericArgument, 10> args;
-        for (int i = 0; i < method.parameterCount(); ++i)
-            args[i] = QGenericArgument(params[i].typeName(), params[i].constData());
+    // call through qt_metacall directly, arguments are converted already
+    auto invoke(QObject *object, const QMetaMethod &method,
+                QVector<QVariant> &params) -> QJsonValue
+    {
+        Q_ASSERT(method.parameterCount() == params.size());
         auto ret = _QVariantFromType(method.returnType());
-        QGenericReturnArgument rarg;
-        if (ret.userType() != QMetaType::Void)
-            rarg = QGenericReturnArgument(ret.typeName(), ret.data());
-        if (!method.invoke(object, rarg, args[0], args[1], args[2], args[3], args[4],
-                          args[5], args[6], args[7], args[8], args[9]))
-            return QJsonValue::Undefined;
+        QVector<void*> argv(params.size() + 1);
+        argv[0] = ret.userType() != QMetaType::Void ? ret.data() : nullptr;
+        for (int i = 0; i < params.size(); ++i)
+            argv[i + 1] = params[i].data();
+        if (QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod,
+                                  method.methodIndex(), argv.data()) >= 0)
+            return QJsonValue::Undefined; // not handled
         if (ret.userType() == QMetaType::Void)
             return QJsonValue::Null;
-        const auto qobject = ret.value<QObject*>();
-        if (qobject)
-            return _JsonFromQObject(qobject);
-        return _JsonFromQVariant(ret);
+        return toJson(ret);
     }
 
-    auto invoke(QObject *object, const QMetaMethod &method, const QJsonArray &array) -> QJsonValue
+    auto invoke(QObject *object, const JrMethod &m, const QJsonArray &array) -> QJsonValue
     {
-        if (method.parameterCount() != array.size())
+        if (m.converters.size() != array.size())
             return QJsonValue::Undefined;
-        QList<QVariant> params;
-        params.reserve(array.size());
-        for (int i = 0; i < method.parameterCount(); ++i) {
-            auto param = _JsonToQVariant(array.at(i), method.parameterType(i));
-            if (!param.isValid())
+        QVector<QVariant> params(array.size());
+        for (int i = 0; i < array.size(); ++i) {
+            params[i] = m.converters[i](array.at(i));
+            if (!params[i].isValid())
                 return QJsonValue::Undefined;
-            params.push_back(param);
         }
-        return invoke(object, method, params);
+        return invoke(object, m.method, params);
     }
 
-    auto invoke(QObject *object, const QMetaMethod &method, const QJsonObject &json) -> QJsonValue
+    auto invoke(QObject *object, const JrMethod &m, const QJsonObject &json) -> QJsonValue
     {
-        if (method.parameterCount() != json.size())
+        if (m.converters.size() != json.size())
             return QJsonValue::Undefined;
-        QList<QVariant> params;
-        params.reserve(json.size());
-        const auto names = method.parameterNames();
-        Q_ASSERT(names.size() == method.parameterCount());
-        for (int i = 0; i < method.parameterCount(); ++i) {
-            auto param = _JsonToQVariant(json[_L(names[i])], method.parameterType(i));
-            if (!param.isValid())
+        Q_ASSERT(m.names.size() == m.converters.size());
+        QVector<QVariant> params(json.size());
+        for (int i = 0; i < m.converters.size(); ++i) {
+            params[i] = m.converters[i](json[m.names[i]]);
+            if (!params[i].isValid())
                 return QJsonValue::Undefined;
-            params.push_back(params);
         }
-        return invoke(object, method, params);
+        return invoke(object, m.method, params);
     }
 };
 
@@ -83,51 +154,19 @@ JrPlayer::~JrPlayer()
 auto JrPlayer::request(const JrRequest &request) -> JrResponse
 {
     Q_ASSERT(request.isValid());
-    QObject *object = &d->app;
-    int pos = 0;
-    const auto jrMethod = request.method();
     const auto jrParams = request.params();
-    if (jrMethod.startsWith("App."_a))
-        pos = 4;
     auto error = [&] (JrError e) { return _JrErrorResponse(request.id(), e); };
-    while (pos < jrMethod.size()) {
-        const int next = jrMethod.indexOf('.'_q, pos);
-        if (next > pos) {
-            const auto name = jrMethod.midRef(pos, next - pos).toUtf8();
-            pos = next + 1;
-            const int left = name.indexOf('[');
-            if (left > 0) {
-                QQmlListReference list(object, name.left(left));
-                const int right = name.indexOf(']', left);
-                if (!list.isValid() || right < 0)
-                    break;
-                bool ok = false;
-                const int idx = name.mid(left + 1, right - (left + 1)).toInt(&ok);
-                const auto obj = list.at(idx);
-                if (!ok || !obj)
-                    break;
-                object = obj;
-                continue;
-            }
-            const auto p = object->property(name);
-            if (auto obj = p.value<QObject*>()) {
-                object = obj;
-                continue;
-            }
-            QQmlListReference list(object, name);
-            if (!list.isValid() || jrMethod.midRef(pos) != "length"_a)
-                break;
-            return { request, list.count() };
-        }
-        const auto name = jrMethod.midRef(pos).toUtf8();
-        pos = jrMethod.size();
-        if (name.isEmpty())
-            break;
-
-        const auto mo = object->metaObject();
-        const int idx = mo->indexOfProperty(name);
-        if (idx >= 0) {
-            const auto p = mo->property(idx);
+    QByteArray name; QQmlListReference length;
+    if (auto object = d->resolve(request.method(), &name, &length)) {
+        if (length.isValid())
+            return { request, length.count() };
+
+        const auto &table = d->table(object->metaObject());
+        const auto it = table.find(name);
+        if (it == table.end())
+            return error(JrError::MethodNotFound);
+        if (it->property >= 0) {
+            const auto p = object->metaObject()->property(it->property);
             if (!jrParams.isUndefined()) {
                 QJsonValue value(QJsonValue::Undefined);
                 if (jrParams.isArray()) {
@@ -149,22 +188,20 @@ auto JrPlayer::request(const JrRequest &request) -> JrResponse
                 if (!p.write(object, var))
                     return error(JrError::MethodNotFound);
             }
-            const auto res = _JsonFromQVariant(p.read(object));
+            const auto res = d->toJson(p.read(object));
             if (!res.isUndefined())
                 return { request, res };
             return _JrErrorResponse(request.id(), JrError::InternalError);
         }
 
-        for (int i = 0; i < mo->methodCount(); ++i) {
-            if (mo->method(i).name() != name)
-                continue;
+        for (auto &method : it->methods) {
             QJsonValue res(QJsonValue::Undefined);
             if (jrParams.isArray())
-                res = d->invoke(object, mo->method(i), jrParams.toArray());
+                res = d->invoke(object, method, jrParams.toArray());
             else if (jrParams.isObject())
-                res = d->invoke(object, mo->method(i), jrParams.toObject());
+                res = d->invoke(object, method, jrParams.toObject());
             else if (jrParams.isUndefined())
-                res = d->invoke(object, mo->method(i), QJsonArray());
+                res = d->invoke(object, method, QJsonArray());
             if (!res.isUndefined())
                 return { request, res };
         }
@@ -172,3 +209,43 @@ auto JrPlayer::request(const JrRequest &request) -> JrResponse
     }
     return _JrErrorResponse(request.id(), JrError::MethodNotFound);
 }
+
+auto JrPlayer::watch(const QString &path, Notify &&notify, QObject *parent) -> QObject*
+{
+    QByteArray name; QQmlListReference length;
+    const auto object = d->resolve(path, &name, &length);
+    if (!object || length.isValid())
+        return nullptr;
+    const auto &table = d->table(object->metaObject());
+    const auto it = table.find(name);
+    if (it == table.end())
+        return nullptr;
+    QMetaMethod signal;
+    std::function<void()> func;
+    if (it->property >= 0) {
+        const auto p = object->metaObject()->property(it->property);
+        if (!p.hasNotifySignal())
+            return nullptr;
+        signal = p.notifySignal();
+        // send current value first
+        func = [notify, p, object] () { notify(Data::toJson(p.read(object))); };
+        func();
+    } else {
+        for (auto &m : it->methods) {
+            if (m.method.methodType() == QMetaMethod::Signal) {
+                signal = m.method;
+                break;
+            }
+        }
+        if (!signal.isValid())
+            return nullptr;
+        // arguments of signal are not delivered, only emission
+        func = [notify] () { notify(QJsonValue::Null); };
+    }
+    auto watcher = new JrWatcher(std::move(func), parent);
+    if (!QObject::connect(object, signal, watcher, JrWatcher::triggerSlot())) {
+        delete watcher;
+        return nullptr;
+    }
+    return watcher;
+}
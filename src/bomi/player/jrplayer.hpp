@@ -9,6 +9,7 @@ public:
     ~JrPlayer();
 private:
     auto request(const JrRequest &request) -> JrResponse final;
+    auto watch(const QString &path, Notify &&notify, QObject *parent) -> QObject* final;
     struct Data;
     Data *d;
 };
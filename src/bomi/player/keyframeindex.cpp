@@ -0,0 +1,86 @@
+#include "keyframeindex.hpp"
+#include "mpv_property.hpp"
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+struct KeyframeDemuxer {
+    AVFormatContext *format = nullptr;
+    AVStream *stream = nullptr;
+    ~KeyframeDemuxer() { avformat_close_input(&format); }
+    auto open(const QByteArray &path) -> bool
+    {
+        if (avformat_open_input(&format, path.constData(), nullptr, nullptr) < 0)
+            return false;
+        if (avformat_find_stream_info(format, nullptr) < 0)
+            return false;
+        const int idx = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (idx < 0)
+            return false;
+        for (uint i = 0; i < format->nb_streams; ++i) {
+            if ((int)i != idx)
+                format->streams[i]->discard = AVDISCARD_ALL;
+        }
+        stream = format->streams[idx];
+        return true;
+    }
+    auto toMSecs(qint64 ts) const -> qint32
+        { return qRound(ts * av_q2d(stream->time_base) * 1000.0); }
+};
+
+auto KeyframeIndex::nearest(int ms) const -> int
+{
+    if (m_times.isEmpty())
+        return -1;
+    auto it = std::lower_bound(m_times.begin(), m_times.end(), ms);
+    if (it == m_times.end())
+        return m_times.last();
+    if (it != m_times.begin() && ms - *(it - 1) < *it - ms)
+        --it;
+    return *it;
+}
+
+auto KeyframeIndex::toByteArray() const -> QByteArray
+{
+    return QByteArray((const char*)m_times.constData(), m_times.size() * sizeof(qint32));
+}
+
+auto KeyframeIndex::fromByteArray(const QByteArray &data) -> KeyframeIndex
+{
+    KeyframeIndex index;
+    index.m_times.resize(data.size() / sizeof(qint32));
+    memcpy(index.m_times.data(), data.constData(), index.m_times.size() * sizeof(qint32));
+    return index;
+}
+
+auto KeyframeIndex::build(const QString &file,
+                          const std::atomic<bool> &cancel) -> KeyframeIndex
+{
+    KeyframeIndex index;
+    KeyframeDemuxer demuxer;
+    if (file.isEmpty() || !demuxer.open(MpvFile(file).toMpv()))
+        return index;
+    auto &times = index.m_times;
+    // mp4 and alike has whole index after opening
+    const auto st = demuxer.stream;
+    for (int i = 0; i < st->nb_index_entries; ++i) {
+        if (st->index_entries[i].flags & AVINDEX_KEYFRAME)
+            times.push_back(demuxer.toMSecs(st->index_entries[i].timestamp));
+    }
+    if (times.size() < 2) {
+        times.clear();
+        AVPacket packet;
+        while (!cancel && av_read_frame(demuxer.format, &packet) >= 0) {
+            const auto ts = packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+            if (packet.stream_index == st->index && (packet.flags & AV_PKT_FLAG_KEY)
+                    && ts != AV_NOPTS_VALUE)
+                times.push_back(demuxer.toMSecs(ts));
+            av_free_packet(&packet);
+        }
+        if (cancel)
+            return KeyframeIndex();
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    return index;
+}
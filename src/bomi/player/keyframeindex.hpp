@@ -0,0 +1,20 @@
+#ifndef KEYFRAMEINDEX_HPP
+#define KEYFRAMEINDEX_HPP
+
+// sorted presentation times of video keyframes in ms, in mpv timestamps
+class KeyframeIndex {
+public:
+    auto isEmpty() const -> bool { return m_times.isEmpty(); }
+    auto size() const -> int { return m_times.size(); }
+    // closest keyframe to ms or -1 if empty
+    auto nearest(int ms) const -> int;
+    auto toByteArray() const -> QByteArray;
+    static auto fromByteArray(const QByteArray &data) -> KeyframeIndex;
+    // read container index or demux whole file without decoding
+    static auto build(const QString &file,
+                      const std::atomic<bool> &cancel) -> KeyframeIndex;
+private:
+    QVector<qint32> m_times;
+};
+
+#endif // KEYFRAMEINDEX_HPP
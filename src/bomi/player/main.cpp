@@ -2,6 +2,8 @@
 #include "dialog/mbox.hpp"
 #include "json/jrserver.hpp"
 #include "player/jrplayer.hpp"
+#include "player/headlesswindow.hpp"
+#include "misc/startuptrace.hpp"
 #include <QCryptographicHash>
 #include <QElapsedTimer>
 #ifdef Q_OS_LINUX
@@ -25,12 +27,18 @@ SIA measure(F func, int loop = 100000) -> quint64
 }
 
 int main(int argc, char **argv) {
+    StartupTrace::start();
 #ifdef BOMI_IMPORT_ICU
     Locale::importIcu();
     return 0;
 #endif
 #ifdef Q_OS_LINUX
     signal(SIGPIPE, SIG_IGN);
+#endif
+    // double-clicked files reach running instance without cold start
+    if (App::handOff(argc, argv))
+        return 0;
+#ifdef Q_OS_LINUX
     auto gtk_disable_setlocale
             = (void(*)(void))QLibrary::resolve(u"gtk-x11-2.0"_q,
                                                0, "gtk_disable_setlocale");
@@ -46,6 +54,7 @@ int main(int argc, char **argv) {
     registerType();
 
     QScopedPointer<App> app(new App(argc, argv));
+    StartupTrace::mark("application");
 
 #ifdef Q_OS_WIN
     const char sep = ';';
@@ -75,10 +84,27 @@ int main(int argc, char **argv) {
         return app->exec();
     }
     qsrand(QDateTime::currentMSecsSinceEpoch());
+    StartupTrace::mark("opengl check");
+
+    if (app->isHeadless()) {
+        auto hw = new HeadlessWindow;
+        _Debug("Show HeadlessWindow.");
+        hw->showFullScreen();
+        StartupTrace::mark("show headless window");
+        app->setHeadlessWindow(hw);
+        app->runCommands();
+        auto ret = app->exec();
+        delete hw;
+        app->sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        app.reset();
+        std::_Exit(ret);
+        return ret;
+    }
 
     MainWindow *mw = new MainWindow;
     _Debug("Show MainWindow.");
     mw->show();
+    StartupTrace::mark("show main window");
     app->setMainWindow(mw);
     _Debug("Start main event loop.");
 
@@ -6,12 +6,14 @@
 #include "mainwindow.hpp"
 #include "player/playlistmodel.hpp"
 #include "player/historymodel.hpp"
+#include "player/medialibrary.hpp"
 #include "player/avinfoobject.hpp"
 #include "player/playengine.hpp"
 #include "pref/pref.hpp"
 #include "audio/audioformat.hpp"
 #include "video/interpolatorparams.hpp"
 #include "video/videopreview.hpp"
+#include "video/streamitem.hpp"
 #include "video/videorenderer.hpp"
 #include "misc/downloader.hpp"
 #include "quick/algorithmobject.hpp"
@@ -26,7 +28,10 @@
 #include "quick/busyiconitem.hpp"
 #include "quick/buttonboxitem.hpp"
 #include "quick/triangleitem.hpp"
+#include "quick/infosubscriber.hpp"
+#include "quick/bluritem.hpp"
 #include "audio/visualizer.hpp"
+#include "audio/barvisualizeritem.hpp"
 #include <QImageWriter>
 
 template<class T>
@@ -45,14 +50,21 @@ auto registerType() -> void
     qmlRegisterType<EditionChapterObject>("bomi", 1, 0, "Chapter");
     qmlRegisterType<EditionChapterObject>("bomi", 1, 0, "Edition");
     qmlRegisterType<TriangleItem>("bomi", 1, 0, "Triangle");
+    qmlRegisterType<InfoSubscriber>("bomi", 1, 0, "InfoSubscriber");
+    qmlRegisterType<BlurItem>("bomi", 1, 0, "Blur");
     qmlRegisterType<AudioVisualizer>("bomi", 1, 0, "Visualizer");
+    qmlRegisterType<BarVisualizerItem>("bomi", 1, 0, "VisualizerBars");
+    qmlRegisterType<StreamItem>("bomi", 1, 0, "Stream");
     qmlRegisterType<TopLevelItem>();
     qmlRegisterType<Downloader>();
     qmlRegisterType<HistoryModel>();
+    qmlRegisterType<MediaLibrary>();
     qmlRegisterType<VideoObject>();
     qmlRegisterType<AvTrackObject>();
     qmlRegisterType<VideoFormatObject>();
     qmlRegisterType<VideoToolObject>();
+    qmlRegisterType<RenderTimingObject>();
+    qmlRegisterType<RenderPassTimingObject>();
     qmlRegisterType<AudioFormatObject>();
     qmlRegisterType<AudioObject>();
     qmlRegisterType<CodecObject>();
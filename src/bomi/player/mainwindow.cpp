@@ -4,6 +4,11 @@
 #include "dialog/mbox.hpp"
 #include "dialog/encoderdialog.hpp"
 #include "quick/appobject.hpp"
+#include "quick/svgimageprovider.hpp"
+#include "misc/startuptrace.hpp"
+#include "opengl/openglshadercache.hpp"
+#include "opengl/openglmisc.hpp"
+#include "os/resourcemonitor.hpp"
 #include <QSessionManager>
 
 //DECLARE_LOG_CONTEXT(Main)
@@ -28,35 +33,49 @@ MainWindow::MainWindow()
 
     d->pref.initialize();
     d->pref.load();
+    d->undo.setUndoLimit(UndoLimit);
     d->undo.setActive(false);
-    d->logViewer = d->dialog<LogViewer>();
     d->adapter = OS::adapter(this);
+    StartupTrace::mark("preferences");
 
     AppObject::setTopLevelItem(d->top);
     AppObject::setQmlEngine(QQuickView::engine());
+    QQuickView::engine()->addImageProvider(u"svg"_q, new SvgImageProvider);
     AppObject::setEngine(&d->e);
     AppObject::setHistory(&d->history);
+    AppObject::setLibrary(&d->library);
     AppObject::setPlaylist(&d->playlist);
     AppObject::setDownloader(&d->downloader);
     AppObject::setTheme(&d->theme);
     AppObject::setWindow(this);
 
     d->playlist.setDownloader(&d->downloader);
+    d->playlist.setProbeCache(&d->probes);
+    d->history.setProbeCache(&d->probes);
     d->e.setHistory(&d->history);
+    d->e.setProbeCache(&d->probes);
     d->e.setYouTube(&d->youtube);
     d->e.setYle(&d->yle);
     d->e.run();
+    StartupTrace::mark("engine");
 
     d->initContextMenu();
     d->initItems();
     d->initTray();
     d->plugEngine();
     d->plugMenu();
+    StartupTrace::mark("menu");
+    if (StartupTrace::isEnabled())
+        connect(&d->e, &PlayEngine::started, this,
+                [] () { StartupTrace::finish("first file started"); });
 
     connect(this, &QQuickView::statusChanged, this, [=] (Status status)
         { if (status == Ready) d->top->setParentItem(contentItem()); });
     connect(d->adapter, &OS::WindowAdapter::stateChanged, this,
             [=] (Qt::WindowState ws) { d->updateWindowState(ws); });
+    connect(d->adapter, &OS::WindowAdapter::refreshRateChanged,
+            &d->e, &PlayEngine::setRefreshRate);
+    d->e.setRefreshRate(d->adapter->refreshRate());
     connect(this, &QQuickView::sceneGraphInitialized, this, [this] () {
         auto context = openglContext();
         if (cApp.isOpenGLDebugLoggerRequested())
@@ -66,6 +85,23 @@ MainWindow::MainWindow()
         emit sceneGraphInitialized();
         _Debug("Scene graph initialized.");
     }, Qt::DirectConnection);
+    connect(this, &MainWindow::sceneGraphInitialized, this, [this] () {
+        auto context = openglContext();
+        if (!m_sgInit || !d->gpu.start(context->format(), context))
+            return;
+        // programs recorded in earlier runs are relinked if driver has changed
+        OpenGLShaderCache::warmUp(&d->gpu);
+    }, Qt::QueuedConnection);
+    // video memory is queried from gpu worker whose context shares scene graph
+    connect(OS::ResourceMonitor::get(), &OS::ResourceMonitor::sampled, this, [this] () {
+        if (!d->gpu.isRunning() || d->gpu.pending())
+            return;
+        d->gpu.post([] (QOpenGLContext*) {
+            double free = -1, total = -1;
+            if (OGL::gpuMemory(&free, &total))
+                OS::ResourceMonitor::setGpuMemory(free, total);
+        });
+    });
     connect(this, &QQuickView::sceneGraphInvalidated, this, [this] () {
         auto context = QOpenGLContext::currentContext();
         m_sgInit = false;
@@ -83,6 +119,7 @@ MainWindow::MainWindow()
 
     d->restoreState();
     d->undo.setActive(true);
+    StartupTrace::mark("restore state");
     QTimer::singleShot(1, this, SLOT(postInitialize()));
 
 #ifdef Q_OS_WIN
@@ -93,6 +130,7 @@ MainWindow::MainWindow()
 
 MainWindow::~MainWindow() {
     cApp.setMprisActivated(false);
+    d->gpu.stop();
     if (d->jrServer)
         d->jrServer->setInterface(nullptr);
     delete d->jrServer;
@@ -114,6 +152,7 @@ auto MainWindow::postInitialize() -> void
     d->applyPref();
     cApp.runCommands();
     d->noMessage = false;
+    StartupTrace::mark("post initialization");
 }
 
 auto MainWindow::adapter() const -> OS::WindowAdapter*
@@ -301,7 +340,7 @@ auto MainWindow::mouseDoubleClickEvent(QMouseEvent *event) -> void
         return;
     d->singleClick.unset();
     if (event->buttons() & Qt::LeftButton) {
-        const auto act = d->menu.action(d->actionId(MsBh::DoubleClick, event));
+        const auto act = d->mouseAction(MsBh::DoubleClick, event);
         if (!act)
             return;
 #ifdef Q_OS_MAC
@@ -340,7 +379,7 @@ auto MainWindow::mouseReleaseEvent(QMouseEvent *event) -> void
             d->singleClick.timer.start(qApp->doubleClickInterval() + 10);
         }
     } else
-        d->trigger(d->menu.action(d->actionId(mb, event)));
+        d->trigger(d->mouseAction(mb, event));
 }
 
 
@@ -385,7 +424,7 @@ auto MainWindow::mousePressEvent(QMouseEvent *event) -> void
     }
 
     if (d->pressedButton == Qt::LeftButton)
-        d->singleClick.action = d->menu.action(d->actionId(MsBh::LeftClick, event));
+        d->singleClick.action = d->mouseAction(MsBh::LeftClick, event);
 }
 
 auto MainWindow::wheelEvent(QWheelEvent *event) -> void
@@ -397,8 +436,7 @@ auto MainWindow::wheelEvent(QWheelEvent *event) -> void
         const int delta = d->wheelAngles >= 120 ? 1 : d->wheelAngles <= -120 ? -1 : 0;
         if (delta) {
             const bool up = d->pref.invert_wheel() ? delta < 0 : delta > 0;
-            const auto id = d->actionId(up ? MsBh::ScrollUp : MsBh::ScrollDown, event);
-            d->trigger(d->menu.action(id));
+            d->trigger(d->mouseAction(up ? MsBh::ScrollUp : MsBh::ScrollDown, event));
             event->accept();
         }
     }
@@ -424,8 +462,7 @@ auto MainWindow::keyPressEvent(QKeyEvent *event) -> void
     if (event->isAccepted())
         return;
     constexpr int modMask = Qt::SHIFT | Qt::CTRL | Qt::ALT | Qt::META;
-    const QKeySequence shortcut(event->key() + (event->modifiers() & modMask));
-    d->trigger(RootMenu::instance().action(shortcut));
+    d->trigger(d->menu.action(event->key() + int(event->modifiers() & modMask)));
     event->accept();
 }
 
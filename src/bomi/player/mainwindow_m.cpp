@@ -21,16 +21,30 @@
 #include "video/interpolatorparams.hpp"
 #include "audio/visualizer.hpp"
 #include "misc/filenamegenerator.hpp"
+#include "misc/tracer.hpp"
 #include <QThreadPool>
 #include <QClipboard>
+#include <QDateTime>
+
+auto MainWindow::Data::mergeId(const void *key) -> int
+{
+    if (!key)
+        return -1;
+    auto it = mergeIds.find(key);
+    if (it == mergeIds.end())
+        it = mergeIds.insert(key, mergeIds.size());
+    return *it;
+}
 
 template<class T, class Func>
-auto MainWindow::Data::push(const T &to, const T &from, const Func &func) -> QUndoCommand*
+auto MainWindow::Data::push(const T &to, const T &from, const Func &func,
+                            const void *merge) -> QUndoCommand*
 {
     if (undo.isActive()) {
-        auto cmd = new ValueCmd<Func, T>(to, from, func);
+        // merged command is deleted by push()
+        auto cmd = new ValueCmd<Func, T>(to, from, func, mergeId(merge));
         undo.push(cmd);
-        return cmd;
+        return undo.command(undo.index() - 1) == cmd ? cmd : nullptr;
     } else {
         func(to);
         return nullptr;
@@ -38,17 +52,19 @@ auto MainWindow::Data::push(const T &to, const T &from, const Func &func) -> QUn
 }
 
 template<class T, class S>
-auto MainWindow::Data::push(const T &to, const T &old, void(PlayEngine::*set)(S)) -> QUndoCommand*
+auto MainWindow::Data::push(const T &to, const T &old, void(PlayEngine::*set)(S),
+                            const void *merge) -> QUndoCommand*
 {
     if (to == old)
         return nullptr;
-    return push(to, old, [=] (const T &s) { (e.*set)(s); });
+    return push(to, old, [=] (const T &s) { (e.*set)(s); }, merge);
 }
 
 template<class T, class S>
-auto MainWindow::Data::push(const T &to, T(MrlState::*get)() const, void(PlayEngine::*set)(S)) -> QUndoCommand*
+auto MainWindow::Data::push(const T &to, T(MrlState::*get)() const, void(PlayEngine::*set)(S),
+                            const void *merge) -> QUndoCommand*
 {
-    return push(to, (e.params()->*get)(), set);
+    return push(to, (e.params()->*get)(), set, merge);
 }
 
 auto MainWindow::Data::plugFlag(QAction *action, bool(MrlState::*get)() const,
@@ -73,7 +89,7 @@ auto MainWindow::Data::plugStep(ActionGroup *g, PLUG_MEMFUNC(T)) -> void
             value = (e.default_()->*get)();
         else
             value = step.changed((e.params()->*get)(), action->enum_());
-        push(value, get, set);
+        push(value, get, set, g);
     });
     propertyMessage(desc, sig, [=, &step] (T val) { return step.text(val); });
 }
@@ -244,7 +260,8 @@ auto MainWindow::Data::plugMenu() -> void
                     ab.setB(-1);
                     msg(tr("Range is too short!"));
                 } else {
-                    ab.start();
+                    if (ab.start())
+                        e.setABLoop(ab.a(), ab.b());
                     msg(tr("Set B to %1. Start to repeat!").arg(time(at)));
                 }
             }
@@ -252,13 +269,15 @@ auto MainWindow::Data::plugMenu() -> void
         } case 's': {
             ab.setA(e.captionBeginTime());
             ab.setB(e.captionEndTime());
-            ab.start();
+            if (ab.start())
+                e.setABLoop(ab.a(), ab.b());
             msg(tr("Repeat current subtitle"));
             break;
         } case 'q':
             ab.stop();
             ab.setA(-1);
             ab.setB(-1);
+            e.setABLoop(-1, -1);
             msg(tr("Quit repeating"));
         }
     });
@@ -343,11 +362,12 @@ auto MainWindow::Data::plugMenu() -> void
         auto action = static_cast<StepAction*>(a);
         push(action->value().changed(r, action->enum_()),
              e.params()->video_aspect_ratio(),
-             [=] (double v) { e.setVideoAspectRatio(v); });
+             [=] (double v) { e.setVideoAspectRatio(v); }, g);
     });
 
     ratio = &video(u"crop"_q);
     PLUG_RATIO(video_crop_ratio, setVideoCropRatio);
+    PLUG_FLAG(video(u"crop"_q)[u"auto"_q], video_crop_auto, setVideoAutoCrop);
     PLUG_ENUM_CHILD(video, video_rotation, setVideoRotation);
 
     auto &snap = video(u"snapshot"_q);
@@ -359,80 +379,15 @@ auto MainWindow::Data::plugMenu() -> void
     connectSnapshot(u"quick-nosub"_q, QuickSnapshotNoSub);
     connectSnapshot(u"tool"_q, SnapshotTool);
     connect(&e, &PlayEngine::snapshotTaken, p, [this] () {
-        QImage frameOnly, withOsd;
-        ph.position = _MSecToTime(e.snapshot(&frameOnly, &withOsd));
-        e.clearSnapshots();
-        if (frameOnly.isNull())
-            return;
-        if (snapshotMode == QuickSnapshot || snapshotMode == SnapshotTool) {
-            QRectF subRect;
-            QImage osd; osd.swap(withOsd);
-            withOsd = frameOnly;
-            QPainter painter(&withOsd);
-            painter.drawImage(osd.rect(), osd);
-            auto sub = e.subtitleImage(withOsd.rect(), &subRect);
-            if (!sub.isNull())
-                painter.drawImage(subRect, sub);
-        }
-        switch (snapshotMode) {
-        case SnapshotTool: {
-            if (!snapshot) {
-                snapshot = dialog<SnapshotDialog>();
-                snapshot->setTakeFunc([=] () {
-                    if (e.hasVideoFrame()) {
-                        snapshotMode = SnapshotTool;
-                        e.takeSnapshot();
-                    } else
-                        snapshot->clear();
-                });
-            }
-            if (!frameOnly.isNull())
-                snapshot->setImage(frameOnly, withOsd);
-            else
-                snapshot->clear();
-            break;
-        } case QuickSnapshot: case QuickSnapshotNoSub: {
-            auto image = frameOnly;
-            if (snapshotMode == QuickSnapshot)
-                image = withOsd;
-
-            QString folder; bool ask = false;
-            switch (pref.quick_snapshot_save()) {
-            case QuickSnapshotSave::Current:
-                if (e.mrl().isLocalFile()) {
-                    folder = _ToAbsPath(e.mrl().toLocalFile());
-                    break;
-                }
-            case QuickSnapshotSave::Ask:
-                folder = _LastOpenPath();
-                ask = true;
-                break;
-            case QuickSnapshotSave::Fixed:
-                folder = pref.quick_snapshot_folder();
-                break;
-            default:
+        // burst snapshots can arrive at once
+        forever {
+            QImage frameOnly, osd;
+            const int time = e.snapshot(&frameOnly, &osd);
+            if (time < 0)
                 return;
-            }
-            if (folder.isEmpty())
-                return;
-            const auto g = fileNameGenerator();
-            auto file = g.get(folder, pref.quick_snapshot_template(), pref.quick_snapshot_format());
-            if (ask)
-                file = _GetSaveFile(nullptr, tr("Save Snapshot"), file, WritableImageExt);
-            if (file.isEmpty())
-                return;
-            const int quality = pref.quick_snapshot_quality();
-            const auto saver = new SnapshotSaver(image, file, quality);
-            if (saver->isWritable()) {
-                QThreadPool::globalInstance()->start(saver);
-                showMessage(u"Save Snapshot"_q, file);
-            } else {
-                delete saver;
-                MBox::error(nullptr, tr("Error"), tr("Failed to create next file:\n%1").arg(file), {BBox::Ok});
-            }
-            break;
-        } default:
-            break;
+            ph.position = _MSecToTime(time);
+            if (!frameOnly.isNull())
+                saveSnapshot(frameOnly, osd);
         }
     }, Qt::QueuedConnection);
     connect(video(u"clip"_q).g(), &ActionGroup::triggered, p, [=] (QAction *act) {
@@ -505,7 +460,7 @@ auto MainWindow::Data::plugMenu() -> void
         const auto action = static_cast<StepAction*>(a); \
         QPointF offset = e.params()->video_offset(); \
         offset.r##coord() = action->value().changed(offset.coord(), action->enum_()); \
-        push(offset, &MrlState::video_offset, &PlayEngine::setVideoOffset); })
+        push(offset, &MrlState::video_offset, &PlayEngine::setVideoOffset, move.g(grp)); })
     PLUG_XY(u"horizontal"_q, x); PLUG_XY(u"vertical"_q, y);
     PROP_NOTIFY(video_offset, [=] (const QPointF &offset) {
         const auto &step = pref.steps().video_offset_pct;
@@ -619,7 +574,7 @@ auto MainWindow::Data::plugMenu() -> void
             const int diff = static_cast<StepAction*>(a)->data();
             auto color = e.params()->video_color();
             color.add(type, diff);
-            push(color, &MrlState::video_color, &PlayEngine::setVideoEqualizer);
+            push(color, &MrlState::video_color, &PlayEngine::setVideoEqualizer, vcolor.g(name));
         });
     });
     connect(vcolor[u"reset"_q], &QAction::triggered, p, [=] ()
@@ -828,7 +783,54 @@ auto MainWindow::Data::plugMenu() -> void
         };
         toggleTool("playinfo", as.playinfo_visible);
     });
-    connect(tool[u"log"_q], &QAction::triggered, logViewer.data(), &LogViewer::show);
+    connect(tool[u"log"_q], &QAction::triggered, p, [this] () {
+        if (!logViewer)
+            logViewer = dialog<LogViewer>();
+        logViewer->show();
+    });
+    // also reachable from json-rpc through App.execute("tool/trace")
+    connect(tool[u"trace"_q], &QAction::toggled, p, [this] (bool on) {
+        if (on) {
+            Tracer::start();
+            showMessage(tr("Record Trace"), true);
+            return;
+        }
+        Tracer::stop();
+        const auto file = _WritablePath(Location::Documents) % "/bomi-trace-"_a
+                % QDateTime::currentDateTime().toString(u"yyyyMMdd-hhmmss"_q) % ".json"_a;
+        if (Tracer::save(file))
+            showMessage(tr("Record Trace"), file);
+        else
+            showMessage(tr("Record Trace"), tr("Failed"));
+    });
+    connect(tool[u"contact-sheet"_q], &QAction::triggered, p, [this] () {
+        const auto title = tr("Export Thumbnail Sheets");
+        if (sheets && sheets->isRunning()) {
+            sheets->stop();
+            showMessage(title, tr("Canceled"));
+            return;
+        }
+        const auto files = _GetOpenFiles(nullptr, title, VideoExt);
+        if (files.isEmpty())
+            return;
+        const auto folder = _GetOpenDir(nullptr, tr("Save Thumbnail Sheets In"));
+        if (folder.isEmpty())
+            return;
+        if (!sheets) {
+            sheets.reset(new ContactSheetExporter);
+            connect(sheets.data(), &ContactSheetExporter::progressed, p,
+                    [=] (int done, int total) {
+                showMessage(title, QString::number(done) % '/'_q % QString::number(total));
+            });
+            connect(sheets.data(), &ContactSheetExporter::finished, p,
+                    [=] (int saved, int failed) {
+                showMessage(title, failed ? tr("%1 saved, %2 failed").arg(saved).arg(failed)
+                                          : tr("%1 saved").arg(saved));
+            });
+        }
+        sheets->start(files, folder);
+        showMessage(title, QString::number(0) % '/'_q % QString::number(files.size()));
+    });
     connect(tool[u"subtitle"_q], &QAction::triggered, p, [this] () {
         if (!sview) {
             sview = dialog<SubtitleViewer>();
@@ -976,3 +978,66 @@ auto MainWindow::Data::deleteDialogs() -> void
     encoder.clear();
 }
 
+
+auto MainWindow::Data::saveSnapshot(const QImage &frameOnly, const QImage &osd) -> void
+{
+    QImage sub; QRectF subRect;
+    if (snapshotMode == QuickSnapshot || snapshotMode == SnapshotTool)
+        sub = e.subtitleImage(frameOnly.rect(), &subRect);
+    switch (snapshotMode) {
+    case SnapshotTool: {
+        if (!snapshot) {
+            snapshot = dialog<SnapshotDialog>();
+            snapshot->setTakeFunc([=] () {
+                if (e.hasVideoFrame()) {
+                    snapshotMode = SnapshotTool;
+                    e.takeSnapshot();
+                } else
+                    snapshot->clear();
+            });
+        }
+        snapshot->setImage(frameOnly, SnapshotSaver::compose(frameOnly, osd, sub, subRect));
+        break;
+    } case QuickSnapshot: case QuickSnapshotNoSub: {
+        QString folder; bool ask = false;
+        switch (pref.quick_snapshot_save()) {
+        case QuickSnapshotSave::Current:
+            if (e.mrl().isLocalFile()) {
+                folder = _ToAbsPath(e.mrl().toLocalFile());
+                break;
+            }
+        case QuickSnapshotSave::Ask:
+            folder = _LastOpenPath();
+            ask = true;
+            break;
+        case QuickSnapshotSave::Fixed:
+            folder = pref.quick_snapshot_folder();
+            break;
+        default:
+            return;
+        }
+        if (folder.isEmpty())
+            return;
+        const auto g = fileNameGenerator();
+        auto file = g.get(folder, pref.quick_snapshot_template(), pref.quick_snapshot_format());
+        if (ask)
+            file = _GetSaveFile(nullptr, tr("Save Snapshot"), file, WritableImageExt);
+        if (file.isEmpty())
+            return;
+        const int quality = pref.quick_snapshot_quality();
+        // composing and encoding are done in worker thread
+        const auto saver = snapshotMode == QuickSnapshot
+                ? new SnapshotSaver(frameOnly, osd, sub, subRect, file, quality)
+                : new SnapshotSaver(frameOnly, file, quality);
+        if (saver->isWritable()) {
+            QThreadPool::globalInstance()->start(saver);
+            showMessage(u"Save Snapshot"_q, file);
+        } else {
+            delete saver;
+            MBox::error(nullptr, tr("Error"), tr("Failed to create next file:\n%1").arg(file), {BBox::Ok});
+        }
+        break;
+    } default:
+        break;
+    }
+}
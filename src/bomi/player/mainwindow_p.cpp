@@ -3,6 +3,7 @@
 #include "app.hpp"
 #include "misc/trayicon.hpp"
 #include "misc/stepactionpair.hpp"
+#include "misc/directorycache.hpp"
 #include "tmp/algorithm.hpp"
 #include "video/kernel3x3.hpp"
 #include "video/deintoption.hpp"
@@ -175,7 +176,7 @@ auto MainWindow::Data::plugEngine() -> void
     });
 #endif
     connect(&e, &PlayEngine::tick, p, [=] (int time) {
-        if (ab.check(time)) e.seek(ab.a());
+        if (ab.check(time)) e.setABLoop(-1, -1);
 #ifdef Q_OS_WIN
         taskbar.progress()->setValue(time);
 #endif
@@ -187,11 +188,12 @@ auto MainWindow::Data::plugEngine() -> void
     });
     connect(&e, &PlayEngine::started, p, [=] (const Mrl &mrl) {
         setOpen(mrl);
+        queueNextMrl();
         if (encoder && !encoder->isBusy())
             encoder->hide();
     });
-    connect(&e, &PlayEngine::finished, p, [=] (const Mrl &/*mrl*/, bool eof) {
-        if (!eof) return;
+    connect(&e, &PlayEngine::finished, p, [=] (const Mrl &/*mrl*/, bool eof, bool queued) {
+        if (!eof || queued) return;
         const auto next = playlist.checkNextMrl();
         if (!next.isEmpty()) load(next, true, !pref.resume_ignore_in_playlist());
     });
@@ -212,6 +214,22 @@ auto MainWindow::Data::plugEngine() -> void
             p, [=] () { if (pref.auto_unmute()) e.setAudioMuted(false); });
 }
 
+// resolve upcoming web streams while current one is playing
+auto MainWindow::Data::prefetchUrls() -> void
+{
+    QStringList urls;
+    int row = playlist.next();
+    for (int i = 0; i < 3 && playlist.isValidRow(row); ++i) {
+        const auto &mrl = playlist.at(row);
+        if (mrl.isRemoteUrl() && !yle.supports(mrl.toString()))
+            urls.push_back(mrl.toString());
+        if (playlist.isShuffled())
+            break;
+        ++row;
+    }
+    youtube.prefetch(urls);
+}
+
 auto MainWindow::Data::initItems() -> void
 {
     recent.setUpdateFunc([=] (auto &list) { this->updateRecentActions(list); });
@@ -219,6 +237,11 @@ auto MainWindow::Data::initItems() -> void
             p, [this] (const Mrl &mrl) { openMrl(mrl); });
     connect(&playlist, &PlaylistModel::playRequested,
             p, [this] (int row) { openMrl(playlist.at(row)); });
+    for (auto signal : { &PlaylistModel::nextChanged, &PlaylistModel::shuffledChanged,
+                         &PlaylistModel::repeatChanged })
+        connect(&playlist, signal, p, [this] () { queueNextMrl(); });
+    connect(&playlist, &PlaylistModel::modelReset, p, [this] () { queueNextMrl(); });
+    connect(&playlist, &PlaylistModel::rowsChanged, p, [this] () { queueNextMrl(); });
 
     hider.setSingleShot(true);
     connect(&hider, &QTimer::timeout, p, [this] () { setCursorVisible(false); });
@@ -525,14 +548,12 @@ auto MainWindow::Data::generatePlaylist(const Mrl &mrl) const -> Playlist
     Playlist list;
     const auto mode = pref.generate_playlist();
     const QFileInfo file(mrl.toLocalFile());
-    const QDir dir = file.dir();
-    const auto filter = _ToNameFilter(pref.exclude_images() ? VideoExt | AudioExt : MediaExt);
+    const auto dir = DirectoryCache::get(file.absolutePath());
+    const auto files = dir->files(pref.exclude_images() ? VideoExt | AudioExt : MediaExt);
     if (mode == GeneratePlaylist::Folder) {
-        const auto files = dir.entryList(filter, QDir::Files, QDir::Name);
         for (int i=0; i<files.size(); ++i)
-            list.push_back(dir.absoluteFilePath(files[i]));
+            list.push_back(dir->filePath(files[i]));
     } else {
-        const auto files = dir.entryInfoList(filter, QDir::Files, QDir::Name);
         const auto fileName = file.fileName();
         bool prefix = false, suffix = false;
         auto it = files.cbegin();
@@ -542,7 +563,7 @@ auto MainWindow::Data::generatePlaylist(const Mrl &mrl) const -> Playlist
             if (!ms.hasMatch())
                 continue;
             static QRegEx rxt(uR"((\D*)\d+(.*))"_q);
-            const auto mt = rxt.match(it->fileName());
+            const auto mt = rxt.match(*it);
             if (!mt.hasMatch())
                 continue;
             if (!prefix && !suffix) {
@@ -559,7 +580,7 @@ auto MainWindow::Data::generatePlaylist(const Mrl &mrl) const -> Playlist
                 if (ms.capturedRef(2) != mt.capturedRef(2))
                     continue;
             }
-            list.append(it->absoluteFilePath());
+            list.append(dir->filePath(*it));
         }
     }
 
@@ -596,14 +617,18 @@ auto MainWindow::Data::applyPref() -> void
     const auto &controls = p.controls_theme();
 
     e.preview()->setShowKeyframe(controls.showKeyframeForPreview);
+    queueNextMrl();
     youtube.setUserAgent(p.yt_user_agent());
     youtube.setProgram(p.yt_program());
     youtube.setPreferredFormat(p.yt_height(), p.yt_fps(), p.yt_container());
     yle.setProgram(p.yle_program());
     history.setRememberImage(p.remember_image());
+    history.setRetention(p.history_max_days(), p.history_max_count());
+    history.setLowMemory(p.low_memory());
     history.setPropertiesToRestore(p.restore_properties());
     history.setShowMediaTitleInName(controls.showMediaTitleForLocalFilesInHistory,
                                     controls.showMediaTitleForUrlsInHistory);
+    library.setFolders(p.library_folders());
     if (subFindDlg)
         subFindDlg->setOptions(pref.preserve_downloaded_subtitles(),
                                pref.preserve_file_name_format(),
@@ -648,6 +673,12 @@ auto MainWindow::Data::applyPref() -> void
 
     menu.retranslate();
     menu.setShortcutMap(p.shortcut_map());
+    const auto &mods = EnumInfo<KeyModifier>::items();
+    for (auto &item : MouseBehaviorInfo::items()) {
+        const auto mm = map.value(item.value);
+        for (int i = 0; i < (int)mods.size(); ++i)
+            mouseActions[(int)item.value][i] = menu.action(mm[mods[i].value]);
+    }
     auto &play = menu(u"play"_q);
     play(u"speed"_q).s()->setValue(p.steps().speed_pct);
     auto &seek = play(u"seek"_q);
@@ -682,27 +713,10 @@ auto MainWindow::Data::applyPref() -> void
 
     theme.set(p.osd_theme());
     theme.set(controls);
-    reloadSkin();
+    switchSkin(p.skin_name());
     if (tray)
         tray->setVisible(p.enable_system_tray());
 
-    auto cache = [&] () {
-        CacheInfo cache;
-        cache.local.kb = p.cache_local_mb() * 1024.0;
-        cache.network.kb = p.cache_network_mb() * 1024.0;
-        cache.disc.kb = p.cache_disc_mb() * 1024.0;
-        cache.local.sec = p.cache_local_sec();
-        cache.network.sec = p.cache_network_sec();
-        cache.disc.sec = p.cache_disc_sec();
-        cache.local.file = p.cache_local_file();
-        cache.network.file = p.cache_network_file();
-        cache.disc.file = p.cache_disc_file();
-        cache.file_kb = p.cache_file_size_mb() * 1024.0;
-        cache.min_playback_kb = p.cache_min_playback_kb();
-        cache.min_seeking_kb = p.cache_min_seeking_kb();
-        cache.remotes = p.network_folders();
-        return cache;
-    };
     auto smb = [&] () {
         SmbAuth smb;
         smb.setUsername(p.smb_username());
@@ -719,31 +733,10 @@ auto MainWindow::Data::applyPref() -> void
         return smb;
     };
 
-    e.lock();
-    e.preview()->setActive(controls.showPreviewOnMouseOverSeekBar);
-
-    e.setResume_locked(p.remember_stopped());
-    e.setPreciseSeeking_locked(p.precise_seeking());
-    e.setCache_locked(cache());
-    e.setSmbAuth_locked(smb());
-    e.setPriority_locked(p.audio_priority(), p.sub_priority());
-    e.setAutoloader_locked(p.audio_autoload(), p.sub_autoload_v2());
-
-    e.setHwAcc_locked(p.enable_hwaccel(), p.hwaccel_codecs());
-    e.setDeintOptions_locked(p.deinterlacing());
-    e.setMotionIntrplOption_locked(p.motion_interpolation());
-
-    e.setAudioDevice_locked(p.audio_device());
-    e.setVolumeNormalizerOption_locked(p.audio_normalizer());
-    e.setChannelLayoutMap_locked(p.channel_manipulation());
-    e.setVolumeControl_locked(p.volume_scale(), p.soft_clip());
-    e.setResyncAvWhenFilterToggled_locked(p.audio_filter_resync());
-
-    e.setSubtitleStyle_locked(p.sub_style());
-    e.setAutoselectMode_locked(p.sub_enable_autoselect(), p.sub_autoselect(),
-                               p.sub_ext(), p.sub_prefer_external());
-    e.unlock();
-    e.reload();
+    // preview runs its own mpv instance
+    e.preview()->setActive(controls.showPreviewOnMouseOverSeekBar && !p.low_memory());
+    e.setSmbAuth(smb());
+    e.setPreferences(p);
 }
 
 auto MainWindow::Data::updateStaysOnTop() -> void
@@ -784,17 +777,74 @@ auto MainWindow::Data::clear() -> void
     p->releaseResources();
 }
 
+static auto skinErrors(const QList<QQmlError> &errors) -> void
+{
+    QString msg;
+    for (auto &error : errors)
+        msg += error.toString() % '\n'_q;
+    MBox::error(nullptr, MainWindow::tr("Error on loading skin"), msg, {BBox::Ok});
+}
+
 auto MainWindow::Data::reloadSkin() -> void
 {
+    _Delete(skin.next);
     clear();
-    Skin::apply(p, pref.skin_name());
-    if (p->status() == QQuickView::Error) {
-        QString msg;
-        for (auto &error : p->errors())
-            msg += error.toString() % '\n'_q;
-        MBox::error(nullptr, tr("Error on loading skin"), msg, {BBox::Ok});
+    skin.name = pref.skin_name();
+    Skin::apply(p, skin.name);
+    if (p->status() == QQuickView::Error)
+        skinErrors(p->errors());
+    else
+        setupSkin();
+}
+
+auto MainWindow::Data::switchSkin(const QString &name) -> void
+{
+    if (!p->rootObject()) {
+        reloadSkin();
+        return;
+    }
+    if (skin.next && skin.nextName == name)
+        return;
+    _Delete(skin.next);
+    if (name == skin.name) {
+        // other preferences may have changed
+        p->setupSkinPlayer();
         return;
     }
+    const auto url = Skin::prepare(p->qmlEngine(), name);
+    skin.nextName = name;
+    skin.next = new QQmlComponent(p->qmlEngine(), url, QQmlComponent::Asynchronous);
+    auto swap = [=] () {
+        auto next = skin.next;
+        if (next->isLoading())
+            return;
+        // may be in its signal
+        next->deleteLater();
+        skin.next = nullptr;
+        if (next->isError()) {
+            skinErrors(next->errors());
+            return;
+        }
+        // compiled types are referenced by next, so view creates it at once
+        this->player = nullptr;
+        skin.name = name;
+        Skin::apply(p, name);
+        if (p->status() == QQuickView::Error) {
+            skinErrors(p->errors());
+            return;
+        }
+        // drop types of previous skin only, scene graph resources are kept
+        p->qmlEngine()->trimComponentCache();
+        setupSkin();
+    };
+    if (skin.next->isLoading())
+        connect(skin.next, &QQmlComponent::statusChanged, p, swap);
+    else
+        swap();
+}
+
+auto MainWindow::Data::setupSkin() -> void
+{
     auto app = p->rootObject();
     if (!app)
         return;
@@ -9,6 +9,8 @@
 #include "playengine.hpp"
 #include "playlistmodel.hpp"
 #include "historymodel.hpp"
+#include "medialibrary.hpp"
+#include "mediaprobe.hpp"
 #include "pref/pref.hpp"
 #include "streamtrack.hpp"
 #include "misc/downloader.hpp"
@@ -17,20 +19,24 @@
 #include "video/videorenderer.hpp"
 #include "subtitle/subtitlerenderer.hpp"
 #include "opengl/opengllogger.hpp"
+#include "opengl/openglworker.hpp"
 #include "quick/themeobject.hpp"
 #include "quick/toplevelitem.hpp"
 #include "quick/windowobject.hpp"
 #include "misc/stepaction.hpp"
 #include "misc/logviewer.hpp"
+#include "video/contactsheet.hpp"
 #include "os/os.hpp"
 #include "misc/smbauth.hpp"
 #include "misc/dataevent.hpp"
 #include "json/jrserver.hpp"
 #include "player/jrplayer.hpp"
 #include <QUndoCommand>
+#include <QDateTime>
 #include <QMimeData>
 #include <QQmlProperty>
 #include <QQmlEngine>
+#include <QQmlComponent>
 
 #ifdef Q_OS_WIN
 #include <QWinTaskbarButton>
@@ -43,15 +49,34 @@ enum MainWindowEvent {
     GetSmbAuth = QEvent::User + 1
 };
 
+// entries beyond this are dropped from the oldest
+static constexpr int UndoLimit = 100;
+
+// commands of same id merge into last one while each comes within
+// MergeWindow of previous, so holding a step key leaves one entry
 template<class Func, class T>
 class ValueCmd : public QUndoCommand {
 public:
-    ValueCmd(const T &to, const T &from, const Func &func)
-        : to(to), from(from), func(func) { }
+    static constexpr qint64 MergeWindow = 1000; // ms
+    ValueCmd(const T &to, const T &from, const Func &func, int id = -1)
+        : to(to), from(from), func(func), m_id(id)
+        , m_time(QDateTime::currentMSecsSinceEpoch()) { }
     auto redo() -> void final { func(to); }
     auto undo() -> void final { func(from); }
+    auto id() const -> int final { return m_id; }
+    auto mergeWith(const QUndoCommand *other) -> bool final
+    {
+        auto cmd = dynamic_cast<const ValueCmd*>(other);
+        if (!cmd || cmd->m_time - m_time > MergeWindow)
+            return false;
+        to = cmd->to;
+        m_time = cmd->m_time;
+        return true;
+    }
 private:
     T to, from; Func  func;
+    int m_id = -1;
+    qint64 m_time = 0;
 };
 
 enum SnapshotMode {
@@ -74,6 +99,10 @@ struct MainWindow::Data {
 
     MainWindow *p = nullptr;
     QQuickItem *player = nullptr, *cropbox = nullptr;
+    struct {
+        QString name, nextName;
+        QQmlComponent *next = nullptr;
+    } skin;
     RootMenu &menu = RootMenu::instance();
     RecentInfo recent;
     AppState as;
@@ -89,6 +118,9 @@ struct MainWindow::Data {
     Qt::MouseButton pressedButton = Qt::NoButton;
     Qt::MouseButton contextMenuButton = Qt::RightButton;
     KeyModifier contextMenuModifier = KeyModifier::None;
+    // mouse_action_map() resolved when preferences are applied
+    std::array<std::array<QAction*, EnumInfo<KeyModifier>::size()>,
+               MouseBehaviorInfo::size()> mouseActions{};
     struct {
         QTimer timer; QAction *action;
         auto unset() { timer.stop(); action = nullptr; }
@@ -110,14 +142,18 @@ struct MainWindow::Data {
     QSharedPointer<PrefDialog> prefDlg;
     QSharedPointer<SubtitleFindDialog> subFindDlg;
     QSharedPointer<LogViewer> logViewer;
+    QSharedPointer<ContactSheetExporter> sheets;
     QSharedPointer<SnapshotDialog> snapshot;
     QSharedPointer<SubtitleViewer> sview;
     QSharedPointer<AudioEqualizerDialog> eq;
     QSharedPointer<VideoColorDialog> color;
     QSharedPointer<IntrplDialog> intrpl, chroma, intrplDown;
     QSharedPointer<EncoderDialog> encoder;
+    // used by playlist and history, so destroyed after them
+    MediaProbeCache probes;
     PlaylistModel playlist;
     QUndoStack undo;
+    QHash<const void*, int> mergeIds;
     Downloader downloader;
     TrayIcon *tray = nullptr;
     QString filePath;
@@ -125,16 +161,20 @@ struct MainWindow::Data {
     ThemeObject theme;
     QList<QAction*> unblockedActions;
     HistoryModel history;
+    MediaLibrary library;
     SnapshotMode snapshotMode = NoSnapshot;
 
     TopLevelItem *top = nullptr;
     OS::WindowAdapter *adapter = nullptr;
     JrServer *jrServer = nullptr;
     JrPlayer jrPlayer;
+    // shares objects with scene graph
+    OpenGLWorker gpu{u"GpuWorker"_q};
     Qt::WindowState prevWindowState = Qt::WindowNoState;
     int wheelAngles = 0;
 
     auto fileNameGenerator(const QTime &end = QTime()) const -> FileNameGenerator;
+    auto saveSnapshot(const QImage &frameOnly, const QImage &osd) -> void;
 
     template<class T, class... Args>
     auto dialog(const Args&... args) -> QSharedPointer<T>
@@ -154,14 +194,28 @@ struct MainWindow::Data {
         { return p->rootObject()->findChild<T*>(name); }
     auto clear() -> void;
     auto resizeContainer() -> void;
-    auto actionId(MouseBehavior mb, QInputEvent *event) const -> QString
-        { return pref.mouse_action_map()[mb][event->modifiers()]; }
+    auto mouseAction(MouseBehavior mb, QInputEvent *event) const -> QAction*
+    {
+        using Info = EnumInfo<KeyModifier>;
+        if (!MouseBehaviorInfo::item(mb))
+            return nullptr;
+        const auto m = Info::from(event->modifiers(), KeyModifier::None);
+        return mouseActions[(int)mb][Info::item(m) - Info::items().data()];
+    }
     auto setOpen(const Mrl &mrl) -> void
     {
         if (mrl.isLocalFile())
             _SetLastOpenPath(mrl.toLocalFile());
         playlist.setLoaded(mrl);
     }
+    auto queueNextMrl() -> void
+    {
+        const auto next = pref.playlist_gapless() ? playlist.nextMrl() : Mrl();
+        e.setNextMrl(next, !pref.resume_ignore_in_playlist());
+        e.prefetchImages({ playlist.nextMrl(), playlist.previousMrl() });
+        prefetchUrls();
+    }
+    auto prefetchUrls() -> void;
     auto deleteDialogs() -> void;
     auto restoreState() -> void;
     auto applyPref() -> void;
@@ -189,7 +243,12 @@ struct MainWindow::Data {
     auto plugMenu() -> void;
     auto load(const Mrl &mrl, bool play = true,
               bool tryResume = true, const QString &sub = QString()) -> void;
+    // tears down current skin and loads it again with files edited
     auto reloadSkin() -> void;
+    // compiles other skin in background and swaps it in when ready, video
+    // and subtitle items and their gl resources stay as they are
+    auto switchSkin(const QString &name) -> void;
+    auto setupSkin() -> void;
     auto trigger(QAction *action) -> void;
     auto setCursorVisible(bool visible) -> void;
     auto cancelToHideCursor() -> void;
@@ -202,12 +261,17 @@ struct MainWindow::Data {
     auto updateWaitingMessage() -> void;
     auto updateWindowState(Qt::WindowState ws) -> void;
 
+    // changes with same merge key, e.g. steps of one group, become one entry
     template<class T, class Func>
-    auto push(const T &to, const T &from, const Func &func) -> QUndoCommand*;
+    auto push(const T &to, const T &from, const Func &func,
+              const void *merge = nullptr) -> QUndoCommand*;
     template<class T, class S>
-    auto push(const T &to, const T &old, void(PlayEngine::*set)(S)) -> QUndoCommand*;
+    auto push(const T &to, const T &old, void(PlayEngine::*set)(S),
+              const void *merge = nullptr) -> QUndoCommand*;
     template<class T, class S>
-    auto push(const T &to, T(MrlState::*get)() const, void(PlayEngine::*set)(S)) -> QUndoCommand*;
+    auto push(const T &to, T(MrlState::*get)() const, void(PlayEngine::*set)(S),
+              const void *merge = nullptr) -> QUndoCommand*;
+    auto mergeId(const void *key) -> int;
     auto showTimeLine() -> void;
     auto showMessageBox(const QVariant &msg) -> void;
     auto showOSD(const QVariant &msg) -> void;
@@ -0,0 +1,517 @@
+#include "medialibrary.hpp"
+#include "mrlstatesqlfield.hpp"
+#include "misc/log.hpp"
+#include "misc/dataevent.hpp"
+#include "os/os.hpp"
+#include <QFileSystemWatcher>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+DECLARE_LOG_CONTEXT(Library)
+
+enum EventType { Indexed = QEvent::User + 1 };
+
+// folders reported at once, also bounds one transaction
+static constexpr int Batch = 64;
+// watched folders, inotify and others have limits per user
+static constexpr int MaxWatches = 4096;
+
+static auto check(const QSqlQuery &query) -> bool
+{
+    if (!query.lastError().isValid())
+        return true;
+    _Error("Error on query: %% for %%"
+           , query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+static auto isUnder(const QString &path, const QString &root) -> bool
+{
+    if (!path.startsWith(root))
+        return false;
+    return path.size() == root.size() || root.endsWith('/'_q)
+            || path[root.size()] == '/'_q;
+}
+
+// lists folders and writes rows with own connection, never blocks gui thread
+class LibraryIndexer : public QThread {
+public:
+    ~LibraryIndexer() { stop(); }
+    auto open(QObject *library, const QString &path, const QString &probes,
+              const QStringList &filters) -> void
+    {
+        m_library = library;
+        m_path = path;
+        m_probes = probes;
+        m_filters = filters;
+        start();
+    }
+    auto stop() -> void
+    {
+        m_mutex.lock(); m_quit = true; m_wake.wakeAll(); m_mutex.unlock(); wait();
+    }
+    // rows out of roots are dropped and roots are scanned from scratch
+    auto setRoots(const QStringList &roots) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        m_roots = roots;
+        m_queue.clear();
+        m_queued.clear();
+        m_known.clear();
+        for (auto &root : roots)
+            enqueue(root);
+        m_prune = true;
+        m_wake.wakeAll();
+    }
+    // sub folders already scanned are not visited again
+    auto rescan(const QString &folder) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (isRooted(folder)) {
+            enqueue(folder);
+            m_wake.wakeAll();
+        }
+    }
+private:
+    struct Row { qint64 rowid = -1, size = -1, mtime = -1; };
+    auto isRooted(const QString &folder) const -> bool
+    {
+        return std::any_of(m_roots.begin(), m_roots.end(), [&] (const QString &root)
+            { return isUnder(folder, root); });
+    }
+    auto enqueue(const QString &folder) -> void
+    {
+        if (m_queued.contains(folder))
+            return;
+        m_queued.insert(folder);
+        m_queue.push_back(folder);
+    }
+    auto run() -> void final;
+    auto count(SqlQueryCache &queries) -> int;
+    // returns sub folders of folder
+    auto scan(SqlQueryCache &queries, const QString &folder) -> QStringList;
+    auto remove(SqlQueryCache &queries, const QString &folder) -> void;
+    auto prune(QSqlDatabase &db, SqlQueryCache &queries, const QStringList &roots) -> void;
+    auto probe(SqlQueryCache &queries, const QString &path, qint64 size,
+               qint64 mtime, QString *title) -> int;
+    QObject *m_library = nullptr;
+    QString m_path, m_probes;
+    QStringList m_filters, m_roots, m_queue;
+    QSet<QString> m_queued, m_known;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_quit = false, m_prune = false, m_attached = false;
+};
+
+auto LibraryIndexer::run() -> void
+{
+    OS::setThreadClass(OS::ThreadClass::Background);
+    const auto name = u"media-library-indexer"_q;
+    {
+        auto db = QSqlDatabase::addDatabase(u"QSQLITE"_q, name);
+        db.setDatabaseName(m_path);
+        if (!db.open())
+            _Error("Error: %%. Couldn't open database for indexing.",
+                   db.lastError().text());
+        QSqlQuery query(db);
+        query.exec(u"PRAGMA synchronous = NORMAL"_q);
+        query.exec(u"CREATE TABLE IF NOT EXISTS library (path TEXT PRIMARY KEY NOT NULL, "
+                    "folder TEXT NOT NULL, name TEXT, size INTEGER, mtime INTEGER, "
+                    "title TEXT, duration INTEGER)"_q);
+        check(query);
+        query.exec(u"CREATE INDEX IF NOT EXISTS library_folder ON library (folder)"_q);
+        check(query);
+        // fts5 is not in every build of sqlite, fts4 reads same queries here
+        for (auto module : { "fts5(name, folder, title, tokenize = 'unicode61')",
+                             "fts4(name, folder, title, tokenize=unicode61)",
+                             "fts4(name, folder, title)" }) {
+            if (query.exec("CREATE VIRTUAL TABLE IF NOT EXISTS library_fts USING "_a % _L(module)))
+                break;
+        }
+        check(query);
+        // probed titles and durations are joined from cache of MediaProbe
+        query.prepare(u"ATTACH DATABASE ? AS media"_q);
+        query.addBindValue(m_probes);
+        m_attached = query.exec();
+        query.finish();
+        SqlQueryCache queries(db);
+        _PostEvent(m_library, Indexed, false, count(queries), QStringList());
+
+        QMutexLocker locker(&m_mutex);
+        while (!m_quit) {
+            if (m_queue.isEmpty() && !m_prune) {
+                m_wake.wait(&m_mutex);
+                continue;
+            }
+            if (m_prune) {
+                m_prune = false;
+                const auto roots = m_roots;
+                locker.unlock();
+                if (db.isOpen())
+                    prune(db, queries, roots);
+                locker.relock();
+                if (m_queue.isEmpty())
+                    _PostEvent(m_library, Indexed, false, count(queries), QStringList());
+                continue;
+            }
+            QStringList scanned;
+            while (!m_quit && !m_prune && !m_queue.isEmpty() && scanned.size() < Batch) {
+                const auto folder = m_queue.takeFirst();
+                m_queued.remove(folder);
+                m_known.insert(folder);
+                locker.unlock();
+                QStringList subs;
+                if (db.isOpen()) {
+                    db.transaction();
+                    subs = scan(queries, folder);
+                    db.commit();
+                }
+                locker.relock();
+                // roots may have changed while scanning
+                for (auto &sub : subs) {
+                    if (!m_known.contains(sub) && isRooted(sub))
+                        enqueue(sub);
+                }
+                scanned.push_back(folder);
+            }
+            _PostEvent(m_library, Indexed, !m_queue.isEmpty(), count(queries), scanned);
+        }
+        queries.clear();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto LibraryIndexer::count(SqlQueryCache &queries) -> int
+{
+    auto &query = queries.get(u"SELECT COUNT(*) FROM library"_q);
+    if (!query.exec() || !query.next()) {
+        check(query);
+        return 0;
+    }
+    const int count = query.value(0).toInt();
+    query.finish();
+    return count;
+}
+
+auto LibraryIndexer::probe(SqlQueryCache &queries, const QString &path,
+                           qint64 size, qint64 mtime, QString *title) -> int
+{
+    if (!m_attached)
+        return -1;
+    auto &query = queries.get(u"SELECT info FROM media.probe "
+                               "WHERE path = ? AND size = ? AND mtime = ?"_q);
+    query.bindValue(0, path);
+    query.bindValue(1, size);
+    query.bindValue(2, mtime);
+    if (!query.exec() || !query.next())
+        return -1;
+    const auto json = QJsonDocument::fromBinaryData(query.value(0).toByteArray()).object();
+    query.finish();
+    *title = json[u"title"_q].toString();
+    return json[u"duration"_q].toInt(-1);
+}
+
+auto LibraryIndexer::scan(SqlQueryCache &queries, const QString &folder) -> QStringList
+{
+    const QDir dir(folder);
+    if (!dir.exists()) {
+        remove(queries, folder);
+        return QStringList();
+    }
+    QHash<QString, Row> rows;
+    auto &select = queries.get(u"SELECT rowid, path, size, mtime FROM library WHERE folder = ?"_q);
+    select.bindValue(0, folder);
+    if (select.exec()) {
+        while (select.next()) {
+            Row row;
+            row.rowid = select.value(0).toLongLong();
+            row.size = select.value(2).toLongLong();
+            row.mtime = select.value(3).toLongLong();
+            rows.insert(select.value(1).toString(), row);
+        }
+    }
+    check(select);
+
+    for (auto &info : dir.entryInfoList(m_filters, QDir::Files)) {
+        const auto path = info.absoluteFilePath();
+        const auto size = info.size();
+        const auto mtime = info.lastModified().toMSecsSinceEpoch();
+        const auto it = rows.find(path);
+        const auto old = it == rows.end() ? Row() : *it;
+        if (it != rows.end())
+            rows.erase(it);
+        if (old.size == size && old.mtime == mtime)
+            continue;
+        QString title;
+        const int duration = probe(queries, path, size, mtime, &title);
+        if (old.rowid >= 0) {
+            auto &update = queries.get(u"UPDATE library SET size = ?, mtime = ?, "
+                                        "title = ?, duration = ? WHERE rowid = ?"_q);
+            update.bindValue(0, size);
+            update.bindValue(1, mtime);
+            update.bindValue(2, title);
+            update.bindValue(3, duration);
+            update.bindValue(4, old.rowid);
+            update.exec();
+            check(update);
+            auto &fts = queries.get(u"UPDATE library_fts SET title = ? WHERE rowid = ?"_q);
+            fts.bindValue(0, title);
+            fts.bindValue(1, old.rowid);
+            fts.exec();
+            check(fts);
+            continue;
+        }
+        auto &insert = queries.get(u"INSERT INTO library (path, folder, name, size, "
+                                    "mtime, title, duration) VALUES (?, ?, ?, ?, ?, ?, ?)"_q);
+        insert.bindValue(0, path);
+        insert.bindValue(1, folder);
+        insert.bindValue(2, info.fileName());
+        insert.bindValue(3, size);
+        insert.bindValue(4, mtime);
+        insert.bindValue(5, title);
+        insert.bindValue(6, duration);
+        if (!insert.exec()) {
+            check(insert);
+            continue;
+        }
+        auto &fts = queries.get(u"INSERT INTO library_fts (rowid, name, folder, title) "
+                                 "VALUES (?, ?, ?, ?)"_q);
+        fts.bindValue(0, insert.lastInsertId());
+        fts.bindValue(1, info.fileName());
+        fts.bindValue(2, folder);
+        fts.bindValue(3, title);
+        fts.exec();
+        check(fts);
+    }
+    for (auto &row : rows) {
+        for (auto table : { "library_fts", "library" }) {
+            auto &query = queries.get("DELETE FROM "_a % _L(table) % " WHERE rowid = ?"_a);
+            query.bindValue(0, row.rowid);
+            query.exec();
+            check(query);
+        }
+    }
+
+    QStringList subs;
+    QSet<QString> names;
+    for (auto &info : dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        subs.push_back(info.absoluteFilePath());
+        names.insert(info.fileName());
+    }
+    // rows of sub folders which are gone, range of prefix runs on index
+    const auto prefix = folder.endsWith('/'_q) ? folder : QString(folder % '/'_q);
+    auto &children = queries.get(u"SELECT DISTINCT folder FROM library "
+                                  "WHERE folder >= ? AND folder < ?"_q);
+    children.bindValue(0, prefix);
+    children.bindValue(1, QString(prefix.left(prefix.size() - 1) % '0'_q));
+    QStringList gone;
+    if (children.exec()) {
+        while (children.next()) {
+            const auto child = children.value(0).toString();
+            const auto name = child.mid(prefix.size()).section('/'_q, 0, 0);
+            if (!names.contains(name))
+                gone.push_back(child);
+        }
+    }
+    check(children);
+    for (auto &child : gone)
+        remove(queries, child);
+    return subs;
+}
+
+auto LibraryIndexer::remove(SqlQueryCache &queries, const QString &folder) -> void
+{
+    auto &fts = queries.get(u"DELETE FROM library_fts WHERE rowid IN "
+                             "(SELECT rowid FROM library WHERE folder = ?)"_q);
+    fts.bindValue(0, folder);
+    fts.exec();
+    check(fts);
+    auto &rows = queries.get(u"DELETE FROM library WHERE folder = ?"_q);
+    rows.bindValue(0, folder);
+    rows.exec();
+    check(rows);
+}
+
+auto LibraryIndexer::prune(QSqlDatabase &db, SqlQueryCache &queries,
+                           const QStringList &roots) -> void
+{
+    auto &query = queries.get(u"SELECT DISTINCT folder FROM library"_q);
+    QStringList outside;
+    if (query.exec()) {
+        while (query.next()) {
+            const auto folder = query.value(0).toString();
+            if (!std::any_of(roots.begin(), roots.end(), [&] (const QString &root)
+                             { return isUnder(folder, root); }))
+                outside.push_back(folder);
+        }
+    }
+    check(query);
+    if (outside.isEmpty())
+        return;
+    db.transaction();
+    for (auto &folder : outside)
+        remove(queries, folder);
+    db.commit();
+    _Info("%% folders removed from library.", outside.size());
+}
+
+/******************************************************************************/
+
+struct MediaLibrary::Data {
+    LibraryIndexer indexer;
+    QSqlDatabase db;
+    mutable SqlQueryCache queries;
+    QFileSystemWatcher watcher;
+    QSet<QString> watched, changed;
+    QTimer rescanner;
+    QStringList folders;
+    bool indexing = false;
+    int count = 0;
+};
+
+MediaLibrary::MediaLibrary(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    // bursts of changes such as copying many files are rescanned once
+    d->rescanner.setSingleShot(true);
+    d->rescanner.setInterval(1000);
+    connect(&d->rescanner, &QTimer::timeout, this, [=] () {
+        for (auto &folder : d->changed)
+            d->indexer.rescan(folder);
+        d->changed.clear();
+    });
+    connect(&d->watcher, &QFileSystemWatcher::directoryChanged,
+            this, [=] (const QString &folder) {
+        if (!QFileInfo(folder).isDir())
+            d->watched.remove(folder);
+        d->changed.insert(folder);
+        d->rescanner.start();
+    });
+}
+
+MediaLibrary::~MediaLibrary()
+{
+    d->indexer.stop();
+    const auto name = d->db.connectionName();
+    d->queries.clear();
+    d->db.close();
+    d->db = QSqlDatabase();
+    delete d;
+    if (!name.isEmpty())
+        QSqlDatabase::removeDatabase(name);
+}
+
+auto MediaLibrary::isIndexing() const -> bool
+{
+    return d->indexing;
+}
+
+auto MediaLibrary::isEnabled() const -> bool
+{
+    return !d->folders.isEmpty();
+}
+
+auto MediaLibrary::count() const -> int
+{
+    return d->count;
+}
+
+auto MediaLibrary::folders() const -> QStringList
+{
+    return d->folders;
+}
+
+auto MediaLibrary::setFolders(const QStringList &folders) -> void
+{
+    QStringList roots;
+    for (auto &folder : folders) {
+        const auto root = QDir(folder).absolutePath();
+        if (!folder.isEmpty() && !roots.contains(root))
+            roots.push_back(root);
+    }
+    if (d->folders == roots)
+        return;
+    const bool enabled = isEnabled();
+    d->folders = roots;
+    // rows of last session are kept until library is used again
+    if (!d->indexer.isRunning()) {
+        if (roots.isEmpty())
+            return;
+        const auto path = _WritablePath(Location::Config) % "/history.db"_a;
+        d->db = QSqlDatabase::addDatabase(u"QSQLITE"_q, u"media-library"_q);
+        d->db.setDatabaseName(path);
+        if (!d->db.open())
+            _Error("Error: %%. Couldn't open database for library.",
+                   d->db.lastError().text());
+        d->queries.setDatabase(d->db);
+        d->indexer.open(this, path, _WritablePath(Location::Cache) % "/mediaprobe.db"_a,
+                        _ToNameFilter(VideoExt | AudioExt));
+    }
+    if (!d->watched.isEmpty())
+        d->watcher.removePaths(d->watched.toList());
+    d->watched.clear();
+    d->changed.clear();
+    d->indexer.setRoots(roots);
+    if (enabled != isEnabled())
+        emit enabledChanged(isEnabled());
+}
+
+auto MediaLibrary::search(const QString &text, int limit) const -> QVariantList
+{
+    if (d->folders.isEmpty() || !d->db.isOpen())
+        return QVariantList();
+    static const QRegularExpression split(u"\\W+"_q,
+                                          QRegularExpression::UseUnicodePropertiesOption);
+    QStringList words;
+    for (auto &word : text.split(split, QString::SkipEmptyParts))
+        words.push_back('"'_q % word % "\"*"_a);
+    if (words.isEmpty())
+        return QVariantList();
+    QElapsedTimer timer;
+    timer.start();
+    auto &query = d->queries.get(u"SELECT l.path, l.name, l.folder, l.title, l.duration "
+                                  "FROM library_fts JOIN library l "
+                                  "ON l.rowid = library_fts.rowid "
+                                  "WHERE library_fts MATCH ? LIMIT ?"_q);
+    query.bindValue(0, words.join(' '_q));
+    query.bindValue(1, limit);
+    QVariantList list;
+    if (query.exec()) {
+        while (query.next()) {
+            QVariantMap map;
+            map[u"location"_q] = _UrlFromLocalFile(query.value(0).toString()).toString();
+            map[u"name"_q] = query.value(1);
+            map[u"folder"_q] = query.value(2);
+            map[u"title"_q] = query.value(3);
+            map[u"duration"_q] = query.value(4);
+            list.push_back(map);
+        }
+    }
+    check(query);
+    query.finish();
+    _Debug("%% results for '%%' in %%ms.", list.size(), text, timer.elapsed());
+    return list;
+}
+
+auto MediaLibrary::customEvent(QEvent *event) -> void
+{
+    if (event->type() != static_cast<QEvent::Type>(Indexed))
+        return;
+    bool indexing = false; int count = 0; QStringList scanned;
+    _TakeData(event, indexing, count, scanned);
+    for (auto &folder : scanned) {
+        if (d->watched.size() >= MaxWatches)
+            break;
+        if (!d->watched.contains(folder) && d->watcher.addPath(folder))
+            d->watched.insert(folder);
+    }
+    if (_Change(d->count, count))
+        emit countChanged(d->count);
+    if (_Change(d->indexing, indexing))
+        emit indexingChanged(d->indexing);
+}
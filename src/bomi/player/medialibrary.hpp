@@ -0,0 +1,35 @@
+#ifndef MEDIALIBRARY_HPP
+#define MEDIALIBRARY_HPP
+
+// index of media files under library folders kept in history database
+// names, folders and probed titles are searchable by full text index
+// folders are scanned in background and rescanned when watcher reports them,
+// unchanged files are skipped by size and modified time
+class MediaLibrary : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool indexing READ isIndexing NOTIFY indexingChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool enabled READ isEnabled NOTIFY enabledChanged)
+public:
+    MediaLibrary(QObject *parent = nullptr);
+    ~MediaLibrary();
+    auto isIndexing() const -> bool;
+    auto isEnabled() const -> bool;
+    auto count() const -> int;
+    // empty list stops indexing and drops every row
+    auto setFolders(const QStringList &folders) -> void;
+    auto folders() const -> QStringList;
+    // list of {location, name, folder, title, duration} for words of text
+    // every word matches as prefix of a word in name, folder or title
+    Q_INVOKABLE QVariantList search(const QString &text, int limit = 100) const;
+signals:
+    void indexingChanged(bool indexing);
+    void countChanged(int count);
+    void enabledChanged(bool enabled);
+private:
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // MEDIALIBRARY_HPP
@@ -21,8 +21,72 @@ EditionChapterObject::~EditionChapterObject()
 
 }
 
+auto EditionChapterObject::set(const Data &d) -> bool
+{
+    const bool differ = m != d;
+    if (differ) {
+        m.number = d.number;
+        m.time = d.time;
+        m.name = d.name;
+        emit changed();
+    }
+    setRate(d.rate);
+    return differ;
+}
+
 auto EditionChapterObject::setRate(qreal rate) -> void
 {
     if (_Change(m.rate, rate))
         emit rateChanged();
 }
+
+auto CacheInfoObject::setUsed(int s) -> void
+{
+    if (!_Change(m_used, s))
+        return;
+    m_measure.push(s);
+    updateStatistics();
+    emit usedChanged(s);
+}
+
+auto CacheInfoObject::setBitrate(int bps) -> void
+{
+    if (_Change(m_bitrate, bps))
+        updateStatistics();
+}
+
+auto CacheInfoObject::setStalled(bool stalled) -> void
+{
+    if (stalled) {
+        if (!m_stall.isValid())
+            m_stall.start();
+        return;
+    }
+    if (!m_stall.isValid())
+        return;
+    emit underrunsChanged(++m_underruns);
+    if (_Change(m_latency, (int)m_stall.elapsed()))
+        emit latencyChanged(m_latency);
+    m_stall.invalidate();
+}
+
+auto CacheInfoObject::resetStatistics() -> void
+{
+    m_measure.reset();
+    m_stall.invalidate();
+    if (_Change(m_underruns, 0))
+        emit underrunsChanged(0);
+    if (_Change(m_latency, 0))
+        emit latencyChanged(0);
+    m_fillRate = m_throughput = 0.0;
+    emit statisticsChanged();
+}
+
+auto CacheInfoObject::updateStatistics() -> void
+{
+    const double fill = m_measure.get();
+    // while the cache is full, input is limited to what playback consumes
+    const double input = fill + m_bitrate / (8.0 * 1024.0);
+    if (_Change(m_fillRate, fill) | _Change(m_throughput, qMax(0.0, input)))
+        emit statisticsChanged();
+}
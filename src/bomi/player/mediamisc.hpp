@@ -2,6 +2,7 @@
 #define MEDIAMISC_HPP
 
 #include "mrl.hpp"
+#include "misc/speedmeasure.hpp"
 
 class PlayEngine;
 
@@ -71,12 +72,18 @@ private:
 
 class EditionChapterObject : public QObject {
     Q_OBJECT
-    Q_PROPERTY(int number READ number CONSTANT FINAL)
-    Q_PROPERTY(int time READ time CONSTANT FINAL)
-    Q_PROPERTY(QString name READ name CONSTANT FINAL)
+    Q_PROPERTY(int number READ number NOTIFY changed FINAL)
+    Q_PROPERTY(int time READ time NOTIFY changed FINAL)
+    Q_PROPERTY(QString name READ name NOTIFY changed FINAL)
     Q_PROPERTY(qreal rate READ rate NOTIFY rateChanged)
 public:
-    struct Data { int number = -2, time = 0; qreal rate = 0.0; QString name; };
+    struct Data {
+        int number = -2, time = 0; qreal rate = 0.0; QString name;
+        // rate follows playback position, not the item itself
+        auto operator == (const Data &rhs) const -> bool
+            { return number == rhs.number && time == rhs.time && name == rhs.name; }
+        auto operator != (const Data &rhs) const -> bool { return !operator == (rhs); }
+    };
     EditionChapterObject() = default;
     ~EditionChapterObject();
     EditionChapterObject(const Data &d): m(d) { }
@@ -87,11 +94,13 @@ public:
     auto rate() const -> qreal { return m.rate; }
     auto isValid() const -> bool { return m.number > -2; }
 signals:
+    void changed();
     void rateChanged();
 private:
-    auto set(const Data &d) -> void { m = d; emit rateChanged(); }
+    // signals only what differs, true if item itself changed
+    auto set(const Data &d) -> bool;
     auto setRate(qreal rate) -> void;
-    auto invalidate() -> void { setRate(0); m = Data(); }
+    auto invalidate() -> void { set(Data()); }
     friend class PlayEngine;
     Data m;
 };
@@ -110,21 +119,47 @@ class CacheInfoObject : public QObject {
     Q_PROPERTY(int size READ size NOTIFY sizeChanged)
     Q_PROPERTY(int used READ used NOTIFY usedChanged)
     Q_PROPERTY(int time READ time NOTIFY timeChanged)
+    Q_PROPERTY(int underruns READ underruns NOTIFY underrunsChanged)
+    Q_PROPERTY(double fillRate READ fillRate NOTIFY statisticsChanged)
+    Q_PROPERTY(double throughput READ throughput NOTIFY statisticsChanged)
+    Q_PROPERTY(int bitrate READ bitrate NOTIFY statisticsChanged)
+    Q_PROPERTY(int latency READ latency NOTIFY latencyChanged)
 public:
     auto size() const -> int { return m_size; }
     auto used() const -> int { return m_used; }
     auto time() const -> int { return m_time; }
+    // stalls for refilling since playback started
+    auto underruns() const -> int { return m_underruns; }
+    // net growth of cache in KiB/s, negative while draining
+    auto fillRate() const -> double { return m_fillRate; }
+    // estimated input speed in KiB/s: fill rate plus consumption by bitrate
+    auto throughput() const -> double { return m_throughput; }
+    // sum of audio and video bitrate in bps
+    auto bitrate() const -> int { return m_bitrate; }
+    // duration of last stall in ms
+    auto latency() const -> int { return m_latency; }
 signals:
     void sizeChanged(int size);
     void usedChanged(int used);
     void timeChanged(int time);
+    void underrunsChanged(int underruns);
+    void latencyChanged(int latency);
+    void statisticsChanged();
 private:
     friend class PlayEngine;
     auto setSize(int s) -> void { if (_Change(m_size, s)) emit sizeChanged(s); }
-    auto setUsed(int s) -> void { if (_Change(m_used, s)) emit usedChanged(s); }
+    auto setUsed(int s) -> void;
+    auto setBitrate(int bps) -> void;
+    auto setStalled(bool stalled) -> void;
+    auto resetStatistics() -> void;
+    auto updateStatistics() -> void;
     Q_INVOKABLE void setTime(int s)
         { if (_Change(m_time, s)) emit timeChanged(s); }
     int m_size = 0, m_used = 0, m_time = 0;
+    int m_underruns = 0, m_bitrate = 0, m_latency = 0;
+    double m_fillRate = 0.0, m_throughput = 0.0;
+    SpeedMeasure<qint64> m_measure{3, 20};
+    QElapsedTimer m_stall;
 };
 
 #endif // MEDIAMISC_HPP
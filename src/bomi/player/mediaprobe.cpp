@@ -0,0 +1,215 @@
+#include "mediaprobe.hpp"
+#include "mrl.hpp"
+#include "misc/log.hpp"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+DECLARE_LOG_CONTEXT(MediaProbe)
+
+static auto check(const QSqlQuery &query) -> bool
+{
+    if (!query.lastError().isValid())
+        return true;
+    _Error("Error on query: %% for %%"
+           , query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+auto MediaProbe::toJson() const -> QJsonObject
+{
+    QJsonObject json;
+    json.insert(u"duration"_q, duration);
+    json.insert(u"chapters"_q, chapters);
+    json.insert(u"title"_q, title);
+    json.insert(u"video"_q, video.toJson());
+    json.insert(u"audio"_q, audio.toJson());
+    json.insert(u"subtitle"_q, subtitle.toJson());
+    return json;
+}
+
+auto MediaProbe::setFromJson(const QJsonObject &json) -> bool
+{
+    duration = json[u"duration"_q].toInt(-1);
+    chapters = json[u"chapters"_q].toInt();
+    title = json[u"title"_q].toString();
+    return video.setFromJson(json[u"video"_q].toObject())
+            & audio.setFromJson(json[u"audio"_q].toObject())
+            & subtitle.setFromJson(json[u"subtitle"_q].toObject());
+}
+
+struct FileKey {
+    QString path;
+    qint64 size = -1, mtime = -1;
+    auto isValid() const -> bool { return size >= 0; }
+    static auto from(const Mrl &mrl) -> FileKey
+    {
+        FileKey key;
+        if (!mrl.isLocalFile())
+            return key;
+        const QFileInfo info(mrl.toLocalFile());
+        if (!info.isFile())
+            return key;
+        key.path = info.absoluteFilePath();
+        key.size = info.size();
+        key.mtime = info.lastModified().toMSecsSinceEpoch();
+        return key;
+    }
+};
+
+struct MediaProbeCache::Data {
+    QSqlDatabase db;
+    QSqlQuery finder, writer, keyFinder, keyWriter, overviewFinder, overviewWriter;
+    // results of this session including misses, views ask for same rows often
+    mutable QHash<QString, MediaProbe> memo;
+};
+
+MediaProbeCache::MediaProbeCache()
+    : d(new Data)
+{
+    d->db = QSqlDatabase::addDatabase(u"QSQLITE"_q, u"media-probe"_q);
+    d->db.setDatabaseName(_WritablePath(Location::Cache) % "/mediaprobe.db"_a);
+    if (!d->db.open()) {
+        _Error("Error: %%. Couldn't create database.", d->db.lastError().text());
+        return;
+    }
+    QSqlQuery query(d->db);
+    query.exec(u"PRAGMA journal_mode = WAL"_q);
+    query.exec(u"CREATE TABLE IF NOT EXISTS probe (path TEXT PRIMARY KEY NOT NULL, "
+                "size INTEGER, mtime INTEGER, info BLOB)"_q);
+    check(query);
+    query.exec(u"CREATE TABLE IF NOT EXISTS keyframe (path TEXT PRIMARY KEY NOT NULL, "
+                "size INTEGER, mtime INTEGER, times BLOB)"_q);
+    check(query);
+    query.exec(u"CREATE TABLE IF NOT EXISTS overview (path TEXT PRIMARY KEY NOT NULL, "
+                "size INTEGER, mtime INTEGER, data BLOB)"_q);
+    check(query);
+    d->finder = QSqlQuery(d->db);
+    d->finder.prepare(u"SELECT info FROM probe WHERE path = ? AND size = ? AND mtime = ?"_q);
+    d->writer = QSqlQuery(d->db);
+    d->writer.prepare(u"INSERT OR REPLACE INTO probe (path, size, mtime, info) "
+                       "VALUES (?, ?, ?, ?)"_q);
+    d->keyFinder = QSqlQuery(d->db);
+    d->keyFinder.prepare(u"SELECT times FROM keyframe "
+                          "WHERE path = ? AND size = ? AND mtime = ?"_q);
+    d->keyWriter = QSqlQuery(d->db);
+    d->keyWriter.prepare(u"INSERT OR REPLACE INTO keyframe (path, size, mtime, times) "
+                          "VALUES (?, ?, ?, ?)"_q);
+    d->overviewFinder = QSqlQuery(d->db);
+    d->overviewFinder.prepare(u"SELECT data FROM overview "
+                               "WHERE path = ? AND size = ? AND mtime = ?"_q);
+    d->overviewWriter = QSqlQuery(d->db);
+    d->overviewWriter.prepare(u"INSERT OR REPLACE INTO overview (path, size, mtime, data) "
+                               "VALUES (?, ?, ?, ?)"_q);
+}
+
+MediaProbeCache::~MediaProbeCache()
+{
+    const auto name = d->db.connectionName();
+    d->finder = d->writer = d->keyFinder = d->keyWriter = QSqlQuery();
+    d->overviewFinder = d->overviewWriter = QSqlQuery();
+    d->db.close();
+    d->db = QSqlDatabase();
+    delete d;
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto MediaProbeCache::find(const Mrl &mrl) const -> MediaProbe
+{
+    if (!mrl.isLocalFile() || !d->db.isOpen())
+        return MediaProbe();
+    auto it = d->memo.constFind(mrl.toLocalFile());
+    if (it != d->memo.cend())
+        return *it;
+    MediaProbe probe;
+    const auto key = FileKey::from(mrl);
+    if (key.isValid()) {
+        d->finder.bindValue(0, key.path);
+        d->finder.bindValue(1, key.size);
+        d->finder.bindValue(2, key.mtime);
+        if (d->finder.exec() && d->finder.next()) {
+            const auto data = d->finder.value(0).toByteArray();
+            const auto doc = QJsonDocument::fromBinaryData(data);
+            if (!probe.setFromJson(doc.object()))
+                probe = MediaProbe();
+        }
+        check(d->finder);
+        d->finder.finish();
+    }
+    d->memo.insert(mrl.toLocalFile(), probe);
+    return probe;
+}
+
+auto MediaProbeCache::store(const Mrl &mrl, const MediaProbe &probe) -> void
+{
+    if (!probe.isValid() || !d->db.isOpen())
+        return;
+    const auto key = FileKey::from(mrl);
+    if (!key.isValid())
+        return;
+    d->writer.bindValue(0, key.path);
+    d->writer.bindValue(1, key.size);
+    d->writer.bindValue(2, key.mtime);
+    d->writer.bindValue(3, QJsonDocument(probe.toJson()).toBinaryData());
+    d->writer.exec();
+    check(d->writer);
+    d->memo.insert(mrl.toLocalFile(), probe);
+}
+
+auto MediaProbeCache::findKeyframes(const Mrl &mrl) const -> KeyframeIndex
+{
+    KeyframeIndex index;
+    const auto key = FileKey::from(mrl);
+    if (!key.isValid() || !d->db.isOpen())
+        return index;
+    d->keyFinder.bindValue(0, key.path);
+    d->keyFinder.bindValue(1, key.size);
+    d->keyFinder.bindValue(2, key.mtime);
+    if (d->keyFinder.exec() && d->keyFinder.next())
+        index = KeyframeIndex::fromByteArray(d->keyFinder.value(0).toByteArray());
+    check(d->keyFinder);
+    d->keyFinder.finish();
+    return index;
+}
+
+auto MediaProbeCache::storeKeyframes(const Mrl &mrl, const KeyframeIndex &index) -> void
+{
+    const auto key = FileKey::from(mrl);
+    if (index.isEmpty() || !key.isValid() || !d->db.isOpen())
+        return;
+    d->keyWriter.bindValue(0, key.path);
+    d->keyWriter.bindValue(1, key.size);
+    d->keyWriter.bindValue(2, key.mtime);
+    d->keyWriter.bindValue(3, index.toByteArray());
+    d->keyWriter.exec();
+    check(d->keyWriter);
+}
+
+auto MediaProbeCache::findOverview(const Mrl &mrl) const -> AudioOverview
+{
+    AudioOverview overview;
+    const auto key = FileKey::from(mrl);
+    if (!key.isValid() || !d->db.isOpen())
+        return overview;
+    d->overviewFinder.bindValue(0, key.path);
+    d->overviewFinder.bindValue(1, key.size);
+    d->overviewFinder.bindValue(2, key.mtime);
+    if (d->overviewFinder.exec() && d->overviewFinder.next())
+        overview = AudioOverview::fromByteArray(d->overviewFinder.value(0).toByteArray());
+    check(d->overviewFinder);
+    d->overviewFinder.finish();
+    return overview;
+}
+
+auto MediaProbeCache::storeOverview(const Mrl &mrl, const AudioOverview &overview) -> void
+{
+    const auto key = FileKey::from(mrl);
+    if (overview.isEmpty() || !key.isValid() || !d->db.isOpen())
+        return;
+    d->overviewWriter.bindValue(0, key.path);
+    d->overviewWriter.bindValue(1, key.size);
+    d->overviewWriter.bindValue(2, key.mtime);
+    d->overviewWriter.bindValue(3, overview.toByteArray());
+    d->overviewWriter.exec();
+    check(d->overviewWriter);
+}
@@ -0,0 +1,40 @@
+#ifndef MEDIAPROBE_HPP
+#define MEDIAPROBE_HPP
+
+#include "streamtrack.hpp"
+#include "keyframeindex.hpp"
+#include "audiooverview.hpp"
+
+class Mrl;
+
+// what demuxer found in a file, so views don't have to open it again
+struct MediaProbe {
+    int duration = -1; // ms
+    int chapters = 0;
+    QString title;
+    StreamList video{StreamVideo}, audio{StreamAudio}, subtitle{StreamSubtitle};
+    auto isValid() const -> bool { return duration >= 0; }
+    auto toJson() const -> QJsonObject;
+    auto setFromJson(const QJsonObject &json) -> bool;
+};
+
+// persistent probe results of local files keyed by path, size and mtime
+// changed files are missed and probed again on next playback
+class MediaProbeCache {
+public:
+    MediaProbeCache();
+    MediaProbeCache(const MediaProbeCache &) = delete;
+    MediaProbeCache &operator = (const MediaProbeCache &) = delete;
+    ~MediaProbeCache();
+    auto find(const Mrl &mrl) const -> MediaProbe;
+    auto store(const Mrl &mrl, const MediaProbe &probe) -> void;
+    auto findKeyframes(const Mrl &mrl) const -> KeyframeIndex;
+    auto storeKeyframes(const Mrl &mrl, const KeyframeIndex &index) -> void;
+    auto findOverview(const Mrl &mrl) const -> AudioOverview;
+    auto storeOverview(const Mrl &mrl, const AudioOverview &overview) -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // MEDIAPROBE_HPP
@@ -57,24 +57,61 @@ static auto sendPropertiesChanged(const QDBusAbstractAdaptor *adaptor,
     QDBusConnection::sessionBus().send(sig);
 }
 
-SIA sendPropertiesChanged(const QDBusAbstractAdaptor *adaptor,
-                          const char *property, const QVariant &value) -> void
-{
-    QVariantMap props;
-    props.insert(_L(property), value);
-    sendPropertiesChanged(adaptor, props);
-}
+// merges changes of an interface into one signal per event loop iteration
+// and drops values which clients already know
+class ChangeBatch {
+public:
+    ChangeBatch(const QDBusAbstractAdaptor *adaptor)
+        : m_adaptor(adaptor)
+    {
+        m_timer.setSingleShot(true);
+        m_timer.setInterval(0);
+        QObject::connect(&m_timer, &QTimer::timeout, [this] () { flush(); });
+    }
+    auto insert(const char *property, const QVariant &value) -> void
+    {
+        m_pending.insert(_L(property), value);
+        if (!m_timer.isActive())
+            m_timer.start();
+    }
+    auto insert(const QVariantMap &properties) -> void
+    {
+        for (auto it = properties.begin(); it != properties.end(); ++it)
+            m_pending.insert(it.key(), it.value());
+        if (!m_timer.isActive())
+            m_timer.start();
+    }
+private:
+    auto flush() -> void
+    {
+        for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+            auto sent = m_sent.find(it.key());
+            if (sent != m_sent.end() && *sent == *it)
+                it = m_pending.erase(it);
+            else
+                m_sent[it.key()] = *it++;
+        }
+        if (!m_pending.isEmpty())
+            sendPropertiesChanged(m_adaptor, m_pending);
+        m_pending.clear();
+    }
+    const QDBusAbstractAdaptor *m_adaptor = nullptr;
+    QVariantMap m_pending, m_sent;
+    QTimer m_timer;
+};
 
 struct MediaPlayer2::Data {
+    Data(const QDBusAbstractAdaptor *adaptor): changes(adaptor) { }
     MainWindow *mw = nullptr;
+    ChangeBatch changes;
 };
 
 MediaPlayer2::MediaPlayer2(QObject *parent)
-: QDBusAbstractAdaptor(parent), d(new Data) {
+: QDBusAbstractAdaptor(parent), d(new Data(this)) {
     d->mw = cApp.mainWindow();
     Q_ASSERT(d->mw);
     connect(d->mw, &MainWindow::fullscreenChanged,
-            [this] (bool fs) { sendPropertiesChanged(this, "Fullscreen", fs); });
+            [this] (bool fs) { d->changes.insert("Fullscreen", fs); });
 }
 
 MediaPlayer2::~MediaPlayer2() {
@@ -183,12 +220,16 @@ private:
 };
 
 struct Player::Data {
+    Data(const QDBusAbstractAdaptor *adaptor): changes(adaptor) { }
+    ChangeBatch changes;
     double volume = 1.0;
     MainWindow *mw = nullptr;
     PlayEngine *engine = nullptr;
     PlaylistModel *playlist = nullptr;
     QString playbackStatus, albumArt;
     QVariantMap metaData;
+    // source of metaData to skip serialization if nothing changed
+    struct { MetaData md; QString art, name; } source;
     Thread thread;
     struct {
         QTimer timer;
@@ -228,7 +269,7 @@ struct Player::Data {
 
 Player::Player(QObject *parent)
     : QDBusAbstractAdaptor(parent)
-    , d(new Data)
+    , d(new Data(this))
 {
     d->thread.p = this;
     d->thread.start();
@@ -238,6 +279,7 @@ Player::Player(QObject *parent)
 
     d->playbackStatus = d->toDBus(d->engine->state());
     d->volume = d->engine->volume();
+    d->source = { d->engine->metaData(), d->albumArt, d->engine->media()->name() };
     d->metaData = d->toDBus(d->engine->metaData());
     connect(d->engine, &PlayEngine::metaDataChanged, this, &Player::updateMetaData);
     connect(d->engine, &PlayEngine::stateChanged, this,
@@ -246,25 +288,27 @@ Player::Player(QObject *parent)
         QVariantMap map;
         map[u"PlaybackStatus"_q] = d->playbackStatus;
         map[u"CanPause"_q] = map[u"CanPlay"_q] = state != PlayEngine::Error;
-        sendPropertiesChanged(this, map);
+        d->changes.insert(map);
     });
+    // clients extrapolate position from Rate, so only Seeked is sent for it
     connect(d->engine, &PlayEngine::speedChanged, this, [this] () {
-        sendPropertiesChanged(this, "Rate", d->engine->speed());
+        d->changes.insert("Rate", d->engine->speed());
     });
     auto checkNextPrevious = [this] () {
         QVariantMap map;
         map[u"CanGoNext"_q] = d->playlist->hasNext();
         map[u"CanGoPrevious"_q] = d->playlist->hasPrevious();
-        sendPropertiesChanged(this, map);
+        d->changes.insert(map);
     };
     connect(d->playlist, &PlaylistModel::loadedChanged,
             this, checkNextPrevious);
     connect(d->engine, &PlayEngine::seekableChanged, this,
             [this] (bool seekable) {
-        sendPropertiesChanged(this, "CanSeek", seekable);
+        d->changes.insert("CanSeek", seekable);
     });
     connect(d->engine, &PlayEngine::volumeChanged, this, [=] () {
-        sendPropertiesChanged(this, "volume", d->engine->volume());
+        d->volume = d->engine->volume();
+        d->changes.insert("Volume", d->volume);
     });
     connect(d->engine, &PlayEngine::sought, this,
             [this] () { emit Seeked(time()); });
@@ -436,8 +480,14 @@ auto Player::SetPosition(const QDBusObjectPath &track, qint64 position) -> void
 
 auto Player::updateMetaData() -> void
 {
-    d->metaData = d->toDBus(d->engine->metaData());
-    sendPropertiesChanged(this, "Metadata", d->metaData);
+    // serialized once per change of media or album art
+    const auto &md = d->engine->metaData();
+    const auto name = d->engine->media()->name();
+    if (md == d->source.md && d->albumArt == d->source.art && name == d->source.name)
+        return;
+    d->source = { md, d->albumArt, name };
+    d->metaData = d->toDBus(md);
+    d->changes.insert("Metadata", d->metaData);
 }
 
 auto Player::customEvent(QEvent *ev) -> void
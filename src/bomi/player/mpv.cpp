@@ -1,16 +1,21 @@
 #include "mpv.hpp"
 #include "video/mpvosdrenderer.hpp"
+#include "video/rendertiming.hpp"
+#include "misc/tracer.hpp"
+#include "os/os.hpp"
 #include <QOpenGLContext>
 #include <QLibrary>
+#include <atomic>
 
 struct PropertyObservation {
     int event;
     const char *name = nullptr;
-    std::function<void(int)> notify = nullptr;      // post from mpv to qt
+    std::function<void(int, const mpv_event_property*)> notify = nullptr; // post to qt
     std::function<void(QEvent*)> process = nullptr; // handle posted event
 };
 
 static constexpr const int UpdateEventBegin = QEvent::User + 10000;
+static constexpr const int FlushEvent = UpdateEventBegin - 1;
 
 auto Mpv::e2l(int error) -> Log::Level
 {
@@ -31,21 +36,57 @@ struct Mpv::Data {
     Mpv *p = nullptr;
     mpv_opengl_cb_context *gl = nullptr;
     MpvOsdRenderer osd;
+    RenderTiming *timing = nullptr;
     bool quit = false;
+    // set by mpv from any thread whenever events are queued
+    QMutex mutex; QWaitCondition wakeup; bool pending = false;
+    // latest undelivered value of each observation
+    QMutex queueMutex; QVector<QEvent*> queued; bool flushing = false;
     QVector<PropertyObservation> observations;
     QVector<std::function<void(mpv_event*)>> events;
     QMap<QByteArray, std::function<void(void)>> hooks;
     int updateEventMax = ::UpdateEventBegin;
     int hookId = 0;
     std::function<void(void)> update;
+    struct {
+        std::atomic<QThread*> thread{nullptr};
+        // in order of first change, sent properties first
+        QVector<QPair<QByteArray, std::function<void(void)>>> properties, commands;
+    } batch;
     auto observation(int event) -> const PropertyObservation&
     {
         Q_ASSERT(UpdateEventBegin <= event && event < updateEventMax);
         Q_ASSERT(event == observations[event - UpdateEventBegin].event);
         return observations[event - UpdateEventBegin];
     }
+    static auto wake(void *p) -> void
+    {
+        auto d = static_cast<Data*>(p);
+        d->mutex.lock();
+        d->pending = true;
+        d->mutex.unlock();
+        d->wakeup.wakeOne();
+    }
+    auto wait() -> void
+    {
+        mutex.lock();
+        while (!pending)
+            wakeup.wait(&mutex);
+        pending = false;
+        mutex.unlock();
+    }
+    auto takeQueued() -> QVector<QEvent*>
+    {
+        QMutexLocker locker(&queueMutex);
+        QVector<QEvent*> events(queued.size(), nullptr);
+        queued.swap(events);
+        flushing = false;
+        return events;
+    }
     auto reset()
     {
+        qDeleteAll(takeQueued());
+        queued.clear();
         quit = false;
         observations.clear();
         events.clear();
@@ -59,10 +100,12 @@ Mpv::Mpv(QObject *parent)
     : QThread(parent), d(new Data)
 {
     d->p = this;
+    setObjectName(_L(m_logContext));
 }
 
 Mpv::~Mpv()
 {
+    qDeleteAll(d->takeQueued());
     delete d;
 }
 
@@ -81,8 +124,9 @@ auto Mpv::initialize(Log::Level lv, bool ogl) -> void
 {
     Q_ASSERT(m_handle && !d->gl);
 
+    // mpv should not produce lines which no output takes
     QByteArray loglv = "no";
-    switch (lv) {
+    switch (std::min(lv, Log::maximumLevel())) {
     case Log::Trace: loglv = "trace"; break;
     case Log::Debug: loglv = "v";     break;
     case Log::Info:  loglv = "info";  break;
@@ -116,6 +160,55 @@ auto Mpv::update() -> void
         d->update();
 }
 
+auto Mpv::begin() -> void
+{
+    Q_ASSERT(!d->batch.thread);
+    d->batch.thread = QThread::currentThread();
+}
+
+auto Mpv::commit() -> void
+{
+    Q_ASSERT(d->batch.thread == QThread::currentThread());
+    d->batch.thread = nullptr;
+    auto properties = std::move(d->batch.properties);
+    auto commands = std::move(d->batch.commands);
+    d->batch.properties.clear();
+    d->batch.commands.clear();
+    for (auto &one : properties)
+        one.second();
+    for (auto &one : commands)
+        one.second();
+    _Trace("Committed %% properties and %% commands.", properties.size(), commands.size());
+}
+
+auto Mpv::cancel(const QByteArray &command) -> void
+{
+    auto &list = d->batch.commands;
+    for (int i = 0; i < list.size(); ++i) {
+        if (list[i].first == command) {
+            list.remove(i);
+            return;
+        }
+    }
+}
+
+auto Mpv::defer(bool command, const QByteArray &name, func<void> &&send) -> bool
+{
+    if (d->batch.thread != QThread::currentThread())
+        return false;
+    // names from literals carry terminating null
+    const QByteArray key(name.constData(), qstrnlen(name.constData(), name.size()));
+    auto &list = command ? d->batch.commands : d->batch.properties;
+    for (auto &one : list) {
+        if (one.first == key) {
+            one.second = std::move(send);
+            return true;
+        }
+    }
+    list.push_back(qMakePair(key, std::move(send)));
+    return true;
+}
+
 auto Mpv::setUpdateCallback(std::function<void ()> &&cb) -> void
 {
     Q_ASSERT(cb);
@@ -128,9 +221,11 @@ auto Mpv::render(OpenGLFramebufferObject *frame, OpenGLFramebufferObject *osd, c
 {
     int ret = 0;
     if (frame) {
+        RenderTimingScope scope(d->timing, RenderTiming::Video);
         ret = mpv_opengl_cb_draw(d->gl, frame->id(), frame->width(), frame->height());
     }
     if (osd) {
+        RenderTimingScope scope(d->timing, RenderTiming::Osd);
         d->osd.prepare(osd);
         mpv_opengl_cb_render_osd(d->gl, osd->width(), osd->height(),
                                  m.left(), m.top(), m.right(), m.bottom(),
@@ -143,6 +238,25 @@ auto Mpv::render(OpenGLFramebufferObject *frame, OpenGLFramebufferObject *osd, c
 auto Mpv::frameSwapped() -> void
 {
     mpv_opengl_cb_report_flip(d->gl, 0);
+    if (d->timing)
+        d->timing->swapped();
+}
+
+auto Mpv::framePts(double &pts) const -> bool
+{
+    if (!d->gl)
+        return false;
+    const double value = mpv_opengl_cb_get_frame_pts(d->gl);
+    // MP_NOPTS_VALUE for no frame
+    if (value < -1e30)
+        return false;
+    pts = value;
+    return true;
+}
+
+auto Mpv::setRenderTiming(RenderTiming *timing) -> void
+{
+    d->timing = timing;
 }
 
 auto Mpv::initializeGL(QOpenGLContext *ctx) -> void
@@ -161,10 +275,14 @@ auto Mpv::initializeGL(QOpenGLContext *ctx) -> void
     auto err = mpv_opengl_cb_init_gl(d->gl, nullptr, getProcAddr, ctx);
     Q_UNUSED(err); Q_ASSERT(err >= 0);
     d->osd.initialize();
+    if (d->timing)
+        d->timing->initializeGL();
 }
 
 auto Mpv::finalizeGL() -> void
 {
+    if (d->timing)
+        d->timing->finalizeGL();
     d->osd.finalize();
     mpv_opengl_cb_uninit_gl(d->gl);
 }
@@ -184,8 +302,8 @@ auto Mpv::request(mpv_event_id id, std::function<void(mpv_event*)> &&proc) -> vo
     d->events[id] = std::move(proc);
 }
 
-auto Mpv::newObservation(const char *name, std::function<void(int)> &&notify,
-                  std::function<void(QEvent*)> &&process) -> int
+auto Mpv::newObservation(const char *name, mpv_format format, Notify &&notify,
+                         std::function<void(QEvent*)> &&process) -> int
 {
     const int event = d->updateEventMax++;
     PropertyObservation ob;
@@ -194,8 +312,12 @@ auto Mpv::newObservation(const char *name, std::function<void(int)> &&notify,
     ob.notify = std::move(notify);
     ob.process = std::move(process);
     d->observations.append(ob);
+    d->queueMutex.lock();
+    d->queued.append(nullptr);
+    d->queueMutex.unlock();
     Q_ASSERT(d->observations.size() == d->updateEventMax - UpdateEventBegin);
-    mpv_observe_property(m_handle, ob.event, ob.name, MPV_FORMAT_NONE);
+    // with a format, mpv sends the value so no get-after-notify is needed
+    mpv_observe_property(m_handle, ob.event, ob.name, format);
     return event;
 }
 
@@ -215,77 +337,114 @@ auto Mpv::run() -> void
 {
     _Debug("Start playloop thread");
     d->quit = false;
+    // events queued before callback are picked up by first drain
+    d->pending = true;
+    mpv_set_wakeup_callback(m_handle, Data::wake, d);
+    OS::ThreadClassKeeper scheduling(OS::ThreadClass::Playback);
     while (!d->quit) {
-        auto ev = mpv_wait_event(m_handle, 0.005);
-        switch (ev->event_id) {
-        case MPV_EVENT_NONE:
-            break;
-        case MPV_EVENT_PROPERTY_CHANGE: {
-            auto &o = d->observation(ev->reply_userdata);
-            o.notify(o.event);
-            break;
-        } case MPV_EVENT_LOG_MESSAGE: {
-            auto msg = static_cast<mpv_event_log_message*>(ev->data);
-            if (msg->log_level == MPV_LOG_LEVEL_NONE)
+        d->wait();
+        scheduling.keep();
+        for (;;) {
+            auto ev = mpv_wait_event(m_handle, 0);
+            if (ev->event_id == MPV_EVENT_NONE)
+                break;
+            TRACE_SCOPE(mpv_event_name(ev->event_id));
+            switch (ev->event_id) {
+            case MPV_EVENT_PROPERTY_CHANGE: {
+                auto &o = d->observation(ev->reply_userdata);
+                o.notify(o.event, static_cast<mpv_event_property*>(ev->data));
+                break;
+            } case MPV_EVENT_LOG_MESSAGE: {
+                auto msg = static_cast<mpv_event_log_message*>(ev->data);
+                if (msg->log_level == MPV_LOG_LEVEL_NONE)
+                    break;
+                auto getLevel = [&]() {
+                    switch (msg->log_level) {
+                    case MPV_LOG_LEVEL_TRACE: return Log::Trace;
+                    case MPV_LOG_LEVEL_V:
+                    case MPV_LOG_LEVEL_DEBUG: return Log::Debug;
+                    case MPV_LOG_LEVEL_INFO:  return Log::Info;
+                    case MPV_LOG_LEVEL_WARN:  return Log::Warn;
+                    default:                  return Log::Error;
+                    }
+                };
+                const auto lv = getLevel();
+                if (lv <= Log::maximumLevel())
+                    Log::print(lv, Log::parse(lv, m_logContext + '/' + msg->prefix, msg->text));
+                break;
+            } case MPV_EVENT_CLIENT_MESSAGE: {
+                auto message = static_cast<mpv_event_client_message*>(ev->data);
+                if (message->num_args < 1)
+                    break;
+                if (!qstrcmp(message->args[0], "hook_run") && message->num_args == 3) {
+                    QByteArray when(message->args[2]);
+                    Q_ASSERT(d->hooks.contains(when));
+                    d->hooks[when]();
+                    tell("hook_ack", when);
+                }
                 break;
-            auto getLevel = [&]() {
-                switch (msg->log_level) {
-                case MPV_LOG_LEVEL_TRACE: return Log::Trace;
-                case MPV_LOG_LEVEL_V:
-                case MPV_LOG_LEVEL_DEBUG: return Log::Debug;
-                case MPV_LOG_LEVEL_INFO:  return Log::Info;
-                case MPV_LOG_LEVEL_WARN:  return Log::Warn;
-                default:                  return Log::Error;
+            } case MPV_EVENT_SET_PROPERTY_REPLY: {
+                QScopedPointer<QByteArray> name(reinterpret_cast<QByteArray*>(ev->reply_userdata));
+                if (!isSuccess(ev->error)) {
+                    _Debug("Error %%: Couldn't set property %%.",
+                           mpv_error_string(ev->error), *name);
                 }
-            };
-            const auto lv = getLevel();
-            Log::print(lv, Log::parse(lv, m_logContext + '/' + msg->prefix, msg->text));
-            break;
-        } case MPV_EVENT_CLIENT_MESSAGE: {
-            auto message = static_cast<mpv_event_client_message*>(ev->data);
-            if (message->num_args < 1)
                 break;
-            if (!qstrcmp(message->args[0], "hook_run") && message->num_args == 3) {
-                QByteArray when(message->args[2]);
-                Q_ASSERT(d->hooks.contains(when));
-                d->hooks[when]();
-                tell("hook_ack", when);
-            }
-            break;
-        } case MPV_EVENT_SET_PROPERTY_REPLY: {
-            QScopedPointer<QByteArray> name(reinterpret_cast<QByteArray*>(ev->reply_userdata));
-            if (!isSuccess(ev->error)) {
-                _Debug("Error %%: Couldn't set property %%.",
-                       mpv_error_string(ev->error), *name);
-            }
-            break;
-        } case MPV_EVENT_COMMAND_REPLY: {
-            QScopedPointer<QByteArray> name(reinterpret_cast<QByteArray*>(ev->reply_userdata));
-            if (!isSuccess(ev->error)) {
-                _Debug("Error %%: Couldn't execute command %%.",
-                       mpv_error_string(ev->error), *name);
-            }
-            break;
-        } case MPV_EVENT_GET_PROPERTY_REPLY: {
-            auto event = static_cast<mpv_event_property*>(ev->data);
-            _Error("Never requested reply: %%", event->name);
-            break;
-        } case MPV_EVENT_SHUTDOWN:
-            d->quit = true;
-            break;
-        default: {
-            if (ev->event_id >= d->events.size())
+            } case MPV_EVENT_COMMAND_REPLY: {
+                QScopedPointer<AsyncReply> reply(reinterpret_cast<AsyncReply*>(ev->reply_userdata));
+                if (!isSuccess(ev->error)) {
+                    _Debug("Error %%: Couldn't execute command %%.",
+                           mpv_error_string(ev->error), reply->name);
+                }
+                if (reply->done)
+                    reply->done(isSuccess(ev->error));
+                break;
+            } case MPV_EVENT_GET_PROPERTY_REPLY: {
+                auto event = static_cast<mpv_event_property*>(ev->data);
+                _Error("Never requested reply: %%", event->name);
+                break;
+            } case MPV_EVENT_SHUTDOWN:
+                d->quit = true;
                 break;
-            if (auto &proc = d->events[ev->event_id])
-                proc(ev);
-        }}
+            default: {
+                if (ev->event_id >= d->events.size())
+                    break;
+                if (auto &proc = d->events[ev->event_id])
+                    proc(ev);
+            }}
+            if (d->quit)
+                break;
+        }
     }
+    mpv_set_wakeup_callback(m_handle, nullptr, nullptr);
     _Debug("Finish playloop thread");
 }
 
+auto Mpv::queue(QEvent *event) -> void
+{
+    const int index = event->type() - UpdateEventBegin;
+    QMutexLocker locker(&d->queueMutex);
+    Q_ASSERT(0 <= index && index < d->queued.size());
+    delete d->queued[index];
+    d->queued[index] = event;
+    if (!d->flushing) {
+        d->flushing = true;
+        _PostEvent(m_observer, FlushEvent);
+    }
+}
+
 auto Mpv::process(QEvent *event) -> bool
 {
     const int type = event->type();
+    if (type == FlushEvent) {
+        // one pass in observation order, so qml sees a consistent state
+        for (auto ev : d->takeQueued()) {
+            if (ev)
+                d->observation(ev->type()).process(ev);
+            delete ev;
+        }
+        return true;
+    }
     if (UpdateEventBegin <= type && type < d->updateEventMax) {
         d->observation(type).process(event);
         return true;
@@ -10,7 +10,7 @@
 #include <functional>
 
 class QOpenGLContext;
-class OpenGLFramebufferObject;
+class OpenGLFramebufferObject;          class RenderTiming;
 
 SCIA s2ms(double s) -> int { return s*1000 + 0.5; }
 
@@ -31,7 +31,9 @@ public:
     Mpv(QObject *parent = nullptr);
     ~Mpv();
 
-    auto setLogContext(const QByteArray &lctx) -> void { m_logContext = lctx; }
+    // also names event thread, so do it before start
+    auto setLogContext(const QByteArray &lctx) -> void
+        { m_logContext = lctx; setObjectName(_L(lctx)); }
     auto getLogContext() const -> const char* { return m_logContext.constData(); }
 
     auto handle() const -> mpv_handle* { return m_handle; }
@@ -69,7 +71,19 @@ public:
     auto tellAsync(const char (&name)[N], const Args&... args) -> bool;
     template<class... Args>
     auto tellAsync(QByteArray &&name, const Args&... args) -> bool;
+    // done is called in mpv thread with whether command succeeded
+    template<int N, class... Args>
+    auto tellAsyncThen(func<void, bool> &&done, const char (&name)[N],
+                       const Args&... args) -> bool;
     auto flush() { mpv_wait_async_requests(m_handle); }
+    // until commit(), setAsync() and tellAsync() without arguments from this
+    // thread are held: last value of each property wins, each command once
+    auto begin() -> void;
+    auto commit() -> void;
+    // drop held command, e.g. ao_reload which reloading file covers
+    template<int N>
+    auto cancel(const char (&name)[N]) -> void { cancel(QByteArray(name, N - 1)); }
+    auto cancel(const QByteArray &command) -> void;
 
     auto setObserver(QObject *observer) -> void { m_observer = observer; }
     template<class Get, class Set>
@@ -94,6 +108,10 @@ public:
     auto initializeGL(QOpenGLContext *ctx) -> void;
     auto finalizeGL() -> void;
     auto frameSwapped() -> void;
+    // pts in seconds of frame drawn by last render(), false if none
+    auto framePts(double &pts) const -> bool;
+    // time video and osd passes, set before initializeGL()
+    auto setRenderTiming(RenderTiming *timing) -> void;
 private:
     static auto e2s(int error) -> const char* { return mpv_error_string(error); }
     static auto e2l(int error) -> Log::Level;
@@ -102,6 +120,11 @@ private:
     template<class T>
     auto _setAsync(QByteArray &&name, const T &value) -> bool;
     auto run() -> void override;
+    struct AsyncReply { QByteArray name; func<void, bool> done; };
+    // false if not in batch of this thread
+    auto defer(bool command, const QByteArray &name, func<void> &&send) -> bool;
+    template<class... Args>
+    auto _tellAsync(AsyncReply *reply, const Args&... args) -> bool;
     auto fill(mpv_node *) { }
     template<class T, class... Args>
     auto fill(mpv_node *it, const T &t, const Args&... args)
@@ -123,8 +146,29 @@ private:
         int error = f(&node);
         return MPV_CHECK(error, "execute %%", name);
     }
-    auto newObservation(const char *name, std::function<void(int)> &&notify,
+    // values are coalesced per property and flushed by one event
+    template<class T>
+    auto post(int event, const T &t) -> void { queue(new DataEvent<T>(event, t)); }
+    auto queue(QEvent *event) -> void;
+    using Notify = std::function<void(int, const mpv_event_property*)>;
+    auto newObservation(const char *name, mpv_format format, Notify &&notify,
                         std::function<void(QEvent*)> &&process) -> int;
+    // value carried by property-change event, which is owned by the event
+    template<class T>
+    static auto decode(const mpv_event_property *prop) -> T
+    {
+        T t = T();
+        if (prop->format == trait<T>::format && prop->data)
+            trait<T>::get(t, *static_cast<const type<T>*>(prop->data));
+        return t;
+    }
+    template<class T, class Set>
+    auto observeTyped(const char *name, Set set) -> int
+    {
+        return newObservation(name, trait<T>::format,
+            [=] (int e, const mpv_event_property *p) { post(e, decode<T>(p)); },
+            [=] (QEvent *event) { set(_MoveData<T>(event)); });
+    }
     struct Data; Data *d;
     mpv_handle *m_handle = nullptr;
     QObject *m_observer = nullptr;
@@ -156,6 +200,8 @@ auto Mpv::_setAsync(QByteArray &&name, const T &value) -> bool
 {
     static_assert(!is_string<T>(), "!!!");
     Q_ASSERT(m_handle);
+    if (defer(false, name, [=] () { _setAsync(QByteArray(name), value); }))
+        return true;
     auto user = new QByteArray(std::move(name));
     MpvSetScopedData<T> data(value);
     int error = mpv_set_property_async(m_handle, (quint64)user,
@@ -186,12 +232,30 @@ auto Mpv::tell(const char (&name)[N], const Args&... args) -> bool
     { return tell(QByteArray::fromRawData(name, N), args...); }
 
 template<class... Args>
-auto Mpv::tellAsync(QByteArray &&name, const Args&... args) -> bool
+auto Mpv::_tellAsync(AsyncReply *reply, const Args&... args) -> bool
 {
-    return command(std::move(name), [&] (auto *node) {
-        auto user = new QByteArray(std::move(name));
-        return mpv_command_node_async(m_handle, (quint64)user, node);
+    const bool ok = command(QByteArray(reply->name), [&] (auto *node) {
+        return mpv_command_node_async(m_handle, (quint64)reply, node);
     }, pass(args)...);
+    if (!ok)
+        delete reply;
+    return ok;
+}
+
+template<class... Args>
+auto Mpv::tellAsync(QByteArray &&name, const Args&... args) -> bool
+{
+    if (!sizeof...(args) && defer(true, name, [=] () { tellAsync(QByteArray(name)); }))
+        return true;
+    return _tellAsync(new AsyncReply{std::move(name), nullptr}, args...);
+}
+
+template<int N, class... Args>
+auto Mpv::tellAsyncThen(func<void, bool> &&done, const char (&name)[N],
+                        const Args&... args) -> bool
+{
+    auto reply = new AsyncReply{QByteArray::fromRawData(name, N), std::move(done)};
+    return _tellAsync(reply, args...);
 }
 
 template<int N, class... Args>
@@ -202,35 +266,37 @@ template<class Get, class Set>
 auto Mpv::observe(const char *name, Get get, Set set) -> tmp::enable_if_callable_t<Get, int>
 {
     using T = tmp::remove_cref_t<decltype(get())>;
-    return newObservation(name, [=] (int e) { _PostEvent(m_observer, e, get()); },
+    return newObservation(name, MPV_FORMAT_NONE,
+                          [=] (int e, const mpv_event_property*) { post(e, get()); },
                           [=] (QEvent *event) { set(_MoveData<T>(event)); });
 }
 
 template<class T, class Update>
 auto Mpv::observe(const char *name, T &t, Update update) -> tmp::enable_unless_callable_t<T, int>
 {
-    return observe(name, [=] () { return get<T>(name); },
-                   [=, &t] (T &&v) { if (_Change(t, v)) update(); });
+    return observeTyped<T>(name, [=, &t] (T &&v) { if (_Change(t, v)) update(); });
 }
 
 template<class Update>
 auto Mpv::observeTime(const char *name, int &t, Update update) -> int
 {
-    return observe(name, [=] () { return s2ms(get<double>(name)); },
-                   [=, &t] (int &&v) { if (_Change(t, v)) update(); });
+    return observeTyped<double>(name, [=, &t] (double &&v)
+        { if (_Change(t, s2ms(v))) update(); });
 }
 
 template<class Set>
 auto Mpv::observe(const char *name, Set set) -> int {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Set, 0>>;
-    return observe(name, [=] () { return get<T>(name); }, set);
+    return observeTyped<T>(name, set);
 }
 
 template<class Check>
 auto Mpv::observeState(const char *name, Check ck) -> int
 {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Check, 0>>;
-    return newObservation(name, [=] (int) { ck(get<T>(name)); }, [](QEvent*){});
+    return newObservation(name, trait<T>::format,
+                          [=] (int, const mpv_event_property *p) { ck(decode<T>(p)); },
+                          [](QEvent*){});
 }
 
 #endif // MPV_HPP
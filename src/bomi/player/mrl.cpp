@@ -5,27 +5,49 @@
 
 Mrl::Mrl(const QUrl &url) {
     if (url.isLocalFile())
-        m_loc = "file://"_a % url.toLocalFile();
+        setLocation("file://"_a % url.toLocalFile());
     else
-        m_loc = url.toString();
+        setLocation(url.toString());
 }
 
 Mrl::Mrl(const QString &location, const QString &name) {
     if (location.isEmpty())
         return;
-    m_loc = location;
+    setLocation(location);
     const int idx = location.indexOf("://"_a);
     if (idx < 0)
-        m_loc = "file://"_a % _ToAbsFilePath(location);
-    else if (startsWith("file://"_a))
-        m_loc = QUrl::fromPercentEncoding(location.toUtf8());
-    else if (startsWith("dvdnav://"_a) || startsWith("bdnav://"_a) || startsWith("cue://"_a))
-        m_loc = location;
-    else
-        m_loc = QUrl::fromPercentEncoding(location.toUtf8());
+        setLocation("file://"_a % _ToAbsFilePath(location));
+    else if (isLocalFile())
+        setLocation(QUrl::fromPercentEncoding(location.toUtf8()));
+    else if (m_kind == Other && !startsWith("cue://"_a))
+        setLocation(QUrl::fromPercentEncoding(location.toUtf8()));
     m_name = name;
 }
 
+auto Mrl::setLocation(const QString &loc) -> void
+{
+    m_loc = loc;
+    if (m_loc.isEmpty()) {
+        m_key = 0;
+        m_kind = None;
+        return;
+    }
+    // two 32-bit hashes with different seeds make one 64-bit key
+    m_key = (quint64(qHash(m_loc, 0)) << 32) | qHash(m_loc, 0x9e3779b9u);
+    auto is = [&] (const QLatin1String &scheme)
+        { return m_loc.startsWith(scheme, Qt::CaseInsensitive); };
+    if (is("file://"_a))
+        m_kind = File;
+    else if (is("dvdnav://"_a))
+        m_kind = Dvd;
+    else if (is("bdnav://"_a))
+        m_kind = Bluray;
+    else if (m_loc.startsWith("cue://"_a))
+        m_kind = Cue;
+    else
+        m_kind = Other;
+}
+
 auto Mrl::path() const -> QString
 {
     return isLocalFile() ? m_loc : QUrl(m_loc).path();
@@ -84,19 +106,11 @@ auto Mrl::isEmpty() const -> bool
     return (idx < 0) || !(idx+3 < m_loc.size());
 }
 
-static const QStringList discSchemes = QStringList()
-        << u"dvdnav"_q << u"bdnav"_q;
-
-auto Mrl::isDisc() const -> bool
-{
-    return discSchemes.contains(scheme(), Qt::CaseInsensitive);
-}
-
 auto Mrl::device() const -> QString
 {
-    const auto scheme = this->scheme();
-    if (!discSchemes.contains(scheme, Qt::CaseInsensitive))
+    if (!isDisc())
         return QString();
+    const auto scheme = this->scheme();
     auto path = m_loc.midRef(scheme.size() + 3);
     const int idx = path.indexOf('/'_q);
     if (idx < 0)
@@ -125,11 +139,6 @@ auto Mrl::fromCueTrack(const QString &cue, const CueTrack &track,
     return Mrl(list.join(u":;"_q), name);
 }
 
-auto Mrl::isCueTrack() const -> bool
-{
-    return m_loc.startsWith("cue://"_a);
-}
-
 auto Mrl::cueSheet() const -> QString
 {
     if (!isCueTrack())
@@ -264,7 +273,7 @@ auto Mrl::toUnique() const -> Mrl
     if (m_hash.isEmpty())
         return Mrl();
     Mrl mrl;
-    mrl.m_loc = scheme() % ":///"_a % QString::fromUtf8(m_hash);
+    mrl.setLocation(scheme() % ":///"_a % QString::fromUtf8(m_hash));
     mrl.m_hash = m_hash;
     mrl.m_name = m_name;
     return mrl;
@@ -273,14 +282,15 @@ auto Mrl::toUnique() const -> Mrl
 auto Mrl::fromUniqueId(const QString &id, const QString &device, const QString &name) -> Mrl
 {
     Mrl mrl;
-    mrl.m_loc = id;
+    mrl.setLocation(id);
     mrl.m_name = name;
     if (!mrl.isDisc())
         return mrl;
     mrl.m_hash = mrl.device().toUtf8();
-    mrl.m_loc = mrl.scheme() % "://"_a;
+    QString loc = mrl.scheme() % "://"_a;
     if (!device.isEmpty())
-        mrl.m_loc += '/'_q % device;
+        loc += '/'_q % device;
+    mrl.setLocation(loc);
     return mrl;
 }
 
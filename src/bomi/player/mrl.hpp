@@ -9,7 +9,9 @@ public:
     Mrl() {}
     Mrl(const QUrl &url);
     Mrl(const QString &location, const QString &name = QString());
-    auto operator == (const Mrl &rhs) const -> bool {return m_loc == rhs.m_loc;}
+    // key differs for most locations, so string is compared only on match
+    auto operator == (const Mrl &rhs) const -> bool
+        { return m_key == rhs.m_key && m_loc == rhs.m_loc; }
     auto operator != (const Mrl &rhs) const -> bool {return !(*this == rhs);}
     auto operator < (const Mrl &rhs) const -> bool {return m_loc < rhs.m_loc;}
     auto location() const -> QString
@@ -19,11 +21,11 @@ public:
         { return m_loc.startsWith(s, Qt::CaseInsensitive); }
     auto startsWith(const QLatin1String &s) const -> bool
         { return m_loc.startsWith(s, Qt::CaseInsensitive); }
-    auto isLocalFile() const -> bool { return startsWith("file://"_a); }
-    auto isDvd() const -> bool { return startsWith("dvdnav://"_a); }
-    auto isBluray() const -> bool { return startsWith("bdnav://"_a); }
-    auto isDisc() const -> bool;
-    auto isCueTrack() const -> bool;
+    auto isLocalFile() const -> bool { return m_kind == File; }
+    auto isDvd() const -> bool { return m_kind == Dvd; }
+    auto isBluray() const -> bool { return m_kind == Bluray; }
+    auto isDisc() const -> bool { return m_kind == Dvd || m_kind == Bluray; }
+    auto isCueTrack() const -> bool { return m_kind == Cue; }
     auto isRemoteUrl() const -> bool { return !isLocalFile() && !isDisc(); }
     auto scheme() const -> QString {return m_loc.left(m_loc.indexOf("://"_a));}
     auto toLocalFile() const -> QString
@@ -41,6 +43,8 @@ public:
     auto toLocal8Bit() const -> QByteArray { return m_loc.toLocal8Bit(); }
     auto toUtf8() const -> QByteArray { return m_loc.toUtf8(); }
     auto hash() const -> QByteArray { return m_hash; }
+    // 64-bit hash of location which can be used as key of models and caches
+    auto key() const -> quint64 { return m_key; }
     auto updateHash() -> void;
     auto isUnique() const -> bool { return !isDisc() || !m_hash.isEmpty(); }
     auto toUnique() const -> Mrl;
@@ -50,7 +54,7 @@ public:
     auto toCueTrack() const -> CueTrack;
     auto cueSheet() const -> QString;
     static auto fromString(const QString str) -> Mrl
-        { Mrl mrl; mrl.m_loc = str; return mrl; }
+        { Mrl mrl; mrl.setLocation(str); return mrl; }
     static auto fromDisc(const QString &scheme, const QString &device,
                          int title, bool hash) -> Mrl;
     static auto fromCueTrack(const QString &cue, const CueTrack &track,
@@ -60,14 +64,22 @@ public:
                              const QString &device = QString(),
                              const QString &name = QString()) -> Mrl;
 private:
+    enum Kind : quint8 { None, File, Dvd, Bluray, Cue, Other };
     auto path() const -> QString;
+    // every change of m_loc should be done here
+    auto setLocation(const QString &loc) -> void;
     QString m_loc = {};
     QString m_name;
     QByteArray m_hash;
+    quint64 m_key = 0;
+    Kind m_kind = None;
 };
 
 Q_DECLARE_METATYPE(Mrl)
 
+SIA qHash(const Mrl &mrl, uint seed = 0) -> uint
+    { return qHash(mrl.key(), seed); }
+
 auto operator << (QDataStream &lhs, const Mrl &rhs) -> QDataStream&;
 auto operator >> (QDataStream &lhs, Mrl &rhs) -> QDataStream&;
 
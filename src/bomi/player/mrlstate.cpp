@@ -5,6 +5,8 @@
 #include "misc/json.hpp"
 #include "misc/jsonstorage.hpp"
 #include "misc/log.hpp"
+#include "os/os.hpp"
+#include "tmp/static_for.hpp"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
@@ -12,6 +14,77 @@
 
 DECLARE_LOG_CONTEXT(History)
 
+// typed access to one property without QMetaProperty and QVariant
+template<class T>
+struct MrlStateField {
+    T MrlState::*member;
+    bool(MrlState::*set)(tmp::cval_t<T>);
+    void(MrlState::*signal)(T);
+    const char *name;
+};
+
+// same order as P_ in MrlState
+#define MRLSTATE_FIELDS(F) \
+    F(mrl) F(name) F(device) F(last_played_date_time) F(resume_position) \
+    F(star) F(edition) F(play_speed) F(video_interpolator) \
+    F(video_interpolator_down) F(video_chroma_upscaler) \
+    F(video_aspect_ratio) F(video_crop_ratio) F(video_crop_auto) \
+    F(video_rotation) F(video_deinterlacing) F(video_dithering) \
+    F(video_zoom) F(video_offset) F(video_vertical_alignment) \
+    F(video_horizontal_alignment) F(video_color) F(video_range) \
+    F(video_space) F(video_hq_upscaling) F(video_hq_downscaling) \
+    F(video_motion_interpolation) F(video_effects) F(video_tracks) \
+    F(audio_volume) F(audio_amplifier) F(audio_equalizer) F(audio_sync) \
+    F(audio_tracks) F(audio_muted) F(audio_volume_normalizer) \
+    F(audio_tempo_scaler) F(audio_channel_layout) F(sub_alignment) \
+    F(sub_display) F(sub_position) F(sub_sync) F(sub_tracks) \
+    F(sub_tracks_inclusive) F(sub_hidden) F(sub_style_overriden) \
+    F(sub_override_ass_position) F(sub_override_ass_scale) F(sub_scale)
+
+template<int N>
+SCA isSequence(const int (&indexes)[N]) -> bool
+{
+    for (int i = 0; i < N; ++i) {
+        if (indexes[i] != i)
+            return false;
+    }
+    return true;
+}
+
+template<class F>
+auto MrlState::forFields(F func) -> void
+{
+#define INDEX(var) (__field_##var - __field_begin - 1),
+    static constexpr int indexes[] = { MRLSTATE_FIELDS(INDEX) };
+#undef INDEX
+    static_assert(sizeof(indexes)/sizeof(int) == __field_end - __field_begin - 1
+                  && isSequence(indexes),
+                  "MRLSTATE_FIELDS is out of sync with properties of MrlState.");
+#define FIELD(var) MrlStateField<decltype(m_##var)>{ &MrlState::m_##var, \
+    &MrlState::set_##var, &MrlState::var##_changed, #var },
+    static const auto fields = std::make_tuple(MRLSTATE_FIELDS(FIELD) nullptr);
+#undef FIELD
+    tmp::static_for_each<0, sizeof(indexes)/sizeof(int)>(fields, func);
+}
+
+auto CacheInfo::get(const Mrl &mrl) const -> const Item&
+{
+    Mrl file = mrl;
+    if (mrl.isCueTrack())
+        file = Mrl(mrl.toCueTrack().file);
+    if (file.isLocalFile()) {
+        auto path = file.toLocalFile();
+        for (auto &folder : remotes) {
+            if (path.startsWith(folder))
+                return network;
+        }
+        return OS::networkHost(path).isEmpty() ? local : network;
+    }
+    if (mrl.isDisc())
+        return disc;
+    return network;
+}
+
 MrlState::MrlState()
     : d(new Data) {
     m_tracks.resize(StreamUnknown);
@@ -77,11 +150,7 @@ auto MrlState::setFromJson(const QJsonObject &json) -> bool
 
 auto MrlState::copyFrom(const MrlState *state) -> void
 {
-    auto mo = metaObject();
-    for (int i = 0; i < mo->propertyCount(); ++i) {
-        auto p = mo->property(i);
-        p.write(this, p.read(state));
-    }
+    forFields([&] (const auto &f) { (this->*f.set)(state->*f.member); });
     *d = *state->d;
 }
 
@@ -104,14 +173,8 @@ auto MrlState::notifySignal(const char *property) const -> QMetaMethod
 
 auto MrlState::notifyAll() const -> void
 {
-    auto mo = metaObject();
-    for (int i = 1; i < mo->propertyCount(); ++i) {
-        auto p = mo->property(i);
-        if (p.hasNotifySignal())
-            p.notifySignal().invoke(const_cast<MrlState*>(this),
-                                    QGenericArgument(p.typeName(),
-                                                     p.read(this).constData()));
-    }
+    auto self = const_cast<MrlState*>(this);
+    forFields([&] (const auto &f) { emit (self->*f.signal)(this->*f.member); });
 }
 
 auto MrlState::metaProperty(const char *property) const -> QMetaProperty
@@ -131,16 +194,15 @@ auto MrlState::defaultProperties() -> QStringList
 
 auto MrlState::restorableProperties() -> QVector<PropertyInfo>
 {
-    auto mo = &staticMetaObject;
     QVector<PropertyInfo> properties;
-    properties.reserve(mo->propertyCount());
     PropertyInfo info;
-    for (int i = 1; i < mo->propertyCount(); ++i) {
-        info.property = _L(mo->property(i).name());
-        info.description = description(mo->property(i).name());
-        if (!info.description.isEmpty())
+    forFields([&] (const auto &f) {
+        info.description = description(f.name);
+        if (!info.description.isEmpty()) {
+            info.property = _L(f.name);
             properties.push_back(info);
-    }
+        }
+    });
     return properties;
 }
 
@@ -201,22 +263,26 @@ auto MrlState::import(const MrlStateV3 *v3) -> void
             m_mutex->unlock();
 }
 
-auto _ImportMrlStates(int version, QSqlDatabase db)
--> QVector<MrlState*>
+auto _ImportMrlStates(int version, QSqlDatabase db, const MrlStateSink &sink) -> int
 {
-    Q_UNUSED(db);
-    QVector<MrlState*> states;
+    int count = 0;
     if (version < 3)
         _Error("This version of history database is not supported.");
     else if (version == 3) {
         MrlStateV3 v3;
         _Info("Importing from %%.", v3.table());
         QSqlQuery query(db);
+        int total = 0;
+        if (query.exec("SELECT COUNT(*) FROM "_a % v3.table()) && query.next())
+            total = query.value(0).toInt();
+        query.finish();
+        // rows are read once, so don't let driver cache them
+        query.setForwardOnly(true);
         if (!query.exec("SELECT * FROM "_a % v3.table())) {
             _Error("Failed to execute query to import.");
             _Error("Query: %%", query.lastQuery());
             _Error("Error: %%", query.lastError().text());
-            return states;
+            return count;
         }
         const auto record = query.record();
         QVector<MrlStateSqlField> fields(record.count());
@@ -231,17 +297,21 @@ auto _ImportMrlStates(int version, QSqlDatabase db)
             fields[i] = MrlStateSqlField(p, p.read(&v3));
         }
 
+        // reused for every row, new fields are reset to default
+        const MrlState default_;
+        MrlState state;
         while (query.next()) {
-            MrlStateV3 v3;
             for (int i = 0; i < record.count(); ++i) {
                 if (fields[i].isValid())
                     fields[i].exportTo(&v3, query.value(i));
             }
-            auto state = new MrlState;
-            state->import(&v3);
-            states.push_back(state);
+            state.copyFrom(&default_);
+            state.import(&v3);
+            if (!sink(&state, count, total))
+                return -1;
+            ++count;
         }
-        _Info("%% records imported.", states.size());
+        _Info("%% records imported.", count);
     }
-    return states;
+    return count;
 }
@@ -21,30 +21,21 @@
 #include <QMetaProperty>
 
 struct CacheInfo {
-    struct Item { double sec = 10; qint64 kb = 0; bool file = false; };
-    auto get(const Mrl &mrl) const -> const Item&
-    {
-        Mrl file = mrl;
-        if (mrl.isCueTrack())
-            file = Mrl(mrl.toCueTrack().file);
-        if (file.isLocalFile()) {
-            auto path = file.toLocalFile();
-            for (auto &folder : remotes) {
-                if (path.startsWith(folder))
-                    return network;
-            }
-            return local;
-        }
-        if (mrl.isDisc())
-            return disc;
-        return network;
-    }
+    struct Item {
+        DECL_EQ(Item, &T::sec, &T::kb, &T::file)
+        double sec = 10; qint64 kb = 0; bool file = false;
+    };
+    DECL_EQ(CacheInfo, &T::local, &T::network, &T::disc, &T::file_kb,
+            &T::min_playback_kb, &T::min_seeking_kb, &T::adaptive, &T::remotes)
+    // local files on network file system get network cache too
+    auto get(const Mrl &mrl) const -> const Item&;
     auto playback_kb(qint64 cache) const -> qint64
         { return qBound<qint64>(0, min_playback_kb, cache * 0.5); }
     auto seeking_kb(qint64 cache) const -> qint64
         { return qBound<qint64>(0, min_seeking_kb, cache * 0.5); }
     Item local, network, disc;
     qint64 file_kb = 1024 * 1024, min_playback_kb = 0, min_seeking_kb = 500;
+    bool adaptive = false;
     QStringList remotes;
 };
 
@@ -64,6 +55,7 @@ class MrlState : public QObject {
 #define P_GEN(type, name, def, checked_t, desc, rev) \
 private: \
     type m_##name = def; \
+    static constexpr int __field_##name = __COUNTER__; \
     Q_PROPERTY(type name READ name WRITE set_##name NOTIFY name ## _changed REVISION rev) \
     Q_CLASSINFO(#name, desc) \
 public: \
@@ -82,6 +74,8 @@ public: \
 private:
 #define P_(type, name, def, desc, rev) P_GEN(type, name, def, t, desc, rev)
 #define PB(type, name, def, min, max, desc, rev) P_GEN(type, name, def, qBound(min, t, max), desc, rev)
+    // every property takes one count, so fields can be checked against them
+    static constexpr int __field_begin = __COUNTER__;
 
     P_(Mrl, mrl, {}, "", 0)
     P_(QString, name, {}, "", 0)
@@ -98,6 +92,7 @@ private:
     P_(Interpolator, video_chroma_upscaler, Interpolator::Bilinear, QT_TR_NOOP("Video Chroma Upscaler"), 0)
     P_(double, video_aspect_ratio, _EnumData(VideoRatio::Source), QT_TR_NOOP("Video Aspect Ratio"), 0)
     P_(double, video_crop_ratio, _EnumData(VideoRatio::Source), QT_TR_NOOP("Video Crop Ratio"), 0)
+    P_(bool, video_crop_auto, false, QT_TR_NOOP("Video Auto Crop"), 0)
     P_(Rotation, video_rotation, Rotation::D0, QT_TR_NOOP("Video Rotation"), 1);
     P_(DeintMode, video_deinterlacing, DeintMode::Auto, QT_TR_NOOP("Video Deinterlacing"), 0)
     P_(Dithering, video_dithering, Dithering::None, QT_TR_NOOP("Video Dithering"), 0)
@@ -135,6 +130,7 @@ private:
     P_(bool, sub_override_ass_position, false, QT_TR_NOOP("Override ASS Position"), 0);
     P_(bool, sub_override_ass_scale, false, QT_TR_NOOP("Override ASS Scale"), 0);
     PB(double, sub_scale, 0.0, -1.0, 1.0, QT_TR_NOOP("Subtitle Scale"), 0)
+    static constexpr int __field_end = __COUNTER__;
 public:
     static const int Version = 4;
     MrlState();
@@ -159,6 +155,9 @@ signals:
     void currentTrackChanged(StreamType type);
 private:
     auto notifyAll() const -> void;
+    // calls func with MrlStateField of each property in declaration order
+    template<class F>
+    static auto forFields(F func) -> void;
     template<class T>
     auto __set_dummy(const T &) { }
     auto __dummy_int() const -> int { return 0; }
@@ -183,6 +182,9 @@ private:
 
 class QSqlDatabase;
 
-auto _ImportMrlStates(int version, QSqlDatabase db) -> QVector<MrlState*>;
+// streams rows of old table to sink with (state, index, total)
+// sink returns false to abort, which returns -1, otherwise count of rows
+using MrlStateSink = std::function<bool(const MrlState*, int, int)>;
+auto _ImportMrlStates(int version, QSqlDatabase db, const MrlStateSink &sink) -> int;
 
 #endif // MRLSTATE_HPP
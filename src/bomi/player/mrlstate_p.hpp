@@ -5,11 +5,8 @@
 #include "enum/autoselectmode.hpp"
 #include "video/deintoption.hpp"
 #include "video/interpolatorparams.hpp"
-#include "misc/smbauth.hpp"
 
 struct MrlState::Data {
-    CacheInfo cache;
-    SmbAuth smb;
     bool autoselect = false, disc = false, preferExternal = false;
     AutoselectMode autoselectMode = AutoselectMode::Matched;
     QString autoselectExt;
@@ -1,7 +1,7 @@
 #include "mrlstatesqlfield.hpp"
 #include "mrl.hpp"
 #include "misc/jsonstorage.hpp"
-#include <QSqlQuery>
+#include <QDataStream>
 #include <QSqlRecord>
 
 template<class T>
@@ -19,12 +19,15 @@ MrlStateSqlField::MrlStateSqlField(const QMetaProperty &property,
     switch (userType) {
     case QMetaType::Int:         case QMetaType::UInt:
     case QMetaType::LongLong:    case QMetaType::ULongLong:
+        m_direct = true;
         break;
     case QMetaType::Double:
         m_sqlType = u"REAL"_q;
+        m_direct = true;
         break;
     case QMetaType::QString:
         m_sqlType = u"TEXT"_q;
+        m_direct = true;
         break;
     case QMetaType::Bool:
         m_v2d = [] (const QVariant &value)
@@ -40,6 +43,7 @@ MrlStateSqlField::MrlStateSqlField(const QMetaProperty &property,
         break;
     default: {
         if (_Is<Mrl>(userType)) {
+            m_form = MrlString;
             m_sqlType = u"TEXT PRIMARY KEY NOT NULL"_q;
             m_v2d = [] (const QVariant &value)
                 { return QVariant(value.value<Mrl>().toString()); };
@@ -51,6 +55,7 @@ MrlStateSqlField::MrlStateSqlField(const QMetaProperty &property,
             break;
         }
         m_sqlType = u"TEXT"_q;
+        m_form = Json;
         switch (_JsonType(userType)) {
         case QJsonValue::String:
             m_v2d = [] (const QVariant &value) -> QVariant
@@ -88,6 +93,124 @@ MrlStateSqlField::MrlStateSqlField(const QMetaProperty &property,
     }}
 }
 
+auto MrlStateSqlField::encode(const QObject *object) const -> QByteArray
+{
+    const auto value = m_property.read(object);
+    switch (m_form) {
+    case MrlString:
+        return value.value<Mrl>().toString().toUtf8();
+    case Json:
+        // binary json can be mapped later with QJsonDocument::fromRawData()
+        return QJsonDocument(QJsonArray() << _JsonFromQVariant(value)).toBinaryData();
+    default: {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_2);
+        out << value;
+        return data;
+    }}
+}
+
+auto MrlStateSqlField::decode(QObject *object, int form, const char *data,
+                              int size) const -> bool
+{
+    if (form != m_form)
+        return false;
+    QVariant value;
+    switch (m_form) {
+    case MrlString:
+        value = QVariant::fromValue(Mrl::fromString(QString::fromUtf8(data, size)));
+        break;
+    case Json: {
+        const auto doc = QJsonDocument::fromRawData(data, size, QJsonDocument::Validate);
+        if (!doc.isArray() || doc.array().isEmpty())
+            return false;
+        value = _JsonToQVariant(doc.array().at(0), m_property.userType());
+        break;
+    } default: {
+        QDataStream in(QByteArray::fromRawData(data, size));
+        in.setVersion(QDataStream::Qt_5_2);
+        in >> value;
+        if (in.status() != QDataStream::Ok)
+            return false;
+    }}
+    return m_property.write(object, value.isValid() ? value : m_defaultValue);
+}
+
+/******************************************************************************/
+
+static const char SnapshotMagic[4] = { 'B', 'M', 'S', '1' };
+
+// entries are padded to 4 bytes, which binary json requires
+SIA _Align4(int size) -> int { return (size + 3) & ~3; }
+
+auto MrlStateSqlFieldList::encode(const QObject *object, int version) const -> QByteArray
+{
+    QByteArray data;
+    data.reserve(4096);
+    auto append = [&] (quint32 v) { data.append((const char*)&v, sizeof(v)); };
+    auto pad = [&] () { while (data.size() & 3) data.append('\0'); };
+    data.append(SnapshotMagic, sizeof(SnapshotMagic));
+    append(version);
+    append(m_fields.size());
+    for (auto &f : m_fields) {
+        const auto name = f.property().name();
+        const auto value = f.encode(object);
+        append(qstrlen(name) | (f.form() << 16));
+        append(value.size());
+        data.append(name);
+        pad();
+        data.append(value);
+        pad();
+    }
+    return data;
+}
+
+auto MrlStateSqlFieldList::decode(const QByteArray &data, QObject *object,
+                                  int version) const -> bool
+{
+    const char *p = data.constData(), *end = p + data.size();
+    auto take = [&] () { quint32 v; memcpy(&v, p, sizeof(v)); p += sizeof(v); return v; };
+    if (data.size() < 12 || memcmp(p, SnapshotMagic, sizeof(SnapshotMagic)))
+        return false;
+    p += sizeof(SnapshotMagic);
+    if ((int)take() != version)
+        return false;
+    const int count = take();
+    for (int i = 0; i < count; ++i) {
+        if (end - p < 8)
+            return false;
+        const auto head = take();
+        const int length = head & 0xffff, form = head >> 16, size = take();
+        if (size < 0 || end - p < _Align4(length) + size)
+            return false;
+        const QLatin1String name(p, length);
+        p += _Align4(length);
+        for (auto &f : m_fields) {
+            if (name == _L(f.property().name())) {
+                if (!f.decode(object, form, p, size))
+                    return false;
+                break;
+            }
+        }
+        p += qMin<qptrdiff>(_Align4(size), end - p);
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+auto SqlQueryCache::get(const QString &sql) -> QSqlQuery&
+{
+    auto it = m_queries.find(sql);
+    if (it == m_queries.end()) {
+        it = m_queries.insert(sql, QSqlQuery(m_db));
+        it->setForwardOnly(true);
+        it->prepare(sql);
+    }
+    return *it;
+}
+
 /******************************************************************************/
 
 auto MrlStateSqlFieldList::clear() -> void
@@ -160,33 +283,43 @@ auto MrlStateSqlFieldList::update(QSqlQuery &query, const QObject *o) -> bool
     auto &update = m_queries[Update];
     if (update.isEmpty())
         return false;
-    if (!query.prepare(update))
+    if (query.lastQuery() != update && !query.prepare(update))
         return false;
-    for (int i = 0; i < m_fields.size(); ++i) {
-        auto &f = m_fields[i];
-        query.bindValue(i, f.sqlData(f.property().read(o)));
-    }
-    const auto where = m_updateWhere.sqlData(m_updateWhere.property().read(o));
-    query.bindValue(m_fields.size(), where);
+    for (int i = 0; i < m_fields.size(); ++i)
+        m_fields[i].bind(query, i, o);
+    m_updateWhere.bind(query, m_fields.size(), o);
     return query.exec();
 }
 
+auto MrlStateSqlFieldList::update(SqlQueryCache &cache, const QObject *o) -> QSqlQuery&
+{
+    auto &query = cache.get(m_queries[Update]);
+    update(query, o);
+    return query;
+}
+
+auto MrlStateSqlFieldList::insert(SqlQueryCache &cache, const QObject *o) -> QSqlQuery&
+{
+    auto &query = cache.get(m_queries[Insert]);
+    insert(query, o);
+    return query;
+}
+
 auto MrlStateSqlFieldList::select(QSqlQuery &query, QObject *object,
                                   const QVariant &where) const -> bool
 {
     auto &select = m_queries[Select];
     if (select.isEmpty())
         return false;
-    if (!query.prepare(select))
+    if (query.lastQuery() != select && !query.prepare(select))
         return false;
-    query.addBindValue(m_where.sqlData(where));
+    query.bindValue(0, m_where.sqlData(where));
     if (!query.exec() || !query.next())
         return false;
-    const auto record = query.record();
-    for (int i = 0; i < m_fields.size(); ++i) {
-        Q_ASSERT(_L(m_fields[i].property().name()) == record.fieldName(i));
-        m_fields[i].exportTo(object, record.value(i));
-    }
+    for (int i = 0; i < m_fields.size(); ++i)
+        m_fields[i].exportTo(object, query.value(i));
+    // do not hold read transaction of wal with cached statement
+    query.finish();
     return true;
 }
 
@@ -194,11 +327,9 @@ auto MrlStateSqlFieldList::insert(QSqlQuery &query, const QObject *o) -> bool
 {
     if (!isInsertPrepared())
         return false;
-    if (!query.prepare(m_queries[Insert]))
+    if (query.lastQuery() != m_queries[Insert] && !query.prepare(m_queries[Insert]))
         return false;
-    for (int i=0; i<m_fields.size(); ++i) {
-        auto &f = m_fields[i];
-        query.bindValue(i, f.sqlData(f.property().read(o)));
-    }
+    for (int i=0; i<m_fields.size(); ++i)
+        m_fields[i].bind(query, i, o);
     return query.exec();
 }
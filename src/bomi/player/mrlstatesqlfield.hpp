@@ -2,6 +2,8 @@
 #define MRLSTATESQLFIELD_HPP
 
 #include <QMetaProperty>
+#include <QSqlQuery>
+#include <QSqlDatabase>
 
 struct MrlStateSqlField;
 
@@ -14,23 +16,46 @@ struct MrlStateSqlField {
     template<class T>
     auto sqlData(T*) const -> void; // error
     auto sqlData(const QVariant &value) const noexcept -> QVariant
-    { return m_v2d(value); }
+    { return m_direct ? value : m_v2d(value); }
+    // bind property of object at given position
+    auto bind(QSqlQuery &query, int pos, const QObject *object) const -> void
+    { query.bindValue(pos, sqlData(m_property.read(object))); }
     auto exportTo(QObject *state, const QVariant &sqlData) const -> bool
     {
         const auto var = m_d2v(sqlData, m_defaultValue.userType());
         return m_property.write(state, var.isValid() ? var : m_defaultValue);
     }
     auto isValid() const -> bool { return m_v2d && m_d2v; }
+    // binary form of property for snapshots
+    auto encode(const QObject *object) const -> QByteArray;
+    auto decode(QObject *object, int form, const char *data, int size) const -> bool;
+    auto form() const -> int { return m_form; }
 private:
+    enum Form { Stream, MrlString, Json };
     QMetaProperty m_property;
     QString m_sqlType;
     QVariant m_defaultValue;
     QVariant(*m_v2d)(const QVariant&) = nullptr;
     QVariant(*m_d2v)(const QVariant&,int) = nullptr;
+    // sqlite takes value as it is
+    bool m_direct = false;
+    Form m_form = Stream;
     friend class MrlStateSqlFieldList;
 };
 
-class QSqlQuery;                        class QSqlDatabase;
+// prepared statements of one connection
+// every distinct statement is prepared once and reused
+class SqlQueryCache {
+public:
+    SqlQueryCache() = default;
+    SqlQueryCache(const QSqlDatabase &db): m_db(db) { }
+    auto setDatabase(const QSqlDatabase &db) -> void { m_queries.clear(); m_db = db; }
+    auto get(const QString &sql) -> QSqlQuery&;
+    auto clear() -> void { m_queries.clear(); }
+private:
+    QSqlDatabase m_db;
+    QHash<QString, QSqlQuery> m_queries;
+};
 
 class MrlStateSqlFieldList {
     using Field = MrlStateSqlField;
@@ -55,20 +80,33 @@ public:
     auto prepareUpdate(const QString &table, const Field &where) -> QString;
     auto prepareSelect(const QString &table, const Field &where) -> QString;
     auto field(const QString &name) const -> Field;
+    // statements are prepared again only if query holds another one
     auto insert(QSqlQuery &query, const QObject *object) -> bool;
     auto update(QSqlQuery &query, const QObject *object) -> bool;
+    // take the prepared statement from cache
+    auto insert(SqlQueryCache &cache, const QObject *object) -> QSqlQuery&;
+    auto update(SqlQueryCache &cache, const QObject *object) -> QSqlQuery&;
+    auto select(SqlQueryCache &cache, QObject *object, const QVariant &where) const -> bool
+        { return select(cache.get(m_queries[Select]), object, where); }
+    auto select(SqlQueryCache &cache, QObject *object) const -> bool
+        { return select(cache, object, m_where.property().read(object)); }
     auto select(QSqlQuery &query, QObject *object) const -> bool
         { return select(query, object, m_where.property().read(object)); }
     auto select(QSqlQuery &q, QObject *o, const QVariant &where) const -> bool;
     template<class T>
     auto select(QSqlQuery &query, QObject *object, const T &t) const -> bool
         { return select(query, object, QVariant::fromValue<T>(t)); }
+    // versioned binary image of whole list, to be stored as blob
+    // decode() restores only fields of this list and skips others
+    // json values are read in place from the data without parsing text
+    auto encode(const QObject *object, int version) const -> QByteArray;
+    auto decode(const QByteArray &data, QObject *object, int version) const -> bool;
     auto isInsertPrepared() const -> bool { return isPrepared(Insert); }
     auto isUpdatePrepared() const -> bool { return isPrepared(Update); }
     auto isSelectPrepared() const -> bool { return isPrepared(Select); }
     auto isPrepared(QueryType type) const -> bool
         { return !m_queries[type].isEmpty(); }
-    auto query(QueryType type) -> QString const { return m_queries[type]; }
+    auto query(QueryType type) const -> QString { return m_queries[type]; }
 private:
     QVector<QString> m_queries = QVector<QString>(MaxType);
     QVector<Field> m_fields;
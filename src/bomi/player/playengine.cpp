@@ -4,8 +4,16 @@
 #include "audio/audionormalizeroption.hpp"
 #include "subtitle/subtitlemodel.hpp"
 #include "os/os.hpp"
+#include "os/resourcemonitor.hpp"
+#include "quick/infosubscriber.hpp"
+#include "misc/directorycache.hpp"
 #include "videosettings.hpp"
+#include "pref/pref.hpp"
 #include <QQuickWindow>
+#include <QScreen>
+
+// MiB of recently shown frames for instant frame steps
+static constexpr int FrameStepCache = 128, LowFrameStepCache = 0;
 
 PlayEngine::PlayEngine()
 : d(new Data(this)) {
@@ -20,8 +28,16 @@ PlayEngine::PlayEngine()
         { d->renderVideoFrame(frame, osd, m); });
     d->updateVideoRendererFboFormat();
     d->info.video.setScreen(d->vr);
+    d->info.video.timing()->setTiming(&d->timing);
+    d->info.video.stats()->setStats(&d->stats);
+    d->info.audio.profile()->setProfile(d->ac->profile());
+    d->mpv.setRenderTiming(&d->timing);
+    d->sr->setRenderTiming(&d->timing);
 
     d->params.m_mutex = &d->mutex;
+    d->clock.uptime.start();
+    d->keyframePool.setMaxThreadCount(1);
+    d->overviewPool.setMaxThreadCount(1);
 
     auto isAss = [=] () {
         auto track = d->params.sub_tracks().selection();
@@ -31,7 +47,14 @@ PlayEngine::PlayEngine()
     connect(&d->params, &MrlState::video_offset_changed, d->vr, &VideoRenderer::setOffset);
     connect(&d->params, &MrlState::video_aspect_ratio_changed, d->vr, &VideoRenderer::setAspectRatio);
     connect(&d->params, &MrlState::video_crop_ratio_changed, d->vr, &VideoRenderer::setCropRatio);
+    connect(&d->params, &MrlState::video_crop_auto_changed, d->vr, &VideoRenderer::setAutoCrop);
     connect(&d->params, &MrlState::video_rotation_changed, d->vr, &VideoRenderer::setRotation);
+    connect(&d->slides, &SlideDecoder::decoded, d->vr, [=] (const QString &file, const QImage &image) {
+        if (d->hasImage)
+            d->vr->preloadImage(image);
+        else if (file == d->albumArt)
+            d->vr->setImage(image);
+    });
     auto updateLetterBox = [=] (bool override)
         { d->mpv.setAsync("ass-force-margins", d->vr->overlayOnLetterbox() && override); };
     connect(&d->params, &MrlState::sub_display_changed, d->vr, [=] (auto sd) {
@@ -139,7 +162,7 @@ PlayEngine::PlayEngine()
             d->mpv.setAsync("pause", false);
             d->mpv.setAsync("speed", 100.0);
         } else {
-            d->mpv.setAsync("speed", d->params.play_speed());
+            d->mpv.setAsync("speed", d->speed(d->params.play_speed()));
             d->mpv.setAsync("pause", d->pauseAfterSkip);
             d->mpv.setAsync("mute", d->params.audio_muted());
         }
@@ -181,6 +204,8 @@ PlayEngine::PlayEngine()
     });
     connect(d->ac, &AudioController::gainChanged,
             &d->info.audio, &AudioObject::setNormalizer);
+    connect(d->ac, &AudioController::loudnessChanged,
+            &d->info.audio, &AudioObject::setLoudness);
     connect(d->ac, &AudioController::spectrumObtained,
             &d->info.audio, &AudioObject::setSpectrum, Qt::QueuedConnection);
     connect(this, &PlayEngine::audioOnlyChanged, d->ac, &AudioController::setAnalyzeSpectrum);
@@ -192,9 +217,17 @@ PlayEngine::PlayEngine()
     d->frames.measure.setTimer([=]()
         { d->info.video.output()->setFps(d->frames.measure.get()); }, 100000);
     connect(&d->info.frameTimer, &QTimer::timeout, this, [=] () {
-        d->info.video.decoder()->setBitrate(d->mpv.get<int>("video-bitrate"));
-        d->info.video.setDelayedFrames(d->info.delayed);
-        d->info.video.setDroppedFrames(d->mpv.get<int64_t>("vo-drop-frame-count"));
+        d->stats.setDrops(d->mpv.get<int64_t>("drop-frame-count"),
+                          d->mpv.get<int64_t>("vo-drop-frame-count"));
+        d->updateDynamicResolution();
+        d->updateDisplaySync();
+    });
+    connect(&d->info.statsTimer, &QTimer::timeout, this, [=] () { d->updateStats(); });
+    connect(InfoSubscription::get(), &InfoSubscription::changed, this, [=] (int interval) {
+        d->updateStatsTimer();
+        // values observed while nobody subscribed were not notified
+        if (interval > 0)
+            emit avSyncChanged(d->avSync);
     });
     connect(d->info.video.output(), &VideoFormatObject::sizeChanged,
             d->preview, &VideoPreview::setSizeHint);
@@ -219,8 +252,13 @@ PlayEngine::PlayEngine()
     d->mpv.setOption("vo", d->vo(&d->params));
     d->mpv.setOption("af", d->af(&d->params));
     d->mpv.setOption("vf", d->vf(&d->params));
+    d->sentVo = d->videoSubOptions(&d->params);
+    d->sentVf = d->vfChain(&d->params);
     d->mpv.setOption("hr-seek", d->preciseSeeking ? "yes" : "absolute");
+    d->mpv.setOption("frame-step-cache", QByteArray::number(FrameStepCache).constData());
     d->mpv.setOption("audio-file-auto", "no");
+    // covers are decoded at display size by slides instead of video chain
+    d->mpv.setOption("audio-display", "no");
     d->mpv.setOption("sub-auto", "no");
     d->mpv.setOption("sub-text-margin-y", "0");
     d->mpv.setOption("audio-client-name", cApp.name());
@@ -259,8 +297,11 @@ PlayEngine::PlayEngine()
 
 PlayEngine::~PlayEngine()
 {
+    d->cancelKeyframes();
+    d->cancelOverview();
     qDeleteAll(d->info.chapters);
     qDeleteAll(d->info.editions);
+    qDeleteAll(d->info.spare);
     d->params.m_mutex = nullptr;
     d->mpv.destroy();
     d->vr->setOverlay(nullptr);
@@ -275,13 +316,18 @@ PlayEngine::~PlayEngine()
 
 auto PlayEngine::initializeGL(const QQuickWindow *w, QOpenGLContext *ctx) -> void
 {
+    // window adapter keeps it current afterward
+    d->timing.setRefreshRate(OS::refreshRate());
     d->mpv.initializeGL(ctx);
     connect(w, &QQuickWindow::frameSwapped,
             &d->mpv, &Mpv::frameSwapped, Qt::DirectConnection);
+    connect(w, &QQuickWindow::frameSwapped,
+            this, [=] () { d->frameSwapped(); }, Qt::DirectConnection);
 }
 
 auto PlayEngine::finalizeGL(QOpenGLContext */*ctx*/) -> void
 {
+    d->releaseSnapshots();
     d->mpv.finalizeGL();
 }
 
@@ -331,16 +377,20 @@ auto PlayEngine::chapters() const -> const QVector<ChapterObject*>&
     return d->info.chapters;
 }
 
-auto PlayEngine::setPriority_locked(const QStringList &audio, const QStringList &sub) -> void
+auto PlayEngine::setPriority(const QStringList &audio, const QStringList &sub) -> void
 {
-    d->streams[StreamAudio].priority = audio;
-    d->streams[StreamSubtitle].priority = sub;
+    d->configure([&] (EngineConfig &c) {
+        c.priority[StreamAudio] = audio;
+        c.priority[StreamSubtitle] = sub;
+    });
 }
 
-auto PlayEngine::setAutoloader_locked(const Autoloader &audio, const Autoloader &sub) -> void
+auto PlayEngine::setAutoloader(const Autoloader &audio, const Autoloader &sub) -> void
 {
-    d->streams[StreamAudio].autoloader = audio;
-    d->streams[StreamSubtitle].autoloader = sub;
+    d->configure([&] (EngineConfig &c) {
+        c.autoloader[StreamAudio] = audio;
+        c.autoloader[StreamSubtitle] = sub;
+    });
 }
 
 auto PlayEngine::clearAllSubtitleSelection() -> void
@@ -477,7 +527,7 @@ auto PlayEngine::speed() const -> double
 auto PlayEngine::setSpeed(double s) -> void
 {
     if (d->params.set_play_speed(s))
-        d->mpv.setAsync("speed", speed());
+        d->mpv.setAsync("speed", d->speed(speed()));
 }
 
 auto PlayEngine::setSubtitleScale(double by) -> void
@@ -485,16 +535,27 @@ auto PlayEngine::setSubtitleScale(double by) -> void
     d->params.set_sub_scale(by);
 }
 
-auto PlayEngine::setSubtitleStyle_locked(const OsdStyle &style) -> void
+auto PlayEngine::setSubtitleStyle(const OsdStyle &style) -> void
 {
     d->subStyle = style;
     d->updateSubtitleStyle();
 }
 
+auto PlayEngine::setSubtitleGpuEffects(bool on) -> void
+{
+    d->sr->setGpuEffects(on);
+}
+
 auto PlayEngine::seek(int pos) -> void
 {
-    if (pos >= 0 && !d->hasImage)
-        d->mpv.tell("seek", (std::max(d->begin, pos) + d->t.offset)/1000.0, "absolute"_b);
+    if (pos >= 0 && !d->hasImage) {
+        pos = std::max(d->begin, pos) + d->t.offset;
+        const int key = d->snapToKeyframe(pos);
+        if (key >= 0) // just after it, or mpv may pick previous one
+            d->mpv.tell("seek", (key + 1)/1000.0, "absolute+keyframes"_b);
+        else
+            d->mpv.tell("seek", pos/1000.0, "absolute"_b);
+    }
     d->vp->stopSkipping();
 }
 
@@ -503,19 +564,23 @@ auto PlayEngine::relativeSeek(int pos) -> void
     if (!d->hasImage) {
         if (pos < d->begin - d->time)
             pos = d->begin - d->time;
-        d->mpv.tell("seek", pos/1000.0, "relative"_b);
+        const int key = d->snapToKeyframe(d->time + pos + d->t.offset);
+        if (key >= 0)
+            d->mpv.tell("seek", (key + 1)/1000.0, "absolute+keyframes"_b);
+        else
+            d->mpv.tell("seek", pos/1000.0, "relative"_b);
         emit sought();
     }
     d->vp->stopSkipping();
 }
 
-auto PlayEngine::setVolumeControl_locked(int scale, bool soft) -> void
+auto PlayEngine::setVolumeControl(int scale, bool soft) -> void
 {
-    d->volumeScale = scale;
+    d->configure([&] (EngineConfig &c) { c.volumeScale = scale; });
     d->ac->setSoftClip(soft);
 }
 
-auto PlayEngine::setChannelLayoutMap_locked(const ChannelLayoutMap &map) -> void
+auto PlayEngine::setChannelLayoutMap(const ChannelLayoutMap &map) -> void
 {
     d->ac->setChannelLayoutMap(map);
 }
@@ -540,14 +605,9 @@ auto PlayEngine::setHistory(HistoryModel *history) -> void
     d->history = history;
 }
 
-auto PlayEngine::lock() -> void
-{
-    d->mutex.lock();
-}
-
-auto PlayEngine::unlock() -> void
+auto PlayEngine::setProbeCache(MediaProbeCache *probes) -> void
 {
-    d->mutex.unlock();
+    d->probes = probes;
 }
 
 auto PlayEngine::setChannelLayout(ChannelLayout layout) -> void
@@ -559,10 +619,15 @@ auto PlayEngine::setChannelLayout(ChannelLayout layout) -> void
     }
 }
 
-auto PlayEngine::setAudioDevice_locked(const QString &device) -> void
+auto PlayEngine::setAudioDevice(const QString &device) -> void
 {
-    d->params.d->audioDevice = device;
-    d->mpv.setAsync("options/audio-device", d->params.d->audioDevice.toLatin1());
+    d->mutex.lock();
+    const bool changed = _Change(d->params.d->audioDevice, device);
+    d->mutex.unlock();
+    d->mpv.setAsync("options/audio-device", device.toLatin1());
+    // only output is reloaded, filter chain keeps its state if possible
+    if (changed && d->time > 0)
+        d->mpv.tellAsync("ao_reload");
 }
 
 auto PlayEngine::screen() const -> QQuickItem*
@@ -570,17 +635,98 @@ auto PlayEngine::screen() const -> QQuickItem*
     return d->vr;
 }
 
-auto PlayEngine::setCache_locked(const CacheInfo &info) -> void
+auto PlayEngine::setPreferences(const Pref &p) -> void
+{
+    auto cache = [&] () {
+        CacheInfo cache;
+        cache.local.kb = p.cache_local_mb() * 1024.0;
+        cache.network.kb = p.cache_network_mb() * 1024.0;
+        cache.disc.kb = p.cache_disc_mb() * 1024.0;
+        cache.local.sec = p.cache_local_sec();
+        cache.network.sec = p.cache_network_sec();
+        cache.disc.sec = p.cache_disc_sec();
+        cache.local.file = p.cache_local_file();
+        cache.network.file = p.cache_network_file();
+        cache.disc.file = p.cache_disc_file();
+        cache.file_kb = p.cache_file_size_mb() * 1024.0;
+        cache.min_playback_kb = p.cache_min_playback_kb();
+        cache.min_seeking_kb = p.cache_min_seeking_kb();
+        cache.adaptive = p.cache_network_adaptive();
+        cache.remotes = p.network_folders();
+        return cache;
+    };
+
+    const bool hwdec = d->hwdec;
+    const auto hwCodecs = d->hwCodecs;
+    d->mpv.begin();
+    d->pending = std::make_shared<EngineConfig>(*d->config());
+
+    setLowMemory(p.low_memory());
+    d->downloads.setEnabled(p.cache_network_progressive());
+
+    // process wide, threads pick it up on their next round
+    OS::ThreadPolicy threads;
+    threads.realtime = p.app_realtime_threads();
+    threads.efficiency = p.app_efficiency_cores();
+    OS::setThreadPolicy(threads);
+
+    setResume(p.remember_stopped());
+    setKeyframeSnapping(p.precise_seeking_tolerance());
+    setPreciseSeeking(p.precise_seeking());
+    setStatsSummary(p.log_stats_summary());
+    setCache(cache());
+    setPriority(p.audio_priority(), p.sub_priority());
+    setAutoloader(p.audio_autoload(), p.sub_autoload_v2());
+
+    setHwAcc(p.enable_hwaccel(), p.hwaccel_codecs());
+    setDecoderThreads(p.decoder_threads(), p.decoder_low_latency());
+    setDeintOptions(p.deinterlacing());
+    setMotionIntrplOption(p.motion_interpolation());
+    setDynamicResolution(p.dynamic_resolution());
+    setDisplaySync(p.display_sync());
+
+    setAudioDevice(p.audio_device());
+    setAudioLowLatency(p.audio_low_latency());
+    setAudioZones(p.audio_zones());
+    setVolumeNormalizerOption(p.audio_normalizer());
+    setChannelLayoutMap(p.channel_manipulation());
+    setVolumeControl(p.volume_scale(), p.soft_clip());
+    setResyncAvWhenFilterToggled(p.audio_filter_resync());
+
+    setSubtitleStyle(p.sub_style());
+    setSubtitleGpuEffects(p.sub_gpu_effects());
+    setAutoselectMode(p.sub_enable_autoselect(), p.sub_autoselect(),
+                      p.sub_ext(), p.sub_prefer_external());
+
+    std::atomic_store(&d->configuration, std::shared_ptr<const EngineConfig>(std::move(d->pending)));
+    // only what is read when file is loaded needs reloading
+    auto loadTime = [] (const EngineConfig &c) {
+        return std::tie(c.cache, c.priority, c.autoloader, c.decoderThreads, c.lowLatencyDecoding);
+    };
+    const auto c = d->config();
+    const bool reload = !d->applied || loadTime(*d->applied) != loadTime(*c)
+            || d->applied->smb.username() != c->smb.username()
+            || d->applied->smb.password() != c->smb.password()
+            || d->hwdec != hwdec || d->hwCodecs != hwCodecs;
+    d->applied = c;
+    if (reload)
+        d->mpv.cancel("ao_reload");
+    d->mpv.commit();
+    if (reload)
+        this->reload();
+}
+
+auto PlayEngine::setCache(const CacheInfo &info) -> void
 {
-    d->params.d->cache = info;
+    d->configure([&] (EngineConfig &c) { c.cache = info; });
 }
 
-auto PlayEngine::setSmbAuth_locked(const SmbAuth &smb) -> void
+auto PlayEngine::setSmbAuth(const SmbAuth &smb) -> void
 {
-    d->params.d->smb = smb;
+    d->configure([&] (EngineConfig &c) { c.smb = smb; });
 }
 
-auto PlayEngine::setHwAcc_locked(bool use, const QList<CodecId> &codecs) -> void
+auto PlayEngine::setHwAcc(bool use, const QList<CodecId> &codecs) -> void
 {
     d->hwdec = use;
     d->hwCodecs = codecs;
@@ -654,6 +800,18 @@ auto PlayEngine::seekChapter(int number) -> void
     d->mpv.setAsync("chapter", number);
 }
 
+auto PlayEngine::setABLoop(int a, int b) -> void
+{
+    auto set = [&] (QByteArray &&name, int ms) {
+        if (ms < 0)
+            d->mpv.setAsync(std::move(name), "no"_b);
+        else
+            d->mpv.setAsync(std::move(name), (ms + d->t.offset) * 1e-3);
+    };
+    set("ab-loop-a"_b, a);
+    set("ab-loop-b"_b, b);
+}
+
 auto PlayEngine::seekEdition(int number, int from) -> void
 {
     const auto mrl = d->mrl;
@@ -699,15 +857,39 @@ auto PlayEngine::shutdown() -> void
     d->mpv.tell("quit");
 }
 
-auto PlayEngine::setResume_locked(bool resume) -> void
+auto PlayEngine::setResume(bool resume) -> void
 {
-    d->resume = resume;
+    d->configure([&] (EngineConfig &c) { c.resume = resume; });
 }
 
-auto PlayEngine::setPreciseSeeking_locked(bool on) -> void
+auto PlayEngine::setPreciseSeeking(bool on) -> void
 {
     if (_Change(d->preciseSeeking, on))
         d->mpv.setAsync("options/hr-seek", on ? "yes"_b : "absolute"_b);
+    d->loadKeyframes();
+}
+
+auto PlayEngine::setLowMemory(bool on) -> void
+{
+    // ms and MiB of subtitle look-ahead
+    static constexpr int Lookahead = 10000, Cache = 64;
+    static constexpr int LowLookahead = 2000, LowCache = 8;
+    d->sr->setCacheLimit(on ? LowLookahead : Lookahead, on ? LowCache : Cache);
+    d->vr->setIdleRelease(on ? 5000 : -1);
+    d->mpv.setAsync("options/frame-step-cache", on ? LowFrameStepCache : FrameStepCache);
+    OS::ResourceMonitor::setSaving("subtitle", on ? Cache - LowCache : 0);
+    OS::ResourceMonitor::setSaving("frame-steps", on ? FrameStepCache - LowFrameStepCache : 0);
+}
+
+auto PlayEngine::setStatsSummary(bool on) -> void
+{
+    d->statsSummary = on;
+}
+
+auto PlayEngine::setKeyframeSnapping(int tolerance) -> void
+{
+    if (_Change(d->keyframes.tolerance, tolerance))
+        d->loadKeyframes();
 }
 
 auto PlayEngine::setMrl(const Mrl &mrl) -> void
@@ -720,8 +902,60 @@ auto PlayEngine::setMrl(const Mrl &mrl) -> void
     }
 }
 
+auto PlayEngine::setNextMrl(const Mrl &mrl, bool tryResume) -> void
+{
+    auto queueable = [&] () {
+        return !mrl.isEmpty() && !mrl.isImage() && !mrl.isDisc()
+                && !d->hasImage && !d->mrl.isEmpty();
+    };
+    if (d->next == mrl || (d->next.isEmpty() && !queueable()))
+        return;
+    d->mpv.tellAsync("playlist_clear");
+    d->next = Mrl();
+    if (!queueable())
+        return;
+    d->next = mrl;
+    d->loadfile(mrl, tryResume, QString(), true);
+    // resolve state and sibling files before mpv asks for them
+    if (mrl.isUnique())
+        d->history->find(mrl);
+    if (mrl.isLocalFile())
+        DirectoryCache::get(QFileInfo(mrl.toLocalFile()).absolutePath());
+}
+
+auto PlayEngine::nextMrl() const -> Mrl
+{
+    return d->next;
+}
+
+auto PlayEngine::prefetchImages(const QList<Mrl> &mrls) -> void
+{
+    // covers while music plays, otherwise images while they are shown
+    const bool covers = !d->albumArt.isEmpty();
+    if (!d->hasImage && !covers)
+        return;
+    for (auto &mrl : mrls) {
+        if (!mrl.isLocalFile())
+            continue;
+        if (covers ? _IsSuffixOf(AudioExt, mrl.suffix()) : mrl.isImage())
+            d->slides.prefetch(mrl.toLocalFile());
+    }
+}
+
 auto PlayEngine::load(const Mrl &mrl, bool tryResume, const QString &sub) -> void
 {
+    d->cancelLoad();
+    d->next = Mrl();
+    if (d->showSlide(mrl)) {
+        if (_Change(d->mrl, mrl)) {
+            d->updateMediaName();
+            emit mrlChanged(d->mrl);
+        }
+        emit started(d->mrl);
+        return;
+    }
+    d->vr->setImage(QImage());
+    d->albumArt.clear();
     if (_Change(d->mrl, mrl)) {
         d->hasImage = mrl.isImage();
         d->updateMediaName();
@@ -785,47 +1019,109 @@ auto PlayEngine::setAudioSync(int sync) -> void
         d->mpv.setAsync("audio-delay", sync * 1e-3);
 }
 
-auto PlayEngine::setResyncAvWhenFilterToggled_locked(bool on) -> void
+auto PlayEngine::setResyncAvWhenFilterToggled(bool on) -> void
 {
     d->filterResync = on;
 }
 
+auto PlayEngine::setAudioZones(const QList<AudioZoneOption> &zones) -> void
+{
+    d->ac->setZones(zones);
+}
+
+auto PlayEngine::setAudioLowLatency(bool on) -> void
+{
+    if (!_Change(d->lowLatencyAudio, on))
+        return;
+    d->ac->setLowLatency(on);
+    d->mpv.setAsync("options/audio-buffer", on ? 0.05 : 0.2);
+    // only drivers which are built can be named here
+#if defined(Q_OS_LINUX)
+    d->mpv.setAsync("options/ao-defaults", on ? "alsa:buffer-time=40"_b
+                                              : "alsa:buffer-time=250"_b);
+#elif defined(Q_OS_WIN)
+    d->mpv.setAsync("options/ao-defaults", on ? "wasapi:exclusive=yes"_b
+                                              : "wasapi:exclusive=no"_b);
+#endif
+    if (d->time > 0)
+        d->mpv.tellAsync("ao_reload");
+}
+
 auto PlayEngine::setAudioVolumeNormalizer(bool on) -> void
 {
     if (d->params.set_audio_volume_normalizer(on)) {
-        d->mpv.tellAsync("af", "set"_b, d->af(&d->params));
+        d->updateAudioFilter();
+        // lookahead of normalizer changes output delay
         d->resync(true);
     }
 }
 
 auto PlayEngine::setAudioTempoScaler(bool on) -> void
 {
-    if (d->params.set_audio_tempo_scaler(on)) {
-        d->mpv.tellAsync("af", "set"_b, d->af(&d->params));
-        d->resync();
-    }
+    if (d->params.set_audio_tempo_scaler(on))
+        d->updateAudioFilter();
 }
 
 auto PlayEngine::stop() -> void
 {
+    d->vr->setImage(QImage());
+    d->albumArt.clear();
+    d->cancelLoad();
     d->mpv.tell("stop");
 }
 
-auto PlayEngine::setMotionIntrplOption_locked(const MotionIntrplOption &option)
+auto PlayEngine::setMotionIntrplOption(const MotionIntrplOption &option)
 -> void
 {
     d->vp->setMotionIntrplOption(option);
 }
 
-auto PlayEngine::setVolumeNormalizerOption_locked(const AudioNormalizerOption &option)
+auto PlayEngine::setRefreshRate(qreal hz) -> void
+{
+    if (hz <= 0)
+        return;
+    d->timing.setRefreshRate(hz);
+    d->vp->setDisplayRefreshRate(hz);
+    d->ac->visualizer()->setRefreshRate(hz);
+}
+
+auto PlayEngine::setDynamicResolution(bool on) -> void
+{
+    if (!_Change(d->dynres.enabled, on) || on)
+        return;
+    d->dynres.scale = 1.0;
+    d->vr->setRenderScale(1.0);
+    if (_Change(d->dynres.cheap, false))
+        d->updateVideoSubOptions();
+}
+
+auto PlayEngine::setDecoderThreads(int threads, bool lowLatency) -> void
+{
+    d->configure([&] (EngineConfig &c) {
+        c.decoderThreads = threads;
+        c.lowLatencyDecoding = lowLatency;
+    });
+}
+
+auto PlayEngine::setDisplaySync(bool on) -> void
+{
+    if (_Change(d->dsync.enabled, on) && !on)
+        d->setDisplaySyncFactor(1.0);
+}
+
+auto PlayEngine::setVolumeNormalizerOption(const AudioNormalizerOption &option)
 -> void
 {
     d->ac->setNormalizerOption(option);
 }
 
-auto PlayEngine::setDeintOptions_locked(const DeintOptionSet &set) -> void
+auto PlayEngine::setDeintOptions(const DeintOptionSet &set) -> void
 {
+    d->mutex.lock();
     d->params.d->deint = set;
+    d->mutex.unlock();
+    d->updateVideoFilter();
+    d->updateVideoSubOptions();
     emit deintOptionsChanged();
 }
 
@@ -889,6 +1185,11 @@ auto PlayEngine::setVideoCropRatio(double ratio) -> void
     d->params.set_video_crop_ratio(ratio);
 }
 
+auto PlayEngine::setVideoAutoCrop(bool on) -> void
+{
+    d->params.set_video_crop_auto(on);
+}
+
 auto PlayEngine::setVideoVerticalAlignment(VerticalAlignment a) -> void
 {
     d->params.set_video_vertical_alignment(a);
@@ -927,15 +1228,22 @@ auto PlayEngine::deintMode() const -> DeintMode
 
 auto PlayEngine::sendMouseClick(const QPointF &pos) -> void
 {
+    if (!d->mpv.handle() || !d->params.d->disc)
+        return;
+    // click must hit latest position whatever is in flight
     d->setMousePos(pos);
-    if (d->params.d->disc)
-        d->mpv.tellAsync("discnav", "mouse"_b);
+    d->moveMouse(true);
+    d->mpv.tellAsync("discnav", "mouse"_b);
 }
 
 auto PlayEngine::sendMouseMove(const QPointF &pos) -> void
 {
-    if (d->setMousePos(pos))
-        d->mpv.tellAsync("discnav", "mouse_move"_b);
+    if (!d->setMousePos(pos))
+        return;
+    // highlight cannot change while moving within highlighted button
+    if (d->mouseOnButton && d->nav.button.contains(d->mouse))
+        return;
+    d->moveMouse(false);
 }
 
 auto PlayEngine::audioDeviceList() const -> QList<AudioDevice>
@@ -986,19 +1294,19 @@ auto PlayEngine::setFramebufferObjectFormat(FramebufferObjectFormat format) -> v
 auto PlayEngine::setColorRange(ColorRange range) -> void
 {
     if (d->params.set_video_range(range))
-        d->mpv.tellAsync("vf", "set"_b, d->vf(&d->params));
+        d->updateVideoFilter();
 }
 
 auto PlayEngine::setColorSpace(ColorSpace space) -> void
 {
     if (d->params.set_video_space(space))
-        d->mpv.tellAsync("vf", "set"_b, d->vf(&d->params));
+        d->updateVideoFilter();
 }
 
 auto PlayEngine::setMotionInterpolation(bool on) -> void
 {
     if (d->params.set_video_motion_interpolation(on)) {
-        d->mpv.tellAsync("vf", "set"_b, d->vf(&d->params));
+        d->updateVideoFilter();
         d->updateVideoSubOptions();
     }
 }
@@ -1129,39 +1437,74 @@ auto PlayEngine::setVideoEffects(VideoEffects e) -> void
 
 auto PlayEngine::setVideoRotation(Rotation r) -> void
 {
-    if (d->params.set_video_rotation(r))
-        d->mpv.setAsync<int>("video-rotate", _EnumData(r));
+    d->params.set_video_rotation(r);
 }
 
 auto PlayEngine::takeSnapshot() -> void
 {
-    d->ss.take = true;
+    ++d->ss.take;
     d->vr->updateForNewFrame(d->displaySize());
 }
 
 auto PlayEngine::snapshot(QImage *frame, QImage *osd) -> int
 {
-    *frame = d->ss.frame;
-    *osd = d->ss.osd;
-    return d->ss.time;
+    QMutexLocker locker(&d->mutex);
+    if (d->ss.taken.isEmpty()) {
+        *frame = *osd = QImage();
+        return -1;
+    }
+    auto s = d->ss.taken.takeFirst();
+    frame->swap(s.frame);
+    osd->swap(s.osd);
+    return s.time;
 }
 
 auto PlayEngine::clearSnapshots() -> void
 {
-    d->ss.frame = d->ss.osd = QImage();
+    QMutexLocker locker(&d->mutex);
+    d->ss.taken.clear();
+}
+
+auto PlayEngine::startCapture(const QString &path, int every, bool osd) -> bool
+{
+    stopCapture();
+    if (!d->capture.writer.start(path))
+        return false;
+    d->capture.every = qMax(1, every);
+    d->capture.osd = osd;
+    d->capture.running = true;
+    emit capturingChanged(true);
+    return true;
+}
+
+auto PlayEngine::stopCapture() -> void
+{
+    if (!d->capture.running.exchange(false))
+        return;
+    d->capture.writer.stop();
+    emit capturingChanged(false);
+}
+
+auto PlayEngine::isCapturing() const -> bool
+{
+    return d->capture.running;
 }
 
 auto PlayEngine::setVideoHighQualityDownscaling(bool on) -> void
 {
-    if (d->params.set_video_hq_downscaling(on))
+    if (d->params.set_video_hq_downscaling(on)) {
+        d->updateVideoRendererFboFormat();
         d->updateVideoSubOptions();
+    }
 }
 
 auto PlayEngine::setVideoHighQualityUpscaling(bool on) -> void
 {
 //    on &= OGL::is16bitFramebufferFormatSupported();
-    if (d->params.set_video_hq_upscaling(on))
+    if (d->params.set_video_hq_upscaling(on)) {
+        d->updateVideoRendererFboFormat();
         d->updateVideoSubOptions();
+    }
 }
 
 auto PlayEngine::seekToNextBlackFrame() -> void
@@ -1295,9 +1638,10 @@ auto PlayEngine::params() const -> const MrlState*
     return &d->params;
 }
 
-auto PlayEngine::setAutoselectMode_locked(bool enable, AutoselectMode mode,
-                                          const QString &ext, bool preferExternal) -> void
+auto PlayEngine::setAutoselectMode(bool enable, AutoselectMode mode,
+                                   const QString &ext, bool preferExternal) -> void
 {
+    QMutexLocker locker(&d->mutex);
     d->params.d->autoselect = enable;
     d->params.d->autoselectMode = mode;
     d->params.d->autoselectExt = ext;
@@ -8,6 +8,7 @@
 #include <QQmlListProperty>
 
 class VideoRenderer;                    class HistoryModel;
+class MediaProbeCache;
 struct DeintOptionSet;                  class ChannelLayoutMap;
 class AudioFormat;                      class VideoColor;
 class MetaData;                         struct OsdStyle;
@@ -32,6 +33,7 @@ class QOpenGLContext;                   class EncodingInfo;
 class SubComp;                          class SmbAuth;
 struct Autoloader;                      struct CacheInfo;
 struct IntrplParamSet;                  struct MotionIntrplOption;
+struct AudioZoneOption;                 class Pref;
 class AudioVisualizer;                  class QQuickWindow;
 class VideoSettings;                    class IntrplParamSetMap;
 
@@ -76,6 +78,7 @@ class PlayEngine : public QObject {
     Q_PROPERTY(bool playing READ isPlaying NOTIFY playingChanged)
     Q_PROPERTY(bool stopped READ isStopped NOTIFY stoppedChanged)
     Q_PROPERTY(bool seekable READ isSeekable NOTIFY seekableChanged)
+    Q_PROPERTY(bool capturing READ isCapturing NOTIFY capturingChanged)
     Q_PROPERTY(QString stateText READ stateText NOTIFY stateChanged)
     Q_PROPERTY(Waiting waiting READ waiting NOTIFY waitingChanged)
     Q_PROPERTY(QString waitingText READ waitingText NOTIFY waitingChanged)
@@ -115,12 +118,20 @@ public:
     auto state() const -> State;
     auto load(const Mrl &mrl, bool tryResume = true, const QString &sub = QString()) -> void;
     auto setMrl(const Mrl &mrl) -> void;
+    // queued in mpv to start without round trip at end-of-file
+    auto setNextMrl(const Mrl &mrl, bool tryResume = true) -> void;
+    auto nextMrl() const -> Mrl;
+    // decode and upload ahead while image or album art is shown,
+    // load() shows them at once
+    auto prefetchImages(const QList<Mrl> &mrls) -> void;
     auto edition() const -> EditionObject*;
     auto chapter() const -> ChapterObject*;
     auto editions() const -> const QVector<EditionObject*>&;
     auto chapters() const -> const QVector<ChapterObject*>&;
     auto seekEdition(int number, int from = 0) -> void;
     auto seekChapter(int number) -> void;
+    // mpv loops by itself with exact seeks, negative values clear the point
+    auto setABLoop(int a, int b) -> void;
     auto isAudioOnly() const -> bool;
     auto currentVideoStreamName() const -> QByteArray;
     auto currentAudioStreamTrack() const -> StreamTrack;
@@ -149,25 +160,43 @@ public:
     auto clearAllSubtitleSelection() -> void;
     auto setTrackSelected(StreamType type, int id, bool s) -> void;
 
-    auto lock() -> void;
-    auto setHwAcc_locked(bool use, const QList<CodecId> &codecs) -> void;
-    auto setSubtitleStyle_locked(const OsdStyle &style) -> void;
-    auto setAutoselectMode_locked(bool enable, AutoselectMode mode,
-                                  const QString &ext, bool preferExternal) -> void;
-    auto setCache_locked(const CacheInfo &info) -> void;
-    auto setSmbAuth_locked(const SmbAuth &smb) -> void;
-    auto setVolumeNormalizerOption_locked(const AudioNormalizerOption &option) -> void;
-    auto setDeintOptions_locked(const DeintOptionSet &set) -> void;
-    auto setAudioDevice_locked(const QString &device) -> void;
-    auto setVolumeControl_locked(int scale, bool soft) -> void;
-    auto setChannelLayoutMap_locked(const ChannelLayoutMap &map) -> void;
-    auto setPriority_locked(const QStringList &audio, const QStringList &sub) -> void;
-    auto setAutoloader_locked(const Autoloader &audio, const Autoloader &sub) -> void;
-    auto setResume_locked(bool resume) -> void;
-    auto setPreciseSeeking_locked(bool on) -> void;
-    auto setResyncAvWhenFilterToggled_locked(bool on) -> void;
-    auto setMotionIntrplOption_locked(const MotionIntrplOption &option) -> void;
-    auto unlock() -> void;
+    auto setHwAcc(bool use, const QList<CodecId> &codecs) -> void;
+    auto setSubtitleStyle(const OsdStyle &style) -> void;
+    auto setSubtitleGpuEffects(bool on) -> void;
+    auto setAutoselectMode(bool enable, AutoselectMode mode,
+                           const QString &ext, bool preferExternal) -> void;
+    // everything in preferences except smb authentication which is set before
+    // sent to mpv at once and reloaded only if what loading reads changed
+    auto setPreferences(const Pref &p) -> void;
+    auto setCache(const CacheInfo &info) -> void;
+    auto setSmbAuth(const SmbAuth &smb) -> void;
+    auto setVolumeNormalizerOption(const AudioNormalizerOption &option) -> void;
+    auto setDeintOptions(const DeintOptionSet &set) -> void;
+    auto setAudioDevice(const QString &device) -> void;
+    auto setVolumeControl(int scale, bool soft) -> void;
+    auto setChannelLayoutMap(const ChannelLayoutMap &map) -> void;
+    auto setPriority(const QStringList &audio, const QStringList &sub) -> void;
+    auto setAutoloader(const Autoloader &audio, const Autoloader &sub) -> void;
+    auto setResume(bool resume) -> void;
+    auto setPreciseSeeking(bool on) -> void;
+    // smaller subtitle look-ahead and idle release of video buffers
+    auto setLowMemory(bool on) -> void;
+    // 0 for exact seeking always
+    auto setKeyframeSnapping(int tolerance) -> void;
+    // log summary of playback statistics when file ends
+    auto setStatsSummary(bool on) -> void;
+    auto setResyncAvWhenFilterToggled(bool on) -> void;
+    // smaller output buffer and less look-ahead in filters
+    auto setAudioLowLatency(bool on) -> void;
+    // other devices which play the same audio along with main device
+    auto setAudioZones(const QList<AudioZoneOption> &zones) -> void;
+    auto setMotionIntrplOption(const MotionIntrplOption &option) -> void;
+    // of monitor under window, call whenever it changes
+    auto setRefreshRate(qreal hz) -> void;
+    auto setDynamicResolution(bool on) -> void;
+    auto setDisplaySync(bool on) -> void;
+    // 0 threads for adaptive count
+    auto setDecoderThreads(int threads, bool lowLatency) -> void;
 
     auto params() const -> const MrlState*;
     auto default_() const -> const MrlState*;
@@ -175,6 +204,7 @@ public:
     auto adjustVideoAspectRatio(double by) -> void;
     auto setVideoAspectRatio(double ratio) -> void;
     auto setVideoCropRatio(double ratio) -> void;
+    auto setVideoAutoCrop(bool on) -> void;
     auto setVideoHighQualityUpscaling(bool on) -> void;
     auto setVideoHighQualityDownscaling(bool on) -> void;
     auto setVideoVerticalAlignment(VerticalAlignment a) -> void;
@@ -286,6 +316,10 @@ public:
     auto takeSnapshot() -> void;
     auto snapshot(QImage *frame, QImage *osd) -> int;
     auto clearSnapshots() -> void;
+    // write every nth rendered frame into images in folder or raw stream
+    Q_INVOKABLE bool startCapture(const QString &path, int every = 1, bool osd = false);
+    Q_INVOKABLE void stopCapture();
+    auto isCapturing() const -> bool;
     auto waitingText() const -> QString;
     auto stateText() const -> QString;
 
@@ -294,6 +328,7 @@ public:
     auto begin_s() const -> int;
     auto end_s() const -> int;
     auto setHistory(HistoryModel *history) -> void;
+    auto setProbeCache(MediaProbeCache *probes) -> void;
 public slots:
     void seek(int pos);
 signals:
@@ -306,7 +341,7 @@ signals:
     void endSyncMrlState();
     void sought();
     void started(Mrl mrl);
-    void finished(Mrl mrl, bool eof);
+    void finished(Mrl mrl, bool eof, bool queued);
     void tick(int pos);
     void mrlChanged(const Mrl &mrl);
     void stateChanged(PlayEngine::State state);
@@ -335,6 +370,7 @@ signals:
     void runningChanged();
     void deintOptionsChanged();
     void snapshotTaken();
+    void capturingChanged(bool capturing);
     void subtitleSelectionChanged();
     void framebufferObjectFormatChanged(FramebufferObjectFormat format);
     void audioOnlyChanged(bool audioOnly);
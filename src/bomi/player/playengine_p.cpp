@@ -1,5 +1,6 @@
 #include "playengine_p.hpp"
-#include <QQmlEngine>
+#include "quick/infosubscriber.hpp"
+#include "misc/tracer.hpp"
 #include <QTextCodec>
 
 template<class T>
@@ -66,12 +67,40 @@ auto PlayEngine::Data::vf(const MrlState *s) const -> QByteArray
     vf.add("noformat:address"_b, vp);
     vf.add("swdec_deint"_b, s->d->deint.swdec.toString().toLatin1());
     vf.add("hwdec_deint"_b, s->d->deint.hwdec.toString().toLatin1());
+    vf.add("deint_threads"_b, s->d->deint.threads);
+    vf.add("deint_detect"_b, (int)s->d->deint.detect);
     vf.add("interpolate"_b, (int)s->video_motion_interpolation());
+    return vf.get() + ':' + vfChain(s);
+}
+
+// options of vf which cannot be changed without building chain again
+auto PlayEngine::Data::vfChain(const MrlState *s) const -> QByteArray
+{
+    OptionList vf(':');
     vf.add("color_space"_b, (int)s->video_space());
     vf.add("color_range"_b, (int)s->video_range());
     return vf.get();
 }
 
+auto PlayEngine::Data::updateVideoFilter() -> void
+{
+    mutex.lock();
+    const auto deint = params.d->deint;
+    mutex.unlock();
+    // running filter takes the others in place
+    vp->setDeintOptions(deint);
+    vp->setMotionInterpolation(params.video_motion_interpolation());
+    if (_Change(sentVf, vfChain(&params)))
+        mpv.tellAsync("vf", "set"_b, vf(&params));
+}
+
+auto PlayEngine::Data::updateAudioFilter() -> void
+{
+    // every option of af is applied in place
+    ac->setTempoScalerActivated(params.audio_tempo_scaler());
+    ac->setNormalizerActivated(params.audio_volume_normalizer());
+}
+
 auto PlayEngine::Data::vo(const MrlState *s) const -> QByteArray
 {
     return "opengl-cb:" + videoSubOptions(s);
@@ -104,30 +133,44 @@ auto PlayEngine::Data::videoSubOptions(const MrlState *s) const -> QByteArray
         return matrix;
     };
 
-    static const QByteArray shader =
-            "const mat4 c_matrix = mat4(__C_MATRIX__); color = c_matrix * color;";
-    auto customShader = [] (const QMatrix4x4 &c_matrix) -> QByteArray {
+    // gl_video folds this into its yuv to rgb matrix, so color adjustments
+    // cost no extra shader operation and changing them never relinks
+    auto colorMatrix = [] (const QMatrix4x4 &c_matrix) -> QByteArray {
         QByteArray mat;
-        for (int c = 0; c < 4; ++c) {
-            mat += "vec4(";
-            for (int r = 0; r < 4; ++r) {
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
                 mat += QByteArray::number(c_matrix(r, c), 'e');
                 mat += ',';
             }
-            mat[mat.size()-1] = ')';
-            mat += ',';
         }
         mat.chop(1);
-        auto cs = shader;
-        cs.replace("__C_MATRIX__", mat);
-        return '%' + QByteArray::number(cs.length()) + '%' + cs;
+        return '%' + QByteArray::number(mat.length()) + '%' + mat;
+    };
+
+    // frames marked as fields by hwdec deinterlacing are rebuilt in gl_video
+    auto deint = [] (DeintMethod method) -> QByteArray {
+        switch (method) {
+        case DeintMethod::Bob:       return "bob"_b;
+        case DeintMethod::LinearBob: return "linear"_b;
+        case DeintMethod::CubicBob:  return "cubic"_b;
+        case DeintMethod::Yadif:     return "yadif"_b;
+        default:                     return "no"_b;
+        }
+    };
+
+    // bilinear scalers are used while gpu cannot keep up with display
+    auto scaler = [&] (const IntrplParamSetMap &map, Interpolator type,
+                       const char *name) -> QByteArray {
+        return map[dynres.cheap ? Interpolator::Bilinear : type].toMpvOption(name);
     };
 
     OptionList opts(':');
-    opts.add("scale", s->d->intrpl[s->video_interpolator()].toMpvOption("scale"));
-    opts.add("cscale", s->d->chroma[s->video_chroma_upscaler()].toMpvOption("cscale"));
+    opts.add("scale", scaler(s->d->intrpl, s->video_interpolator(), "scale"));
+    opts.add("cscale", scaler(s->d->chroma, s->video_chroma_upscaler(), "cscale"));
     if (useIntrplDown)
-        opts.add("dscale", s->d->intrplDown[s->video_interpolator_down()].toMpvOption("dscale"));
+        opts.add("dscale", scaler(s->d->intrplDown, s->video_interpolator_down(), "dscale"));
+    // software decoded frames are uploaded from pixel buffers
+    opts.add("pbo", true);
     opts.add("dither-depth", "auto"_b);
     opts.add("dither", _EnumData(s->video_dithering()));
     opts.add("frame-queue-size", s->video_motion_interpolation() || vp->isSkipping() ? 1 : 3);
@@ -135,11 +178,18 @@ auto PlayEngine::Data::videoSubOptions(const MrlState *s) const -> QByteArray
     opts.add("fancy-downscaling", s->video_hq_downscaling());
     opts.add("sigmoid-upscaling", s->video_hq_upscaling() && OGL::is16bitFramebufferFormatSupported());
     opts.add("interpolation", s->video_motion_interpolation());
-    const bool rgba16 = vr->framebufferObjectFormat() == OGL::RGBA16_UNorm;
-    opts.add("fbo-format", rgba16 ? "rgba16"_b : "rgba"_b);
+    opts.add("deint", deint(s->d->deint.hwdec.method));
+    auto fboFormat = [] (OGL::TextureFormat format) -> QByteArray {
+        switch (format) {
+        case OGL::RGBA16_UNorm:  return "rgba16"_b;
+        case OGL::RGB10A2_UNorm: return "rgb10_a2"_b;
+        default:                 return "rgba"_b;
+        }
+    };
+    opts.add("fbo-format", fboFormat(vr->framebufferObjectFormat()));
     const auto cmat = c_matrix();
     if (!cmat.isIdentity())
-        opts.add("custom-shader", customShader(cmat));
+        opts.add("color-matrix", colorMatrix(cmat));
     return opts.get();
 }
 
@@ -150,35 +200,191 @@ auto PlayEngine::Data::updateVideoScaler() -> void
     vr->setScalerEnabled(use);
 }
 
+auto PlayEngine::Data::setDynamicResolution(double scale, bool cheap) -> void
+{
+    dynres.cooldown = 5;
+    dynres.headroom = 0;
+    if (_Change(dynres.scale, scale))
+        vr->setRenderScale(scale);
+    if (_Change(dynres.cheap, cheap))
+        updateVideoSubOptions();
+    _Debug("Dynamic resolution: scale=%%, cheap scalers=%%", scale, cheap);
+}
+
+auto PlayEngine::Data::updateDynamicResolution() -> void
+{
+    static constexpr double MinScale = 0.5, Step = 0.8;
+    if (!dynres.enabled || !hasVideo)
+        return;
+    if (dynres.cooldown > 0) {
+        --dynres.cooldown;
+        return;
+    }
+    // about a quarter second of frames, so old scales fade out quickly
+    const auto stats = timing.stats(15);
+    if (stats.samples < 15)
+        return;
+    const auto &video = stats.passes[RenderTiming::Video];
+    const auto &osd = stats.passes[RenderTiming::Osd];
+    const double cost = video.gpu >= 0 ? video.gpu + qMax(0.0, osd.gpu)
+                                       : video.cpu + osd.cpu;
+    const double budget = stats.period > 0 ? stats.period : 1000.0 / 60.0;
+    if (cost > budget * 0.85) {
+        // resolution first, then scalers
+        if (dynres.scale > MinScale)
+            setDynamicResolution(qMax(MinScale, dynres.scale * Step), dynres.cheap);
+        else if (!dynres.cheap)
+            setDynamicResolution(dynres.scale, true);
+    } else if (cost < budget * 0.5) {
+        // recover in reverse order after two seconds of headroom
+        if (++dynres.headroom < 20)
+            return;
+        if (dynres.cheap)
+            setDynamicResolution(dynres.scale, false);
+        else if (dynres.scale < 1.0)
+            setDynamicResolution(qMin(1.0, dynres.scale / Step), false);
+    } else
+        dynres.headroom = 0;
+}
+
+auto PlayEngine::Data::updateStats() -> void
+{
+    auto &video = info.video;
+    video.decoder()->setBitrate(mpv.get<int>("video-bitrate"));
+    video.setDelayedFrames(info.delayed);
+    video.setDroppedFrames(mpv.get<int64_t>("vo-drop-frame-count"));
+    video.setDecoderStats(mpv.get<double>("video-decode-time"),
+                          mpv.get<int>("video-decoder-queue"),
+                          mpv.get<int>("drop-frame-count"));
+    video.setDecoderThreads(vdThreads);
+    info.audio.setLatency((ac->delay() + mpv.get<double>("ao-delay")) * 1e3);
+    video.timing()->update(video.droppedFrames());
+    video.stats()->update();
+    info.audio.profile()->update();
+}
+
+// stats are polled only while somebody displays them
+auto PlayEngine::Data::updateStatsTimer() -> void
+{
+    const int interval = InfoSubscription::get()->interval();
+    if (interval > 0 && p->isRunning()) {
+        info.statsTimer.setInterval(interval);
+        if (!info.statsTimer.isActive()) {
+            info.statsTimer.start();
+            updateStats();
+        }
+    } else
+        info.statsTimer.stop();
+}
+
+auto PlayEngine::Data::updateDisplaySync() -> void
+{
+    // beyond this, pitch shift would be audible
+    static constexpr double MaxAdjust = 0.01;
+    if (!dsync.enabled)
+        return;
+    if (dsync.cooldown > 0) {
+        --dsync.cooldown;
+        return;
+    }
+    dsync.cooldown = 9;
+    const double fps = info.video.decoder()->fps();
+    const auto stats = timing.stats();
+    double factor = 1.0;
+    // motion interpolation and skipping make their own cadence
+    if (hasVideo && !vp->isSkipping() && !params.video_motion_interpolation()
+            && fps > 1.0 && stats.samples >= RenderTiming::History / 2) {
+        const double hz = 1000.0 / stats.vsync;
+        // each frame stays for the same number of refreshes
+        const double repeat = qRound(hz / fps);
+        if (repeat >= 1) {
+            const double f = hz / repeat / fps;
+            if (qAbs(f - 1.0) <= MaxAdjust)
+                factor = f;
+        }
+    }
+    // measured vsync wanders a little, do not chase every sample
+    if (qAbs(factor - dsync.factor) > 1e-4 || (factor == 1.0 && dsync.factor != 1.0))
+        setDisplaySyncFactor(factor);
+}
+
+auto PlayEngine::Data::setDisplaySyncFactor(double factor) -> void
+{
+    if (dsync.factor == factor)
+        return;
+    _Debug("Display sync speed factor: %%", factor);
+    dsync.factor = factor;
+    ac->setSyncScale(factor);
+    if (!vp->isSkipping())
+        mpv.setAsync("speed", speed(params.play_speed()));
+}
+
+// cheapest format which keeps source depth
+auto PlayEngine::Data::negotiateFboFormat() const -> OGL::TextureFormat
+{
+    auto supports = [] (OGL::TextureFormat format)
+        { return OGL::isSupportedFrambufferFormat(format); };
+    const auto fallback = OGL::is16bitFramebufferFormatSupported()
+            ? OGL::RGBA16_UNorm : OGL::RGBA8_UNorm;
+    // linear light scaling bands below 16 bits
+    if (params.video_hq_upscaling() || params.video_hq_downscaling())
+        return fallback;
+    const int depth = info.video.filter()->depth();
+    if (depth <= 0)
+        return fallback;
+    if (depth <= 8 && supports(OGL::RGBA8_UNorm))
+        return OGL::RGBA8_UNorm;
+    if (depth <= 10 && supports(OGL::RGB10A2_UNorm))
+        return OGL::RGB10A2_UNorm;
+    return fallback;
+}
+
 auto PlayEngine::Data::updateVideoRendererFboFormat() -> void
 {
     auto gl = _EnumData(fboFormat);
     if (gl == OGL::NoTextureFormat)
-        gl = OGL::is16bitFramebufferFormatSupported() ? OGL::RGBA16_UNorm : OGL::RGBA8_UNorm;
+        gl = negotiateFboFormat();
+    if (vr->framebufferObjectFormat() == gl)
+        return;
+    _Debug("Use %% for video framebuffer.", gl);
     vr->setFramebufferObjectFormat(gl);
 }
 
+auto PlayEngine::Data::updateVideoFboFormat() -> void
+{
+    const auto prev = vr->framebufferObjectFormat();
+    updateVideoRendererFboFormat();
+    if (vr->framebufferObjectFormat() != prev)
+        updateVideoSubOptions();
+}
+
 auto PlayEngine::Data::updateVideoSubOptions() -> void
 {
     mutex.lock();
     auto opts = videoSubOptions(&params);
+    const bool changed = _Change(sentVo, opts);
     mutex.unlock();
-    mpv.tellAsync("vo_cmdline", videoSubOptions(&params));
+    // vo parses and applies every sub-option again
+    if (changed)
+        mpv.tellAsync("vo_cmdline", opts);
 }
 
-auto PlayEngine::Data::loadfile(const Mrl &mrl, bool resume, const QString &sub) -> void
+auto PlayEngine::Data::loadfile(const Mrl &mrl, bool resume, const QString &sub,
+                                bool append) -> void
 {
     QString file = mrl.isLocalFile() ? mrl.toLocalFile() : mrl.toString();
     if (file.isEmpty())
         return;
     OptionList opts;
-    opts.add("pause"_b, p->isPaused() || hasImage);
+    // appended entry follows pause state at the time it starts
+    if (!append)
+        opts.add("pause"_b, p->isPaused() || hasImage);
     opts.add("resume-playback", resume);
     if (!sub.isEmpty())
         opts.add("sub-file", sub.toUtf8(), true);
     if (!mrl.name().isEmpty() && mrl.isCueTrack())
         opts.addRaw("media-title", mrl.name().toUtf8());
-    mpv.tell("loadfile"_b, file.toUtf8(), "replace"_b, opts.get());
+    mpv.tell("loadfile"_b, file.toUtf8(), append ? "append"_b : "replace"_b, opts.get());
 }
 
 auto PlayEngine::Data::updateMediaName(const QString &name) -> void
@@ -198,14 +404,180 @@ auto PlayEngine::Data::updateMediaName(const QString &name) -> void
 
 static constexpr const auto QCI = Qt::CaseInsensitive;
 
+class LoadStageJob : public QRunnable {
+public:
+    LoadStageJob(LoadStages *stages, LoadStages::Stage stage,
+                 std::function<void(void)> &&func)
+        : m_stages(stages), m_stage(stage), m_func(std::move(func)) { }
+    auto run() -> void final
+    {
+        QElapsedTimer timer;
+        timer.start();
+        m_func();
+        m_stages->msecs[m_stage] = timer.elapsed();
+        m_stages->done.release();
+    }
+private:
+    LoadStages *m_stages = nullptr;
+    LoadStages::Stage m_stage;
+    std::function<void(void)> m_func;
+};
+
+auto LoadStages::run(QThreadPool *pool, Stage stage,
+                     std::function<void(void)> &&func) -> void
+{
+    ++started;
+    pool->start(new LoadStageJob(this, stage, std::move(func)));
+}
+
+// called in gui thread when another file is requested
+class KeyframeJob : public QRunnable {
+public:
+    KeyframeJob(QObject *obj, const Mrl &mrl,
+                const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_obj(obj), m_mrl(mrl), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        const auto index = KeyframeIndex::build(m_mrl.toLocalFile(), *m_cancel);
+        if (!*m_cancel && !index.isEmpty())
+            _PostEvent(m_obj, KeyframesReady, m_mrl, index);
+    }
+private:
+    QObject *m_obj = nullptr;
+    Mrl m_mrl;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
+auto PlayEngine::Data::snapToKeyframe(int ms) const -> int
+{
+    if (!preciseSeeking || keyframes.tolerance <= 0 || keyframes.mrl != mrl)
+        return -1;
+    const int key = keyframes.index.nearest(ms);
+    return key >= 0 && qAbs(key - ms) <= keyframes.tolerance ? key : -1;
+}
+
+auto PlayEngine::Data::cancelKeyframes() -> void
+{
+    if (keyframes.cancel)
+        *keyframes.cancel = true;
+    keyframes.cancel.clear();
+    keyframes.index = KeyframeIndex();
+    keyframes.mrl = Mrl();
+}
+
+// index is built only for local video when snapping can be used
+auto PlayEngine::Data::loadKeyframes() -> void
+{
+    const bool use = preciseSeeking && keyframes.tolerance > 0 && mrl.isLocalFile()
+                     && !hasImage;
+    if (!use) {
+        cancelKeyframes();
+        return;
+    }
+    if (keyframes.mrl == mrl)
+        return;
+    cancelKeyframes();
+    keyframes.mrl = mrl;
+    if (probes)
+        keyframes.index = probes->findKeyframes(mrl);
+    if (!keyframes.index.isEmpty())
+        return;
+    keyframes.cancel.reset(new std::atomic<bool>(false));
+    keyframePool.start(new KeyframeJob(p, mrl, keyframes.cancel));
+}
+
+// called in gui thread when another file is requested
+class OverviewJob : public QRunnable {
+public:
+    OverviewJob(QObject *obj, const Mrl &mrl,
+                const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_obj(obj), m_mrl(mrl), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        // decoding whole file must not take cpu from playback
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        const auto overview = AudioOverview::build(m_mrl.toLocalFile(), *m_cancel);
+        if (!*m_cancel && !overview.isEmpty())
+            _PostEvent(m_obj, OverviewReady, m_mrl, overview);
+    }
+private:
+    QObject *m_obj = nullptr;
+    Mrl m_mrl;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
+auto PlayEngine::Data::setOverview(const AudioOverview &overview) -> void
+{
+    info.audio.setOverview(overview);
+    ac->setFileLoudness(overview.loudness());
+}
+
+auto PlayEngine::Data::cancelOverview() -> void
+{
+    if (overview.cancel)
+        *overview.cancel = true;
+    overview.cancel.clear();
+    overview.mrl = Mrl();
+    setOverview(AudioOverview());
+}
+
+// envelope is decoded only once for local files, then found in probe cache
+auto PlayEngine::Data::loadOverview() -> void
+{
+    if (!mrl.isLocalFile() || hasImage) {
+        cancelOverview();
+        return;
+    }
+    if (overview.mrl == mrl)
+        return;
+    cancelOverview();
+    overview.mrl = mrl;
+    if (probes)
+        setOverview(probes->findOverview(mrl));
+    if (info.audio.hasOverview())
+        return;
+    overview.cancel.reset(new std::atomic<bool>(false));
+    overviewPool.start(new OverviewJob(p, mrl, overview.cancel));
+}
+
+auto PlayEngine::Data::cancelLoad() -> void
+{
+    loadSerial.ref();
+    if (youtube)
+        youtube->cancel();
+    if (yle)
+        yle->cancel();
+}
+
+// frame threading of h264/hevc scales over many cores while older codecs
+// mostly decode with slices and only gain latency from more threads
+SCA decoderThreads(CodecId codec, int user) -> int
+{
+    if (user > 0)
+        return qMin(user, 16);
+    const int cores = qMax(1, QThread::idealThreadCount());
+    switch (codec) {
+    case CodecId::Mpeg1: case CodecId::Mpeg2: case CodecId::Mpeg4:
+    case CodecId::Vc1:   case CodecId::Wmv3:
+        return qMin(cores, 4);
+    default:
+        // one extra for load balancing, lavc does not go beyond 16
+        return qMin(cores + 1, 16);
+    }
+}
+
 auto PlayEngine::Data::onLoad() -> void
 {
+    ttff.timer.start();
+    ttff.pending = true;
+    const int serial = loadSerial.load();
+    const auto config = this->config();
     auto file = mpv.get<MpvFile>("stream-open-filename");
     const auto sub = mpv.get<MpvUtf8>("file-local-options/sub-file").data;
     mpv.setAsync("file-local-options/sub-file", MpvFileList());
     t.local = localCopy();
     t.seekable = t.begin = t.duration = -1;
-    t.offset = 0;
+    clock.offset = t.offset = 0;
     auto local = t.local.data();
 
     Mrl mrl(file);
@@ -228,10 +600,6 @@ auto PlayEngine::Data::onLoad() -> void
         local->set_audio_tracks(StreamList());
         local->set_sub_tracks(StreamList());
         local->set_sub_tracks_inclusive(StreamList());
-        found = history->getState(local);
-        resume = mpv.get<bool>("options/resume-playback") && this->resume;
-        if (resume)
-            start = local->resume_position();
     } else {
         start = reload;
         local->set_device(mrl.device());
@@ -241,7 +609,7 @@ auto PlayEngine::Data::onLoad() -> void
     if (mrl.isCueTrack()) {
         const auto track = mrl.toCueTrack();
         file.data = track.file;
-        t.offset = t.begin = track.start;
+        clock.offset = t.offset = t.begin = track.start;
         mpv.setAsync("file-local-options/start", QByteArray::number(track.start * 1e-3, 'f'));
         if (track.end != -1) {
             mpv.setAsync("file-local-options/end", QByteArray::number(track.end * 1e-3, 'f'));
@@ -250,7 +618,7 @@ auto PlayEngine::Data::onLoad() -> void
     }
 
     if (file.data.startsWith("smb://"_a, QCI)) {
-        auto smb = local->d->smb;
+        auto smb = config->smb;
         QUrl url = smb.translate(QUrl(file));
         bool ok = false;
         for (;;) {
@@ -274,6 +642,41 @@ auto PlayEngine::Data::onLoad() -> void
         }
     }
 
+    // state lookup, file discovery and url resolution do not depend on each other
+    LoadStages stages;
+    if (reload < 0)
+        stages.run(&loadPool, LoadStages::State, [&] () { found = history->getState(local); });
+    MpvFileList audioFiles, subFiles;
+    if (mrl.isLocalFile()) {
+        stages.run(&loadPool, LoadStages::Files, [&] () {
+            audioFiles = autoloadFiles(StreamAudio, mrl);
+            subFiles = autoloadFiles(StreamSubtitle, mrl);
+        });
+    }
+    const bool http = file.data.startsWith("http://"_a, QCI)
+                      || file.data.startsWith("https://"_a, QCI);
+    bool yleUrl = false, resolved = false;
+    if (http) {
+        file = QUrl(file).toString(QUrl::FullyEncoded);
+        if (file != ytResult.mrl)
+            ytResult.clear();
+        yleUrl = yle && yle->supports(file);
+        if (yleUrl || (ytResult.mrl != file && youtube)) {
+            stages.run(&loadPool, LoadStages::Url, [&] () {
+                resolved = yleUrl ? yle->run(file) : youtube->run(file);
+            });
+        }
+    }
+    stages.wait();
+    ttff.stages = stages.msecs;
+    if (serial != loadSerial.load())
+        _Debug("Loading %% has been canceled.", mrl.toString());
+    if (reload < 0) {
+        resume = mpv.get<bool>("options/resume-playback") && config->resume;
+        if (resume)
+            start = local->resume_position();
+    }
+
     auto setFiles = [&] (QByteArray &&name, QByteArray &&nid,
             const StreamList &list) {
         MpvFileList files; int id = -1;
@@ -293,11 +696,10 @@ auto PlayEngine::Data::onLoad() -> void
 
     if (found && local->audio_tracks().isValid())
         setFiles("file-local-options/audio-file"_b, "file-local-options/aid"_b, local->audio_tracks());
-    else {
-        QMutexLocker locker(&mutex);
-        mpv.setAsync("file-local-options/audio-file", autoloadFiles(StreamAudio));
-    }
+    else
+        mpv.setAsync("file-local-options/audio-file", audioFiles);
     QVector<SubComp> loads;
+    MpvFileList autoSubs;
     auto loadSub = [&] (auto &&res) {
         MpvFileList files, encs;
         _R(files, loads) = res;
@@ -321,8 +723,9 @@ auto PlayEngine::Data::onLoad() -> void
             setFiles("file-local-options/sub-file"_b, "file-local-options/sid"_b, local->sub_tracks());
             loads = restoreInclusiveSubtitles(local->sub_tracks_inclusive(), EncodingInfo(), -1);
         } else {
-            QMutexLocker locker(&mutex);
-            loadSub(autoloadSubtitle(local));
+            // parsed in background and attached when ready
+            autoSubs = subFiles;
+            mpv.setAsync("file-local-options/sid", "auto"_b);
         }
     } else {
         QMutexLocker locker(&mutex);
@@ -341,12 +744,31 @@ auto PlayEngine::Data::onLoad() -> void
     else
         start = -1;
 
+    // codec is known only from earlier playback before demuxer opens
+    StreamList videos = local->video_tracks();
+    if (videos.isEmpty() && probes)
+        videos = probes->find(mrl).video;
+    auto codec = CodecId::Invalid;
+    for (auto &track : videos) {
+        if (codec == CodecId::Invalid || track.isSelected())
+            codec = CodecIdInfo::fromData(track.codec());
+    }
+    vdThreads = decoderThreads(codec, config->decoderThreads);
+    mpv.setAsync("file-local-options/vd-lavc-threads", vdThreads.load());
+    if (config->lowLatencyDecoding)
+        mpv.setAsync("file-local-options/vd-lavc-o", "thread_type=slice"_b);
+
     const auto deint = local->video_deinterlacing() != DeintMode::None;
-    mpv.setAsync("speed", local->play_speed());
-    mpv.setAsync("video-rotate", _EnumData(local->video_rotation()));
+    mpv.setAsync("speed", speed(local->play_speed()));
 
     mpv.setAsync("options/vo", vo(local));
     mpv.setAsync("options/vf", vf(local));
+    if (!append) {
+        mutex.lock();
+        sentVo = videoSubOptions(local);
+        mutex.unlock();
+        sentVf = vfChain(local);
+    }
     mpv.setAsync("options/deinterlace", deint ? "yes"_b : "no"_b);
 
     mpv.setAsync("options/af", af(local));
@@ -359,28 +781,29 @@ auto PlayEngine::Data::onLoad() -> void
     mpv.setAsync("options/sub-visibility", !local->sub_hidden());
     mpv.setAsync("options/sub-delay", local->sub_sync() * 1e-3);
 
-    const auto cache = local->d->cache.get(mrl);
+    const auto &item = config->cache.get(mrl);
+    auto cache = item;
     t.caching = cache.kb > 0LL;
     if (t.caching) {
+        auto initial = config->cache.playback_kb(cache.kb);
+        if (config->cache.adaptive && &item == &config->cache.network)
+            adaptCache(mrl, cache, initial);
         mpv.setAsync("file-local-options/cache", cache.kb);
-        mpv.setAsync("file-local-options/cache-initial", local->d->cache.playback_kb(cache.kb));
-        mpv.setAsync("file-local-options/cache-seek-min", local->d->cache.seeking_kb(cache.kb));
+        mpv.setAsync("file-local-options/cache-initial", initial);
+        mpv.setAsync("file-local-options/cache-seek-min", config->cache.seeking_kb(cache.kb));
         mpv.setAsync("file-local-options/cache-secs", cache.sec);
         mpv.setAsync("file-local-options/cache-file", cache.file ? "TMP"_b : ""_b);
-        mpv.setAsync("file-local-options/cache-file-size", local->d->cache.file_kb);
+        mpv.setAsync("file-local-options/cache-file-size", config->cache.file_kb);
     } else
         mpv.setAsync("file-local-options/cache", "no"_b);
 
-    if (file.data.startsWith("http://"_a, QCI) || file.data.startsWith("https://"_a, QCI)) {
-        file = QUrl(file).toString(QUrl::FullyEncoded);
-        if (file != ytResult.mrl)
-            ytResult.clear();
-        if (yle && yle->supports(file)) {
-            if (yle->run(file)) {
+    if (http) {
+        if (yleUrl) {
+            if (resolved) {
                 start = -1;
                 file = yle->url();
             }
-        } else if (ytResult.mrl == file || (youtube && youtube->run(file))) {
+        } else if (ytResult.mrl == file || resolved) {
             mpv.setAsync("file-local-options/cookies", true);
             mpv.setAsync("file-local-options/cookies-file", MpvFile(youtube->cookies()).toMpv());
             mpv.setAsync("file-local-options/user-agent", youtube->userAgent().toUtf8());
@@ -421,6 +844,11 @@ auto PlayEngine::Data::onLoad() -> void
                     mpv.setAsync("file-local-options/demuxer-lavf-o", "fflags=+ignidx"_b);
                 }
             }
+        } else {
+            // plain file is read from its download in cache if enabled
+            const auto served = downloads.url(file.data);
+            if (!served.isEmpty())
+                file = served;
         }
     } else
         ytResult.clear();
@@ -443,9 +871,17 @@ auto PlayEngine::Data::onLoad() -> void
     _PostEvent(p, SyncMrlState, t.local, loads, ytResult);
     t.local.clear();
 
+    // posted after SyncMrlState so that components are added, not replaced
+    const int subs = subSerial.fetchAndAddOrdered(1) + 1;
+    if (!autoSubs.names.isEmpty() && serial == loadSerial.load()) {
+        loadSubtitleFiles(autoSubs.names, [=] (const QSharedPointer<SubtitleLoads> &loads)
+            { _PostEvent(p, SubtitlesLoaded, subs, loads); });
+    }
+
     mutex.lock();
     playingVideo = file.toMpv();
     mutex.unlock();
+    ttff.hook = ttff.timer.elapsed();
 }
 
 auto PlayEngine::Data::onUnload() -> void
@@ -457,6 +893,55 @@ auto PlayEngine::Data::onUnload() -> void
     t.local->set_edition(info.edition.number());
 }
 
+auto PlayEngine::Data::showSlide(const Mrl &mrl) -> bool
+{
+    // msec of cross fade between slides
+    static constexpr int Fade = 300;
+    if (!hasImage || !vr->hasFrame() || !mrl.isImage() || !mrl.isLocalFile())
+        return false;
+    const auto size = QSizeF(vr->width(), vr->height()) * vr->devicePixelRatio();
+    slides.setTargetSize(size.toSize());
+    const auto image = slides.get(mrl.toLocalFile());
+    // mpv reports broken one as usual
+    if (image.isNull())
+        return false;
+    vr->setImage(image, Fade);
+    return true;
+}
+
+auto PlayEngine::Data::updateAlbumArt() -> void
+{
+    if (hasImage)
+        return;
+    const auto file = hasAlbumArt && mrl.isLocalFile() ? mrl.toLocalFile() : QString();
+    if (!_Change(albumArt, file))
+        return;
+    if (file.isEmpty()) {
+        vr->setImage(QImage());
+        return;
+    }
+    const auto size = QSizeF(vr->width(), vr->height()) * vr->devicePixelRatio();
+    slides.setTargetSize(size.toSize());
+    const auto image = slides.cached(file);
+    if (image.isNull())
+        slides.prefetch(file);
+    else
+        vr->setImage(image);
+}
+
+auto PlayEngine::Data::moveMouse(bool force) -> void
+{
+    if (nav.moving && !force) {
+        nav.pending = true;
+        return;
+    }
+    nav.pending = false;
+    ++nav.moving;
+    mpv.tellAsync("mouse", mouse.x(), mouse.y());
+    mpv.tellAsyncThen([=] (bool) { _PostEvent(p, DiscMouseMoved); },
+                      "discnav", "mouse_move"_b);
+}
+
 auto PlayEngine::Data::hook() -> void
 {
     mpv.hook("on_load", [=] () { onLoad(); });
@@ -487,16 +972,21 @@ auto PlayEngine::Data::observe() -> void
     }, [=] (bool s) { if (_Change(seekable, s)) emit p->seekableChanged(seekable); });
 
     auto updateChapter = [=] (int n) {
-        info.chapter.invalidate();
+        ChapterData current;
         for (auto chapter : info.chapters) {
             chapter->setRate(p->rate(chapter->time()));
             if (chapter->number() == n)
-                info.chapter.set(chapter->m);
+                current = chapter->m;
         }
-        emit p->chapterChanged();
+        if (info.chapter.set(current))
+            emit p->chapterChanged();
     };
 
-    mpv.observeTime("avsync", avSync, [=] () { emit p->avSyncChanged(avSync); });
+    mpv.observeTime("avsync", avSync, [=] () {
+        stats.pushAvSync(avSync);
+        if (InfoSubscription::get()->isActive())
+            emit p->avSyncChanged(avSync);
+    });
     mpv.observe("time-pos", [=] () {
         int ctime = 0;
         if (t.caching)
@@ -505,15 +995,7 @@ auto PlayEngine::Data::observe() -> void
             QMetaObject::invokeMethod(&info.cache, "setTime",
                                       Qt::QueuedConnection, Q_ARG(int, ctime));
         return s2ms(mpv.get<double>("time-pos")) - t.offset;
-    }, [=] (int pos) {
-        if (!_Change(time, pos))
-            return;
-        emit p->tick(time);
-        if (_Change(time_s, time/1000))
-            emit p->time_sChanged();
-        sr->render(time);
-        info.video.setFrameNumber(calcFrameCount(info.video.decoder()->fps(), time - begin));
-    });
+    }, [=] (int pos) { sampleTime(pos); });
     mpv.observe("time-start", [=] () {
         return (t.begin < 0 ? s2ms(mpv.get<double>("time-start")) : t.begin) - t.offset;
     }, [=] (int ms) {
@@ -543,36 +1025,35 @@ auto PlayEngine::Data::observe() -> void
         info.video.setFrameCount(calcFrameCount(info.video.decoder()->fps(), duration));
     });
 
-    mpv.observe("chapter-list", [=] () {
-        const auto array = mpv.get<QVariant>("chapter-list").toList();
-        QVector<ChapterData> data(array.size());
-        for (int i=0; i<array.size(); ++i) {
-            const auto map = array[i].toMap();
-            data[i].number = i;
-            data[i].time = s2ms(map[u"time"_q].toDouble()) - t.offset;
-            data[i].name = map[u"title"_q].toString();
-            if (data[i].name.isEmpty())
-                data[i].name = _MSecToString(data[i].time, u"hh:mm:ss.zzz"_q);
-        }
-        return data;
-    }, [=] (auto &&data) {
-        for (auto chapter : info.chapters)
-            QQmlEngine::setObjectOwnership(chapter, QQmlEngine::JavaScriptOwnership);
-        info.chapters.resize(data.size());
-        for (int i = 0; i < data.size(); ++i) {
-            info.chapters[i] = new ChapterObject;
-            info.chapters[i]->set(data[i]);
-        }
-        emit p->chaptersChanged();
+    mpv.observe("chapter-list", [=] () { return toChapters(); }, [=] (auto &&data) {
+        if (updateList(info.chapters, data))
+            emit p->chaptersChanged();
         updateChapter(mpv.get<int>("chapter"));
     });
     mpv.observe("chapter", updateChapter);
     mpv.observe("track-list", [=] () {
-        return toTracks(mpv.get<QVariant>("track-list"));
+        return toTracks();
     }, [=] (auto &&strms) {
-        params.set_video_tracks(strms[StreamVideo]);
-        params.set_audio_tracks(strms[StreamAudio]);
-        params.set_sub_tracks(strms[StreamSubtitle]);
+        // track-list is notified for any change of any track,
+        // so only lists which differ from current ones are signaled
+        auto &subs = strms[StreamSubtitle];
+        for (auto &track : subs) {
+            if (!track.isExternal() || track.encoding().isValid())
+                continue;
+            // encoding has been taken already by previous update
+            for (auto &old : params.sub_tracks()) {
+                if (old.file() == track.file()) {
+                    track.m_encoding = old.encoding();
+                    break;
+                }
+            }
+        }
+        if (params.video_tracks() != strms[StreamVideo])
+            params.set_video_tracks(strms[StreamVideo]);
+        if (params.audio_tracks() != strms[StreamAudio])
+            params.set_audio_tracks(strms[StreamAudio]);
+        if (params.sub_tracks() != subs)
+            params.set_sub_tracks(subs);
 
         auto audioOnly = !strms[StreamAudio].isEmpty();
         if (audioOnly && !strms[StreamVideo].isEmpty()) {
@@ -583,6 +1064,8 @@ auto PlayEngine::Data::observe() -> void
                 }
             }
         }
+        hasAlbumArt = audioOnly && !strms[StreamVideo].isEmpty();
+        updateAlbumArt();
         if (_Change(this->audioOnly, audioOnly))
             emit p->audioOnlyChanged(audioOnly);
         if (strms[StreamSubtitle].isEmpty())
@@ -638,7 +1121,12 @@ auto PlayEngine::Data::observe() -> void
         input->setHeight(h);
         input->setBppSize(input->size());
     });
-    mpv.observe("video-bitrate", [=] (int bps) { info.video.decoder()->setBitrate(bps); });
+    auto updateBitrate = [=] () {
+        info.cache.setBitrate(info.video.decoder()->bitrate()
+                              + info.audio.decoder()->bitrate());
+    };
+    mpv.observe("video-bitrate", [=] (int bps)
+        { info.video.decoder()->setBitrate(bps); updateBitrate(); });
     mpv.observe("video-format", [=] (MpvLatin1 &&f) { info.video.decoder()->setType(f); });
     QRegularExpression rx(uR"(Video decoder: ([^\n]*))"_q);
     auto filterInput = [=] (const char *name) -> QString {
@@ -664,6 +1152,8 @@ auto PlayEngine::Data::observe() -> void
         auto &video = info.video;
         auto info = video.filter();
         setParams(info, params, u"w"_q, u"h"_q);
+        if (fboFormat == FramebufferObjectFormat::Auto)
+            updateVideoFboFormat();
     });
     mpv.observe("video-out-params", [=] (QVariant &&var) {
         const auto params = var.toMap();
@@ -673,7 +1163,8 @@ auto PlayEngine::Data::observe() -> void
 
     mpv.observe("audio-codec", [=] (MpvLatin1 &&c) { info.audio.codec()->parse(c); });
     mpv.observe("audio-format", [=] (MpvLatin1 &&f) { info.audio.decoder()->setType(f); });
-    mpv.observe("audio-bitrate", [=] (int bps) { info.audio.decoder()->setBitrate(bps); });
+    mpv.observe("audio-bitrate", [=] (int bps)
+        { info.audio.decoder()->setBitrate(bps); updateBitrate(); });
     mpv.observe("audio-samplerate", [=] (int s) { info.audio.decoder()->setSampleRate(s, false); });
     mpv.observe("audio-channels", [=] (int n)
         { info.audio.decoder()->setChannels(QString::number(n) % "ch"_a, n); });
@@ -681,6 +1172,13 @@ auto PlayEngine::Data::observe() -> void
     mpv.observe("current-ao", [=] (MpvLatin1 &&ao) { info.audio.setDriver(ao); });
 
     mpv.observe("disc-mouse-on-button", [=] (bool on) { mouseOnButton = on; });
+    mpv.observe("disc-button-rect", [=] (MpvLatin1 &&rect) {
+        const auto v = rect.data.split(' '_q);
+        if (v.size() == 4)
+            nav.button.setCoords(v[0].toInt(), v[1].toInt(), v[2].toInt() - 1, v[3].toInt() - 1);
+        else
+            nav.button = QRect();
+    });
 }
 
 auto PlayEngine::Data::request() -> void
@@ -714,9 +1212,10 @@ auto PlayEngine::Data::request() -> void
                 edition = editions[item];
         }
 
-        auto strs = toTracks(mpv.get<QVariant>("track-list"));
+        auto strs = toTracks();
+        const auto config = this->config();
         auto select = [&] (StreamType type) {
-            for (auto &p : streams[type].priority) {
+            for (auto &p : config->priority[type]) {
                 const QRegEx rx(p);
                 for (auto &str : strs[type]) {
                     auto m = rx.match(str.language());
@@ -768,10 +1267,77 @@ auto PlayEngine::Data::request() -> void
         t.local.clear();
     });
     mpv.request(MPV_EVENT_PLAYBACK_RESTART, [=] () {
+        if (ttff.pending) {
+            ttff.pending = false;
+            _Debug("First frame in %%ms: on_load %%ms, state %%ms, files %%ms, url %%ms",
+                   ttff.timer.elapsed(), ttff.hook, ttff.stages[LoadStages::State],
+                   ttff.stages[LoadStages::Files], ttff.stages[LoadStages::Url]);
+        }
         _PostEvent(p, NotifySeek);
     });
 }
 
+auto PlayEngine::Data::updateTime(int pos) -> void
+{
+    if (!_Change(time, pos))
+        return;
+    emit p->tick(time);
+    if (_Change(time_s, time/1000))
+        emit p->time_sChanged();
+    sr->render(subtitleTime());
+    info.video.setFrameNumber(calcFrameCount(info.video.decoder()->fps(), time - begin));
+}
+
+auto PlayEngine::Data::subtitleTime() const -> int
+{
+    // presented frames drive subtitles only while they are coming in
+    const int frame = clock.frame;
+    const auto swapped = clock.swapped.load();
+    if (frame == NoFrame || !clock.running || swapped < 0
+            || clock.uptime.elapsed() - swapped > 100)
+        return time;
+    // last frame before seek can stay until first one after it
+    return qAbs(frame - time) > 1000 ? time : frame;
+}
+
+auto PlayEngine::Data::sampleTime(int pos) -> void
+{
+    clock.pts = pos;
+    clock.sampled = clock.uptime.elapsed();
+    clock.running = state == PlayEngine::Playing;
+    // nothing is presented, so vsync will not pick it up
+    const auto swapped = clock.swapped.load();
+    if (!clock.running || swapped < 0 || clock.sampled - swapped > 100)
+        updateTime(pos);
+}
+
+// called in render thread
+auto PlayEngine::Data::frameSwapped() -> void
+{
+    // gpu should have caught up after a couple of frames
+    if (ss.readback.pending())
+        collectSnapshots(++ss.polls > 2);
+    if (capture.readback.pending())
+        collectCaptures(false);
+    clock.swapped = clock.uptime.elapsed();
+    if (!clock.pending.exchange(true))
+        _PostEvent(p, Tick);
+}
+
+auto PlayEngine::Data::interpolateTime() -> void
+{
+    clock.pending = false;
+    int pos = clock.pts;
+    if (clock.running && state == PlayEngine::Playing) {
+        // never run far ahead of mpv when it stalls
+        const auto elapsed = qMin<qint64>(clock.uptime.elapsed() - clock.sampled, 250);
+        pos += elapsed * speed(params.play_speed());
+        if (duration > 0)
+            pos = qMin(pos, begin + duration);
+    }
+    updateTime(pos);
+}
+
 auto PlayEngine::Data::process(QEvent *event) -> void
 {
     if (mpv.process(event))
@@ -783,24 +1349,35 @@ auto PlayEngine::Data::process(QEvent *event) -> void
     case WaitingChange: {
         bool set = false; Waitings waitings = NoWaiting;
         _TakeData(event, waitings, set);
+        if (waitings & Buffering)
+            info.cache.setStalled(set);
         setWaitings(waitings, set);
         break;
     } case PreparePlayback: {
+        subFiles.pending.clear();
+        subFiles.loaded = false;
+        nav.moving = 0;
+        nav.pending = false;
+        break;
+    } case DiscMouseMoved: {
+        nav.moving = qMax(0, nav.moving - 1);
+        if (!nav.moving && nav.pending)
+            moveMouse(false);
         break;
     } case StartPlayback: {
         clearTimings();
+        info.cache.resetStatistics();
+        subFiles.loaded = true;
+        addPendingSubtitleFiles();
         QVector<EditionData> editions; EditionData edition;
         _TakeData(event, editions, edition);
-        qDeleteAll(info.editions);
-        info.editions.resize(editions.size());
-        for (int i = 0; i < info.editions.size(); ++i) {
-            info.editions[i] = new EditionObject;
-            info.editions[i]->set(editions[i]);
-        }
-        info.edition.set(edition);
-        emit p->editionsChanged();
-        emit p->editionChanged();
+        if (updateList(info.editions, editions))
+            emit p->editionsChanged();
+        if (info.edition.set(edition))
+            emit p->editionChanged();
         emit p->started(params.mrl());
+        loadKeyframes();
+        loadOverview();
         if (params.set_name(mpv.get<MpvUtf8>("media-title").data))
             history->update(&params, u"name"_q, false);
         history->update();
@@ -827,14 +1404,73 @@ auto PlayEngine::Data::process(QEvent *event) -> void
             state = Error;
             break;
         }
+        // mpv has already moved to queued entry
+        const bool advanced = reason == MPV_END_FILE_REASON_EOF && !next.isEmpty();
         updateState(state);
+        recordCache(last->mrl());
         history->update(last.data(), false);
-        emit p->finished(last->mrl(), eof);
+        if (probes && state != Error && duration > 0) {
+            MediaProbe probe;
+            probe.duration = duration;
+            probe.chapters = info.chapters.size();
+            probe.title = last->name();
+            probe.video = last->video_tracks();
+            probe.audio = last->audio_tracks();
+            probe.subtitle = last->sub_tracks();
+            probes->store(last->mrl(), probe);
+        }
+        if (advanced) {
+            mrl = next;
+            hasImage = false;
+            // track list of next one may have come first
+            updateAlbumArt();
+            updateMediaName();
+            emit p->mrlChanged(mrl);
+        }
+        next = Mrl();
+        cancelKeyframes();
+        cancelOverview();
+        if (statsSummary && state != Error)
+            _Info("Playback statistics of %%: %%", last->mrl().toString(),
+                  stats.summary().toString());
+        emit p->finished(last->mrl(), eof, advanced);
         break;
     } case NotifySeek:
         emit p->sought();
         break;
-    case SyncMrlState: {
+    case Tick:
+        interpolateTime();
+        break;
+    case KeyframesReady: {
+        Mrl mrl; KeyframeIndex index;
+        _TakeData(event, mrl, index);
+        if (probes)
+            probes->storeKeyframes(mrl, index);
+        if (mrl == keyframes.mrl) {
+            keyframes.index = index;
+            _Debug("%% keyframes are indexed.", index.size());
+        }
+        break;
+    }
+    case OverviewReady: {
+        Mrl mrl; AudioOverview overview;
+        _TakeData(event, mrl, overview);
+        if (probes)
+            probes->storeOverview(mrl, overview);
+        if (mrl == this->overview.mrl) {
+            setOverview(overview);
+            _Debug("Audio overview has %% buckets, loudness %% LUFS.",
+                   overview.size(), overview.loudness());
+        }
+        break;
+    }
+    case SubtitlesLoaded: {
+        int serial = 0; QSharedPointer<SubtitleLoads> loads;
+        _TakeData(event, serial, loads);
+        if (serial == subSerial.load())
+            attachSubtitles(*loads);
+        break;
+    } case SyncMrlState: {
         QSharedPointer<MrlState> ms;
         QVector<SubComp> loads;
         YouTubeDL::Result ytr;
@@ -865,48 +1501,168 @@ auto PlayEngine::Data::process(QEvent *event) -> void
     }
 }
 
-auto PlayEngine::Data::takeSnapshot() -> void
+auto PlayEngine::Data::takeSnapshot(const Fbo *frame, const Fbo *osd,
+                                    const QMargins &m) -> void
 {
-    p->clearSnapshots();
     const auto size = displaySize();
     if (size.isEmpty()) {
+        mutex.lock();
+        ss.taken.push_back(Snapshot());
+        mutex.unlock();
         emit p->snapshotTaken();
         return;
     }
-    Fbo frame(size), osd(size);
-    mpv.render(&frame, &osd, QMargins());
-    ss.frame = frame.texture().toImage(QImage::Format_ARGB32);
-    ss.osd = osd.texture().toImage(QImage::Format_ARGB32_Premultiplied);
-    ss.time = mpv.get<double>("time-pos") * 1e3;
-    emit p->snapshotTaken();
+    if (!ss.readback.isValid())
+        ss.readback.create();
+    // frame is not rotated in fbo unlike osd
+    const auto angle = _EnumData(vr->rotation());
+    const auto osdSize = angle % 180 ? size.transposed() : size;
+    // just rendered frame can be read as it is unless it is scaled or padded
+    const auto reusable = [&] (const Fbo *fbo, const QSize &size)
+        { return fbo && fbo->size() == size; };
+    if (!reusable(frame, size) || !m.isNull() || (osd && !reusable(osd, osdSize))) {
+        if (!reusable(ss.frame, size))
+            _Renew(ss.frame, size);
+        if (!reusable(ss.osd, osdSize))
+            _Renew(ss.osd, osdSize);
+        mpv.render(ss.frame, ss.osd, QMargins());
+        frame = ss.frame;
+        osd = ss.osd;
+    }
+    ss.readback.read(frame, QImage::Format_ARGB32);
+    ss.readback.read(osd, QImage::Format_ARGB32_Premultiplied);
+    ss.times.push_back(mpv.get<double>("time-pos") * 1e3);
+    ss.angles.push_back(angle);
+    ss.polls = 0;
+}
+
+auto PlayEngine::Data::collectSnapshots(bool wait) -> void
+{
+    bool taken = false;
+    while (ss.readback.pending() >= 2) {
+        Snapshot snapshot;
+        if (!ss.readback.take(snapshot.frame, wait))
+            break;
+        ss.readback.take(snapshot.osd, true);
+        snapshot.time = ss.times.takeFirst();
+        if (const int angle = ss.angles.takeFirst())
+            snapshot.frame = snapshot.frame.transformed(QTransform().rotate(angle));
+        mutex.lock();
+        ss.taken.push_back(snapshot);
+        mutex.unlock();
+        taken = true;
+    }
+    if (taken)
+        emit p->snapshotTaken();
+}
+
+auto PlayEngine::Data::captureFrame(const Fbo *frame, const Fbo *osd,
+                                    const QMargins &m) -> void
+{
+    collectCaptures(false);
+    if (++capture.skip < capture.every)
+        return;
+    capture.skip = 0;
+    if (!capture.readback.isValid())
+        capture.readback.create();
+    if (capture.readback.available() < 2) {
+        capture.writer.drop();
+        return;
+    }
+    const auto angle = _EnumData(vr->rotation());
+    const auto size = angle % 180 ? frame->size().transposed() : frame->size();
+    // osd fbo covers letterbox with margins and cannot be laid over frame
+    if (!capture.osd || !m.isNull() || (osd && osd->size() != size))
+        osd = nullptr;
+    capture.readback.read(frame, QImage::Format_ARGB32);
+    capture.readback.read(osd, QImage::Format_ARGB32_Premultiplied);
+    capture.angles.push_back(angle);
+}
+
+auto PlayEngine::Data::collectCaptures(bool wait) -> void
+{
+    while (capture.readback.pending() >= 2) {
+        QImage frame, osd;
+        if (!capture.readback.take(frame, wait))
+            break;
+        capture.readback.take(osd, true);
+        // fbo holds frame as decoded, so rotate afterwards
+        if (const int angle = capture.angles.takeFirst())
+            frame = frame.transformed(QTransform().rotate(angle));
+        capture.writer.push(frame, osd);
+    }
+}
+
+auto PlayEngine::Data::releaseSnapshots() -> void
+{
+    collectSnapshots(true);
+    collectCaptures(true);
+    capture.readback.destroy();
+    ss.readback.destroy();
+    _Delete(ss.frame);
+    _Delete(ss.osd);
 }
 
 auto PlayEngine::Data::renderVideoFrame(Fbo *frame, Fbo *osd, const QMargins &m) -> void
 {
+    TRACE_SCOPE("PlayEngine::renderVideoFrame");
     info.delayed = mpv.render(frame, osd, m);
+    if (frame)
+        stats.pushFrame(info.delayed > 0);
     frames.measure.push(++frames.drawn);
 
+    // subtitles are asked for next frame, so they are ready when it comes
+    double pts = 0.0;
+    if (!mpv.framePts(pts))
+        clock.frame = NoFrame;
+    else if (pts != clock.framePts) {
+        double dt = pts - clock.framePts;
+        if (!(0.0 < dt && dt < 0.25)) {
+            const double fps = info.video.output()->fps();
+            dt = fps > 0.0 ? 1.0/fps : 0.0;
+        }
+        clock.framePts = pts;
+        clock.frame = s2ms(pts + dt) - clock.offset;
+    }
+
     _Trace("PlayEngine::Data::renderVideoFrame(): "
            "render queued frame(%%), avgfps: %%",
            frame->size(), info.video.output()->fps());
 
-    if (ss.take) {
-        takeSnapshot();
-        ss.take = false;
+    // collect before taking new one so that burst never overflows the ring
+    collectSnapshots(false);
+    if (ss.take > 0 && (!ss.readback.isValid() || ss.readback.available() >= 2)) {
+        --ss.take;
+        takeSnapshot(frame, osd, m);
     }
+    if (capture.running && frame)
+        captureFrame(frame, osd, m);
+    else if (capture.readback.pending())
+        collectCaptures(true);
+    // ask another frame for pending request or readback while paused
+    if (ss.take > 0 || ss.readback.pending())
+        vr->updateForNewFrame(displaySize());
 }
 
-auto PlayEngine::Data::toTracks(const QVariant &var) -> QVector<StreamList>
+auto PlayEngine::Data::toTracks() -> QVector<StreamList>
 {
     QVector<StreamList> streams(3);
     streams[StreamVideo] = { StreamVideo };
     streams[StreamAudio] = { StreamAudio };
     streams[StreamSubtitle] = { StreamSubtitle };
-    auto list = var.toList();
-    for (auto &var : list) {
-        auto track = StreamTrack::fromMpvData(var);
-        streams[track.type()].insert(track);
+    mpv_node node;
+    if (!mpv.handle() || mpv_get_property(mpv.handle(), "track-list",
+                                          MPV_FORMAT_NODE, &node) < 0)
+        return streams;
+    if (node.format == MPV_FORMAT_NODE_ARRAY) {
+        auto list = node.u.list;
+        for (int i = 0; i < list->num; ++i) {
+            auto track = StreamTrack::fromMpvNode(list->values[i]);
+            if (_InRange(StreamAudio, track.type(), StreamSubtitle))
+                streams[track.type()].insert(track);
+        }
     }
+    mpv_free_node_contents(&node);
     auto &subs = streams[StreamSubtitle];
     if (!subs.isEmpty()) {
         QMutexLocker locker(&mutex);
@@ -918,6 +1674,61 @@ auto PlayEngine::Data::toTracks(const QVariant &var) -> QVector<StreamList>
     return streams;
 }
 
+auto PlayEngine::Data::toChapters() -> QVector<ChapterData>
+{
+    QVector<ChapterData> chapters;
+    mpv_node node;
+    if (!mpv.handle() || mpv_get_property(mpv.handle(), "chapter-list",
+                                          MPV_FORMAT_NODE, &node) < 0)
+        return chapters;
+    if (node.format == MPV_FORMAT_NODE_ARRAY) {
+        auto list = node.u.list;
+        chapters.resize(list->num);
+        for (int i = 0; i < list->num; ++i) {
+            auto &data = chapters[i];
+            data.number = i;
+            if (list->values[i].format != MPV_FORMAT_NODE_MAP)
+                continue;
+            auto map = list->values[i].u.list;
+            for (int j = 0; j < map->num; ++j) {
+                const auto &value = map->values[j];
+                if (!qstrcmp(map->keys[j], "time") && value.format == MPV_FORMAT_DOUBLE)
+                    data.time = s2ms(value.u.double_) - t.offset;
+                else if (!qstrcmp(map->keys[j], "title") && value.format == MPV_FORMAT_STRING)
+                    data.name = QString::fromUtf8(value.u.string);
+            }
+        }
+    }
+    mpv_free_node_contents(&node);
+    for (auto &data : chapters) {
+        if (data.name.isEmpty())
+            data.name = _MSecToString(data.time, u"hh:mm:ss.zzz"_q);
+    }
+    return chapters;
+}
+
+auto PlayEngine::Data::updateList(QVector<EditionChapterObject*> &list,
+                                  const QVector<EditionChapterData> &data) -> bool
+{
+    bool changed = list.size() != data.size();
+    // objects may be still referenced by qml, so they are kept not deleted
+    while (list.size() > data.size()) {
+        list.last()->invalidate();
+        info.spare.push_back(list.takeLast());
+    }
+    while (list.size() < data.size())
+        list.push_back(info.spare.isEmpty() ? new EditionChapterObject
+                                            : info.spare.takeLast());
+    for (int i = 0; i < data.size(); ++i) {
+        // rate is updated with position later
+        auto item = data[i];
+        item.rate = list[i]->rate();
+        if (list[i]->set(item))
+            changed = true;
+    }
+    return changed;
+}
+
 auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const EncodingInfo &enc, bool detect) -> QVector<SubComp>
 {
     Q_ASSERT(tracks.type() == StreamInclusiveSubtitle);
@@ -942,9 +1753,10 @@ auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const
     return ret;
 }
 
-auto PlayEngine::Data::autoloadFiles(StreamType type) -> MpvFileList
+auto PlayEngine::Data::autoloadFiles(StreamType type, const Mrl &mrl) -> MpvFileList
 {
-    auto &a = streams[type].autoloader;
+    const auto config = this->config();
+    auto &a = config->autoloader[type];
     if (!a.enabled)
         return MpvFileList();
     return a.autoload(mrl, streams[type].ext);
@@ -954,7 +1766,7 @@ auto PlayEngine::Data::autoselect(const MrlState *s, QVector<SubComp> &loads) ->
 {
     QVector<int> selected;
     QSet<QString> langSet;
-    const QFileInfo file(mrl.toLocalFile());
+    const QFileInfo file(s->mrl().toLocalFile());
     const QString base = file.completeBaseName();
 
     for (int i = 0; i<loads.size(); ++i) {
@@ -996,24 +1808,100 @@ auto PlayEngine::Data::autoselect(const MrlState *s, QVector<SubComp> &loads) ->
         loads[selected[i]].selection() = true;
 }
 
-auto PlayEngine::Data::autoloadSubtitle(const MrlState *s, const MpvFileList &subs)
+class SubtitleLoadJob : public QRunnable {
+public:
+    SubtitleLoadJob(const QSharedPointer<SubtitleLoads> &loads, int index)
+        : m_loads(loads), m_index(index) { }
+    auto run() -> void final
+    {
+        auto &file = m_loads->files[m_index];
+        file.encoding = EncodingInfo::detect(EncodingInfo::Subtitle, file.name);
+        file.loaded = file.subtitle.load(file.name, file.encoding);
+        if (!m_loads->remains.deref()) {
+            if (m_loads->finished)
+                m_loads->finished(m_loads);
+            m_loads->done.release();
+        }
+    }
+private:
+    QSharedPointer<SubtitleLoads> m_loads;
+    int m_index = -1;
+};
+
+auto PlayEngine::Data::loadSubtitleFiles(const QStringList &files,
+                                         SubtitleLoads::Finished &&finished)
+-> QSharedPointer<SubtitleLoads>
+{
+    QSharedPointer<SubtitleLoads> loads(new SubtitleLoads);
+    loads->files.resize(files.size());
+    for (int i = 0; i < files.size(); ++i)
+        loads->files[i].name = files[i];
+    loads->remains = files.size();
+    loads->finished = std::move(finished);
+    for (int i = 0; i < files.size(); ++i)
+        subPool.start(new SubtitleLoadJob(loads, i));
+    if (files.isEmpty())
+        loads->done.release();
+    return loads;
+}
+
+auto PlayEngine::Data::takeSubtitles(const MrlState *s, const SubtitleLoads &loads)
 -> T<MpvFileList, QVector<SubComp>>
 {
     MpvFileList files;
-    QVector<SubComp> loads;
-    for (auto &file : subs.names) {
-       Subtitle sub;
-       const auto enc = EncodingInfo::detect(EncodingInfo::Subtitle, file);
-       if (sub.load(file, enc)) {
-           for (int i = 0; i < sub.size(); ++i)
-               loads.push_back(sub[i]);
-       } else {
-           files.names.push_back(file);
-           assEncodings[file] = enc;
-       }
+    QVector<SubComp> comps;
+    for (auto &file : loads.files) {
+        if (file.loaded) {
+            for (int i = 0; i < file.subtitle.size(); ++i)
+                comps.push_back(file.subtitle[i]);
+        } else {
+            files.names.push_back(file.name);
+            assEncodings[file.name] = file.encoding;
+        }
+    }
+    autoselect(s, comps);
+    return _T(files, comps);
+}
+
+auto PlayEngine::Data::autoloadSubtitle(const MrlState *s, const MpvFileList &subs)
+-> T<MpvFileList, QVector<SubComp>>
+{
+    auto loads = loadSubtitleFiles(subs.names);
+    loads->done.acquire();
+    return takeSubtitles(s, *loads);
+}
+
+auto PlayEngine::Data::attachSubtitles(const SubtitleLoads &loads) -> void
+{
+    MpvFileList files; QVector<SubComp> comps;
+    mutex.lock();
+    _R(files, comps) = takeSubtitles(&params, loads);
+    const bool preferExternal = params.d->preferExternal;
+    for (auto &file : files.names)
+        subFiles.pending.push_back({file, assEncodings[file]});
+    mutex.unlock();
+    bool selected = false;
+    for (auto &comp : comps)
+        selected = selected || comp.selection();
+    subFiles.select = !(selected && preferExternal);
+    if (subFiles.loaded)
+        addPendingSubtitleFiles();
+    if (!comps.isEmpty()) {
+        sr->addComponents(comps);
+        syncInclusiveSubtitles();
     }
-    autoselect(s, loads);
-    return _T(files, loads);
+    if (!subFiles.select)
+        mpv.setAsync("sid", "no"_b);
+}
+
+auto PlayEngine::Data::addPendingSubtitleFiles() -> void
+{
+    // like sub-file, the first external one is selected unless bomi shows one
+    for (int i = 0; i < subFiles.pending.size(); ++i) {
+        const auto &sub = subFiles.pending[i];
+        sub_add(sub.file, sub.encoding, subFiles.select && !i);
+    }
+    subFiles.pending.clear();
 }
 
 auto PlayEngine::Data::autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>
@@ -1050,6 +1938,7 @@ auto PlayEngine::Data::updateState(State s) -> void
             info.frameTimer.start();
         else
             info.frameTimer.stop();
+        updateStatsTimer();
     }
 }
 
@@ -1065,9 +1954,53 @@ auto PlayEngine::Data::setWaitings(Waitings w, bool set) -> void
         emit p->waitingChanged(new_);
 }
 
+auto PlayEngine::Data::recordCache(const Mrl &mrl) -> void
+{
+    const auto host = cacheHost(mrl);
+    const auto &cache = info.cache;
+    if (host.isEmpty() || cache.throughput() <= 0 || cache.bitrate() <= 0)
+        return;
+    mutex.lock();
+    auto &record = cacheRecords[host];
+    // smooth over files so that one bad session does not dominate
+    if (record.throughput > 0)
+        record.throughput = record.throughput * 0.5 + cache.throughput() * 0.5;
+    else
+        record.throughput = cache.throughput();
+    record.bitrate = cache.bitrate();
+    mutex.unlock();
+}
+
+auto PlayEngine::Data::adaptCache(const Mrl &mrl, CacheInfo::Item &item,
+                                  qint64 &initial) -> void
+{
+    const auto host = cacheHost(mrl);
+    if (host.isEmpty())
+        return;
+    mutex.lock();
+    const auto record = cacheRecords.value(host);
+    mutex.unlock();
+    if (record.throughput <= 0 || record.bitrate <= 0)
+        return;
+    const double rate = record.bitrate / (8.0 * 1024.0); // KiB/s
+    const double headroom = qMax(0.25, record.throughput / rate);
+    // slow link needs longer read-ahead, fast one keeps configured value
+    if (headroom < 2.0)
+        item.sec = qMin(120.0, item.sec * 2.0 / headroom);
+    item.kb = qBound<qint64>(item.kb, rate * item.sec * 1.5, item.kb * 4);
+    // prefill what would run out before read-ahead period ends
+    if (headroom < 1.0)
+        initial = qMax<qint64>(initial, qMin<qint64>(item.kb / 2,
+                                     rate * item.sec * (1.0 - headroom)));
+    _Info("Adapt cache for %%: %% KiB/s for %% KiB/s stream, "
+          "%% KiB, %% sec, %% KiB initial", host, record.throughput, rate,
+          item.kb, item.sec, initial);
+}
+
 auto PlayEngine::Data::clearTimings() -> void
 {
     frames.measure.reset();
+    stats.reset();
     info.video.setDroppedFrames(0);
     info.video.setDelayedFrames(0);
     info.video.output()->setFps(0);
@@ -1172,6 +2105,7 @@ auto PlayEngine::Data::resync(bool force) -> void
 auto PlayEngine::Data::volume(const MrlState *s) const -> double
 {
     auto x = s->audio_volume();
+    const int volumeScale = config()->volumeScale;
     if (volumeScale > 0 && x > 1e-8) {
         const auto a = M_LN10 * volumeScale / 20.0;
         const auto b = exp(-a);
@@ -8,23 +8,36 @@
 #include "avinfoobject.hpp"
 #include "streamtrack.hpp"
 #include "historymodel.hpp"
+#include "mediaprobe.hpp"
 #include "misc/autoloader.hpp"
+#include "misc/smbauth.hpp"
 #include "misc/youtubedl.hpp"
 #include "misc/osdstyle.hpp"
 #include "misc/speedmeasure.hpp"
 #include "misc/yledl.hpp"
+#include "misc/downloadserver.hpp"
 #include "misc/charsetdetector.hpp"
 #include "audio/audiocontroller.hpp"
 #include "audio/audioformat.hpp"
 #include "video/videorenderer.hpp"
 #include "video/videoprocessor.hpp"
 #include "video/videopreview.hpp"
+#include "video/rendertiming.hpp"
+#include "video/playbackstats.hpp"
+#include "video/slidedecoder.hpp"
+#include "video/framecapture.hpp"
 #include "subtitle/subtitle.hpp"
 #include "subtitle/subtitlerenderer.hpp"
 #include "enum/codecid.hpp"
 #include "enum/framebufferobjectformat.hpp"
 #include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglreadback.hpp"
 #include "os/os.hpp"
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QQueue>
+#include <atomic>
+#include <memory>
 
 #ifdef bool
 #undef bool
@@ -37,8 +50,8 @@ auto _ChmapNameFromLayout(ChannelLayout layout) -> QByteArray;
 enum EventType {
     UserType = QEvent::User, StateChange, WaitingChange,
     PreparePlayback,EndPlayback, StartPlayback, NotifySeek,
-    SyncMrlState,
-    EventTypeMax
+    SyncMrlState, SubtitlesLoaded, Tick, KeyframesReady, OverviewReady,
+    DiscMouseMoved, EventTypeMax
 };
 
 static const QVector<StreamType> streamTypes
@@ -51,8 +64,16 @@ struct StreamData {
     const char *pid = nullptr;
     ExtType ext;
     int reserved = -1;
-    QStringList priority;
-    Autoloader autoloader;
+};
+
+// preferences which mpv thread reads, never modified after publish()
+struct EngineConfig {
+    CacheInfo cache;
+    SmbAuth smb;
+    std::array<QStringList, StreamUnknown> priority;
+    std::array<Autoloader, StreamUnknown> autoloader;
+    int volumeScale = 0, decoderThreads = 0;
+    bool resume = false, lowLatencyDecoding = false;
 };
 
 struct SubtitleWithEncoding {
@@ -60,10 +81,43 @@ struct SubtitleWithEncoding {
     EncodingInfo encoding;
 };
 
+// charset detection and parsing of subtitle files, one pool job per file
+struct SubtitleLoads {
+    using Finished = std::function<void(const QSharedPointer<SubtitleLoads>&)>;
+    struct File {
+        QString name;
+        EncodingInfo encoding;
+        Subtitle subtitle;
+        bool loaded = false;
+    };
+    std::vector<File> files;
+    QAtomicInt remains = 0;
+    QSemaphore done;
+    // called in pool thread which finished last
+    Finished finished;
+};
+
+// independent steps of on_load hook, run concurrently and joined by wait()
+struct LoadStages {
+    enum Stage { State, Files, Url, StageMax };
+    std::array<qint64, StageMax> msecs = {{-1, -1, -1}};
+    QSemaphore done;
+    int started = 0;
+    auto run(QThreadPool *pool, Stage stage, std::function<void(void)> &&func) -> void;
+    auto wait() -> void { done.acquire(started); started = 0; }
+};
+
 struct PlayEngine::Data {
     Data(PlayEngine *engine);
     PlayEngine *p = nullptr;
 
+    RenderTiming timing;
+    PlaybackStats stats;
+    // next image replaces shown one without loading it in mpv
+    // also decodes album art which mpv is told not to display
+    SlideDecoder slides;
+    // file whose cover is shown or being decoded, gui thread
+    QString albumArt;
     Mpv mpv;
     VideoRenderer *vr = nullptr;
     VideoPreview *preview = nullptr;
@@ -72,22 +126,28 @@ struct PlayEngine::Data {
     VideoProcessor *vp = nullptr;
     FramebufferObjectFormat fboFormat = FramebufferObjectFormat::Auto;
     QByteArray playingVideo, playingAudio;
+    // options sent to mpv last time, the same ones are never sent again
+    QByteArray sentVo, sentVf;
     YouTubeDL::Result ytResult;
 
     PlayEngine::Waitings waitings = PlayEngine::NoWaiting;
     PlayEngine::State state = PlayEngine::Stopped;
     PlayEngine::ActivationState hwacc = PlayEngine::Unavailable;
 
-    Mrl mrl;
+    Mrl mrl, next;
     MrlState params, default_;
     QMutex mutex;
 
     struct {
         MediaObject media;
-        VideoObject video; QTimer frameTimer; int delayed = 0;
+        VideoObject video; int delayed = 0;
+        // frameTimer drives playback control, statsTimer only info for display
+        QTimer frameTimer, statsTimer;
         AudioObject audio;
         SubtitleObject subtitle;
         QVector<EditionChapterObject*> chapters, editions;
+        // objects left over by shorter lists, reused by longer ones
+        QVector<EditionChapterObject*> spare;
         EditionChapterObject chapter, edition;
         StreamingFormatObject streaming;
         QVector<StreamingFormatObject*> streamings;
@@ -97,8 +157,10 @@ struct PlayEngine::Data {
     MetaData metaData;
     OsdStyle subStyle;
     HistoryModel *history = nullptr;
+    MediaProbeCache *probes = nullptr;
     YleDL *yle = nullptr;
     YouTubeDL *youtube = nullptr;
+    DownloadServer downloads;
 
     struct {
         bool caching = false;
@@ -107,18 +169,60 @@ struct PlayEngine::Data {
     } t; // thread local
 
     bool hasImage = false, seekable = false, hasVideo = false;
-    bool pauseAfterSkip = false, resume = false, hwdec = false;
-    bool quit = false, preciseSeeking = false, mouseOnButton = false;
+    bool pauseAfterSkip = false, hwdec = false;
+    bool quit = false, preciseSeeking = false, mouseOnButton = false, statsSummary = false;
     bool filterResync = false, audioOnly = false, useIntrplDown = false;
+    bool lowLatencyAudio = false, hasAlbumArt = false;
 
     QList<CodecId> hwCodecs;
 
-    int avSync = 0, reload = -1, volumeScale = 0;
+    int avSync = 0, reload = -1;
+
+    // std::shared_ptr for atomic_load/atomic_store, readers never lock
+    std::shared_ptr<const EngineConfig> configuration = std::make_shared<EngineConfig>();
+    auto config() const { return std::atomic_load(&configuration); }
+    // copy current one, modify and publish, called in gui thread only
+    template<class F>
+    auto configure(F &&modify) -> void
+    {
+        if (pending) {
+            modify(*pending);
+            return;
+        }
+        auto c = std::make_shared<EngineConfig>(*config());
+        modify(*c);
+        std::atomic_store(&configuration, std::shared_ptr<const EngineConfig>(std::move(c)));
+    }
+    // collects configure() while preferences are applied, published at once
+    std::shared_ptr<EngineConfig> pending;
+    // one which last preferences were applied with
+    std::shared_ptr<const EngineConfig> applied;
     int time_s = 0, begin_s = 0, end_s = 0, duration_s = 0;
     int duration = 0, begin = 0, time = 0;
 
+    static constexpr int NoFrame = std::numeric_limits<int>::min();
+    // last time-pos from mpv, applied at vsync and interpolated in between
+    struct {
+        QElapsedTimer uptime;
+        qint64 sampled = 0; std::atomic<qint64> swapped{-1};
+        std::atomic<bool> pending{false};
+        int pts = 0; bool running = false;
+        // next frame after presented one, which subtitles are prepared for
+        // written in render thread while offset is copied from t.offset
+        std::atomic<int> frame{NoFrame}, offset{0};
+        double framePts = 0.0;
+    } clock;
+    auto subtitleTime() const -> int;
+
     QMap<QString, EncodingInfo> assEncodings;
 
+    // files rejected by bomi wait here until mpv has loaded the file
+    struct {
+        QVector<SubtitleWithEncoding> pending;
+        bool select = true, loaded = false;
+    } subFiles;
+    QAtomicInt subSerial = 0;
+
     std::array<StreamData, StreamUnknown> streams = []() {
         std::array<StreamData, StreamUnknown> strs;
         strs[StreamVideo] = { "vid", VideoExt };
@@ -132,8 +236,96 @@ struct PlayEngine::Data {
         SpeedMeasure<quint64> measure{5, 20};
     } frames;
 
-    struct { QImage osd, frame; bool take = false; int time = 0; } ss;
+    // snapshots are read back without stalling render thread, then queued
+    struct Snapshot { QImage frame, osd; int time = 0; };
+    struct {
+        OpenGLReadback readback{8}; // frame and osd for each snapshot
+        Fbo *frame = nullptr, *osd = nullptr; // when rendered one differs
+        QQueue<int> times, angles;
+        QQueue<Snapshot> taken; // guarded by mutex
+        std::atomic<int> take{0};
+        int polls = 0;
+    } ss;
+
+    // every nth rendered frame is read back and written while capturing
+    struct {
+        FrameCapture writer;
+        OpenGLReadback readback{6};
+        std::atomic<int> every{1};
+        std::atomic<bool> running{false}, osd{false};
+        int skip = 0;
+        QQueue<int> angles; // rotation of each read
+    } capture;
+    auto captureFrame(const Fbo *frame, const Fbo *osd, const QMargins &m) -> void;
+    auto collectCaptures(bool wait) -> void;
+
+    // frame fbo scale and cheap scalers chosen from gpu timings
+    struct {
+        bool enabled = false, cheap = false;
+        double scale = 1.0;
+        int headroom = 0, cooldown = 0;
+    } dynres;
+
+    // playback speed factor which lines frames up with display refresh
+    // written in gui thread, read anywhere
+    struct {
+        bool enabled = false;
+        std::atomic<double> factor{1.0};
+        int cooldown = 0;
+    } dsync;
+    auto speed(double user) const -> double { return user * dsync.factor; }
+
+    // decoder threads chosen for current load
+    std::atomic<int> vdThreads{0};
+
+    // time to first frame of current load, only touched in mpv thread
+    struct {
+        QElapsedTimer timer;
+        qint64 hook = -1;
+        std::array<qint64, LoadStages::StageMax> stages;
+        bool pending = false;
+    } ttff;
+    QAtomicInt loadSerial = 0;
+    auto cancelLoad() -> void;
+
+    // measured network speed per host for adaptive caching, guarded by mutex
+    struct CacheRecord { double throughput = 0.0; int bitrate = 0; };
+    QHash<QString, CacheRecord> cacheRecords;
+    static auto cacheHost(const Mrl &mrl) -> QString
+    {
+        if (mrl.isLocalFile())
+            return OS::networkHost(mrl.toLocalFile());
+        return QUrl(mrl.toString()).host();
+    }
+    auto recordCache(const Mrl &mrl) -> void;
+    auto adaptCache(const Mrl &mrl, CacheInfo::Item &item, qint64 &initial) -> void;
+
+    // keyframes of playing file, precise seeks close to one are snapped to it
+    struct {
+        Mrl mrl;
+        KeyframeIndex index;
+        QSharedPointer<std::atomic<bool>> cancel;
+        int tolerance = 0;
+    } keyframes;
+    auto loadKeyframes() -> void;
+    auto cancelKeyframes() -> void;
+    auto snapToKeyframe(int ms) const -> int;
+
+    // audio overview of playing local file, shown in seek bar
+    struct {
+        Mrl mrl;
+        QSharedPointer<std::atomic<bool>> cancel;
+    } overview;
+    auto loadOverview() -> void;
+    auto cancelOverview() -> void;
+    auto setOverview(const AudioOverview &overview) -> void;
+
     QPoint mouse;
+    // disc menu, mouse moves in flight are not queued but latest one is kept
+    struct {
+        QRect button; // highlighted one in video coordinates
+        int moving = 0; bool pending = false;
+    } nav;
 
     auto resync(bool force = false) -> void;
     auto updateSubtitleStyle() -> void;
@@ -152,40 +344,69 @@ struct PlayEngine::Data {
         { mpv.tellAsync("audio_add", MpvFile(file), select ? "select"_b : "auto"_b); }
     auto sub_add(const QString &file, const EncodingInfo &enc, bool select) -> void;
     auto autoselect(const MrlState *s, QVector<SubComp> &loads) -> void;
-    auto autoloadFiles(StreamType type) -> MpvFileList;
+    auto autoloadFiles(StreamType type) -> MpvFileList { return autoloadFiles(type, mrl); }
+    auto autoloadFiles(StreamType type, const Mrl &mrl) -> MpvFileList;
     auto autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>;
     auto autoloadSubtitle(const MrlState *s, const MpvFileList &files) -> T<MpvFileList, QVector<SubComp>>;
+    auto loadSubtitleFiles(const QStringList &files, SubtitleLoads::Finished &&finished
+                           = nullptr) -> QSharedPointer<SubtitleLoads>;
+    auto takeSubtitles(const MrlState *s, const SubtitleLoads &loads) -> T<MpvFileList, QVector<SubComp>>;
+    auto attachSubtitles(const SubtitleLoads &loads) -> void;
+    auto addPendingSubtitleFiles() -> void;
 
     auto af(const MrlState *s) const -> QByteArray;
     auto vf(const MrlState *s) const -> QByteArray;
+    auto vfChain(const MrlState *s) const -> QByteArray;
     auto vo(const MrlState *s) const -> QByteArray;
+    auto updateVideoFilter() -> void;
+    auto updateAudioFilter() -> void;
     auto updateVideoScaler() -> void;
+    auto updateDynamicResolution() -> void;
+    auto setDynamicResolution(double scale, bool cheap) -> void;
+    auto updateDisplaySync() -> void;
+    auto updateStats() -> void;
+    auto updateStatsTimer() -> void;
+    auto setDisplaySyncFactor(double factor) -> void;
     auto videoSubOptions(const MrlState *s) const -> QByteArray;
     auto updateVideoSubOptions() -> void;
     auto updateVideoRendererFboFormat() -> void;
+    auto negotiateFboFormat() const -> OGL::TextureFormat;
+    // renegotiate and reconfigure vo if format changed
+    auto updateVideoFboFormat() -> void;
     auto renderVideoFrame(Fbo *frame, Fbo *osd, const QMargins &m) -> void;
     auto displaySize() const { return info.video.output()->size(); }
     auto post(State state) -> void { _PostEvent(p, StateChange, state); }
     auto post(Waitings w, bool set) -> void { _PostEvent(p, WaitingChange, w, set); }
     auto volume(const MrlState *s) const -> double;
-    auto loadfile(const Mrl &mrl, bool resume, const QString &sub = QString()) -> void;
+    auto loadfile(const Mrl &mrl, bool resume, const QString &sub = QString(),
+                  bool append = false) -> void;
     auto updateMediaName(const QString &name = QString()) -> void;
 
-    auto toTracks(const QVariant &var) -> QVector<StreamList>;
+    auto toTracks() -> QVector<StreamList>;
+    auto toChapters() -> QVector<ChapterData>;
+    // updates objects in place, true if list or any of its item changed
+    auto updateList(QVector<EditionChapterObject*> &list,
+                    const QVector<EditionChapterData> &data) -> bool;
     auto refresh() -> void {mpv.tellAsync("frame_step"); mpv.tell("frame_back_step");}
     auto observe() -> void;
+    auto updateTime(int pos) -> void;
+    auto sampleTime(int pos) -> void;
+    auto frameSwapped() -> void;
+    auto interpolateTime() -> void;
     auto process(QEvent *event) -> void;
     auto hook() -> void;
     auto setMousePos(const QPointF &pos)
     {
         if (!mpv.handle() || !params.d->disc)
             return false;
-        if (!_Change(mouse, vr->mapToVideo(pos).toPoint()))
-            return false;
-        mpv.tellAsync("mouse", mouse.x(), mouse.y());
-        return true;
+        return _Change(mouse, vr->mapToVideo(pos).toPoint());
     }
-    auto takeSnapshot() -> void;
+    auto moveMouse(bool force) -> void;
+    auto showSlide(const Mrl &mrl) -> bool;
+    auto updateAlbumArt() -> void;
+    auto takeSnapshot(const Fbo *frame, const Fbo *osd, const QMargins &m) -> void;
+    auto collectSnapshots(bool wait) -> void;
+    auto releaseSnapshots() -> void;
     auto localCopy() -> QSharedPointer<MrlState>;
     auto onLoad() -> void;
     auto onUnload() -> void;
@@ -201,6 +422,9 @@ struct PlayEngine::Data {
     }
     auto setSubtitleFiles(const QVector<SubtitleWithEncoding> &subs) -> void;
     auto addSubtitleFiles(const QVector<SubtitleWithEncoding> &subs) -> void;
+
+    // last members so that running jobs finish before anything else goes
+    QThreadPool subPool, loadPool, keyframePool, overviewPool;
 };
 
 #endif // PLAYENGINE_P_HPP
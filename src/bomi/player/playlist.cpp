@@ -2,9 +2,9 @@
 #include "misc/encodinginfo.hpp"
 #include "tmp/algorithm.hpp"
 #include "misc/objectstorage.hpp"
-#include <QCollator>
 #include <QTextStream>
 #include <QTextCodec>
+#include <QThreadPool>
 
 Playlist::Playlist()
 : QList<Mrl>() {}
@@ -25,11 +25,7 @@ Playlist::Playlist(const QList<Mrl> &rhs)
 
 auto Playlist::sort() -> void
 {
-    QCollator c;
-    c.setNumericMode(true);
-
-    tmp::sort(*this, [&](Mrl a, Mrl b) -> bool
-        { return c.compare(a.toString(), b.toString()) < 0; });
+    tmp::sort_by(*this, [] (const Mrl &mrl) { return _NaturalSortKey(mrl.toString()); });
 }
 
 auto Playlist::save(const QString &filePath, Type type) const -> bool
@@ -52,39 +48,54 @@ auto Playlist::save(const QString &filePath, Type type) const -> bool
     }
 }
 
-auto Playlist::load(QTextStream &in, const EncodingInfo &_enc,
+// whole text is decoded at once and split into lines without copies
+class PlaylistLines {
+public:
+    PlaylistLines(const QString &text): m_text(text) { }
+    auto atEnd() const -> bool { return m_pos >= m_text.size(); }
+    auto next() -> QStringRef
+    {
+        int end = m_text.indexOf('\n'_q, m_pos);
+        if (end < 0)
+            end = m_text.size();
+        const auto line = m_text.midRef(m_pos, end - m_pos);
+        m_pos = end + 1;
+        return line.trimmed();
+    }
+private:
+    const QString &m_text;
+    int m_pos = 0;
+};
+
+auto Playlist::load(const char *data, int size, const EncodingInfo &_enc,
                     Type type, const QUrl &url) -> bool
 {
     clear();
     EncodingInfo enc = _enc;
     if (type == M3U8)
         enc = EncodingInfo::utf8();
-    if (enc.isValid())
-        in.setCodec(enc.codec());
-    const qint64 pos = in.pos();
-    in.seek(0);
-    auto ret = [&] () {
-        switch (type) {
-        case PLS:
-            return loadPLS(in, url);
-        case M3U:
-        case M3U8:
-            return loadM3U(in, url);
-        case Cue:
-            return loadCue(in, url);
-        default:
-            return false;
-        }
-    }();
-    in.seek(pos);
-    return ret;
+    // same as QTextStream: bom first, then valid utf-8, then locale
+    if (!enc.isValid())
+        enc = EncodingInfo::sniff(data, size);
+    const auto text = enc.decode(data, size);
+    PlaylistLines in(text);
+    switch (type) {
+    case PLS:
+        return loadPLS(in, url);
+    case M3U:
+    case M3U8:
+        return loadM3U(in, url);
+    case Cue:
+        return loadCue(in, url);
+    default:
+        return false;
+    }
 }
 
 auto Playlist::load(const QUrl &url, QByteArray *data,
                     const EncodingInfo &enc, Type type) -> bool
 {
-    QTextStream in(data);
-    return load(in, enc, type, url);
+    return load(data->constData(), data->size(), enc, type, url);
 }
 
 auto Playlist::load(const QString &filePath, const EncodingInfo &enc, Type type) -> bool
@@ -94,8 +105,12 @@ auto Playlist::load(const QString &filePath, const EncodingInfo &enc, Type type)
         return false;
     if (type == Unknown)
         type = guessType(filePath);
-    QTextStream in(&file);
-    return load(in, enc, type, _UrlFromLocalFile(filePath));
+    const auto url = _UrlFromLocalFile(filePath);
+    const auto size = file.size();
+    if (auto mapped = size > 0 ? file.map(0, size) : nullptr)
+        return load(reinterpret_cast<const char*>(mapped), size, enc, type, url);
+    const auto data = file.readAll();
+    return load(data.constData(), data.size(), enc, type, url);
 }
 
 auto Playlist::load(const Mrl &mrl, const EncodingInfo &enc, Type type) -> bool
@@ -146,48 +161,72 @@ auto Playlist::saveM3U(QTextStream &out) const -> bool
     return true;
 }
 
-auto Playlist::loadPLS(QTextStream &in, const QUrl &url) -> bool
+auto Playlist::loadPLS(PlaylistLines &in, const QUrl &url) -> bool
 {
+    QVector<Entry> entries;
     while (!in.atEnd()) {
-        const QString line = in.readLine();
-        if (line.isEmpty())
+        const auto line = in.next();
+        // File<n>=<location>
+        if (!line.startsWith("File"_a))
+            continue;
+        int i = 4;
+        while (i < line.size() && line.at(i).isDigit())
+            ++i;
+        if (i == 4 || i + 1 >= line.size() || line.at(i) != '='_q)
             continue;
-        static QRegEx rxFile(uR"(^File\d+=(.+)$)"_q);
-        const auto match = rxFile.match(line);
-        if (match.hasMatch())
-            push_back(Mrl(resolve(match.captured(1), url)));
+        entries.push_back({line.mid(i + 1).toString(), QString()});
     }
+    resolve(entries, url);
     return true;
 }
 
-auto Playlist::loadM3U(QTextStream &in, const QUrl &url) -> bool
+auto Playlist::loadM3U(PlaylistLines &in, const QUrl &url) -> bool
 {
     auto getNextLocation = [&in] () -> QString {
         while (!in.atEnd()) {
-            const QString line = in.readLine().trimmed();
+            const auto line = in.next();
             if (!line.isEmpty() && !line.startsWith('#'_q))
-                return line;
+                return line.toString();
         }
         return QString();
     };
+    // #EXTINF:<duration>[ attributes],<name>
+    auto extInf = [] (const QStringRef &line, QString *name) -> bool {
+        if (!line.startsWith("#EXTINF"_a))
+            return false;
+        int i = 7;
+        while (i < line.size() && line.at(i).isSpace())
+            ++i;
+        if (i >= line.size() || line.at(i++) != ':'_q)
+            return false;
+        while (i < line.size() && line.at(i).isSpace())
+            ++i;
+        if (i < line.size() && line.at(i) == '-'_q)
+            ++i;
+        if (i >= line.size() || !line.at(i).isDigit())
+            return false;
+        const int comma = line.indexOf(','_q, i);
+        if (comma < 0)
+            return false;
+        *name = line.mid(comma + 1).trimmed().toString();
+        return true;
+    };
 
-    QRegEx rxExtInf(uR"(#EXTINF\s*:\s*(?<num>(-|)\d+)[^,]*,\s*(?<name>.*)\s*$)"_q);
+    QVector<Entry> entries;
     while (!in.atEnd()) {
-        const QString line = in.readLine().trimmed();
+        const auto line = in.next();
         if (line.isEmpty())
             continue;
-        QString name, location;
+        Entry entry;
         if (line.startsWith('#'_q)) {
-            auto matched = rxExtInf.match(line);
-            if (matched.hasMatch()) {
-                name = matched.captured(u"name"_q);
-                location = getNextLocation();
-            }
+            if (extInf(line, &entry.name))
+                entry.location = getNextLocation();
         } else
-            location = line;
-        if (!location.isEmpty())
-            push_back(Mrl(resolve(location, url), name));
+            entry.location = line.toString();
+        if (!entry.location.isEmpty())
+            entries.push_back(entry);
     }
+    resolve(entries, url);
     return true;
 }
 
@@ -213,8 +252,9 @@ struct CueTrack {
     }
 };
 
-auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
+auto Playlist::loadCue(PlaylistLines &in, const QUrl &url) -> bool
 {
+    const auto base = Playlist::base(url);
     CueTrack init;
     CueTrack *current = &init;
     QRegEx rxField(uR"#(^(\w+)\s+(.*)\s*$)#"_q);
@@ -223,7 +263,7 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
     QRegEx rxIndex(uR"(^\s*(\d\d)\s+(\d\d):(\d\d):(\d\d)\s*$)"_q);
     QVector<CueTrack> tracks;
     while (!in.atEnd()) {
-        const auto line = in.readLine().trimmed();
+        const auto line = in.next().toString();
         auto m = rxField.match(line);
         if (!m.hasMatch())
             continue;
@@ -241,7 +281,7 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
             m = rxFile.match(value);
             if (!m.hasMatch())
                 return false;
-            current->file = resolve(m.captured(1), url);
+            current->file = resolve(m.captured(1), base);
             continue;
         }
         if (key == "INDEX"_a) {
@@ -282,26 +322,114 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
     return true;
 }
 
-auto Playlist::resolve(const QString &location, const QUrl &url) -> QString
+// directory part of playlist url, which is prepended to relative paths
+auto Playlist::base(const QUrl &url) -> QString
 {
-    if (url.isEmpty() || location.indexOf("://"_a) > 0)
-        return location;
-    const QFileInfo info(location);
-    if (info.isAbsolute())
-        return location;
+    if (url.isEmpty())
+        return QString();
     const auto str = url.toString();
     const auto idx = str.lastIndexOf('/'_q);
-    if (idx < 0)
+    return idx < 0 ? QString() : str.left(idx + 1);
+}
+
+auto Playlist::resolve(const QString &location, const QString &base) -> QString
+{
+    if (base.isEmpty() || location.indexOf("://"_a) > 0)
+        return location;
+    if (QDir::isAbsolutePath(location))
         return location;
-    return str.left(idx + 1) % location;
+    return base % location;
 }
 
+class PlaylistResolveJob : public QRunnable {
+public:
+    PlaylistResolveJob(const Playlist::Entry *entries, Mrl *mrls, int count,
+                       const QString &base)
+        : m_entries(entries), m_mrls(mrls), m_count(count), m_base(base) { }
+    auto run() -> void final
+    {
+        for (int i = 0; i < m_count; ++i) {
+            auto &entry = m_entries[i];
+            m_mrls[i] = Mrl(Playlist::resolve(entry.location, m_base), entry.name);
+        }
+    }
+private:
+    const Playlist::Entry *m_entries;
+    Mrl *m_mrls;
+    int m_count;
+    QString m_base;
+};
+
+// entries are made into mrls after parsing, in parallel for long lists
+auto Playlist::resolve(const QVector<Entry> &entries, const QUrl &url) -> void
+{
+    static constexpr int Chunk = 4096;
+    const auto base = Playlist::base(url);
+    QVector<Mrl> mrls(entries.size());
+    if (entries.size() < Chunk * 2) {
+        PlaylistResolveJob(entries.data(), mrls.data(), entries.size(), base).run();
+    } else {
+        QThreadPool pool;
+        for (int from = 0; from < entries.size(); from += Chunk) {
+            const int count = qMin(Chunk, entries.size() - from);
+            pool.start(new PlaylistResolveJob(entries.data() + from,
+                                              mrls.data() + from, count, base));
+        }
+        pool.waitForDone();
+    }
+    reserve(size() + mrls.size());
+    for (auto &mrl : mrls)
+        push_back(mrl);
+}
+
+// compact form of playlist for session restore: utf-8 location and name
+// pairs in one blob instead of a versioned Mrl record per entry
+static constexpr quint32 CompactMark = 0xffffffff;
+static constexpr qint32 CompactVersion = 1;
+
 auto operator << (QDataStream &out, const Playlist &pl) -> QDataStream&
 {
-    return out << static_cast<const QList<Mrl>&>(pl);
+    QByteArray blob;
+    for (auto &mrl : pl) {
+        blob += mrl.toString().toUtf8();
+        blob += '\0';
+        blob += mrl.name().toUtf8();
+        blob += '\0';
+    }
+    return out << CompactMark << CompactVersion << (qint32)pl.size() << blob;
 }
 
 auto operator >> (QDataStream &in, Playlist &pl) -> QDataStream&
 {
-    return in >> static_cast<QList<Mrl>&>(pl);
+    pl.clear();
+    quint32 mark = 0;
+    in >> mark;
+    if (mark != CompactMark) {
+        // plain list of mrls in older versions
+        pl.reserve(mark);
+        for (quint32 i = 0; i < mark && !in.atEnd(); ++i) {
+            Mrl mrl;
+            in >> mrl;
+            pl.push_back(mrl);
+        }
+        return in;
+    }
+    qint32 version = 0, count = 0; QByteArray blob;
+    in >> version >> count >> blob;
+    if (version != CompactVersion)
+        return in;
+    pl.reserve(count);
+    const char *p = blob.constData(), *end = p + blob.size();
+    while (p < end) {
+        const auto loc = p;
+        p += qstrnlen(p, end - p) + 1;
+        if (p > end)
+            break;
+        const auto name = p;
+        p += qstrnlen(p, end - p) + 1;
+        if (p > end)
+            break;
+        pl.push_back(Mrl(QString::fromUtf8(loc), QString::fromUtf8(name)));
+    }
+    return in;
 }
@@ -6,6 +6,7 @@
 
 class QFile;                            class QDir;
 class EncodingInfo;                     class ObjectStorage;
+class PlaylistLines;
 
 class Playlist : public QList<Mrl> {
 public:
@@ -24,15 +25,19 @@ public:
     auto load(const QUrl &url, QByteArray *data, const EncodingInfo &enc, Type type) -> bool;
     static auto guessType(const QString &fileName) -> Type;
     static auto typeForSuffix(const QString &suffix) -> Type;
+    // parsed entry before its location is resolved
+    struct Entry { QString location, name; };
+    static auto resolve(const QString &location, const QString &base) -> QString;
 private:
-    static auto resolve(const QString &location, const QUrl &url) -> QString;
+    static auto base(const QUrl &url) -> QString;
+    auto resolve(const QVector<Entry> &entries, const QUrl &url) -> void;
     auto savePLS(QTextStream &out) const -> bool;
     auto saveM3U(QTextStream &out) const -> bool;
-    auto load(QTextStream &in, const EncodingInfo &enc, Type type,
+    auto load(const char *data, int size, const EncodingInfo &enc, Type type,
               const QUrl &url = QUrl()) -> bool;
-    auto loadPLS(QTextStream &in, const QUrl &url = QUrl()) -> bool;
-    auto loadM3U(QTextStream &in, const QUrl &url = QUrl()) -> bool;
-    auto loadCue(QTextStream &in, const QUrl &url = QUrl()) -> bool;
+    auto loadPLS(PlaylistLines &in, const QUrl &url = QUrl()) -> bool;
+    auto loadM3U(PlaylistLines &in, const QUrl &url = QUrl()) -> bool;
+    auto loadCue(PlaylistLines &in, const QUrl &url = QUrl()) -> bool;
 };
 
 Q_DECLARE_METATYPE(Playlist)
@@ -1,16 +1,39 @@
 #include "playlistmodel.hpp"
 #include "misc/downloader.hpp"
 #include "misc/encodinginfo.hpp"
-#include <random>
+#include "mediaprobe.hpp"
 #include <chrono>
 #include <QQuickItem>
 
 PlaylistModel::PlaylistModel(QObject *parent)
 : Super(parent) {
+    using std::chrono::system_clock;
+    m_random.seed(system_clock::now().time_since_epoch().count());
+    // base emits rowsChanged and specialRowChanged in between begin and end
+    // of changes, so order follows rows before anyone asks for next
+    auto invalidate = [=] () { m_next = m_previous = -2; };
+    connect(this, &PlaylistModel::modelAboutToBeReset, this, [=] () {
+        m_order.clear();
+        m_position.clear();
+        invalidate();
+    });
+    connect(this, &PlaylistModel::rowsAboutToBeInserted, this,
+            [=] (const QModelIndex &, int first, int last) {
+        insertShuffled(first, last - first + 1);
+        invalidate();
+    });
+    connect(this, &PlaylistModel::rowsAboutToBeRemoved, this,
+            [=] (const QModelIndex &, int first, int last) {
+        removeShuffled(first, last - first + 1);
+        invalidate();
+    });
+    connect(this, &PlaylistModel::specialRowChanged, this, invalidate);
     connect(this, &PlaylistModel::modelReset, this, &PlaylistModel::contentWidthChanged);
     connect(this, &PlaylistModel::rowsChanged, this, &PlaylistModel::countChanged);
     connect(this, &PlaylistModel::specialRowChanged, this, &PlaylistModel::loadedChanged);
     connect(this, &PlaylistModel::loadedChanged, this, &PlaylistModel::nextChanged);
+    // connected before any view, so views never read stale rows
+    connect(this, &PlaylistModel::contentsChanged, this, [=] () { m_pages.clear(); });
 }
 
 PlaylistModel::~PlaylistModel() {}
@@ -21,17 +44,24 @@ auto PlaylistModel::next() const -> int
         return -1;
     if (!m_shuffled)
         return (loaded() >= rows() - 1 && m_repeat) ? 0 : loaded() + 1;
-    if (m_shuffledIdx.size() != rows())
-        shuffle();
-    const int find = m_shuffledIdx.indexOf(loaded());
-    if (find == -1)
-        return m_shuffledIdx.first();
-    if (find < m_shuffledIdx.size() - 1)
-        return m_shuffledIdx[find + 1];
-    if (!m_repeat)
-        return -1;
-    shuffle();
-    return m_shuffledIdx.first();
+    if (m_next > -2)
+        return m_next;
+    if (m_order.size() != rows())
+        shuffle(loaded(), true);
+    const int pos = isValidRow(loaded()) ? m_position[loaded()] : -1;
+    if (pos < 0)
+        m_next = m_order.first();
+    else if (pos < m_order.size() - 1)
+        m_next = m_order[pos + 1];
+    else if (!m_repeat)
+        m_next = -1;
+    else {
+        // next round
+        shuffle(loaded(), false);
+        m_previous = -2;
+        m_next = m_order.first();
+    }
+    return m_next;
 }
 
 auto PlaylistModel::previous() const -> int
@@ -40,47 +70,102 @@ auto PlaylistModel::previous() const -> int
         return -1;
     if (!m_shuffled)
         return (loaded() <= 0 && m_repeat) ? rows() - 1 : loaded() - 1;
-    if (m_shuffledIdx.size() != rows())
-        shuffle();
-    const int find = m_shuffledIdx.indexOf(loaded());
-    if (find == -1)
-        return m_shuffledIdx.first();
-    if (find > 0)
-        return m_shuffledIdx[find - 1];
-    if (!m_repeat)
-        return -1;
-    shuffle();
-    return m_shuffledIdx.last();
+    if (m_previous > -2)
+        return m_previous;
+    if (m_order.size() != rows())
+        shuffle(loaded(), true);
+    const int pos = isValidRow(loaded()) ? m_position[loaded()] : -1;
+    if (pos < 0)
+        m_previous = m_order.first();
+    else if (pos > 0)
+        m_previous = m_order[pos - 1];
+    else if (!m_repeat)
+        m_previous = -1;
+    else {
+        // previous round
+        shuffle(loaded(), true);
+        m_next = -2;
+        m_previous = m_order.last();
+    }
+    return m_previous;
+}
+
+auto PlaylistModel::shuffle(int keep, bool front) const -> void
+{
+    m_order.resize(rows());
+    for (int i = 0; i < m_order.size(); ++i)
+        m_order[i] = i;
+    std::shuffle(m_order.begin(), m_order.end(), m_random);
+    if (isValidRow(keep)) {
+        const int pos = m_order.indexOf(keep);
+        std::swap(m_order[pos], front ? m_order.first() : m_order.last());
+    }
+    m_position.resize(m_order.size());
+    for (int i = 0; i < m_order.size(); ++i)
+        m_position[m_order[i]] = i;
 }
 
-auto PlaylistModel::shuffle() const -> void
+auto PlaylistModel::insertShuffled(int first, int count) -> void
 {
-    if (!m_shuffled) {
-        m_shuffledIdx.clear();
+    if (m_order.size() != rows() || count <= 0)
         return;
+    // new rows are spread over what is left to play in this round
+    const int from = isValidRow(loaded()) ? m_position[loaded()] + 1 : 0;
+    std::uniform_int_distribution<int> dist(from, m_order.size());
+    QVector<QPair<int, int>> inserts(count);
+    for (int i = 0; i < count; ++i)
+        inserts[i] = qMakePair(dist(m_random), first + i);
+    std::sort(inserts.begin(), inserts.end());
+    QVector<int> order;
+    order.reserve(m_order.size() + count);
+    int next = 0;
+    for (int i = 0; i <= m_order.size(); ++i) {
+        for (; next < count && inserts[next].first == i; ++next)
+            order.push_back(inserts[next].second);
+        if (i < m_order.size())
+            order.push_back(m_order[i] >= first ? m_order[i] + count : m_order[i]);
     }
-    m_shuffledIdx.resize(rows());
-    for (int i = 0; i < m_shuffledIdx.size(); ++i)
-        m_shuffledIdx[i] = i;
-    if (m_shuffledIdx.size() < 2 || !m_shuffled)
+    m_order.swap(order);
+    m_position.resize(m_order.size());
+    for (int i = 0; i < m_order.size(); ++i)
+        m_position[m_order[i]] = i;
+}
+
+auto PlaylistModel::removeShuffled(int first, int count) -> void
+{
+    if (m_order.size() != rows() || count <= 0)
         return;
-    using namespace std; using std::chrono::system_clock;
-    static const auto seed = system_clock::now().time_since_epoch().count();
-    std::shuffle(m_shuffledIdx.begin(), m_shuffledIdx.end(),
-                 default_random_engine(seed));
+    const int last = first + count - 1;
+    int size = 0;
+    for (int i = 0; i < m_order.size(); ++i) {
+        const int row = m_order[i];
+        if (row < first)
+            m_order[size++] = row;
+        else if (row > last)
+            m_order[size++] = row - count;
+    }
+    m_order.resize(size);
+    m_position.resize(size);
+    for (int i = 0; i < size; ++i)
+        m_position[m_order[i]] = i;
 }
 
 auto PlaylistModel::setShuffled(bool shuffled) -> void
 {
     if (!_Change(m_shuffled, shuffled))
         return;
+    m_order.clear();
+    m_position.clear();
+    m_next = m_previous = -2;
     emit shuffledChanged();
 }
 
 auto PlaylistModel::setRepeat(bool repeat) -> void
 {
-    if (_Change(m_repeat, repeat))
-        emit repeatChanged();
+    if (!_Change(m_repeat, repeat))
+        return;
+    m_next = m_previous = -2;
+    emit repeatChanged();
 }
 
 auto PlaylistModel::roleNames() const -> QHash<int, QByteArray>
@@ -89,19 +174,46 @@ auto PlaylistModel::roleNames() const -> QHash<int, QByteArray>
     names[NameRole] = "name";
     names[LocationRole] = "location";
     names[LoadedRole] = "isLoaded";
+    names[DurationRole] = "duration";
+    names[TitleRole] = "title";
+    names[RecordRole] = "record";
     return names;
 }
 
-auto PlaylistModel::number(int row) const -> QString
+auto PlaylistModel::cached(int row) const -> const Row&
 {
-    if (m_fill.isNull())
-        return QString::number(row+1);
-    int digits = 0, left = rows();
-    do {
-        ++digits;
-        left = left/10;
-    } while (left);
-    return _N(row+1, 10, digits, m_fill);
+    static const Row null;
+    if (!isValidRow(row))
+        return null;
+    const int page = row / PageSize;
+    auto it = m_pages.find(page);
+    if (it == m_pages.end()) {
+        while (m_pages.size() >= MaxPages) {
+            // drop the farthest page
+            const bool front = page - m_pages.firstKey() > m_pages.lastKey() - page;
+            m_pages.erase(front ? m_pages.begin() : --m_pages.end());
+        }
+        int digits = 0, left = rows();
+        do {
+            ++digits;
+            left = left/10;
+        } while (left);
+        const int from = page * PageSize, to = qMin(from + PageSize, rows());
+        QVector<Row> items(to - from);
+        for (int i = from; i < to; ++i) {
+            auto &item = items[i - from];
+            const auto &mrl = at(i);
+            item.name = mrl.displayName();
+            item.location = mrl.isLocalFile() ? mrl.toLocalFile() : mrl.toString();
+            item.number = m_fill.isNull() ? QString::number(i + 1)
+                                          : _N(i + 1, 10, digits, m_fill);
+            item.record[u"name"_q] = item.name;
+            item.record[u"location"_q] = item.location;
+            item.record[u"number"_q] = item.number;
+        }
+        it = m_pages.insert(page, items);
+    }
+    return (*it)[row - page * PageSize];
 }
 
 auto PlaylistModel::play(int row) -> void
@@ -110,12 +222,6 @@ auto PlaylistModel::play(int row) -> void
         emit playRequested(row);
 }
 
-auto PlaylistModel::location(int row) const -> QString
-{
-    auto mrl = value(row);
-    return mrl.isLocalFile() ? mrl.toLocalFile() : mrl.toString();
-}
-
 auto PlaylistModel::roleData(int row, int, int role) const -> QVariant
 {
     if (!isValidRow(row))
@@ -126,6 +232,17 @@ auto PlaylistModel::roleData(int row, int, int role) const -> QVariant
         return location(row);
     } else if (role == LoadedRole)
         return loaded() == row;
+    else if (role == RecordRole)
+        return cached(row).record;
+    else if (role == DurationRole || role == TitleRole) {
+        // filled from last playback, files are never opened here
+        if (!m_probes)
+            return QVariant();
+        const auto probe = m_probes->find(value(row));
+        if (!probe.isValid())
+            return QVariant();
+        return role == DurationRole ? QVariant(probe.duration) : QVariant(probe.title);
+    }
     return QVariant();
 }
 
@@ -3,8 +3,10 @@
 
 #include "playlist.hpp"
 #include "misc/simplelistmodel.hpp"
+#include <random>
 
 class Downloader;                       class EncodingInfo;
+class MediaProbeCache;
 
 class PlaylistModel : public SimpleListModel<Mrl, Playlist> {
     Q_OBJECT
@@ -20,7 +22,8 @@ class PlaylistModel : public SimpleListModel<Mrl, Playlist> {
     Q_PROPERTY(bool repetitive READ repeat NOTIFY repeatChanged)
     Q_ENUMS(Role)
 public:
-    enum Role {NameRole = Qt::UserRole + 1, LocationRole, LoadedRole};
+    enum Role {NameRole = Qt::UserRole + 1, LocationRole, LoadedRole,
+               DurationRole, TitleRole, RecordRole};
     PlaylistModel(QObject *parent = 0);
     ~PlaylistModel();
 
@@ -41,9 +44,9 @@ public:
     auto isShuffled() const -> bool { return m_shuffled; }
     auto selected() const -> int { return m_selected; }
     auto repeat() const -> bool { return m_repeat; }
-    Q_INVOKABLE QString name(int row) const {return value(row).displayName();}
-    Q_INVOKABLE QString location(int row) const;
-    Q_INVOKABLE QString number(int row) const;
+    Q_INVOKABLE QString name(int row) const { return cached(row).name; }
+    Q_INVOKABLE QString location(int row) const { return cached(row).location; }
+    Q_INVOKABLE QString number(int row) const { return cached(row).number; }
     Q_INVOKABLE bool isLoaded(int row) const {return loaded() == row;}
 
     auto open(const Mrl &mrl, const EncodingInfo &enc) -> void;
@@ -55,6 +58,7 @@ public:
     auto setVisible(bool visible) -> void;
     auto toggle() -> void { setVisible(!isVisible()); }
     auto setDownloader(Downloader *downloader) -> void;
+    auto setProbeCache(const MediaProbeCache *probes) -> void { m_probes = probes; }
     Q_INVOKABLE void clear() { setList(Playlist()); }
     Q_INVOKABLE void playNext() { play(next()); }
     Q_INVOKABLE void playPrevious() { play(previous()); }
@@ -77,19 +81,35 @@ signals:
     void nextChanged();
 private:
     friend class PlayEngine;
+    // formatted once per row, every page is dropped when list changes
+    struct Row {
+        QString name, location, number;
+        QVariantMap record;
+    };
+    static constexpr int PageSize = 64, MaxPages = 16;
+    auto cached(int row) const -> const Row&;
     auto setLoaded(int row) -> void;
-    auto shuffle() const -> void;
+    // new order of all rows, keep is placed at front or back of it
+    auto shuffle(int keep, bool front) const -> void;
+    auto insertShuffled(int first, int count) -> void;
+    auto removeShuffled(int first, int count) -> void;
     QChar m_fill = QChar::Null;
     bool m_visible = false;
     int m_selected = -1;
     Downloader *m_downloader = nullptr;
+    const MediaProbeCache *m_probes = nullptr;
     EncodingInfo m_enc;
     bool m_shuffled = false, m_repeat = false;
-    mutable QVector<int> m_shuffledIdx;
+    // order of rows in shuffled play and position of each row in it
+    mutable QVector<int> m_order, m_position;
+    mutable std::mt19937 m_random;
+    // valid until list, loaded row or mode changes, -2 if not computed
+    mutable int m_next = -2, m_previous = -2;
+    mutable QMap<int, QVector<Row>> m_pages;
 };
 
 inline auto PlaylistModel::setFillChar(QChar c) -> void
-{ if (_Change(m_fill, c)) emit fillCharChanged(); }
+{ if (_Change(m_fill, c)) { m_pages.clear(); emit fillCharChanged(); } }
 
 inline auto PlaylistModel::setVisible(bool visible) -> void
 { if (_Change(m_visible, visible)) emit visibleChanged(m_visible); }
@@ -41,6 +41,7 @@ auto RecentInfo::stack(const Mrl &mrl) -> void
         d->openList.pop_back();
     if (d->update)
         d->update(d->openList);
+    d->storage.saveLater();
 }
 
 auto RecentInfo::clear() -> void
@@ -48,6 +49,7 @@ auto RecentInfo::clear() -> void
     d->openList.clear();
     if (d->update)
         d->update(d->openList);
+    d->storage.saveLater();
 }
 
 auto RecentInfo::save() const -> void
@@ -34,6 +34,7 @@ struct MenuActionInfo
 {
     MenuActionInfo() = default;
     QAction *action = nullptr;
+    // static source text needs no closure, trans is for dynamic ones
     Translate trans;
     const char *desc = nullptr;
 };
@@ -43,7 +44,8 @@ struct RootMenu::Data {
     MenuActionInfo *info = nullptr;
     QMap<QString, QString> alias;
     QMap<QString, MenuActionInfo> actions;
-    QMap<QKeySequence, QAction*> keymap;
+    // single key shortcuts sorted by code, rebuilt in setShortcutMap()
+    std::vector<std::pair<int, QAction*>> keys;
 
     auto find(const QString &longId) const -> QAction*
     {
@@ -82,28 +84,33 @@ struct RootMenu::Data {
 
     template<class T>
     auto reg(T *obj, const QString &id, const char *trans) -> T*
-    { return reg(obj, id, toGetText(trans)); }
+    { newInfo(obj, id)->desc = trans; return obj; }
 
     template<class T>
     auto reg(T *obj, const QString &id, Translate &&translate) -> T*
     { newInfo(obj, id)->trans = std::move(translate); return obj; }
 
     template<class Func>
-    auto menu(const QString &id, GetText &&gt, Func &&func) -> Menu*
+    auto fill(Menu *menu, Func &&func) -> Menu*
     {
-        Q_ASSERT(parent);
-        auto menu = parent->addMenu(id);
-        reg(menu, id, std::move(gt));
         std::swap(parent, menu);
         func();
         std::swap(parent, menu);
         return menu;
     }
 
+    template<class Func>
+    auto menu(const QString &id, GetText &&gt, Func &&func) -> Menu*
+    {
+        Q_ASSERT(parent);
+        return fill(reg(parent->addMenu(id), id, std::move(gt)), std::move(func));
+    }
+
     template<class Func>
     auto menu(const QString &id, const char *tr, Func &&func) -> Menu*
     {
-        return menu(id, toGetText(tr), std::move(func));
+        Q_ASSERT(parent);
+        return fill(reg(parent->addMenu(id), id, tr), std::move(func));
     }
 
     auto action(const QString &id, const char *tr, bool checkable = false) -> QAction*
@@ -176,7 +183,12 @@ struct RootMenu::Data {
     template<class T>
     auto enumAction(T t, const QString &key, const char *trans, bool ch = false,
                     const QString &g = QString()) -> EnumAction<T>*
-    { return enumAction<T>(t, key, toGetText(trans), ch, g); }
+    {
+        auto action = _NewEnumAction<T>(t);
+        action->setCheckable(ch);
+        reg(parent->addActionToGroup(action, key, g), key, trans);
+        return action;
+    }
 
     template<class T>
     auto enumActions(const EnumItemVector<T> &items, bool checkable) -> void
@@ -391,7 +403,11 @@ RootMenu::RootMenu()
             d->separator();
             d->stepPair(u"adjust"_q);
         });
-        d->menu(u"crop"_q, QT_TR_NOOP("Crop"), [=] () { addRatioActions(); });
+        d->menu(u"crop"_q, QT_TR_NOOP("Crop"), [=] () {
+            addRatioActions();
+            d->separator();
+            d->action(u"auto"_q, QT_TR_NOOP("Detect Black Bars"), true);
+        });
         d->menuStepReset(u"zoom"_q, QT_TR_NOOP("Zoom"));
         d->enumMenuCheckable<Rotation>(true);
 
@@ -616,6 +632,8 @@ RootMenu::RootMenu()
         d->action(u"subtitle"_q, QT_TR_NOOP("Subtitle Viewer"));
         d->action(u"playinfo"_q, QT_TR_NOOP("Playback Information"));
         d->action(u"log"_q, QT_TR_NOOP("Log Viewer"));
+        d->action(u"trace"_q, QT_TR_NOOP("Record Trace"), true);
+        d->action(u"contact-sheet"_q, QT_TR_NOOP("Export Thumbnail Sheets"));
         d->separator();
 
         d->action(u"pref"_q, QT_TR_NOOP("Preferences"))->setMenuRole(QAction::PreferencesRole);
@@ -704,16 +722,25 @@ auto RootMenu::resolve(const QString &id) const -> QString
 
 auto RootMenu::setShortcutMap(const ShortcutMap &map) -> void
 {
-    d->keymap.clear();
+    d->keys.clear();
     for (auto it = d->actions.cbegin(); it != d->actions.cend(); ++it) {
         const auto &keys = map.keys(it.key());
         const auto action = it->action;
         action->setShortcuts(keys);
         for (auto &key : keys) {
-            if (!key.isEmpty())
-                d->keymap[key] = action;
+            if (key.count() == 1)
+                d->keys.emplace_back(key[0], action);
         }
     }
+    std::stable_sort(d->keys.begin(), d->keys.end(),
+                     [] (const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+    // the last binding wins for duplicated key
+    auto out = d->keys.begin();
+    for (auto it = d->keys.begin(); it != d->keys.end(); ++it) {
+        if (it + 1 == d->keys.end() || (it + 1)->first != it->first)
+            *out++ = *it;
+    }
+    d->keys.erase(out, d->keys.end());
 #ifdef Q_OS_MAC
     a(u"exit"_q)->setShortcut(QKeySequence());
 #endif
@@ -725,7 +752,9 @@ auto RootMenu::retranslate() -> void
         Q_ASSERT(info.action);
         if (info.action->objectName().isEmpty())
             continue;
-        if (!info.trans)
+        if (info.desc)
+            Data::translate(info.action, tr(info.desc));
+        else if (!info.trans)
             _Error("'%%' is not tranlsatable.", info.action->objectName());
         else
             info.trans();
@@ -758,7 +787,14 @@ auto RootMenu::action(const QString &id) const -> QAction*
 
 auto RootMenu::action(const QKeySequence &shortcut) const -> QAction*
 {
-    return d->keymap.value(shortcut);
+    return shortcut.count() == 1 ? action(shortcut[0]) : nullptr;
+}
+
+auto RootMenu::action(int key) const -> QAction*
+{
+    auto it = std::lower_bound(d->keys.begin(), d->keys.end(), key,
+                               [] (const auto &item, int key) { return item.first < key; });
+    return it != d->keys.end() && it->first == key ? it->second : nullptr;
 }
 
 struct DumpInfo {
@@ -14,6 +14,8 @@ public:
     auto description(const QString &id) const -> QString;
     auto action(const QString &id) const -> QAction*;
     auto action(const QKeySequence &key) const -> QAction*;
+    // key code combined with modifiers, as an element of QKeySequence
+    auto action(int key) const -> QAction*;
     auto setShortcutMap(const ShortcutMap &map) -> void;
     auto resolve(const QString &id) const -> QString;
     static auto instance() -> RootMenu&;
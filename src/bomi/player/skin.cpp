@@ -51,20 +51,25 @@ auto Skin::names(bool reload/* = false*/) -> QStringList
     return d->skins.keys();
 }
 
-auto Skin::apply(QQuickView *view, const QString &name) -> void
+auto Skin::prepare(QQmlEngine *engine, const QString &name) -> QUrl
 {
     if (data()->skins.isEmpty())
         names(true);
-    auto imports = view->engine()->importPathList();
+    auto imports = engine->importPathList();
     for (auto path : data()->qmls) {
         if (!imports.contains(path))
-            view->engine()->addImportPath(path);
+            engine->addImportPath(path);
     }
-    const auto skin = Skin::source(name);
+    return QUrl::fromLocalFile(Skin::source(name).absoluteFilePath());
+}
+
+auto Skin::apply(QQuickView *view, const QString &name) -> void
+{
+    const auto url = prepare(view->engine(), name);
     view->setResizeMode(QQuickView::SizeRootObjectToView);
     const auto current = QDir::currentPath();
     QDir::setCurrent(qApp->applicationDirPath());
-    view->setSource(QUrl::fromLocalFile(skin.absoluteFilePath()));
+    view->setSource(url);
     QDir::setCurrent(current);
 }
 
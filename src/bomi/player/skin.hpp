@@ -1,7 +1,7 @@
 #ifndef SKIN_HPP
 #define SKIN_HPP
 
-class QQuickView;
+class QQuickView;                       class QQmlEngine;
 
 class Skin {
 public:
@@ -10,6 +10,8 @@ public:
     static auto names(bool reload = false) -> QStringList;
     static auto source(const QString &name) -> QFileInfo;
     static auto apply(QQuickView *view, const QString &name) -> void;
+    // import paths are added to engine, so url can be compiled by itself
+    static auto prepare(QQmlEngine *engine, const QString &name) -> QUrl;
 protected:
     Skin() {}
 private:
@@ -1,6 +1,7 @@
 #include "streamtrack.hpp"
 #include "subtitle/subtitle.hpp"
 #include "misc/locale.hpp"
+#include <libmpv/client.h>
 
 SIA type2str(StreamType type) -> QString
 {
@@ -82,29 +83,51 @@ auto StreamTrack::name() const -> QString
     return name;
 }
 
-auto StreamTrack::fromMpvData(const QVariant &mpv) -> StreamTrack
+auto StreamTrack::fromMpvNode(const mpv_node &node) -> StreamTrack
 {
-    const auto map = mpv.toMap();
+    if (node.format != MPV_FORMAT_NODE_MAP)
+        return StreamTrack();
     StreamTrack track;
-    track.m_type = str2type(map[u"type"_q].toString());
+    auto list = node.u.list;
+    for (int i = 0; i < list->num; ++i) {
+        const char *key = list->keys[i];
+        const auto &value = list->values[i];
+        auto string = [&] () {
+            return value.format == MPV_FORMAT_STRING
+                    ? QString::fromUtf8(value.u.string) : QString();
+        };
+        auto flag = [&] () {
+            return value.format == MPV_FORMAT_FLAG && value.u.flag;
+        };
+        if (!qstrcmp(key, "type"))
+            track.m_type = str2type(string());
+        else if (!qstrcmp(key, "id"))
+            track.m_id = value.format == MPV_FORMAT_INT64 ? value.u.int64 : -1;
+        else if (!qstrcmp(key, "albumart"))
+            track.m_albumart = flag();
+        else if (!qstrcmp(key, "codec"))
+            track.m_codec = string();
+        else if (!qstrcmp(key, "default"))
+            track.m_default = flag();
+        else if (!qstrcmp(key, "lang"))
+            track.m_lang = string();
+        else if (!qstrcmp(key, "title"))
+            track.m_title = string();
+        else if (!qstrcmp(key, "external-filename"))
+            track.m_file = string();
+        else if (!qstrcmp(key, "selected"))
+            track.m_selected = flag();
+    }
     if (track.m_type == StreamUnknown)
         return StreamTrack();
-    track.m_albumart = map[u"albumart"_q].toBool();
-    track.m_codec = map[u"codec"_q].toString();
-    track.m_default = map[u"default"_q].toBool();
-    track.m_id = map[u"id"_q].toInt();
-    track.m_lang = map[u"lang"_q].toString();
     if (_InRange(2, track.m_lang.size(), 3) && _IsAlphabet(track.m_lang))
         track.m_displayLang = Locale::isoToNativeName(track.m_lang);
-    track.m_title = map[u"title"_q].toString();
-    track.m_file = map[u"external-filename"_q].toString();
     if (!track.m_file.isEmpty()) {
         if (track.m_file.contains("googlevideo.com/videoplayback"_a))
             track.m_title.clear();
         else
             track.m_title = QFileInfo(track.m_file).fileName();
     }
-    track.m_selected = map[u"selected"_q].toBool();
     return track;
 }
 
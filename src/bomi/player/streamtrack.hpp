@@ -6,6 +6,7 @@
 enum StreamType { StreamAudio = 0, StreamVideo, StreamSubtitle, StreamInclusiveSubtitle, StreamUnknown };
 
 class SubComp;
+struct mpv_node;
 
 class StreamTrack {
     Q_DECLARE_TR_FUNCTIONS(StreamTrack)
@@ -35,7 +36,8 @@ public:
     auto isValid() const -> bool { return m_type != StreamUnknown; }
     static auto typeDescription(StreamType type, bool albumart = false) -> QString;
     static auto fromJson(const QJsonObject &json) -> StreamTrack;
-    static auto fromMpvData(const QVariant &mpv) -> StreamTrack;
+    // reads map node of track-list directly without QVariant
+    static auto fromMpvNode(const mpv_node &node) -> StreamTrack;
     static auto fromSubComp(const SubComp &comp) -> StreamTrack;
 private:
     friend class PlayEngine;
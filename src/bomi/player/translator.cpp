@@ -25,7 +25,9 @@ struct Translator::Data {
     QTranslator trans, qt;
     QString path, def, file;
     QStringList dirs;
+    // available translations are listed only when asked
     QSet<Locale> locales;
+    bool scanned = false;
     auto tryLoad(QTranslator *tr, const QString &file) -> bool
     {
         for (auto &dir : dirs) {
@@ -67,8 +69,6 @@ Translator::Translator()
 
     qApp->installTranslator(&d->trans);
     qApp->installTranslator(&d->qt);
-    for (auto &dir : d->dirs)
-        d->locales += getLocales(dir, u"*.qm"_q, u"(.*).qm"_q);
 }
 
 Translator::~Translator() {
@@ -83,8 +83,14 @@ auto Translator::get() -> Translator&
 
 auto Translator::availableLocales() -> LocaleList
 {
+    auto d = get().d;
+    if (!d->scanned) {
+        for (auto &dir : d->dirs)
+            d->locales += getLocales(dir, u"*.qm"_q, u"(.*).qm"_q);
+        d->scanned = true;
+    }
     LocaleList list;
-    for (auto &locale : get().d->locales)
+    for (auto &locale : d->locales)
         list.push_back(locale);
     return list;
 }
@@ -217,18 +217,56 @@ static void write(const EnumType &type) {
         }
     }
     cases += "        default: return QString();";
+
+    // names are switched by length first and literals compare without allocation
+    vector<size_t> lengths;
+    for (const EnumType::Item &item : type.items) {
+        if (find(lengths.begin(), lengths.end(), item.name.size()) == lengths.end())
+            lengths.push_back(item.name.size());
+    }
+    sort(lengths.begin(), lengths.end());
+    string finds;
+    for (auto length : lengths) {
+        finds += "        case " + toString(length) + ":\n";
+        for (size_t i = 0; i < type.items.size(); ++i) {
+            if (type.items[i].name.size() != length)
+                continue;
+            finds += "            if (name == QLatin1String(\"" + type.items[i].name
+                    + "\"))\n                return &info[" + toString(i) + "];\n";
+        }
+        finds += "            break;\n";
+    }
+    if (!finds.empty())
+        finds.erase(finds.size() - 1);
+    replace(hpp, "__ENUM_FUNC_FIND_CASES", finds);
+
+    bool unique = true;
+    for (size_t i = 0; i < type.items.size() && unique; ++i) {
+        for (size_t j = 0; j < i && unique; ++j)
+            unique = type.items[i].value != type.items[j].value;
+    }
     replace(hpp, "__ENUM_VALUES", value);
     replace(hpp, "__ENUM_COUNT", toString(type.items.size()));
     replace(hpp, "__ENUM_FUNC_DESC_CASES", cases);
-    if (type.continuous)
+    if (type.continuous) {
         replace(hpp, "__ENUM_FUNC_ITEM", R"(return 0 <= e && e < size() ? &info[(int)e] : nullptr;)");
-    else
+        replace(hpp, "__ENUM_FUNC_FROM_INT", R"(return 0 <= id && id < size() ? info[id].value : def;)");
+    } else if (unique) {
+        string item = "\n        switch (e) {\n";
+        for (size_t i = 0; i < type.items.size(); ++i)
+            item += "        case Enum::" + type.items[i].name + ": return &info[" + toString(i) + "];\n";
+        item += "        default: return nullptr;\n        }\n   ";
+        replace(hpp, "__ENUM_FUNC_ITEM", item);
+        replace(hpp, "__ENUM_FUNC_FROM_INT", R"(auto i = item((Enum)id); return i ? i->value : def;)");
+    } else {
         replace(hpp, "__ENUM_FUNC_ITEM", R"(
     auto it = std::find_if(info.cbegin(), info.cend(),
                             [e] (const Item &info)
                             { return info.value == e; });
     return it != info.cend() ? &(*it) : nullptr;
 )");
+        replace(hpp, "__ENUM_FUNC_FROM_INT", R"(auto i = item((Enum)id); return i ? i->value : def;)");
+    }
 
     replace(cpp, "__ENUM_NAME", type.name);
     replace(cpp, "__ENUM_COUNT", toString(type.items.size()));
@@ -73,27 +73,15 @@ __ENUM_FUNC_DESC_CASES
     static constexpr auto items() -> const ItemList&
     { return info; }
     static auto from(int id, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [id] (const Item &item)
-                               { return item.value == id; });
-        return it != info.cend() ? it->value : def;
-    }
+    { __ENUM_FUNC_FROM_INT }
     static auto from(const QString &name, Enum def = default_()) -> Enum
-    {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        return it != info.cend() ? it->value : def;
-    }
+    { auto i = find(name); return i ? i->value : def; }
     static auto fromName(Enum &val, const QString &name) -> bool
     {
-        auto it = std::find_if(info.cbegin(), info.cend(),
-                               [&name] (const Item &item)
-                               { return !name.compare(item.name); });
-        if (it == info.cend())
+        auto i = find(name);
+        if (!i)
             return false;
-        val = it->value;
+        val = i->value;
         return true;
     }
     static auto fromData(const __ENUM_DATA_TYPE &data,
@@ -107,6 +95,15 @@ __ENUM_FUNC_DESC_CASES
     static constexpr auto default_() -> Enum
     { return __ENUM_NAME::__ENUM_DEFAULT; }
 private:
+    static auto find(const QString &name) -> const Item*
+    {
+        switch (name.size()) {
+__ENUM_FUNC_FIND_CASES
+        default:
+            break;
+        }
+        return nullptr;
+    }
     static const ItemList info;
 };
 
@@ -5,6 +5,7 @@
 #include "player/mrlstate.hpp"
 #include "audio/channellayoutmap.hpp"
 #include "audio/audionormalizeroption.hpp"
+#include "audio/audiozone.hpp"
 #include "video/deintcaps.hpp"
 #include "video/deintoption.hpp"
 #include "video/motionintrploption.hpp"
@@ -75,8 +76,13 @@ private:
     P0(bool, remember_stopped, true)
     P0(bool, resume_ignore_in_playlist, false)
     P0(bool, precise_seeking, false)
+    P0(int, precise_seeking_tolerance, 250)
     P0(bool, remember_image, false)
+    P0(int, history_max_days, 0)
+    P0(int, history_max_count, 0)
+    P0(bool, low_memory, false)
     P0(bool, enable_generate_playlist, true)
+    P0(bool, playlist_gapless, true)
     P0(QStringList, restore_properties, defaultRestoreProperties())
     P0(GeneratePlaylist, generate_playlist, GeneratePlaylist::Folder)
     P0(bool, hide_cursor, true)
@@ -99,6 +105,8 @@ private:
     P0(ControlsTheme, controls_theme, {})
 
     P0(MotionIntrplOption, motion_interpolation, {})
+    P0(bool, dynamic_resolution, false)
+    P0(bool, display_sync, false)
 
     P0(ChannelLayoutMap, channel_manipulation, ChannelLayoutMap::default_())
 
@@ -112,6 +120,7 @@ private:
     P0(int, sub_enc_accuracy, defaultSubtitleEncodingDetectionAccuracy())
     P0(int, ms_per_char, 500)
     P0(OsdStyle, sub_style, {})
+    P0(bool, sub_gpu_effects, false)
     P0(bool, sub_prefer_external, true)
 
     P0(bool, enable_system_tray, true)
@@ -124,6 +133,8 @@ private:
 
     P0(bool, enable_hwaccel, false)
     P0(QList<CodecId>, hwaccel_codecs, OS::hwAcc()->fullCodecList())
+    P0(int, decoder_threads, 0)
+    P0(bool, decoder_low_latency, false)
     P0(DeintOptionSet, deinterlacing, {})
 
     P0(bool, audio_filter_resync, true)
@@ -135,6 +146,8 @@ private:
     P0(ShortcutMap, shortcut_map, {})
 
     P1(QString, audio_device, u"auto"_q, "currentText")
+    P0(bool, audio_low_latency, false)
+    P0(QList<AudioZoneOption>, audio_zones, {})
     P0(bool, soft_clip, true)
     P0(bool, auto_unmute, false)
 
@@ -150,7 +163,10 @@ private:
     P0(int, cache_min_playback_kb, 0)
     P0(int, cache_min_seeking_kb, 500)
     P0(double, cache_file_size_mb, 1024)
+    P0(bool, cache_network_adaptive, false)
+    P0(bool, cache_network_progressive, false)
     P0(QStringList, network_folders, {})
+    P0(QStringList, library_folders, {})
 
     P0(QString, yt_user_agent, u"Mozilla/5.0 (X11; Linux x86_64; rv:10.0) Gecko/20100101 Firefox/10.0 (Chrome)"_q)
     P0(QString, yt_program, u"youtube-dl"_q)
@@ -170,6 +186,9 @@ private:
     P1(Locale, app_locale, {}, "locale");
     P1(QString, app_style, {}, "value");
     P0(LogOption, app_log_option, LogOption::default_())
+    P0(bool, log_stats_summary, false)
+    P0(bool, app_realtime_threads, false)
+    P0(bool, app_efficiency_cores, false)
     P1(QFont, app_font, {}, "currentFont")
     P1(QFont, app_fixed_font, {}, "currentFont")
 
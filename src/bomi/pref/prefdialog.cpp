@@ -33,28 +33,55 @@ struct PrefDialog::Data {
     QHash<QObject*, QList<ValueWatcher*>> editorToWatcher;
     Pref orig;
     bool filling = false;
+    // editors of each page are filled from orig when it is shown first
+    // last one is for editors out of any page
+    QVector<QVector<ValueWatcher*>> pages;
+    QVector<bool> filled;
 
     auto retranslate() -> void
     {
         ui.sub_ext->setItemText(0, tr("All"));
     }
 
-    auto fillEditors(const Pref *pref) -> void
+    auto pageOf(QObject *editor) const -> int
     {
-        for (auto &w : watchers) {
-            if (w.editor.isValid())
-                w.editor.write(w.property.read(pref));
+        for (auto o = editor; o; o = o->parent()) {
+            if (o->parent() == ui.stack)
+                return ui.stack->indexOf(static_cast<QWidget*>(o));
         }
+        return ui.stack->count();
+    }
+
+    auto fillPage(int page, const Pref *pref) -> void
+    {
+        for (auto w : pages[page])
+            w->editor.write(w->property.read(pref));
+        filled[page] = true;
+    }
+
+    auto fillEditors(const Pref *pref) -> void
+    {
+        for (int i = 0; i < pages.size(); ++i)
+            fillPage(i, pref);
+    }
+
+    // fill current page and editors out of pages, the others are deferred
+    auto fillShown() -> void
+    {
+        filling = true;
+        fillPage(ui.stack->currentIndex(), &orig);
+        fillPage(ui.stack->count(), &orig);
+        filling = false;
     }
 
+    // editors of pages which have not been filled have nothing to apply
     auto sync() -> void
     {
-        for (auto &w : watchers) {
-            if (!w.editor.isValid())
+        for (int i = 0; i < pages.size(); ++i) {
+            if (!filled[i])
                 continue;
-            w.property.write(&orig, w.editor.read());
-            if (w.isModified())
-                qDebug() << w.property.typeName() << w.property.name();
+            for (auto w : pages[i])
+                w->property.write(&orig, w->editor.read());
         }
         modified.clear();
         p->setWindowModified(false);
@@ -82,6 +109,13 @@ PrefDialog::PrefDialog(QWidget *parent)
         d->ui.page_name->setText(text);
         d->ui.stack->setCurrentWidget(widget);
     });
+    connect(d->ui.stack, &QStackedWidget::currentChanged, this, [=] (int page) {
+        if (page < 0 || page >= d->filled.size() || d->filled[page])
+            return;
+        d->filling = true;
+        d->fillPage(page, &d->orig);
+        d->filling = false;
+    });
 
     QTreeWidgetItem *categoryItem = nullptr;
     auto addCategory = [&] (const QString &name) {
@@ -187,6 +221,7 @@ PrefDialog::PrefDialog(QWidget *parent)
     d->ui.yt_container->addItems( { u"mp4"_q, u"webm"_q } );
 
     d->ui.network_folders->setAddingAndErasingEnabled(true);
+    d->ui.library_folders->setAddingAndErasingEnabled(true);
 
     auto checkSubAutoselectMode = [this] (const QVariant &data) {
         const bool enabled = data.toInt() == AutoselectMode::Matched;
@@ -280,6 +315,8 @@ PrefDialog::PrefDialog(QWidget *parent)
 
     auto &mo = Pref::staticMetaObject;
     d->watchers.resize(mo.propertyCount() - mo.propertyOffset());
+    d->pages.resize(d->ui.stack->count() + 1);
+    d->filled.fill(false, d->pages.size());
 
     // 526
 //    remove(17); // skin
@@ -310,6 +347,8 @@ PrefDialog::PrefDialog(QWidget *parent)
         }
         d->editorToWatcher[editor].push_back(&w);
         w.editor = QQmlProperty(editor, editorProp);
+        if (w.editor.isValid())
+            d->pages[d->pageOf(editor)].push_back(&w);
         if (!w.editor.hasNotifySignal())
             qDebug() << "No notify signal in" << editor->metaObject()->className() << "for" << w.property.name();
         else
@@ -341,7 +380,11 @@ PrefDialog::PrefDialog(QWidget *parent)
         case BBox::Close:
             hide();
         case BBox::Reset:
-            d->fillEditors(&d->orig);
+            // others still show orig
+            for (int i = 0; i < d->pages.size(); ++i) {
+                if (d->filled[i])
+                    d->fillPage(i, &d->orig);
+            }
             break;
         case BBox::RestoreDefaults: {
             Pref pref;
@@ -387,10 +430,12 @@ auto PrefDialog::setAudioDeviceList(const QList<AudioDevice> &devices) -> void {
 
 auto PrefDialog::set(const Pref *p) -> void
 {
-    d->filling = true;
-    d->fillEditors(p);
-    d->sync();
-    d->filling = false;
+    for (auto &w : d->watchers)
+        w.property.write(&d->orig, w.property.read(p));
+    d->filled.fill(false);
+    d->fillShown();
+    d->modified.clear();
+    setWindowModified(false);
 }
 
 auto PrefDialog::get(Pref *p) -> void
@@ -2,10 +2,13 @@
 #include "formatobject.hpp"
 #include "tmp/algorithm.hpp"
 #include "windowobject.hpp"
+#include "infosubscriber.hpp"
 #include "player/mrl.hpp"
 #include "player/rootmenu.hpp"
 #include "player/mainwindow.hpp"
+#include "player/playengine.hpp"
 #include "os/os.hpp"
+#include "os/resourcemonitor.hpp"
 #include "player/app.hpp"
 #include <QQmlEngine>
 
@@ -13,22 +16,53 @@ extern "C" {
 int av_cpu_count(void);
 }
 
+// sampling every thread is not cheap even if somebody wants it faster
+static constexpr int MinMonitorInterval = 200;
+
+// resources are sampled only while info is subscribed
+static auto follow(QObject *o, QPointer<OS::ResourceMonitor> &monitor, bool &acquired) -> void
+{
+    auto update = [&monitor, &acquired] (int interval) {
+        if (!monitor)
+            return;
+        if (interval > 0)
+            monitor->setInterval(qMax(MinMonitorInterval, interval));
+        if (_Change(acquired, interval > 0)) {
+            if (acquired)
+                monitor->acquire();
+            else
+                monitor->release();
+        }
+    };
+    auto s = InfoSubscription::get();
+    QObject::connect(s, &InfoSubscription::changed, o, update);
+    update(s->interval());
+}
+
 MemoryObject::MemoryObject()
 {
     m_total = OS::totalMemory();
     m_usage = OS::usingMemory();
 
-    connect(&m_timer, &QTimer::timeout, this, [=] () {
-        if (_Change(m_usage, OS::usingMemory()))
+    m_monitor = OS::ResourceMonitor::get();
+    connect(m_monitor.data(), &OS::ResourceMonitor::sampled, this, [=] () {
+        const auto u = m_monitor->usage();
+        bool changed = _Change(m_usage, u.memory);
+        changed |= _Change(m_heap, u.heap);
+        changed |= _Change(m_heapRate, u.heapRate);
+        changed |= _Change(m_gpuFree, u.gpuFree);
+        changed |= _Change(m_gpuTotal, u.gpuTotal);
+        changed |= _Change(m_saved, u.saved);
+        if (changed)
             emit usageChanged();
     });
-    m_timer.setInterval(500);
-    m_timer.start();
+    follow(this, m_monitor, m_acquired);
 }
 
 MemoryObject::~MemoryObject()
 {
-    m_timer.stop();
+    if (m_monitor && m_acquired)
+        m_monitor->release();
 }
 
 /******************************************************************************/
@@ -36,29 +70,30 @@ MemoryObject::~MemoryObject()
 
 CpuObject::CpuObject()
 {
-    m_pt = OS::processTime();
-    m_st = OS::systemTime();
     m_cores = av_cpu_count();
 
-    connect(&m_timer, &QTimer::timeout, this, [=] () {
-        double usage = 0.0;
-        const auto pt = OS::processTime();
-        const auto st = OS::systemTime();
-        static constexpr quint64 th = 10000;
-        if (pt > m_pt + th && st > m_st + th) {
-            usage = (pt - m_pt)/(double)(st - m_st)*100.0;
-            _R(m_pt, m_st) = _T(pt, st);
+    m_monitor = OS::ResourceMonitor::get();
+    connect(m_monitor.data(), &OS::ResourceMonitor::sampled, this, [=] () {
+        const auto u = m_monitor->usage();
+        m_threads.clear();
+        m_threads.reserve(u.threads.size());
+        for (auto &t : u.threads) {
+            QVariantMap map;
+            map[u"name"_q] = t.name;
+            map[u"usage"_q] = t.cpu;
+            map[u"count"_q] = t.count;
+            m_threads.push_back(map);
         }
-        if (_Change(m_usage, usage))
-            emit usageChanged();
+        m_usage = u.cpu;
+        emit usageChanged();
     });
-    m_timer.setInterval(500);
-    m_timer.start();
+    follow(this, m_monitor, m_acquired);
 }
 
 CpuObject::~CpuObject()
 {
-    m_timer.stop();
+    if (m_monitor && m_acquired)
+        m_monitor->release();
 }
 
 /******************************************************************************/
@@ -75,7 +110,10 @@ auto AppObject::setWindow(MainWindow *window) -> void
 
 auto AppObject::open(const QString &location) -> void
 {
-    s.mw->openFromFileManager(Mrl(location));
+    if (s.mw)
+        s.mw->openFromFileManager(Mrl(location));
+    else if (s.engine) // headless
+        s.engine->load(Mrl(location));
 }
 
 auto AppObject::description(const QString &actionId) const -> QString
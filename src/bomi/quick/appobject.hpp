@@ -2,44 +2,63 @@
 #define APPOBJECT_HPP
 
 #include <QQuickItem>
+#include <QPointer>
 
 class PlayEngine;                       class HistoryModel;
 class PlaylistModel;                    class TopLevelItem;
+class MediaLibrary;
 class Downloader;                       class ThemeObject;
 class WindowObject;                     class MainWindow;
+namespace OS { class ResourceMonitor; }
 
 class MemoryObject : public QObject {
     Q_OBJECT
     Q_PROPERTY(qreal total READ total CONSTANT FINAL)
     Q_PROPERTY(qreal usage READ usage NOTIFY usageChanged)
+    Q_PROPERTY(qreal heap READ heap NOTIFY usageChanged)
+    Q_PROPERTY(qreal heapRate READ heapRate NOTIFY usageChanged)
+    Q_PROPERTY(qreal gpuFree READ gpuFree NOTIFY usageChanged)
+    Q_PROPERTY(qreal gpuTotal READ gpuTotal NOTIFY usageChanged)
+    Q_PROPERTY(qreal saved READ saved NOTIFY usageChanged)
 public:
     MemoryObject();
     ~MemoryObject();
     auto total() const -> qreal { return m_total; }
     auto usage() const -> qreal { return m_usage; }
+    auto heap() const -> qreal { return m_heap; }
+    auto heapRate() const -> qreal { return m_heapRate; }
+    auto gpuFree() const -> qreal { return m_gpuFree; }
+    auto gpuTotal() const -> qreal { return m_gpuTotal; }
+    auto saved() const -> qreal { return m_saved; }
 signals:
     void usageChanged();
 private:
-    qreal m_total = 1, m_usage = 0;
-    QTimer m_timer;
+    qreal m_total = 1, m_usage = 0, m_heap = -1, m_heapRate = 0;
+    qreal m_gpuFree = -1, m_gpuTotal = -1, m_saved = 0;
+    QPointer<OS::ResourceMonitor> m_monitor;
+    bool m_acquired = false;
 };
 
 class CpuObject : public QObject {
     Q_OBJECT
     Q_PROPERTY(qreal usage READ usage NOTIFY usageChanged)
     Q_PROPERTY(int cores READ cores CONSTANT FINAL)
+    Q_PROPERTY(QVariantList threads READ threads NOTIFY usageChanged)
 public:
     CpuObject();
     ~CpuObject();
     auto usage() const -> qreal { return m_usage; }
     auto cores() const -> int { return m_cores; }
+    // list of {name, usage, count} maps, busiest first
+    auto threads() const -> QVariantList { return m_threads; }
 signals:
     void usageChanged();
 private:
     qreal m_usage = 0;
-    quint64 m_pt = 0, m_st = 0;
     int m_cores = 1;
-    QTimer m_timer;
+    QVariantList m_threads;
+    QPointer<OS::ResourceMonitor> m_monitor;
+    bool m_acquired = false;
 };
 
 class AppObject : public QObject {
@@ -48,6 +67,7 @@ class AppObject : public QObject {
     Q_FLAGS(Events)
     Q_PROPERTY(PlayEngine *engine READ engine CONSTANT FINAL)
     Q_PROPERTY(HistoryModel *history READ history CONSTANT FINAL)
+    Q_PROPERTY(MediaLibrary *library READ library CONSTANT FINAL)
     Q_PROPERTY(PlaylistModel *playlist READ playlist CONSTANT FINAL)
     Q_PROPERTY(TopLevelItem *topLevelItem READ topLevelItem CONSTANT FINAL)
     Q_PROPERTY(Downloader *download READ downloader CONSTANT FINAL)
@@ -66,6 +86,7 @@ public:
     Q_DECLARE_FLAGS(Events, Event)
     auto engine() const -> PlayEngine* { return s.engine; }
     auto history() const -> HistoryModel* { return s.history; }
+    auto library() const -> MediaLibrary* { return s.library; }
     auto playlist() const -> PlaylistModel* { return s.playlist; }
     auto topLevelItem() const -> TopLevelItem* { return s.top; }
     auto downloader() const -> Downloader* { return s.down; }
@@ -86,6 +107,7 @@ public:
     static auto setTheme(ThemeObject *theme) -> void { s.theme = theme; }
     static auto setEngine(PlayEngine *engine) -> void { s.engine = engine; }
     static auto setHistory(HistoryModel *history) -> void { s.history = history; }
+    static auto setLibrary(MediaLibrary *library) -> void { s.library = library; }
     static auto setPlaylist(PlaylistModel *pl) -> void { s.playlist = pl; }
     static auto setTopLevelItem(TopLevelItem *top) -> void { s.top = top; }
     static auto setDownloader(Downloader *down) -> void { s.down = down; }
@@ -101,6 +123,7 @@ private:
     struct StaticData {
         PlayEngine *engine = nullptr;
         HistoryModel *history = nullptr;
+        MediaLibrary *library = nullptr;
         PlaylistModel *playlist = nullptr;
         TopLevelItem *top = nullptr;
         Downloader *down = nullptr;
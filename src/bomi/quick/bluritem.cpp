@@ -0,0 +1,256 @@
+#include "bluritem.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglshadercache.hpp"
+#include "misc/log.hpp"
+#include <QQuickWindow>
+#include <QSGTextureProvider>
+#include <QSGDynamicTexture>
+#include <QOpenGLShaderProgram>
+#include <QPointer>
+
+DECLARE_LOG_CONTEXT(Quick)
+
+static constexpr int MaxPasses = 6;
+
+struct BlurShader {
+    QOpenGLShaderProgram *program = nullptr;
+    int loc_rect = -1, loc_texel = -1;
+    auto link(const QByteArray &fragment) -> bool
+    {
+        OpenGLShaderCache::Source source;
+        source.vertex = R"(
+            attribute vec2 aPosition;
+            varying vec2 coord;
+            void main() {
+                coord = aPosition * 0.5 + 0.5;
+                gl_Position = vec4(aPosition, 0.0, 1.0);
+            }
+        )";
+        source.fragment = R"(
+            uniform sampler2D tex;
+            uniform vec4 rect;
+            uniform vec2 texel;
+            varying vec2 coord;
+            vec4 tap(float x, float y) {
+                return texture2D(tex, rect.xy + coord * rect.zw + vec2(x, y) * texel);
+            }
+        )" + fragment;
+        source.attributes << "aPosition";
+        program = new QOpenGLShaderProgram;
+        if (!OpenGLShaderCache::link(program, source)) {
+            _Delete(program);
+            return false;
+        }
+        program->bind();
+        program->setUniformValue(program->uniformLocation("tex"), 0);
+        loc_rect = program->uniformLocation("rect");
+        loc_texel = program->uniformLocation("texel");
+        program->release();
+        return true;
+    }
+    // rect is normalized area of source to be drawn
+    auto draw(const OpenGLFramebufferObject *target, const QRectF &rect,
+              const QSizeF &texel) -> void
+    {
+        static const GLfloat quad[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+        auto f = QOpenGLContext::currentContext()->functions();
+        target->bind();
+        f->glViewport(0, 0, target->width(), target->height());
+        program->bind();
+        program->setUniformValue(loc_rect, rect.x(), rect.y(), rect.width(), rect.height());
+        program->setUniformValue(loc_texel, texel);
+        program->setAttributeArray(0, quad, 2);
+        program->enableAttributeArray(0);
+        f->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        program->disableAttributeArray(0);
+        program->release();
+        target->release();
+    }
+};
+
+struct BlurItem::Data {
+    BlurItem *p = nullptr;
+    QPointer<QQuickItem> source;
+    int passes = 2;
+    qreal offset = 1.0;
+    // gui thread marks, render thread clears while gui thread waits
+    bool dirty = true;
+    // render thread
+    QPointer<QSGTextureProvider> provider;
+    BlurShader down, up;
+    QVector<OpenGLFramebufferObject*> levels;
+    QSize size{0, 0};
+    bool broken = false;
+
+    auto invalidate() -> void { dirty = true; p->forceRepaint(); }
+    auto clear() -> void { qDeleteAll(levels); levels.clear(); }
+    // level i is 1/2^(i+1) of output
+    auto prepare(const QSize &output) -> void
+    {
+        if (levels.size() == passes && size == output)
+            return;
+        clear();
+        size = output;
+        QSize s = output;
+        for (int i = 0; i < passes; ++i) {
+            s = QSize(std::max(1, (s.width() + 1) / 2), std::max(1, (s.height() + 1) / 2));
+            auto fbo = new OpenGLFramebufferObject(s);
+            // border would darken edges through every pass
+            auto texture = fbo->texture();
+            OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+            texture.setWrapMode(OGL::ClampToEdge);
+            levels.push_back(fbo);
+        }
+    }
+};
+
+BlurItem::BlurItem(QQuickItem *parent)
+    : Super(parent), d(new Data)
+{
+    d->p = this;
+    setFlag(ItemHasContents, true);
+}
+
+BlurItem::~BlurItem()
+{
+    delete d;
+}
+
+auto BlurItem::source() const -> QQuickItem*
+{
+    return d->source;
+}
+
+auto BlurItem::setSource(QQuickItem *source) -> void
+{
+    if (d->source == source)
+        return;
+    if (source && !source->isTextureProvider()) {
+        _Error("Blur source is not a texture provider.");
+        source = nullptr;
+    }
+    d->source = source;
+    d->invalidate();
+    emit sourceChanged();
+}
+
+auto BlurItem::passes() const -> int
+{
+    return d->passes;
+}
+
+auto BlurItem::setPasses(int passes) -> void
+{
+    if (_Change(d->passes, qBound(1, passes, MaxPasses))) {
+        d->invalidate();
+        emit passesChanged();
+    }
+}
+
+auto BlurItem::offset() const -> qreal
+{
+    return d->offset;
+}
+
+auto BlurItem::setOffset(qreal offset) -> void
+{
+    if (_Change(d->offset, offset)) {
+        d->invalidate();
+        emit offsetChanged();
+    }
+}
+
+auto BlurItem::imageSize() const -> QSize
+{
+    const auto size = targetSize();
+    if (size.isEmpty())
+        return size;
+    return { std::max(1, size.width() / 2), std::max(1, size.height() / 2) };
+}
+
+auto BlurItem::initializeGL() -> void
+{
+    Super::initializeGL();
+    // 4 corners around center at half pixel
+    const bool down = d->down.link(R"(
+        void main() {
+            vec4 c = tap(0.0, 0.0) * 4.0;
+            c += tap(-1.0, -1.0) + tap(1.0, 1.0) + tap(1.0, -1.0) + tap(-1.0, 1.0);
+            gl_FragColor = c * (1.0 / 8.0);
+        }
+    )");
+    // 8 taps on diamond, diagonals weighted twice
+    const bool up = d->up.link(R"(
+        void main() {
+            vec4 c = tap(-2.0, 0.0) + tap(2.0, 0.0) + tap(0.0, -2.0) + tap(0.0, 2.0);
+            c += (tap(-1.0, 1.0) + tap(1.0, 1.0) + tap(1.0, -1.0) + tap(-1.0, -1.0)) * 2.0;
+            gl_FragColor = c * (1.0 / 12.0);
+        }
+    )");
+    d->broken = !down || !up;
+    if (d->broken)
+        _Error("Cannot initialize blur shaders.");
+    d->dirty = true;
+}
+
+auto BlurItem::finalizeGL() -> void
+{
+    Super::finalizeGL();
+    d->clear();
+    d->size = QSize(0, 0);
+    _Delete(d->down.program);
+    _Delete(d->up.program);
+    d->provider = nullptr;
+}
+
+auto BlurItem::paint(OpenGLFramebufferObject *fbo) -> void
+{
+    if (d->broken || !d->source)
+        return;
+    auto provider = d->source->textureProvider();
+    if (d->provider != provider) {
+        if (d->provider)
+            disconnect(d->provider, nullptr, this, nullptr);
+        d->provider = provider;
+        if (provider)
+            connect(provider, &QSGTextureProvider::textureChanged,
+                    this, [=] () { d->invalidate(); }, Qt::QueuedConnection);
+        d->dirty = true;
+    }
+    auto texture = provider ? provider->texture() : nullptr;
+    if (!texture || texture->textureSize().isEmpty())
+        return;
+    bool updated = false;
+    if (auto dynamic = qobject_cast<QSGDynamicTexture*>(texture))
+        updated = dynamic->updateTexture();
+    // keep last result unless source or output has changed
+    if (!updated && !d->dirty && d->size == fbo->size() && d->levels.size() == d->passes)
+        return;
+    d->dirty = false;
+    d->prepare(fbo->size());
+
+    auto f = QOpenGLContext::currentContext()->functions();
+    f->glDisable(GL_BLEND);
+    f->glDisable(GL_DEPTH_TEST);
+    f->glDisable(GL_SCISSOR_TEST);
+    f->glActiveTexture(GL_TEXTURE0);
+    auto texel = [&] (const QSize &size) {
+        return QSizeF(d->offset / size.width(), d->offset / size.height());
+    };
+    const QRectF full(0, 0, 1, 1);
+    texture->setFiltering(QSGTexture::Linear);
+    texture->bind();
+    d->down.draw(d->levels[0], texture->normalizedTextureSubRect(),
+                 texel(texture->textureSize()));
+    for (int i = 1; i < d->levels.size(); ++i) {
+        d->levels[i - 1]->texture().bind();
+        d->down.draw(d->levels[i], full, texel(d->levels[i - 1]->size()));
+    }
+    for (int i = d->levels.size() - 1; i >= 0; --i) {
+        d->levels[i]->texture().bind();
+        d->up.draw(i > 0 ? d->levels[i - 1] : fbo, full, texel(d->levels[i]->size()));
+    }
+    if (auto w = window())
+        w->resetOpenGLState();
+}
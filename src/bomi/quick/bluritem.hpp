@@ -0,0 +1,39 @@
+#ifndef BLURITEM_HPP
+#define BLURITEM_HPP
+
+#include "simplefboitem.hpp"
+
+// dual filter blur of texture provider like ShaderEffectSource
+// runs at half size of item and below, and blurs again only when
+// source has been updated, so paused video under panel costs nothing
+class BlurItem : public SimpleFboItem {
+    Q_OBJECT
+    using Super = SimpleFboItem;
+    Q_PROPERTY(QQuickItem *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(int passes READ passes WRITE setPasses NOTIFY passesChanged)
+    Q_PROPERTY(qreal offset READ offset WRITE setOffset NOTIFY offsetChanged)
+public:
+    BlurItem(QQuickItem *parent = nullptr);
+    ~BlurItem();
+    auto source() const -> QQuickItem*;
+    auto setSource(QQuickItem *source) -> void;
+    // each pass halves resolution once more, which doubles radius
+    auto passes() const -> int;
+    auto setPasses(int passes) -> void;
+    // distance of taps in texels of each level
+    auto offset() const -> qreal;
+    auto setOffset(qreal offset) -> void;
+    auto imageSize() const -> QSize final;
+signals:
+    void sourceChanged();
+    void passesChanged();
+    void offsetChanged();
+private:
+    auto paint(OpenGLFramebufferObject *fbo) -> void final;
+    auto initializeGL() -> void final;
+    auto finalizeGL() -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // BLURITEM_HPP
@@ -25,7 +25,6 @@ signals:
     void sourceChanged(const QUrl &url);
     void angleChanged();
 private:
-    auto type() const -> Type* override { static Type type; return &type; }
     auto geometryChanged(const QRectF &n, const QRectF &o) -> void override;
     auto initializeGL() -> void override;
     auto finalizeGL() -> void override;
@@ -0,0 +1,52 @@
+#include "infosubscriber.hpp"
+
+auto InfoSubscription::get() -> InfoSubscription*
+{
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    static InfoSubscription subscription;
+    return &subscription;
+}
+
+auto InfoSubscription::update() -> void
+{
+    int interval = 0;
+    for (auto s : m_subscribers) {
+        if (s->isActive())
+            interval = interval ? qMin(interval, s->interval()) : s->interval();
+    }
+    if (_Change(m_interval, interval))
+        emit changed(m_interval);
+}
+
+/******************************************************************************/
+
+InfoSubscriber::InfoSubscriber(QObject *parent)
+    : QObject(parent)
+{
+    auto s = InfoSubscription::get();
+    s->m_subscribers.push_back(this);
+    s->update();
+}
+
+InfoSubscriber::~InfoSubscriber()
+{
+    auto s = InfoSubscription::get();
+    s->m_subscribers.removeOne(this);
+    s->update();
+}
+
+auto InfoSubscriber::setActive(bool active) -> void
+{
+    if (_Change(m_active, active)) {
+        InfoSubscription::get()->update();
+        emit activeChanged();
+    }
+}
+
+auto InfoSubscriber::setInterval(int ms) -> void
+{
+    if (_Change(m_interval, qMax(MinInterval, ms))) {
+        InfoSubscription::get()->update();
+        emit intervalChanged();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef INFOSUBSCRIBER_HPP
+#define INFOSUBSCRIBER_HPP
+
+class InfoSubscriber;
+
+// info for display is costly to keep up to date during playback
+// so publishers compute and emit it only while any subscriber is active,
+// at the shortest interval among active subscribers
+class InfoSubscription : public QObject {
+    Q_OBJECT
+public:
+    // should be called in main thread
+    static auto get() -> InfoSubscription*;
+    auto isActive() const -> bool { return m_interval > 0; }
+    // in ms, 0 if nobody subscribes
+    auto interval() const -> int { return m_interval; }
+signals:
+    void changed(int interval);
+private:
+    InfoSubscription() = default;
+    auto update() -> void;
+    friend class InfoSubscriber;
+    QVector<InfoSubscriber*> m_subscribers;
+    int m_interval = 0;
+};
+
+// consumer of info in qml, e.g. active while its view is visible
+class InfoSubscriber : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+public:
+    static constexpr int MinInterval = 50;
+    InfoSubscriber(QObject *parent = nullptr);
+    ~InfoSubscriber();
+    auto isActive() const -> bool { return m_active; }
+    auto setActive(bool active) -> void;
+    auto interval() const -> int { return m_interval; }
+    auto setInterval(int ms) -> void;
+signals:
+    void activeChanged();
+    void intervalChanged();
+private:
+    bool m_active = true;
+    int m_interval = 500;
+};
+
+#endif // INFOSUBSCRIBER_HPP
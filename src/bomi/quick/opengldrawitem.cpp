@@ -1,5 +1,9 @@
 #include "opengldrawitem.hpp"
+#include "misc/tracer.hpp"
 #include <QQuickWindow>
+#include <atomic>
+
+static std::atomic<int> s_drawCalls{0};
 
 OpenGLDrawItem::OpenGLDrawItem(QQuickItem *parent)
     : GeometryItem(parent)
@@ -7,13 +11,15 @@ OpenGLDrawItem::OpenGLDrawItem(QQuickItem *parent)
     setFlag(ItemHasContents, true);
     connect(this, &QQuickItem::windowChanged, [this] (QQuickWindow *window) {
         m_win = window;
+        // engine owned items come back to same window when skin is switched
+        const auto type = static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection);
         if (window) {
             connect(window, &QQuickWindow::sceneGraphInitialized,
-                    this, &OpenGLDrawItem::tryInitGL, Qt::DirectConnection);
+                    this, &OpenGLDrawItem::tryInitGL, type);
             connect(window, &QQuickWindow::beforeRendering,
-                    this, &OpenGLDrawItem::tryInitGL, Qt::DirectConnection);
+                    this, &OpenGLDrawItem::tryInitGL, type);
             connect(window, &QQuickWindow::sceneGraphInvalidated,
-                    this, &OpenGLDrawItem::finalizeGL, Qt::DirectConnection);
+                    this, &OpenGLDrawItem::finalizeGL, type);
         }
     });
 }
@@ -22,6 +28,16 @@ OpenGLDrawItem::~OpenGLDrawItem() {
 
 }
 
+auto OpenGLDrawItem::countDrawCall() -> void
+{
+    ++s_drawCalls;
+}
+
+auto OpenGLDrawItem::finishFrame() -> int
+{
+    return s_drawCalls.exchange(0);
+}
+
 auto OpenGLDrawItem::devicePixelRatio() const -> double
 {
     return m_win ? m_win->devicePixelRatio() : 1.0;
@@ -35,6 +51,7 @@ auto OpenGLDrawItem::createNode() const -> QSGGeometryNode*
 auto OpenGLDrawItem::updatePaintNode(QSGNode *old,
                                      UpdatePaintNodeData *) -> QSGNode*
 {
+    TRACE_SCOPE(metaObject()->className());
     tryInitGL();
     m_node = static_cast<QSGGeometryNode*>(old);
     if (!m_node) {
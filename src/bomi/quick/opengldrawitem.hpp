@@ -2,6 +2,7 @@
 #define OPENGLDRAWITEM_HPP
 
 #include "geometryitem.hpp"
+#include "opengl/openglshadercache.hpp"
 #include <QOpenGLFunctions>
 #include <QSGGeometry>
 #include <QSGMaterial>
@@ -22,6 +23,10 @@ public:
     virtual auto rerender() -> void { reserve(UpdateAll); }
     static auto func() -> QOpenGLFunctions* { return context()->functions(); }
     static auto context() -> QOpenGLContext*;
+    // material passes of custom items in render thread, for debugging batching
+    static auto countDrawCall() -> void;
+    // return passes of last frame and start counting next one
+    static auto finishFrame() -> int;
 protected:
     auto isInitialized() const -> bool { return m_init; }
     auto reserve(UpdateHint hint, bool update = true) -> void;
@@ -128,8 +133,12 @@ protected:
 public:
     using Type = QSGMaterialType;
     using VertexDrawItem<T>::VertexDrawItem;
+    // materials whose data compare equal share one draw call in batch renderer
+    // so everything set by ShaderIface::update() must be compared here
     struct ShaderData {
         virtual ~ShaderData() = default;
+        virtual auto compare(const ShaderData *other) const -> int
+            { return this == other ? 0 : (this < other ? -1 : 1); }
     };
     struct ShaderIface {
         static QOpenGLFunctions *func() { return VertexDrawItem<T>::func(); }
@@ -159,6 +168,8 @@ private:
         Material(const ShaderRenderItem *item);
         auto type() const -> QSGMaterialType* final { return m_item->type(); }
         auto createShader() const -> QSGMaterialShader* final;
+        auto compare(const QSGMaterial *other) const -> int final
+            { return m_data->compare(static_cast<const Material*>(other)->m_data); }
         auto data() -> ShaderData* { return m_data; }
         auto data() const -> const ShaderData* { return m_data; }
     private:
@@ -178,6 +189,8 @@ private:
         auto updateState(const RenderState &state,
                          QSGMaterial *new_, QSGMaterial *) -> void final;
         auto deactivate() -> void final { m_iface->afterUpdate(); }
+    protected:
+        auto compile() -> void final;
     private:
         int loc_matrix = -1, loc_opacity = -1;
     };
@@ -219,6 +232,16 @@ template<class T>
 auto ShaderRenderItem<T>::Shader::attributeNames() const -> const char *const*
 { return m_attributes.data(); }
 
+// same as default one except that linked program is cached on disk
+template<class T>
+auto ShaderRenderItem<T>::Shader::compile() -> void
+{
+    const OpenGLShaderCache::Source source = {
+        m_iface->vertexShader, m_iface->fragmentShader, m_iface->attributes
+    };
+    OpenGLShaderCache::link(program(), source);
+}
+
 template<class T>
 auto ShaderRenderItem<T>::Shader::initialize() -> void
 {
@@ -233,6 +256,7 @@ auto ShaderRenderItem<T>::Shader::updateState(const RenderState &state,
                                               QSGMaterial *new_,
                                               QSGMaterial *) -> void
 {
+    OpenGLDrawItem::countDrawCall();
     auto prog = program();
     if (state.isMatrixDirty())
         prog->setUniformValue(loc_matrix, state.combinedMatrix());
@@ -73,7 +73,7 @@ private:
     THEME_PV(bool, bold, m.font.bold())
     THEME_PV(bool, strikeout, m.font.strikeOut())
     THEME_PV(bool, italic, m.font.italic())
-    THEME_PV(Style, style, Outline)
+    THEME_PC(Style, style, Outline)
     THEME_PV(QColor, color, m.font.color)
     THEME_PV(QColor, styleColor, m.outline.color)
 public:
@@ -88,9 +88,9 @@ public:
         TimelineThemeObject timeline;
         MessageThemeObject message;
     } mutable m;
-    THEME_PV(OsdStyleObject*, style, &m.style)
-    THEME_PV(TimelineThemeObject*, timeline, &m.timeline)
-    THEME_PV(MessageThemeObject*, message, &m.message)
+    THEME_PC(OsdStyleObject*, style, &m.style)
+    THEME_PC(TimelineThemeObject*, timeline, &m.timeline)
+    THEME_PC(MessageThemeObject*, message, &m.message)
 };
 
 class OsdThemeWidget : public QWidget {
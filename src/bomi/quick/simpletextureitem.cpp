@@ -3,6 +3,13 @@
 
 struct SimpleTextureData : public SimpleTextureItem::ShaderData {
     const OpenGLTexture2D *texture = nullptr;
+    // items drawing same texture can be merged into one batch
+    auto compare(const ShaderData *other) const -> int final
+    {
+        const auto rhs = static_cast<const SimpleTextureData*>(other)->texture;
+        const auto id1 = texture->id(), id2 = rhs->id();
+        return id1 == id2 ? 0 : (id1 < id2 ? -1 : 1);
+    }
 };
 
 struct SimpleTextureShader : public SimpleTextureItem::ShaderIface {
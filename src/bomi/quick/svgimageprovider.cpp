@@ -0,0 +1,107 @@
+#include "svgimageprovider.hpp"
+#include "misc/log.hpp"
+#include <QSvgRenderer>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QPainter>
+#include <QCache>
+#include <QMutex>
+
+DECLARE_LOG_CONTEXT(Quick)
+
+// rasterized files kept on disk, oldest ones go first
+static constexpr int DiskMax = 64;
+
+struct SvgImageProvider::Data {
+    QMutex mutex;
+    // cost in KiB
+    QCache<QString, QImage> images{16 * 1024};
+    QString folder;
+    auto prune() -> void
+    {
+        QDir dir(folder);
+        const auto files = dir.entryInfoList({ u"*.png"_q }, QDir::Files, QDir::Time);
+        for (int i = DiskMax; i < files.size(); ++i)
+            dir.remove(files[i].fileName());
+    }
+};
+
+SvgImageProvider::SvgImageProvider()
+    : QQuickImageProvider(Image), d(new Data)
+{
+    d->folder = _WritablePath(Location::Cache) % "/svg"_a;
+    QDir().mkpath(d->folder);
+}
+
+SvgImageProvider::~SvgImageProvider()
+{
+    delete d;
+}
+
+auto SvgImageProvider::requestImage(const QString &id, QSize *size,
+                                    const QSize &requested) -> QImage
+{
+    // called in loader thread of qml engine for asynchronous images
+    QFile file(id.startsWith(':'_q) || QFileInfo(id).isAbsolute() ? id : ':'_q % '/'_q % id);
+    if (!file.open(QFile::ReadOnly)) {
+        _Error("Cannot open %%.", id);
+        return QImage();
+    }
+    const auto svg = file.readAll();
+    const auto dpr = qApp->devicePixelRatio();
+    // parsing is skipped for cached ones whose size is given fully
+    QScopedPointer<QSvgRenderer> renderer;
+    auto parse = [&] () {
+        if (!renderer)
+            renderer.reset(new QSvgRenderer(svg));
+        if (!renderer->isValid())
+            _Error("Cannot parse %%.", id);
+        return renderer->isValid();
+    };
+    QSize target = requested;
+    if (target.width() <= 0 || target.height() <= 0) {
+        if (!parse())
+            return QImage();
+        target = renderer->defaultSize();
+        if (requested.width() > 0 || requested.height() > 0)
+            target.scale(requested.width() > 0 ? requested.width() : INT_MAX,
+                         requested.height() > 0 ? requested.height() : INT_MAX,
+                         Qt::KeepAspectRatio);
+    }
+    auto step = [] (int v) { return qMax(Step, (v + Step - 1) / Step * Step); };
+    const QSize pixels(step(qCeil(target.width() * dpr)), step(qCeil(target.height() * dpr)));
+    if (size)
+        *size = target;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(svg);
+    hash.addData(QByteArray::number(pixels.width()) + 'x' + QByteArray::number(pixels.height()));
+    const auto key = _L(hash.result().toHex());
+    const auto path = d->folder % '/'_q % key % ".png"_a;
+
+    QMutexLocker locker(&d->mutex);
+    if (auto cached = d->images.object(key))
+        return *cached;
+    locker.unlock();
+
+    QImage image;
+    if (!image.load(path, "PNG") || image.size() != pixels) {
+        if (!parse())
+            return QImage();
+        image = QImage(pixels, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        renderer->render(&painter);
+        painter.end();
+        QSaveFile out(path);
+        if (out.open(QFile::WriteOnly) && image.save(&out, "PNG") && out.commit())
+            d->prune();
+        else
+            _Warn("Cannot write rasterized %% to %%.", id, path);
+    }
+    image.setDevicePixelRatio(dpr);
+
+    locker.relock();
+    d->images.insert(key, new QImage(image), image.byteCount() / 1024);
+    return image;
+}
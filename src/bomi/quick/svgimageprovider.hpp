@@ -0,0 +1,22 @@
+#ifndef SVGIMAGEPROVIDER_HPP
+#define SVGIMAGEPROVIDER_HPP
+
+#include <QQuickImageProvider>
+
+// image://svg/<path> rasterizes svg once per size and device pixel ratio
+// and keeps it in memory and on disk for next start
+// sizes are rounded up to steps, so resizing crosses few of them and image
+// with asynchronous: true keeps showing old one while next steps rasterizes
+class SvgImageProvider : public QQuickImageProvider {
+public:
+    static constexpr int Step = 64;
+    SvgImageProvider();
+    ~SvgImageProvider();
+    auto requestImage(const QString &id, QSize *size,
+                      const QSize &requested) -> QImage override;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // SVGIMAGEPROVIDER_HPP
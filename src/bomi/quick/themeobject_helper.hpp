@@ -1,6 +1,8 @@
 #ifndef THEMEOBJECT_HELPER_HPP
 #define THEMEOBJECT_HELPER_HPP
 
+#include <QMetaProperty>
+
 #define THEME_C(type, name) \
 private: \
     type m_##name; \
@@ -11,17 +13,47 @@ private:
 
 #define THEME_P(type, name) \
 private: \
-    Q_PROPERTY(type name READ name CONSTANT FINAL) \
+    Q_PROPERTY(type name READ name NOTIFY name##Changed FINAL) \
 public: \
     auto name() const -> type { return m.name; } \
+    Q_SIGNAL void name##Changed(); \
 private:
 
 #define THEME_PV(type, name, var) \
+private: \
+    Q_PROPERTY(type name READ name NOTIFY name##Changed FINAL) \
+public: \
+    auto name() const -> type { return var; } \
+    Q_SIGNAL void name##Changed(); \
+private:
+
+// value of sub-object which never changes
+#define THEME_PC(type, name, var) \
 private: \
     Q_PROPERTY(type name READ name CONSTANT FINAL) \
 public: \
     auto name() const -> type { return var; } \
 private:
 
+// replaces object->m with theme and notifies only properties which have changed
+// so that bindings on untouched properties, like fonts, are not evaluated again
+template<class O, class T>
+SIA _SetTheme(O *object, const T &theme) -> void
+{
+    if (object->m == theme)
+        return;
+    const auto mo = object->metaObject();
+    const int offset = mo->propertyOffset(), count = mo->propertyCount();
+    QVarLengthArray<QVariant, 16> old(count - offset);
+    for (int i = offset; i < count; ++i)
+        old[i - offset] = mo->property(i).read(object);
+    object->m = theme;
+    for (int i = offset; i < count; ++i) {
+        const auto property = mo->property(i);
+        if (property.hasNotifySignal() && property.read(object) != old[i - offset])
+            property.notifySignal().invoke(object, Qt::DirectConnection);
+    }
+}
+
 #endif // THEMEOBJECT_HELPER_HPP
 
@@ -1,8 +1,10 @@
 #include "toplevelitem.hpp"
 #include <QQuickWindow>
+#include <atomic>
 
 struct TopLevelItem::Data {
     bool pressed = false;
+    std::atomic<int> drawCalls{0};
 };
 
 TopLevelItem::TopLevelItem(QQuickItem *parent)
@@ -21,6 +23,10 @@ TopLevelItem::TopLevelItem(QQuickItem *parent)
                     this, &QQuickItem::setHeight);
             setWidth(w->width());
             setHeight(w->height());
+            connect(w, &QQuickWindow::afterRendering, this, [this] () {
+                if (d->drawCalls.exchange(finishFrame()) != d->drawCalls)
+                    emit drawCallsChanged(d->drawCalls);
+            }, Qt::DirectConnection);
         }
     });
 }
@@ -34,6 +40,11 @@ auto TopLevelItem::updateVertex(Vertex *vertex) -> void
     Vertex::fillAsTriangleStrip(vertex, {0, 0}, {width(), height()});
 }
 
+auto TopLevelItem::drawCalls() const -> int
+{
+    return d->drawCalls;
+}
+
 auto TopLevelItem::filteredMousePressEvent() const -> bool
 {
     return d->pressed;
@@ -5,6 +5,8 @@
 
 class TopLevelItem : public SimpleVertexItem {
     Q_OBJECT
+    // material passes of custom items in last frame
+    Q_PROPERTY(int drawCalls READ drawCalls NOTIFY drawCallsChanged)
 public:
     TopLevelItem(QQuickItem *parent = nullptr);
     ~TopLevelItem();
@@ -13,6 +15,9 @@ public:
     auto updateVertexOnGeometryChanged() const -> bool override { return true; }
     auto vertexCount() const -> int override { return 4; }
     Q_INVOKABLE void check();
+    auto drawCalls() const -> int;
+signals:
+    void drawCallsChanged(int drawCalls);
 private:
     auto updateVertex(Vertex *vertex) -> void override;
     auto drawingMode() const -> GLenum final { return GL_TRIANGLE_STRIP; }
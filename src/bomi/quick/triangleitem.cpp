@@ -1,20 +1,15 @@
 #include "triangleitem.hpp"
 
-struct TriangleItem::SData : ShaderData {
-    QMatrix4x4 scaler;
-};
-
 struct TriangleItem::SIface : ShaderIface {
     SIface() {
         vertexShader = R"(
             uniform mat4 qt_Matrix;
-            uniform mat4 scaler;
             attribute vec4 aPosition;
             attribute vec4 aColor;
             varying vec4 color;
             void main() {
                 color = aColor;
-                gl_Position = scaler * qt_Matrix * aPosition;
+                gl_Position = qt_Matrix * aPosition;
             }
         )";
         fragmentShader = R"(
@@ -27,20 +22,12 @@ struct TriangleItem::SIface : ShaderIface {
         attributes << "aPosition" << "aColor";
     }
 private:
-    auto resolve(QOpenGLShaderProgram *prog) -> void final
-    {
-        loc_scaler = prog->uniformLocation("scaler");
-    }
-    auto update(QOpenGLShaderProgram *prog, ShaderData *data) -> void final
-    {
-        auto d = static_cast<const SData*>(data);
-        prog->setUniformValue(loc_scaler, d->scaler);
-    }
-    int loc_scaler = -1;
+    // no uniforms so that all triangles are merged into one batch
+    auto resolve(QOpenGLShaderProgram *) -> void final { }
+    auto update(QOpenGLShaderProgram *, ShaderData *) -> void final { }
 };
 
 struct TriangleItem::Data {
-    QMatrix4x4 scaler;
     QPointF centroid;
 };
 
@@ -129,7 +116,7 @@ auto TriangleItem::setColor(const QColor &color) -> void
         vertices()[1].color.set(color);
         vertices()[2].color.set(color);
         emit colorChanged(color);
-        reserve(UpdateMaterial);
+        reserve(UpdateGeometry);
     }
 }
 
@@ -138,14 +125,28 @@ auto TriangleItem::createShader() const -> ShaderIface*
     return new SIface;
 }
 
+// every triangle has same data
+struct TriangleData : TriangleItem::ShaderData {
+    auto compare(const ShaderData *) const -> int final { return 0; }
+};
+
 auto TriangleItem::createData() const -> ShaderData*
 {
-    return new SData;
+    return new TriangleData;
 }
 
-auto TriangleItem::updateData(ShaderData *data) -> void
+auto TriangleItem::updateData(ShaderData *) -> void
 {
-    static_cast<SData*>(data)->scaler = d->scaler;
+}
+
+auto TriangleItem::updateVertex(Vertex *vertex) -> void
+{
+    // points are relative to size, scaled here instead of in shader
+    for (int i = 0; i < 3; ++i) {
+        vertex[i] = vertices()[i];
+        vertex[i].position.set(vertex[i].position.x * width(),
+                               vertex[i].position.y * height());
+    }
 }
 
 auto TriangleItem::geometryChanged(const QRectF &new_, const QRectF &old) -> void
@@ -157,7 +158,5 @@ auto TriangleItem::geometryChanged(const QRectF &new_, const QRectF &old) -> voi
 
 auto TriangleItem::updatePolish() -> void
 {
-    d->scaler.setToIdentity();
-    d->scaler.scale(width(), height());
-    reserve(UpdateAll);
+    reserve(UpdateGeometry);
 }
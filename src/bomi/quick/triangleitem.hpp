@@ -29,12 +29,13 @@ signals:
 private:
     auto geometryChanged(const QRectF &new_, const QRectF &old) -> void final;
     auto updatePolish() -> void final;
+    auto updateVertex(Vertex *vertex) -> void final;
     auto vertexCount() const -> int final { return 3; }
     auto type() const -> Type* final { static Type t; return &t; }
     auto createShader() const -> ShaderIface* final;
     auto createData() const -> ShaderData* final;
     auto updateData(ShaderData *data) -> void final;
-    struct SIface; struct SData;
+    struct SIface;
     struct Data;
     Data *d;
 };
@@ -2,16 +2,81 @@
 #include "player/mrl.hpp"
 #include "misc/xmlrpcclient.hpp"
 #include "misc/locale.hpp"
+#include "misc/dataevent.hpp"
+#include <QThreadPool>
+#include <QtEndian>
 
 SIA _Args() -> QVariantList { return QVariantList(); }
 auto translator_display_language(const QString &iso) -> QString;
 
+enum EventType { Hashed = QEvent::User + 1 };
+
+static constexpr int HashChunk = 64 * 1024;
+
+struct MovieHash {
+    QString file, hash;
+    qint64 bytes = 0;
+};
+
+// file size plus sums of 64-bit words in the first and last 64 KiB
+static auto movieHash(const QString &fileName, MovieHash *out) -> bool
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    const auto bytes = file.size();
+    if (bytes < HashChunk)
+        return false;
+    quint64 h = bytes;
+    auto sum = [&] (qint64 offset) -> bool {
+        if (!file.seek(offset))
+            return false;
+        const auto buffer = file.read(HashChunk);
+        if (buffer.size() != HashChunk)
+            return false;
+        const auto data = reinterpret_cast<const uchar*>(buffer.constData());
+        for (int i = 0; i < HashChunk; i += sizeof(quint64))
+            h += qFromLittleEndian<quint64>(data + i);
+        return true;
+    };
+    if (!sum(0) || !sum(bytes - HashChunk))
+        return false;
+    out->file = fileName;
+    out->bytes = bytes;
+    out->hash = QString::number(h, 16).rightJustified(16, '0'_q);
+    return true;
+}
+
+class HashJob : public QRunnable {
+public:
+    HashJob(QObject *finder, int serial, const QStringList &files)
+        : m_finder(finder), m_serial(serial), m_files(files) { }
+    auto run() -> void final
+    {
+        QVector<MovieHash> hashes;
+        for (auto &file : m_files) {
+            MovieHash hash;
+            if (movieHash(file, &hash))
+                hashes.push_back(hash);
+        }
+        _PostEvent(m_finder, Hashed, m_serial, hashes);
+    }
+private:
+    QObject *m_finder = nullptr;
+    int m_serial = 0;
+    QStringList m_files;
+};
+
 struct OpenSubtitlesFinder::Data {
     State state = Unavailable;
     OpenSubtitlesFinder *p = nullptr;
     XmlRpcClient client;
     QString token, error;
     QTimer timer;
+    QThreadPool pool;
+    int serial = 0;
+    // results of hash searches, which never change for a file
+    QHash<QString, QVector<SubtitleLink>> cache;
 
     void setState(State s) {
         if (_Change(state, s)) {
@@ -49,16 +114,17 @@ struct OpenSubtitlesFinder::Data {
         this->error = error;
         setState(Error);
     }
-    auto call(const QVariantMap &map) -> void
+    using Links = QVector<SubtitleLink>;
+    // links grouped by MovieHash, or under empty key for other searches
+    using Found = std::function<void(const QHash<QString, Links>&)>;
+    auto call(const QVariantList &queries, Found &&done) -> void
     {
-        const auto args = _Args() << token << QVariant(QVariantList() << map);
-        client.call(u"SearchSubtitles"_q, args, p, [this] (const QVariantList &results) {
+        const auto args = _Args() << token << QVariant(queries);
+        client.call(u"SearchSubtitles"_q, args, p, [this, done] (const QVariantList &results) {
             setState(Available);
-            if (results.isEmpty() || results.first().type() != QVariant::Map) {
-                emit p->found(QVector<SubtitleLink>());
-            } else {
+            QHash<QString, Links> found;
+            if (!results.isEmpty() && results.first().type() == QVariant::Map) {
                 const auto list = results.first().toMap()[u"data"_q].toList();
-                QVector<SubtitleLink> links;
                 for (auto &it : list) {
                     if (it.type() != QVariant::Map)
                         continue;
@@ -72,14 +138,63 @@ struct OpenSubtitlesFinder::Data {
                         link.langCode = map[u"ISO639"_q].toString();
                     if (link.langCode.isEmpty())
                         link.langCode = map[u"LanguageName"_q].toString();
-                    links.append(link);
+                    found[map[u"MovieHash"_q].toString()].append(link);
                 }
-                emit p->found(links);
             }
+            done(found);
         });
         timer.stop();
         timer.start();
     }
+    auto call(const QVariantMap &map) -> void
+    {
+        call(QVariantList() << map, [this] (const QHash<QString, Links> &found) {
+            Links links;
+            for (auto &list : found)
+                links += list;
+            emit p->found(links);
+        });
+    }
+    auto search(const QVector<MovieHash> &hashes) -> void
+    {
+        Links links;
+        QVariantList queries;
+        QHash<QString, QString> files; // hash -> file
+        auto append = [] (Links &links, const Links &found, const QString &file) {
+            for (auto link : found) {
+                link.media = file;
+                links.push_back(link);
+            }
+        };
+        for (auto &hash : hashes) {
+            auto it = cache.constFind(hash.hash);
+            if (it != cache.cend()) {
+                append(links, *it, hash.file);
+                continue;
+            }
+            if (files.contains(hash.hash))
+                continue;
+            files[hash.hash] = hash.file;
+            QVariantMap map;
+            map[u"sublanguageid"_q] = u"all"_q;
+            map[u"moviehash"_q] = hash.hash;
+            map[u"moviebytesize"_q] = hash.bytes;
+            queries.push_back(map);
+        }
+        if (queries.isEmpty()) {
+            setState(Available);
+            emit p->found(links);
+            return;
+        }
+        call(queries, [=] (const QHash<QString, Links> &found) mutable {
+            for (auto it = files.cbegin(); it != files.cend(); ++it) {
+                const auto list = found.value(it.key());
+                cache.insert(it.key(), list);
+                append(links, list, it.value());
+            }
+            emit p->found(links);
+        });
+    }
 };
 
 OpenSubtitlesFinder::OpenSubtitlesFinder(QObject *parent)
@@ -113,6 +228,8 @@ OpenSubtitlesFinder::OpenSubtitlesFinder(QObject *parent)
 }
 
 OpenSubtitlesFinder::~OpenSubtitlesFinder() {
+    d->pool.clear();
+    d->pool.waitForDone();
     d->timer.stop();
     d->logout();
     delete d;
@@ -147,40 +264,38 @@ auto OpenSubtitlesFinder::find(const QString &query, int season, int episode) ->
 }
 
 auto OpenSubtitlesFinder::find(const Mrl &mrl) -> bool
+{
+    return find(QList<Mrl>() << mrl);
+}
+
+auto OpenSubtitlesFinder::find(const QList<Mrl> &mrls) -> bool
 {
     if (d->state != Available)
         return false;
-    auto fileName = mrl.toLocalFile();
-    if (fileName.isEmpty())
-        return false;
-    QFile file(fileName);
-    if (!file.open(QFile::ReadOnly))
-        return false;
-    const auto bytes = file.size();
-    constexpr int len = 64*1024;
-    if (bytes < len)
+    QStringList files;
+    for (auto &mrl : mrls) {
+        const QFileInfo info(mrl.toLocalFile());
+        if (info.isFile() && info.size() >= HashChunk)
+            files.push_back(info.absoluteFilePath());
+    }
+    if (files.isEmpty())
         return false;
     d->setState(Finding);
-    constexpr int chunks = len/sizeof(quint64);
-    QDataStream in(&file);
-    in.setByteOrder(QDataStream::LittleEndian);
-    auto sum = [&chunks, &file, &in] (qint64 offset) {
-        file.seek(offset); quint64 hash = 0, chunk = 0;
-        for (int i=0; i<chunks; ++i) { in >> chunk; hash += chunk; } return hash;
-    };
-    quint64 h = bytes + sum(0) + sum(bytes-len);
-    auto hash = QString::number(h, 16);
-    if (hash.size() < 16)
-        hash = _N(0, 10, 16-hash.size(), '0'_q) + hash;
-
-    QVariantMap map;
-    map[u"sublanguageid"_q] = u"all"_q;
-    map[u"moviehash"_q] = hash;
-    map[u"moviebytesize"_q] = bytes;
-    d->call(map);
+    d->pool.start(new HashJob(this, ++d->serial, files));
     return true;
 }
 
+auto OpenSubtitlesFinder::customEvent(QEvent *event) -> void
+{
+    if (event->type() != Hashed)
+        return;
+    int serial = 0; QVector<MovieHash> hashes;
+    _TakeData(event, serial, hashes);
+    if (serial != d->serial || d->state != Finding)
+        return;
+    d->search(hashes);
+}
+
 auto OpenSubtitlesFinder::state() const -> OpenSubtitlesFinder::State
 {
     return d->state;
@@ -6,6 +6,8 @@ class Mrl;
 struct SubtitleLink {
     QString language, fileName, date, langCode;
     QUrl url;
+    // media file which link was found for by hash, empty for other searches
+    QString media;
 };
 
 class OpenSubtitlesFinder : public QObject {
@@ -17,11 +19,15 @@ public:
     OpenSubtitlesFinder(QObject *parent = nullptr);
     ~OpenSubtitlesFinder();
     auto find(const Mrl &mrl) -> bool;
+    // files are hashed in background and searched in one request
+    auto find(const QList<Mrl> &mrls) -> bool;
     auto find(const QString &tag) -> bool;
     auto find(const QString &query, int season, int episode) -> bool;
     auto state() const -> State;
     auto isAvailable() const -> bool { return state() == Available; }
     auto error() const -> QString;
+private:
+    auto customEvent(QEvent *event) -> void final;
 signals:
     void stateChanged();
     void found(const QVector<SubtitleLink> &links);
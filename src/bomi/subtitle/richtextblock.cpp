@@ -18,14 +18,24 @@ auto RichTextBlockParser::get(const QString &open, const QString &close,
     return ret;
 }
 
-auto RichTextBlockParser::paragraph(Tag *tag) -> QList<RichTextBlock>
+auto RichTextBlockParser::paragraphText(Tag *tag) -> QStringRef
 {
     if (m_pos >= m_text.size())
-        return QList<RichTextBlock>();
+        return QStringRef();
     QStringRef paragraph = trim(get(u"p"_q, u"/?sync|/?p|/body|/sami"_q, tag));
-    if (m_good)
-        return parse(paragraph, tag ? tag->style() : RichTextBlock::Style());
-    return QList<RichTextBlock>();
+    if (!m_good)
+        return QStringRef();
+    if (paragraph.isNull())
+        paragraph = QStringRef(m_text.string(), m_text.position() + m_pos, 0);
+    return paragraph;
+}
+
+auto RichTextBlockParser::paragraph(Tag *tag) -> QList<RichTextBlock>
+{
+    const auto paragraph = paragraphText(tag);
+    if (paragraph.isNull())
+        return QList<RichTextBlock>();
+    return parse(paragraph, tag ? tag->style() : RichTextBlock::Style());
 }
 
 auto RichTextBlockParser::parse(const QStringRef &text,
@@ -52,10 +52,12 @@ public:
     auto get(const QString &open, const QString &close,
              Tag *tag = nullptr) -> QStringRef;
     auto paragraph(Tag *tag = nullptr) -> QList<RichTextBlock>;
+    // markup of next paragraph to be parsed later, null at end
+    auto paragraphText(Tag *tag = nullptr) -> QStringRef;
+    static auto parse(const QStringRef &text, const RichTextBlock::Style &style
+                      = RichTextBlock::Style()) -> QList<RichTextBlock>;
 protected:
     using Style = RichTextBlock::Style;
-    static auto parse(const QStringRef &text,
-                      const Style &style = Style()) -> QList<RichTextBlock>;
     QStringRef m_text;
     int m_pos, m_good;
 };
@@ -1,4 +1,18 @@
 #include "richtextdocument.hpp"
+#include <QGlyphRun>
+
+struct RichTextDocument::Shared {
+    ~Shared()
+    {
+        for (auto &layout : layouts) {
+            qDeleteAll(layout->rubies);
+            _Delete(layout);
+        }
+    }
+    QVector<Layout*> layouts;
+    QVector<QRectF> boxes;
+    QRectF natural;
+};
 
 RichTextDocument::RichTextDocument()
 {
@@ -11,13 +25,59 @@ RichTextDocument::RichTextDocument(const QString &text)
 }
 
 RichTextDocument::RichTextDocument(const RichTextDocument &rhs)
-    : m_blocks(rhs.blocks())
-    , m_option(rhs.m_option)
+    : m_option(rhs.m_option)
     , m_format(rhs.m_format)
     , m_lineLeading(rhs.m_lineLeading)
     , m_paragraphLeading(rhs.m_paragraphLeading)
 {
-    setChanged(!m_blocks.isEmpty());
+    assign(rhs);
+    setChanged(!m_blocks.isEmpty() || m_lazy.load());
+}
+
+// captions are shared between gui and rendering threads
+static QMutex sourceMutex;
+
+auto RichTextDocument::assign(const RichTextDocument &rhs) -> void
+{
+    if (rhs.m_lazy.loadAcquire()) {
+        QMutexLocker locker(&sourceMutex);
+        if (rhs.m_lazy.load()) {
+            m_blocks = rhs.m_blocks;
+            m_sources = rhs.m_sources;
+            m_lazy.storeRelease(1);
+            return;
+        }
+    }
+    m_blocks = rhs.m_blocks;
+    m_sources.clear();
+    m_lazy.storeRelease(0);
+}
+
+auto RichTextDocument::appendSource(const QString &text, int from, int length,
+                                    bool paragraphs,
+                                    const RichTextBlock::Style &style) -> void
+{
+    m_sources.append({text, from, length, paragraphs, style});
+    m_lazy.storeRelease(1);
+    setChanged(true);
+}
+
+auto RichTextDocument::parseSources() const -> void
+{
+    QMutexLocker locker(&sourceMutex);
+    if (!m_lazy.load())
+        return;
+    for (auto &source : m_sources) {
+        const QStringRef text(&source.text, source.from, source.length);
+        if (source.paragraphs) {
+            RichTextBlockParser parser(text);
+            while (!parser.atEnd())
+                m_blocks += parser.paragraph();
+        } else
+            m_blocks += RichTextBlockParser::parse(text, source.style);
+    }
+    m_sources.clear();
+    m_lazy.storeRelease(0);
 }
 
 RichTextDocument::~RichTextDocument()
@@ -27,17 +87,46 @@ RichTextDocument::~RichTextDocument()
 
 auto RichTextDocument::freeLayouts() -> void
 {
-    for (auto &layout : m_layouts) {
-        qDeleteAll(layout->rubies);
-        _Delete(layout);
+    if (m_shared)
+        m_shared.reset();
+    else {
+        for (auto &layout : m_layouts) {
+            qDeleteAll(layout->rubies);
+            _Delete(layout);
+        }
     }
     m_layouts.clear();
+    m_blockChanged = true;
+}
+
+static auto writeBlock(QDataStream &out, const RichTextBlock &block) -> void
+{
+    out << block.text << block.paragraph << block.formats.size();
+    for (auto &format : block.formats)
+        out << format.begin << format.end << format.style;
+    out << block.rubies.size();
+    for (auto &ruby : block.rubies) {
+        out << ruby.rb_begin << ruby.rb_end;
+        writeBlock(out, ruby.rt_block);
+    }
+}
+
+auto RichTextDocument::layoutKey(double maxWidth) const -> QByteArray
+{
+    QByteArray key;
+    QDataStream out(&key, QIODevice::WriteOnly);
+    out << m_format.properties() << int(m_option.alignment())
+        << int(m_option.wrapMode()) << m_lineLeading << m_paragraphLeading
+        << maxWidth << m_blocks.size();
+    for (auto &block : m_blocks)
+        writeBlock(out, block);
+    return key;
 }
 
 auto RichTextDocument::operator = (const RichTextDocument &rhs)
 -> RichTextDocument& {
     if (this != &rhs) {
-        m_blocks = rhs.blocks();
+        assign(rhs);
         m_option = rhs.m_option;
         m_format = rhs.m_format;
         m_lineLeading = rhs.m_lineLeading;
@@ -50,6 +139,8 @@ auto RichTextDocument::operator = (const RichTextDocument &rhs)
 auto RichTextDocument::operator = (const QList<RichTextBlock> &rhs)
 -> RichTextDocument& {
     if (&m_blocks != &rhs) {
+        m_sources.clear();
+        m_lazy.storeRelease(0);
         m_blocks = rhs;
         setChanged(true);
     }
@@ -65,6 +156,7 @@ auto RichTextDocument::operator += (const QList<RichTextBlock> &rhs)
 -> RichTextDocument& {
     if (!rhs.isEmpty()) {
         setChanged(true);
+        blocks();
         m_blocks += rhs;
     }
     return *this;
@@ -124,10 +216,8 @@ auto RichTextDocument::setTextOutline(const QPen &pen) -> void
 auto RichTextDocument::setText(const QString &text) -> void
 {
     m_blocks.clear();
-    RichTextBlockParser parser(text.midRef(0));
-    while (!parser.atEnd())
-        m_blocks += parser.paragraph();
-    setChanged(true);
+    m_sources.clear();
+    appendText(text);
 }
 
 
@@ -144,6 +234,25 @@ auto RichTextDocument::doLayout(double maxWidth) -> void
 {
     if (!m_dirty)
         return;
+    blocks();
+    QByteArray key;
+    if (m_cache) {
+        key = layoutKey(maxWidth);
+        if (auto shared = m_cache->m_cache.object(key)) {
+            freeLayouts();
+            m_shared = *shared;
+            m_layouts = m_shared->layouts;
+            m_boxes = m_shared->boxes;
+            m_natural = m_shared->natural;
+            m_blockChanged = m_dirty = false;
+            return;
+        }
+    }
+    // never lay out again what others may draw
+    if (m_shared) {
+        freeLayouts();
+        updateLayoutInfo();
+    }
     double width = -1;
     const int px = m_format.intProperty(QTextFormat::FontPixelSize);
     m_boxes.clear();
@@ -204,10 +313,20 @@ auto RichTextDocument::doLayout(double maxWidth) -> void
     }
     m_natural = QRectF(0.0, 0.0, width, pos.ry());
     m_dirty = false;
+    if (m_cache) {
+        m_shared.reset(new Shared);
+        m_shared->layouts = m_layouts;
+        m_shared->boxes = m_boxes;
+        m_shared->natural = m_natural;
+        m_cache->m_cache.insert(key, new QSharedPointer<Shared>(m_shared));
+    }
 }
 
 auto RichTextDocument::updateLayoutInfo() -> void
 {
+    blocks();
+    if (m_shared && (m_formatChanged || m_pxChanged || m_optionChanged))
+        freeLayouts();
     if (m_blockChanged) {
         freeLayouts();
         m_layouts.resize(m_blocks.size());
@@ -297,6 +416,39 @@ auto RichTextDocument::draw(QPainter *painter, const QPointF &pos) -> void
     }
 }
 
+auto RichTextDocument::drawOutline(QPainter *painter, const QPointF &pos,
+                                   const QPen &pen) -> void
+{
+    QPainterPath path;
+    auto add = [&] (const QTextLayout &layout) {
+        for (auto &run : layout.glyphRuns()) {
+            const auto font = run.rawFont();
+            const auto indexes = run.glyphIndexes();
+            const auto positions = run.positions();
+            for (int i = 0; i < indexes.size(); ++i)
+                path.addPath(font.pathForGlyph(indexes[i]).translated(positions[i]));
+            if (positions.isEmpty())
+                continue;
+            const auto rect = run.boundingRect();
+            const auto base = positions.first().y();
+            auto line = [&] (double y)
+                { path.addRect(rect.left(), y, rect.width(), font.lineThickness()); };
+            if (run.underline())
+                line(base + font.underlinePosition());
+            if (run.strikeOut())
+                line(base - font.ascent()/3.0);
+            if (run.overline())
+                line(base - font.ascent());
+        }
+    };
+    for (auto layout : m_layouts) {
+        add(layout->block);
+        for (auto ruby : layout->rubies)
+            add(*ruby);
+    }
+    painter->strokePath(path.translated(pos), pen);
+}
+
 auto RichTextDocument::drawBoudingBoxes(QPainter *painter,
                                         const QPointF &pos) -> void
 {
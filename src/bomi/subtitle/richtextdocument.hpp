@@ -4,9 +4,11 @@
 #include "richtextblock.hpp"
 #include "richtexthelper.hpp"
 #include <QTextLayout>
+#include <QCache>
 
 class RichTextDocument : public RichTextHelper {
 public:
+    class LayoutCache;
     RichTextDocument();
     RichTextDocument(const QString &text);
     RichTextDocument(const RichTextDocument &rhs);
@@ -15,15 +17,15 @@ public:
     RichTextDocument &operator = (const QList<RichTextBlock> &rhs);
     RichTextDocument &operator += (const RichTextDocument &rhs);
     RichTextDocument &operator += (const QList<RichTextBlock> &rhs);
-    inline auto isEmpty() const -> bool {return m_blocks.isEmpty();}
+    inline auto isEmpty() const -> bool {return blocks().isEmpty();}
     inline auto totalLength() const -> int {
         int ret = 0;
-        for (auto &block : m_blocks)
+        for (auto &block : blocks())
             ret += block.text.size();
         return ret;
     }
     inline auto hasWords() const -> bool {
-        for (auto &block : m_blocks) {
+        for (auto &block : blocks()) {
             if (block.hasWords())
                 return true;
         }
@@ -31,15 +33,25 @@ public:
     }
     inline auto toPlainText() const -> QString {
         QString ret;
-        for (auto &block : m_blocks)
+        for (auto &block : blocks())
             ret += block.text;
         return ret;
     }
-    inline const QList<RichTextBlock> &blocks() const {return m_blocks;}
+    inline const QList<RichTextBlock> &blocks() const
+        { if (m_lazy.loadAcquire()) parseSources(); return m_blocks; }
+    // append markup which is parsed on first access to blocks
+    // text is shared, so a span of a whole file costs no copy
+    auto appendText(const QString &text) -> void
+        { appendSource(text, 0, text.size(), true, {}); }
+    auto appendParagraph(const QString &text, int from, int length,
+                         const RichTextBlock::Style &style) -> void
+        { appendSource(text, from, length, false, style); }
     auto setAlignment(Qt::Alignment alignment) -> void;
     auto setWrapMode(QTextOption::WrapMode wrapMode) -> void;
     auto setFormat(QTextFormat::Property property, const QVariant &data) -> void;
     auto draw(QPainter *painter, const QPointF &pos) -> void;
+    // stroke contours of laid out glyphs
+    auto drawOutline(QPainter *painter, const QPointF &pos, const QPen &pen) -> void;
     auto drawBoudingBoxes(QPainter *painter, const QPointF &pos) -> void;
     auto doLayout(double maxWidth) -> void;
     auto updateLayoutInfo() -> void;
@@ -49,18 +61,40 @@ public:
     auto setTextOutline(const QPen &pen) -> void;
     auto naturalSize() const -> QSizeF {return m_natural.size();}
     auto setLeading(double newLine, double paragraph) -> void;
-    auto clear() -> void { freeLayouts(); m_blocks.clear(); setChanged(true); }
+    auto clear() -> void
+    {
+        freeLayouts(); m_blocks.clear(); m_sources.clear();
+        m_lazy.storeRelease(0); setChanged(true);
+    }
     const QVector<QRectF> &boundingBoxes() const { return m_boxes; }
+    // reuse shaped layouts of documents with same content, format and width
+    // cache is not copied along with document
+    auto setLayoutCache(LayoutCache *cache) -> void { m_cache = cache; }
 private:
     struct Layout {
         QTextLayout block;
         QVector<QTextLayout*> rubies;
     };
+    struct Shared;
+    struct Source {
+        QString text;
+        int from, length;
+        bool paragraphs;
+        RichTextBlock::Style style;
+    };
+    auto appendSource(const QString &text, int from, int length,
+                      bool paragraphs, const RichTextBlock::Style &style) -> void;
+    auto parseSources() const -> void;
+    auto assign(const RichTextDocument &rhs) -> void;
     auto freeLayouts() -> void;
+    auto layoutKey(double maxWidth) const -> QByteArray;
     inline auto setChanged(bool changed) -> void {
         m_dirty = m_blockChanged = m_formatChanged = m_pxChanged = m_optionChanged = changed;
     }
-    QList<RichTextBlock> m_blocks;
+    // parsed lazily from m_sources while m_lazy is set
+    mutable QList<RichTextBlock> m_blocks;
+    mutable QVector<Source> m_sources;
+    mutable QAtomicInt m_lazy = 0;
     QVector<QRectF> m_boxes;
     QTextOption m_option;
     QTextCharFormat m_format;
@@ -69,6 +103,29 @@ private:
     QVector<Layout*> m_layouts;
     bool m_blockChanged, m_formatChanged, m_optionChanged, m_pxChanged, m_dirty;
     QRectF m_natural;
+    LayoutCache *m_cache = nullptr;
+    // owner of m_layouts when they came from or went to cache
+    QSharedPointer<Shared> m_shared;
+};
+
+// recently laid out documents, not thread-safe
+// copies start empty so that each owner keeps its own
+class RichTextDocument::LayoutCache {
+public:
+    LayoutCache(int size = 128) { m_cache.setMaxCost(size); }
+    LayoutCache(const LayoutCache &rhs) { m_cache.setMaxCost(rhs.m_cache.maxCost()); }
+    auto operator = (const LayoutCache &rhs) -> LayoutCache&
+    {
+        if (this != &rhs) {
+            m_cache.clear();
+            m_cache.setMaxCost(rhs.m_cache.maxCost());
+        }
+        return *this;
+    }
+    auto clear() -> void { m_cache.clear(); }
+private:
+    friend class RichTextDocument;
+    QCache<QByteArray, QSharedPointer<Shared>> m_cache;
 };
 
 #endif // RICHTEXTDOCUMENT_HPP
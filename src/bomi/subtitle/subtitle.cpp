@@ -10,14 +10,13 @@ auto SubComp::name() const -> QString
     return m_klass.isEmpty() ? m_file : m_file % "("_a % m_klass % ")"_a;
 }
 
-auto Subtitle::component(double frameRate) const -> SubComp
+auto Subtitle::timeline(double frameRate) const -> SubCompTimeline
 {
-    if (m_comp.isEmpty())
-        return SubComp();
-    SubComp comp;
-    for (int i=0; i<m_comp.size(); ++i)
-        comp.unite(m_comp[i], frameRate);
-    return comp;
+    QVector<const SubComp*> comps;
+    comps.reserve(m_comp.size());
+    for (auto &comp : m_comp)
+        comps.push_back(&comp);
+    return SubCompTimeline(comps, frameRate);
 }
 
 SubComp::SubComp() {
@@ -40,11 +39,6 @@ auto SubComp::toTrack() const -> StreamTrack
     return StreamTrack::fromSubComp(*this);
 }
 
-auto SubComp::united(const SubComp &other, double frameRate) const -> SubComp
-{
-    return SubComp(*this).unite(other, frameRate);
-}
-
 auto SubComp::start(int time, double frameRate) const -> const_iterator
 {
     if (isEmpty() || time < 0)
@@ -65,57 +59,101 @@ auto SubComp::finish(int time, double frameRate) const -> const_iterator
     return upperBound(key);
 }
 
-auto SubComp::unite(const SubComp &rhs, double fps) -> SubComp&
-{
-    if (this == &rhs || rhs.isEmpty())
-        return *this;
-    else if (isEmpty())
-        return *this = rhs;
-    auto convertKeyBase = [this] (int key, SyncType from, SyncType to,
-                                  double frameRate) {
-        return  (from == to) ? key : ((to == Time) ? msec(key, frameRate)
-                                                   : frame(key, frameRate));
-    };
-
-    auto it1 = m_capts.begin();
-    auto it2 = rhs.begin();
-    const auto k2 = convertKeyBase(it2.key(), rhs.base(), m_base, fps);
-    if (it2.key() < it1.key()) {
-        while (k2 < it1.key()) {
-            m_capts.insert(k2, *it2);
-            ++it2;
-        }
-    } else if (k2 == it1.key()){
-        *it1 += *it2;
-        ++it2;
-    } else
-        it1 = --m_capts.lowerBound(k2);
-
-    while (it2 != rhs.end()) {
-        auto &cap1 = *it1;
-//        const int ka = it1.key();
-        const int kb = ++it1 != m_capts.end() ? it1.key() : -1;
-//        Q_ASSERT(ka < k2);
-        int k2 = 0;
-        while (it2 != rhs.end()) {
-            k2 = convertKeyBase(it2.key(), rhs.base(), m_base, fps);
-            if (!(kb == -1 || k2 < kb))
-                break;
-            *m_capts.insert(k2, cap1) += *it2;
-            ++it2;
+SubCompIndex::SubCompIndex(const SubComp *comp)
+    : m_frame(comp->isBasedOnFrame())
+{
+    m_keys.reserve(comp->map().size());
+    m_its.reserve(comp->map().size());
+    for (auto it = comp->begin(); it != comp->end(); ++it) {
+        m_keys.push_back(it.key());
+        m_its.push_back(it);
+    }
+}
+
+auto SubCompIndex::upperBound(int time, double fps) const -> int
+{
+    // msec() is monotonic in frame, so order of keys holds for any fps
+    auto it = m_frame ? std::upper_bound(m_keys.begin(), m_keys.end(), time,
+                            [fps] (int t, int key) { return t < SubComp::msec(key, fps); })
+                      : std::upper_bound(m_keys.begin(), m_keys.end(), time);
+    return it - m_keys.begin();
+}
+
+SubCompTimeline::SubCompTimeline(const QVector<const SubComp*> &comps, double fps)
+    : m_fps(fps)
+{
+    m_indexes.reserve(comps.size());
+    for (auto comp : comps) {
+        m_indexes.push_back(SubCompIndex(comp));
+        m_frame |= comp->isBasedOnFrame();
+    }
+    merge();
+}
+
+auto SubCompTimeline::setFps(double fps) -> void
+{
+    if (_Change(m_fps, fps) && m_frame)
+        merge();
+}
+
+auto SubCompTimeline::merge() -> void
+{
+    // frame is not placeable without fps
+    auto usable = [this] (const SubCompIndex &index)
+        { return !index.isBasedOnFrame() || m_fps > 0.0; };
+    int total = 0;
+    for (auto &index : m_indexes)
+        total += usable(index) ? index.size() : 0;
+    m_times.clear();
+    m_times.reserve(total);
+    QVector<int> heads(m_indexes.size(), 0);
+    forever {
+        int min = -1, time = 0;
+        for (int k = 0; k < m_indexes.size(); ++k) {
+            const auto &index = m_indexes[k];
+            if (!usable(index) || heads[k] >= index.size())
+                continue;
+            const int t = index.time(heads[k], m_fps);
+            if (min < 0 || t < time) {
+                min = k;
+                time = t;
+            }
         }
-        if (it2 == rhs.end())
+        if (min < 0)
             break;
-        if (k2 == kb)
-            *it1 += *it2++;
-        else if (it2 != rhs.begin())
-            *it1 += *(it2-1);
+        ++heads[min];
+        if (m_times.isEmpty() || m_times.last() != time)
+            m_times.push_back(time);
     }
+}
+
+auto SubCompTimeline::start(int time) const -> int
+{
+    if (time < 0)
+        return -1;
+    auto it = std::upper_bound(m_times.begin(), m_times.end(), time);
+    return it == m_times.begin() ? -1 : *(it - 1);
+}
 
-    auto it = m_capts.begin();
-    for (int idx = 0; it != m_capts.end(); ++idx, ++it)
-        it->index = idx;
-    return *this;
+auto SubCompTimeline::finish(int time) const -> int
+{
+    if (time < 0)
+        return -1;
+    auto it = std::upper_bound(m_times.begin(), m_times.end(), time);
+    return it == m_times.end() ? -1 : *it;
+}
+
+auto SubCompTimeline::caption(int time) const -> RichTextDocument
+{
+    RichTextDocument caption;
+    for (auto &index : m_indexes) {
+        if (index.isBasedOnFrame() && m_fps <= 0.0)
+            continue;
+        const int i = index.find(time, m_fps);
+        if (i >= 0)
+            caption += *index.iterator(i);
+    }
+    return caption;
 }
 
 auto Subtitle::caption(int time, double fps) const -> RichTextDocument
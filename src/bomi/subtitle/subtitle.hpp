@@ -41,8 +41,6 @@ public:
     auto operator != (const SubComp &rhs) const -> bool {return !operator==(rhs);}
     auto operator[] (int key) -> SubCapt& { return m_capts[key]; }
     auto operator[] (int key) const -> SubCapt { return m_capts[key]; }
-    auto unite(const SubComp &other, double frameRate) -> SubComp&;
-    auto united(const SubComp &other, double frameRate) const -> SubComp;
 
     auto hasWords() const -> bool
         { for (auto &c : m_capts) if (c.hasWords()) return true; return false; }
@@ -93,6 +91,55 @@ private:
 
 using SubtitleComponentIterator = QMapIterator<int, SubCapt>;
 
+// flat sorted index of captions in a component
+// frame keys are converted when searched, so fps can change freely
+class SubCompIndex {
+public:
+    SubCompIndex() = default;
+    SubCompIndex(const SubComp *comp);
+    auto size() const -> int { return m_keys.size(); }
+    auto isEmpty() const -> bool { return m_keys.isEmpty(); }
+    auto iterator(int i) const -> SubComp::ConstIt { return m_its[i]; }
+    auto isBasedOnFrame() const -> bool { return m_frame; }
+    auto time(int i, double fps) const -> int
+        { return m_frame ? SubComp::msec(m_keys[i], fps) : m_keys[i]; }
+    // first caption which starts after time, size() if none
+    auto upperBound(int time, double fps) const -> int;
+    // caption shown at time, -1 if before first one
+    auto find(int time, double fps) const -> int { return upperBound(time, fps) - 1; }
+private:
+    QVector<int> m_keys;
+    QVector<SubComp::ConstIt> m_its;
+    bool m_frame = false;
+};
+
+// merged timeline of several components, which are neither copied nor united
+// boundaries of every index are merged in k-way once and captions of each
+// component are joined only when asked, so cost of selection is linear
+class SubCompTimeline {
+public:
+    SubCompTimeline() = default;
+    SubCompTimeline(const QVector<const SubComp*> &comps, double fps);
+    auto isEmpty() const -> bool { return m_times.isEmpty(); }
+    auto size() const -> int { return m_times.size(); }
+    auto time(int i) const -> int { return m_times[i]; }
+    auto fps() const -> double { return m_fps; }
+    // merges again only if any component is based on frame
+    auto setFps(double fps) -> void;
+    // start of caption shown at time, -1 if none
+    auto start(int time) const -> int;
+    // start of caption after time, -1 if none
+    auto finish(int time) const -> int;
+    // captions of every component shown at time
+    auto caption(int time) const -> RichTextDocument;
+private:
+    auto merge() -> void;
+    QVector<SubCompIndex> m_indexes;
+    QVector<int> m_times;
+    double m_fps = -1.0;
+    bool m_frame = false;
+};
+
 class Subtitle {
 public:
     const SubComp &operator[] (int rhs) const {return m_comp[rhs];}
@@ -100,7 +147,7 @@ public:
     auto count() const -> int {return m_comp.size();}
     auto size() const -> int {return m_comp.size();}
     auto isEmpty() const -> bool;
-    auto component(double frameRate) const -> SubComp;
+    auto timeline(double frameRate) const -> SubCompTimeline;
     const QList<SubComp> &components() const { return m_comp; }
 //    auto start(int time, double frameRate) const -> int;
 //    auto end(int time, double frameRate) const -> int;
@@ -1,6 +1,5 @@
 #include "subtitle_parser_p.hpp"
 #include "misc/log.hpp"
-#include <QTextStream>
 
 DECLARE_LOG_CONTEXT(Subtitle)
 
@@ -17,12 +16,17 @@ auto SubtitleParser::parse(const QString &fileName,
                            const EncodingInfo &enc) -> Subtitle
 {
     QFile file(fileName);
-    if (!file.open(QFile::ReadOnly) || file.size() > (1 << 20))
+    if (!file.open(QFile::ReadOnly) || file.size() > (16 << 20))
         return Subtitle();
-    QTextStream in;
-    in.setDevice(&file);
-    in.setCodec(enc.codec());
-    const QString all = in.readAll();
+    // decode in one pass from mapped file, utf-8 skips QTextCodec
+    QString all;
+    if (auto data = file.map(0, file.size())) {
+        all = enc.decode(reinterpret_cast<const char*>(data), file.size());
+        file.unmap(data);
+    } else {
+        const auto bytes = file.readAll();
+        all = enc.decode(bytes.constData(), bytes.size());
+    }
     QFileInfo info(fileName);
     Subtitle sub;
 
@@ -32,8 +32,9 @@ protected:
         { return sub.m_comp; }
     static auto components(const Subtitle &sub) -> const QList<SubComp>&
         { return sub.m_comp; }
+    // captions are kept as markup until shown
     static auto append(SubComp &c, const QString &text, int start) -> void
-        { c[start] += RichTextDocument(text); }
+        { c[start].appendText(text); }
     static auto append(SubComp &c, const QString &t, int start, int end) -> void
         { append(c, t, start); c[end]; }
 private:
@@ -38,11 +38,16 @@ auto SamiParser::_parse(Subtitle &sub) -> void
         if (tag.name.isEmpty())
             break;
         const int sync = toInt(tag.value("start"));
-        QMap<QString, QList<RichTextBlock> > blocks;
+        // only spans of paragraphs are kept, rich text is built on demand
+        struct Paragraph { QStringRef text; RichTextBlock::Style style; };
+        QMap<QString, QVector<Paragraph>> blocks;
         RichTextBlockParser p(block_sync);
         while (!p.atEnd()) {
-            const QList<RichTextBlock> paragraph = p.paragraph(&tag);
-            blocks[tag.value("class").toString()] += paragraph;
+            const auto paragraph = p.paragraphText(&tag);
+            // caption without paragraph still clears previous one
+            auto &list = blocks[tag.value("class").toString()];
+            if (!paragraph.isNull())
+                list.append({paragraph, tag.style()});
         }
         for (auto it = blocks.begin(); it != blocks.end(); ++it) {
             SubComp *comp = nullptr;
@@ -56,7 +61,10 @@ auto SamiParser::_parse(Subtitle &sub) -> void
                 comp = &append(sub);
                 comp->setLanguage(it.key());
             }
-            (*comp)[sync] += it.value();
+            auto &capt = (*comp)[sync];
+            for (auto &paragraph : it.value())
+                capt.appendParagraph(text, paragraph.text.position(),
+                                     paragraph.text.size(), paragraph.style);
         }
     }
 }
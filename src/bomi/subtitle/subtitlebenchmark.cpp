@@ -0,0 +1,228 @@
+#include "subtitlebenchmark.hpp"
+#include "subtitle.hpp"
+#include "subtitledrawer.hpp"
+#include "os/os.hpp"
+#include "misc/benchmarktable.hpp"
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+
+static const char *const s_lines[] = {
+    "Where are you going?",
+    "<i>He said he would be back before dawn.</i>",
+    "<b>Stop!</b> Don't move.",
+    "<font color=\"#ffff00\">[door creaks]</font>",
+    "- Did you hear that?<br>- Hear what?",
+    "I have been waiting here for hours and nobody told me that "
+        "the last train had already left the station.",
+    "어디 가는 거야? 여기서 기다려.",
+    "<u>Chapter Two</u><br><i>The Return</i>"
+};
+
+struct SubtitleBenchmark::Data {
+    QTemporaryDir dir;
+    QList<Sample> samples;
+    int captions = 2000;
+    QRectF area = {0, 0, 1280, 720};
+    double peak = 0.0;
+
+    auto line(int i) const -> QString
+        { return QString::fromUtf8(s_lines[i % (int)(sizeof(s_lines)/sizeof(s_lines[0]))]); }
+    auto write(const QString &name, const QString &ext, const QString &text) -> void
+    {
+        Sample sample;
+        sample.name = name;
+        sample.file = dir.path() % "/sample."_a % ext;
+        QFile file(sample.file);
+        if (!file.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+        sample.bytes = file.write(text.toUtf8());
+        samples.push_back(sample);
+    }
+    auto generate() -> void
+    {
+        auto srtTime = [] (int ms) {
+            return u"%1:%2:%3,%4"_q.arg(ms/3600000, 2, 10, '0'_q)
+                    .arg(ms/60000%60, 2, 10, '0'_q).arg(ms/1000%60, 2, 10, '0'_q)
+                    .arg(ms%1000, 3, 10, '0'_q);
+        };
+        auto tmpTime = [] (int ms) {
+            return u"%1:%2:%3"_q.arg(ms/3600000, 2, 10, '0'_q)
+                    .arg(ms/60000%60, 2, 10, '0'_q).arg(ms/1000%60, 2, 10, '0'_q);
+        };
+        QString srt, smi, tmp;
+        smi += "<SAMI>\n<HEAD>\n<STYLE TYPE=\"text/css\">\n<!--\n"
+               "P { margin-left:8pt; margin-right:8pt; }\n"
+               ".KRCC { Name:Korean; lang:ko-KR; }\n"
+               ".ENCC { Name:English; lang:en-US; }\n"
+               "-->\n</STYLE>\n</HEAD>\n<BODY>\n"_a;
+        for (int i = 0; i < captions; ++i) {
+            const int start = 1000 + i * 3000, end = start + 2500;
+            const auto text = line(i);
+            srt += _N(i + 1) % '\n'_q % srtTime(start) % " --> "_a
+                    % srtTime(end) % '\n'_q % QString(text).replace("<br>"_a, "\n"_a)
+                    % "\n\n"_a;
+            smi += "<SYNC Start="_a % _N(start) % "><P Class=ENCC>"_a % text
+                    % "\n<P Class=KRCC>"_a % line(i + 6) % '\n'_q
+                    % "<SYNC Start="_a % _N(end) % "><P Class=ENCC>&nbsp;\n"_a
+                    % "<P Class=KRCC>&nbsp;\n"_a;
+            tmp += tmpTime(start) % ':'_q % QString(text).replace("<br>"_a, "|"_a) % '\n'_q
+                    % tmpTime(end) % ":\n"_a;
+        }
+        smi += "</BODY>\n</SAMI>\n"_a;
+        write(u"SubRip"_q, u"srt"_q, srt);
+        write(u"SAMI"_q, u"smi"_q, smi);
+        write(u"TMPlayer"_q, u"txt"_q, tmp);
+    }
+    auto sampleMemory() -> void { peak = qMax(peak, OS::usingMemory()); }
+};
+
+SubtitleBenchmark::SubtitleBenchmark()
+    : d(new Data)
+{
+}
+
+SubtitleBenchmark::~SubtitleBenchmark()
+{
+    delete d;
+}
+
+auto SubtitleBenchmark::setCaptions(int count) -> void
+{
+    d->captions = count;
+    d->samples.clear();
+}
+
+auto SubtitleBenchmark::setArea(const QRectF &area) -> void
+{
+    d->area = area;
+}
+
+auto SubtitleBenchmark::samples() -> QList<Sample>
+{
+    if (d->samples.isEmpty() && d->dir.isValid())
+        d->generate();
+    return d->samples;
+}
+
+auto SubtitleBenchmark::parse(const Sample &sample) -> ParseResult
+{
+    ParseResult result;
+    QElapsedTimer timer;
+    timer.start();
+    const auto sub = Subtitle::parse(sample.file, EncodingInfo::utf8());
+    // captions are parsed lazily, so touch every one
+    for (auto &comp : sub.components()) {
+        for (auto it = comp.begin(); it != comp.end(); ++it) {
+            if (!it->blocks().isEmpty())
+                ++result.captions;
+        }
+    }
+    result.nsecs = timer.nsecsElapsed();
+    d->sampleMemory();
+    return result;
+}
+
+auto SubtitleBenchmark::render(const Sample &sample, const Case &c) -> RenderResult
+{
+    RenderResult result;
+    const auto sub = Subtitle::parse(sample.file, EncodingInfo::utf8());
+    if (sub.isEmpty())
+        return result;
+    const auto &comp = sub[0];
+    SubtitleDrawer drawer;
+    drawer.setGpuEffects(c.gpu);
+    drawer.setStyle(c.style);
+    drawer.setAlignment(Qt::AlignBottom | Qt::AlignHCenter);
+    result.layout.reserve(comp.size());
+    result.draw.reserve(comp.size());
+    const double width = d->area.width() / drawer.scale(d->area);
+    QElapsedTimer timer;
+    QImage image; int gap = 0;
+    for (auto it = comp.begin(); it != comp.end(); ++it) {
+        if (!it->hasWords())
+            continue;
+        RichTextDocument doc = *it;
+        timer.start();
+        doc.doLayout(width);
+        result.layout.push_back(timer.nsecsElapsed());
+        timer.start();
+        drawer.draw(image, gap, *it, d->area, c.dpr);
+        result.draw.push_back(timer.nsecsElapsed());
+    }
+    d->sampleMemory();
+    return result;
+}
+
+auto SubtitleBenchmark::RenderResult::percentile(QVector<quint64> &ns,
+                                                 double p) -> double
+{
+    if (ns.isEmpty())
+        return 0.0;
+    const int n = qBound<int>(0, p * (ns.size() - 1) + 0.5, ns.size() - 1);
+    std::nth_element(ns.begin(), ns.begin() + n, ns.end());
+    return ns[n] * 1e-3;
+}
+
+auto SubtitleBenchmark::cases() -> QList<Case>
+{
+    QList<Case> cases;
+    auto add = [&] (const char *name, std::function<void(OsdStyle&)> &&set,
+                    bool gpu = false) {
+        for (const double dpr : {1.0, 2.0}) {
+            Case c;
+            c.name = _L(name) % " @"_a % _N(dpr, 0) % 'x'_q;
+            set(c.style);
+            c.dpr = dpr;
+            c.gpu = gpu;
+            cases.push_back(c);
+        }
+    };
+    add("plain", [] (OsdStyle &s) {
+        s.outline.enabled = false; s.shadow.enabled = false;
+    });
+    add("outline", [] (OsdStyle &s) { s.shadow.enabled = false; });
+    add("outline+shadow", [] (OsdStyle &s) { s.shadow.blur = false; });
+    add("outline+blur", [] (OsdStyle &) { });
+    add("bbox", [] (OsdStyle &s) {
+        s.outline.enabled = false; s.shadow.enabled = false; s.bbox.enabled = true;
+    });
+    add("outline+blur gpu", [] (OsdStyle &) { }, true);
+    return cases;
+}
+
+auto SubtitleBenchmark::dumpInfo() -> void
+{
+    SubtitleBenchmark bench;
+    const auto samples = bench.samples();
+    if (samples.isEmpty()) {
+        qDebug() << "Cannot write subtitle samples.";
+        return;
+    }
+    const auto cases = SubtitleBenchmark::cases();
+    BenchmarkTable table;
+    table.fit(cases);
+    table.fit(samples);
+    auto num = [] (double v, int w) { return _N(v, 1, w); };
+
+    table.header(u"sample"_q, "  captions  MiB/s  captions/s");
+    for (auto &s : samples) {
+        const auto r = bench.parse(s);
+        const double sec = r.nsecs * 1e-9;
+        table.row(s.name, _N(r.captions, 10, 10)
+                  % num(sec > 0 ? s.bytes / sec / (1 << 20) : 0, 7)
+                  % num(sec > 0 ? r.captions / sec : 0, 12));
+    }
+    qDebug() << "";
+    table.header(u"case"_q, "  layout us p50/p95    draw us p50/p95/p99");
+    const auto &sample = samples.front();
+    for (auto &c : cases) {
+        auto r = bench.render(sample, c);
+        table.row(c.name, num(RenderResult::percentile(r.layout, 0.5), 9)
+                  % num(RenderResult::percentile(r.layout, 0.95), 9)
+                  % num(RenderResult::percentile(r.draw, 0.5), 11)
+                  % num(RenderResult::percentile(r.draw, 0.95), 9)
+                  % num(RenderResult::percentile(r.draw, 0.99), 9));
+    }
+    qDebug() << "";
+    qDebug().nospace() << "peak memory: " << num(bench.d->peak, 0).constData() << " MiB";
+}
@@ -0,0 +1,35 @@
+#ifndef SUBTITLEBENCHMARK_HPP
+#define SUBTITLEBENCHMARK_HPP
+
+#include "misc/osdstyle.hpp"
+
+// runs generated subtitle files through parser, layout and drawer
+// without a video output, to measure the cost of the subtitle path
+
+class SubtitleBenchmark {
+public:
+    struct Sample { QString name, file; qint64 bytes = 0; };
+    struct Case { QString name; OsdStyle style; double dpr = 1.0; bool gpu = false; };
+    struct ParseResult { int captions = 0; quint64 nsecs = 0; };
+    // latencies of each caption in nanoseconds
+    struct RenderResult {
+        QVector<quint64> layout, draw;
+        static auto percentile(QVector<quint64> &ns, double p) -> double;
+    };
+    SubtitleBenchmark();
+    ~SubtitleBenchmark();
+    // number of captions in each generated sample
+    auto setCaptions(int count) -> void;
+    auto setArea(const QRectF &area) -> void;
+    auto samples() -> QList<Sample>;
+    auto parse(const Sample &sample) -> ParseResult;
+    auto render(const Sample &sample, const Case &c) -> RenderResult;
+    static auto cases() -> QList<Case>;
+    // run all samples() and cases() and print tables to stdout
+    static auto dumpInfo() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLEBENCHMARK_HPP
@@ -1,5 +1,145 @@
 #include "subtitledrawer.hpp"
 
+#if defined(__SSE2__)
+#define SUBTITLE_DRAWER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// x/255 for x in [0, 255*255]
+SCIA div255(int x) -> int { return (x + 128 + ((x + 128) >> 8)) >> 8; }
+
+// radius of each of three box passes matching variance of one box of radius
+static auto boxRadius(int radius) -> int
+{
+    const double d = 2*radius + 1;
+    return qMax(1, qRound((std::sqrt((d*d - 1)/3.0 + 1.0) - 1.0)*0.5));
+}
+
+// box filter of src with count samples which are stride apart into dst
+// zero outside
+static auto boxLine(const uchar *src, uchar *dst, int count, int r) -> void
+{
+    const int mul = (1 << 16)/(2*r + 1);
+    int sum = 0;
+    for (int i = 0; i < r && i < count; ++i)
+        sum += src[i];
+    for (int i = 0; i < count; ++i) {
+        if (i + r < count)
+            sum += src[i + r];
+        dst[i] = (sum*mul + (1 << 15)) >> 16;
+        if (i - r >= 0)
+            sum -= src[i - r];
+    }
+}
+
+auto FastAlphaBlur::apply(uchar *alpha, int w, int h, int radius) -> void
+{
+    if (radius < 1 || w < 1 || h < 1)
+        return;
+    const int r = boxRadius(radius);
+    const int mul = (1 << 16)/(2*r + 1);
+    _Expand(m_line, qMax(w, h));
+    // horizontal: three passes for each row
+    for (int y = 0; y < h; ++y) {
+        auto row = alpha + y*w;
+        auto tmp = m_line.data();
+        boxLine(row, tmp, w, r);
+        boxLine(tmp, row, w, r);
+        boxLine(row, tmp, w, r);
+        memcpy(row, tmp, w);
+    }
+    // vertical: running column sums over whole rows to stay in cache
+    m_sums.resize(w);
+    _Expand(m_line, w*(h + 1));
+    for (int pass = 0; pass < 3; ++pass) {
+        auto sums = m_sums.data();
+        auto out = m_line.data();
+        std::fill_n(sums, w, 0);
+        for (int y = 0; y < r && y < h; ++y) {
+            auto row = alpha + y*w;
+            for (int x = 0; x < w; ++x)
+                sums[x] += row[x];
+        }
+        for (int y = 0; y < h; ++y, out += w) {
+            if (y + r < h) {
+                auto add = alpha + (y + r)*w;
+                for (int x = 0; x < w; ++x)
+                    sums[x] += add[x];
+            }
+            for (int x = 0; x < w; ++x)
+                out[x] = (sums[x]*mul + (1 << 15)) >> 16;
+            if (y - r >= 0) {
+                auto sub = alpha + (y - r)*w;
+                for (int x = 0; x < w; ++x)
+                    sums[x] -= sub[x];
+            }
+        }
+        memcpy(alpha, m_line.data(), w*h);
+    }
+}
+
+// bounding rect of pixels with non-zero alpha
+static auto opaqueRect(const QImage &image) -> QRect
+{
+    int top = -1, bottom = -1, left = image.width(), right = -1;
+    for (int y = 0; y < image.height(); ++y) {
+        auto line = reinterpret_cast<const quint32*>(image.constScanLine(y));
+        int x0 = 0, x1 = image.width() - 1;
+        while (x0 <= x1 && !(line[x0] >> 24))
+            ++x0;
+        if (x0 > x1)
+            continue;
+        while (!(line[x1] >> 24))
+            --x1;
+        if (top < 0)
+            top = y;
+        bottom = y;
+        left = qMin(left, x0);
+        right = qMax(right, x1);
+    }
+    if (top < 0)
+        return QRect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+// dst[i] = color*alpha[i], color is premultiplied
+static auto colorize(quint32 *dst, const uchar *alpha, int count,
+                     const int color[4]) -> void
+{
+    int i = 0;
+#if SUBTITLE_DRAWER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c = _mm_setr_epi16(color[0], color[1], color[2], color[3],
+                                     color[0], color[1], color[2], color[3]);
+    const __m128i round = _mm_set1_epi16(128);
+    auto mul = [&] (__m128i a) {
+        // a holds alpha of two pixels repeated for each channel
+        __m128i x = _mm_add_epi16(_mm_mullo_epi16(a, c), round);
+        return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    };
+    for (; i + 4 <= count; i += 4) {
+        quint32 a4;
+        memcpy(&a4, alpha + i, 4);
+        if (!a4) {
+            _mm_storeu_si128((__m128i*)(dst + i), zero);
+            continue;
+        }
+        // a0 a0 a0 a0 a1 a1 a1 a1 a2 ... as 16-bit
+        __m128i a = _mm_cvtsi32_si128(a4);
+        a = _mm_unpacklo_epi8(a, a);
+        a = _mm_unpacklo_epi16(a, a);
+        const __m128i lo = mul(_mm_unpacklo_epi8(a, zero));
+        const __m128i hi = mul(_mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        const int a = alpha[i];
+        dst[i] = (quint32)div255(color[3]*a) << 24 | div255(color[2]*a) << 16
+                | div255(color[1]*a) << 8 | div255(color[0]*a);
+    }
+}
+
 SubCompImage::SubCompImage(const SubComp *comp, Iterator it, void *creator)
     : m_comp(comp)
     , m_it(it)
@@ -46,12 +186,11 @@ auto SubtitleDrawer::setStyle(const OsdStyle &style) -> void
 {
     m_style = style;
     updateStyle(m_front, style);
-    updateStyle(m_back, style);
     if (style.outline.enabled) {
         const auto size = style.font.height()*style.outline.width*2.0;
-        m_back.setTextOutline(style.outline.color, size);
+        m_outline = QPen(style.outline.color, size);
     } else
-        m_back.setTextOutline(Qt::NoPen);
+        m_outline = Qt::NoPen;
 }
 
 auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
@@ -63,23 +202,21 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
         return bboxes;
     const double scale = this->scale(area)*dpr;
     const double fscale = m_style.font.height()*scale;
-    auto make = [=] (RichTextDocument &doc, const RichTextDocument &from) {
-        doc = from;
-        doc += text;
-        doc.updateLayoutInfo();
-        doc.doLayout(area.width()/(scale/dpr));
-    };
-    RichTextDocument front, back;
-    make(front, m_front);
-    make(back, m_back);
+    RichTextDocument front = m_front;
+    front += text;
+    front.setLayoutCache(&m_layouts);
+    front.updateLayoutInfo();
+    front.doLayout(area.width()/(scale/dpr));
     QPoint thick(0, 0);
     if (m_style.bbox.enabled)
         thick = (fscale*m_style.bbox.padding).toPoint();
     QPoint soffset(0, 0);
-    if (m_style.shadow.enabled)
+    // shader can toggle shadow without redrawing, so always leave room for it
+    if (m_style.shadow.enabled || m_gpu)
         soffset = (fscale*m_style.shadow.offset).toPoint();
     QPoint offset(0, 0);
     const int blur = m_style.shadow.blur ? qRound(fscale*0.01) : 0;
+    const int outline = m_gpu ? outlineRadius(fscale) : 0;
     const auto nsize = front.naturalSize()*scale;
     QSize imageSize(nsize.width() + 1, nsize.height() + 1);
     QPoint pad = soffset;
@@ -91,9 +228,9 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
         pad.ry() = offset.ry() = -soffset.y();
         soffset.ry() = 0;
     }
-    imageSize += {pad.rx() + (blur+thick.x())*2, pad.ry() + (blur+thick.y())*2};
-    const QPoint pblur(blur, blur);
-    offset += pblur;
+    const int margin = blur + outline;
+    imageSize += {pad.rx() + (margin+thick.x())*2, pad.ry() + (margin+thick.y())*2};
+    offset += QPoint(margin, margin);
     offset += thick;
     image = QImage(imageSize, QImage::Format_ARGB32_Premultiplied);
     if (!image.isNull()) {
@@ -104,43 +241,43 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
         QPainter painter(&image);
         painter.translate(origin/dpr);
         painter.scale(scale/dpr, scale/dpr);
-        back.draw(&painter, QPointF(0, 0));
+        // outline is stroked from same glyphs instead of second layout
+        if (!m_gpu && m_outline.style() != Qt::NoPen)
+            front.drawOutline(&painter, QPointF(0, 0), m_outline);
         front.draw(&painter, QPointF(0, 0));
         painter.end();
-        if (m_style.shadow.enabled) {
+        if (m_style.shadow.enabled && !m_gpu) {
             QImage bg(image.size(), QImage::Format_ARGB32_Premultiplied);
             bg.setDevicePixelRatio(dpr);
-            auto dest = bg.bits();
-            const quint32 sr = m_style.shadow.color.red();
-            const quint32 sg = m_style.shadow.color.green();
-            const quint32 sb = m_style.shadow.color.blue();
-            const quint32 sa = m_style.shadow.color.alpha();
-            for (int y=0; y<bg.height(); ++y) {
-                const int ys = y - soffset.y();
-                if (ys < 0) {
-                    memset(dest, 0, bg.bytesPerLine());
-                    dest += bg.bytesPerLine();
-                } else {
-                    auto src = image.bits() + image.bytesPerLine() * ys;
-                    for (int x=0; x<bg.width(); ++x) {
-                        const int xs = x-soffset.x();
-                        if (xs < 0) {
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                        } else {
-                            *dest++ = sb*sa*src[3] >> 16;
-                            *dest++ = sg*sa*src[3] >> 16;
-                            *dest++ = sr*sa*src[3] >> 16;
-                            *dest++ = sa*   src[3] >> 8;
-                            src += 4;
-                        }
-                    }
+            bg.fill(0x0);
+            // only glyphs, shifted and grown by blur, are processed
+            const auto glyphs = opaqueRect(image);
+            const auto area = glyphs.translated(soffset)
+                    .adjusted(-blur, -blur, blur, blur) & bg.rect();
+            if (!area.isEmpty()) {
+                const int w = area.width(), h = area.height();
+                m_buffer.resize(w*h);
+                auto alpha = reinterpret_cast<uchar*>(m_buffer.data());
+                memset(alpha, 0, w*h);
+                const auto src = glyphs & area.translated(-soffset);
+                for (int y = src.top(); y <= src.bottom(); ++y) {
+                    auto line = image.constScanLine(y) + 3;
+                    auto dst = alpha + (y + soffset.y() - area.y())*w
+                            + src.x() + soffset.x() - area.x();
+                    for (int x = src.left(); x <= src.right(); ++x)
+                        *dst++ = line[x << 2];
+                }
+                if (blur)
+                    m_blur.apply(alpha, w, h, blur);
+                const auto &sc = m_style.shadow.color;
+                const int sa = sc.alpha();
+                const int color[4] = { div255(sc.blue()*sa), div255(sc.green()*sa),
+                                       div255(sc.red()*sa), sa };
+                for (int y = 0; y < h; ++y) {
+                    auto dst = reinterpret_cast<quint32*>(bg.scanLine(y + area.y()));
+                    colorize(dst + area.x(), alpha + y*w, w, color);
                 }
             }
-            if (blur)
-                m_blur.applyTo(bg, m_style.shadow.color, blur);
             painter.begin(&bg);
             painter.drawImage(QPoint(0, 0), image);
             painter.end();
@@ -161,3 +298,22 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
     }
     return bboxes;
 }
+
+auto SubtitleDrawer::outlineRadius(double fscale) const -> int
+{
+    return m_style.outline.enabled ? qCeil(fscale*m_style.outline.width) : 0;
+}
+
+auto SubtitleDrawer::needsRedraw(const OsdStyle &style) const -> bool
+{
+    if (!m_gpu)
+        return style != m_style;
+    // colors and shadow toggle are applied by shader
+    auto patch = [] (OsdStyle s) {
+        s.outline.color = Qt::black;
+        s.shadow.color = Qt::black;
+        s.shadow.enabled = true;
+        return s;
+    };
+    return patch(style) != patch(m_style);
+}
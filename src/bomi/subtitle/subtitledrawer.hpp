@@ -11,101 +11,14 @@ struct Margin {
     double top = 0.0, right = 0.0, bottom = 0.0, left = 0.0;
 };
 
+// gaussian blur of an alpha plane approximated by three box passes
+// pixels outside of the plane are treated as transparent
 class FastAlphaBlur {
 public:
-    FastAlphaBlur(): radius(-1) {}
-    // copied from openframeworks superfast blur and modified
-    auto applyTo(QImage &mask, const QColor &color, int radius) -> void {
-        if (radius < 1 || mask.isNull())
-            return;
-        setSize(mask.size());
-        setRadius(radius);
-        const int w = s.width();
-        const int h = s.height();
-
-        uchar *a = valpha.data();
-        const uchar *inv = vinv.constData();
-        int *min = vmin.data();
-        int *max = vmax.data();
-
-        const int xmax = mask.width()-1;
-        for (int x=0; x<w; ++x) {
-            min[x] = qMin(x + radius + 1, xmax);
-            max[x] = qMax(x - radius, 0);
-        }
-
-        const uchar *c_bits = mask.constBits()+3;
-        uchar *it = a;
-        for (int y=0; y<h; ++y, c_bits += (mask.width() << 2)) {
-            int sum = 0;
-            for(int i=-radius; i<=radius; ++i)
-                sum += c_bits[qBound(0, i, xmax) << 2];
-            for (int x=0; x<w; ++x, ++it) {
-                sum += c_bits[min[x] << 2];
-                sum -= c_bits[max[x] << 2];
-                *it = inv[sum];
-            }
-        }
-
-        const int ymax = mask.height()-1;
-        for (int y=0; y<h; ++y){
-            min[y] = qMin(y + radius + 1, ymax)*w;
-            max[y] = qMax(y - radius, 0)*w;
-        }
-
-        uchar *bits = mask.bits();
-        const double r = color.redF();
-        const double g = color.greenF();
-        const double b = color.blueF();
-        const uchar *c_it = a;
-        for (int x=0; x<w; ++x, ++c_it){
-            int sum = 0;
-            int yp = -radius*w;
-            for(int i=-radius; i<=radius; ++i, yp += w)
-                sum += c_it[qMax(0, yp)];
-            uchar *p = bits + (x << 2);
-            for (int y=0; y<h; ++y, p += (xmax << 2)){
-                const uchar a = inv[sum];
-                if (p[3] < 255) {
-                    *p++ = a*b;
-                    *p++ = a*g;
-                    *p++ = a*r;
-                    *p++ = a;
-                } else {
-                    p += 4;
-                }
-                sum += c_it[min[y]];
-                sum -= c_it[max[y]];
-            }
-        }
-    }
-
+    auto apply(uchar *alpha, int width, int height, int radius) -> void;
 private:
-    auto setSize(const QSize &size) -> void {
-        if (size != s) {
-            s = size;
-            if (!s.isEmpty()) {
-                vmin.resize(qMax(s.width(), s.height()));
-                vmax.resize(vmin.size());
-                valpha.resize(s.width()*s.height());
-            }
-        }
-    }
-    auto setRadius(const int radius) -> void {
-        if (this->radius != radius) {
-            this->radius = radius;
-            if (radius > 0) {
-                const int range = (radius << 1) + 1;
-                vinv.resize(range << 8);
-                for (int i=0; i<vinv.size(); ++i)
-                    vinv[i] = i/range;
-            }
-        }
-    }
-    int radius;
-    QSize s;
-    QVector<int> vmin, vmax;
-    QVector<uchar> valpha, vinv;
+    QVector<uchar> m_line;
+    QVector<int> m_sums;
 };
 
 class SubCompImage : public QImage {
@@ -121,6 +34,8 @@ public:
     auto creator() const -> void* { return m_creator; }
     auto boundingBoxes() const -> const QVector<QRectF>& { return m_bboxes; }
     auto gap() const -> int { return m_gap; }
+    // font scale in pixels which image has been rasterized at
+    auto scale() const -> double { return m_scale; }
 private:
     friend class SubtitleDrawer;
     const SubComp *m_comp = nullptr;
@@ -128,6 +43,7 @@ private:
     RichTextDocument m_text;
     QVector<QRectF> m_bboxes;
     int m_gap = 0;
+    double m_scale = 0.0;
     void *m_creator = nullptr;
 };
 
@@ -145,28 +61,38 @@ public:
     auto margin() const -> const Margin& { return m_margin; }
     auto style() const -> const OsdStyle& {return m_style;}
     auto scale(const QRectF &area) const -> double;
+    // draw only the text and leave outline and shadow to the shader
+    // image gets padded by outlineRadius() on top of shadow blur in draw()
+    auto setGpuEffects(bool on) -> void { m_gpu = on; }
+    auto hasGpuEffects() const -> bool { return m_gpu; }
+    // whether changing to style requires images to be drawn again
+    auto needsRedraw(const OsdStyle &style) const -> bool;
+    // outline radius in pixels for given font scale
+    auto outlineRadius(double fscale) const -> int;
 private:
     static auto updateStyle(RichTextDocument &doc,
                             const OsdStyle &style) -> void;
     OsdStyle m_style;
-    RichTextDocument m_front, m_back;
+    RichTextDocument m_front;
+    RichTextDocument::LayoutCache m_layouts;
+    QPen m_outline = Qt::NoPen;
     Margin m_margin;
     Qt::Alignment m_alignment;
-    bool m_drawn = false;
+    bool m_drawn = false, m_gpu = false;
     FastAlphaBlur m_blur;
     QByteArray m_buffer;
 };
 
 inline auto SubtitleDrawer::setAlignment(Qt::Alignment alignment) -> void
 {
-    m_back.setAlignment(m_alignment = alignment);
-    m_front.setAlignment(alignment);
+    m_front.setAlignment(m_alignment = alignment);
 }
 
 inline auto SubtitleDrawer::draw(SubCompImage &pic, const QRectF &area,
                                  double dpr) -> bool
 {
     pic.m_bboxes = draw(pic, pic.m_gap, pic.m_text, area, dpr);
+    pic.m_scale = scale(area)*dpr;
     return !pic.isNull();
 }
 
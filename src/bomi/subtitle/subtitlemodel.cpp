@@ -1,51 +1,263 @@
 #include "subtitlemodel.hpp"
 #include "misc/matchstring.hpp"
+#include "misc/matchindex.hpp"
+#include "misc/dataevent.hpp"
 #include <QScrollBar>
-#include <QSortFilterProxyModel>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QThreadPool>
+
+// ms spent on scanning per event loop iteration
+static constexpr int ScanBudget = 8;
+
+enum EventType { Indexed = QEvent::User + 1, Filtered };
 
 SIA operator < (int lhs, const SubCompModelData &rhs) -> bool
 {
     return lhs < rhs.start();
 }
 
+SIA operator < (const SubCompModelData &lhs, int rhs) -> bool
+{
+    return lhs.start() < rhs;
+}
+
+using SearchIndex = QSharedPointer<const MatchIndex>;
+
+// builds index of scanned captions, then filters by it
+// candidates are narrowed results of previous query, which is extended
+class SearchJob : public QRunnable {
+public:
+    SearchJob(QObject *model, int serial, const QStringList &texts)
+        : m_model(model), m_serial(serial), m_texts(texts) { }
+    SearchJob(QObject *model, int serial, const SearchIndex &index,
+              const MatchString &caption, const QVector<int> &candidates,
+              bool narrow, const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_model(model), m_serial(serial), m_index(index), m_caption(caption)
+        , m_candidates(candidates), m_narrow(narrow), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        if (!m_index) {
+            _PostEvent(m_model, Indexed, m_serial,
+                       SearchIndex(new MatchIndex(m_texts)));
+            return;
+        }
+        auto matched = m_index->find(m_caption, m_narrow ? &m_candidates : nullptr,
+                                     m_cancel.data());
+        if (!*m_cancel)
+            _PostEvent(m_model, Filtered, m_serial, m_caption, matched);
+    }
+private:
+    QObject *m_model = nullptr;
+    int m_serial = 0;
+    QStringList m_texts;
+    SearchIndex m_index;
+    MatchString m_caption;
+    QVector<int> m_candidates;
+    bool m_narrow = false;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
 struct SubCompModel::Data {
+    SubCompModel *p = nullptr;
     bool visible = false, ms = false, fps = false;
     QString name;
+    // own copy keeps iterators of rows valid
+    SubComp comp;
+    SubCompIndex index;
+    int next = 0, time = -1;
+    double mul = 1.0;
+    QTimer scanner;
+    int start = -1, end = -1;
+    MatchString caption;
+    // every caption with words, filled once per component by scanner
+    QList<SubCompModelData> all;
+    QStringList texts;
+    // serial tells results for current component and query
+    int serial = 0;
+    SearchIndex search;
+    MatchString matchedCaption;
+    QVector<int> matched;
+    bool hasMatched = false;
+    QSharedPointer<std::atomic<bool>> cancel;
+    QThreadPool pool;
+    auto filtered() const -> bool
+        { return !caption.string().isEmpty() && caption.isValid(); }
+    auto accepts(const SubCompModelData &data) const -> bool
+    {
+        if (start >= 0 && data.start() < start)
+            return false;
+        if (end >= 0 && data.start() > end)
+            return false;
+        if (!filtered())
+            return true;
+        return caption.contains(data.text());
+    }
+    auto cancelSearch() -> void
+    {
+        if (cancel)
+            *cancel = true;
+        cancel.reset();
+        pool.clear();
+        ++serial;
+    }
+    // positions of all which are in time range of filter
+    auto range() const -> std::pair<int, int>
+    {
+        auto first = all.begin(), last = all.end();
+        if (start >= 0)
+            first = std::lower_bound(all.begin(), all.end(), start);
+        if (end >= 0)
+            last = std::upper_bound(first, all.end(), end);
+        return { first - all.begin(), last - all.begin() };
+    }
+    auto apply() -> void
+    {
+        const auto r = range();
+        QList<SubCompModelData> rows;
+        if (!filtered()) {
+            rows = all.mid(r.first, r.second - r.first);
+        } else {
+            Q_ASSERT(hasMatched);
+            auto it = std::lower_bound(matched.begin(), matched.end(), r.first);
+            for (; it != matched.end() && *it < r.second; ++it)
+                rows.push_back(all[*it]);
+        }
+        p->setList(rows);
+        if (time >= 0)
+            p->setCurrentCaption(time);
+    }
+    auto research() -> void
+    {
+        cancelSearch();
+        if (!filtered() || (hasMatched && matchedCaption == caption)) {
+            apply();
+            return;
+        }
+        const bool narrow = hasMatched && MatchIndex::narrows(matchedCaption, caption);
+        cancel.reset(new std::atomic<bool>(false));
+        pool.start(new SearchJob(p, serial, search, caption, matched, narrow, cancel));
+    }
 };
 
 SubCompModel::SubCompModel(QObject *parent)
     : Super(ColumnCount, parent)
     , d(new Data)
 {
+    d->p = this;
+    d->pool.setMaxThreadCount(1);
     QFont font; font.setBold(true); font.setItalic(true);
     setSpecialFont(font);
+    d->scanner.setInterval(0);
+    connect(&d->scanner, &QTimer::timeout, this, [=] () { scan(); });
+}
+
+SubCompModel::~SubCompModel()
+{
+    d->cancelSearch();
+    d->pool.waitForDone();
+    delete d;
 }
 
 auto SubCompModel::setComponent(const SubComp &comp) -> void
 {
     d->name = comp.name();
     d->fps = comp.isBasedOnFrame();
+    d->comp = comp;
+    d->index = SubCompIndex(&d->comp);
+    restart();
+}
 
-    auto it = comp.begin();
-    QList<SubCompModelData> list;
-    for (; it != comp.end(); ++it) {
-        if (it->hasWords()) {
-            it->index = 0;
-            list.append(it);
-            break;
-        }
+auto SubCompModel::setFilter(int start, int end, const MatchString &caption) -> void
+{
+    d->start = start;
+    d->end = end;
+    d->caption = caption;
+    if (d->search) {
+        d->research();
+        return;
     }
-    if (!list.isEmpty()) {
-        for (++it; it != comp.end(); ++it) {
-            auto &last = list.last();
-            if (last.m_end < 0)
-                last.m_end = it.key();
-            if (it->hasWords())
-                list.append(it);
-            it->index = list.size() - 1;
-        }
+    // index is not ready, so test scanned rows and keep scanning
+    QList<SubCompModelData> rows;
+    for (auto &data : d->all) {
+        if (d->accepts(data))
+            rows.push_back(data);
+    }
+    setList(rows);
+    if (d->time >= 0)
+        setCurrentCaption(d->time);
+}
+
+auto SubCompModel::isScanning() const -> bool
+{
+    return d->scanner.isActive() || d->cancel;
+}
+
+auto SubCompModel::restart() -> void
+{
+    d->cancelSearch();
+    d->search.reset();
+    d->hasMatched = false;
+    d->matched.clear();
+    d->all.clear();
+    d->texts.clear();
+    setList(QList<SubCompModelData>());
+    d->next = 0;
+    d->scanner.start();
+    scan();
+}
+
+auto SubCompModel::scan() -> void
+{
+    QElapsedTimer timer;
+    timer.start();
+    QList<SubCompModelData> rows;
+    const auto &index = d->index;
+    for (; d->next < index.size() && timer.elapsed() < ScanBudget; ++d->next) {
+        const auto it = index.iterator(d->next);
+        if (!it->hasWords())
+            continue;
+        const int i = d->next + 1;
+        SubCompModelData data(it, i < index.size() ? index.iterator(i).key() : -1);
+        data.m_mul = d->mul;
+        d->texts.push_back(data.text());
+        d->all.push_back(data);
+        if (d->accepts(data))
+            rows.append(data);
+    }
+    append(rows);
+    if (d->next >= index.size()) {
+        d->scanner.stop();
+        d->pool.start(new SearchJob(this, d->serial, d->texts));
+        d->texts.clear();
+    }
+    if (!rows.isEmpty() && d->time >= 0)
+        setCurrentCaption(d->time);
+}
+
+auto SubCompModel::customEvent(QEvent *event) -> void
+{
+    switch (static_cast<int>(event->type())) {
+    case Indexed: {
+        int serial = 0; SearchIndex search;
+        _TakeData(event, serial, search);
+        if (serial == d->serial)
+            d->search = search;
+        break;
+    } case Filtered: {
+        int serial = 0; MatchString caption; QVector<int> matched;
+        _TakeData(event, serial, caption, matched);
+        if (serial != d->serial)
+            break;
+        d->cancel.reset();
+        d->matchedCaption = caption;
+        d->matched = matched;
+        d->hasMatched = true;
+        d->apply();
+        break;
+    } default:
+        break;
     }
-    setList(list);
 }
 
 auto SubCompModel::header(int column) const -> QString
@@ -86,10 +298,17 @@ auto SubCompModel::name() const -> QString
 auto SubCompModel::setFps(double fps) -> void
 {
     if (d->fps) {
+        d->mul = 1000.0/fps;
+        // time range of filter depends on fps
+        if (d->start >= 0 || d->end >= 0) {
+            restart();
+            return;
+        }
         beginResetModel();
-        const auto mul = 1000.0/fps;
         for (auto &data : getList())
-            data.m_mul = mul;
+            data.m_mul = d->mul;
+        for (auto &data : d->all)
+            data.m_mul = d->mul;
         endResetModel();
     }
 }
@@ -102,33 +321,16 @@ auto SubCompModel::setVisible(bool visible) -> void
 
 auto SubCompModel::setCurrentCaption(int time) -> void
 {
+    d->time = time;
     auto &l = this->list();
     setSpecialRow((std::upper_bound(l.begin(), l.end(), time) - l.begin()) - 1);
 }
 
 /******************************************************************************/
 
-class SubCompFilterModel : public QSortFilterProxyModel {
-    auto filterAcceptsRow(int srow, const QModelIndex &) const -> bool final
-    {
-        auto m = static_cast<SubCompModel*>(sourceModel());
-        if (start >= 0 && m->at(srow).start() < start)
-            return false;
-        if (end >= 0 && m->at(srow).start() > end)
-            return false;
-        if (caption.string().isEmpty() || !caption.isValid())
-            return true;
-        return caption.contains(m->at(srow).text());
-    }
-public:
-    int start = -1, end = -1;
-    MatchString caption;
-};
-
 struct SubCompView::Data {
     SubCompView *p = nullptr;
     SubCompModel *model = nullptr;
-    SubCompFilterModel proxy;
     bool autoScroll = false;
     bool ms = false, time = true;
     auto updateHeader()
@@ -149,8 +351,9 @@ SubCompView::SubCompView(QWidget *parent)
     setRootIsDecorated(false);
     setHorizontalScrollMode(ScrollPerPixel);
     setAutoScroll(false);
+    // row heights are never measured row by row
+    setUniformRowHeights(true);
     d->updateHeader();
-    QTreeView::setModel(&d->proxy);
 }
 
 auto SubCompView::adjustColumns() -> void
@@ -161,7 +364,7 @@ auto SubCompView::adjustColumns() -> void
 
 auto SubCompView::setModelToNull() -> void
 {
-    d->proxy.setSourceModel(nullptr);
+    d->model = nullptr;
 }
 
 auto SubCompView::setModel(QAbstractItemModel *model) -> void
@@ -169,7 +372,7 @@ auto SubCompView::setModel(QAbstractItemModel *model) -> void
     if (d->model)
         d->model->disconnect(this);
     d->model = dynamic_cast<SubCompModel*>(model);
-    d->proxy.setSourceModel(d->model);
+    QTreeView::setModel(d->model);
     if (d->model) {
         d->model->setTimeInMilliseconds(d->ms);
         d->model->setVisible(isVisible());
@@ -184,10 +387,7 @@ auto SubCompView::updateCurrentRow(int row) -> void
 {
     if (!d->model || !d->autoScroll)
         return;
-    auto m = static_cast<SubCompModel*>(d->proxy.sourceModel());
-    if (!m)
-        return;
-    const QModelIndex idx = d->proxy.mapFromSource(m->index(row, SubCompModel::Text));
+    const QModelIndex idx = d->model->index(row, SubCompModel::Text);
     if (idx.isValid()) {
         auto h = horizontalScrollBar();
         const int prev = h->value();
@@ -227,10 +427,8 @@ auto SubCompView::hideEvent(QHideEvent *event) -> void
 
 auto SubCompView::setFilter(int start, int end, const MatchString &caption) -> void
 {
-    d->proxy.start = start;
-    d->proxy.end = end;
-    d->proxy.caption = caption;
-    d->proxy.invalidate();
+    if (d->model)
+        d->model->setFilter(start, end, caption);
 }
 
 auto SubCompView::setTimeInMilliseconds(bool ms) -> void
@@ -7,17 +7,22 @@
 
 class MatchString;
 
+// text is materialized when the row is shown or searched first
 struct SubCompModelData {
     SubCompModelData() = default;
-    SubCompModelData(SubComp::const_iterator it)
-        : m_start(it.key()), m_end(-1), m_text(it->toPlainText()) {}
+    SubCompModelData(SubComp::const_iterator it, int end)
+        : m_it(it), m_start(it.key()), m_end(end) {}
     auto start() const -> int { return m_start * m_mul; }
     auto end() const -> int { return m_end * m_mul; }
-    auto text() const -> QString { return m_text; }
+    auto text() const -> QString
+        { if (m_text.isNull()) m_text = m_it->toPlainText(); return m_text; }
+    auto operator == (const SubCompModelData &rhs) const -> bool
+        { return m_start == rhs.m_start && m_end == rhs.m_end && m_mul == rhs.m_mul; }
 private:
+    SubComp::const_iterator m_it;
     int m_start = -1, m_end = -1;
     double m_mul = 1.0;
-    QString m_text;
+    mutable QString m_text;
     friend class SubCompModel;
 };
 
@@ -26,13 +31,21 @@ class SubCompModel : public SimpleListModel<SubCompModelData> {
 public:
     enum Column {Start = 0, End, Text, ColumnCount};
     SubCompModel(QObject *parent = 0);
+    ~SubCompModel();
     auto name() const -> QString;
     auto setFps(double fps) -> void;
     auto setCurrentCaption(int time) -> void;
     auto setVisible(bool visible) -> void;
     auto setTimeInMilliseconds(bool ms) -> void;
     auto setComponent(const SubComp &comp) -> void;
+    // rows are filled in slices on idle, so matches stream in
+    // after that, captions are searched by index in background
+    auto setFilter(int start, int end, const MatchString &caption) -> void;
+    auto isScanning() const -> bool;
 private:
+    auto scan() -> void;
+    auto restart() -> void;
+    auto customEvent(QEvent *event) -> void final;
     auto header(int column) const -> QString final;
     auto displayData(int row, int column) const -> QVariant final;
     struct Data;
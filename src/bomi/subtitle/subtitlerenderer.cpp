@@ -4,10 +4,18 @@
 #include "enum/autoselectmode.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglpixelbufferring.hpp"
+#include "video/rendertiming.hpp"
+#include <QVector2D>
 
 struct SubtitleShaderData : public SubtitleRenderer::ShaderData {
-    const OpenGLTexture2D *texture, *bbox;
+    const OpenGLTexture2D *texture;
     QColor bboxColor;
+    // effects in pixels, outline radius of 0 means no outline
+    bool effects = false;
+    QColor outlineColor, shadowColor;
+    float outline = 0.f, blur = 0.f;
+    QPointF shadowOffset;
 };
 
 struct SubtitleShader : public SubtitleRenderer::ShaderIface {
@@ -25,33 +33,87 @@ struct SubtitleShader : public SubtitleRenderer::ShaderIface {
         )";
         fragmentShader = (R"(
             uniform sampler2D tex;
-            uniform sampler2D bbox;
             uniform vec4 bboxColor;
+            uniform float effects;
+            uniform vec2 texel;
+            uniform float outline, blur;
+            uniform vec4 outlineColor, shadowColor;
+            uniform vec2 shadowOffset;
             varying vec2 texCoord;
+            // max of alpha in disc of radius r, sampled on two rings
+            float dilate(vec2 uv, float r) {
+                float a = texture2D(tex, uv).a;
+                if (r <= 0.0)
+                    return a;
+                for (int i = 0; i < 12; ++i) {
+                    float t = float(i)*0.52359877559;
+                    vec2 d = vec2(cos(t), sin(t))*texel*r;
+                    a = max(a, texture2D(tex, uv + d).a);
+                    a = max(a, texture2D(tex, uv + d*0.5).a);
+                }
+                return a;
+            }
+            vec4 under(vec4 top, vec4 color, float a) {
+                return top + vec4(color.rgb, 1.0)*(color.a*a*(1.0 - top.a));
+            }
             void main() {
+                // bounding boxes are quads drawn before caption quad
+                if (texCoord.x < 0.0) {
+                    gl_FragColor = vec4(bboxColor.rgb, 1.0)*bboxColor.a;
+                    return;
+                }
                 vec4 top = texture2D(tex, texCoord);
-                float alpha = texture2D(bbox, texCoord).a*bboxColor.a*(1.0 - top.a);
-                gl_FragColor = top + bboxColor*alpha;
+                if (effects > 0.5) {
+                    if (outline > 0.0)
+                        top = under(top, outlineColor, dilate(texCoord, outline));
+                    if (shadowColor.a > 0.0) {
+                        vec2 uv = texCoord - shadowOffset*texel;
+                        float a = dilate(uv, outline);
+                        // soft edge from a wider ring instead of gaussian
+                        if (blur > 0.0)
+                            a = 0.5*(a + dilate(uv, outline + blur*2.0));
+                        top = under(top, shadowColor, a);
+                    }
+                }
+                gl_FragColor = top;
             }
         )");
         attributes << "aPosition" << "aTexCoord";
     }
     void resolve(QOpenGLShaderProgram *prog) override {
         loc_tex = prog->uniformLocation("tex");
-        loc_bbox = prog->uniformLocation("bbox");
         loc_bboxColor = prog->uniformLocation("bboxColor");
+        loc_effects = prog->uniformLocation("effects");
+        loc_texel = prog->uniformLocation("texel");
+        loc_outline = prog->uniformLocation("outline");
+        loc_blur = prog->uniformLocation("blur");
+        loc_outlineColor = prog->uniformLocation("outlineColor");
+        loc_shadowColor = prog->uniformLocation("shadowColor");
+        loc_shadowOffset = prog->uniformLocation("shadowOffset");
     }
     void update(QOpenGLShaderProgram *prog,
                 SubtitleRenderer::ShaderData *data) override {
         auto d = static_cast<const SubtitleShaderData*>(data);
         auto f = func();
         d->texture->bind(prog, loc_tex, 0);
-        d->bbox->bind(prog, loc_bbox, 1);
         prog->setUniformValue(loc_bboxColor, d->bboxColor);
+        prog->setUniformValue(loc_effects, d->effects ? 1.f : 0.f);
+        if (d->effects) {
+            const auto w = qMax(1, d->texture->width());
+            const auto h = qMax(1, d->texture->height());
+            prog->setUniformValue(loc_texel, QVector2D(1.f/w, 1.f/h));
+            prog->setUniformValue(loc_outline, d->outline);
+            prog->setUniformValue(loc_blur, d->blur);
+            prog->setUniformValue(loc_outlineColor, d->outlineColor);
+            prog->setUniformValue(loc_shadowColor, d->shadowColor);
+            prog->setUniformValue(loc_shadowOffset, d->shadowOffset);
+        }
         f->glActiveTexture(GL_TEXTURE0);
     }
 private:
-    int loc_tex = -1, loc_bbox = -1, loc_bboxColor = -1;
+    int loc_tex = -1, loc_bboxColor = -1, loc_effects = -1;
+    int loc_texel = -1, loc_outline = -1, loc_blur = -1;
+    int loc_outlineColor = -1, loc_shadowColor = -1, loc_shadowOffset = -1;
 };
 
 struct SubtitleRenderer::Data {
@@ -59,7 +121,16 @@ struct SubtitleRenderer::Data {
     SubtitleRenderer *p = nullptr;
     QList<SubComp*> loaded;
     QSize imageSize{0, 0};
+    // font scale which images have been drawn at
+    double imageScale = 0.0;
+    // images are scaled to current size until drawn again for it
+    auto displayScale() const -> double
+    {
+        const double s = drawer.scale(p->rect())*p->devicePixelRatio();
+        return imageScale > 0.0 ? s/imageScale : 1.0;
+    }
     SubtitleDrawer drawer;
+    RenderTiming *timing = nullptr;
     int delay = 0, msec = 0, lastTime = -1;
     bool selecting = false, textChanged = true;
     bool top = false, hidden = false, empty = true;
@@ -72,9 +143,17 @@ struct SubtitleRenderer::Data {
 //        return langMap.value(r->comp->language().id(), -1);
         return langMap.value(comp.language(), -1);
     }
-    QVector<quint32> zeros, bboxData;
+    // texture is atlas which only grows, and areas of last captions
+    // are cleared when next ones are uploaded
+    QVector<quint32> zeros;
+    QSize atlas{0, 0};
+    QRegion drawn;
+    OpenGLPixelBufferRing pbo;
+    // bounding boxes in pixels of image, drawn as geometry
+    QVector<QRectF> boxes;
     SubCompSelection selection{p};
-    OpenGLTexture2D bbox;
+    // boundaries of selected components for start() and finish()
+    SubCompTimeline timeline;
 
     auto find(int id) const -> SubComp*
     {
@@ -100,6 +179,9 @@ struct SubtitleRenderer::Data {
         p->reserve(UpdateGeometry);
     }
     void applySelection() {
+        QVector<const SubComp*> comps;
+        selection.forComponents([&] (const SubComp &comp) { comps.push_back(&comp); });
+        timeline = SubCompTimeline(comps, fps());
         empty = selection.isEmpty();
         emit p->selectionChanged();
         if (!empty)
@@ -155,13 +237,15 @@ auto SubtitleRenderer::initializeGL() -> void
 {
     SimpleTextureItem::initializeGL();
     texture().create();
-    d->bbox.create();
+    d->pbo.create();
+    d->atlas = {0, 0};
+    d->drawn = QRegion();
 }
 
 auto SubtitleRenderer::finalizeGL() -> void
 {
     SimpleTextureItem::finalizeGL();
-    d->bbox.destroy();
+    d->pbo.destroy();
     texture().destroy();
 }
 
@@ -185,8 +269,21 @@ auto SubtitleRenderer::setPriority(const QStringList &priority) -> void
 
 auto SubtitleRenderer::setStyle(const OsdStyle &style) -> void
 {
+    const bool redraw = d->drawer.needsRedraw(style);
     d->drawer.setStyle(style);
+    if (redraw)
+        d->updateDrawer();
+    else
+        reserve(UpdateMaterial);
+}
+
+auto SubtitleRenderer::setGpuEffects(bool on) -> void
+{
+    if (d->drawer.hasGpuEffects() == on)
+        return;
+    d->drawer.setGpuEffects(on);
     d->updateDrawer();
+    reserve(UpdateMaterial);
 }
 
 auto SubtitleRenderer::draw(const QRectF &rect, QRectF *put) const -> QImage
@@ -194,7 +291,10 @@ auto SubtitleRenderer::draw(const QRectF &rect, QRectF *put) const -> QImage
     if (d->hidden)
         return QImage();
     QImage sub; int gap = 0;
-    auto boxes = d->drawer.draw(sub, gap, text(), rect, 1.0);
+    // snapshots never pass through shader
+    auto drawer = d->drawer;
+    drawer.setGpuEffects(false);
+    auto boxes = drawer.draw(sub, gap, text(), rect, 1.0);
     if (sub.isNull())
         return QImage();
     if (put)
@@ -262,6 +362,7 @@ auto SubtitleRenderer::style() const -> const OsdStyle&
 auto SubtitleRenderer::unload() -> void
 {
     d->selection.clear();
+    d->timeline = SubCompTimeline();
     qDeleteAll(d->loaded);
     d->loaded.clear();
     setVisible(false);
@@ -270,34 +371,77 @@ auto SubtitleRenderer::unload() -> void
     emit selectionChanged();
 }
 
+auto SubtitleRenderer::vertexCount() const -> int
+{
+    return (d->boxes.size() + 1) * 6;
+}
+
 auto SubtitleRenderer::updateVertex(Vertex *vertex) -> void
 {
-    const auto dpr = devicePixelRatio();
-    const QRectF r(d->drawer. pos(d->imageSize/dpr, rect()), d->imageSize/dpr);
-    OGL::CoordAttr::fillTriangleStrip(vertex, &Vertex::position,
-                                      r.topLeft(), r.bottomRight());
+    const auto scale = d->displayScale()/devicePixelRatio();
+    const QSizeF size = QSizeF(d->imageSize)*scale;
+    const QRectF r(d->drawer.pos(size, rect()), size);
+    // negative texture coordinates select box color in shader
+    for (auto &box : d->boxes) {
+        const QRectF b(r.topLeft() + box.topLeft()*scale, box.size()*scale);
+        vertex = Vertex::fillAsTriangles(vertex, b.topLeft(), b.bottomRight(),
+                                         {-1, -1}, {-1, -1});
+    }
+    const QPointF tbr(d->imageSize.width()/qMax(1.0, (double)d->atlas.width()),
+                      d->imageSize.height()/qMax(1.0, (double)d->atlas.height()));
+    Vertex::fillAsTriangles(vertex, r.topLeft(), r.bottomRight(), {0, 0}, tbr);
 }
 
 auto SubtitleRenderer::createData() const -> ShaderData*
 {
     auto data = new SubtitleShaderData;
     data->texture = &texture();
-    data->bbox = &d->bbox;
     return data;
 }
 
+auto SubtitleRenderer::setRenderTiming(RenderTiming *timing) -> void
+{
+    d->timing = timing;
+}
+
+auto SubtitleRenderer::setCacheLimit(int ms, int megabytes) -> void
+{
+    d->selection.setCacheLimit(ms, qint64(megabytes) << 20);
+}
+
 auto SubtitleRenderer::updateData(ShaderData *sd) -> void
 {
     auto data = static_cast<SubtitleShaderData*>(sd);
+    RenderTimingScope scope(d->timing, RenderTiming::Subtitle);
     updateTexture(&texture());
-    data->bboxColor = d->drawer.style().bbox.color;
+    const auto &style = d->drawer.style();
+    data->bboxColor = style.bbox.color;
+    data->effects = d->drawer.hasGpuEffects();
+    if (data->effects) {
+        // same metrics as SubtitleDrawer::draw()
+        // in pixels of texture, which can differ from size on screen
+        const double fscale = style.font.height() * (d->imageScale > 0.0 ? d->imageScale
+                : d->drawer.scale(geometry()) * devicePixelRatio());
+        data->outline = d->drawer.outlineRadius(fscale);
+        data->outlineColor = style.outline.color;
+        data->shadowColor = style.shadow.enabled ? style.shadow.color
+                                                 : QColor(Qt::transparent);
+        data->shadowOffset = (fscale*style.shadow.offset).toPoint();
+        data->blur = style.shadow.blur ? qRound(fscale*0.01) : 0;
+    }
 }
 
 auto SubtitleRenderer::updateTexture(OpenGLTexture2D *texture) -> void
 {
     d->imageSize = {0, 0};
-    const int spacing = d->drawer.style().font.height()
-            * d->drawer.scale(geometry())
+    d->imageScale = 0.0;
+    d->selection.forImages([&] (const SubCompImage &image) {
+        if (!image.isNull() && d->imageScale <= 0.0)
+            d->imageScale = image.scale();
+    });
+    const double scale = d->imageScale > 0.0 ? d->imageScale/devicePixelRatio()
+                                             : d->drawer.scale(geometry());
+    const int spacing = d->drawer.style().font.height() * scale
             * d->drawer.style().spacing.paragraph + 0.5;
     int lastTime = -1;
     d->selection.forImages([&] (const SubCompImage &image) {
@@ -309,29 +453,50 @@ auto SubtitleRenderer::updateTexture(OpenGLTexture2D *texture) -> void
     });
     d->imageSize.rheight() -= spacing;
     if (!d->imageSize.isEmpty()) {
-        const auto len = d->imageSize.width()*d->imageSize.height();
-        _Expand(d->zeros, len);
-        OpenGLTextureBinder<OGL::Target2D> binder;
-        binder.bind(texture);
-        texture->initialize(d->imageSize, d->zeros.data());
-        binder.bind(&d->bbox);
-        d->bbox.initialize(d->imageSize, d->zeros.data());
-        int y = 0;
+        OpenGLTextureBinder<OGL::Target2D> binder(texture);
+        const auto need = d->imageSize;
+        if (d->atlas.width() < need.width() || d->atlas.height() < need.height()) {
+            // grow by half at least so that next captions fit mostly
+            auto grow = [] (int has, int need)
+                { return has < need ? qMax(need, has + has/2) : has; };
+            d->atlas = { grow(d->atlas.width(), need.width()),
+                         grow(d->atlas.height(), need.height()) };
+            _Expand(d->zeros, d->atlas.width()*d->atlas.height());
+            texture->initialize(d->atlas, d->zeros.data());
+            d->drawn = QRegion();
+        }
+        struct Part { QRect rect; const void *data; };
+        QVector<Part> parts;
+        QRegion drawn;
+        int bytes = 0, y = 0;
+        d->boxes.clear();
         d->selection.forImages([&] (const SubCompImage &image) {
-            const int x = (texture->width() - image.width())*0.5;
+            const int x = (d->imageSize.width() - image.width())*0.5;
             if (!image.isNull()) {
-                binder.bind(texture);
-                texture->upload(x, y, image.width(), image.height(), image.bits());
-                binder.bind(&d->bbox);
-                for (auto &bbox : image.boundingBoxes()) {
-                    const auto rect = bbox.toRect().translated(x, y);
-                    if (_Expand(d->bboxData, rect.width()*rect.height()))
-                        d->bboxData.fill(_Max<quint32>());
-                    d->bbox.upload(rect, d->bboxData.data());
-                }
+                const QRect rect(x, y, image.width(), image.height());
+                parts.push_back({rect, image.bits()});
+                bytes += image.byteCount();
+                drawn += rect;
+                for (auto &bbox : image.boundingBoxes())
+                    d->boxes.push_back(bbox.translated(x, y));
             }
             y += image.height() + spacing;
         });
+        // only what is left from last captions should be cleared
+        for (auto &rect : (d->drawn - drawn).rects()) {
+            _Expand(d->zeros, rect.width()*rect.height());
+            texture->upload(rect, d->zeros.data());
+        }
+        // staged in pbo, so upload returns before gpu copies pixels
+        if (d->pbo.map(bytes)) {
+            for (auto &part : parts)
+                part.data = d->pbo.write(part.data, part.rect.width()*part.rect.height()*4);
+            d->pbo.unmap();
+        }
+        for (auto &part : parts)
+            texture->upload(part.rect, part.data);
+        d->pbo.release();
+        d->drawn = drawn;
         reserve(UpdateGeometry, false);
     }
     if (_Change(d->lastTime, lastTime))
@@ -390,6 +555,7 @@ auto SubtitleRenderer::setHidden(bool hidden) -> void
 auto SubtitleRenderer::setFPS(double fps) -> void
 {
     d->selection.setFPS(fps);
+    d->timeline.setFps(d->fps());
 }
 
 auto SubtitleRenderer::fps() const -> double
@@ -457,26 +623,12 @@ auto SubtitleRenderer::lastUpdatedTime() const -> int
 
 auto SubtitleRenderer::start(int time) const -> int
 {
-    int ret = -1;
-    d->selection.forComponents([this, time, &ret] (const SubComp &comp) {
-        const auto it = comp.start(time - d->delay, d->fps());
-        if (it != comp.end())
-            ret = qMax(ret, comp.isBasedOnFrame() ? comp.msec(it.key(), d->fps()) : it.key());
-    });
-    return ret;
+    return d->timeline.start(time - d->delay);
 }
 
 auto SubtitleRenderer::finish(int time) const -> int
 {
-    int ret = -1;
-    d->selection.forComponents([this, time, &ret] (const SubComp &comp) {
-        const auto it = comp.finish(time - d->delay, d->fps());
-        if (it != comp.end()) {
-            const int t = comp.isBasedOnFrame() ? comp.msec(it.key(), d->fps()) : it.key();
-            ret = ret == -1 ? t : qMin(ret, t);
-        }
-    });
-    return ret;
+    return d->timeline.finish(time - d->delay);
 }
 
 static bool updateIfEarlier(SubComp::ConstIt it, int &time) {
@@ -5,7 +5,7 @@
 #include "player/streamtrack.hpp"
 
 class SubComp;                          class Subtitle;
-class RichTextDocument;
+class RichTextDocument;                 class RenderTiming;
 struct OsdStyle;                        class SubtitleDrawer;
 enum class AutoselectMode;
 
@@ -38,6 +38,8 @@ public:
     auto deselect(int id = -1) -> void;
     auto style() const -> const OsdStyle&;
     auto setStyle(const OsdStyle &style) -> void;
+    // composite outline and shadow in shader instead of drawing them
+    auto setGpuEffects(bool on) -> void;
     auto text() const -> const RichTextDocument&;
     auto draw(const QRectF &rect, QRectF *put = nullptr) const -> QImage;
     auto updateVertexOnGeometryChanged() const -> bool override { return true; }
@@ -47,6 +49,9 @@ public:
     auto setFPS(double fps) -> void;
     auto toTrackList() const -> StreamList;
     auto lastUpdatedTime() const -> int;
+    auto setRenderTiming(RenderTiming *timing) -> void;
+    // look-ahead of prepared captions per component
+    auto setCacheLimit(int ms, int megabytes) -> void;
 //    auto load(const QVector<StreamTrack> &tracks) -> void;
 signals:
     void updated(int time);
@@ -63,6 +68,8 @@ private:
     auto type() const -> Type* override { static Type type; return &type; }
     auto updateTexture(OpenGLTexture2D *texture) -> void override;
     auto updateData(ShaderData *data) -> void override;
+    auto drawingMode() const -> GLenum override { return GL_TRIANGLES; }
+    auto vertexCount() const -> int override;
     auto updateVertex(Vertex *vertex) -> void override;
     struct Data; Data *d;
     friend class SubtitleRendererShader;
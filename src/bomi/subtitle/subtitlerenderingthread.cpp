@@ -1,32 +1,75 @@
 #include "subtitlerenderingthread.hpp"
 #include "misc/dataevent.hpp"
+#include "misc/tracer.hpp"
+#include "os/os.hpp"
+#include <QElapsedTimer>
+#include <atomic>
 
-template<>
-inline bool qMapLessThanKey(const SubCompItMapIt &lhs,
-                            const SubCompItMapIt &rhs) {
-    return lhs.key() < rhs.key();
-}
+// look-ahead stops after this many captions or ms of drawing per job
+static constexpr int MaxAhead = 32, FillBudget = 15;
+// raster scale steps per octave, and change of wrapping width in ratio
+// which still keeps cached images, renderer scales them to exact size
+static constexpr double ScaleSteps = 8.0, WrapTolerance = 0.02;
+
+struct CachedImage {
+    SubCompImage image{nullptr};
+    quint64 used = 0;
+};
 
-struct SubCompSelection::Thread::Data {
+struct SubCompSelection::Worker::Data {
     Item *item = nullptr;
     int time = 0;
     const SubComp *comp = nullptr;
-    SubCompItMap its;
-    SubCompItMapIt it = its.end();
-    QMap<SubCompItMapIt, SubCompImage> pool;
+    SubCompIndex its;
+    int it = -1;
+    // keyed by position in its
+    QMap<int, CachedImage> pool;
+    qint64 bytes = 0, limit = 0;
+    quint64 clock = 0;
     QObject *receiver = nullptr;
-    bool quit = false;
+    // set under selection mutex, read by pool threads while rendering
+    std::atomic<bool> quit{false};
+    bool filling = false;
+    int lookahead = 0;
+    int flags = 0, from = 0, until = -1, after = -1;
     double fps = 1.0, dpr = 1.0, mul = 1.0;
-    QMutex *mutex; QWaitCondition *wait;
     QRectF rect; SubtitleDrawer drawer;
-    SubCompSelection *selection = nullptr;
+    // rect resized for quantized scale, and wrapping width in layout unit
+    QRectF raster;
+    double rasterScale = 0.0, wrap = 0.0;
+
+    // returns true if cached images do not fit new area
+    auto updateRaster() -> bool
+    {
+        const double s = drawer.scale(rect)*dpr;
+        if (s <= 0.0 || rect.isEmpty()) {
+            raster = rect;
+            rasterScale = wrap = 0.0;
+            return true;
+        }
+        const double q = std::exp2(std::round(std::log2(s)*ScaleSteps)/ScaleSteps);
+        const double w = rect.width()/(s/dpr);
+        if (qFuzzyCompare(q, rasterScale) && qAbs(w - wrap) <= wrap*WrapTolerance)
+            return false;
+        // same layout width as rect, only pixel density differs
+        raster = QRectF(rect.topLeft(), rect.size()*(q/s));
+        rasterScale = q;
+        wrap = w;
+        return true;
+    }
 
-    SubComp::ConstIt iterator(int time) const { return comp->start(time, fps); }
-    auto newPicture(SubCompItMapIt it)
+    auto newPicture(int it)
+    {
+        CachedImage cache;
+        cache.image = SubCompImage(comp, its.iterator(it), item);
+        drawer.draw(cache.image, raster, dpr);
+        bytes += cache.image.byteCount();
+        return pool.insert(it, cache);
+    }
+    auto clearPool()
     {
-        auto pic = pool.insert(it, SubCompImage(comp, *it, item));
-        drawer.draw(*pic, rect, dpr);
-        return pic;
+        pool.clear();
+        bytes = 0;
     }
     auto update()
     {
@@ -34,159 +77,295 @@ struct SubCompSelection::Thread::Data {
             return;
         auto post = [this] (const SubCompImage &pic)
             { _PostEvent(receiver, ImagePrepared, pic); };
-        if (it != its.end()) {
+        if (it >= 0) {
             auto cache = pool.find(it);
             if (cache == pool.end())
                 cache = newPicture(it);
-            post(*cache);
+            cache->used = ++clock;
+            post(cache->image);
         } else
             post(comp);
     }
 
+    // draw captions within look-ahead until time budget of this job runs out
     auto fillCache()
     {
-        if (it == its.end())
+        filling = false;
+        if (it < 0)
+            return;
+        QElapsedTimer timer;
+        timer.start();
+        const int end = its.time(it, fps) + lookahead;
+        int key = it;
+        for (int i = 0; i < MaxAhead && ++key < its.size()
+                        && its.time(key, fps) <= end; ++i) {
+            auto cache = pool.find(key);
+            if (cache == pool.end()) {
+                if (bytes >= limit)
+                    break;
+                if (quit || timer.elapsed() > FillBudget) {
+                    filling = true;
+                    break;
+                }
+                cache = newPicture(key);
+            }
+            cache->used = ++clock;
+        }
+        evict();
+    }
+
+    // least recently shown first, so captions behind a short seek survive
+    auto evict()
+    {
+        if (bytes <= limit)
             return;
-        auto iit = pool.begin();
-        while (iit != pool.end() && iit.key().key() < it.key())
-            iit = pool.erase(iit);
-        Q_ASSERT(iit.key() == it);
-        auto key = it;
-        const int size = qMin(2, pool.size()+1);
-        for (int i=0; i<size; ++i) {
-            ++iit; ++key;
-            if (key == its.end())
+        QVector<decltype(pool.begin())> lru;
+        lru.reserve(pool.size());
+        for (auto iit = pool.begin(); iit != pool.end(); ++iit) {
+            if (iit.key() != it)
+                lru.push_back(iit);
+        }
+        std::sort(lru.begin(), lru.end(), [] (const auto &lhs, const auto &rhs)
+            { return lhs->used < rhs->used; });
+        for (auto iit : lru) {
+            if (bytes <= limit)
                 break;
-            if (iit == pool.end())
-                iit = newPicture(key);
+            bytes -= iit->image.byteCount();
+            pool.erase(iit);
         }
     }
 
     auto draw(bool force)
     {
-        auto iit = --its.upperBound(time);
+        const int iit = its.find(time, fps);
         if (force || it != iit) {
-            if (it == its.end() || ++it != iit) {
-                pool.clear();
-                it = iit;
-                update();
-            } else {
-                update();
-                fillCache();
-            }
+            it = iit;
+            update();
         }
+        fillCache();
     }
 
-    auto rebuild()
+    // find captions around time without touching current state
+    auto span()
     {
-        pool.clear();
-        its.clear();
-        it = its.end();
-        for (auto iit = comp->begin(); iit != comp->end(); ++iit)
-            its.insert(comp->toTime(iit.key(), fps), iit);
+        from = std::numeric_limits<int>::min();
+        until = after = std::numeric_limits<int>::max();
+        const int next = its.upperBound(time, fps);
+        if (next > 0)
+            from = its.time(next - 1, fps);
+        if (next < its.size()) {
+            until = its.time(next, fps);
+            if (next + 1 < its.size())
+                after = its.time(next + 1, fps);
+        }
     }
 };
 
-SubCompSelection::Thread::Thread(QMutex *mutex, QWaitCondition *wait,
-                                 Item *item, SubCompSelection *selection,
-                                 QObject *renderer)
-    : QThread()
-    , d(new Data)
+static constexpr int NewOption = SubCompSelection::NewDrawer
+                                | SubCompSelection::NewArea;
+static constexpr int ForceUpdate = SubCompSelection::Rerender
+                                  | SubCompSelection::NewFPS | NewOption;
+
+SubCompSelection::Worker::Worker(Item *item, QObject *renderer)
+    : d(new Data)
 {
     d->item = item;
     d->comp = item->comp;
     d->receiver = renderer;
-    d->mutex = mutex;
-    d->wait = wait;
-    d->selection = selection;
+    d->its = SubCompIndex(item->comp);
 }
 
-SubCompSelection::Thread::~Thread()
+SubCompSelection::Worker::~Worker()
 {
-    finish();
+    Q_ASSERT(!busy);
     delete d;
 }
 
-auto SubCompSelection::Thread::setFPS(double fps) -> void
+auto SubCompSelection::Worker::setFPS(double fps) -> void
 {
     this->fps = fps;
-    flags |= Rebuild;
+    flags |= NewFPS;
 }
 
-auto SubCompSelection::Thread::finish() -> void
+auto SubCompSelection::Worker::finish() -> void
 {
     d->quit = true;
-    d->wait->wakeAll();
-    if (!wait(5000))
-        terminate();
 }
 
-auto SubCompSelection::Thread::run() -> void
+auto SubCompSelection::Worker::rank() -> int
+{
+    if (d->quit || busy)
+        return 0;
+    if (!flags)
+        return filling ? 3 : 0;
+    if (flags & ForceUpdate || until < 0)
+        return 1;
+    // a seek out of cached captions should be shown first
+    if (time < from || time >= after)
+        return 1;
+    if (time >= until)
+        return 2;
+    // still in drawn caption, nothing happens
+    flags = 0;
+    return filling ? 3 : 0;
+}
+
+auto SubCompSelection::Worker::take() -> void
+{
+    d->flags = flags;
+    flags = 0;
+    d->time = time;
+    d->fps = fps;
+    d->lookahead = lookahead;
+    d->limit = limit;
+    if (d->flags & NewDrawer)
+        d->drawer = drawer;
+    if (d->flags & NewArea) {
+        d->rect = rect;
+        d->dpr = dpr;
+    }
+}
+
+auto SubCompSelection::Worker::run() -> void
+{
+    TRACE_SCOPE("SubCompSelection::Worker::run");
+    // index and cached images do not depend on fps
+    if (d->flags & NewDrawer)
+        d->rasterScale = 0.0;
+    if (d->flags & NewOption && d->updateRaster())
+        d->clearPool();
+    if (d->quit)
+        return;
+    if (d->time > 0 && d->fps > 0.0 && !d->its.isEmpty()) {
+        d->draw(d->flags & ForceUpdate);
+        d->span();
+    } else if (d->its.isEmpty()) {
+        d->from = std::numeric_limits<int>::min();
+        d->until = d->after = std::numeric_limits<int>::max();
+    } else
+        d->until = -1;
+}
+
+auto SubCompSelection::Worker::done() -> void
 {
-    static constexpr int NewOption = NewDrawer | NewArea;
-    static constexpr int ForceUpdate = Rerender | Rebuild | NewOption;
-    int flags = 0;
-    while (!d->quit) {
-        QMutexLocker locker(d->mutex);
-        if (!(this->flags & ForceUpdate))
-            d->wait->wait(d->mutex);
-        if (d->quit)
-            break;
-        flags = this->flags;
-        this->flags = 0;
-        d->time = time;
-        d->fps = fps;
-        if (flags & NewOption) {
-            if (flags & NewDrawer)
-                d->drawer = drawer;
-            if (flags & NewArea) {
-                d->rect = rect;
-                d->dpr = dpr;
+    from = d->from;
+    until = d->until;
+    after = d->after;
+    filling = d->filling;
+    busy = false;
+}
+
+/******************************************************************************/
+
+struct PoolThread : public QThread {
+    std::function<void(void)> func;
+    auto run() -> void final { func(); }
+};
+
+// fixed number of threads shared by all components of selection
+class SubCompSelection::Pool {
+public:
+    static constexpr int Threads = 2;
+    Pool(SubCompSelection *s): s(s)
+    {
+        for (auto &thread : threads) {
+            thread.func = [this] () { loop(); };
+            thread.setObjectName(u"Subtitle"_q);
+            thread.start();
+        }
+    }
+    ~Pool()
+    {
+        s->mutex.lock();
+        quit = true;
+        s->wait.wakeAll();
+        s->mutex.unlock();
+        for (auto &thread : threads)
+            thread.wait();
+    }
+private:
+    auto loop() -> void
+    {
+        OS::ThreadClassKeeper scheduling(OS::ThreadClass::Render);
+        QMutexLocker locker(&s->mutex);
+        while (!quit) {
+            auto worker = s->schedule();
+            if (!worker) {
+                s->wait.wait(&s->mutex);
+                continue;
             }
+            worker->busy = true;
+            worker->take();
+            locker.unlock();
+            scheduling.keep();
+            worker->run();
+            locker.relock();
+            worker->done();
+            s->idle.wakeAll();
         }
-        locker.unlock();
-        if (d->quit)
-            break;
-        if (flags & Rebuild)
-            d->rebuild();
-        if (flags & NewOption)
-            d->pool.clear();
-        if (d->quit)
-            break;
-        if (d->time > 0 && d->fps > 0.0 && !d->its.isEmpty())
-            d->draw(flags & ForceUpdate);
     }
-}
+    SubCompSelection *s = nullptr;
+    std::array<PoolThread, Threads> threads;
+    bool quit = false;
+};
 
 /******************************************************************************/
 
 struct SubCompSelection::Data {
-    QMutex mutex;
-    QWaitCondition wait;
+    Pool *pool = nullptr;
     QObject *renderer = nullptr;
     SubtitleDrawer drawer;
     QRectF rect;
     double dpr = 1.0, fps = 30.0;
+    int lookahead = 10000;
+    qint64 limit = 64 << 20;
 };
 
 SubCompSelection::SubCompSelection(QObject *renderer)
     : d(new Data)
 {
     d->renderer = renderer;
+    d->pool = new Pool(this);
 }
 
 SubCompSelection::~SubCompSelection()
 {
+    clear();
+    delete d->pool;
     delete d;
 }
 
+auto SubCompSelection::schedule() -> Worker*
+{
+    Worker *next = nullptr;
+    int rank = 0;
+    for (const auto &item : items) {
+        const int r = item.worker->rank();
+        if (!r)
+            continue;
+        if (!next || r < rank || (r == rank && item.worker->due() < next->due())) {
+            next = item.worker;
+            rank = r;
+        }
+    }
+    return next;
+}
+
+auto SubCompSelection::release(List::iterator it) -> void
+{
+    QMutexLocker locker(&mutex);
+    it->worker->finish();
+    while (it->worker->busy)
+        idle.wait(&mutex);
+    it->release();
+    items.erase(it);
+}
+
 auto SubCompSelection::remove(const SubComp *comp) -> void
 {
     auto it = find(comp);
-    if (it != items.end()) {
-        it->release();
-        items.erase(it);
-    }
+    if (it != items.end())
+        release(it);
 }
 
 auto SubCompSelection::drawer() const -> const SubtitleDrawer&
@@ -197,18 +376,14 @@ auto SubCompSelection::drawer() const -> const SubtitleDrawer&
 auto SubCompSelection::setDrawer(const SubtitleDrawer &drawer) -> void
 {
     d->drawer = drawer;
-    forThreads([this] (Thread *t) { t->setDrawer(d->drawer); });
+    forWorkers([this] (Worker *w) { w->setDrawer(d->drawer); });
 }
 
 auto SubCompSelection::clear() -> void
 {
-    for (auto &item : items)
-        item.thread->finish();
-    wait.wakeAll();
+    while (!items.empty())
+        release(items.begin());
     qApp->removePostedEvents(d->renderer, ImagePrepared);
-    for (auto &item : items)
-        item.release();
-    items.clear();
 }
 
 auto SubCompSelection::setArea(const QRectF &rect, double dpr) -> void
@@ -216,7 +391,7 @@ auto SubCompSelection::setArea(const QRectF &rect, double dpr) -> void
     if (d->rect == rect && d->dpr == dpr)
         return;
     d->rect = rect; d->dpr = dpr;
-    forThreads([this] (Thread *thread) { thread->setArea(d->rect, d->dpr); });
+    forWorkers([this] (Worker *w) { w->setArea(d->rect, d->dpr); });
 }
 
 auto SubCompSelection::isEmpty() const -> bool
@@ -232,14 +407,17 @@ auto SubCompSelection::prepend(const SubComp *comp) -> bool
     if (contains(comp) || !comp)
         return false;
     const_cast<SubComp*>(comp)->selection() = true;
+    mutex.lock();
     items.push_front(Item());
     auto &item = items.front();
     item.comp = comp;
-    item.thread = new Thread(&mutex, &wait, &item, this, d->renderer);
-    item.thread->setFPS(d->fps);
-    item.thread->setDrawer(d->drawer);
-    item.thread->setArea(d->rect, d->dpr);
-    item.thread->start();
+    item.worker = new Worker(&item, d->renderer);
+    item.worker->setFPS(d->fps);
+    item.worker->setDrawer(d->drawer);
+    item.worker->setArea(d->rect, d->dpr);
+    item.worker->setCacheLimit(d->lookahead, d->limit);
+    mutex.unlock();
+    wait.wakeAll();
     return true;
 }
 
@@ -251,7 +429,7 @@ auto SubCompSelection::fps() const -> double
 auto SubCompSelection::setFPS(double fps) -> void
 {
     if (_Change(d->fps, fps))
-        forThreads([this, fps] (Thread *t) { t->setFPS(fps); });
+        forWorkers([this, fps] (Worker *w) { w->setFPS(fps); });
 }
 
 auto SubCompSelection::update(const SubCompImage &image) -> bool
@@ -271,3 +449,9 @@ auto SubCompSelection::setMargin(double top, double bottom,
     margin.right = right; margin.left = left;
     d->drawer.setMargin(margin);
 }
+
+auto SubCompSelection::setCacheLimit(int ms, qint64 bytes) -> void
+{
+    if (_Change(d->lookahead, ms) | _Change(d->limit, bytes))
+        forWorkers([this] (Worker *w) { w->setCacheLimit(d->lookahead, d->limit); });
+}
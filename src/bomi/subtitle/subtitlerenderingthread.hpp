@@ -3,38 +3,53 @@
 
 #include "subtitledrawer.hpp"
 
-using SubCompItMap = QMap<int, SubComp::ConstIt>;
-using SubCompItMapIt = SubCompItMap::const_iterator;
-
 class SubCompSelection {
 public:
     static constexpr int ImagePrepared = QEvent::User+1;
     enum Flag {
-        NewDrawer = 1, NewArea = 2, Rebuild = 4, Rerender = 8, Tick = 16
+        NewDrawer = 1, NewArea = 2, NewFPS = 4, Rerender = 8, Tick = 16
     };
 private:
     struct Item;
-    class Thread : public QThread {
+    // list of items is modified and workers are scheduled with mutex locked
+    // rasterizes one component, run by any thread of the pool
+    // setters are called with the selection mutex locked
+    class Worker {
     public:
-        Thread(QMutex *mutex, QWaitCondition *wait, Item *item,
-               SubCompSelection *selection, QObject *renderer);
-        ~Thread();
+        Worker(Item *item, QObject *renderer);
+        ~Worker();
         auto setFPS(double fps) -> void;
         auto render(int time, int flags) -> void;
         auto setArea(const QRectF &rect, double dpr) -> void;
         auto setDrawer(const SubtitleDrawer &drawer) -> void;
+        auto setCacheLimit(int ms, qint64 bytes) -> void
+            { lookahead = ms; limit = bytes; }
         auto finish() -> void;
+        // 0 for nothing to do, 1 for seek or forced update, 2 for others,
+        // 3 for filling look-ahead cache
+        // ticks which change nothing are dropped here
+        auto rank() -> int;
+        // caption boundary where next new image is required
+        auto due() const -> int { return until; }
+        auto take() -> void;
         auto run() -> void;
+        auto done() -> void;
+        bool busy = false;
     private:
         QRectF rect;
         double dpr = 1.0, fps = 1.0;
         SubtitleDrawer drawer;
-        int time = 0, flags = 0;
+        int time = 0, flags = 0, lookahead = 0;
+        qint64 limit = 0;
+        bool filling = false;
+        // span of drawn caption and start of caption after next
+        int from = 0, until = -1, after = -1;
         struct Data; Data *d;
     };
+    class Pool;
     struct Item {
         auto release() -> void;
-        Thread *thread  = nullptr;
+        Worker *worker = nullptr;
         const SubComp *comp = nullptr;
         SubCompImage image{nullptr};
     };
@@ -62,32 +77,37 @@ public:
     auto setFPS(double fps) -> void;
     auto setMargin(double top, double bottom,
                    double right, double left) -> void;
+    // look-ahead of each component in ms and its cache size in bytes
+    auto setCacheLimit(int ms, qint64 bytes) -> void;
 private:
     auto item(const SubCompImage &image) -> Item*;
     auto find(const SubComp *comp) -> List::iterator;
     auto find(const SubComp *comp) const -> List::const_iterator;
     template<class Func>
-    auto forThreads(Func func) -> void;
+    auto forWorkers(Func func) -> void;
+    auto schedule() -> Worker*;
+    auto release(List::iterator it) -> void;
     List items; mutable QMutex mutex;
-    mutable QWaitCondition wait;
+    mutable QWaitCondition wait, idle;
     struct Data;
     Data *d;
     QVector<SubCompImage> m_images;
 };
 
-inline auto SubCompSelection::Thread::render(int time, int flags) -> void
+inline auto SubCompSelection::Worker::render(int time, int flags) -> void
 { this->time = time; this->flags |= flags; }
 
-inline auto SubCompSelection::Thread::setArea(const QRectF &rect,
+inline auto SubCompSelection::Worker::setArea(const QRectF &rect,
                                               double dpr) -> void
 { this->rect = rect; this->dpr = dpr; flags |= NewArea; }
 
-inline auto SubCompSelection::Thread::setDrawer(const SubtitleDrawer &d) -> void
+inline auto SubCompSelection::Worker::setDrawer(const SubtitleDrawer &d) -> void
 { this->drawer = d; flags |= NewDrawer; }
 
 template<class LessThan>
 inline auto SubCompSelection::sort(LessThan lt) -> void
 {
+    QMutexLocker locker(&mutex);
     items.sort([lt] (const Item &lhs, const Item &rhs) {
         return lt(*lhs.comp, *rhs.comp);
     });
@@ -102,11 +122,11 @@ inline auto SubCompSelection::forImages(F f) const -> void
 { for (const auto &item : items) f(item.image); }
 
 inline auto SubCompSelection::render(int ms, int flags) -> void
-{ forThreads([this, ms, flags] (Thread *t) { t->render(ms, flags); }); }
+{ forWorkers([this, ms, flags] (Worker *w) { w->render(ms, flags); }); }
 
 inline auto SubCompSelection::Item::release() -> void
 {
-    _Delete(thread);
+    _Delete(worker);
     if (comp)
         const_cast<SubComp*>(comp)->selection() = false;
 }
@@ -134,10 +154,10 @@ inline auto SubCompSelection::find(const SubComp *comp) const
 }
 
 template<class Func>
-inline auto SubCompSelection::forThreads(Func func) -> void {
+inline auto SubCompSelection::forWorkers(Func func) -> void {
     mutex.lock();
     for (const auto &item : items)
-        func(item.thread);
+        func(item.worker);
     mutex.unlock();
     wait.wakeAll();
 }
@@ -4,7 +4,6 @@
 #include "misc/matchstring.hpp"
 #include "misc/objectstorage.hpp"
 #include "ui_subtitleviewer.h"
-#include <QSortFilterProxyModel>
 #include <QSplitter>
 #include <QScrollArea>
 
@@ -102,13 +101,9 @@ struct SubtitleViewer::Data {
     }
     auto seekIndex(const QModelIndex &idx) -> void
     {
-        auto proxy = qobject_cast<const QSortFilterProxyModel*>(idx.model());
-        if (!proxy)
-            return;
-        const auto src = proxy->mapToSource(idx);
-        auto model = static_cast<const SubCompModel*>(src.model());
-        if (model && src.isValid() && seek)
-            seek(model->at(src.row()).start());
+        auto model = dynamic_cast<const SubCompModel*>(idx.model());
+        if (model && idx.isValid() && seek)
+            seek(model->at(idx.row()).start());
     }
 };
 
@@ -65,6 +65,24 @@ template<class Container, class Compare>
 SIA sort(Container &c, Compare cmp) -> void
 { std::sort(std::begin(c), std::end(c), cmp); }
 
+// stable sort by key which is computed only once for each item
+template<class Container, class F>
+SIA sort_by(Container &c, F key) -> void
+{
+    using Key = typename std::decay<decltype(key(*std::begin(c)))>::type;
+    std::vector<std::pair<Key, int>> keys;
+    keys.reserve(c.size());
+    for (auto &item : c)
+        keys.emplace_back(key(item), keys.size());
+    std::stable_sort(keys.begin(), keys.end(), [] (const auto &lhs, const auto &rhs)
+        { return lhs.first < rhs.first; });
+    Container sorted;
+    sorted.reserve(c.size());
+    for (auto &k : keys)
+        sorted.push_back(c[k.second]);
+    c = std::move(sorted);
+}
+
 template<class T>
 SIA max(const T &t1, const T &t2) -> T { return std::max(t1, t2); }
 
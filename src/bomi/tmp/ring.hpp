@@ -0,0 +1,128 @@
+#ifndef RING_HPP
+#define RING_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <QtGlobal>
+
+namespace tmp {
+
+static constexpr int CacheLineSize = 64;
+
+// pads atomic index to whole cache line so that producer and consumer
+// never write to the same line, heap alignment of alignas is not guaranteed
+template<class T>
+struct PaddedIndex {
+    std::atomic<T> value{0};
+    char padding[CacheLineSize - sizeof(std::atomic<T>)];
+};
+
+// lock-free ring of values for one producer and one consumer thread
+// push() is called only by producer and pop()/clear() only by consumer
+template<class T>
+class SpscRing {
+public:
+    SpscRing(int order): m_data(1 << order), m_mask((1u << order) - 1) { }
+    auto capacity() const -> int { return m_mask + 1; }
+    // gen(i) gives i-th value. returns false if ring is too full
+    template<class F>
+    auto push(int count, F gen) -> bool
+    {
+        const auto head = m_head.value.load(std::memory_order_relaxed);
+        const auto tail = m_tail.value.load(std::memory_order_acquire);
+        if (capacity() - int(head - tail) < count)
+            return false;
+        for (int i = 0; i < count; ++i)
+            m_data[(head + i) & m_mask] = gen(i);
+        m_head.value.store(head + count, std::memory_order_release);
+        return true;
+    }
+    auto push(const T &t) -> bool { return push(1, [&] (int) { return t; }); }
+    // returns count of values moved into dst
+    auto pop(T *dst, int max) -> int
+    {
+        const auto tail = m_tail.value.load(std::memory_order_relaxed);
+        const auto head = m_head.value.load(std::memory_order_acquire);
+        const int count = std::min<int>(max, head - tail);
+        for (int i = 0; i < count; ++i)
+            dst[i] = std::move(m_data[(tail + i) & m_mask]);
+        m_tail.value.store(tail + count, std::memory_order_release);
+        return count;
+    }
+    auto pop(T &t) -> bool { return pop(&t, 1); }
+    auto clear() -> void
+    {
+        const auto head = m_head.value.load(std::memory_order_acquire);
+        m_tail.value.store(head, std::memory_order_release);
+    }
+private:
+    std::vector<T> m_data;
+    const quint32 m_mask;
+    PaddedIndex<quint32> m_head, m_tail;
+};
+
+// bounded lock-free ring for many producers and one consumer thread
+// each slot has a sequence number which tells who owns it
+template<class T, int Order>
+class MpscRing {
+public:
+    static constexpr quint64 Size = quint64(1) << Order;
+    MpscRing()
+    {
+        for (quint64 i = 0; i < Size; ++i)
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    // write(T&) fills taken slot. returns position or -1 if ring is full
+    template<class F>
+    auto tryPush(F write) -> qint64
+    {
+        auto pos = m_head.value.load(std::memory_order_relaxed);
+        forever {
+            auto &slot = m_slots[pos & (Size - 1)];
+            const auto seq = slot.seq.load(std::memory_order_acquire);
+            const auto diff = (qint64)seq - (qint64)pos;
+            if (!diff) {
+                if (m_head.value.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    write(slot.value);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return pos;
+                }
+            } else if (diff < 0)
+                return -1;
+            else
+                pos = m_head.value.load(std::memory_order_relaxed);
+        }
+    }
+    // read(T&) takes value out of slot, called only by consumer
+    template<class F>
+    auto pop(F read) -> bool
+    {
+        if (isEmpty())
+            return false;
+        auto &slot = m_slots[m_tail & (Size - 1)];
+        read(slot.value);
+        slot.seq.store(m_tail + Size, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+    // next position to push, any thread
+    auto head() const -> quint64 { return m_head.value.load(std::memory_order_relaxed); }
+    // count of popped values, consumer only
+    auto tail() const -> quint64 { return m_tail; }
+    auto isEmpty() const -> bool
+    {
+        const auto &slot = m_slots[m_tail & (Size - 1)];
+        return slot.seq.load(std::memory_order_acquire) != m_tail + 1;
+    }
+private:
+    struct Slot { std::atomic<quint64> seq{0}; T value; };
+    Slot m_slots[Size];
+    PaddedIndex<quint64> m_head;
+    quint64 m_tail = 0;
+};
+
+}
+
+#endif // RING_HPP
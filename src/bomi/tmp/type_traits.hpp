@@ -63,6 +63,19 @@ SCIA is_convertible() -> bool { return std::is_convertible<From, To>::value; }
 template<class T>
 SCIA is_enum_class() -> bool {return is_enum<T>() && !is_convertible<T, int>();}
 
+namespace detail {
+template<class T, class = void>
+struct has_equal : std::false_type { };
+
+template<class T>
+struct has_equal<T, typename std::enable_if<std::is_same<decltype(void(
+    std::declval<const T&>() == std::declval<const T&>())), void>::value
+    >::type> : std::true_type { };
+}
+
+template<class T>
+SCIA has_equal() -> bool { return detail::has_equal<T>::value; }
+
 namespace detail {
 template<class T, class S, class... Args>
 struct are_same {
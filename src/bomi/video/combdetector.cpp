@@ -0,0 +1,98 @@
+#include "combdetector.hpp"
+#include "mpimage.hpp"
+
+#if defined(__SSE2__)
+#define COMB_DETECT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COMB_DETECT_NEON 1
+#include <arm_neon.h>
+#endif
+
+// number of sampled rows
+static constexpr int Rows = 64;
+// difference of luma which counts as a comb
+static constexpr int Threshold = 12;
+// ratio of combed pixels to take a frame as evidence
+static constexpr double MinCombs = 0.002;
+// combs between fields against combs within a field for interlaced frame
+static constexpr int Ratio = 3;
+// frames of evidence to flip decision and bound of score
+static constexpr int Flip = 8, Hold = 16;
+
+// pixels of b brighter or darker than both of a and c by threshold
+static auto combs(const uchar *a, const uchar *b, const uchar *c, int count) -> int
+{
+    int sum = 0, i = 0;
+#if COMB_DETECT_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i th = _mm_set1_epi8(Threshold);
+    __m128i acc = zero;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        const __m128i vc = _mm_loadu_si128((const __m128i*)(c + i));
+        const __m128i hi = _mm_subs_epu8(vb, _mm_max_epu8(va, vc));
+        const __m128i lo = _mm_subs_epu8(_mm_min_epu8(va, vc), vb);
+        const __m128i d = _mm_subs_epu8(_mm_max_epu8(hi, lo), th);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_min_epu8(d, one), zero));
+    }
+    alignas(16) quint64 lanes[2];
+    _mm_store_si128((__m128i*)lanes, acc);
+    sum = lanes[0] + lanes[1];
+#elif COMB_DETECT_NEON
+    const uint8x16_t one = vdupq_n_u8(1);
+    const uint8x16_t th = vdupq_n_u8(Threshold);
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t va = vld1q_u8(a + i), vb = vld1q_u8(b + i), vc = vld1q_u8(c + i);
+        const uint8x16_t hi = vqsubq_u8(vb, vmaxq_u8(va, vc));
+        const uint8x16_t lo = vqsubq_u8(vminq_u8(va, vc), vb);
+        const uint8x16_t d = vqsubq_u8(vmaxq_u8(hi, lo), th);
+        acc = vpadalq_u16(acc, vpaddlq_u8(vminq_u8(d, one)));
+    }
+    sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1)
+        + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (; i < count; ++i) {
+        const int lo = std::min(a[i], c[i]), hi = std::max(a[i], c[i]);
+        sum += (b[i] > hi + Threshold) || (b[i] < lo - Threshold);
+    }
+    return sum;
+}
+
+auto CombDetector::feed(const mp_image *mpi) -> bool
+{
+    switch (mpi->imgfmt) {
+    case IMGFMT_420P:   case IMGFMT_NV12:   case IMGFMT_NV21:
+    case IMGFMT_444P:   case IMGFMT_422P:   case IMGFMT_440P:
+    case IMGFMT_411P:   case IMGFMT_410P:   case IMGFMT_Y8:
+        break;
+    default:
+        return false;
+    }
+    if (mpi->h < 8 || mpi->w <= 0)
+        return false;
+    const uchar *const data = mpi->planes[0];
+    const int stride = mpi->stride[0];
+    const int step = std::max(1, (mpi->h - 4) / Rows);
+    int woven = 0, field = 0, rows = 0;
+    for (int y = 2; y + 2 < mpi->h; y += step, ++rows) {
+        const uchar *line = data + y * stride;
+        woven += combs(line - stride, line, line + stride, mpi->w);
+        field += combs(line - 2*stride, line, line + 2*stride, mpi->w);
+    }
+    // still or flat frames tell nothing about interlacing
+    if (woven < MinCombs * rows * mpi->w)
+        return false;
+    m_score = qBound(-Hold, m_score + (woven > Ratio * field ? 1 : -1), Hold);
+    const bool decided = m_decided, interlaced = m_interlaced;
+    if (m_score >= Flip)
+        m_decided = m_interlaced = true;
+    else if (m_score <= -Flip) {
+        m_decided = true;
+        m_interlaced = false;
+    }
+    return decided != m_decided || interlaced != m_interlaced;
+}
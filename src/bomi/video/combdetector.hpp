@@ -0,0 +1,23 @@
+#ifndef COMBDETECTOR_HPP
+#define COMBDETECTOR_HPP
+
+struct mp_image;
+
+// finds combing of woven fields regardless of interlace flags
+// a few rows of luma are compared with neighbor lines of both fields and of
+// same field; combing makes the former differ much more than the latter
+// decision is kept for a scene: it flips only after many frames agree
+class CombDetector {
+public:
+    // true if decision has been changed
+    auto feed(const mp_image *mpi) -> bool;
+    // false until enough frames with motion have been fed
+    auto isDecided() const -> bool { return m_decided; }
+    auto isInterlaced() const -> bool { return m_interlaced; }
+    auto reset() -> void { m_score = 0; m_decided = m_interlaced = false; }
+private:
+    int m_score = 0;
+    bool m_decided = false, m_interlaced = false;
+};
+
+#endif // COMBDETECTOR_HPP
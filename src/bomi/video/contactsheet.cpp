@@ -0,0 +1,208 @@
+#include "contactsheet.hpp"
+#include "keyframedecoder.hpp"
+#include "player/mpv_property.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+#include "os/os.hpp"
+#include <QThreadPool>
+#include <QSaveFile>
+#include <QPainter>
+
+DECLARE_LOG_CONTEXT(Video)
+
+enum EventType { Exported = QEvent::User + 1 };
+
+class SheetTileJob : public QRunnable {
+public:
+    SheetTileJob(std::function<void(void)> &&run): m_run(std::move(run)) { }
+    auto run() -> void final
+    {
+        OS::setThreadClass(OS::ThreadClass::Background);
+        m_run();
+    }
+private:
+    std::function<void(void)> m_run;
+};
+
+auto ContactSheet::generate(const QString &file, int threads,
+                            const std::atomic<bool> &cancel) const -> QImage
+{
+    const int count = columns * rows;
+    KeyframeDecoder first;
+    if (file.isEmpty() || count <= 0 || !first.open(MpvFile(file).toMpv()))
+        return QImage();
+    const int height = qBound(16, qRound(tileWidth / first.aspect()) & ~1, tileWidth * 2);
+    QImage image(columns * tileWidth, rows * height, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    // taken once here, scanLine() of shared image is not for threads
+    const auto bits = image.bits();
+    const int stride = image.bytesPerLine();
+    const qint64 duration = first.duration();
+    QVector<qint64> positions(count, -1);
+    std::atomic<int> drawn{0};
+    // decoder n takes tiles n, n + threads, ... so that each seeks forward
+    auto decode = [&] (KeyframeDecoder *decoder, int from, int step) {
+        for (int i = from; i < count && !cancel; i += step) {
+            const qint64 us = duration * (i + 0.5) / count;
+            const QRect rect(i % columns * tileWidth, i / columns * height, tileWidth, height);
+            if (decoder->decode(us) && decoder->draw(bits, stride, rect)) {
+                positions[i] = decoder->position() < 0 ? us : decoder->position();
+                ++drawn;
+            }
+        }
+    };
+    threads = qBound(1, threads, count);
+    if (threads > 1) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads - 1);
+        for (int i = 1; i < threads; ++i) {
+            pool.start(new SheetTileJob([&, i] () {
+                KeyframeDecoder decoder;
+                if (decoder.open(MpvFile(file).toMpv()))
+                    decode(&decoder, i, threads);
+            }));
+        }
+        decode(&first, 0, threads);
+        pool.waitForDone();
+    } else
+        decode(&first, 0, 1);
+    if (cancel || !drawn)
+        return QImage();
+    if (timestamps) {
+        QPainter painter(&image);
+        auto font = painter.font();
+        font.setPixelSize(qMax(10, height / 10));
+        painter.setFont(font);
+        const int margin = font.pixelSize() / 3;
+        for (int i = 0; i < count; ++i) {
+            if (positions[i] < 0)
+                continue;
+            const QRect rect(i % columns * tileWidth, i / columns * height, tileWidth, height);
+            const auto text = _MSecToString(positions[i] / 1000);
+            auto box = painter.fontMetrics().boundingRect(text);
+            box.adjust(-margin, -margin, margin, margin);
+            box.moveBottomRight(rect.bottomRight());
+            painter.fillRect(box, QColor(0, 0, 0, 160));
+            painter.setPen(Qt::white);
+            painter.drawText(box, Qt::AlignCenter, text);
+        }
+    }
+    return image;
+}
+
+auto ContactSheet::target(const QString &file, const QString &folder) -> QString
+{
+    return QDir(folder).filePath(QFileInfo(file).fileName() % ".jpg"_a);
+}
+
+/******************************************************************************/
+
+class SheetExportJob : public QRunnable {
+public:
+    SheetExportJob(QObject *exporter, const ContactSheet &sheet, int threads,
+                   const QString &file, const QString &folder,
+                   const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_exporter(exporter), m_sheet(sheet), m_threads(threads)
+        , m_file(file), m_folder(folder), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        if (*m_cancel)
+            return;
+        OS::setThreadClass(OS::ThreadClass::Background);
+        const auto image = m_sheet.generate(m_file, m_threads, *m_cancel);
+        if (*m_cancel)
+            return;
+        bool saved = false;
+        if (image.isNull())
+            _Error("Cannot decode keyframes of %% for thumbnail sheet.", m_file);
+        else {
+            const auto path = ContactSheet::target(m_file, m_folder);
+            QSaveFile out(path);
+            saved = out.open(QFile::WriteOnly) && image.save(&out, "JPG", 90) && out.commit();
+            if (!saved)
+                _Error("Cannot write thumbnail sheet '%%'.", path);
+        }
+        _PostEvent(m_exporter, Exported, m_cancel, saved);
+    }
+private:
+    QObject *m_exporter = nullptr;
+    ContactSheet m_sheet;
+    int m_threads = 1;
+    QString m_file, m_folder;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
+
+struct ContactSheetExporter::Data {
+    QThreadPool pool;
+    QSharedPointer<std::atomic<bool>> cancel;
+    int total = 0, done = 0, saved = 0;
+};
+
+ContactSheetExporter::ContactSheetExporter(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+}
+
+ContactSheetExporter::~ContactSheetExporter()
+{
+    stop();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto ContactSheetExporter::isRunning() const -> bool
+{
+    return !d->cancel.isNull();
+}
+
+auto ContactSheetExporter::start(const QStringList &files, const QString &folder,
+                                 const ContactSheet &sheet) -> void
+{
+    stop();
+    if (files.isEmpty())
+        return;
+    QDir().mkpath(folder);
+    d->total = files.size();
+    d->done = d->saved = 0;
+    d->cancel.reset(new std::atomic<bool>(false));
+    // every core busy either way, seeking one file from many decoders is
+    // only worth it while there are fewer files than cores
+    const int cores = qMax(1, QThread::idealThreadCount());
+    const int parallel = qMin(files.size(), cores);
+    d->pool.setMaxThreadCount(parallel);
+    for (auto &file : files)
+        d->pool.start(new SheetExportJob(this, sheet, cores / parallel, file, folder, d->cancel));
+    _Info("Start exporting thumbnail sheets of %% files into %%.", files.size(), folder);
+}
+
+auto ContactSheetExporter::stop() -> void
+{
+    if (!d->cancel)
+        return;
+    *d->cancel = true;
+    d->cancel.reset();
+    d->pool.clear();
+}
+
+auto ContactSheetExporter::customEvent(QEvent *event) -> void
+{
+    switch (static_cast<int>(event->type())) {
+    case Exported: {
+        QSharedPointer<std::atomic<bool>> cancel; bool saved = false;
+        _TakeData(event, cancel, saved);
+        if (cancel != d->cancel)
+            break;
+        ++d->done;
+        if (saved)
+            ++d->saved;
+        emit progressed(d->done, d->total);
+        if (d->done >= d->total) {
+            d->cancel.reset();
+            _Info("Exported %% thumbnail sheets, %% failed.", d->saved, d->total - d->saved);
+            emit finished(d->saved, d->total - d->saved);
+        }
+        break;
+    } default:
+        break;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef CONTACTSHEET_HPP
+#define CONTACTSHEET_HPP
+
+// grid of keyframes evenly spaced in time with their timestamps
+// decoded by ffmpeg directly, so playback and its mpv are not involved
+struct ContactSheet {
+    int columns = 4, rows = 6, tileWidth = 320;
+    bool timestamps = true;
+    // decoders which share tiles of one file
+    auto generate(const QString &file, int threads,
+                  const std::atomic<bool> &cancel) const -> QImage;
+    // sheet of file saved in folder
+    static auto target(const QString &file, const QString &folder) -> QString;
+};
+
+// writes sheets of many files in background
+// small batch spreads tiles of each file across decoders, large batch files
+class ContactSheetExporter : public QObject {
+    Q_OBJECT
+public:
+    ContactSheetExporter(QObject *parent = nullptr);
+    ~ContactSheetExporter();
+    auto start(const QStringList &files, const QString &folder,
+               const ContactSheet &sheet = ContactSheet()) -> void;
+    auto stop() -> void;
+    auto isRunning() const -> bool;
+signals:
+    void progressed(int done, int total);
+    void finished(int saved, int failed);
+private:
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // CONTACTSHEET_HPP
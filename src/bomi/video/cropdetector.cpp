@@ -0,0 +1,231 @@
+#include "cropdetector.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglreadback.hpp"
+#include "opengl/openglshadercache.hpp"
+#include "misc/log.hpp"
+#include <QOpenGLShaderProgram>
+#include <QElapsedTimer>
+#include <QVector2D>
+#include <atomic>
+
+DECLARE_LOG_CONTEXT(Video)
+
+// columns and rows are resampled to this number of lines
+static constexpr int Lines = 128;
+// msec between analyzed frames
+static constexpr int Interval = 250;
+// samples to keep: bars can grow only if every sample in history agrees
+static constexpr int History = 32, MinHistory = 8;
+// bars thinner than this are noise or encoder padding, not letterbox
+static constexpr int MinBar = 2;
+// max luma of a line which is regarded as black
+static constexpr double Black = 0.1;
+
+struct Bars {
+    int x = 0, y = 0;
+    auto operator == (const Bars &rhs) const -> bool
+        { return x == rhs.x && y == rhs.y; }
+    auto operator != (const Bars &rhs) const -> bool { return !operator == (rhs); }
+};
+
+struct CropDetector::Data {
+    OpenGLFramebufferObject *fbo = nullptr;
+    QOpenGLShaderProgram *shader = nullptr;
+    OpenGLReadback readback{2};
+    QElapsedTimer timer;
+    QVector<Bars> history;
+    Bars applied;
+    int discard = 0, loc_scale = -1;
+    std::atomic<bool> reset{false};
+    mutable QMutex mutex;
+    QSizeF area;
+
+    // returns length of leading black lines from both ends, -1 if all black
+    static auto measure(const QRgb *line, int &head, int &tail) -> bool
+    {
+        head = 0;
+        while (head < Lines && qRed(line[head]) <= Black * 255)
+            ++head;
+        if (head >= Lines)
+            return false;
+        tail = 0;
+        while (qRed(line[Lines - 1 - tail]) <= Black * 255)
+            ++tail;
+        return true;
+    }
+    auto push(const QImage &image) -> bool
+    {
+        if (image.width() != Lines || image.height() != 2)
+            return false;
+        // image is not flipped: row 0 is bottom of fbo which holds columns
+        int left, right, top, bottom;
+        const auto columns = reinterpret_cast<const QRgb*>(image.constScanLine(0));
+        const auto rows = reinterpret_cast<const QRgb*>(image.constScanLine(1));
+        // dark frame tells nothing about bars
+        if (!measure(columns, left, right) || !measure(rows, top, bottom))
+            return false;
+        Bars bars;
+        bars.x = qMin(left, right);
+        bars.y = qMin(top, bottom);
+        if (bars.x < MinBar)
+            bars.x = 0;
+        if (bars.y < MinBar)
+            bars.y = 0;
+        history.push_back(bars);
+        if (history.size() > History)
+            history.pop_front();
+        if (history.size() < MinHistory)
+            return false;
+        // second thinnest bars in history to ignore one odd frame like flash
+        auto thinnest = [&] (int Bars::*m) {
+            int first = Lines, second = Lines;
+            for (auto &b : history) {
+                if (b.*m < first) {
+                    second = first;
+                    first = b.*m;
+                } else if (b.*m < second)
+                    second = b.*m;
+            }
+            return second;
+        };
+        Bars target;
+        target.x = thinnest(&Bars::x);
+        target.y = thinnest(&Bars::y);
+        if (!_Change(applied, target))
+            return false;
+        QSizeF area(1.0 - 2.0 * applied.x / Lines, 1.0 - 2.0 * applied.y / Lines);
+        if (!applied.x && !applied.y)
+            area = QSizeF();
+        _Debug("Detected black bars: %%x%% lines of %%", applied.x, applied.y, Lines);
+        QMutexLocker locker(&mutex);
+        this->area = area;
+        return true;
+    }
+    auto draw(const OpenGLFramebufferObject *frame) -> void
+    {
+        static const GLfloat quad[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+        auto f = QOpenGLContext::currentContext()->functions();
+        fbo->bind();
+        f->glViewport(0, 0, fbo->width(), fbo->height());
+        shader->bind();
+        f->glActiveTexture(GL_TEXTURE0);
+        frame->texture().bind();
+        // frame may use only part of pooled texture
+        const auto c = frame->capacity();
+        shader->setUniformValue(loc_scale, QVector2D(frame->width() / float(c.width()),
+                                                     frame->height() / float(c.height())));
+        shader->setAttributeArray(0, quad, 2);
+        shader->enableAttributeArray(0);
+        f->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        shader->disableAttributeArray(0);
+        shader->release();
+        fbo->release();
+    }
+};
+
+CropDetector::CropDetector()
+    : d(new Data)
+{
+    d->timer.start();
+}
+
+CropDetector::~CropDetector()
+{
+    Q_ASSERT(!d->fbo);
+    delete d;
+}
+
+auto CropDetector::create() -> bool
+{
+    if (d->fbo)
+        return true;
+    OpenGLShaderCache::Source source;
+    source.vertex = R"(
+        attribute vec2 aPosition;
+        varying vec2 coord;
+        void main() {
+            coord = aPosition * 0.5 + 0.5;
+            gl_Position = vec4(aPosition, 0.0, 1.0);
+        }
+    )";
+    // lower row reduces columns and upper one reduces rows
+    source.fragment = R"(
+        uniform sampler2D frame;
+        uniform vec2 scale;
+        varying vec2 coord;
+        const int Taps = 48;
+        void main() {
+            bool column = coord.y < 0.5;
+            float m = 0.0;
+            float s = 0.0;
+            for (int i = 0; i < Taps; ++i) {
+                float t = (float(i) + 0.5) / float(Taps);
+                vec2 p = column ? vec2(coord.x, t) : vec2(t, coord.x);
+                vec3 c = texture2D(frame, p * scale).rgb;
+                float y = dot(c, vec3(0.2126, 0.7152, 0.0722));
+                m = max(m, y);
+                s += y;
+            }
+            gl_FragColor = vec4(m, s / float(Taps), 0.0, 1.0);
+        }
+    )";
+    source.attributes << "aPosition";
+    d->shader = new QOpenGLShaderProgram;
+    if (!OpenGLShaderCache::link(d->shader, source) || !d->readback.create()) {
+        _Error("Cannot initialize black bar detection.");
+        _Delete(d->shader);
+        return false;
+    }
+    d->shader->bind();
+    d->shader->setUniformValue(d->shader->uniformLocation("frame"), 0);
+    d->loc_scale = d->shader->uniformLocation("scale");
+    d->shader->release();
+    d->fbo = new OpenGLFramebufferObject(QSize(Lines, 2));
+    return true;
+}
+
+auto CropDetector::destroy() -> void
+{
+    d->readback.destroy();
+    _Delete(d->shader);
+    _Delete(d->fbo);
+    d->discard = 0;
+}
+
+auto CropDetector::analyze(const OpenGLFramebufferObject *frame) -> bool
+{
+    if (!d->fbo || !frame || frame->size().isEmpty())
+        return false;
+    bool changed = false;
+    if (d->reset.exchange(false)) {
+        d->history.clear();
+        d->discard = d->readback.pending();
+        changed = _Change(d->applied, Bars());
+    }
+    QImage image;
+    while (d->readback.pending() && d->readback.take(image)) {
+        if (d->discard > 0)
+            --d->discard;
+        else
+            changed |= d->push(image);
+    }
+    if (d->timer.elapsed() >= Interval && d->readback.available()) {
+        d->timer.restart();
+        d->draw(frame);
+        d->readback.read(d->fbo, QImage::Format_ARGB32);
+    }
+    return changed;
+}
+
+auto CropDetector::area() const -> QSizeF
+{
+    QMutexLocker locker(&d->mutex);
+    return d->area;
+}
+
+auto CropDetector::reset() -> void
+{
+    d->reset = true;
+    QMutexLocker locker(&d->mutex);
+    d->area = QSizeF();
+}
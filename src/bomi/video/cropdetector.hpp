@@ -0,0 +1,32 @@
+#ifndef CROPDETECTOR_HPP
+#define CROPDETECTOR_HPP
+
+class OpenGLFramebufferObject;
+
+// finds black bars burnt into frames
+// each line of a few frames per second is reduced to max and mean of luma
+// in gpu, and only a tiny image is read back without waiting for it
+// detected bars are smoothed over seconds so that dark scenes or fades
+// cannot bring the crop back and forth
+class CropDetector {
+public:
+    CropDetector();
+    CropDetector(const CropDetector &) = delete;
+    CropDetector &operator = (const CropDetector &) = delete;
+    ~CropDetector();
+    // current context is required for functions below
+    auto create() -> bool;
+    auto destroy() -> void;
+    // true if detected area has been changed
+    auto analyze(const OpenGLFramebufferObject *frame) -> bool;
+    // any thread
+    // centered visible part of frame in [0, 1], empty if nothing detected
+    auto area() const -> QSizeF;
+    // forget detection, e.g. for new source, applied at next analyze()
+    auto reset() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // CROPDETECTOR_HPP
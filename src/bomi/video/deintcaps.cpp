@@ -3,31 +3,35 @@
 #include "os/os.hpp"
 #include "misc/json.hpp"
 
+struct DeintCapsEntry { DeintMethod method; bool cpu, gpu, doubler; };
+
+static constexpr DeintCapsEntry capsTable[] = {
+    //  method                cpu    gpu   doubler
+    { DeintMethod::Bob      , true , true, true },
+    { DeintMethod::LinearBob, true , true, true },
+    { DeintMethod::CubicBob , true , true, true },
+    { DeintMethod::Yadif    , true , true, true }
+};
+
+// hwacc is asked only once for whole life of process
 auto DeintCaps::list() -> const QList<DeintCaps>&
 {
-    static QList<DeintCaps> caps;
-    if (!caps.isEmpty())
+    static const QList<DeintCaps> caps = [] () {
+        QList<DeintCaps> caps;
+        for (int i=0; i<DeintMethodInfo::size(); ++i) {
+            caps.push_back(DeintCaps());
+            caps.back().m_method = (DeintMethod)i;
+        }
+        for (auto &e : capsTable) {
+            auto &cap = caps[(int)e.method];
+            if (e.cpu)
+                cap.m_procs |= Processor::CPU;
+            if (e.gpu && OS::hwAcc()->supports(e.method))
+                cap.m_procs |= Processor::GPU;
+            cap.m_doubler = e.doubler;
+        }
         return caps;
-    for (int i=0; i<DeintMethodInfo::size(); ++i) {
-        caps.push_back(DeintCaps());
-        caps.back().m_method = (DeintMethod)i;
-    }
-
-    auto push = [] (DeintMethod method, bool cpu, bool gpu, bool doubler) {
-        auto &cap = caps[(int)method];
-        cap.m_method = method;
-        if (cpu)
-            cap.m_procs |= Processor::CPU;
-        if (gpu && OS::hwAcc()->supports(method))
-            cap.m_procs |= Processor::GPU;
-        cap.m_doubler = doubler;
-        return caps[(int)method];
-    };
-    //  method                        cpu    gpu    doubler
-    push(DeintMethod::Bob           , true , true, true );
-    push(DeintMethod::LinearBob     , true , true, true );
-    push(DeintMethod::CubicBob      , true , true, true );
-    push(DeintMethod::Yadif         , true , true, true );
+    }();
     return caps;
 }
 
@@ -25,7 +25,7 @@ auto DeintOption::fromString(const QString &string) -> DeintOption
 
 #undef JSON_CLASS
 #define JSON_CLASS DeintOptionSet
-static const auto jio = JIO(JE(swdec), JE(hwdec));
+static const auto jio = JIO(JE(swdec), JE(hwdec), JE(threads), JE(detect));
 JSON_DECLARE_FROM_TO_FUNCTIONS
 
 DeintOptionSet::DeintOptionSet()
@@ -23,7 +23,7 @@ Q_DECLARE_METATYPE(DeintOption)
 
 struct DeintOptionSet {
     DeintOptionSet();
-    DECL_EQ(DeintOptionSet, &T::hwdec, &T::swdec);
+    DECL_EQ(DeintOptionSet, &T::hwdec, &T::swdec, &T::threads, &T::detect);
     auto option(Processor proc) const -> DeintOption
     {
         return proc == Processor::CPU ? swdec
@@ -32,6 +32,8 @@ struct DeintOptionSet {
     auto toJson() const -> QJsonObject;
     auto setFromJson(const QJsonObject &json) -> bool;
     DeintOption hwdec, swdec;
+    int threads = 0; // for filter graph of swdec, 0 for auto
+    bool detect = true; // find combing of swdec instead of trusting flags
 };
 
 Q_DECLARE_METATYPE(DeintOptionSet)
@@ -14,9 +14,105 @@ static auto null_mp_image(void *arg, void(*free)(void*)) -> mp_image*
 
 auto query_video_format(quint32 format) -> int;
 
+struct FFmpegFilterGraph::Worker : public QThread {
+    // queued input is bounded so that memory stays low on slow machines
+    static constexpr int MaxQueued = 2;
+    Worker(FFmpegFilterGraph *graph): graph(graph) { start(); }
+    ~Worker() { mutex.lock(); quit = true; wake.wakeAll(); mutex.unlock(); wait(); }
+    auto run() -> void final
+    {
+        QMutexLocker locker(&mutex);
+        forever {
+            while (!quit && input.empty())
+                wake.wait(&mutex);
+            if (quit)
+                break;
+            auto mpi = std::move(input.front());
+            input.pop_front();
+            busy = true;
+            locker.unlock();
+            std::deque<MpImage> frames;
+            if (graph->filter(mpi)) {
+                for (auto frame = graph->drain(); !frame.isNull(); frame = graph->drain())
+                    frames.push_back(std::move(frame));
+            }
+            locker.relock();
+            for (auto &frame : frames)
+                output.push_back(std::move(frame));
+            busy = false;
+            idle.wakeAll();
+        }
+    }
+    // mutex should be locked
+    auto waitForIdle() -> void
+    {
+        while (busy || !input.empty())
+            idle.wait(&mutex);
+    }
+    FFmpegFilterGraph *graph = nullptr;
+    QMutex mutex;
+    QWaitCondition wake, idle;
+    std::deque<MpImage> input, output;
+    bool quit = false, busy = false;
+};
+
+auto FFmpegFilterGraph::setPipelined(bool pipelined) -> void
+{
+    if (pipelined == !!m_worker)
+        return;
+    if (pipelined)
+        m_worker = new Worker(this);
+    else
+        _Delete(m_worker);
+}
+
 auto FFmpegFilterGraph::push(const MpImage &in) -> bool
 {
     Q_ASSERT(m_imgfmt == in->imgfmt && m_size == QSize(in->w, in->h));
+    if (!m_graph)
+        return false;
+    if (!m_worker)
+        return filter(in);
+    QMutexLocker locker(&m_worker->mutex);
+    while (m_worker->input.size() >= Worker::MaxQueued)
+        m_worker->idle.wait(&m_worker->mutex);
+    m_worker->input.push_back(in);
+    m_worker->wake.wakeAll();
+    return true;
+}
+
+auto FFmpegFilterGraph::pull() -> MpImage
+{
+    if (!m_worker)
+        return drain();
+    QMutexLocker locker(&m_worker->mutex);
+    if (m_worker->output.empty())
+        return MpImage();
+    auto mpi = std::move(m_worker->output.front());
+    m_worker->output.pop_front();
+    return mpi;
+}
+
+auto FFmpegFilterGraph::flush() -> void
+{
+    if (!m_worker)
+        return;
+    QMutexLocker locker(&m_worker->mutex);
+    m_worker->waitForIdle();
+}
+
+auto FFmpegFilterGraph::clear() -> void
+{
+    if (!m_worker)
+        return;
+    QMutexLocker locker(&m_worker->mutex);
+    m_worker->input.clear();
+    m_worker->waitForIdle();
+    m_worker->output.clear();
+}
+
+auto FFmpegFilterGraph::filter(const MpImage &in) -> bool
+{
     if (!m_graph)
         return false;
     auto src = m_src->outputs[0];
@@ -40,7 +136,7 @@ auto FFmpegFilterGraph::push(const MpImage &in) -> bool
     return ok;
 }
 
-auto FFmpegFilterGraph::pull() -> MpImage
+auto FFmpegFilterGraph::drain() -> MpImage
 {
     if (!m_graph)
         return MpImage();
@@ -53,6 +149,10 @@ auto FFmpegFilterGraph::pull() -> MpImage
     auto freeAvFrame = [](void *frame) { av_frame_free((AVFrame**)&frame); };
     auto mpi = null_mp_image(frame, freeAvFrame);
     mp_image_copy_fields_from_av_frame(mpi, frame);
+    if (frame->pts == AV_NOPTS_VALUE)
+        mpi->pts = MP_NOPTS_VALUE;
+    else
+        mpi->pts = frame->pts * av_q2d(m_sink->inputs[0]->time_base);
     return MpImage::wrap(mpi);
 }
 
@@ -122,6 +222,9 @@ auto FFmpegFilterGraph::initialize(const QString &option, const QSize &size,
     auto out = avfilter_inout_alloc();
     auto in = avfilter_inout_alloc();
     m_graph = avfilter_graph_alloc();
+    // must be set before any filter is added
+    m_graph->nb_threads = m_threads > 0 ? m_threads : QThread::idealThreadCount();
+    m_graph->thread_type = AVFILTER_THREAD_SLICE;
     if (!linkGraph(in, out))
         release();
     avfilter_inout_free(&out);
@@ -131,13 +234,15 @@ auto FFmpegFilterGraph::initialize(const QString &option, const QSize &size,
 
 auto FFmpegFilterGraph::release() -> void
 {
+    clear();
     avfilter_graph_free(&m_graph);
     m_src = m_sink = nullptr;
 }
 
 /******************************************************************************/
 
-auto BobDeinterlacer::field(DeintMethod method, const MpImage &src, bool top) const -> MpImage
+auto BobDeinterlacer::field(DeintMethod method, const MpImage &src, bool top,
+                            MpImagePool &pool) const -> MpImage
 {
     if (src->num_planes < 1)
         return src;
@@ -145,7 +250,9 @@ auto BobDeinterlacer::field(DeintMethod method, const MpImage &src, bool top) co
     if (h < 4)
         return src;
 
-    MpImage dst = std::move(newImage(src));
+    MpImage dst = pool.like(src);
+    if (dst.isNull())
+        return src;
     const int stride = src->stride[0];
     auto in = src->planes[0], out = dst->planes[0];
     auto copy = [=] (int src, int dst)
@@ -231,18 +338,3 @@ auto BobDeinterlacer::field(DeintMethod method, const MpImage &src, bool top) co
                (src->h >> src->fmt.ys[i]) * src->stride[i]);
     return dst;
 }
-
-auto BobDeinterlacer::newImage(const MpImage &mpi) const -> MpImage
-{
-    auto tmp = mp_image_pool_get(m_pool, mpi->imgfmt, mpi->stride[0], mpi->h);
-    auto img = mp_image_new_ref(tmp);
-    talloc_free(tmp);
-    img->w = mpi->w;
-    img->h = mpi->h;
-    img->stride[0] = mpi->stride[0];
-    img->stride[1] = mpi->stride[1];
-    img->stride[2] = mpi->stride[2];
-    img->stride[3] = mpi->stride[3];
-    mp_image_copy_attributes(img, (mp_image*)mpi.data());
-    return MpImage::wrap(img);
-}
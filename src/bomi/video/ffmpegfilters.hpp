@@ -18,30 +18,43 @@ extern "C" {
 
 class FFmpegFilterGraph {
 public:
-    ~FFmpegFilterGraph() { release(); }
+    FFmpegFilterGraph() = default;
+    FFmpegFilterGraph(const FFmpegFilterGraph &) = delete;
+    FFmpegFilterGraph &operator = (const FFmpegFilterGraph &) = delete;
+    ~FFmpegFilterGraph() { release(); delete m_worker; }
+    // slice threads for filters in graph, 0 for the number of cores
+    // takes effect on next initialization
+    auto setThreads(int threads) -> void { m_threads = threads; }
+    // run filters on a worker thread: push() queues and pull() never waits
+    auto setPipelined(bool pipelined) -> void;
     auto push(const MpImage &mpi) -> bool;
     auto pull() -> MpImage;
+    // wait until queued images are filtered
+    auto flush() -> void;
+    // drop queued images
+    auto clear() -> void;
     auto initialize(const QString &opt, const QSize &s, mp_imgfmt fmt) -> bool;
     auto initialize(const QString &opt, const MpImage &mpi) -> bool
         { return initialize(opt, {mpi->w, mpi->h}, mpi->imgfmt); }
 private:
+    struct Worker;
     auto release() -> void;
     auto linkGraph(AVFilterInOut *&in, AVFilterInOut *&out) -> bool;
+    auto filter(const MpImage &mpi) -> bool;
+    auto drain() -> MpImage;
     QString m_option;
     mp_imgfmt m_imgfmt = IMGFMT_NONE;
     QSize m_size = {0, 0};
+    int m_threads = 0;
     AVFilterGraph *m_graph = nullptr;
     AVFilterContext *m_src = nullptr, *m_sink = nullptr;
+    Worker *m_worker = nullptr;
 };
 
 class BobDeinterlacer {
 public:
-    BobDeinterlacer() { m_pool = mp_image_pool_new(10); }
-    ~BobDeinterlacer() { mp_image_pool_clear(m_pool); }
-    auto field(DeintMethod method, const MpImage &src, bool top) const -> MpImage;
-private:
-    auto newImage(const MpImage &mpi) const -> MpImage;
-    mp_image_pool *m_pool = nullptr;
+    auto field(DeintMethod method, const MpImage &src, bool top,
+               MpImagePool &pool) const -> MpImage;
 };
 
 
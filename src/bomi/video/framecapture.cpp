@@ -0,0 +1,146 @@
+#include "framecapture.hpp"
+#include "misc/log.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+
+DECLARE_LOG_CONTEXT(Capture)
+
+struct FrameCapture::Data {
+    mutable QMutex mutex;
+    QThreadPool pool;
+    QString folder;
+    QFile file;
+    QSize size;
+    bool running = false;
+    int serial = 0, limit = 0;
+    QAtomicInt pending = 0, written = 0, dropped = 0;
+
+    auto write(QImage frame, const QImage &osd, int serial) -> void
+    {
+        if (!osd.isNull()) {
+            QPainter painter(&frame);
+            painter.drawImage(osd.rect(), osd);
+        }
+        bool ok = false;
+        if (folder.isEmpty()) {
+            // single thread in pool keeps frame order
+            const int bytes = frame.bytesPerLine() * frame.height();
+            ok = file.write((const char*)frame.constBits(), bytes) == bytes;
+        } else {
+            const auto name = u"%1/frame-%2.png"_q.arg(folder).arg(serial, 6, 10, '0'_q);
+            // highest quality means least compression, which is fastest
+            ok = frame.save(name, "png", 100);
+        }
+        if (ok)
+            written.ref();
+        else {
+            dropped.ref();
+            _Error("Cannot write frame %%.", serial);
+        }
+        pending.deref();
+    }
+};
+
+class FrameCaptureJob : public QRunnable {
+public:
+    using Func = std::function<void(void)>;
+    FrameCaptureJob(Func &&func): m_func(std::move(func)) { }
+private:
+    auto run() -> void final { m_func(); }
+    Func m_func;
+};
+
+FrameCapture::FrameCapture()
+    : d(new Data)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+    delete d;
+}
+
+auto FrameCapture::start(const QString &path) -> bool
+{
+    stop();
+    QMutexLocker locker(&d->mutex);
+    d->folder.clear();
+    d->size = QSize();
+    d->serial = 0;
+    d->written = d->dropped = 0;
+    int threads = 1;
+    if (QFileInfo(path).isDir()) {
+        d->folder = path;
+        threads = qBound(1, QThread::idealThreadCount() - 1, 4);
+    } else {
+        bool opened = false;
+        if (path == "-"_a)
+            opened = d->file.open(stdout, QFile::WriteOnly);
+        else {
+            d->file.setFileName(path);
+            opened = d->file.open(QFile::WriteOnly | QFile::Truncate);
+        }
+        if (!opened) {
+            _Error("Cannot open '%%' for raw frames.", path);
+            return false;
+        }
+    }
+    d->pool.setMaxThreadCount(threads);
+    d->limit = threads * 2;
+    d->running = true;
+    _Info("Start capturing frames to '%%'.", path);
+    return true;
+}
+
+auto FrameCapture::stop() -> void
+{
+    d->mutex.lock();
+    const bool running = d->running;
+    d->running = false;
+    d->mutex.unlock();
+    if (!running)
+        return;
+    d->pool.waitForDone();
+    d->file.close();
+    _Info("Stop capturing frames. written: %%, dropped: %%",
+          d->written.load(), d->dropped.load());
+}
+
+auto FrameCapture::isRunning() const -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    return d->running;
+}
+
+auto FrameCapture::push(const QImage &frame, const QImage &osd) -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    if (!d->running || frame.isNull())
+        return false;
+    if (d->pending.load() >= d->limit) {
+        d->dropped.ref();
+        return false;
+    }
+    if (d->folder.isEmpty() && _Change(d->size, frame.size()))
+        _Info("Raw frames: %%x%% bgra", d->size.width(), d->size.height());
+    d->pending.ref();
+    const int serial = d->serial++;
+    d->pool.start(new FrameCaptureJob([=] () { d->write(frame, osd, serial); }));
+    return true;
+}
+
+auto FrameCapture::drop() -> void
+{
+    d->dropped.ref();
+}
+
+auto FrameCapture::written() const -> int
+{
+    return d->written.load();
+}
+
+auto FrameCapture::dropped() const -> int
+{
+    return d->dropped.load();
+}
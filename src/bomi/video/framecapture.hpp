@@ -0,0 +1,28 @@
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+// writes captured frames into numbered images in a folder or one raw stream
+// raw stream is a sequence of bgra frames for pipes, '-' means stdout
+// frames are encoded in a bounded pool and dropped when it cannot keep up
+class FrameCapture {
+public:
+    FrameCapture();
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator = (const FrameCapture &) = delete;
+    ~FrameCapture();
+    // images for existing folder, raw stream otherwise
+    auto start(const QString &path) -> bool;
+    // waits for pending frames
+    auto stop() -> void;
+    auto isRunning() const -> bool;
+    // thread-safe, osd is drawn over frame in worker
+    auto push(const QImage &frame, const QImage &osd) -> bool;
+    auto drop() -> void;
+    auto written() const -> int;
+    auto dropped() const -> int;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // FRAMECAPTURE_HPP
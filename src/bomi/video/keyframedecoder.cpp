@@ -0,0 +1,117 @@
+#include "keyframedecoder.hpp"
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+struct KeyframeDecoder::Data {
+    AVFormatContext *format = nullptr;
+    AVCodecContext *codec = nullptr;
+    AVFrame *frame = nullptr;
+    SwsContext *sws = nullptr;
+    int stream = -1;
+    qint64 position = -1;
+};
+
+KeyframeDecoder::KeyframeDecoder()
+    : d(new Data)
+{
+}
+
+KeyframeDecoder::~KeyframeDecoder()
+{
+    sws_freeContext(d->sws);
+    av_frame_free(&d->frame);
+    if (d->codec)
+        avcodec_close(d->codec);
+    avformat_close_input(&d->format);
+    delete d;
+}
+
+auto KeyframeDecoder::open(const QByteArray &path) -> bool
+{
+    if (avformat_open_input(&d->format, path.constData(), nullptr, nullptr) < 0)
+        return false;
+    if (avformat_find_stream_info(d->format, nullptr) < 0 || d->format->duration <= 0)
+        return false;
+    AVCodec *dec = nullptr;
+    d->stream = av_find_best_stream(d->format, AVMEDIA_TYPE_VIDEO, -1, -1, &dec, 0);
+    if (d->stream < 0 || !dec)
+        return false;
+    for (uint i = 0; i < d->format->nb_streams; ++i) {
+        if ((int)i != d->stream)
+            d->format->streams[i]->discard = AVDISCARD_ALL;
+    }
+    // only keyframes are shown, so skip everything else
+    auto ctx = d->format->streams[d->stream]->codec;
+    ctx->skip_frame = AVDISCARD_NONKEY;
+    ctx->skip_loop_filter = AVDISCARD_ALL;
+    if (avcodec_open2(ctx, dec, nullptr) < 0)
+        return false;
+    d->codec = ctx;
+    d->frame = av_frame_alloc();
+    return d->frame && d->codec->width > 0 && d->codec->height > 0;
+}
+
+auto KeyframeDecoder::duration() const -> qint64
+{
+    return d->format ? d->format->duration : 0;
+}
+
+auto KeyframeDecoder::aspect() const -> double
+{
+    auto sar = av_guess_sample_aspect_ratio(d->format, d->format->streams[d->stream], nullptr);
+    const double ratio = sar.num > 0 && sar.den > 0 ? av_q2d(sar) : 1.0;
+    return d->codec->width * ratio / d->codec->height;
+}
+
+auto KeyframeDecoder::decode(qint64 us) -> bool
+{
+    d->position = -1;
+    const qint64 start = d->format->start_time != AV_NOPTS_VALUE ? d->format->start_time : 0;
+    if (av_seek_frame(d->format, -1, us + start, AVSEEK_FLAG_BACKWARD) < 0)
+        return false;
+    avcodec_flush_buffers(d->codec);
+    AVPacket packet;
+    for (int i = 0; i < 256 && av_read_frame(d->format, &packet) >= 0; ++i) {
+        int got = 0;
+        if (packet.stream_index == d->stream)
+            avcodec_decode_video2(d->codec, d->frame, &got, &packet);
+        av_free_packet(&packet);
+        if (got) {
+            const auto ts = av_frame_get_best_effort_timestamp(d->frame);
+            if (ts != AV_NOPTS_VALUE) {
+                const auto tb = d->format->streams[d->stream]->time_base;
+                d->position = qMax<qint64>(0, av_rescale_q(ts, tb, AV_TIME_BASE_Q) - start);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+auto KeyframeDecoder::position() const -> qint64
+{
+    return d->position;
+}
+
+auto KeyframeDecoder::draw(QImage &image, const QRect &rect) -> bool
+{
+    return draw(image.bits(), image.bytesPerLine(), rect);
+}
+
+auto KeyframeDecoder::draw(uchar *bits, int stride, const QRect &rect) -> bool
+{
+    auto frame = d->frame;
+    d->sws = sws_getCachedContext(d->sws, frame->width, frame->height,
+                                  (AVPixelFormat)frame->format,
+                                  rect.width(), rect.height(), AV_PIX_FMT_RGB32,
+                                  SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!d->sws)
+        return false;
+    uint8_t *dst[] = { bits + rect.y() * stride + rect.x() * 4, nullptr, nullptr, nullptr };
+    int strides[] = { stride, 0, 0, 0 };
+    sws_scale(d->sws, frame->data, frame->linesize, 0, frame->height, dst, strides);
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef KEYFRAMEDECODER_HPP
+#define KEYFRAMEDECODER_HPP
+
+// decodes only keyframes of video stream with ffmpeg directly, without mpv
+// one instance is used by one thread at a time
+class KeyframeDecoder {
+public:
+    KeyframeDecoder();
+    KeyframeDecoder(const KeyframeDecoder &) = delete;
+    KeyframeDecoder &operator = (const KeyframeDecoder &) = delete;
+    ~KeyframeDecoder();
+    auto open(const QByteArray &path) -> bool;
+    // in us
+    auto duration() const -> qint64;
+    auto aspect() const -> double;
+    // decode keyframe before us
+    auto decode(qint64 us) -> bool;
+    // us of decoded keyframe from start of file, negative if unknown
+    auto position() const -> qint64;
+    // scale decoded frame into rect of RGB32 image directly
+    auto draw(QImage &image, const QRect &rect) -> bool;
+    // same for image whose bits are shared by threads drawing other rects
+    auto draw(uchar *bits, int stride, const QRect &rect) -> bool;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // KEYFRAMEDECODER_HPP
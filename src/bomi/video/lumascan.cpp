@@ -0,0 +1,136 @@
+#include "lumascan.hpp"
+#include "mpimage.hpp"
+
+#if defined(__SSE2__)
+#define LUMA_SCAN_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LUMA_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+// minimum number of rows to be sampled
+static constexpr int MinRows = 256;
+
+#if LUMA_SCAN_SSE2
+SIA horizontal(__m128i acc) -> quint64
+{
+    alignas(16) quint64 lanes[2];
+    _mm_store_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1];
+}
+#endif
+
+// sum of count luma bytes: planar for skip 1, packed 4:2:2 for skip 2
+// offset is the position of luma in a pair for packed formats
+template<int skip, int offset = 0>
+static auto sum8(const uchar *p, int count) -> quint64
+{
+    static_assert(skip == 1 || (skip == 2 && offset < 2), "wrong layout");
+    quint64 sum = 0;
+    int i = 0;
+    constexpr int bytes = 16, pixels = bytes / skip;
+#if LUMA_SCAN_SSE2
+    // psadbw against zero sums 8 bytes at once, chroma is removed first
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i acc = zero;
+    for (; i + pixels <= count; i += pixels, p += bytes) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        if (skip == 2)
+            v = offset ? _mm_srli_epi16(v, 8) : _mm_and_si128(v, mask);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    sum = horizontal(acc);
+#elif LUMA_SCAN_NEON
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + pixels <= count; i += pixels, p += bytes) {
+        uint8x16_t v = vld1q_u8(p);
+        if (skip == 2) {
+            const uint16x8_t w = vreinterpretq_u16_u8(v);
+            v = vreinterpretq_u8_u16(offset ? vshrq_n_u16(w, 8)
+                                            : vandq_u16(w, vdupq_n_u16(0x00ff)));
+        }
+        acc = vpadalq_u16(acc, vpaddlq_u8(v));
+    }
+    sum = quint64(vgetq_lane_u32(acc, 0)) + vgetq_lane_u32(acc, 1)
+        + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (p += offset; i < count; ++i, p += skip)
+        sum += *p;
+    return sum;
+}
+
+static auto sum16(const quint16 *p, int count) -> quint64
+{
+    quint64 sum = 0;
+    int i = 0;
+#if LUMA_SCAN_SSE2
+    // pmaddwd would treat samples as signed, so widen to 32 bits first
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; i + 8 <= count; i += 8, p += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)p);
+        const __m128i s = _mm_add_epi32(_mm_unpacklo_epi16(v, zero),
+                                        _mm_unpackhi_epi16(v, zero));
+        acc = _mm_add_epi64(acc, _mm_add_epi64(_mm_unpacklo_epi32(s, zero),
+                                               _mm_unpackhi_epi32(s, zero)));
+    }
+    sum = horizontal(acc);
+#elif LUMA_SCAN_NEON
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 8 <= count; i += 8, p += 8)
+        acc = vpadalq_u32(acc, vpaddlq_u16(vld1q_u16(p)));
+    sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    for (; i < count; ++i)
+        sum += *p++;
+    return sum;
+}
+
+template<class F>
+static auto average(const mp_image *mpi, int step, F &&sumLine) -> double
+{
+    if (step <= 0)
+        step = std::max(1, mpi->h / MinRows);
+    const uchar *const data = mpi->planes[0];
+    quint64 sum = 0; int rows = 0;
+    for (int y = 0; y < mpi->h; y += step, ++rows)
+        sum += sumLine(data + y * mpi->stride[0], mpi->w);
+    if (!rows || mpi->w <= 0)
+        return -1;
+    const int bits = mpi->fmt.plane_bits;
+    double avg = double(sum) / (double(rows) * mpi->w);
+    avg /= (1 << bits) - 1;
+    if (mpi->params.colorlevels == MP_CSP_LEVELS_TV)
+        avg = (avg - 16.0/255)*255.0/(235.0 - 16.0);
+    return avg;
+}
+
+auto _LumaScan(const mp_image *mpi, int step) -> double
+{
+    switch (mpi->imgfmt) {
+    case IMGFMT_420P:   case IMGFMT_NV12:   case IMGFMT_NV21:
+    case IMGFMT_444P:   case IMGFMT_422P:   case IMGFMT_440P:
+    case IMGFMT_411P:   case IMGFMT_410P:   case IMGFMT_Y8:
+    case IMGFMT_444AP:  case IMGFMT_422AP:  case IMGFMT_420AP:
+        return average(mpi, step, [] (const uchar *p, int w)
+            { return sum8<1>(p, w); });
+    case IMGFMT_444P16: case IMGFMT_444P14: case IMGFMT_444P12:
+    case IMGFMT_444P10: case IMGFMT_444P9:  case IMGFMT_422P16:
+    case IMGFMT_422P14: case IMGFMT_422P12: case IMGFMT_422P10:
+    case IMGFMT_422P9:  case IMGFMT_420P16: case IMGFMT_420P14:
+    case IMGFMT_420P12: case IMGFMT_420P10: case IMGFMT_420P9:
+    case IMGFMT_Y16:
+        return average(mpi, step, [] (const uchar *p, int w)
+            { return sum16((const quint16*)p, w); });
+    case IMGFMT_YUYV:
+        return average(mpi, step, [] (const uchar *p, int w)
+            { return sum8<2, 0>(p, w); });
+    case IMGFMT_UYVY:
+        return average(mpi, step, [] (const uchar *p, int w)
+            { return sum8<2, 1>(p, w); });
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef LUMASCAN_HPP
+#define LUMASCAN_HPP
+
+struct mp_image;
+
+// average luma of mpi in [0, 1] from every step-th row
+// step <= 0 picks a step from image height
+// returns negative value if format is not supported
+auto _LumaScan(const mp_image *mpi, int step = 0) -> double;
+
+#endif // LUMASCAN_HPP
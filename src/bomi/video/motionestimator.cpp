@@ -0,0 +1,237 @@
+#include "motionestimator.hpp"
+#include "mpimage.hpp"
+
+#if defined(__SSE2__)
+#define MOTION_ESTIMATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// mean absolute difference per pixel above which a block is blended in place
+static constexpr int BadMatch = 24;
+// smallest matching window at coarse levels
+static constexpr int MinWindow = 8;
+
+struct Params { int levels, block, range, refine; };
+
+static const Params s_params[] = {
+    { 2, 16, 4, 1 }, // Fast
+    { 3, 16, 6, 1 }, // Balanced
+    { 3,  8, 8, 2 }  // Best
+};
+
+struct Plane {
+    const uchar *data = nullptr;
+    int w = 0, h = 0, stride = 0;
+    auto at(int x, int y) const -> const uchar* { return data + y * stride + x; }
+};
+
+struct Vector { int x = 0, y = 0, sad = 0; };
+
+static auto sad(const uchar *a, int sa, const uchar *b, int sb, int w, int h) -> int
+{
+    int sum = 0;
+#if MOTION_ESTIMATOR_SSE2
+    if (!(w & 7)) {
+        __m128i acc = _mm_setzero_si128();
+        for (int y = 0; y < h; ++y, a += sa, b += sb) {
+            int x = 0;
+            for (; x + 16 <= w; x += 16) {
+                const auto va = _mm_loadu_si128((const __m128i*)(a + x));
+                const auto vb = _mm_loadu_si128((const __m128i*)(b + x));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+            }
+            if (x < w) {
+                const auto va = _mm_loadl_epi64((const __m128i*)(a + x));
+                const auto vb = _mm_loadl_epi64((const __m128i*)(b + x));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+            }
+        }
+        return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc));
+    }
+#endif
+    for (int y = 0; y < h; ++y, a += sa, b += sb) {
+        for (int x = 0; x < w; ++x)
+            sum += qAbs(a[x] - b[x]);
+    }
+    return sum;
+}
+
+struct Pyramid {
+    std::vector<Plane> planes;
+    std::vector<std::vector<uchar>> storage;
+    auto build(const mp_image *mpi, int levels) -> void
+    {
+        planes.resize(levels);
+        storage.resize(levels);
+        auto &base = planes[0];
+        base.data = mpi->planes[0];
+        base.w = mpi->w; base.h = mpi->h; base.stride = mpi->stride[0];
+        for (int l = 1; l < levels; ++l) {
+            const auto &src = planes[l - 1];
+            auto &dst = planes[l];
+            dst.w = src.w / 2; dst.h = src.h / 2; dst.stride = dst.w;
+            storage[l].resize(dst.w * dst.h);
+            auto out = storage[l].data();
+            for (int y = 0; y < dst.h; ++y) {
+                const uchar *r0 = src.at(0, 2 * y), *r1 = r0 + src.stride;
+                for (int x = 0; x < dst.w; ++x, r0 += 2, r1 += 2)
+                    *out++ = (r0[0] + r0[1] + r1[0] + r1[1] + 2) >> 2;
+            }
+            dst.data = storage[l].data();
+        }
+    }
+};
+
+struct MotionEstimator::Data {
+    Quality quality = Balanced;
+    Pyramid prev, next;
+    int bw = 0, bh = 0; // number of blocks
+    std::vector<Vector> vectors, coarse;
+
+    auto params() const -> const Params& { return s_params[quality]; }
+
+    // search around predictors in level l, window is centered on block
+    auto search(int l, int bx, int by, const Vector *predictors, int count,
+                int range) const -> Vector
+    {
+        const auto &a = prev.planes[l], &b = next.planes[l];
+        const int block = params().block >> l;
+        const int win = std::max(block, MinWindow);
+        const int cx = ((bx * params().block + params().block / 2) >> l) - win / 2;
+        const int cy = ((by * params().block + params().block / 2) >> l) - win / 2;
+        const int x0 = qBound(0, cx, a.w - win), y0 = qBound(0, cy, a.h - win);
+        Vector best; best.sad = std::numeric_limits<int>::max();
+        auto test = [&] (int vx, int vy) {
+            const int x1 = x0 + vx, y1 = y0 + vy;
+            if (x1 < 0 || y1 < 0 || x1 + win > b.w || y1 + win > b.h)
+                return;
+            const int s = sad(a.at(x0, y0), a.stride, b.at(x1, y1), b.stride, win, win)
+                    + (qAbs(vx) + qAbs(vy)); // prefer short vectors on ties
+            if (s < best.sad) {
+                best.x = vx; best.y = vy; best.sad = s;
+            }
+        };
+        for (int i = 0; i < count; ++i) {
+            const auto &p = predictors[i];
+            for (int dy = -range; dy <= range; ++dy)
+                for (int dx = -range; dx <= range; ++dx)
+                    test(p.x + dx, p.y + dy);
+        }
+        if (best.sad == std::numeric_limits<int>::max())
+            best = Vector();
+        best.sad = best.sad * 256 / (win * win); // per pixel in 1/256
+        return best;
+    }
+};
+
+MotionEstimator::MotionEstimator()
+    : d(new Data)
+{
+
+}
+
+MotionEstimator::~MotionEstimator()
+{
+    delete d;
+}
+
+auto MotionEstimator::setQuality(Quality quality) -> void
+{
+    d->quality = quality;
+}
+
+auto MotionEstimator::quality() const -> Quality
+{
+    return d->quality;
+}
+
+auto MotionEstimator::supports(const mp_image *mpi) -> bool
+{
+    switch (mpi->imgfmt) {
+    case IMGFMT_420P: case IMGFMT_422P: case IMGFMT_444P:
+    case IMGFMT_440P: case IMGFMT_411P: case IMGFMT_Y8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+auto MotionEstimator::estimate(const MpImage &prev, const MpImage &next) -> bool
+{
+    if (prev.isNull() || next.isNull() || !supports(prev.data())
+            || prev->imgfmt != next->imgfmt || prev->w != next->w || prev->h != next->h)
+        return false;
+    const auto &params = d->params();
+    int levels = params.levels;
+    while (levels > 1 && std::min(prev->w, prev->h) >> (levels - 1) < 4 * MinWindow)
+        --levels;
+    if (std::min(prev->w, prev->h) < 2 * MinWindow)
+        return false;
+    d->prev.build(prev.data(), levels);
+    d->next.build(next.data(), levels);
+    d->bw = (prev->w + params.block - 1) / params.block;
+    d->bh = (prev->h + params.block - 1) / params.block;
+    for (int l = levels - 1; l >= 0; --l) {
+        d->coarse.swap(d->vectors);
+        d->vectors.assign(d->bw * d->bh, Vector());
+        const bool top = l == levels - 1;
+        const int range = top ? params.range : params.refine;
+        for (int by = 0; by < d->bh; ++by) {
+            for (int bx = 0; bx < d->bw; ++bx) {
+                const int i = by * d->bw + bx;
+                Vector candidates[3]; int count = 0;
+                // predictor from coarser level and causal neighbors in this level
+                if (!top) {
+                    candidates[count++] = { d->coarse[i].x * 2, d->coarse[i].y * 2, 0 };
+                    if (bx > 0)
+                        candidates[count++] = d->vectors[i - 1];
+                    if (by > 0)
+                        candidates[count++] = d->vectors[i - d->bw];
+                } else
+                    candidates[count++] = Vector();
+                d->vectors[i] = d->search(l, bx, by, candidates, count, range);
+            }
+        }
+    }
+    return true;
+}
+
+auto MotionEstimator::synthesize(MpImage &dst, const MpImage &prev,
+                                 const MpImage &next, double t) const -> void
+{
+    const int block = d->params().block;
+    const int t256 = qBound(0, qRound(t * 256), 256);
+    for (int p = 0; p < prev->num_planes; ++p) {
+        const int xs = prev->fmt.xs[p], ys = prev->fmt.ys[p];
+        const int w = (prev->w + (1 << xs) - 1) >> xs;
+        const int h = (prev->h + (1 << ys) - 1) >> ys;
+        const int bw = block >> xs, bh = block >> ys;
+        const uchar *a = prev->planes[p], *b = next->planes[p];
+        const int sa = prev->stride[p], sb = next->stride[p], so = dst->stride[p];
+        for (int by = 0; by < d->bh; ++by) {
+            for (int bx = 0; bx < d->bw; ++bx) {
+                const auto &v = d->vectors[by * d->bw + bx];
+                int ax = 0, ay = 0, nx = 0, ny = 0;
+                if (v.sad <= BadMatch * 256) {
+                    // content at q comes from q - t*v in prev and q + (1 - t)*v in next
+                    ax = -((v.x * t256 + 128) >> 8) >> xs;
+                    ay = -((v.y * t256 + 128) >> 8) >> ys;
+                    nx = ((v.x * (256 - t256) + 128) >> 8) >> xs;
+                    ny = ((v.y * (256 - t256) + 128) >> 8) >> ys;
+                }
+                const int x0 = bx * bw, y0 = by * bh;
+                const int x1 = std::min(w, x0 + bw), y1 = std::min(h, y0 + bh);
+                for (int y = y0; y < y1; ++y) {
+                    const uchar *ra = a + qBound(0, y + ay, h - 1) * sa;
+                    const uchar *rb = b + qBound(0, y + ny, h - 1) * sb;
+                    uchar *out = dst->planes[p] + y * so;
+                    for (int x = x0; x < x1; ++x) {
+                        const int pa = ra[qBound(0, x + ax, w - 1)];
+                        const int pb = rb[qBound(0, x + nx, w - 1)];
+                        out[x] = (pa * (256 - t256) + pb * t256 + 128) >> 8;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef MOTIONESTIMATOR_HPP
+#define MOTIONESTIMATOR_HPP
+
+class MpImage;                          struct mp_image;
+
+// block matching motion estimation on a downscaled luma pyramid
+// and motion compensated synthesis of intermediate frames
+// only 8-bit planar YCbCr is supported
+
+class MotionEstimator {
+public:
+    enum Quality { Fast, Balanced, Best };
+    MotionEstimator();
+    ~MotionEstimator();
+    auto setQuality(Quality quality) -> void;
+    auto quality() const -> Quality;
+    static auto supports(const mp_image *mpi) -> bool;
+    // vectors from prev to next, both must have same format and size
+    auto estimate(const MpImage &prev, const MpImage &next) -> bool;
+    // write frame at t in [0, 1] between prev and next into dst
+    // dst has the format and size of prev
+    auto synthesize(MpImage &dst, const MpImage &prev,
+                    const MpImage &next, double t) const -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // MOTIONESTIMATOR_HPP
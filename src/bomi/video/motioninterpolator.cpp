@@ -1,13 +1,26 @@
 #include "motioninterpolator.hpp"
 #include "mpimage.hpp"
+#include "motionestimator.hpp"
+#include "motionintrploption.hpp"
 #include "misc/log.hpp"
 #include "tmp/algorithm.hpp"
+#include <QElapsedTimer>
+
+DECLARE_LOG_CONTEXT(Video)
+
+// number of consecutive source frames slower than budget before giving up
+static constexpr int MaxSlowFrames = 10;
 
 struct MotionInterpolator::Data {
     MotionInterpolator *p = nullptr;
     std::deque<MpImage> queue;
     bool eof = false;
     double dt = -1;
+    bool compensate = false;
+    int slow = 0;
+    MpImage source;
+    MotionEstimator estimator;
+    QElapsedTimer timer;
     auto next() const -> double
     {
         Q_ASSERT(!queue.empty() && dt > 0);
@@ -32,6 +45,40 @@ struct MotionInterpolator::Data {
         mpi->fields |= additional;
         queue.push_back(std::move(mpi));
     }
+
+    auto canCompensate(const MpImage &next) const -> bool
+    {
+        return compensate && p->pool() && !source.isNull()
+                && source->pts != MP_NOPTS_VALUE && next->pts > source->pts
+                && MotionEstimator::supports(next.data());
+    }
+
+    // frame at pts between source and next
+    auto synthesize(const MpImage &next, double pts) const -> MpImage
+    {
+        const double t = (pts - source->pts) / (next->pts - source->pts);
+        if (t >= 0.99)
+            return next;
+        auto dst = p->pool()->like(next);
+        if (dst.isNull())
+            return next;
+        estimator.synthesize(dst, source, next, std::max(0.0, t));
+        return dst;
+    }
+
+    // fall back to repeating when motion compensation cannot keep up
+    auto measure(double budget) -> void
+    {
+        if (timer.nsecsElapsed() * 1e-9 <= budget) {
+            slow = 0;
+            return;
+        }
+        if (++slow < MaxSlowFrames)
+            return;
+        _Warn("Motion compensation is too slow. Fall back to blending.");
+        compensate = false;
+        source.release();
+    }
 };
 
 MotionInterpolator::MotionInterpolator()
@@ -50,14 +97,23 @@ auto MotionInterpolator::push(MpImage &&mpi) -> void
     d->eof = mpi.isNull();
     if (d->eof)
         return;
-    if (d->queue.empty() || d->dt < 0 || mpi->pts < d->next())
+    if (d->queue.empty() || d->dt < 0 || mpi->pts < d->next()) {
+        if (d->compensate)
+            d->source = mpi;
         d->push(std::move(mpi), mpi->pts, false);
-    else {
+    } else {
+        d->timer.start();
+        const bool mc = d->canCompensate(mpi) && d->estimator.estimate(d->source, mpi);
         int additional = 0;
         do {
-            d->push(std::move(MpImage(mpi)), d->next(), additional);
+            const auto pts = d->next();
+            d->push(mc ? d->synthesize(mpi, pts) : MpImage(mpi), pts, additional);
             additional = MP_IMGFIELD_ADDITIONAL;
         } while (d->next() < mpi->pts);
+        if (mc)
+            d->measure((mpi->pts - d->source->pts) * 0.5);
+        if (d->compensate)
+            d->source = std::move(mpi);
     }
 }
 
@@ -76,6 +132,7 @@ auto MotionInterpolator::pop() -> MpImage
 auto MotionInterpolator::clear() -> void
 {
     d->queue.clear();
+    d->source.release();
     d->eof = false;
 }
 
@@ -84,6 +141,16 @@ auto MotionInterpolator::setTargetFps(double fps) -> void
     d->dt = 1.0/fps;
 }
 
+auto MotionInterpolator::setOption(const MotionIntrplOption &option) -> void
+{
+    setTargetFps(option.fps());
+    d->compensate = option.compensate;
+    d->estimator.setQuality((MotionEstimator::Quality)qBound(0, option.quality, 2));
+    d->slow = 0;
+    if (!d->compensate)
+        d->source.release();
+}
+
 auto MotionInterpolator::fpsManipulation() const -> double
 {
     return 1.0/d->dt;
@@ -3,7 +3,7 @@
 
 #include "videofilter.hpp"
 
-class MpImage;
+class MpImage;                          struct MotionIntrplOption;
 
 class MotionInterpolator : public VideoFilter {
 public:
@@ -14,6 +14,7 @@ public:
     auto clear() -> void;
     auto needsMore() const -> bool;
     auto setTargetFps(double fpsManipulation) -> void;
+    auto setOption(const MotionIntrplOption &option) -> void;
     auto fpsManipulation() const -> double final;
 private:
     struct Data;
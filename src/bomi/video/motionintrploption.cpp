@@ -5,7 +5,8 @@
 
 #define JSON_CLASS MotionIntrplOption
 
-static const auto jio = JIO(JE(sync_to_monitor), JE(target_fps));
+static const auto jio = JIO(JE(sync_to_monitor), JE(target_fps),
+                            JE(compensate), JE(quality));
 
 JSON_DECLARE_FROM_TO_FUNCTIONS
 
@@ -22,6 +23,8 @@ struct MotionIntrplOptionWidget::Data {
     QButtonGroup *g = nullptr;
     QLabel *detected = nullptr;
     QDoubleSpinBox *fps = nullptr;
+    QCheckBox *compensate = nullptr;
+    QComboBox *quality = nullptr;
 };
 
 MotionIntrplOptionWidget::MotionIntrplOptionWidget(QWidget *parent)
@@ -52,6 +55,15 @@ MotionIntrplOptionWidget::MotionIntrplOptionWidget(QWidget *parent)
     hbox->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding));
     vbox->addLayout(hbox);
 
+    d->compensate = new QCheckBox(tr("Motion compensation"));
+    d->quality = new QComboBox;
+    d->quality->addItems({ tr("Fast"), tr("Balanced"), tr("Best") });
+    hbox = new QHBoxLayout;
+    hbox->addWidget(d->compensate);
+    hbox->addWidget(d->quality);
+    hbox->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding));
+    vbox->addLayout(hbox);
+
     setLayout(vbox);
 
     d->g->addButton(r1, Sync);
@@ -60,8 +72,12 @@ MotionIntrplOptionWidget::MotionIntrplOptionWidget(QWidget *parent)
     auto signal = &MotionIntrplOptionWidget::optionChanged;
     PLUG_CHANGED(d->g);
     PLUG_CHANGED(d->fps);
+    PLUG_CHANGED(d->compensate);
+    PLUG_CHANGED(d->quality);
     connect(r2, &QRadioButton::toggled, d->fps, &QWidget::setEnabled);
+    connect(d->compensate, &QCheckBox::toggled, d->quality, &QWidget::setEnabled);
     d->fps->setEnabled(false);
+    d->quality->setEnabled(false);
 }
 
 MotionIntrplOptionWidget::~MotionIntrplOptionWidget()
@@ -74,6 +90,8 @@ auto MotionIntrplOptionWidget::option() const -> MotionIntrplOption
     MotionIntrplOption option;
     option.sync_to_monitor = d->g->checkedId() == Sync;
     option.target_fps = d->fps->value();
+    option.compensate = d->compensate->isChecked();
+    option.quality = d->quality->currentIndex();
     return option;
 }
 
@@ -84,6 +102,8 @@ auto MotionIntrplOptionWidget::setOption(const MotionIntrplOption &option) -> vo
     else
         d->g->button(Target)->setChecked(true);
     d->fps->setValue(option.target_fps);
+    d->compensate->setChecked(option.compensate);
+    d->quality->setCurrentIndex(qBound(0, option.quality, 2));
 }
 
 auto MotionIntrplOptionWidget::showEvent(QShowEvent *e) -> void
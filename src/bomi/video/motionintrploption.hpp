@@ -3,9 +3,13 @@
 
 struct MotionIntrplOption
 {
-    DECL_EQ(MotionIntrplOption, &T::sync_to_monitor, &T::target_fps)
+    DECL_EQ(MotionIntrplOption, &T::sync_to_monitor, &T::target_fps,
+            &T::compensate, &T::quality)
     bool sync_to_monitor = true;
     double target_fps = 60;
+    // synthesize frames from motion vectors instead of repeating them
+    bool compensate = false;
+    int quality = 1; // MotionEstimator::Quality
     auto fps() const -> double;
     auto toJson() const -> QJsonObject;
     auto setFromJson(const QJsonObject &json) -> bool;
@@ -1 +1,50 @@
 #include "mpimage.hpp"
+extern "C" {
+#include <video/mp_image_pool.h>
+}
+
+static QAtomicInteger<quint64> s_allocations{0};
+
+MpImagePool::MpImagePool(int max)
+{
+    m_pool = mp_image_pool_new(max);
+}
+
+MpImagePool::~MpImagePool()
+{
+    talloc_free(m_pool);
+}
+
+auto MpImagePool::get(int imgfmt, int w, int h) -> MpImage
+{
+    auto mpi = mp_image_pool_get_no_alloc(m_pool, imgfmt, w, h);
+    if (!mpi) {
+        s_allocations.ref();
+        mpi = mp_image_pool_get(m_pool, imgfmt, w, h);
+    }
+    return MpImage::wrap(mpi);
+}
+
+auto MpImagePool::allocations() -> quint64
+{
+    return s_allocations.load();
+}
+
+auto MpImagePool::like(const MpImage &mpi) -> MpImage
+{
+    // allocate with stride as width to keep the row layout of source
+    auto img = get(mpi->imgfmt, mpi->stride[0], mpi->h);
+    if (img.isNull())
+        return img;
+    img->w = mpi->w;
+    img->h = mpi->h;
+    for (int i = 0; i < 4; ++i)
+        img->stride[i] = mpi->stride[i];
+    mp_image_copy_attributes(img.data(), (mp_image*)mpi.data());
+    return img;
+}
+
+auto MpImagePool::clear() -> void
+{
+    mp_image_pool_clear(m_pool);
+}
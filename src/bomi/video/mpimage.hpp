@@ -44,6 +44,27 @@ private:
     mp_image *m = nullptr;
 };
 
+struct mp_image_pool;
+
+// reuses images keyed by format and size
+// an image returns to pool when its last reference is released
+class MpImagePool {
+public:
+    MpImagePool(int max = 10);
+    ~MpImagePool();
+    MpImagePool(const MpImagePool &) = delete;
+    MpImagePool &operator = (const MpImagePool &) = delete;
+    auto get(int imgfmt, int w, int h) -> MpImage;
+    // image with same format, size, strides and attributes as mpi
+    // contents are not copied
+    auto like(const MpImage &mpi) -> MpImage;
+    auto clear() -> void;
+    // images newly allocated by any pool so far
+    static auto allocations() -> quint64;
+private:
+    mp_image_pool *m_pool = nullptr;
+};
+
 namespace std {
 template <>
 inline auto swap(MpImage &lhs, MpImage &rhs) -> void { lhs.swap(rhs); }
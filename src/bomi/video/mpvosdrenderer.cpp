@@ -1,21 +1,64 @@
 #include "mpvosdrenderer.hpp"
 #include "opengl/openglvertex.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglpixelbufferring.hpp"
+#include "opengl/openglshadercache.hpp"
 #include "tmp/static_op.hpp"
 #include <QOpenGLBuffer>
 extern "C" {
 #include <sub/osd.h>
 }
 
-enum Attr {AttrPosition, AttrTexCoord, AttrColor};
+enum Attr {AttrPosition, AttrTexCoord, AttrColor, AttrCorner};
 using Vertex = OGL::TextureColorVertex;
 
+// one part as an instance of unit quad, pos/size and texPos/texSize are vec4
+struct Instance {
+    OGL::CoordAttr pos, size, texPos, texSize;
+    OGL::ColorAttr color;
+};
+
+static const OGL::CoordAttr corners[] = {
+    {0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1}
+};
+
 struct PartInfo {
     QPoint map = {0, 0};
     quint32 color = 0;
     int strideAsPixel = 0;
+    const void *data = nullptr; // bitmap or offset in pbo
+    // last uploaded bitmap and drawn geometry
+    uint hash = 0;
+    QSize size = {0, 0};
+    QRect pos;
+    bool dirty = true;
 };
 
+static constexpr int shifts[] = { 0, 0, 2, 2 };
+
+// bytes in padding of each line are not hashed
+static auto hashBitmap(const sub_bitmap &img, int shift) -> uint
+{
+    // qHashBits() would need qt 5.4
+    auto line = static_cast<const char*>(img.bitmap);
+    const int bytes = img.w << shift;
+    uint hash = 0;
+    for (int y = 0; y < img.h; ++y, line += img.stride)
+        hash = qHash(QByteArray::fromRawData(line, bytes), hash);
+    return hash;
+}
+
+SIA alignment(int stride) -> int
+{
+    if (!tmp::remainder<8>(stride))
+        return 8;
+    if (!tmp::remainder<4>(stride))
+        return 4;
+    if (!tmp::remainder<2>(stride))
+        return 2;
+    return 1;
+}
+
 struct MpvOsdRenderer::Data {
     MpvOsdRenderer *p = nullptr;
     struct {
@@ -27,29 +70,48 @@ struct MpvOsdRenderer::Data {
     bool clear = false;
     QSize atlasSize = {0, 0};
     int format = SUBBITMAP_LIBASS;
-    int loc_atlas = 0, loc_matrix = 0;
+    int loc_matrix = 0;
     QOpenGLShaderProgram *shader = nullptr;
+    QHash<int, QOpenGLShaderProgram*> shaders;
     OpenGLFramebufferObject *fbo = nullptr;
     OpenGLTexture2D atlas;
+    OpenGLPixelBufferRing pbo;
     OpenGLTextureTransferInfo transfer;
     QMatrix4x4 vMatrix;
-    QOpenGLBuffer vbo{QOpenGLBuffer::VertexBuffer};
-    int prevVboSize = 0;
+    // geometry is streamed through ring each draw,
+    // staged copies only grow up to high-water mark of parts
+    OpenGLPixelBufferRing vbo{3, GL_ARRAY_BUFFER};
+    QOpenGLBuffer quad{QOpenGLBuffer::VertexBuffer};
+    QVector<Instance> instances;
+    QVector<Vertex> vertices;
+    int packed = 0, drawn = 0;
     QOpenGLFunctions *func = nullptr;
+    auto (QOPENGLF_APIENTRYP vertexAttribDivisor)(GLuint, GLuint) -> void = nullptr;
+    auto (QOPENGLF_APIENTRYP drawArraysInstanced)(GLenum, GLint, GLsizei,
+                                                  GLsizei) -> void = nullptr;
     QVector<PartInfo> parts;
 
+    auto isInstanced() const -> bool { return drawArraysInstanced; }
+
     auto build(int inFormat) -> void
     {
         if (!_Change(format, inFormat) && shader)
             return;
-        _Renew(shader);
         atlasSize = {};
         const auto tformat = format & SUBBITMAP_RGBA ? OGL::BGRA
                                                      : OGL::OneComponent;
         transfer = OpenGLTextureTransferInfo::get(tformat);
-        QByteArray frag;
+        // formats can alternate, so keep every program once linked
+        shader = shaders.value(format);
+        if (!shader)
+            shader = link();
+        loc_matrix = shader->uniformLocation("matrix");
+    }
+    auto link() -> QOpenGLShaderProgram*
+    {
+        OpenGLShaderCache::Source source;
         if (format == SUBBITMAP_LIBASS) {
-            frag = R"(
+            source.fragment = R"(
                     uniform sampler2D atlas;
             varying vec4 c;
             varying vec2 texCoord;
@@ -59,7 +121,7 @@ struct MpvOsdRenderer::Data {
             }
             )";
         } else {
-            frag = R"(
+            source.fragment = R"(
                     uniform sampler2D atlas;
             varying vec2 texCoord;
             void main() {
@@ -67,9 +129,23 @@ struct MpvOsdRenderer::Data {
             }
             )";
         }
-        shader->removeAllShaders();
-        shader->addShaderFromSourceCode(QOpenGLShader::Fragment, frag);
-        shader->addShaderFromSourceCode(QOpenGLShader::Vertex, R"(
+        if (isInstanced()) {
+            source.vertex = R"(
+            uniform mat4 matrix;
+            varying vec4 c;
+            varying vec2 texCoord;
+            attribute vec4 aPosition;
+            attribute vec4 aTexCoord;
+            attribute vec4 aColor;
+            attribute vec2 aCorner;
+            void main() {
+                c = aColor.abgr;
+                texCoord = aTexCoord.xy + aCorner*aTexCoord.zw;
+                gl_Position = matrix*vec4(aPosition.xy + aCorner*aPosition.zw, 0.0, 1.0);
+            }
+            )";
+        } else {
+            source.vertex = R"(
                                         uniform mat4 matrix;
                 varying vec4 c;
         varying vec2 texCoord;
@@ -81,38 +157,44 @@ struct MpvOsdRenderer::Data {
             texCoord = aTexCoord;
             gl_Position = matrix*aPosition;
         }
-        )");
-        shader->bindAttributeLocation("aTexCoord", AttrTexCoord);
-        shader->bindAttributeLocation("aPosition", AttrPosition);
-        shader->bindAttributeLocation("aColor", AttrColor);
-        shader->link();
+        )";
+        }
+        source.attributes.resize(isInstanced() ? 4 : 3);
+        source.attributes[AttrTexCoord] = "aTexCoord";
+        source.attributes[AttrPosition] = "aPosition";
+        source.attributes[AttrColor] = "aColor";
+        if (isInstanced())
+            source.attributes[AttrCorner] = "aCorner";
+        auto shader = new QOpenGLShaderProgram;
+        OpenGLShaderCache::link(shader, source);
         Q_ASSERT(shader->isLinked());
-
-        loc_atlas = shader->uniformLocation("atlas");
-        loc_matrix = shader->uniformLocation("matrix");
+        shaders.insert(format, shader);
         shader->bind();
-        shader->setUniformValue(loc_atlas, 0);
+        shader->setUniformValue(shader->uniformLocation("atlas"), 0);
         shader->release();
+        return shader;
     }
-    auto initializeAtlas(const sub_bitmaps *imgs) -> void
+    // returns true if parts are placed anew so that every part is dirty
+    auto initializeAtlas(const sub_bitmaps *imgs) -> bool
     {
         using tmp::aligned;
         static const int max = OGL::maximumTextureSize();
         if (parts.size() < imgs->num_parts)
             _Expand(parts, imgs->num_parts);
-        static constexpr int shifts[] = { 0, 0, 2, 2 };
         const int shift = shifts[imgs->format];
         QSize sheet{0, 0}; QPoint map{0, 0};
         int lineHeight = 0;
+        // placement depends only on sizes, so same sizes give same places
+        bool same = packed == imgs->num_parts;
 
         for (int i=0; i<imgs->num_parts; ++i) {
             auto &img = imgs->parts[i];
             auto &part = parts[i];
-            if (imgs->format == SUBBITMAP_LIBASS) {
-                const quint32 color = img.libass.color;
-                part.color = (color & 0xffffff00) | (0xff - (color & 0xff));
-            }
-            part.strideAsPixel = (img.stride >> shift);
+            const int strideAsPixel = (img.stride >> shift);
+            same &= part.strideAsPixel == strideAsPixel
+                    && part.size == QSize(img.w, img.h);
+            part.strideAsPixel = strideAsPixel;
+            part.size = {img.w, img.h};
             if (map.x() + part.strideAsPixel >= max) {
                 map.rx() = 0; map.ry() += lineHeight;
                 lineHeight = 0;
@@ -125,6 +207,7 @@ struct MpvOsdRenderer::Data {
             map.rx() += img.w;
         }
         sheet.rheight() = map.y() + lineHeight;
+        packed = imgs->num_parts;
 
         if (sheet.width() > atlasSize.width() || sheet.height() > atlasSize.height()) {
             if (sheet.width() > atlasSize.width())
@@ -132,7 +215,145 @@ struct MpvOsdRenderer::Data {
             if (sheet.height() > atlasSize.height())
                 atlasSize.rheight() = qMin(aligned<4>(sheet.height()*1.5), max);
             atlas.initialize(atlasSize, transfer);
+            return true;
         }
+        return !same;
+    }
+    // upload dirty parts only
+    auto upload(const sub_bitmaps *imgs, bool all) -> void
+    {
+        const int shift = shifts[imgs->format];
+        int bytes = 0;
+        for (int i = 0; i < imgs->num_parts; ++i) {
+            const auto &img = imgs->parts[i];
+            auto &part = parts[i];
+            const auto hash = hashBitmap(img, shift);
+            part.dirty = all || _Change(part.hash, hash);
+            part.hash = hash;
+            if (part.dirty)
+                bytes += img.stride * img.h;
+        }
+        if (!bytes)
+            return;
+        // staged uploads run as dma, first write everything into pbo
+        pbo.map(bytes);
+        for (int i = 0; i < imgs->num_parts; ++i) {
+            const auto &img = imgs->parts[i];
+            if (parts[i].dirty)
+                parts[i].data = pbo.write(img.bitmap, img.stride * img.h);
+        }
+        pbo.unmap();
+        for (int i = 0; i < imgs->num_parts; ++i) {
+            const auto &part = parts[i];
+            const auto &img = imgs->parts[i];
+            if (!part.dirty)
+                continue;
+            Q_ASSERT(part.map.x() + part.strideAsPixel <= atlas.width());
+            Q_ASSERT(part.map.y() + img.h <= atlas.height());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
+            atlas.upload(part.map.x(), part.map.y(), img.w, img.h, part.data);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        pbo.release();
+    }
+    // returns true if any part moved or changed its color
+    auto updateGeometry(const sub_bitmaps *imgs) -> bool
+    {
+        bool moved = false;
+        for (int i = 0; i < imgs->num_parts; ++i) {
+            const auto &img = imgs->parts[i];
+            auto &part = parts[i];
+            if (imgs->format == SUBBITMAP_LIBASS) {
+                const quint32 color = img.libass.color;
+                moved |= _Change(part.color, (color & 0xffffff00) | (0xff - (color & 0xff)));
+            }
+            moved |= _Change(part.pos, QRect(img.x, img.y, img.dw, img.dh));
+        }
+        return moved;
+    }
+    // refill staged geometry, which is copied into vbo for each draw
+    auto fill(const sub_bitmaps *imgs) -> void
+    {
+        const int num = imgs->num_parts;
+        const float aw = atlas.width(), ah = atlas.height();
+        if (isInstanced()) {
+            instances.resize(num);
+            for (int i = 0; i < num; ++i) {
+                const auto &part = parts[i];
+                const auto &img = imgs->parts[i];
+                auto &inst = instances[i];
+                inst.pos.set(img.x, img.y);
+                inst.size.set(img.dw, img.dh);
+                inst.texPos.set(part.map.x() / aw, part.map.y() / ah);
+                inst.texSize.set(img.w / aw, img.h / ah);
+                inst.color.set(part.color);
+            }
+        } else {
+            vertices.resize(num * 6);
+            auto vertex = vertices.data();
+            for (int i = 0; i < num; ++i) {
+                const auto &part = parts[i];
+                const auto &img = imgs->parts[i];
+                const QRectF pos(img.x, img.y, img.dw, img.dh);
+                const QRectF tex(part.map.x() / aw, part.map.y() / ah,
+                                 img.w / aw, img.h / ah);
+                vertex = OGL::CoordAttr::fillTriangles(vertex,
+                    &Vertex::position, pos.topLeft(), pos.bottomRight(),
+                    &Vertex::texCoord, tex.topLeft(), tex.bottomRight(),
+                    [&](Vertex *const it) { it->color.set(part.color); });
+            }
+        }
+    }
+    // bind geometry of drawn parts to attributes, returns vertex count per part
+    auto bindGeometry() -> int
+    {
+        const bool instanced = isInstanced();
+        if (instanced) {
+            quad.bind();
+            shader->setAttributeBuffer(AttrCorner, GL_FLOAT, 0, 2);
+            shader->enableAttributeArray(AttrCorner);
+            quad.release();
+        }
+        const int bytes = instanced ? drawn * sizeof(Instance)
+                                    : drawn * 6 * sizeof(Vertex);
+        const void *source = instanced ? static_cast<const void*>(instances.constData())
+                                       : static_cast<const void*>(vertices.constData());
+        // without buffer, client memory of staged copy is drawn directly
+        if (!vbo.map(bytes))
+            func->glBindBuffer(GL_ARRAY_BUFFER, 0);
+        auto base = static_cast<const char*>(vbo.write(source, bytes));
+        vbo.unmap();
+        if (instanced) {
+            shader->setAttributeArray(AttrPosition, GL_FLOAT,
+                base + offsetof(Instance, pos), 4, sizeof(Instance));
+            shader->setAttributeArray(AttrTexCoord, GL_FLOAT,
+                base + offsetof(Instance, texPos), 4, sizeof(Instance));
+            shader->setAttributeArray(AttrColor, GL_UNSIGNED_BYTE,
+                base + offsetof(Instance, color), 4, sizeof(Instance));
+        } else {
+            shader->setAttributeArray(AttrPosition, GL_FLOAT,
+                base + offsetof(Vertex, position), 2, sizeof(Vertex));
+            shader->setAttributeArray(AttrTexCoord, GL_FLOAT,
+                base + offsetof(Vertex, texCoord), 2, sizeof(Vertex));
+            shader->setAttributeArray(AttrColor, GL_UNSIGNED_BYTE,
+                base + offsetof(Vertex, color), 4, sizeof(Vertex));
+        }
+        shader->enableAttributeArray(AttrPosition);
+        shader->enableAttributeArray(AttrTexCoord);
+        shader->enableAttributeArray(AttrColor);
+        return instanced ? 6 : 6 * drawn;
+    }
+    auto releaseGeometry() -> void
+    {
+        shader->disableAttributeArray(AttrPosition);
+        shader->disableAttributeArray(AttrTexCoord);
+        shader->disableAttributeArray(AttrColor);
+        if (isInstanced())
+            shader->disableAttributeArray(AttrCorner);
+        // fence for the draw, so that ring never overwrites what gpu reads
+        vbo.release();
     }
 };
 
@@ -147,15 +368,42 @@ MpvOsdRenderer::~MpvOsdRenderer() {
 auto MpvOsdRenderer::initialize() -> void
 {
     d->atlas.create(OGL::Linear, OGL::ClampToEdge);
+    d->pbo.create();
     d->vbo.create();
-    d->vbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
     d->func = OGL::func();
+    d->vertexAttribDivisor = nullptr;
+    d->drawArraysInstanced = nullptr;
+    if (OGL::hasExtension(OGL::InstancedArrays)) {
+        auto ctx = QOpenGLContext::currentContext();
+#define RESOLVE(var, name) \
+    ((d->var = reinterpret_cast<decltype(d->var)>(ctx->getProcAddress(name))) \
+     || (d->var = reinterpret_cast<decltype(d->var)>(ctx->getProcAddress(name "ARB"))))
+        if (!RESOLVE(vertexAttribDivisor, "glVertexAttribDivisor")
+                || !RESOLVE(drawArraysInstanced, "glDrawArraysInstanced"))
+            d->drawArraysInstanced = nullptr;
+#undef RESOLVE
+    }
+    if (d->isInstanced()) {
+        d->quad.create();
+        d->quad.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        d->quad.bind();
+        d->quad.allocate(corners, sizeof(corners));
+        d->quad.release();
+    }
 }
 auto MpvOsdRenderer::finalize() -> void
 {
     d->atlas.destroy();
-    _Delete(d->shader);
+    d->pbo.destroy();
+    qDeleteAll(d->shaders);
+    d->shaders.clear();
+    d->shader = nullptr;
     d->vbo.destroy();
+    d->quad.destroy();
+    // gpu side is gone, so next draw should upload everything
+    d->atlasSize = {0, 0};
+    d->packed = d->drawn = 0;
+    d->last.id = -1;
 }
 
 auto MpvOsdRenderer::prepare(OpenGLFramebufferObject *fbo) -> void
@@ -164,17 +412,6 @@ auto MpvOsdRenderer::prepare(OpenGLFramebufferObject *fbo) -> void
     d->fbo = fbo;
 }
 
-SIA alignment(int stride) -> int
-{
-    if (!tmp::remainder<8>(stride))
-        return 8;
-    if (!tmp::remainder<4>(stride))
-        return 4;
-    if (!tmp::remainder<2>(stride))
-        return 2;
-    return 1;
-}
-
 auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
 {
     if (!d->fbo || !d->fbo->isValid())
@@ -187,43 +424,17 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
             && d->last.fbo == d->fbo && d->last.size == d->fbo->size())
         return;
 
-    d->vbo.bind();
-
     d->func->glActiveTexture(GL_TEXTURE0);
     OpenGLTextureBinder<OGL::Target2D> binder(&d->atlas);
 
     if (_Change(d->last.id, imgs->change_id)) {
         d->build(imgs->format);
-        d->initializeAtlas(imgs);
-        if (d->prevVboSize < static_cast<int>(num*6))
-            d->vbo.allocate((d->prevVboSize = num*6*1.2)*sizeof(Vertex));
-        auto vertex = static_cast<Vertex*>(d->vbo.map(QOpenGLBuffer::WriteOnly));
-        for (int i = 0; i < num; ++i) {
-            const auto &part = d->parts[i];
-            const auto &img = imgs->parts[i];
-            Q_ASSERT(part.map.x() + part.strideAsPixel <= d->atlas.width());
-            Q_ASSERT(part.map.y() + img.h <= d->atlas.height());
-
-            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
-
-            d->atlas.upload(part.map.x(), part.map.y(), img.w, img.h, img.bitmap);
-
-            QPointF tp = part.map; QSizeF ts(img.w, img.h);
-            tp.rx() /= d->atlas.width();
-            tp.ry() /= d->atlas.height();
-            ts.rwidth() /= d->atlas.width();
-            ts.rheight() /= d->atlas.height();
-            const QRectF pos(img.x, img.y, img.dw, img.dh), tex(tp, ts);
-            vertex = OGL::CoordAttr::fillTriangles(vertex,
-                &Vertex::position, pos.topLeft(), pos.bottomRight(),
-                &Vertex::texCoord, tex.topLeft(), tex.bottomRight(),
-                [&](Vertex *const it) { it->color.set(part.color); });
-
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-        }
-        d->vbo.unmap();
+        const bool repacked = d->initializeAtlas(imgs);
+        d->upload(imgs, repacked);
+        // staged geometry is kept unless something has moved
+        const bool moved = d->updateGeometry(imgs);
+        if (_Change(d->drawn, num) || moved || repacked)
+            d->fill(imgs);
     }
 
     d->vMatrix.setToIdentity();
@@ -237,22 +448,22 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
     glClear(GL_COLOR_BUFFER_BIT);
 
     d->shader->bind();
-    SET_ATTR_COORD(d->shader, AttrPosition, Vertex, position);
-    SET_ATTR_COORD(d->shader, AttrTexCoord, Vertex, texCoord);
-    SET_ATTR_COLOR(d->shader, AttrColor, Vertex, color);
-    d->shader->enableAttributeArray(AttrPosition);
-    d->shader->enableAttributeArray(AttrTexCoord);
-    d->shader->enableAttributeArray(AttrColor);
+    const int vertices = d->bindGeometry();
     d->shader->setUniformValue(d->loc_matrix, d->vMatrix);
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    glDrawArrays(GL_TRIANGLES, 0, 6*num);
+    if (d->isInstanced()) {
+        // divisors are context state, so reset them for other renderers
+        for (auto attr : {AttrPosition, AttrTexCoord, AttrColor})
+            d->vertexAttribDivisor(attr, 1);
+        d->drawArraysInstanced(GL_TRIANGLES, 0, vertices, d->drawn);
+        for (auto attr : {AttrPosition, AttrTexCoord, AttrColor})
+            d->vertexAttribDivisor(attr, 0);
+    } else
+        glDrawArrays(GL_TRIANGLES, 0, vertices);
     glDisable(GL_BLEND);
-    d->shader->disableAttributeArray(AttrPosition);
-    d->shader->disableAttributeArray(AttrTexCoord);
-    d->shader->disableAttributeArray(AttrColor);
+    d->releaseGeometry();
     d->shader->release();
-    d->vbo.release();
     d->fbo->release();
 }
 
@@ -0,0 +1,175 @@
+#include "playbackstats.hpp"
+#include <QElapsedTimer>
+
+// values kept in ring and counted in fixed bins, oldest one leaves its bin
+struct RollingHistogram {
+    RollingHistogram(double low, double width, int bins)
+        : m_low(low), m_width(width), m_bins(bins, 0) { }
+    auto push(double v) -> void
+    {
+        if (m_size == PlaybackStats::History) {
+            const double old = m_values[m_pos];
+            --m_bins[bin(old)];
+            m_sum -= old;
+        } else
+            ++m_size;
+        m_values[m_pos] = v;
+        m_pos = (m_pos + 1) % PlaybackStats::History;
+        ++m_bins[bin(v)];
+        m_sum += v;
+    }
+    auto clear() -> void
+    {
+        m_size = m_pos = 0;
+        m_sum = 0;
+        m_bins.fill(0);
+    }
+    auto distribution() const -> PlaybackStats::Distribution
+    {
+        PlaybackStats::Distribution dist;
+        dist.low = m_low;
+        dist.width = m_width;
+        dist.bins = m_bins;
+        dist.samples = m_size;
+        if (m_size <= 0)
+            return dist;
+        dist.min = dist.max = m_values[0];
+        for (int i = 1; i < m_size; ++i) {
+            dist.min = qMin(dist.min, m_values[i]);
+            dist.max = qMax(dist.max, m_values[i]);
+        }
+        dist.mean = m_sum / m_size;
+        // percentiles at center of bins, clamped to seen range
+        auto percentile = [&] (double p) {
+            const int rank = qCeil(m_size * p);
+            int count = 0;
+            for (int i = 0; i < m_bins.size(); ++i) {
+                count += m_bins[i];
+                if (count >= rank)
+                    return qBound(dist.min, m_low + (i + 0.5) * m_width, dist.max);
+            }
+            return dist.max;
+        };
+        dist.p50 = percentile(0.5);
+        dist.p95 = percentile(0.95);
+        dist.p99 = percentile(0.99);
+        return dist;
+    }
+private:
+    auto bin(double v) const -> int
+        { return qBound(0, qFloor((v - m_low) / m_width), m_bins.size() - 1); }
+    double m_low, m_width, m_sum = 0;
+    QVector<int> m_bins;
+    std::array<double, PlaybackStats::History> m_values;
+    int m_size = 0, m_pos = 0;
+};
+
+struct PlaybackStats::Data {
+    mutable QMutex mutex;
+    // 5ms bins within +-200ms, 1ms bins up to 100ms
+    std::array<RollingHistogram, KindCount> histograms = {{
+        { -200.0, 5.0, 80 }, { 0.0, 1.0, 100 }
+    }};
+    QElapsedTimer frame;
+    qint64 frames = 0, late = 0;
+    qint64 decoder = 0, output = 0, decoderBase = -1, outputBase = -1;
+};
+
+PlaybackStats::PlaybackStats()
+    : d(new Data)
+{
+}
+
+PlaybackStats::~PlaybackStats()
+{
+    delete d;
+}
+
+auto PlaybackStats::pushAvSync(double ms) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    d->histograms[AvSync].push(ms);
+}
+
+auto PlaybackStats::pushFrame(bool late) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    ++d->frames;
+    if (late)
+        ++d->late;
+    if (d->frame.isValid())
+        d->histograms[FrameInterval].push(d->frame.nsecsElapsed() * 1e-6);
+    d->frame.start();
+}
+
+auto PlaybackStats::setDrops(qint64 decoder, qint64 output) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    // counters of mpv restart for each file
+    if (d->decoderBase < 0 || decoder < d->decoderBase)
+        d->decoderBase = decoder;
+    if (d->outputBase < 0 || output < d->outputBase)
+        d->outputBase = output;
+    d->decoder = decoder - d->decoderBase;
+    d->output = output - d->outputBase;
+}
+
+auto PlaybackStats::summary() const -> Summary
+{
+    QMutexLocker locker(&d->mutex);
+    Summary s;
+    for (int i = 0; i < KindCount; ++i)
+        s.distributions[i] = d->histograms[i].distribution();
+    s.frames = d->frames;
+    s.lateFrames = d->late;
+    s.decoderDrops = d->decoder;
+    s.outputDrops = d->output;
+    return s;
+}
+
+auto PlaybackStats::reset() -> void
+{
+    QMutexLocker locker(&d->mutex);
+    for (auto &h : d->histograms)
+        h.clear();
+    d->frame.invalidate();
+    d->frames = d->late = 0;
+    d->decoder = d->output = 0;
+    d->decoderBase = d->outputBase = -1;
+}
+
+auto PlaybackStats::Summary::toMap() const -> QVariantMap
+{
+    auto map = [] (const Distribution &dist) {
+        QVariantList bins;
+        bins.reserve(dist.bins.size());
+        for (int count : dist.bins)
+            bins.push_back(count);
+        return QVariantMap{
+            { u"min"_q, dist.min }, { u"max"_q, dist.max }, { u"mean"_q, dist.mean },
+            { u"p50"_q, dist.p50 }, { u"p95"_q, dist.p95 }, { u"p99"_q, dist.p99 },
+            { u"low"_q, dist.low }, { u"width"_q, dist.width },
+            { u"samples"_q, dist.samples }, { u"bins"_q, bins }
+        };
+    };
+    return QVariantMap{
+        { u"avSync"_q, map(distributions[AvSync]) },
+        { u"frameInterval"_q, map(distributions[FrameInterval]) },
+        { u"frames"_q, frames }, { u"lateFrames"_q, lateFrames },
+        { u"decoderDrops"_q, decoderDrops }, { u"outputDrops"_q, outputDrops }
+    };
+}
+
+auto PlaybackStats::Summary::toString() const -> QString
+{
+    auto text = [] (const Distribution &dist) {
+        return u"mean %1, p50 %2, p95 %3, p99 %4, min %5, max %6 ms (%7 samples)"_q
+                .arg(dist.mean, 0, 'f', 2).arg(dist.p50, 0, 'f', 1)
+                .arg(dist.p95, 0, 'f', 1).arg(dist.p99, 0, 'f', 1)
+                .arg(dist.min, 0, 'f', 1).arg(dist.max, 0, 'f', 1).arg(dist.samples);
+    };
+    return "A/V sync: "_a % text(distributions[AvSync])
+            % "; frame interval: "_a % text(distributions[FrameInterval])
+            % u"; %1 frames, %2 late, %3 dropped by decoder, %4 dropped by output"_q
+              .arg(frames).arg(lateFrames).arg(decoderDrops).arg(outputDrops);
+}
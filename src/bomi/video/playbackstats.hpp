@@ -0,0 +1,43 @@
+#ifndef PLAYBACKSTATS_HPP
+#define PLAYBACKSTATS_HPP
+
+#include <array>
+
+// rolling histograms of playback quality for one file
+// fed by mpv, render and gui thread and read by any thread through summary()
+class PlaybackStats {
+public:
+    static constexpr int History = 3000;
+    enum Kind { AvSync, FrameInterval, KindCount };
+    // all in ms over last History samples
+    struct Distribution {
+        double min = 0, max = 0, mean = 0, p50 = 0, p95 = 0, p99 = 0;
+        // first bin starts at low, values out of range go to edge bins
+        double low = 0, width = 0;
+        QVector<int> bins;
+        int samples = 0;
+    };
+    struct Summary {
+        std::array<Distribution, KindCount> distributions;
+        // counts since reset()
+        qint64 frames = 0, lateFrames = 0, decoderDrops = 0, outputDrops = 0;
+        auto toMap() const -> QVariantMap;
+        auto toString() const -> QString;
+    };
+    PlaybackStats();
+    PlaybackStats(const PlaybackStats &) = delete;
+    PlaybackStats &operator = (const PlaybackStats &) = delete;
+    ~PlaybackStats();
+    auto pushAvSync(double ms) -> void;
+    // call for every rendered frame, late if mpv reported it delayed
+    auto pushFrame(bool late) -> void;
+    // cumulative counters of mpv
+    auto setDrops(qint64 decoder, qint64 output) -> void;
+    auto summary() const -> Summary;
+    auto reset() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // PLAYBACKSTATS_HPP
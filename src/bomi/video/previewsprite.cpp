@@ -0,0 +1,88 @@
+#include "previewsprite.hpp"
+#include "keyframedecoder.hpp"
+#include "player/mpv_property.hpp"
+#include "misc/log.hpp"
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+DECLARE_LOG_CONTEXT(Video)
+
+static constexpr int Rows = (PreviewSprite::Count + PreviewSprite::Columns - 1)
+                            / PreviewSprite::Columns;
+
+auto PreviewSprite::index(double rate) const -> int
+{
+    return qBound(0, (int)(rate * Count), Count - 1);
+}
+
+auto PreviewSprite::tile(int index) const -> QImage
+{
+    const QPoint pos(index % Columns * m_tile.width(), index / Columns * m_tile.height());
+    return m_image.copy({pos, m_tile});
+}
+
+auto PreviewSprite::localFile(const QByteArray &path) -> QString
+{
+    auto file = MpvFile::fromMpv(path).data;
+    if (file.startsWith("file://"_a))
+        file = QUrl(file).toLocalFile();
+    const QFileInfo info(file);
+    return info.isFile() ? info.absoluteFilePath() : QString();
+}
+
+auto PreviewSprite::cachePath(const QString &file) -> QString
+{
+    const QFileInfo info(file);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(file.toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(Count) + 'x' + QByteArray::number(TileWidth));
+    return _WritablePath(Location::Cache) % "/preview/"_a
+            % _L(hash.result().toHex()) % ".jpg"_a;
+}
+
+auto PreviewSprite::cached(const QString &file) -> PreviewSprite
+{
+    PreviewSprite sprite;
+    if (file.isEmpty() || !sprite.m_image.load(cachePath(file), "JPG"))
+        return sprite;
+    const auto size = sprite.m_image.size();
+    if (size.width() != Columns * TileWidth || size.height() % Rows) {
+        sprite.m_image = QImage();
+        return sprite;
+    }
+    sprite.m_tile = {TileWidth, size.height() / Rows};
+    return sprite;
+}
+
+auto PreviewSprite::generate(const QString &file,
+                             const std::atomic<bool> &cancel) -> PreviewSprite
+{
+    PreviewSprite sprite;
+    KeyframeDecoder decoder;
+    if (file.isEmpty() || !decoder.open(MpvFile(file).toMpv()))
+        return sprite;
+    const int height = qBound(16, qRound(TileWidth / decoder.aspect()) & ~1, TileWidth * 2);
+    QImage image(Columns * TileWidth, Rows * height, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    int drawn = 0;
+    for (int i = 0; i < Count; ++i) {
+        if (cancel)
+            return sprite;
+        const qint64 us = decoder.duration() * (i + 0.5) / Count;
+        const QRect rect(i % Columns * TileWidth, i / Columns * height, TileWidth, height);
+        if (decoder.decode(us) && decoder.draw(image, rect))
+            ++drawn;
+    }
+    if (!drawn)
+        return sprite;
+    const auto path = cachePath(file);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    if (!out.open(QFile::WriteOnly) || !image.save(&out, "JPG", 85) || !out.commit())
+        _Warn("Cannot write preview cache '%%'.", path);
+    sprite.m_image = std::move(image);
+    sprite.m_tile = {TileWidth, height};
+    return sprite;
+}
@@ -0,0 +1,24 @@
+#ifndef PREVIEWSPRITE_HPP
+#define PREVIEWSPRITE_HPP
+
+// keyframe thumbnails of a file in one sheet, evenly spaced in time
+// sheets are cached on disk by file identity and reused across sessions
+class PreviewSprite {
+public:
+    static constexpr int Columns = 10, Count = 100, TileWidth = 160;
+    auto isNull() const -> bool { return m_image.isNull(); }
+    auto index(double rate) const -> int;
+    auto tile(int index) const -> QImage;
+    // local file for mpv path, empty if it cannot be cached
+    static auto localFile(const QByteArray &path) -> QString;
+    static auto cached(const QString &file) -> PreviewSprite;
+    // decode and store new sheet, which can take long
+    static auto generate(const QString &file,
+                         const std::atomic<bool> &cancel) -> PreviewSprite;
+private:
+    static auto cachePath(const QString &file) -> QString;
+    QImage m_image;
+    QSize m_tile = {0, 0};
+};
+
+#endif // PREVIEWSPRITE_HPP
@@ -0,0 +1,254 @@
+#include "renderbenchmark.hpp"
+#include "rendertiming.hpp"
+#include "interpolatorparams.hpp"
+#include "enum/interpolator.hpp"
+#include "enum/dithering.hpp"
+#include "player/mpv.hpp"
+#include "opengl/opengloffscreencontext.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglreadback.hpp"
+#include "misc/log.hpp"
+#include "misc/benchmarktable.hpp"
+#include <QCryptographicHash>
+#include <QOpenGLFunctions>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QSemaphore>
+
+DECLARE_LOG_CONTEXT(Video)
+
+// fixed pattern with frame counter, so every frame differs from others
+static const auto Source = "av://lavfi:testsrc=size=480x270:rate=30"_b;
+// ms to wait for a frame to be uploaded
+static constexpr int FrameTimeout = 5000;
+
+struct RenderBenchmark::Data {
+    OpenGLOffscreenContext gl;
+    QString golden, folder;
+    int frames = 3, repeats = 20;
+    QSize size = {1280, 720};
+
+    auto vo(const Case &c) const -> QByteArray
+    {
+        auto fbo = [] (OGL::TextureFormat format) -> QByteArray {
+            switch (format) {
+            case OGL::RGBA16_UNorm:  return "rgba16"_b;
+            case OGL::RGB10A2_UNorm: return "rgb10_a2"_b;
+            default:                 return "rgba"_b;
+            }
+        };
+        // cscale and pbo are fixed to keep output of scale alone
+        return "opengl-cb:scale="_b % IntrplParamSet(c.scale).toMpvOption("scale")
+               % ":cscale=bilinear:pbo=no:dither-depth=8:dither="_b
+               % _EnumData(c.dithering) % ":fbo-format="_b % fbo(c.fbo);
+    }
+    // waits until given frame is shown in paused state
+    auto wait(const Mpv &mpv, QSemaphore &updated, int frame) const -> bool
+    {
+        QElapsedTimer timer;
+        timer.start();
+        for (;;) {
+            const int left = FrameTimeout - timer.elapsed();
+            if (left <= 0 || !updated.tryAcquire(1, left))
+                return false;
+            int current = -1;
+            if (mpv.get("estimated-frame-number", current) && current >= frame) {
+                updated.tryAcquire(updated.available());
+                return true;
+            }
+        }
+    }
+    // max difference of channels, or -1 for different size
+    static auto compare(const QImage &a, const QImage &b) -> int
+    {
+        if (a.size() != b.size())
+            return -1;
+        int error = 0;
+        for (int y = 0; y < a.height(); ++y) {
+            auto p = a.constScanLine(y), q = b.constScanLine(y);
+            for (int x = 0; x < a.width() * 4; ++x)
+                error = std::max(error, std::abs(p[x] - q[x]));
+        }
+        return error;
+    }
+};
+
+RenderBenchmark::RenderBenchmark()
+    : d(new Data)
+{
+    d->gl.setContextName(u"RenderBenchmark"_q);
+    d->gl.createSurface();
+    if (!d->gl.createContext() || !d->gl.makeCurrent()) {
+        _Error("Cannot create OpenGL context for benchmark.");
+        return;
+    }
+    // golden images are valid only for same driver
+    auto f = d->gl.context()->functions();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        if (auto str = f->glGetString(name))
+            hash.addData(reinterpret_cast<const char*>(str));
+    }
+    d->folder = _L(hash.result().toHex().left(16));
+    d->gl.doneCurrent();
+}
+
+RenderBenchmark::~RenderBenchmark()
+{
+    delete d;
+}
+
+auto RenderBenchmark::setGoldenPath(const QString &path) -> void
+{
+    d->golden = path;
+}
+
+auto RenderBenchmark::setFrames(int frames) -> void
+{
+    d->frames = frames;
+}
+
+auto RenderBenchmark::setRepeats(int repeats) -> void
+{
+    d->repeats = repeats;
+}
+
+auto RenderBenchmark::setTargetSize(const QSize &size) -> void
+{
+    d->size = size;
+}
+
+auto RenderBenchmark::run(const Case &c) -> Result
+{
+    Result result;
+    if (d->folder.isEmpty() || !OGL::isSupportedFrambufferFormat(c.fbo)
+            || !d->gl.makeCurrent())
+        return result;
+    QString folder;
+    if (!d->golden.isEmpty()) {
+        folder = d->golden % '/'_q % d->folder;
+        if (!QDir().mkpath(folder))
+            folder.clear();
+    }
+
+    auto f = d->gl.context()->functions();
+    OpenGLFramebufferObject target(d->size);
+    OpenGLReadback readback(1);
+    readback.create();
+    RenderTiming timing;
+    QSemaphore updated;
+
+    Mpv mpv;
+    mpv.setLogContext("mpv/benchmark"_b);
+    mpv.create();
+    mpv.setOption("vo", d->vo(c).constData());
+    mpv.setOption("hwdec", "no");
+    mpv.setOption("aid", "no");
+    mpv.setOption("sid", "no");
+    mpv.setOption("pause", "yes");
+    mpv.setOption("keep-open", "always");
+    mpv.setOption("osd-level", "0");
+    mpv.initialize(Log::Error);
+    mpv.setUpdateCallback([&] () { updated.release(); });
+    mpv.setRenderTiming(&timing);
+    mpv.start();
+    mpv.initializeGL(d->gl.context());
+    mpv.tell("loadfile", Source);
+
+    result.status = Passed;
+    for (int i = 0; i < d->frames; ++i) {
+        if (i > 0)
+            mpv.tell("frame_step");
+        if (!d->wait(mpv, updated, i))
+            break;
+        for (int r = 0; r < d->repeats; ++r) {
+            mpv.render(&target, nullptr, QMargins());
+            f->glFinish();
+            ++result.draws;
+        }
+        QImage image;
+        if (!readback.read(&target, QImage::Format_ARGB32)
+                || !readback.take(image, true))
+            break;
+        image = image.mirrored();
+        ++result.frames;
+        if (folder.isEmpty())
+            continue;
+        QString name = c.name % '-'_q % _N(i) % ".png"_a;
+        name.replace(' '_q, '_'_q);
+        const auto path = folder % '/'_q % name;
+        QImage golden;
+        if (!golden.load(path)) {
+            image.save(path);
+            if (result.status == Passed)
+                result.status = Created;
+            continue;
+        }
+        const int error = Data::compare(image, golden.convertToFormat(image.format()));
+        result.error = error < 0 ? 255 : std::max(result.error, error);
+        if (result.error > Tolerance)
+            result.status = Failed;
+    }
+    if (result.frames < d->frames)
+        result.status = Failed;
+
+    const auto stats = timing.stats().passes[RenderTiming::Video];
+    result.gpu = stats.gpu;
+    result.gpuMax = stats.gpuMax;
+    result.cpu = stats.cpu;
+    mpv.finalizeGL();
+    mpv.tell("quit");
+    mpv.wait();
+    mpv.destroy();
+    readback.destroy();
+    d->gl.doneCurrent();
+    return result;
+}
+
+auto RenderBenchmark::cases() -> QList<Case>
+{
+    static const std::pair<OGL::TextureFormat, const char*> fbos[] = {
+        { OGL::RGBA8_UNorm, "rgba8" }, { OGL::RGB10A2_UNorm, "rgb10a2" },
+        { OGL::RGBA16_UNorm, "rgba16" }
+    };
+    QList<Case> cases;
+    for (auto &scale : InterpolatorInfo::items()) {
+        for (auto &dithering : DitheringInfo::items()) {
+            for (auto &fbo : fbos) {
+                Case c;
+                c.name = scale.key % ' '_q % dithering.key % ' '_q % _L(fbo.second);
+                c.scale = scale.value;
+                c.dithering = dithering.value;
+                c.fbo = fbo.first;
+                cases.push_back(c);
+            }
+        }
+    }
+    return cases;
+}
+
+auto RenderBenchmark::dumpInfo(const QString &golden) -> void
+{
+    const auto error = OGL::check();
+    if (!error.isEmpty()) {
+        qDebug().noquote() << error;
+        return;
+    }
+    RenderBenchmark bench;
+    bench.setGoldenPath(golden);
+    const auto cases = RenderBenchmark::cases();
+    BenchmarkTable table;
+    table.fit(cases);
+    table.header(u"case"_q, "    gpu ms   gpu max    cpu ms  error  status");
+    static const char *names[] = { "failed", "passed", "created", "skipped" };
+    std::array<int, 4> counts = {{0, 0, 0, 0}};
+    for (auto &c : cases) {
+        const auto r = bench.run(c);
+        ++counts[r.status];
+        auto ms = [] (double v) { return v < 0 ? u"-"_q.rightJustified(10) : _N(v, 3, 10); };
+        table.row(c.name, ms(r.gpu) % ms(r.gpuMax) % ms(r.cpu)
+                  % _N(r.error).rightJustified(7) % "  "_a % _L(names[r.status]));
+    }
+    qDebug().nospace() << counts[Passed] << " passed, " << counts[Failed] << " failed, "
+                       << counts[Created] << " created, " << counts[Skipped] << " skipped";
+}
@@ -0,0 +1,49 @@
+#ifndef RENDERBENCHMARK_HPP
+#define RENDERBENCHMARK_HPP
+
+#include "opengl/openglmisc.hpp"
+
+enum class Interpolator;                enum class Dithering;
+
+// renders fixed frames of a generated source through gl_video offscreen
+// for each setup of scaler, dithering and intermediate fbo format
+// to catch regressions of cost and output in the render path
+// golden images are kept per gpu since drivers differ in rounding
+
+class RenderBenchmark {
+public:
+    struct Case {
+        QString name;
+        Interpolator scale; Dithering dithering;
+        OGL::TextureFormat fbo;
+    };
+    enum Status { Failed, Passed, Created, Skipped };
+    struct Result {
+        Status status = Skipped;
+        int frames = 0, draws = 0;
+        // ms per draw, negative gpu time if timer queries are unavailable
+        double gpu = -1, gpuMax = -1, cpu = 0;
+        // largest difference of 8-bit channels against golden images
+        int error = 0;
+    };
+    // channel difference which is still regarded as identical
+    static constexpr int Tolerance = 3;
+    RenderBenchmark();
+    ~RenderBenchmark();
+    // directory of golden images, missing ones are created
+    auto setGoldenPath(const QString &path) -> void;
+    auto setFrames(int frames) -> void;
+    // draws of each frame to measure
+    auto setRepeats(int repeats) -> void;
+    auto setTargetSize(const QSize &size) -> void;
+    // context must have been created, which is made current in run()
+    auto run(const Case &c) -> Result;
+    static auto cases() -> QList<Case>;
+    // timings of every case and its comparison against golden images
+    static auto dumpInfo(const QString &golden) -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // RENDERBENCHMARK_HPP
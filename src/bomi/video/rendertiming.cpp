@@ -0,0 +1,188 @@
+#include "rendertiming.hpp"
+#include "opengl/openglbenchmarker.hpp"
+#include <QElapsedTimer>
+
+struct TimingRing {
+    auto push(double v) -> void
+    {
+        m_values[m_pos] = v;
+        m_pos = (m_pos + 1) % RenderTiming::History;
+        m_size = qMin(m_size + 1, RenderTiming::History);
+    }
+    auto clear() -> void { m_size = m_pos = 0; }
+    auto size() const -> int { return m_size; }
+    auto average(int window) const -> double
+    {
+        const int n = qMin(window, m_size);
+        if (n <= 0)
+            return 0.0;
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i)
+            sum += at(i);
+        return sum / n;
+    }
+    auto max(int window) const -> double
+    {
+        const int n = qMin(window, m_size);
+        double max = 0.0;
+        for (int i = 0; i < n; ++i)
+            max = qMax(max, at(i));
+        return max;
+    }
+    // mean period of intervals which lie near multiples of nominal one
+    auto vsync(double nominal, int window) const -> double
+    {
+        const int n = qMin(window, m_size);
+        double sum = 0.0;
+        int count = 0;
+        for (int i = 0; i < n; ++i) {
+            const double v = at(i);
+            const int k = qRound(v / nominal);
+            if (k < 1 || k > 4 || qAbs(v - k * nominal) > nominal * 0.15)
+                continue;
+            sum += v;
+            count += k;
+        }
+        return count > 0 ? sum / count : nominal;
+    }
+private:
+    // i-th latest value
+    auto at(int i) const -> double
+    {
+        constexpr int size = RenderTiming::History;
+        return m_values[(m_pos - 1 - i + size) % size];
+    }
+    std::array<double, RenderTiming::History> m_values;
+    int m_size = 0, m_pos = 0;
+};
+
+struct PassTiming {
+    OpenGLBenchmarker gpu;
+    QElapsedTimer cpu;
+    TimingRing gpuTimes, cpuTimes;
+};
+
+struct RenderTiming::Data {
+    mutable QMutex mutex;
+    std::array<PassTiming, PassCount> passes;
+    TimingRing intervals;
+    QElapsedTimer swap;
+    double period = 0.0;
+    int misses = 0;
+    // GL_TIME_ELAPSED queries cannot be nested
+    int gpuPass = -1;
+    bool rendered = false;
+    auto collect(PassTiming &pass) -> void
+    {
+        qint64 ns = -1;
+        while ((ns = pass.gpu.take()) >= 0) {
+            QMutexLocker locker(&mutex);
+            pass.gpuTimes.push(ns * 1e-6);
+        }
+    }
+};
+
+RenderTiming::RenderTiming()
+    : d(new Data)
+{
+}
+
+RenderTiming::~RenderTiming()
+{
+    delete d;
+}
+
+auto RenderTiming::initializeGL() -> void
+{
+    for (auto &pass : d->passes)
+        pass.gpu.create();
+    d->gpuPass = -1;
+}
+
+auto RenderTiming::finalizeGL() -> void
+{
+    for (auto &pass : d->passes)
+        pass.gpu.destroy();
+    d->gpuPass = -1;
+}
+
+auto RenderTiming::begin(Pass pass) -> void
+{
+    auto &p = d->passes[pass];
+    d->collect(p);
+    if (d->gpuPass < 0) {
+        p.gpu.begin();
+        d->gpuPass = pass;
+    }
+    p.cpu.start();
+}
+
+auto RenderTiming::end(Pass pass) -> void
+{
+    auto &p = d->passes[pass];
+    const double cpu = p.cpu.nsecsElapsed() * 1e-6;
+    if (d->gpuPass == pass) {
+        p.gpu.end();
+        d->gpuPass = -1;
+    }
+    if (pass == Video)
+        d->rendered = true;
+    QMutexLocker locker(&d->mutex);
+    p.cpuTimes.push(cpu);
+}
+
+auto RenderTiming::swapped() -> void
+{
+    if (!d->swap.isValid()) {
+        d->swap.start();
+        return;
+    }
+    const double interval = d->swap.nsecsElapsed() * 1e-6;
+    d->swap.start();
+    QMutexLocker locker(&d->mutex);
+    d->intervals.push(interval);
+    // idle swaps without new frame are not misses
+    if (d->rendered && d->period > 0 && interval > d->period * 1.5)
+        ++d->misses;
+    d->rendered = false;
+}
+
+auto RenderTiming::setRefreshRate(double hz) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    d->period = hz > 0 ? 1000.0 / hz : 0.0;
+}
+
+auto RenderTiming::stats(int window) const -> Stats
+{
+    QMutexLocker locker(&d->mutex);
+    Stats stats;
+    for (int i = 0; i < PassCount; ++i) {
+        auto &pass = d->passes[i];
+        auto &s = stats.passes[i];
+        if (pass.gpuTimes.size()) {
+            s.gpu = pass.gpuTimes.average(window);
+            s.gpuMax = pass.gpuTimes.max(window);
+        }
+        s.cpu = pass.cpuTimes.average(window);
+        s.cpuMax = pass.cpuTimes.max(window);
+    }
+    stats.interval = d->intervals.average(window);
+    stats.intervalMax = d->intervals.max(window);
+    stats.period = d->period;
+    stats.vsync = d->intervals.vsync(d->period > 0 ? d->period : 1000.0 / 60.0, window);
+    stats.samples = qMin(window, d->intervals.size());
+    stats.vsyncMisses = d->misses;
+    return stats;
+}
+
+auto RenderTiming::reset() -> void
+{
+    QMutexLocker locker(&d->mutex);
+    for (auto &pass : d->passes) {
+        pass.gpuTimes.clear();
+        pass.cpuTimes.clear();
+    }
+    d->intervals.clear();
+    d->misses = 0;
+}
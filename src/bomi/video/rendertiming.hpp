@@ -0,0 +1,54 @@
+#ifndef RENDERTIMING_HPP
+#define RENDERTIMING_HPP
+
+#include <array>
+
+// timings of render passes in render thread
+// recorded by render thread and read by any thread through stats()
+class RenderTiming {
+public:
+    static constexpr int History = 120;
+    enum Pass { Video, Osd, Subtitle, PassCount };
+    // all in ms over last samples, negative gpu time if unavailable
+    struct PassStats {
+        double gpu = -1, gpuMax = -1, cpu = 0, cpuMax = 0;
+    };
+    struct Stats {
+        std::array<PassStats, PassCount> passes;
+        double interval = 0, intervalMax = 0, period = 0;
+        // measured refresh period, nominal one until enough swaps are seen
+        double vsync = 0;
+        int vsyncMisses = 0, samples = 0;
+    };
+    RenderTiming();
+    RenderTiming(const RenderTiming &) = delete;
+    RenderTiming &operator = (const RenderTiming &) = delete;
+    ~RenderTiming();
+    // current context is required for initializeGL(), finalizeGL(), begin(), end()
+    auto initializeGL() -> void;
+    auto finalizeGL() -> void;
+    auto begin(Pass pass) -> void;
+    auto end(Pass pass) -> void;
+    // call right after buffer swap
+    auto swapped() -> void;
+    auto setRefreshRate(double hz) -> void;
+    // average and max of last window samples
+    auto stats(int window = History) const -> Stats;
+    auto reset() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+// scoped begin()/end() which allows null timing
+class RenderTimingScope {
+public:
+    RenderTimingScope(RenderTiming *timing, RenderTiming::Pass pass)
+        : m_timing(timing), m_pass(pass) { if (m_timing) m_timing->begin(m_pass); }
+    ~RenderTimingScope() { if (m_timing) m_timing->end(m_pass); }
+private:
+    RenderTiming *m_timing;
+    RenderTiming::Pass m_pass;
+};
+
+#endif // RENDERTIMING_HPP
@@ -0,0 +1,201 @@
+#include "slidedecoder.hpp"
+#include "player/mpv_property.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+#include "os/os.hpp"
+#include <QImageReader>
+#include <QThreadPool>
+#include <QBuffer>
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+DECLARE_LOG_CONTEXT(Video)
+
+enum EventType { Decoded = QEvent::User + 1 };
+
+class SlideDecodeJob : public QRunnable {
+public:
+    SlideDecodeJob(QObject *decoder, int serial, const QString &file, const QSize &target)
+        : m_decoder(decoder), m_serial(serial), m_file(file), m_target(target) { }
+    auto run() -> void final
+    {
+        OS::setThreadClass(OS::ThreadClass::Background);
+        auto image = SlideDecoder::decode(m_file, m_target);
+        _PostEvent(m_decoder, Decoded, m_serial, m_file, image);
+    }
+private:
+    QObject *m_decoder = nullptr;
+    int m_serial = 0;
+    QString m_file;
+    QSize m_target;
+};
+
+struct SlideDecoder::Data {
+    SlideDecoder *p = nullptr;
+    QSize target;
+    int serial = 0;
+    QThreadPool pool;
+    QSet<QString> pending;
+    // most recently used at back
+    QList<QPair<QString, QImage>> images;
+    auto find(const QString &file) -> int
+    {
+        for (int i = 0; i < images.size(); ++i) {
+            if (images[i].first == file)
+                return i;
+        }
+        return -1;
+    }
+    auto store(const QString &file, const QImage &image) -> void
+    {
+        const int idx = find(file);
+        if (idx >= 0)
+            images.removeAt(idx);
+        images.push_back(qMakePair(file, image));
+        while (images.size() > Capacity)
+            images.pop_front();
+    }
+};
+
+SlideDecoder::SlideDecoder(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    d->p = this;
+    d->pool.setMaxThreadCount(2);
+}
+
+SlideDecoder::~SlideDecoder()
+{
+    clear();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto SlideDecoder::setTargetSize(const QSize &size) -> void
+{
+    const bool larger = size.width() > d->target.width()
+            || size.height() > d->target.height();
+    d->target = size;
+    if (larger)
+        clear();
+}
+
+auto SlideDecoder::targetSize() const -> QSize
+{
+    return d->target;
+}
+
+auto SlideDecoder::clear() -> void
+{
+    ++d->serial;
+    d->pool.clear();
+    d->pending.clear();
+    d->images.clear();
+}
+
+auto SlideDecoder::prefetch(const QString &file) -> void
+{
+    if (file.isEmpty() || d->pending.contains(file) || d->find(file) >= 0)
+        return;
+    d->pending.insert(file);
+    d->pool.start(new SlideDecodeJob(this, d->serial, file, d->target));
+}
+
+auto SlideDecoder::get(const QString &file) -> QImage
+{
+    const int idx = d->find(file);
+    if (idx >= 0) {
+        auto image = d->images[idx].second;
+        d->store(file, image);
+        return image;
+    }
+    // pending one would be too late, its result is stored anyway
+    auto image = decode(file, d->target);
+    if (!image.isNull())
+        d->store(file, image);
+    return image;
+}
+
+auto SlideDecoder::cached(const QString &file) const -> QImage
+{
+    const int idx = d->find(file);
+    return idx < 0 ? QImage() : d->images[idx].second;
+}
+
+// cover embedded in audio file, read from header without probing streams
+static auto attachedPicture(const QString &file) -> QByteArray
+{
+    AVFormatContext *format = nullptr;
+    if (avformat_open_input(&format, MpvFile(file).toMpv().constData(), nullptr, nullptr) < 0)
+        return QByteArray();
+    QByteArray data;
+    for (uint i = 0; i < format->nb_streams; ++i) {
+        const auto stream = format->streams[i];
+        if (stream->disposition & AV_DISPOSITION_ATTACHED_PIC && stream->attached_pic.size > 0) {
+            data = QByteArray((const char*)stream->attached_pic.data, stream->attached_pic.size);
+            break;
+        }
+    }
+    avformat_close_input(&format);
+    return data;
+}
+
+auto SlideDecoder::decode(const QString &file, const QSize &target) -> QImage
+{
+    QBuffer cover;
+    QImageReader reader;
+    if (_IsSuffixOf(AudioExt, QFileInfo(file).suffix())) {
+        cover.setData(attachedPicture(file));
+        if (cover.data().isEmpty())
+            return QImage();
+        reader.setDevice(&cover);
+    } else
+        reader.setFileName(file);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+    reader.setAutoTransform(true);
+    const bool rotated = reader.transformation() & QImageIOHandler::TransformationRotate90;
+#else
+    const bool rotated = false;
+#endif
+    // decoding scaled is much faster for large jpegs, never scale up
+    auto size = reader.size();
+    auto box = target;
+    if (rotated)
+        box.transpose();
+    if (size.isValid() && !box.isEmpty()
+            && (size.width() > box.width() || size.height() > box.height())) {
+        size.scale(box, Qt::KeepAspectRatio);
+        reader.setScaledSize(size);
+    }
+    auto image = reader.read();
+    if (image.isNull()) {
+        _Error("Cannot decode %%: %%", file, reader.errorString());
+        return image;
+    }
+    const auto format = image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                : QImage::Format_RGB32;
+    if (image.format() != format)
+        image = image.convertToFormat(format);
+    return image;
+}
+
+auto SlideDecoder::customEvent(QEvent *event) -> void
+{
+    switch (static_cast<int>(event->type())) {
+    case Decoded: {
+        int serial = 0; QString file; QImage image;
+        _TakeData(event, serial, file, image);
+        if (serial != d->serial)
+            break;
+        d->pending.remove(file);
+        if (image.isNull())
+            break;
+        if (d->find(file) < 0)
+            d->store(file, image);
+        emit decoded(file, image);
+        break;
+    } default:
+        break;
+    }
+}
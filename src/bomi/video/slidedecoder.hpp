@@ -0,0 +1,32 @@
+#ifndef SLIDEDECODER_HPP
+#define SLIDEDECODER_HPP
+
+// decodes still images or covers embedded in audio files in background,
+// scaled down to display size
+// a few decoded ones are kept so that going back and forth needs no decoding
+class SlideDecoder : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int Capacity = 4;
+    SlideDecoder(QObject *parent = nullptr);
+    ~SlideDecoder();
+    // larger size drops decoded images as they would look blurry
+    auto setTargetSize(const QSize &size) -> void;
+    auto targetSize() const -> QSize;
+    // start decoding unless decoded or pending
+    auto prefetch(const QString &file) -> void;
+    // decoded one or decode now if not decoded yet
+    auto get(const QString &file) -> QImage;
+    // decoded one or null image, never decodes
+    auto cached(const QString &file) const -> QImage;
+    auto clear() -> void;
+    static auto decode(const QString &file, const QSize &target) -> QImage;
+signals:
+    void decoded(const QString &file, const QImage &image);
+private:
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // SLIDEDECODER_HPP
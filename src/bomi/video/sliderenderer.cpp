@@ -0,0 +1,164 @@
+#include "sliderenderer.hpp"
+#include "opengl/opengltexture2d.hpp"
+#include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglshadercache.hpp"
+#include "misc/log.hpp"
+#include <QOpenGLShaderProgram>
+
+DECLARE_LOG_CONTEXT(Video)
+
+struct SlideTexture {
+    qint64 key = 0;
+    OpenGLTexture2D texture;
+};
+
+struct SlideRenderer::Data {
+    QOpenGLShaderProgram *shader = nullptr;
+    int loc_weight = -1;
+    // most recently used at back
+    QList<SlideTexture*> textures;
+    auto find(const QImage &image) -> SlideTexture*
+    {
+        for (int i = 0; i < textures.size(); ++i) {
+            if (textures[i]->key == image.cacheKey()) {
+                textures.move(i, textures.size() - 1);
+                return textures.back();
+            }
+        }
+        return nullptr;
+    }
+    auto texture(const QImage &image) -> SlideTexture*
+    {
+        if (image.isNull())
+            return nullptr;
+        if (auto t = find(image))
+            return t;
+        SlideTexture *t = nullptr;
+        if (textures.size() < TextureMax) {
+            t = new SlideTexture;
+            t->texture.create();
+        } else {
+            t = textures.takeFirst();
+        }
+        t->key = image.cacheKey();
+        OpenGLTextureBinder<OGL::Target2D> binder(&t->texture);
+        t->texture.initialize(image.width(), image.height(), OGL::BGRA, image.constBits());
+        textures.push_back(t);
+        return t;
+    }
+    // rect in normalized device coordinates
+    auto draw(const SlideTexture *t, const QRectF &rect, float weight) -> void
+    {
+        if (!t || weight <= 0.0f)
+            return;
+        const GLfloat quad[] = {
+            float(rect.left()), float(rect.top()), float(rect.right()), float(rect.top()),
+            float(rect.left()), float(rect.bottom()), float(rect.right()), float(rect.bottom())
+        };
+        static const GLfloat coords[] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+        auto f = QOpenGLContext::currentContext()->functions();
+        f->glActiveTexture(GL_TEXTURE0);
+        t->texture.bind();
+        shader->setUniformValue(loc_weight, weight);
+        shader->setAttributeArray(0, quad, 2);
+        shader->setAttributeArray(1, coords, 2);
+        f->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+};
+
+SlideRenderer::SlideRenderer()
+    : d(new Data)
+{
+}
+
+SlideRenderer::~SlideRenderer()
+{
+    Q_ASSERT(!d->shader);
+    delete d;
+}
+
+auto SlideRenderer::create() -> bool
+{
+    if (d->shader)
+        return true;
+    OpenGLShaderCache::Source source;
+    source.vertex = R"(
+        attribute vec2 aPosition;
+        attribute vec2 aTexCoord;
+        varying vec2 texCoord;
+        void main() {
+            texCoord = aTexCoord;
+            gl_Position = vec4(aPosition, 0.0, 1.0);
+        }
+    )";
+    source.fragment = R"(
+        uniform sampler2D tex;
+        uniform float weight;
+        varying vec2 texCoord;
+        void main() {
+            gl_FragColor = texture2D(tex, texCoord) * weight;
+        }
+    )";
+    source.attributes << "aPosition" << "aTexCoord";
+    d->shader = new QOpenGLShaderProgram;
+    if (!OpenGLShaderCache::link(d->shader, source)) {
+        _Error("Cannot initialize slide renderer.");
+        _Delete(d->shader);
+        return false;
+    }
+    d->shader->bind();
+    d->shader->setUniformValue(d->shader->uniformLocation("tex"), 0);
+    d->loc_weight = d->shader->uniformLocation("weight");
+    d->shader->release();
+    return true;
+}
+
+auto SlideRenderer::destroy() -> void
+{
+    for (auto t : d->textures) {
+        t->texture.destroy();
+        delete t;
+    }
+    d->textures.clear();
+    _Delete(d->shader);
+}
+
+auto SlideRenderer::upload(const QImage &image) -> void
+{
+    if (d->shader)
+        d->texture(image);
+}
+
+auto SlideRenderer::draw(OpenGLFramebufferObject *fbo, const QImage &current,
+                         const QImage &previous, double progress) -> void
+{
+    if (!d->shader || !fbo || fbo->size().isEmpty())
+        return;
+    // look up previous one first not to evict it by uploading current one
+    const auto prev = progress < 1.0 ? d->texture(previous) : nullptr;
+    const auto cur = d->texture(current);
+    auto f = QOpenGLContext::currentContext()->functions();
+    fbo->bind();
+    f->glViewport(0, 0, fbo->width(), fbo->height());
+    f->glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    f->glClear(GL_COLOR_BUFFER_BIT);
+    // weighted sum of both
+    f->glEnable(GL_BLEND);
+    f->glBlendFunc(GL_ONE, GL_ONE);
+    d->shader->bind();
+    d->shader->enableAttributeArray(0);
+    d->shader->enableAttributeArray(1);
+    if (prev) {
+        QSizeF size = prev->texture.size();
+        size.scale(fbo->size(), Qt::KeepAspectRatio);
+        const double w = size.width() / fbo->width(), h = size.height() / fbo->height();
+        d->draw(prev, QRectF(QPointF(-w, -h), QPointF(w, h)), 1.0 - progress);
+    }
+    d->draw(cur, QRectF(QPointF(-1, -1), QPointF(1, 1)), prev ? progress : 1.0);
+    d->shader->disableAttributeArray(0);
+    d->shader->disableAttributeArray(1);
+    d->shader->release();
+    f->glDisable(GL_BLEND);
+    fbo->release();
+}
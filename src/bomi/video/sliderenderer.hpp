@@ -0,0 +1,30 @@
+#ifndef SLIDERENDERER_HPP
+#define SLIDERENDERER_HPP
+
+class OpenGLFramebufferObject;
+
+// draws still images into frame fbo instead of mpv, cross fading between them
+// uploaded textures are kept for a few images so that next and previous
+// slides are in gpu memory before they are shown
+class SlideRenderer {
+public:
+    static constexpr int TextureMax = 3;
+    SlideRenderer();
+    SlideRenderer(const SlideRenderer &) = delete;
+    SlideRenderer &operator = (const SlideRenderer &) = delete;
+    ~SlideRenderer();
+    // current context is required for functions below
+    auto create() -> bool;
+    auto destroy() -> void;
+    // upload unless cached, least recently used one is evicted
+    auto upload(const QImage &image) -> void;
+    // current one over previous one which fades out while progress goes to 1
+    // previous one keeps its aspect ratio within fbo
+    auto draw(OpenGLFramebufferObject *fbo, const QImage &current,
+              const QImage &previous, double progress) -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // SLIDERENDERER_HPP
@@ -18,7 +18,10 @@ struct SoftwareDeinterlacer::Data {
     std::deque<MpImage> queue;
 
     auto bobField(bool top) const -> MpImage
-        { return bob.field(deint.method, input, top); }
+    {
+        auto pool = p->pool();
+        return pool ? bob.field(deint.method, input, top, *pool) : MpImage();
+    }
     auto step(int split) const -> double
     {
         if (pts == MP_NOPTS_VALUE || prev == MP_NOPTS_VALUE)
@@ -45,6 +48,7 @@ SoftwareDeinterlacer::SoftwareDeinterlacer()
     : d(new Data)
 {
     d->p = this;
+    d->graph.setPipelined(true);
 }
 
 SoftwareDeinterlacer::~SoftwareDeinterlacer()
@@ -59,8 +63,10 @@ auto SoftwareDeinterlacer::pass() const -> bool
 
 auto SoftwareDeinterlacer::push(MpImage &&mpi) -> void
 {
-    if (mpi.isNull())
+    if (mpi.isNull()) {
+        d->graph.flush();
         return;
+    }
     d->setNewPts(mpi->pts);
     d->input = std::move(mpi);
     d->processed = 0;
@@ -71,8 +77,10 @@ auto SoftwareDeinterlacer::push(MpImage &&mpi) -> void
         case Mark: case Bob:
             break;
         case Graph:
-            if (!(d->pass = !d->graph.initialize(d->option, d->input)))
+            if (!(d->pass = !d->graph.initialize(d->option, d->input))) {
                 d->graph.push(d->input);
+                d->input.release();
+            }
             break;
         default:
             d->pass = true;
@@ -83,6 +91,16 @@ auto SoftwareDeinterlacer::push(MpImage &&mpi) -> void
 
 auto SoftwareDeinterlacer::pop() -> MpImage
 {
+    if (d->type == Graph && !d->pass) {
+        // graph runs behind input, its output carries its own pts
+        auto ret = d->graph.pull();
+        if (!ret.isNull()) {
+            ret->fields &= ~MP_IMGFIELD_INTERLACED;
+            if (ret->pts == MP_NOPTS_VALUE)
+                ret->pts = d->nextPts();
+        }
+        return ret;
+    }
     if (d->processed >= d->count || d->input.isNull())
         return MpImage();
     MpImage ret;
@@ -100,13 +118,6 @@ auto SoftwareDeinterlacer::pop() -> MpImage
                 ret->fields |= fields[!topFirst];
             }
             break;
-        } case Graph: {
-            ret = d->graph.pull();
-            if (!ret.isNull()) {
-                ret->fields &= ~MP_IMGFIELD_INTERLACED;
-                ret->pts = d->nextPts();
-            }
-            break;
         } case Bob: {
             const bool topFirst = d->input->fields & MP_IMGFIELD_TOP_FIRST;
             ret = d->bobField(topFirst == !d->processed);
@@ -144,7 +155,7 @@ auto SoftwareDeinterlacer::setOption(const DeintOption &deint) -> void
             d->type = Bob;
             break;
         case DeintMethod::Yadif:
-            d->option = "yadif"_a % (d->deint.doubler ? "=mode=1"_a : ""_a);
+            d->option = d->deint.doubler ? u"yadif=mode=1"_q : u"yadif"_q;
             d->type = Graph;
             break;
         default:
@@ -158,6 +169,13 @@ auto SoftwareDeinterlacer::setOption(const DeintOption &deint) -> void
 auto SoftwareDeinterlacer::clear() -> void
 {
     d->queue.clear();
+    d->graph.clear();
+    d->pass = false;
+}
+
+auto SoftwareDeinterlacer::setThreads(int threads) -> void
+{
+    d->graph.setThreads(threads);
 }
 
 auto SoftwareDeinterlacer::fpsManipulation() const -> double
@@ -13,6 +13,8 @@ public:
     SoftwareDeinterlacer(const SoftwareDeinterlacer &other) = delete;
     SoftwareDeinterlacer &operator = (const SoftwareDeinterlacer &rhs) = delete;
     auto setOption(const DeintOption &deint) -> void;
+    // threads for filter graph, 0 for the number of cores
+    auto setThreads(int threads) -> void;
     auto push(MpImage &&mpi) -> void;
     auto pop() -> MpImage;
     auto clear() -> void;
@@ -0,0 +1,188 @@
+#include "streamitem.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "misc/dataevent.hpp"
+#include "misc/log.hpp"
+#include "player/mpv.hpp"
+#include <QQuickWindow>
+
+DECLARE_LOG_CONTEXT(Video)
+
+enum EventType {NewFrame = QEvent::User + 1 };
+
+struct StreamItem::Data {
+    StreamItem *p = nullptr;
+    QString source;
+    bool audible = false, redraw = false, scaled = false;
+    Priority priority = Normal;
+    int maxHeight = 0, height = 0, id = 0;
+    Mpv mpv;
+    // items of all windows, only one of them is audible
+    static QList<StreamItem*> items;
+    auto limit() -> void
+    {
+        const bool scale = maxHeight > 0 && height > maxHeight;
+        if (!_Change(scaled, scale) && !scale)
+            return;
+        mpv.tellAsync("vf", "set"_b, scale ? "scale=-2:"_b + QByteArray::number(maxHeight)
+                                           : QByteArray());
+    }
+    auto load() -> void
+    {
+        const bool low = priority == Low;
+        mpv.setAsync("options/vd-lavc-threads", low ? 1 : 0);
+        mpv.setAsync("options/vd-lavc-fast", low);
+        mpv.setAsync("options/vd-lavc-skiploopfilter", MpvLatin1(low ? u"all"_q : u"default"_q));
+        scaled = false;
+        height = 0;
+        mpv.tellAsync("vf", "set"_b, QByteArray());
+        if (source.isEmpty())
+            mpv.tellAsync("stop");
+        else
+            mpv.tellAsync("loadfile", MpvFile(source));
+    }
+};
+
+QList<StreamItem*> StreamItem::Data::items;
+
+StreamItem::StreamItem(QQuickItem *parent)
+    : Super(parent), d(new Data)
+{
+    d->p = this;
+    Data::items.append(this);
+    d->mpv.setLogContext("mpv/stream"_b);
+    d->mpv.create();
+    d->mpv.setObserver(this);
+    d->mpv.observe("vid", [=] (int id) {
+        const bool video = hasVideo();
+        if (_Change(d->id, id) && video != hasVideo())
+            emit hasVideoChanged();
+    });
+    d->mpv.observe("height", [=] (int height) {
+        d->height = height;
+        d->limit();
+    });
+    // streams of wall are watched together, so nothing is kept for next time
+    d->mpv.setOption("hwdec", "no");
+    d->mpv.setOption("aid", "no");
+    d->mpv.setOption("sid", "no");
+    d->mpv.setOption("sub-auto", "no");
+    d->mpv.setOption("osd-level", "0");
+    d->mpv.setOption("quiet", "yes");
+    d->mpv.setOption("title", "\"\"");
+    d->mpv.setOption("vo", "opengl-cb:scale=bilinear:dscale=bilinear:cscale=bilinear"
+                           ":dither-depth=no:fbo-format=rgba");
+    d->mpv.setOption("keep-open", "yes");
+    d->mpv.setOption("loop", "inf");
+    d->mpv.setOption("use-text-osd", "no");
+    d->mpv.setOption("audio-display", "no");
+    d->mpv.initialize(Log::Error);
+    d->mpv.setUpdateCallback([=] () { _PostEvent(this, NewFrame); });
+    d->mpv.start();
+}
+
+StreamItem::~StreamItem()
+{
+    Data::items.removeOne(this);
+    d->mpv.destroy();
+    delete d;
+}
+
+auto StreamItem::initializeGL() -> void
+{
+    Super::initializeGL();
+    d->mpv.initializeGL(QOpenGLContext::currentContext());
+}
+
+auto StreamItem::finalizeGL() -> void
+{
+    Super::finalizeGL();
+    d->mpv.finalizeGL();
+}
+
+auto StreamItem::customEvent(QEvent *event) -> void
+{
+    switch (static_cast<int>(event->type())) {
+    case NewFrame:
+        d->redraw = true;
+        reserve(UpdateMaterial);
+        break;
+    default:
+        d->mpv.process(event);
+        break;
+    }
+}
+
+auto StreamItem::paint(OpenGLFramebufferObject *fbo) -> void
+{
+    fbo->bind();
+    if (d->redraw) {
+        d->redraw = false;
+        if (auto w = window()) {
+            w->resetOpenGLState();
+            d->mpv.render(fbo, nullptr, QMargins());
+            w->resetOpenGLState();
+        }
+    }
+    fbo->release();
+}
+
+auto StreamItem::source() const -> QString
+{
+    return d->source;
+}
+
+auto StreamItem::setSource(const QString &source) -> void
+{
+    if (!_Change(d->source, source))
+        return;
+    d->load();
+    emit sourceChanged();
+}
+
+auto StreamItem::isAudible() const -> bool
+{
+    return d->audible;
+}
+
+auto StreamItem::setAudible(bool audible) -> void
+{
+    if (!_Change(d->audible, audible))
+        return;
+    if (audible) {
+        for (auto item : Data::items) {
+            if (item != this)
+                item->setAudible(false);
+        }
+    }
+    d->mpv.setAsync("aid", MpvLatin1(audible ? u"auto"_q : u"no"_q));
+    emit audibleChanged();
+}
+
+auto StreamItem::priority() const -> Priority
+{
+    return d->priority;
+}
+
+auto StreamItem::setPriority(Priority priority) -> void
+{
+    if (_Change(d->priority, priority))
+        emit priorityChanged();
+}
+
+auto StreamItem::maxHeight() const -> int
+{
+    return d->maxHeight;
+}
+
+auto StreamItem::setMaxHeight(int height) -> void
+{
+    if (!_Change(d->maxHeight, qMax(0, height)))
+        return;
+    d->limit();
+    emit maxHeightChanged();
+}
+
+auto StreamItem::hasVideo() const -> bool
+{
+    return d->id > 0;
+}
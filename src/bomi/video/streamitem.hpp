@@ -0,0 +1,50 @@
+#ifndef STREAMITEM_HPP
+#define STREAMITEM_HPP
+
+#include "quick/simplefboitem.hpp"
+
+// one more stream in the window of main player for picture-in-picture or
+// video wall in skins, each has own opengl-cb instance like VideoPreview
+// but all of them are drawn in one scene graph and its gl context
+// only audible one among them plays audio
+class StreamItem : public SimpleFboItem {
+    Q_OBJECT
+    Q_ENUMS(Priority)
+    using Super = SimpleFboItem;
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(bool audible READ isAudible WRITE setAudible NOTIFY audibleChanged)
+    Q_PROPERTY(Priority priority READ priority WRITE setPriority NOTIFY priorityChanged)
+    Q_PROPERTY(int maxHeight READ maxHeight WRITE setMaxHeight NOTIFY maxHeightChanged)
+    Q_PROPERTY(bool hasVideo READ hasVideo NOTIFY hasVideoChanged)
+public:
+    // decoding threads and shortcuts, applied from next source
+    enum Priority { Low, Normal };
+    StreamItem(QQuickItem *parent = nullptr);
+    ~StreamItem();
+    auto source() const -> QString;
+    auto setSource(const QString &source) -> void;
+    auto isAudible() const -> bool;
+    auto setAudible(bool audible) -> void;
+    auto priority() const -> Priority;
+    auto setPriority(Priority priority) -> void;
+    // video taller than this is scaled down before upload, 0 for no limit
+    auto maxHeight() const -> int;
+    auto setMaxHeight(int height) -> void;
+    auto hasVideo() const -> bool;
+    auto imageSize() const -> QSize final { return size().toSize(); }
+signals:
+    void sourceChanged();
+    void audibleChanged();
+    void priorityChanged();
+    void maxHeightChanged();
+    void hasVideoChanged();
+private:
+    auto paint(OpenGLFramebufferObject *fbo) -> void final;
+    auto initializeGL() -> void final;
+    auto finalizeGL() -> void final;
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // STREAMITEM_HPP
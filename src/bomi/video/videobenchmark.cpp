@@ -0,0 +1,190 @@
+#include "videobenchmark.hpp"
+#include "mpimage.hpp"
+#include "videofilter.hpp"
+#include "softwaredeinterlacer.hpp"
+#include "motioninterpolator.hpp"
+#include "motionintrploption.hpp"
+#include "deintoption.hpp"
+#include "lumascan.hpp"
+#include "combdetector.hpp"
+#include "os/os.hpp"
+#include "misc/benchmarktable.hpp"
+#include <QElapsedTimer>
+
+// distinct source frames which are repeated
+static constexpr int Sources = 4;
+
+struct VideoBenchmark::Data {
+    int frames = 120;
+
+    // moving bars with fields sampled at different times to comb on motion
+    auto fill(MpImage &mpi, int index) const -> void
+    {
+        const int depth = mpi->fmt.plane_bits;
+        const int max = (1 << depth) - 1, bytes = depth > 8 ? 2 : 1;
+        auto put = [&] (uchar *line, int x, int v) {
+            if (bytes > 1)
+                ((quint16*)line)[x] = v;
+            else
+                line[x] = v;
+        };
+        for (int y = 0; y < mpi->h; ++y) {
+            auto line = mpi->planes[0] + y * mpi->stride[0];
+            const int shift = (index * 2 + (y & 1)) * 8;
+            for (int x = 0; x < mpi->w; ++x)
+                put(line, x, (((x + shift) >> 5) & 1) ? max * 3 / 4 : max / 4);
+        }
+        for (int p = 1; p < mpi->num_planes; ++p) {
+            const int w = mpi->w >> mpi->fmt.xs[p], h = mpi->h >> mpi->fmt.ys[p];
+            for (int y = 0; y < h; ++y) {
+                auto line = mpi->planes[p] + y * mpi->stride[p];
+                for (int x = 0; x < w; ++x)
+                    put(line, x, (max + 1) / 2);
+            }
+        }
+        mpi->fields = MP_IMGFIELD_INTERLACED | MP_IMGFIELD_TOP_FIRST;
+    }
+};
+
+VideoBenchmark::VideoBenchmark()
+    : d(new Data)
+{
+
+}
+
+VideoBenchmark::~VideoBenchmark()
+{
+    delete d;
+}
+
+auto VideoBenchmark::setFrames(int frames) -> void
+{
+    d->frames = frames;
+}
+
+auto VideoBenchmark::run(const Case &c) -> Result
+{
+    MpImagePool pool(16);
+    QVector<MpImage> sources;
+    for (int i = 0; i < Sources; ++i) {
+        auto mpi = pool.get(c.imgfmt, c.size.width(), c.size.height());
+        if (mpi.isNull())
+            return Result();
+        d->fill(mpi, i);
+        sources.push_back(std::move(mpi));
+    }
+
+    PassthroughVideoFilter passthrough;
+    SoftwareDeinterlacer deinterlacer;
+    MotionInterpolator interpolator;
+    CombDetector combs;
+    VideoFilter *filter = nullptr;
+    switch (c.stage) {
+    case Passthrough:
+        filter = &passthrough;
+        break;
+    case Bob: case Yadif: case YadifDoubler:
+        deinterlacer.setOption(DeintOption(c.stage == Bob ? DeintMethod::Bob
+                                                          : DeintMethod::Yadif,
+                                           Processor::CPU, c.stage != Yadif));
+        filter = &deinterlacer;
+        break;
+    case Blend: case Compensate: {
+        MotionIntrplOption option;
+        option.sync_to_monitor = false;
+        option.target_fps = 60;
+        option.compensate = c.stage == Compensate;
+        interpolator.setOption(option);
+        filter = &interpolator;
+        break;
+    } default:
+        break;
+    }
+    if (filter)
+        filter->setPool(&pool);
+
+    Result result;
+    const double memory = OS::usingMemory();
+    QElapsedTimer timer;
+    auto drain = [&] () {
+        for (;;) {
+            auto out = filter->pop();
+            if (out.isNull())
+                break;
+            ++result.out;
+        }
+    };
+    for (int i = 0; i < d->frames; ++i) {
+        auto mpi = MpImage::ref(sources[i % Sources].data());
+        mpi->pts = i / SourceFps;
+        const auto allocs = MpImagePool::allocations();
+        timer.start();
+        if (filter) {
+            filter->push(std::move(mpi));
+            drain();
+        } else {
+            if (c.stage == LumaScan)
+                _LumaScan(mpi.data());
+            else
+                combs.feed(mpi.data());
+            ++result.out;
+        }
+        result.nsecs += timer.nsecsElapsed();
+        result.allocations += MpImagePool::allocations() - allocs;
+        result.peak = std::max(result.peak, OS::usingMemory() - memory);
+        ++result.in;
+    }
+    if (filter) {
+        timer.start();
+        filter->push(MpImage());
+        drain();
+        result.nsecs += timer.nsecsElapsed();
+    }
+    return result;
+}
+
+auto VideoBenchmark::cases() -> QList<Case>
+{
+    struct Format { const char *name; int imgfmt; };
+    struct Size { const char *name; QSize size; };
+    static const Format formats[] = {
+        { "8bit", IMGFMT_420P }, { "10bit", IMGFMT_420P10 }
+    };
+    static const Size sizes[] = {
+        { "1080p", {1920, 1080} }, { "2160p", {3840, 2160} }
+    };
+    static const std::pair<Stage, const char*> stages[] = {
+        { Passthrough, "pass" }, { Bob, "bob x2" }, { Yadif, "yadif" },
+        { YadifDoubler, "yadif x2" }, { Blend, "interpolate 60" },
+        { Compensate, "interpolate 60 mc" }, { LumaScan, "luma scan" },
+        { CombDetect, "comb detect" }
+    };
+    QList<Case> cases;
+    for (auto &size : sizes) {
+        for (auto &format : formats) {
+            for (auto &stage : stages) {
+                Case c;
+                c.name = _L(size.name) % ' '_q % _L(format.name) % ' '_q % _L(stage.second);
+                c.imgfmt = format.imgfmt;
+                c.size = size.size;
+                c.stage = stage.first;
+                cases.push_back(c);
+            }
+        }
+    }
+    return cases;
+}
+
+auto VideoBenchmark::dumpInfo() -> void
+{
+    VideoBenchmark bench;
+    const auto cases = VideoBenchmark::cases();
+    BenchmarkTable table;
+    table.fit(cases);
+    table.header(u"case"_q, "       fps  realtime  allocs/frame  peak MiB");
+    for (auto &c : cases) {
+        const auto r = bench.run(c);
+        table.row(c.name, _N(r.fps(), 1, 10) % _N(r.realtime(SourceFps), 2, 9) % 'x'_q
+                  % _N(r.allocationsPerFrame(), 2, 14) % _N(r.peak, 1, 10));
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef VIDEOBENCHMARK_HPP
+#define VIDEOBENCHMARK_HPP
+
+// runs the filter stages of VideoProcessor against synthetic frames
+// without a decoder or video output, to measure the cost of the video path
+
+class VideoBenchmark {
+public:
+    enum Stage {
+        Passthrough, Bob, Yadif, YadifDoubler, Blend, Compensate,
+        LumaScan, CombDetect
+    };
+    struct Case {
+        QString name;
+        int imgfmt; QSize size;
+        Stage stage;
+    };
+    struct Result {
+        quint64 in = 0, out = 0, allocations = 0, nsecs = 0;
+        // growth of resident memory while running in MiB
+        double peak = 0.0;
+        auto fps() const -> double { return nsecs ? out / (nsecs * 1e-9) : 0.0; }
+        auto allocationsPerFrame() const -> double
+            { return in ? allocations / double(in) : 0.0; }
+        // processed seconds of video per second
+        auto realtime(double fps) const -> double
+            { return nsecs ? in / fps / (nsecs * 1e-9) : 0.0; }
+    };
+    // frame rate of synthetic source, which is interlaced tff
+    static constexpr double SourceFps = 30.0;
+    VideoBenchmark();
+    ~VideoBenchmark();
+    // number of source frames for each case
+    auto setFrames(int frames) -> void;
+    auto run(const Case &c) -> Result;
+    static auto cases() -> QList<Case>;
+    // fps and allocations of every case on stdout
+    static auto dumpInfo() -> void;
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // VIDEOBENCHMARK_HPP
@@ -5,11 +5,17 @@
 
 class VideoFilter {
 public:
+    virtual ~VideoFilter() { }
+    // pool shared by filters for new images
+    auto setPool(MpImagePool *pool) -> void { m_pool = pool; }
+    auto pool() const -> MpImagePool* { return m_pool; }
     virtual auto push(MpImage &&mpi) -> void = 0;
     virtual auto pop() -> MpImage = 0;
     virtual auto clear() -> void = 0;
     virtual auto needsMore() const -> bool;
     virtual auto fpsManipulation() const -> double { return 1.0; }
+private:
+    MpImagePool *m_pool = nullptr;
 };
 
 class PassthroughVideoFilter : public VideoFilter {
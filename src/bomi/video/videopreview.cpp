@@ -5,11 +5,47 @@
 #include "misc/dataevent.hpp"
 #include "misc/log.hpp"
 #include "player/mpv.hpp"
+#include "previewsprite.hpp"
+#include "rendertiming.hpp"
+#include "os/os.hpp"
 #include <QQuickWindow>
+#include <QThreadPool>
+#include <QElapsedTimer>
 
 DECLARE_LOG_CONTEXT(Video)
 
-enum EventType {NewFrame = QEvent::User + 1 };
+enum EventType {NewFrame = QEvent::User + 1, SpriteMissing, SpriteReady };
+
+// share of gpu time which preview may spend, renders are delayed beyond this
+static constexpr double GpuShare = 0.1;
+// msec after which seek is regarded as lost and next one is sent anyway
+static constexpr qint64 SeekTimeout = 1000;
+
+// find cached sprite, or let live preview run until new one is generated
+class SpriteJob : public QRunnable {
+public:
+    SpriteJob(QObject *preview, const QByteArray &path, const QString &file,
+              const QSharedPointer<std::atomic<bool>> &cancel)
+        : m_preview(preview), m_path(path), m_file(file), m_cancel(cancel) { }
+    auto run() -> void final
+    {
+        OS::setThreadClass(OS::ThreadClass::Background);
+        auto sprite = PreviewSprite::cached(m_file);
+        if (sprite.isNull()) {
+            if (*m_cancel)
+                return;
+            _PostEvent(m_preview, SpriteMissing, m_path);
+            sprite = PreviewSprite::generate(m_file, *m_cancel);
+        }
+        if (!sprite.isNull() && !*m_cancel)
+            _PostEvent(m_preview, SpriteReady, m_path, sprite);
+    }
+private:
+    QObject *m_preview = nullptr;
+    QByteArray m_path;
+    QString m_file;
+    QSharedPointer<std::atomic<bool>> m_cancel;
+};
 
 struct VideoPreview::Data {
     VideoPreview *p = nullptr;
@@ -19,8 +55,75 @@ struct VideoPreview::Data {
     QSize displaySize{0, 0};
     double rate = 0.0, aspect = 0, percent = 0;
     Mpv mpv;
-    auto vo() const -> QByteArray { return "opengl-cb"_b; }
-    auto hasVideo() -> bool { return id > 0 && !displaySize.isEmpty(); }
+    // hover preview becomes texture lookup when sprite is available
+    QThreadPool pool;
+    QByteArray path;
+    QSharedPointer<std::atomic<bool>> cancel;
+    PreviewSprite sprite;
+    int tile = -1;
+    // only one seek is in flight, the latest request replaces pending one
+    bool seeking = false;
+    double pending = -1;
+    qint64 seekTime = 0;
+    // render thread measures and gui thread delays next render
+    RenderTiming timing;
+    QElapsedTimer clock;
+    std::atomic<qint64> next{0};
+    QTimer throttle;
+    auto vo() const -> QByteArray
+    {
+        return "opengl-cb:scale=bilinear:dscale=bilinear:cscale=bilinear"
+               ":dither-depth=no:fbo-format=rgba"_b;
+    }
+    auto seek(double percent) -> void
+    {
+        if (seeking && clock.elapsed() - seekTime < SeekTimeout) {
+            pending = percent;
+            return;
+        }
+        seeking = true;
+        seekTime = clock.elapsed();
+        pending = -1;
+        mpv.tellAsync("seek", percent, keyframe ? "absolute-percent+keyframes"_b
+                                                : "absolute-percent+exact"_b);
+    }
+    auto finishSeek() -> void
+    {
+        seeking = false;
+        if (pending >= 0)
+            seek(pending);
+    }
+    auto resetSeek() -> void
+    {
+        seeking = false;
+        pending = -1;
+    }
+    auto update() -> void
+    {
+        const auto wait = next - clock.elapsed();
+        if (wait > 0) {
+            if (!throttle.isActive())
+                throttle.start(wait);
+            return;
+        }
+        redraw = true;
+        p->reserve(UpdateMaterial);
+    }
+    auto hasVideo() -> bool
+        { return (id > 0 || !sprite.isNull()) && !displaySize.isEmpty(); }
+    auto cancelSprite() -> void
+    {
+        if (cancel)
+            *cancel = true;
+        cancel.reset();
+        path.clear();
+        tile = -1;
+        if (!sprite.isNull()) {
+            sprite = PreviewSprite();
+            if (_Change(video, hasVideo()))
+                emit p->hasVideoChanged(video);
+        }
+    }
     auto sizeAspect() const -> double
     {
         if (displaySize.isEmpty())
@@ -33,6 +136,10 @@ VideoPreview::VideoPreview(QQuickItem *parent)
     : Super(parent), d(new Data)
 {
     d->p = this;
+    d->pool.setMaxThreadCount(1);
+    d->clock.start();
+    d->throttle.setSingleShot(true);
+    connect(&d->throttle, &QTimer::timeout, this, [=] () { d->update(); });
     setAcceptHoverEvents(true);
     setAcceptedMouseButtons(Qt::AllButtons);
     setFlag(ItemAcceptsDrops, true);
@@ -46,8 +153,15 @@ VideoPreview::VideoPreview(QQuickItem *parent)
         if (_Change(d->id, id) && _Change(d->video, d->hasVideo()))
             emit hasVideoChanged(d->video);
     });
-    d->mpv.request(MPV_EVENT_START_FILE, [=] () { d->loaded = true; });
-    d->mpv.request(MPV_EVENT_END_FILE, [=] () { d->loaded = false; });
+    d->mpv.request(MPV_EVENT_START_FILE, [=] () { d->loaded = true; d->resetSeek(); });
+    d->mpv.request(MPV_EVENT_END_FILE, [=] () { d->loaded = false; d->resetSeek(); });
+    d->mpv.request(MPV_EVENT_PLAYBACK_RESTART, [=] () { d->finishSeek(); });
+    d->mpv.setRenderTiming(&d->timing);
+    // never compete with main playback: software decoding in a few threads
+    // at lower priority with speedups which do not matter for thumbnails
+    d->mpv.setOption("core-nice", "10");
+    d->mpv.setOption("vd-lavc-threads", "2");
+    d->mpv.setOption("vd-lavc-fast", "yes");
     d->mpv.setOption("hwdec", "no");
     d->mpv.setOption("aid", "no");
     d->mpv.setOption("sid", "no");
@@ -70,6 +184,9 @@ VideoPreview::VideoPreview(QQuickItem *parent)
 }
 
 VideoPreview::~VideoPreview() {
+    d->cancelSprite();
+    d->pool.clear();
+    d->pool.waitForDone();
     d->mpv.destroy();
     delete d;
 }
@@ -93,13 +210,21 @@ auto VideoPreview::rate() const -> double
 
 auto VideoPreview::setRate(double rate) -> void
 {
-    if (!d->active || !d->video || !d->loaded)
+    if (!d->active || !d->video)
+        return;
+    if (!d->sprite.isNull()) {
+        if (_Change(d->rate, rate)) {
+            if (_Change(d->tile, d->sprite.index(d->rate)))
+                reserve(UpdateMaterial);
+            emit rateChanged(d->rate);
+        }
+        return;
+    }
+    if (!d->loaded)
         return;
     if (_Change(d->rate, rate)) {
         if (_Change(d->percent, qRound(d->rate * 10000)/100.0))
-            d->mpv.tellAsync("seek", d->percent, d->keyframe
-                             ? "absolute-percent+keyframes"_b
-                             : "absolute-percent+exact"_b);
+            d->seek(d->percent);
         emit rateChanged(d->rate);
     }
 }
@@ -113,7 +238,25 @@ auto VideoPreview::customEvent(QEvent *event) -> void
 {
     switch (static_cast<int>(event->type())) {
     case NewFrame: {
-        d->redraw = true;
+        d->update();
+        break;
+    } case SpriteMissing: {
+        QByteArray path;
+        _TakeData(event, path);
+        if (path == d->path)
+            d->mpv.tellAsync("loadfile", path);
+        break;
+    } case SpriteReady: {
+        QByteArray path; PreviewSprite sprite;
+        _TakeData(event, path, sprite);
+        if (path != d->path)
+            break;
+        if (d->loaded)
+            d->mpv.tellAsync("stop");
+        d->sprite = sprite;
+        d->tile = d->sprite.index(d->rate);
+        if (_Change(d->video, d->hasVideo()))
+            emit hasVideoChanged(d->video);
         reserve(UpdateMaterial);
         break;
     } default:
@@ -147,6 +290,18 @@ auto VideoPreview::sizeHint() const -> QSize
 
 auto VideoPreview::paint(OpenGLFramebufferObject *fbo) -> void
 {
+    if (!d->sprite.isNull()) {
+        if (d->tile < 0)
+            return;
+        // texture rows run bottom to top
+        const auto image = d->sprite.tile(d->tile)
+                .scaled(fbo->size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                .convertToFormat(QImage::Format_ARGB32).mirrored();
+        auto texture = fbo->texture();
+        OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+        texture.upload(image.constBits());
+        return;
+    }
     fbo->bind();
     if (d->redraw) {
         d->redraw = false;
@@ -155,6 +310,10 @@ auto VideoPreview::paint(OpenGLFramebufferObject *fbo) -> void
             w->resetOpenGLState();
             d->mpv.render(fbo, nullptr, QMargins());
             w->resetOpenGLState();
+            // keep average cost within share of gpu time
+            const auto s = d->timing.stats(4).passes[RenderTiming::Video];
+            const auto cost = s.gpu >= 0 ? s.gpu : s.cpu;
+            d->next = d->clock.elapsed() + qRound64(cost / GpuShare);
         }
     }
     fbo->release();
@@ -164,12 +323,22 @@ auto VideoPreview::load(const QByteArray &path) -> void
 {
     if (path.contains("bomi-yle-"_b))
         return;
-    if (d->active)
+    if (!d->active)
+        return;
+    d->cancelSprite();
+    const auto file = d->keyframe ? PreviewSprite::localFile(path) : QString();
+    if (file.isEmpty()) {
         d->mpv.tellAsync("loadfile", path);
+        return;
+    }
+    d->path = path;
+    d->cancel.reset(new std::atomic<bool>(false));
+    d->pool.start(new SpriteJob(this, path, file, d->cancel));
 }
 
 auto VideoPreview::unload() -> void
 {
+    d->cancelSprite();
     d->mpv.tellAsync("stop");
 }
 
@@ -4,12 +4,15 @@
 #include "softwaredeinterlacer.hpp"
 #include "motioninterpolator.hpp"
 #include "motionintrploption.hpp"
+#include "lumascan.hpp"
+#include "combdetector.hpp"
 #include "deintoption.hpp"
 #include "player/mpv_helper.hpp"
 #include "opengl/opengloffscreencontext.hpp"
 #include "os/os.hpp"
 #include "enum/colorrange.hpp"
 #include "enum/colorspace.hpp"
+#include "misc/tracer.hpp"
 extern "C" {
 #include <video/filter/vf.h>
 #include <video/hwdec.h>
@@ -20,7 +23,7 @@ extern vf_info vf_info_noformat;
 struct bomi_vf_priv {
     VideoProcessor *vp;
     char *address, *swdec_deint, *hwdec_deint;
-    int interpolate, color_range, color_space;
+    int interpolate, color_range, color_space, deint_threads, deint_detect;
 };
 
 static auto priv(vf_instance *vf) -> VideoProcessor*
@@ -35,6 +38,8 @@ auto create_vf_info() -> vf_info
         MPV_OPTION(address),
         MPV_OPTION(swdec_deint),
         MPV_OPTION(hwdec_deint),
+        MPV_OPTION(deint_threads),
+        MPV_OPTION(deint_detect),
         MPV_OPTION(interpolate),
         MPV_OPTION(color_space),
         MPV_OPTION(color_range),
@@ -59,11 +64,14 @@ public:
         m_pool = mp_image_pool_new(2);
     }
     virtual ~HwDecTool() { talloc_free(m_pool); }
-    virtual auto download(const MpImage &src) -> MpImage
+    virtual auto download(const MpImage &src,
+                          const OS::HwAcc::Download &part = OS::HwAcc::Download()) -> MpImage
     {
-        auto img = OS::hwAcc()->download(m_ctx, src.data(), m_pool);
+        auto img = OS::hwAcc()->download(m_ctx, src.data(), m_pool, part);
         return img ? MpImage::wrap(img) : MpImage();
     }
+    auto scanLuma(const MpImage &src) -> double
+        { return OS::hwAcc()->scanLuma(m_ctx, src.data()); }
 protected:
     mp_hwdec_ctx *m_ctx = nullptr;
     mp_image_pool *m_pool = nullptr;
@@ -75,11 +83,22 @@ struct VideoProcessor::Data {
     VideoProcessor *p = nullptr;
     vf_instance *vf = nullptr;
     DeintOption deint_swdec, deint_hwdec;
+    // resolved option for each of (off/on, swdec/hwdec, cpu/gpu)
+    std::array<DeintOption, 8> deints;
+    int deintIndex = -1;
     SoftwareDeinterlacer deinterlacer;
+    CombDetector combs;
     PassthroughVideoFilter passthrough;
     VideoFilter *filter = nullptr;
     MotionInterpolator interpolator;
     MotionIntrplOption intrplOption;
+    std::atomic<double> refresh{-1.0};
+    std::atomic<bool> refreshChanged{false};
+    // options from other threads, taken at next frame
+    enum Next { NextDeint = 1, NextInterpolate = 2 };
+    std::atomic<int> next{0};
+    DeintOptionSet nextDeint;
+    bool nextInterpolate = false;
     mp_image_params params;
     ColorSpace spaceIn = ColorSpace::Auto, spaceOut = ColorSpace::Auto, spaceOpt = ColorSpace::Auto;
     ColorRange rangeIn = ColorRange::Auto, rangeOut = ColorRange::Auto, rangeOpt = ColorRange::Auto;
@@ -87,9 +106,9 @@ struct VideoProcessor::Data {
     mp_csp_levels mp_lv_out = MP_CSP_LEVELS_AUTO;
     int hwdecType = -10;
     bool deint = false, inter_i = false, inter_o = false, interpolate = false;
-    bool hwacc = false;
+    bool hwacc = false, detect = false;
     HwDecTool *hwdec = nullptr;
-    mp_image_pool *pool = nullptr;
+    MpImagePool pool;
 
     QMutex mutex; // must be locked
     double ptsSkipStart = MP_NOPTS_VALUE, ptsLastSkip = MP_NOPTS_VALUE;
@@ -102,12 +121,47 @@ struct VideoProcessor::Data {
         interpolator.clear();
         filter = nullptr;
     }
+    auto resolveDeints() -> void
+    {
+        for (int i = 0; i < (int)deints.size(); ++i) {
+            auto &opt = deints[i];
+            opt = DeintOption();
+            if (i & 4)
+                opt = (i & 2) ? deint_hwdec : deint_swdec;
+            opt.processor = (i & 1) ? Processor::GPU : Processor::CPU;
+        }
+        deintIndex = -1;
+    }
+    auto takeNext() -> void
+    {
+        mutex.lock();
+        const int flags = next.exchange(0);
+        const auto set = nextDeint;
+        const bool intrpl = nextInterpolate;
+        mutex.unlock();
+        if (flags & NextDeint) {
+            deinterlacer.setThreads(set.threads);
+            detect = set.detect;
+            if (_Change(deint_swdec, set.swdec) | _Change(deint_hwdec, set.hwdec)) {
+                resolveDeints();
+                updateDeint();
+            }
+        }
+        // choose filter again
+        if ((flags & NextInterpolate) && _Change(interpolate, intrpl))
+            reset();
+    }
+    // filters are reset only if selected option has been changed
     auto updateDeint() -> void
     {
-        DeintOption opt;
-        if (deint)
-            opt = hwdecType > 0 ? deint_hwdec : deint_swdec;
-        opt.processor = hwacc ? Processor::GPU : Processor::CPU;
+        const int index = (deint << 2) | ((hwdecType > 0) << 1) | hwacc;
+        if (index == deintIndex)
+            return;
+        const bool changed = deintIndex < 0 || deints[index] != deints[deintIndex];
+        deintIndex = index;
+        if (!changed)
+            return;
+        const auto &opt = deints[index];
         deinterlacer.setOption(opt);
         reset();
         emit p->deintMethodChanged(opt.method);
@@ -118,12 +172,13 @@ VideoProcessor::VideoProcessor()
     : d(new Data)
 {
     d->p = this;
-    d->pool = mp_image_pool_new(1);
+    d->deinterlacer.setPool(&d->pool);
+    d->passthrough.setPool(&d->pool);
+    d->interpolator.setPool(&d->pool);
 }
 
 VideoProcessor::~VideoProcessor()
 {
-    talloc_free(d->pool);
     delete d->hwdec;
     delete d;
 }
@@ -133,6 +188,29 @@ auto VideoProcessor::setMotionIntrplOption(const MotionIntrplOption &option) ->
     d->intrplOption = option;
 }
 
+auto VideoProcessor::setDeintOptions(const DeintOptionSet &set) -> void
+{
+    d->mutex.lock();
+    d->nextDeint = set;
+    d->next |= Data::NextDeint;
+    d->mutex.unlock();
+}
+
+auto VideoProcessor::setMotionInterpolation(bool on) -> void
+{
+    d->mutex.lock();
+    d->nextInterpolate = on;
+    d->next |= Data::NextInterpolate;
+    d->mutex.unlock();
+}
+
+auto VideoProcessor::setDisplayRefreshRate(double hz) -> void
+{
+    if (hz <= 0 || d->refresh.exchange(hz) == hz)
+        return;
+    d->refreshChanged = true;
+}
+
 auto VideoProcessor::open(vf_instance *vf) -> int
 {
     auto p = reinterpret_cast<bomi_vf_priv*>(vf->priv);
@@ -143,8 +221,13 @@ auto VideoProcessor::open(vf_instance *vf) -> int
         d->deint_swdec = DeintOption::fromString(_L(p->swdec_deint));
     if (p->hwdec_deint)
         d->deint_hwdec = DeintOption::fromString(_L(p->hwdec_deint));
+    d->resolveDeints();
     d->spaceOpt = (ColorSpace)p->color_space;
     d->rangeOpt = (ColorRange)p->color_range;
+    d->deinterlacer.setThreads(p->deint_threads);
+    d->detect = p->deint_detect;
+    d->interpolate = p->interpolate;
+    d->combs.reset();
     d->updateDeint();
     memset(&d->params, 0, sizeof(d->params));
     vf->reconfig = [] (vf_instance *vf, mp_image_params *in,
@@ -165,7 +248,7 @@ auto VideoProcessor::open(vf_instance *vf) -> int
     hwdec_request_api(vf->hwdec, OS::hwAcc()->name().toLatin1());
     if (vf->hwdec && vf->hwdec->hwctx)
         d->hwdec = new HwDecTool(vf->hwdec->hwctx);
-    mp_image_pool_clear(d->pool);
+    d->pool.clear();
     p->vp->stopSkipping();
     return true;
 }
@@ -239,8 +322,9 @@ auto VideoProcessor::reconfig(mp_image_params *in, mp_image_params *out) -> int
     if (_Change(d->rangeOut, mp2enum(out->colorlevels)))
         emit outputColorRangeChanged(d->rangeOut);
 
-    d->interpolator.setTargetFps(d->intrplOption.fps());
+    d->interpolator.setOption(d->intrplOption);
     d->reset();
+    d->combs.reset();
     d->hwdecType = -10;
     return 0;
 }
@@ -267,58 +351,6 @@ auto VideoProcessor::isSkipping() const -> bool
     return d->skip;
 }
 
-template<class F>
-static auto avgLuma(const mp_image *mpi, F &&addLine) -> double
-{
-    const uchar *const data = mpi->planes[0];
-    double avg = 0;
-    for (int y = 0; y < mpi->h; ++y)
-         addLine(avg, data + y * mpi->stride[0], mpi->w);
-    const int bits = mpi->fmt.plane_bits;
-    avg /= mpi->h * mpi->w;
-    avg /= (1 << bits) - 1;
-    if (mpi->params.colorlevels == MP_CSP_LEVELS_TV)
-        avg = (avg - 16.0/255)*255.0/(235.0 - 16.0);
-    return avg;
-}
-
-template<class T>
-static auto lumaYCbCrPlanar(const mp_image *mpi) -> double
-{
-    return avgLuma(mpi, [] (double &sum, const uchar *data, int w) {
-        const T *p = (const T*)data;
-        for (int x = 0; x < w; ++x)
-            sum += *p++;
-    });
-}
-
-static auto luminance(const mp_image *mpi) -> double
-{
-    switch (mpi->imgfmt) {
-    case IMGFMT_420P:   case IMGFMT_NV12:   case IMGFMT_NV21:
-    case IMGFMT_444P:   case IMGFMT_422P:   case IMGFMT_440P:
-    case IMGFMT_411P:   case IMGFMT_410P:   case IMGFMT_Y8:
-    case IMGFMT_444AP:  case IMGFMT_422AP:  case IMGFMT_420AP:
-        return lumaYCbCrPlanar<quint8>(mpi);
-    case IMGFMT_444P16: case IMGFMT_444P14: case IMGFMT_444P12:
-    case IMGFMT_444P10: case IMGFMT_444P9:  case IMGFMT_422P16:
-    case IMGFMT_422P14: case IMGFMT_422P12: case IMGFMT_422P10:
-    case IMGFMT_422P9:  case IMGFMT_420P16: case IMGFMT_420P14:
-    case IMGFMT_420P12: case IMGFMT_420P10: case IMGFMT_420P9:
-    case IMGFMT_Y16:
-        return lumaYCbCrPlanar<quint16>(mpi);
-    case IMGFMT_YUYV:   case IMGFMT_UYVY: {
-        const int offset = mpi->imgfmt == IMGFMT_UYVY;
-        return avgLuma(mpi, [&] (double &sum, const uchar *p, int w) {
-            p += offset;
-            for (int i = 0; i < w; ++i, p += 2)
-                sum += *p;
-        });
-    } default:
-        return -1;
-    }
-}
-
 auto VideoProcessor::hwdec() const -> QString
 {
     switch (d->hwdecType) {
@@ -339,6 +371,7 @@ auto VideoProcessor::hwdec() const -> QString
 
 auto VideoProcessor::filterIn(mp_image *_mpi) -> int
 {
+    TRACE_SCOPE("VideoProcessor::filterIn");
     if (!_mpi) { // propagate eof
         d->passthrough.push(MpImage());
         d->deinterlacer.push(MpImage());
@@ -346,6 +379,8 @@ auto VideoProcessor::filterIn(mp_image *_mpi) -> int
         return 0;
     }
 
+    if (d->next)
+        d->takeNext();
     const bool hwacc = _Change(d->hwacc, !!IMGFMT_IS_HWACCEL(_mpi->imgfmt));
     const bool hwtype = _Change(d->hwdecType, _mpi->hwdec_type);
     if (hwacc || hwtype)
@@ -373,16 +408,26 @@ auto VideoProcessor::filterIn(mp_image *_mpi) -> int
                         return false;
                 }
                 MpImage img;
+                double y = -1.0;
                 if (IMGFMT_IS_HWACCEL(mpi->imgfmt)) {
                     Q_ASSERT(d->hwdec);
                     if (!d->hwdec)
                         return false;
-                    img = d->hwdec->download(mpi);
+                    y = d->hwdec->scanLuma(mpi);
+                    if (y < 0) {
+                        // average needs neither chroma nor every pixel
+                        OS::HwAcc::Download part;
+                        part.lumaOnly = true;
+                        part.scale = 4;
+                        img = d->hwdec->download(mpi, part);
+                    }
                 } else
                     img = mpi;
-                if (img.isNull())
-                    return false;
-                const auto y = luminance(img.data());
+                if (y < 0) {
+                    if (img.isNull())
+                        return false;
+                    y = _LumaScan(img.data());
+                }
                 if (y < 0.005)
                     return false;
                 return true;
@@ -400,6 +445,23 @@ auto VideoProcessor::filterIn(mp_image *_mpi) -> int
         }
     }
 
+    if (d->refreshChanged.exchange(false) && d->intrplOption.sync_to_monitor) {
+        d->interpolator.setTargetFps(d->refresh);
+        if (d->filter == &d->interpolator)
+            emit fpsManimulated(d->interpolator.fpsManipulation());
+    }
+    if (d->deint && d->detect && !IMGFMT_IS_HWACCEL(mpi->imgfmt)) {
+        const bool changed = d->combs.feed(mpi.data());
+        if (d->combs.isDecided()) {
+            if (!d->combs.isInterlaced())
+                mpi.unset(MP_IMGFIELD_INTERLACED);
+            else if (!mpi.isInterlaced()) // most of broadcasts are tff
+                mpi.set(MP_IMGFIELD_INTERLACED | MP_IMGFIELD_TOP_FIRST);
+        }
+        // choose filter again not to run deinterlacer for progressive scene
+        if (changed && d->filter && mpi.isInterlaced() != d->inter_i)
+            d->reset();
+    }
     if (!d->filter) {
         if (mpi.isInterlaced() && !d->deinterlacer.pass())
             d->filter = &d->deinterlacer;
@@ -422,6 +484,7 @@ auto VideoProcessor::needsInput() const -> bool
 
 auto VideoProcessor::filterOut() -> int
 {
+    TRACE_SCOPE("VideoProcessor::filterOut");
     if (!d->filter)
         return 0;
     auto mpi = std::move(d->filter->pop());
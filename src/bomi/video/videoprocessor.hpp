@@ -3,7 +3,7 @@
 
 struct vf_instance;                     struct mp_image_params;
 struct vf_info;                         struct mp_image;
-struct MotionIntrplOption;
+struct MotionIntrplOption;             struct DeintOptionSet;
 enum class DeintMethod;                 enum class ColorSpace;
 enum class ColorRange;
 
@@ -21,6 +21,11 @@ public:
     auto isSkipping() const -> bool;
     auto hwdec() const -> QString;
     auto setMotionIntrplOption(const MotionIntrplOption &option) -> void;
+    // applied to running filter at next frame without building chain again
+    auto setDeintOptions(const DeintOptionSet &set) -> void;
+    auto setMotionInterpolation(bool on) -> void;
+    // retarget interpolation synced to monitor without reconfiguration
+    auto setDisplayRefreshRate(double hz) -> void;
     auto inputColorSpace() const -> ColorSpace;
     auto inputColorRange() const -> ColorRange;
     auto outputColorSpace() const -> ColorSpace;
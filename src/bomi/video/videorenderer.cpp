@@ -1,21 +1,130 @@
 #include "videorenderer.hpp"
 #include "letterboxitem.hpp"
 #include "mpvosdrenderer.hpp"
+#include "cropdetector.hpp"
+#include "sliderenderer.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/openglframebufferobject.hpp"
 #include "opengl/opengltexturebinder.hpp"
 #include "misc/dataevent.hpp"
 #include "misc/log.hpp"
+#include "os/resourcemonitor.hpp"
 #include "enum/rotation.hpp"
 #include <QQmlProperty>
 #include <QQuickWindow>
+#include <QElapsedTimer>
+#include <QVector2D>
 
 DECLARE_LOG_CONTEXT(Video)
 
-enum EventType {NewFrame = QEvent::User + 1 };
+enum EventType {NewFrame = QEvent::User + 1, CropDetected, SlideTick };
 
-enum DirtyFlag {
-    DirtyRot = 1
+static auto fboBytes(const OpenGLFramebufferObject *fbo) -> qint64
+{
+    if (!fbo)
+        return 0;
+    int bpp = 4;
+    switch (fbo->format()) {
+    case OGL::RGBA16_UNorm: case OGL::RGBA16F:
+        bpp = 8;
+        break;
+    case OGL::RGBA32F:
+        bpp = 16;
+        break;
+    default:
+        break;
+    }
+    const auto size = fbo->capacity();
+    return qint64(size.width()) * size.height() * bpp;
+}
+
+// fbos are allocated in sizes rounded up to buckets and kept for a while
+// after released, so resizing back and forth or toggling fullscreen reuses
+// them with a smaller size in use instead of reallocating gpu memory
+struct FboPool {
+    static constexpr int Bucket = 128;
+    static constexpr qint64 Timeout = 5000; // msec
+    struct Entry { OpenGLFramebufferObject *fbo; qint64 released; };
+    QVector<Entry> entries;
+    QElapsedTimer timer;
+    FboPool() { timer.start(); }
+    ~FboPool() { Q_ASSERT(entries.isEmpty()); }
+    static auto bucket(const QSize &size) -> QSize
+    {
+        auto up = [] (int v) { return qMax(1, (v + Bucket - 1) / Bucket) * Bucket; };
+        return { up(size.width()), up(size.height()) };
+    }
+    // larger one is reused only if it would not waste too much memory
+    static auto fits(const OpenGLFramebufferObject *fbo, const QSize &size,
+                     OGL::TextureFormat format) -> bool
+    {
+        if (!fbo || fbo->format() != format)
+            return false;
+        const auto c = fbo->capacity(), b = bucket(size);
+        return c.width() >= size.width() && c.height() >= size.height()
+                && qint64(c.width()) * c.height() <= 2 * qint64(b.width()) * b.height();
+    }
+    // unused part of texture must stay clear as it was border
+    static auto use(OpenGLFramebufferObject *fbo, const QSize &size) -> void
+    {
+        auto f = QOpenGLContext::currentContext()->functions();
+        fbo->setSize(size);
+        fbo->bind();
+        f->glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        f->glClear(GL_COLOR_BUFFER_BIT);
+        fbo->release();
+    }
+    auto acquire(const QSize &size, OGL::TextureFormat format) -> OpenGLFramebufferObject*
+    {
+        int best = -1;
+        qint64 area = 0;
+        for (int i = 0; i < entries.size(); ++i) {
+            const auto fbo = entries[i].fbo;
+            const auto c = fbo->capacity();
+            if (fits(fbo, size, format)
+                    && (best < 0 || qint64(c.width()) * c.height() < area)) {
+                best = i;
+                area = qint64(c.width()) * c.height();
+            }
+        }
+        OpenGLFramebufferObject *fbo = nullptr;
+        if (best < 0)
+            fbo = new OpenGLFramebufferObject(bucket(size), format);
+        else {
+            fbo = entries[best].fbo;
+            entries.remove(best);
+        }
+        use(fbo, size);
+        return fbo;
+    }
+    auto release(OpenGLFramebufferObject *fbo) -> void
+    {
+        if (fbo)
+            entries.push_back({ fbo, timer.elapsed() });
+    }
+    auto collect() -> void
+    {
+        const auto now = timer.elapsed();
+        for (int i = entries.size() - 1; i >= 0; --i) {
+            if (now - entries[i].released > Timeout) {
+                delete entries[i].fbo;
+                entries.remove(i);
+            }
+        }
+    }
+    auto clear() -> void
+    {
+        for (auto &e : entries)
+            delete e.fbo;
+        entries.clear();
+    }
+    auto bytes() const -> qint64
+    {
+        qint64 bytes = 0;
+        for (auto &e : entries)
+            bytes += fboBytes(e.fbo);
+        return bytes;
+    }
 };
 
 struct FboSet {
@@ -32,13 +141,33 @@ struct FboSet {
             return &fbo->texture();
         return &fallback;
     }
-    auto renew() -> bool
+    // scale of texture coordinates for part of texture in use
+    auto scale() const -> QVector2D
+    {
+        if (texture() == &fallback)
+            return { 1.0f, 1.0f };
+        const auto c = fbo->capacity();
+        return { fbo->width() / float(c.width()), fbo->height() / float(c.height()) };
+    }
+    // true if new one has been allocated
+    auto renew(FboPool &pool) -> bool
     {
         if (!visible || (fbo && fbo->size() == size && fbo->format() == format))
             return false;
-        _Renew(fbo, size, format);
+        if (size.isEmpty()) {
+            release(pool);
+            return false;
+        }
+        if (FboPool::fits(fbo, size, format)) {
+            FboPool::use(fbo, size);
+            return false;
+        }
+        pool.release(fbo);
+        fbo = pool.acquire(size, format);
         return true;
     }
+    auto release(FboPool &pool) -> void { pool.release(fbo); fbo = nullptr; }
+    auto bytes() const -> qint64 { return fboBytes(fbo); }
 };
 
 struct VideoRenderer::VideoShaderData : public VideoRenderer::ShaderData {
@@ -52,14 +181,16 @@ struct VideoRenderer::VideoShaderIface : public VideoRenderer::ShaderIface {
         if (osd) {
             vertexShader = R"(
                 uniform mat4 qt_Matrix;
+                uniform vec2 frameScale;
+                uniform vec2 osdScale;
                 attribute vec4 aPosition;
                 attribute vec2 aFrameTexCoord;
                 attribute vec2 aOsdTexCoord;
                 varying vec2 frameTexCoord;
                 varying vec2 osdTexCoord;
                 void main() {
-                    frameTexCoord = aFrameTexCoord;
-                    osdTexCoord = aOsdTexCoord;
+                    frameTexCoord = aFrameTexCoord * frameScale;
+                    osdTexCoord = aOsdTexCoord * osdScale;
                     gl_Position = qt_Matrix * aPosition;
                 }
             )";
@@ -77,12 +208,13 @@ struct VideoRenderer::VideoShaderIface : public VideoRenderer::ShaderIface {
         } else {
             vertexShader = R"(
                 uniform mat4 qt_Matrix;
+                uniform vec2 frameScale;
                 attribute vec4 aPosition;
                 attribute vec2 aFrameTexCoord;
                 attribute vec2 aOsdTexCoord;
                 varying vec2 frameTexCoord;
                 void main() {
-                    frameTexCoord = aFrameTexCoord;
+                    frameTexCoord = aFrameTexCoord * frameScale;
                     gl_Position = qt_Matrix * aPosition;
                 }
             )";
@@ -99,8 +231,11 @@ struct VideoRenderer::VideoShaderIface : public VideoRenderer::ShaderIface {
     void resolve(QOpenGLShaderProgram *prog) override {
         Q_ASSERT(prog->isLinked());
         loc_frameTex = prog->uniformLocation("frameTex");
-        if (m_osd)
+        loc_frameScale = prog->uniformLocation("frameScale");
+        if (m_osd) {
             loc_osdTex = prog->uniformLocation("osdTex");
+            loc_osdScale = prog->uniformLocation("osdScale");
+        }
     }
     void update(QOpenGLShaderProgram *prog,
                 VideoRenderer::ShaderData *data) override {
@@ -109,6 +244,9 @@ struct VideoRenderer::VideoShaderIface : public VideoRenderer::ShaderIface {
         if (frame->id() != GL_NONE && !frame->isEmpty()) {
             prog->setUniformValue(loc_frameTex, 0);
             prog->setUniformValue(loc_osdTex, 1);
+            prog->setUniformValue(loc_frameScale, d->frame->scale());
+            if (m_osd)
+                prog->setUniformValue(loc_osdScale, d->osd->scale());
             func()->glActiveTexture(GL_TEXTURE0);
             frame->bind();
             if (m_osd && d->osdVisible) {
@@ -120,6 +258,7 @@ struct VideoRenderer::VideoShaderIface : public VideoRenderer::ShaderIface {
     }
 private:
     int loc_frameTex = -1, loc_osdTex = -1;
+    int loc_frameScale = -1, loc_osdScale = -1;
     bool m_osd = false;
 };
 
@@ -136,20 +275,42 @@ private:
 
 struct VideoRenderer::Data {
     VideoRenderer *p = nullptr;
-    double crop = -1.0, aspect = -1.0, dar = 0.0;
+    double crop = -1.0, aspect = -1.0, dar = 0.0, scale = 1.0;
     bool onLetterbox = true, redraw = false, portrait = false;
     bool flip_h = false, flip_v = false, scaler = false;
+    // autoCrop is read in render thread
+    std::atomic<bool> autoCrop{false};
+    CropDetector detector;
+    // visible part of frame found by detector
+    QSizeF detected;
     Qt::Alignment alignment = Qt::AlignCenter;
     QRectF vtx; QPointF offset = {0, 0};
     LetterboxItem *letterbox = nullptr;
     GeometryItem *overlay = nullptr;
     Rotation rotation = Rotation::D0;
-    int dirty = 0;
 
     FboSet frame, osd;
+    FboPool pool;
+
+    SlideRenderer slides;
+    // still image shown instead of mpv frames, gui thread
+    struct {
+        QImage current, previous;
+        QVector<QImage> uploads;
+        QElapsedTimer fade;
+        int duration = 0;
+        // last frame size from mpv to restore when image is gone
+        QSize videoSize{0, 1};
+    } image;
+    // copied in updateData() for render()
+    struct {
+        QImage current, previous;
+        double progress = 1.0;
+    } slide;
 
     QSize sourceSize{0, 1};
-    QTimer sizeChecker;
+    QTimer idle;
+    bool release = false;
     RenderFrameFunc render = nullptr;
 
     static auto isSameRatio(double r1, double r2) -> bool
@@ -170,6 +331,8 @@ struct VideoRenderer::Data {
             return crop;
         if (crop == 0.0)
             return itemAspectRatio();
+        if (autoCrop && !detected.isEmpty())
+            return fallback * detected.width() / detected.height();
         return fallback;
     }
     auto targetCropRatio() const -> double
@@ -220,15 +383,66 @@ struct VideoRenderer::Data {
     {
         if (onLetterbox)
             return p->size().toSize();
-        return fboSizeHint();
+        return frameSizeHint();
     }
-    auto fboSizeHint() const -> QSize
+    // frame fbo is never rotated, rotation is applied to texture coordinates
+    auto frameSizeHint() const -> QSize
     {
         auto size = sourceSize;
-        if (portrait)
-            std::swap(size.rwidth(), size.rheight());
-        if (scaler)
-            size.scale(qCeil(vtx.width()), qCeil(vtx.height()), Qt::KeepAspectRatio);
+        if (scaler) {
+            auto box = vtx.size();
+            if (portrait)
+                box.transpose();
+            size.scale(qCeil(box.width()), qCeil(box.height()), Qt::KeepAspectRatio);
+        }
+        return size;
+    }
+    auto setSourceSize(const QSize &size) -> void
+    {
+        if (_Change(sourceSize, size)) {
+            detector.reset();
+            detected = QSizeF();
+            p->reserve(UpdateGeometry, false);
+            frame.size = fboSizeHint();
+            osd.size = osdSizeHint();
+            p->polish();
+        }
+    }
+    auto fadeProgress() const -> double
+    {
+        if (image.previous.isNull() || image.duration <= 0)
+            return 1.0;
+        return qMin(1.0, image.fade.elapsed() / double(image.duration));
+    }
+    // reallocate fbos only if pixel size has been changed
+    auto updateSizes() -> void
+    {
+        if (_Change(frame.size, fboSizeHint()) | _Change(osd.size, osdSizeHint())) {
+            redraw = true;
+            p->reserve(UpdateAll);
+        }
+    }
+    // normalized point on rotated frame to point on frame fbo
+    auto unrotate(const QPointF &pt) const -> QPointF
+    {
+        switch (rotation) {
+        case Rotation::D90:
+            return { pt.y(), 1.0 - pt.x() };
+        case Rotation::D180:
+            return { 1.0 - pt.x(), 1.0 - pt.y() };
+        case Rotation::D270:
+            return { 1.0 - pt.y(), pt.x() };
+        default:
+            return pt;
+        }
+    }
+    auto fboSizeHint() const -> QSize
+    {
+        auto size = frameSizeHint();
+        if (scale < 1.0) {
+            size.rwidth() = qMax(1, qRound(size.width() * scale));
+            size.rheight() = qMax(1, qRound(size.height() * scale));
+        }
         return size;
     }
 };
@@ -244,15 +458,11 @@ VideoRenderer::VideoRenderer(QQuickItem *parent)
     setAcceptHoverEvents(true);
     setAcceptedMouseButtons(Qt::AllButtons);
     setFlag(ItemAcceptsDrops, true);
-    connect(&d->sizeChecker, &QTimer::timeout, [this] () {
-        if (_Change(d->frame.size, d->fboSizeHint()) |
-                _Change(d->osd.size, d->osdSizeHint())) {
-            d->redraw = true;
-            reserve(UpdateAll);
-        }
+    connect(&d->idle, &QTimer::timeout, [this] () {
+        d->release = true;
+        reserve(UpdateMaterial);
     });
-    d->sizeChecker.setInterval(300);
-    d->sizeChecker.setSingleShot(true);
+    d->idle.setSingleShot(true);
 }
 
 VideoRenderer::~VideoRenderer() {
@@ -305,13 +515,20 @@ auto VideoRenderer::initializeGL() -> void
     const quint32 p = 0x0;
     d->frame.fallback.initialize(1, 1, OGL::BGRA, &p);
     d->osd.fallback = d->frame.fallback;
+    d->detector.create();
+    d->slides.create();
 }
 
 auto VideoRenderer::finalizeGL() -> void
 {
     Super::finalizeGL();
     d->frame.fallback.destroy();
-    _Delete(d->frame.fbo);
+    d->detector.destroy();
+    d->slides.destroy();
+    d->slide.current = d->slide.previous = QImage();
+    d->frame.release(d->pool);
+    d->osd.release(d->pool);
+    d->pool.clear();
 }
 
 auto VideoRenderer::customEvent(QEvent *event) -> void
@@ -319,16 +536,29 @@ auto VideoRenderer::customEvent(QEvent *event) -> void
     switch (static_cast<int>(event->type())) {
     case NewFrame: {
         auto ds = _GetData<QSize>(event);
-        if (_Change(d->sourceSize, ds)) {
-            reserve(UpdateGeometry, false);
-            d->frame.size = d->fboSizeHint();
-            d->osd.size = d->osdSizeHint();
-            polish();
-        }
+        d->image.videoSize = ds;
+        if (!d->image.current.isNull())
+            break;
+        d->setSourceSize(ds);
+        if (!hasFrame() && d->idle.interval() > 0)
+            d->idle.start();
+        else
+            d->idle.stop();
         d->redraw = true;
         reserve(UpdateMaterial);
         break;
-    } default:
+    } case SlideTick:
+        d->redraw = true;
+        reserve(UpdateMaterial);
+        break;
+    case CropDetected:
+        d->detected = _GetData<QSizeF>(event);
+        if (d->autoCrop && d->crop < 0.0) {
+            polish();
+            reserve(UpdateGeometry);
+        }
+        break;
+    default:
         break;
     }
 }
@@ -412,6 +642,22 @@ auto VideoRenderer::setCropRatio(double ratio) -> void
     }
 }
 
+auto VideoRenderer::setAutoCrop(bool on) -> void
+{
+    if (d->autoCrop == on)
+        return;
+    d->autoCrop = on;
+    d->detector.reset();
+    d->detected = QSizeF();
+    polish();
+    reserve(UpdateGeometry);
+}
+
+auto VideoRenderer::isAutoCropEnabled() const -> bool
+{
+    return d->autoCrop;
+}
+
 auto VideoRenderer::cropRatio() const -> double
 {
     return d->crop;
@@ -439,7 +685,6 @@ auto VideoRenderer::sizeHint() const -> QSize
 auto VideoRenderer::updatePolish() -> void
 {
     Super::updatePolish();
-    d->sizeChecker.stop();
     QRectF letter;
     if (_Change(d->vtx, d->frameRect({0, 0, width(), height()}, d->offset, &letter))) {
         reserve(UpdateGeometry, false);
@@ -468,7 +713,7 @@ auto VideoRenderer::updatePolish() -> void
         const auto g = d->onLetterbox ? rect() : d->letterbox->screen();
         d->overlay->setGeometry(g);
     }
-    d->sizeChecker.start();
+    d->updateSizes();
 }
 
 auto VideoRenderer::setFlipped(bool horizontal, bool vertical) -> void
@@ -519,9 +764,25 @@ auto VideoRenderer::render(VideoShaderData *data) -> void
         return;
     data->redraw = false;
     auto w = window();
-    if (w && d->render) {
+    if (w && !d->slide.current.isNull()) {
+        w->resetOpenGLState();
+        d->slides.draw(d->frame.fbo, d->slide.current, d->slide.previous, d->slide.progress);
+        // mpv does not draw on it for images
+        if (data->osdVisible && d->osd.fbo) {
+            auto f = QOpenGLContext::currentContext()->functions();
+            d->osd.fbo->bind();
+            f->glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            f->glClear(GL_COLOR_BUFFER_BIT);
+            d->osd.fbo->release();
+        }
+        w->resetOpenGLState();
+        if (d->slide.progress < 1.0)
+            _PostEvent(this, SlideTick);
+    } else if (w && d->render) {
         w->resetOpenGLState();
         d->render(d->frame.fbo, data->osdVisible ? d->osd.fbo : nullptr, data->osdMargins);
+        if (d->autoCrop && d->detector.analyze(d->frame.fbo))
+            _PostEvent(this, CropDetected, d->detector.area());
         w->resetOpenGLState();
     }
 }
@@ -529,15 +790,33 @@ auto VideoRenderer::render(VideoShaderData *data) -> void
 auto VideoRenderer::updateData(ShaderData *_data) -> void
 {
     auto data = static_cast<VideoShaderData*>(_data);
+    if (d->release) {
+        d->release = false;
+        if (!hasFrame() && (d->frame.fbo || d->osd.fbo || !d->pool.entries.isEmpty())) {
+            const auto bytes = d->frame.bytes() + d->osd.bytes() + d->pool.bytes();
+            d->frame.release(d->pool);
+            d->osd.release(d->pool);
+            d->pool.clear();
+            OS::ResourceMonitor::setSaving("video-buffers", bytes / double(1 << 20));
+        }
+    }
+    d->pool.collect();
+    // context is current here, so upload ahead before they are shown
+    for (auto &image : d->image.uploads)
+        d->slides.upload(image);
+    d->image.uploads.clear();
     if (!d->redraw) {
         _Trace("VideoRendererItem::updateTexture(): no queued frame");
     } else if (!d->frame.size.isEmpty()) {
         d->redraw = false;
-        d->frame.renew();
-        d->osd.renew();
+        if (d->frame.renew(d->pool) | d->osd.renew(d->pool))
+            OS::ResourceMonitor::setSaving("video-buffers", 0.0);
         data->redraw = true;
         data->osdMargins = d->osd.margins;
         data->osdVisible = d->osd.visible;
+        d->slide.current = d->image.current;
+        d->slide.previous = d->image.previous;
+        d->slide.progress = d->fadeProgress();
     }
 }
 
@@ -552,8 +831,11 @@ auto VideoRenderer::updateVertex(Vertex *vertex) -> void
     if (d->flip_h)
         std::swap(tl.rx(), br.rx());
     FILL_TS(position, {0, 0}, {width(), height()});
-    FILL_TS(frameTexCoord, tl, br);
     FILL_TS(osdTexCoord, d->osd.rect.topLeft(), d->osd.rect.bottomRight());
+    // same order as triangle strip
+    const QPointF corners[] = { tl, {tl.x(), br.y()}, {br.x(), tl.y()}, br };
+    for (int i = 0; i < 4; ++i)
+        vertex[i].frameTexCoord.set(d->unrotate(corners[i]));
 }
 
 auto VideoRenderer::initializeVertex(Vertex *vertex) const -> void
@@ -568,12 +850,7 @@ auto VideoRenderer::initializeVertex(Vertex *vertex) const -> void
 auto VideoRenderer::setRotation(Rotation r) -> void
 {
     if (_Change(d->rotation, r)) {
-        if (_Change(d->portrait, _IsOneOf(r, Rotation::D90, Rotation::D270))) {
-            d->frame.size = d->fboSizeHint();
-            d->redraw = true;
-            reserve(UpdateAll);
-        }
-        d->dirty = DirtyRot;
+        d->portrait = _IsOneOf(r, Rotation::D90, Rotation::D270);
         polish();
         reserve(UpdateGeometry);
     }
@@ -618,6 +895,29 @@ auto VideoRenderer::setScalerEnabled(bool on) -> void
     }
 }
 
+auto VideoRenderer::setRenderScale(double scale) -> void
+{
+    if (_Change(d->scale, qBound(0.1, scale, 1.0))) {
+        d->frame.size = d->fboSizeHint();
+        d->redraw = true;
+        reserve(UpdateAll);
+    }
+}
+
+auto VideoRenderer::setIdleRelease(int msec) -> void
+{
+    d->idle.setInterval(qMax(0, msec));
+    if (msec > 0 && !hasFrame())
+        d->idle.start();
+    else
+        d->idle.stop();
+}
+
+auto VideoRenderer::renderScale() const -> double
+{
+    return d->scale;
+}
+
 auto VideoRenderer::setOsdVisible(bool visible) -> void
 {
     if (_Change(d->osd.visible, visible)) {
@@ -626,6 +926,34 @@ auto VideoRenderer::setOsdVisible(bool visible) -> void
     }
 }
 
+auto VideoRenderer::setImage(const QImage &image, int transition) -> void
+{
+    auto &s = d->image;
+    if (image.cacheKey() == s.current.cacheKey())
+        return;
+    s.previous = transition > 0 && !image.isNull() ? s.current : QImage();
+    s.current = image;
+    s.duration = transition;
+    s.fade.start();
+    d->setSourceSize(image.isNull() ? s.videoSize : image.size());
+    d->idle.stop();
+    d->redraw = true;
+    reserve(UpdateMaterial);
+}
+
+auto VideoRenderer::hasImage() const -> bool
+{
+    return !d->image.current.isNull();
+}
+
+auto VideoRenderer::preloadImage(const QImage &image) -> void
+{
+    if (image.isNull())
+        return;
+    d->image.uploads.push_back(image);
+    reserve(UpdateMaterial);
+}
+
 auto VideoRenderer::updateAll() -> void
 {
     polish();
@@ -51,6 +51,10 @@ public:
     auto setAlignment(Qt::Alignment alignment) -> void;
     auto setOffset(const QPointF &offset) -> void;
     auto setCropRatio(double ratio) -> void;
+    // crop black bars found in frames while crop ratio is same as source
+    auto setAutoCrop(bool on) -> void;
+    auto isAutoCropEnabled() const -> bool;
+    // rotation and flips only change texture coordinates, fbos are kept
     auto setRotation(Rotation r) -> void;
     auto setRenderFrameFunction(const RenderFrameFunc &func) -> void;
     auto updateForNewFrame(const QSize &displaySize) -> void;
@@ -59,6 +63,17 @@ public:
     auto isPortrait() const -> bool;
     auto setScalerEnabled(bool on) -> void;
     auto setOsdVisible(bool visible) -> void;
+    // scale of frame fbo for dynamic resolution, upscaled when drawn
+    auto setRenderScale(double scale) -> void;
+    auto renderScale() const -> double;
+    // free frame buffers after msec without video, keep them if not positive
+    auto setIdleRelease(int msec) -> void;
+    // draw still image instead of frames from render function, fading from
+    // previous image for transition msec, null image returns to frames
+    auto setImage(const QImage &image, int transition = 0) -> void;
+    auto hasImage() const -> bool;
+    // upload ahead to gpu so that setImage() with it shows up at once
+    auto preloadImage(const QImage &image) -> void;
     auto updateAll() -> void;
     Q_INVOKABLE QRectF mapFromVideo(const QRect &rect);
 signals:
@@ -15,6 +15,8 @@ struct Line {
 struct DeintWidget::Data {
     DeintWidget *p = nullptr;
     Line lines[2];
+    QSpinBox *threads = nullptr;
+    QCheckBox *detect = nullptr;
     auto line(Processor proc) -> Line& { return lines[proc == Processor::GPU]; }
     auto create(Processor proc, const QString &label, QGridLayout *grid) -> void
     {
@@ -86,6 +88,22 @@ DeintWidget::DeintWidget(QWidget *parent)
     auto grid = new QGridLayout;
     d->create(Processor::CPU, tr("For S/W decoding"), grid);
     d->create(Processor::GPU, tr("For H/W decoding"), grid);
+
+    d->threads = new QSpinBox(this);
+    d->threads->setRange(0, 64);
+    d->threads->setSpecialValueText(tr("Auto"));
+    d->threads->setToolTip(tr("Threads for S/W deinterlacing filters.\n"
+                              "Auto uses as many threads as CPU cores."));
+    grid->addWidget(new QLabel(tr("Filter threads")), 2, 0);
+    grid->addWidget(d->threads, 2, 1);
+    connect(SIGNAL_VT(d->threads, valueChanged, int),
+            this, &DeintWidget::optionsChanged);
+
+    d->detect = new QCheckBox(tr("Detect interlacing regardless of flags"), this);
+    d->detect->setToolTip(tr("Look for combing in S/W decoded frames to find\n"
+                             "mis-flagged interlaced or progressive video."));
+    grid->addWidget(d->detect, 3, 0, 1, 3);
+    connect(d->detect, &QCheckBox::toggled, this, &DeintWidget::optionsChanged);
     setLayout(grid);
 }
 
@@ -97,6 +115,8 @@ auto DeintWidget::set(const DeintOptionSet &options) -> void
 {
     d->setOption(Processor::CPU, options.option(Processor::CPU));
     d->setOption(Processor::GPU, options.option(Processor::GPU));
+    d->threads->setValue(options.threads);
+    d->detect->setChecked(options.detect);
 }
 
 auto DeintWidget::get() const -> DeintOptionSet
@@ -104,5 +124,7 @@ auto DeintWidget::get() const -> DeintOptionSet
     DeintOptionSet set;
     set.swdec = d->option(Processor::CPU);
     set.hwdec = d->option(Processor::GPU);
+    set.threads = d->threads->value();
+    set.detect = d->detect->isChecked();
     return set;
 }
@@ -209,6 +209,8 @@ static struct af_instance *af_create(struct af_stream *s, char *name,
         .log = mp_log_new(af, s->log, name),
         .replaygain_data = s->replaygain_data,
         .out_pool = mp_audio_pool_create(af),
+        .global = s->global,
+        .output_delay = &s->output_delay,
     };
     struct m_config *config = m_config_from_obj_desc(af, s->log, &desc);
     if (m_config_apply_defaults(config, name, s->opts->af_defs) < 0)
@@ -550,6 +552,7 @@ struct af_stream *af_new(struct mpv_global *global)
 {
     struct af_stream *s = talloc_zero(NULL, struct af_stream);
     s->log = mp_log_new(s, global->log, "!af");
+    s->global = global;
 
     static const struct af_info in = { .name = "in" };
     s->first = talloc(s, struct af_instance);
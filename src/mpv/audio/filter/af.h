@@ -69,6 +69,8 @@ struct af_instance {
     int (*filter_out)(struct af_instance *af);
     void *priv;
     struct mp_audio *data; // configuration and buffer for outgoing data stream
+    struct mpv_global *global; // for filters which open outputs on their own
+    const double *output_delay; // seconds of output queued after all filters
 
     struct af_instance *next;
     struct af_instance *prev;
@@ -100,7 +102,9 @@ struct af_stream {
 
     struct mp_log *log;
     struct MPOpts *opts;
+    struct mpv_global *global;
     struct replaygain_data *replaygain_data;
+    double output_delay; // updated by player for every chunk
 };
 
 // Return values
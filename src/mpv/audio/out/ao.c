@@ -239,6 +239,22 @@ static void split_ao_device(void *tmp, char *opt, char **out_ao, char **out_dev)
     *out_ao = bstrto0(tmp, b_ao);
 }
 
+// Open exactly the given "driver/device" without falling back to others.
+struct ao *ao_init_device(struct mpv_global *global, const char *device,
+                          int samplerate, int format, struct mp_chmap channels)
+{
+    void *tmp = talloc_new(NULL);
+    char *name, *dev;
+    split_ao_device(tmp, talloc_strdup(tmp, device), &name, &dev);
+    struct ao *ao = NULL;
+    if (name) {
+        ao = ao_init(false, global, NULL, NULL, samplerate, format, channels,
+                     dev, name, NULL);
+    }
+    talloc_free(tmp);
+    return ao;
+}
+
 struct ao *ao_init_best(struct mpv_global *global,
                         struct input_ctx *input_ctx,
                         struct encode_lavc_context *encode_lavc_ctx,
@@ -75,6 +75,8 @@ struct ao *ao_init_best(struct mpv_global *global,
                         struct input_ctx *input_ctx,
                         struct encode_lavc_context *encode_lavc_ctx,
                         int samplerate, int format, struct mp_chmap channels);
+struct ao *ao_init_device(struct mpv_global *global, const char *device,
+                          int samplerate, int format, struct mp_chmap channels);
 void ao_uninit(struct ao *ao);
 void ao_get_format(struct ao *ao, struct mp_audio *format);
 const char *ao_get_name(struct ao *ao);
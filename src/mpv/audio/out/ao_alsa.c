@@ -64,6 +64,7 @@ struct priv {
     int cfg_resample;
     int cfg_ni;
     int cfg_ignore_chmap;
+    int cfg_buffer_time; // in ms
 };
 
 #define BUFFER_TIME 250000  // 250ms
@@ -535,12 +536,15 @@ static int init_device(struct ao *ao, bool second_try)
             (p->alsa, alsa_hwparams, &ao->samplerate, NULL);
     CHECK_ALSA_ERROR("Unable to set samplerate-2");
 
+    // keep periods at least 5ms long for short buffers
+    unsigned int buffer_time = p->cfg_buffer_time * 1000;
+    unsigned int periods = MPCLAMP(p->cfg_buffer_time / 5, 2, FRAGCOUNT);
     err = snd_pcm_hw_params_set_buffer_time_near
-            (p->alsa, alsa_hwparams, &(unsigned int){BUFFER_TIME}, NULL);
+            (p->alsa, alsa_hwparams, &buffer_time, NULL);
     CHECK_ALSA_WARN("Unable to set buffer time near");
 
     err = snd_pcm_hw_params_set_periods_near
-            (p->alsa, alsa_hwparams, &(unsigned int){FRAGCOUNT}, NULL);
+            (p->alsa, alsa_hwparams, &periods, NULL);
     CHECK_ALSA_WARN("Unable to set periods");
 
     /* finally install hardware parameters */
@@ -960,6 +964,7 @@ const struct ao_driver audio_out_alsa = {
         .cfg_mixer_name = "Master",
         .cfg_mixer_index = 0,
         .cfg_ni = 0,
+        .cfg_buffer_time = BUFFER_TIME / 1000,
     },
     .options = (const struct m_option[]) {
         OPT_STRING("device", cfg_device, 0),
@@ -969,6 +974,7 @@ const struct ao_driver audio_out_alsa = {
         OPT_INTRANGE("mixer-index", cfg_mixer_index, 0, 0, 99),
         OPT_FLAG("non-interleaved", cfg_ni, 0),
         OPT_FLAG("ignore-chmap", cfg_ignore_chmap, 0),
+        OPT_INTRANGE("buffer-time", cfg_buffer_time, 0, 10, 1000),
         {0}
     },
 };
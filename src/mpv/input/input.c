@@ -853,6 +853,9 @@ void mp_input_wakeup_nolock(struct input_ctx *ictx)
     // Some audio APIs discourage use of locking in their audio callback,
     // and these audio callbacks happen to call mp_input_wakeup_nolock()
     // when new data is needed. This is why we use semaphores here.
+    // Outputs opened outside of the player core have no input context.
+    if (!ictx)
+        return;
     sem_post(&ictx->wakeup);
 }
 
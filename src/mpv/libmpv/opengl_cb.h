@@ -216,6 +216,14 @@ int mpv_opengl_cb_render_osd(struct mpv_opengl_cb_context *ctx,
                              int w, int h, int ml, int mt, int mr, int mb, double dpar,
                              void(*cb)(void*,struct sub_bitmaps*), void *octx);
 
+/**
+ * Return pts in seconds of the video frame drawn by mpv_opengl_cb_draw(),
+ * which stays until next frame is drawn. This has same time base as
+ * "time-pos" property, and is a negative value of huge magnitude if no
+ * frame has been drawn since last reconfiguration.
+ */
+double mpv_opengl_cb_get_frame_pts(mpv_opengl_cb_context *ctx);
+
 /**
  * Tell the renderer that a frame was flipped at the given time. This is
  * optional, but can help the player to achieve better timing.
@@ -118,6 +118,7 @@ const m_option_t mp_opts[] = {
                 {"belownormal", BELOW_NORMAL_PRIORITY_CLASS},
                 {"idle",        IDLE_PRIORITY_CLASS})),
 #endif
+    OPT_INTRANGE("core-nice", core_nice, 0, 0, 19),
     OPT_FLAG("config", load_config, CONF_GLOBAL | CONF_NOCFG | CONF_PRE_PARSE),
     OPT_STRING("config-dir", force_configdir,
                CONF_GLOBAL | CONF_NOCFG | CONF_PRE_PARSE),
@@ -461,6 +462,7 @@ const m_option_t mp_opts[] = {
     OPT_FLAG("osd-scale-by-window", osd_scale_by_window, 0),
 
     OPT_DOUBLE("sstep", step_sec, CONF_MIN, 0),
+    OPT_INTRANGE("frame-step-cache", frame_step_cache, 0, 0, 4096),
 
     OPT_CHOICE("framedrop", frame_dropping, 0,
                ({"no", 0},
@@ -166,6 +166,7 @@ typedef struct MPOpts {
     int play_frames;
     double ab_loop[2];
     double step_sec;
+    int frame_step_cache;
     int position_resume;
     int position_save_on_quit;
     int write_filename_in_watch_later_config;
@@ -257,6 +258,7 @@ typedef struct MPOpts {
     char *hwdec_codecs;
 
     int w32_priority;
+    int core_nice;
 
     int network_cookies_enabled;
     char *network_cookies_file;
@@ -494,6 +494,10 @@ void fill_audio_out_buffers(struct MPContext *mpctx, double endpts)
         mpctx->video_status != STATUS_EOF && mpctx->delay > 0)
         return;
 
+    // audio already filtered but not heard yet
+    d_audio->afilter->output_delay = ao_get_delay(mpctx->ao)
+                                   + mp_audio_buffer_seconds(mpctx->ao_buffer);
+
     int playsize = ao_get_space(mpctx->ao);
 
     int skip = 0;
@@ -19,6 +19,10 @@
 #include <errno.h>
 #include <locale.h>
 #include <assert.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 
 #include "common/common.h"
 #include "common/msg.h"
@@ -494,6 +498,13 @@ static void *playback_thread(void *p)
 
     mpthread_set_name("playback core");
 
+#ifdef __linux__
+    // Nice value is per thread on Linux, and threads created by the core
+    // (demuxer, decoder, VO) inherit it.
+    if (mpctx->opts->core_nice > 0)
+        setpriority(PRIO_PROCESS, syscall(SYS_gettid), mpctx->opts->core_nice);
+#endif
+
     mp_play_files(mpctx);
 
     // This actually waits until all clients are gone before actually
@@ -512,6 +512,16 @@ static int mp_property_avsync(void *ctx, struct m_property *prop,
     return m_property_double_ro(action, arg, mpctx->last_av_difference);
 }
 
+/// Audio buffered in AO and device (RO)
+static int mp_property_ao_delay(void *ctx, struct m_property *prop,
+                                int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    if (!mpctx->ao)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_double_ro(action, arg, ao_get_delay(mpctx->ao));
+}
+
 static int mp_property_total_avsync_change(void *ctx, struct m_property *prop,
                                            int action, void *arg)
 {
@@ -545,6 +555,28 @@ static int mp_property_vo_drop_frame_count(void *ctx, struct m_property *prop,
     return m_property_int_ro(action, arg, vo_get_drop_count(mpctx->video_out));
 }
 
+/// Average time of decoding one video packet in ms
+static int mp_property_video_decode_time(void *ctx, struct m_property *prop,
+                                         int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    if (!mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+
+    return m_property_double_ro(action, arg, mpctx->d_video->decode_time * 1e3);
+}
+
+/// Packets held in video decoder, e.g. by frame threading
+static int mp_property_video_decoder_queue(void *ctx, struct m_property *prop,
+                                           int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    if (!mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+
+    return m_property_int_ro(action, arg, mpctx->d_video->queued_packets);
+}
+
 /// Current position in percent (RW)
 static int mp_property_percent_pos(void *ctx, struct m_property *prop,
                                    int action, void *arg)
@@ -702,6 +734,21 @@ static int mp_property_mouse_on_button(void *ctx, struct m_property *prop,
     return m_property_flag_ro(action, arg, on);
 }
 
+/// Highlighted button of disc menu as "x0 y0 x1 y1", empty if none (RO)
+static int mp_property_disc_button_rect(void *ctx, struct m_property *prop,
+                                        int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    int rect[4];
+    if (!mp_nav_get_button_rect(mpctx, rect))
+        return m_property_strdup_ro(action, arg, "");
+    char *str = talloc_asprintf(NULL, "%d %d %d %d",
+                                rect[0], rect[1], rect[2], rect[3]);
+    int r = m_property_strdup_ro(action, arg, str);
+    talloc_free(str);
+    return r;
+}
+
 /// Current chapter (RW)
 static int mp_property_chapter(void *ctx, struct m_property *prop,
                                int action, void *arg)
@@ -3307,9 +3354,12 @@ static const struct m_property mp_properties[] = {
     {"duration", mp_property_duration},
     M_PROPERTY_DEPRECATED_ALIAS("length", "duration"),
     {"avsync", mp_property_avsync},
+    {"ao-delay", mp_property_ao_delay},
     {"total-avsync-change", mp_property_total_avsync_change},
     {"drop-frame-count", mp_property_drop_frame_cnt},
     {"vo-drop-frame-count", mp_property_vo_drop_frame_count},
+    {"video-decode-time", mp_property_video_decode_time},
+    {"video-decoder-queue", mp_property_video_decoder_queue},
     {"percent-pos", mp_property_percent_pos},
     {"time-start", mp_property_time_start},
     {"time-pos", mp_property_time_pos},
@@ -3319,6 +3369,7 @@ static const struct m_property mp_properties[] = {
     {"disc-title", mp_property_disc_title},
     {"disc-menu-active", mp_property_disc_menu},
     {"disc-mouse-on-button", mp_property_mouse_on_button},
+    {"disc-button-rect", mp_property_disc_button_rect},
     {"chapter", mp_property_chapter},
     {"edition", mp_property_edition},
     {"disc-titles", mp_property_disc_titles},
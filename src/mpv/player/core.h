@@ -279,6 +279,15 @@ typedef struct MPContext {
     uint64_t backstep_start_seek_ts;
     bool backstep_active;
 
+    // Recently shown (or hr-seek skipped) software frames, oldest first.
+    // Frame steps inside of it are shown without seeking and decoding.
+    struct mp_image **step_ring;
+    int num_step_ring;
+    int64_t step_ring_bytes;
+    // Number of frames stepped back from the newest entry. If not 0, the
+    // decoder is ahead of the displayed frame.
+    int step_ring_pos;
+
     double next_heartbeat;
     double last_idle_tick;
     double next_cache_update;
@@ -376,6 +385,7 @@ void mp_nav_user_input(struct MPContext *mpctx, char *command);
 void mp_handle_nav(struct MPContext *mpctx);
 int mp_nav_in_menu(struct MPContext *mpctx);
 bool mp_nav_mouse_on_button(struct MPContext *mpctx);
+bool mp_nav_get_button_rect(struct MPContext *mpctx, int rect[4]);
 
 // loadfile.c
 void uninit_player(struct MPContext *mpctx, unsigned int mask);
@@ -492,6 +502,8 @@ void reset_video_state(struct MPContext *mpctx);
 int reinit_video_chain(struct MPContext *mpctx);
 int reinit_video_filters(struct MPContext *mpctx);
 void write_video(struct MPContext *mpctx, double endpts);
+void step_ring_clear(struct MPContext *mpctx);
+bool step_ring_show(struct MPContext *mpctx, int dir);
 void mp_force_video_refresh(struct MPContext *mpctx);
 void uninit_video_out(struct MPContext *mpctx);
 void uninit_video_chain(struct MPContext *mpctx);
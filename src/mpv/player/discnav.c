@@ -111,6 +111,27 @@ bool mp_nav_mouse_on_button(struct MPContext *mpctx)
     return mpctx->nav_state ? mpctx->nav_state->nav_mouse_on_button : false;
 }
 
+static void update_button_rect(struct MPContext *mpctx)
+{
+    mp_notify_property(mpctx, "disc-button-rect");
+}
+
+// Rectangle (x0 y0 x1 y1) of the highlighted button in video coordinates.
+bool mp_nav_get_button_rect(struct MPContext *mpctx, int rect[4])
+{
+    struct mp_nav_state *nav = mpctx->nav_state;
+    if (!nav)
+        return false;
+    pthread_mutex_lock(&nav->osd_lock);
+    bool visible = nav->hi_visible;
+    if (visible) {
+        for (int i = 0; i < 4; i++)
+            rect[i] = nav->highlight[i];
+    }
+    pthread_mutex_unlock(&nav->osd_lock);
+    return visible;
+}
+
 // If a demuxer is accessing the stream, we have to use demux_stream_control()
 // to avoid synchronization issues; otherwise access it directly.
 static int run_stream_control(struct MPContext *mpctx, int cmd, void *arg)
@@ -167,6 +188,7 @@ void mp_nav_reset(struct MPContext *mpctx)
     mp_input_disable_section(mpctx->input, "discnav-menu");
     run_stream_control(mpctx, STREAM_CTRL_RESUME_CACHE, NULL);
     update_state(mpctx);
+    update_button_rect(mpctx);
 }
 
 void mp_nav_destroy(struct MPContext *mpctx)
@@ -277,6 +299,7 @@ void mp_handle_nav(struct MPContext *mpctx)
             pthread_mutex_unlock(&nav->osd_lock);
             update_resolution(mpctx);
             osd_set_nav_highlight(mpctx->osd, mpctx);
+            update_button_rect(mpctx);
             break;
         }
         case MP_NAV_EVENT_OVERLAY: {
@@ -114,6 +114,13 @@ void unpause_player(struct MPContext *mpctx)
     mpctx->osd_function = 0;
     mpctx->osd_force_update = true;
 
+    // Decoder and audio are ahead of a frame shown from the step ring.
+    if (mpctx->step_ring_pos > 0) {
+        queue_seek(mpctx, MPSEEK_ABSOLUTE, mpctx->last_vo_pts,
+                   MPSEEK_VERY_EXACT, true);
+        mpctx->step_ring_pos = 0;
+    }
+
     if (mpctx->ao && mpctx->d_audio)
         ao_resume(mpctx->ao);
     if (mpctx->video_out)
@@ -130,13 +137,17 @@ void add_step_frame(struct MPContext *mpctx, int dir)
     if (!mpctx->d_video)
         return;
     if (dir > 0) {
+        if (mpctx->paused && step_ring_show(mpctx, 1))
+            return;
         mpctx->step_frames += 1;
         unpause_player(mpctx);
     } else if (dir < 0) {
         if (!mpctx->backstep_active && !mpctx->hrseek_active) {
+            pause_player(mpctx);
+            if (step_ring_show(mpctx, -1))
+                return;
             mpctx->backstep_active = true;
             mpctx->backstep_start_seek_ts = mpctx->vo_pts_history_seek_ts;
-            pause_player(mpctx);
         }
     }
 }
@@ -16,6 +16,7 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <inttypes.h>
 #include <math.h>
@@ -198,6 +199,80 @@ int reinit_video_filters(struct MPContext *mpctx)
     return d_video->vfilter->initialized;
 }
 
+static int64_t image_bytes(struct mp_image *img)
+{
+    int64_t bytes = 0;
+    for (int n = 0; n < img->num_planes; n++)
+        bytes += (int64_t)abs(img->stride[n]) * mp_image_plane_h(img, n);
+    return bytes;
+}
+
+void step_ring_clear(struct MPContext *mpctx)
+{
+    for (int n = 0; n < mpctx->num_step_ring; n++)
+        talloc_free(mpctx->step_ring[n]);
+    mpctx->num_step_ring = 0;
+    mpctx->step_ring_bytes = 0;
+    mpctx->step_ring_pos = 0;
+}
+
+static void step_ring_add(struct MPContext *mpctx, struct mp_image *img)
+{
+    int64_t size = mpctx->opts->frame_step_cache * (int64_t)(1024 * 1024);
+    int64_t bytes = image_bytes(img);
+    // Keeping hw surfaces would starve the decoder's surface pool.
+    if (bytes > size || img->pts == MP_NOPTS_VALUE ||
+        IMGFMT_IS_HWACCEL(img->imgfmt))
+    {
+        step_ring_clear(mpctx);
+        return;
+    }
+    if (mpctx->num_step_ring) {
+        struct mp_image *last = mpctx->step_ring[mpctx->num_step_ring - 1];
+        if (last->pts >= img->pts ||
+            !mp_image_params_equal(&last->params, &img->params))
+            step_ring_clear(mpctx);
+    }
+    while (mpctx->num_step_ring && mpctx->step_ring_bytes + bytes > size) {
+        mpctx->step_ring_bytes -= image_bytes(mpctx->step_ring[0]);
+        talloc_free(mpctx->step_ring[0]);
+        MP_TARRAY_REMOVE_AT(mpctx->step_ring, mpctx->num_step_ring, 0);
+    }
+    MP_TARRAY_APPEND(mpctx, mpctx->step_ring, mpctx->num_step_ring,
+                     mp_image_new_ref(img));
+    mpctx->step_ring_bytes += bytes;
+}
+
+// Show the previous (dir < 0) or next (dir > 0) frame of the step ring.
+// Returns false if there is no such frame, and the caller has to seek.
+bool step_ring_show(struct MPContext *mpctx, int dir)
+{
+    struct vo *vo = mpctx->video_out;
+    int num = mpctx->num_step_ring;
+    if (!vo || !vo->config_ok || !num || mpctx->video_status < STATUS_READY)
+        return false;
+    // The newest entry must be what is displayed when not stepped back.
+    if (!mpctx->step_ring_pos && mpctx->step_ring[num - 1]->pts != mpctx->last_vo_pts)
+        return false;
+    int pos = mpctx->step_ring_pos - dir;
+    if (pos < 0 || pos >= num)
+        return false;
+    struct mp_image *img = mpctx->step_ring[num - 1 - pos];
+    if (!vo->params || !mp_image_params_equal(&img->params, vo->params))
+        return false;
+    vo_wait_frame(vo);
+    mpctx->step_ring_pos = pos;
+    mpctx->video_pts = img->pts;
+    mpctx->last_vo_pts = img->pts;
+    mpctx->playback_pts = img->pts;
+    mpctx->osd_force_update = true;
+    update_osd_msg(mpctx);
+    update_subtitles(mpctx);
+    vo_queue_frame(vo, mp_image_new_ref(img), mp_time_us(), -1);
+    mp_notify(mpctx, MPV_EVENT_TICK, NULL);
+    return true;
+}
+
 void reset_video_state(struct MPContext *mpctx)
 {
     if (mpctx->d_video)
@@ -208,6 +283,7 @@ void reset_video_state(struct MPContext *mpctx)
     mp_image_unrefp(&mpctx->next_frame[0]);
     mp_image_unrefp(&mpctx->next_frame[1]);
     mp_image_unrefp(&mpctx->saved_frame);
+    step_ring_clear(mpctx);
 
     mpctx->delay = 0;
     mpctx->time_frame = 0;
@@ -649,7 +725,8 @@ static int video_output_image(struct MPContext *mpctx, double endpts)
             } else if (hrseek && mpctx->hrseek_lastframe) {
                 mp_image_setrefp(&mpctx->saved_frame, img);
             } else if (hrseek && img->pts < mpctx->hrseek_pts - .005) {
-                /* just skip */
+                /* just skip, but keep it for backstepping */
+                step_ring_add(mpctx, img);
             } else {
                 add_new_frame(mpctx, img);
                 img = NULL;
@@ -862,6 +939,7 @@ void write_video(struct MPContext *mpctx, double endpts)
     update_osd_msg(mpctx);
     update_subtitles(mpctx);
 
+    step_ring_add(mpctx, mpctx->next_frame[0]);
     vo_queue_frame(vo, mpctx->next_frame[0], pts, duration);
     mpctx->next_frame[0] = NULL;
 
@@ -178,6 +178,7 @@ static bool check_stream_network(int fd)
         0x564C      /*NCP*/,    0x6969      /*NFS*/,    0x6E667364  /*NFSD*/,
         0xAAD7AAEA  /*PANFS*/,  0x50495045  /*PIPEFS*/, 0x517B      /*SMB*/,
         0xBEEFDEAD  /*SNFS*/,   0xBACBACBC  /*VMHGFS*/, 0x7461636f  /*OCFS2*/,
+        0xFE534D42  /*SMB2*/,
         0
     };
     if (fstatfs(fd, &fs) == 0) {
@@ -307,8 +308,11 @@ static int open_f(stream_t *stream)
     stream->read_chunk = 64 * 1024;
     stream->close = s_close;
 
-    if (check_stream_network(fd))
+    if (check_stream_network(fd)) {
         stream->streaming = true;
+        // each read is a round trip to server, so let cache ask for more
+        stream->read_chunk = 1024 * 1024;
+    }
 
     return STREAM_OK;
 }
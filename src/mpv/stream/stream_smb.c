@@ -131,7 +131,9 @@ static int open_f (stream_t *stream)
   stream->write_buffer = write_buffer;
   stream->close = close_f;
   stream->control = control;
-  stream->read_chunk = 128 * 1024;
+  // libsmbclient splits large read into pipelined requests,
+  // so bigger chunk keeps several of them in flight for cache
+  stream->read_chunk = 1024 * 1024;
   stream->streaming = true;
 
   return STREAM_OK;
@@ -69,6 +69,7 @@ void video_reset_decoding(struct dec_video *d_video)
     d_video->codec_dts = MP_NOPTS_VALUE;
     d_video->sorted_pts = MP_NOPTS_VALUE;
     d_video->unsorted_pts = MP_NOPTS_VALUE;
+    d_video->queued_packets = 0;
 }
 
 int video_vd_control(struct dec_video *d_video, int cmd, void *arg)
@@ -316,10 +317,19 @@ struct mp_image *video_decode(struct dec_video *d_video,
 
     MP_STATS(d_video, "start decode video");
 
+    int64_t start = mp_time_us();
     struct mp_image *mpi = d_video->vd_driver->decode(d_video, packet, drop_frame);
+    double elapsed = (mp_time_us() - start) / 1e6;
 
     MP_STATS(d_video, "end decode video");
 
+    d_video->decode_time = d_video->decode_time > 0
+                         ? d_video->decode_time * 0.9 + elapsed * 0.1 : elapsed;
+    if (packet)
+        d_video->queued_packets++;
+    if (mpi)
+        d_video->queued_packets = MPMAX(d_video->queued_packets - 1, 0);
+
     if (!mpi || drop_frame) {
         talloc_free(mpi);
         return NULL;            // error / skipped frame
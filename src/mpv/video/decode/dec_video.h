@@ -76,6 +76,10 @@ struct dec_video {
 
     // State used only by player/video.c
     double last_pts;
+
+    // Decoder statistics
+    double decode_time;   // running average of one decode call, seconds
+    int queued_packets;   // packets fed to decoder without a frame out yet
 };
 
 struct mp_decoder_list *video_decoder_list(void);
@@ -32,9 +32,11 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "filter_kernels.h"
 
@@ -157,6 +159,98 @@ void mp_compute_lut(struct filter_kernel *filter, int count, float *out_array)
     }
 }
 
+// Computing LUTs is expensive for windowed and polar filters, and every
+// gl_video instance (main video, preview) recomputes them on each scaler
+// switch. Keep the last results around, keyed by all kernel parameters.
+#define LUT_CACHE_SIZE 16
+
+struct lut_cache_entry {
+    struct filter_kernel kernel;
+    int count;
+    float *weights;
+    unsigned int used;
+};
+
+static pthread_mutex_t lut_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct lut_cache_entry lut_cache[LUT_CACHE_SIZE];
+static unsigned int lut_cache_clock;
+
+static bool double_eq(double a, double b)
+{
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static bool filter_window_eq(const struct filter_window *a,
+                             const struct filter_window *b)
+{
+    return a->weight == b->weight &&
+           ((!a->name && !b->name) ||
+            (a->name && b->name && strcmp(a->name, b->name) == 0)) &&
+           double_eq(a->radius, b->radius) &&
+           double_eq(a->params[0], b->params[0]) &&
+           double_eq(a->params[1], b->params[1]) &&
+           double_eq(a->blur, b->blur);
+}
+
+static bool lut_cache_match(const struct lut_cache_entry *e,
+                            const struct filter_kernel *filter, int count)
+{
+    return e->weights && e->count == count &&
+           e->kernel.polar == filter->polar &&
+           e->kernel.size == filter->size &&
+           double_eq(e->kernel.inv_scale, filter->inv_scale) &&
+           filter_window_eq(&e->kernel.f, &filter->f) &&
+           filter_window_eq(&e->kernel.w, &filter->w);
+}
+
+void mp_compute_lut_cached(struct filter_kernel *filter, int count,
+                           float *out_array)
+{
+    size_t bytes = sizeof(float) * count * (filter->polar ? 1 : filter->size);
+
+    pthread_mutex_lock(&lut_cache_lock);
+    for (int n = 0; n < LUT_CACHE_SIZE; n++) {
+        struct lut_cache_entry *e = &lut_cache[n];
+        if (lut_cache_match(e, filter, count)) {
+            memcpy(out_array, e->weights, bytes);
+            e->used = ++lut_cache_clock;
+            pthread_mutex_unlock(&lut_cache_lock);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&lut_cache_lock);
+
+    // don't block other threads while computing
+    mp_compute_lut(filter, count, out_array);
+
+    float *weights = malloc(bytes);
+    if (!weights)
+        return;
+    memcpy(weights, out_array, bytes);
+
+    pthread_mutex_lock(&lut_cache_lock);
+    struct lut_cache_entry *oldest = &lut_cache[0];
+    for (int n = 0; n < LUT_CACHE_SIZE; n++) {
+        struct lut_cache_entry *e = &lut_cache[n];
+        if (lut_cache_match(e, filter, count)) {
+            // another thread was faster
+            free(weights);
+            pthread_mutex_unlock(&lut_cache_lock);
+            return;
+        }
+        if (e->used < oldest->used)
+            oldest = e;
+    }
+    free(oldest->weights);
+    *oldest = (struct lut_cache_entry){
+        .kernel = *filter,
+        .count = count,
+        .weights = weights,
+        .used = ++lut_cache_clock,
+    };
+    pthread_mutex_unlock(&lut_cache_lock);
+}
+
 typedef struct filter_window params;
 
 static double box(params *p, double x)
@@ -50,5 +50,9 @@ const struct filter_kernel *mp_find_filter_kernel(const char *name);
 bool mp_init_filter(struct filter_kernel *filter, const int *sizes,
                     double scale);
 void mp_compute_lut(struct filter_kernel *filter, int count, float *out_array);
+// Same as mp_compute_lut(), but reuses the weights of a previous call with
+// identical parameters in any thread.
+void mp_compute_lut_cached(struct filter_kernel *filter, int count,
+                           float *out_array);
 
 #endif /* MPLAYER_FILTER_KERNELS_H */
@@ -24,6 +24,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include <libavutil/common.h>
@@ -184,6 +185,7 @@ struct gl_video {
 
     struct fbotex chroma_merge_fbo;
     struct fbotex source_fbo;
+    struct fbotex deint_fbos[4];
     struct fbotex indirect_fbo;
     struct fbotex blend_subs_fbo;
     struct fbosurface surfaces[FBOSURFACES_MAX];
@@ -202,6 +204,10 @@ struct gl_video {
 
     struct mp_csp_equalizer video_eq;
 
+    // affine user transform applied to the source color, see color-matrix
+    struct mp_cmat user_cmat;
+    bool use_user_cmat;
+
     struct mp_rect src_rect;    // displayed part of the source video
     struct mp_rect dst_rect;    // video rectangle on output window
     struct mp_osd_res osd_rect; // OSD size/margins
@@ -456,6 +462,13 @@ const struct m_sub_options gl_video_conf = {
 
         OPT_REMOVED("approx-gamma", "this is always enabled now"),
         OPT_STRING("custom-shader", custom_shader, 0),
+        OPT_STRING("color-matrix", color_matrix, 0),
+        OPT_CHOICE("deint", deint, 0,
+                   ({"no", 0},
+                    {"bob", 1},
+                    {"linear", 2},
+                    {"cubic", 3},
+                    {"yadif", 4})),
         OPT_REMOVED("cscale-down", "chroma is never downscaled"),
         OPT_REMOVED("scale-sep", "this is set automatically whenever sane"),
         OPT_REMOVED("indirect", "this is set automatically whenever sane"),
@@ -581,8 +594,10 @@ static void uninit_rendering(struct gl_video *p)
     for (int n = 0; n < FBOSURFACES_MAX; n++)
         fbotex_uninit(&p->surfaces[n].fbotex);
 
-    for (int n = 0; n < 4; n++)
+    for (int n = 0; n < 4; n++) {
         fbotex_uninit(&p->copy_fbos[n]);
+        fbotex_uninit(&p->deint_fbos[n]);
+    }
 
     gl_video_reset_surfaces(p);
 }
@@ -1039,7 +1054,7 @@ static void reinit_scaler(struct gl_video *p, struct scaler *scaler,
     gl->BindTexture(target, scaler->gl_lut);
 
     float *weights = talloc_array(NULL, float, LOOKUP_TEXTURE_SIZE * size);
-    mp_compute_lut(scaler->kernel, LOOKUP_TEXTURE_SIZE, weights);
+    mp_compute_lut_cached(scaler->kernel, LOOKUP_TEXTURE_SIZE, weights);
 
     if (target == GL_TEXTURE_1D) {
         gl->TexImage1D(target, 0, fmt->internal_format, LOOKUP_TEXTURE_SIZE,
@@ -1408,6 +1423,79 @@ static void pass_copy_from_rect(struct gl_video *p)
     memcpy(&p->pass_tex, &new_pass_tex, sizeof(p->pass_tex));
 }
 
+// Rebuild full frames from single fields on the GPU. Only frames tagged with
+// MP_IMGFIELD_TOP or MP_IMGFIELD_BOTTOM are touched, so progressive content
+// and frames already deinterlaced by a filter go through unchanged.
+static void pass_deinterlace(struct gl_video *p)
+{
+    struct mp_image *mpi = p->image.mpi;
+    if (!p->opts.deint || !mpi || !(mpi->fields & MP_IMGFIELD_INTERLACED))
+        return;
+    int parity;
+    if (mpi->fields & MP_IMGFIELD_TOP)
+        parity = 0;
+    else if (mpi->fields & MP_IMGFIELD_BOTTOM)
+        parity = 1;
+    else
+        return;
+
+    struct src_tex planes[TEXUNIT_VIDEO_NUM];
+    memcpy(&planes, &p->pass_tex, sizeof(p->pass_tex));
+    memset(&p->pass_tex, 0, sizeof(p->pass_tex));
+
+    for (int n = 0; n < p->plane_count; n++) {
+        struct src_tex *src = &planes[n];
+        if (!src->gl_tex)
+            continue;
+        p->pass_tex[0] = *src;
+        p->pass_tex[0].src = (struct mp_rect_f){0, 0, src->tex_w, src->tex_h};
+        GLSLF("// deinterlacing (plane %d)\n", n);
+        // texture_size0 is (1, 1) for rectangle textures
+        GLSL(vec2 dx = vec2(1.0 / texture_size0.x, 0.0);)
+        GLSL(vec2 dy = vec2(0.0, 1.0 / texture_size0.y);)
+        GLSL(vec4 color = texture(texture0, texcoord0);)
+        GLSLF("if (mod(floor(texcoord0.y * texture_size0.y), 2.0) != %d.0) {\n",
+              parity);
+        GLSL(vec4 a = texture(texture0, texcoord0 - dy);)
+        GLSL(vec4 b = texture(texture0, texcoord0 + dy);)
+        switch (p->opts.deint) {
+        case 1: // repeat the nearest line of the field
+            GLSLF("color = %s;\n", parity ? "b" : "a");
+            break;
+        case 2:
+            GLSL(color = 0.5 * (a + b);)
+            break;
+        case 3:
+            GLSL(vec4 a2 = texture(texture0, texcoord0 - 3.0 * dy);)
+            GLSL(vec4 b2 = texture(texture0, texcoord0 + 3.0 * dy);)
+            GLSL(color = (9.0 * (a + b) - (a2 + b2)) / 16.0;)
+            break;
+        case 4: {
+            // Motion adaptive without neighbouring frames: keep the other
+            // field where it does not comb against this one (static area),
+            // otherwise interpolate spatially along the best edge direction.
+            GLSL(vec4 spatial = 0.5 * (a + b);)
+            GLSL(float score = abs(a.r - b.r);)
+            GLSL(for (int k = -1; k <= 1; k += 2) {)
+            GLSL(    vec4 ak = texture(texture0, texcoord0 - dy + float(k) * dx);)
+            GLSL(    vec4 bk = texture(texture0, texcoord0 + dy - float(k) * dx);)
+            GLSL(    float s = abs(ak.r - bk.r);)
+            GLSL(    if (s < score) { score = s; spatial = 0.5 * (ak + bk); })
+            GLSL(})
+            GLSL(float comb = max(min(a.r, b.r) - color.r, color.r - max(a.r, b.r));)
+            GLSL(color = mix(color, spatial, smoothstep(0.01, 0.04, comb));)
+            break;
+        }
+        }
+        GLSL(})
+        finish_pass_fbo(p, &p->deint_fbos[n], src->tex_w, src->tex_h, 0, 0);
+        src->gl_tex = p->deint_fbos[n].texture;
+        src->gl_target = GL_TEXTURE_2D;
+    }
+
+    memcpy(&p->pass_tex, &planes, sizeof(p->pass_tex));
+}
+
 // sample from video textures, set "color" variable to yuv value
 static void pass_read_video(struct gl_video *p)
 {
@@ -1417,6 +1505,8 @@ static void pass_read_video(struct gl_video *p)
     if (p->gl->version < 300 && p->pass_tex[0].gl_target == GL_TEXTURE_RECTANGLE)
         pass_copy_from_rect(p);
 
+    pass_deinterlace(p);
+
     // The custom shader logic is a bit tricky, but there are basically three
     // different places it can occur: RGB, or chroma *and* luma (which are
     // treated separately even for 4:4:4 content, but the minor speed loss
@@ -1534,6 +1624,24 @@ static void pass_read_video(struct gl_video *p)
     }
 }
 
+// out = a * b as affine transforms, out may alias a or b
+static void mul_cmat(struct mp_cmat *out, const struct mp_cmat *a,
+                     const struct mp_cmat *b)
+{
+    struct mp_cmat r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r.m[i][j] = 0;
+            for (int k = 0; k < 3; k++)
+                r.m[i][j] += a->m[i][k] * b->m[k][j];
+        }
+        r.c[i] = a->c[i];
+        for (int k = 0; k < 3; k++)
+            r.c[i] += a->m[i][k] * b->c[k];
+    }
+    *out = r;
+}
+
 // yuv conversion, and any other conversions before main up/down-scaling
 static void pass_convert_yuv(struct gl_video *p)
 {
@@ -1552,6 +1660,17 @@ static void pass_convert_yuv(struct gl_video *p)
     if (p->color_swizzle[0])
         GLSLF("color = color.%s;\n", p->color_swizzle);
 
+    // The user matrix applies to the source color before conversion. It is
+    // folded into the conversion matrix when possible so that it costs
+    // neither an extra operation nor a shader variant per value.
+    bool fold_user_cmat = p->use_user_cmat && !p->is_rgb &&
+                          !(p->image_desc.flags & MP_IMGFLAG_XYZ);
+    if (p->use_user_cmat && !fold_user_cmat) {
+        gl_sc_uniform_mat3(sc, "usermatrix", true, &p->user_cmat.m[0][0]);
+        gl_sc_uniform_vec3(sc, "usermatrix_c", p->user_cmat.c);
+        GLSL(color.rgb = mat3(usermatrix) * color.rgb + usermatrix_c;)
+    }
+
     // Pre-colormatrix input gamma correction
     if (p->image_desc.flags & MP_IMGFLAG_XYZ) {
         cparams.colorspace = MP_CSP_XYZ;
@@ -1574,6 +1693,8 @@ static void pass_convert_yuv(struct gl_video *p)
         } else {
             mp_get_yuv2rgb_coeffs(&cparams, &m);
         }
+        if (fold_user_cmat)
+            mul_cmat(&m, &m, &p->user_cmat);
         gl_sc_uniform_mat3(sc, "colormatrix", true, &m.m[0][0]);
         gl_sc_uniform_vec3(sc, "colormatrix_c", m.c);
 
@@ -2771,6 +2892,34 @@ static const char *handle_scaler_opt(const char *name, bool tscale)
     return NULL;
 }
 
+// color-matrix is 12 numbers of a row-major 3x4 matrix separated by commas
+static void parse_color_matrix(struct gl_video *p, const char *str)
+{
+    p->use_user_cmat = false;
+    if (!str || !str[0])
+        return;
+    float v[12];
+    int n = 0;
+    const char *s = str;
+    for (; n < 12; n++) {
+        char *end;
+        v[n] = strtof(s, &end);
+        if (end == s)
+            break;
+        s = *end == ',' ? end + 1 : end;
+    }
+    if (n != 12) {
+        MP_ERR(p, "Invalid color-matrix '%s'.\n", str);
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++)
+            p->user_cmat.m[i][j] = v[i * 4 + j];
+        p->user_cmat.c[i] = v[i * 4 + 3];
+    }
+    p->use_user_cmat = true;
+}
+
 static char **dup_str_array(void *parent, char **src)
 {
     if (!src)
@@ -2819,6 +2968,8 @@ void gl_video_set_options(struct gl_video *p, struct gl_video_opts *opts,
     p->opts.scale_shader = talloc_strdup(p, p->opts.scale_shader);
     p->opts.pre_shaders = dup_str_array(p, p->opts.pre_shaders);
     p->opts.post_shaders = dup_str_array(p, p->opts.post_shaders);
+    parse_color_matrix(p, p->opts.color_matrix);
+    p->opts.color_matrix = NULL;
 
     check_gl_features(p);
     uninit_rendering(p);
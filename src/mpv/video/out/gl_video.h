@@ -65,6 +65,8 @@ struct gl_video_opts {
     int use_rectangle;
     struct m_color background;
     char *custom_shader;
+    char *color_matrix;
+    int deint;
     int interpolation;
     int blend_subs;
     char *source_shader;
@@ -82,6 +82,8 @@ struct mpv_opengl_cb_context {
     int64_t recent_flip;
     int64_t approx_vsync;
     int64_t cur_pts;
+    // pts of the last image set to renderer in mpv_opengl_cb_draw()
+    double frame_pts;
     bool vsync_timed;
 
     // --- All of these can only be accessed from the thread where the host
@@ -184,6 +186,7 @@ struct mpv_opengl_cb_context *mp_opengl_create(struct mpv_global *g,
     pthread_cond_init(&ctx->wakeup, NULL);
 
     ctx->gl = talloc_zero(ctx, GL);
+    ctx->frame_pts = MP_NOPTS_VALUE;
 
     ctx->log = mp_log_new(ctx, g->log, "opengl-cb");
     ctx->client_api = client_api;
@@ -334,6 +337,7 @@ int mpv_opengl_cb_draw(mpv_opengl_cb_context *ctx, int fbo, int vp_w, int vp_h)
     }
 
     if (ctx->reconfigured) {
+        ctx->frame_pts = MP_NOPTS_VALUE;
         gl_video_set_osd_source(ctx->renderer, vo ? vo->osd : NULL);
         gl_video_config(ctx->renderer, &ctx->img_params);
     }
@@ -368,6 +372,7 @@ int mpv_opengl_cb_draw(mpv_opengl_cb_context *ctx, int fbo, int vp_w, int vp_h)
         struct frame_timing *t = mpi->priv; // set by draw_image_timed
         if (t)
             ctx->cur_pts = t->pts;
+        ctx->frame_pts = mpi->pts;
     }
 
     struct frame_timing timing = {
@@ -396,6 +401,14 @@ int mpv_opengl_cb_draw(mpv_opengl_cb_context *ctx, int fbo, int vp_w, int vp_h)
     return left;
 }
 
+double mpv_opengl_cb_get_frame_pts(mpv_opengl_cb_context *ctx)
+{
+    pthread_mutex_lock(&ctx->lock);
+    double pts = ctx->frame_pts;
+    pthread_mutex_unlock(&ctx->lock);
+    return pts;
+}
+
 int mpv_opengl_cb_report_flip(mpv_opengl_cb_context *ctx, int64_t time)
 {
     pthread_mutex_lock(&ctx->lock);